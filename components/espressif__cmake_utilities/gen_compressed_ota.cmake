@@ -7,7 +7,14 @@ if (NOT TARGET gen_compressed_ota)
         set(COMPRESSED_OTA_BIN_SIGN_PARA )
     endif()
 
-    set(GEN_COMPRESSED_BIN_CMD  ${CMAKE_CURRENT_LIST_DIR}/scripts/gen_custom_ota.py ${COMPRESSED_OTA_BIN_SIGN_PARA} --add_app_header)
+    # idf.py -DCOMPRESSED_OTA_BASE_BIN=<app running on the devices> gen_compressed_ota packs a delta against it
+    if (COMPRESSED_OTA_BASE_BIN)
+        set(COMPRESSED_OTA_BIN_BASE_PARA --base_file ${COMPRESSED_OTA_BASE_BIN})
+    else()
+        set(COMPRESSED_OTA_BIN_BASE_PARA )
+    endif()
+
+    set(GEN_COMPRESSED_BIN_CMD  ${CMAKE_CURRENT_LIST_DIR}/scripts/gen_custom_ota.py ${COMPRESSED_OTA_BIN_SIGN_PARA} ${COMPRESSED_OTA_BIN_BASE_PARA} --add_app_header)
 
     add_custom_command(TARGET gen_compressed_ota
     POST_BUILD
@@ -21,12 +21,17 @@ import lzma
 # siged_packed_compressed_file = 'hello-world.bin.xz.packed.signed'
 
 binary_compress_type = {'none': 0, 'xz':1}
+binary_delta_type = {'none': 0, 'add_extra': 1}
 header_version = {'v1': 1, 'v2': 2, 'v3': 3}
 
 SCRIPT_VERSION = '1.0.0'
 ORIGIN_APP_IMAGE_HEADER_LEN = 288   # sizeof(esp_image_header_t) + sizeof(esp_image_segment_header_t) + sizeof(esp_app_desc_t). See esp_app_format.h
 # At present, we calculate the checksum of the first 4KB data of the old app.                
 OLD_APP_CHECK_DATA_SIZE = 4096      
+# A delta is looked up in the old app by blocks of this many bytes
+DELTA_BLOCK_SIZE = 16
+# The device keeps the whole dictionary of a compressed delta in RAM
+DELTA_DICT_SIZE = 16*1024
 
 # v1 compressed data header:
 # Note: Encryption_type field is deprecated, the field is reserved for compatibility.
@@ -72,13 +77,92 @@ OLD_APP_CHECK_DATA_SIZE = 4096
 # | Data | “ESP”   |     3   |   0/1    |            |           |                |                |              |            |
 # |------|---------|---------|----------|------------|-----------|----------------|----------------|--------------|------------|
 
-def xz_compress(store_directory, in_file):
+# Delta of type add_extra, like bsdiff, the new app is a list of controls:
+# |------|----------|-----------|-----------|-----------|-------------|-------------|-----|
+# |      | New app  | add len   | extra len | seek      | add len     | extra len   |     |
+# |      | length   |           |           |           | diff bytes  | extra bytes | ... |
+# |------|----------|-----------|-----------|-----------|-------------|-------------|-----|
+# | Data | uint32   | LEB128    | LEB128    | zigzag    |             |             |     |
+# | type | little-  |           |           | LEB128    |             |             |     |
+# |      | endian   |           |           |           |             |             |     |
+# |------|----------|-----------|-----------|-----------|-------------|-------------|-----|
+# Each diff byte is added to the old app byte at the current position, the extra bytes
+# are copied as is, then the position moves by seek. The position starts at 0.
+def leb128(value):
+    data = bytearray()
+    while value > 0x7f:
+        data.append((value & 0x7f) | 0x80)
+        value >>= 7
+    data.append(value)
+    return bytes(data)
+
+def delta_extend(old, new, new_pos, old_pos):
+    # extend as long as more than half of the bytes match, bytes that differ cost a diff byte
+    # but cheaper than starting a new control, typically addresses moved by the new code
+    size = min(len(new) - new_pos, len(old) - old_pos)
+    same = best = length = i = 0
+    while i < size and i - length <= 64:
+        if new[new_pos + i:new_pos + i + 64] == old[old_pos + i:old_pos + i + 64]:
+            step = min(64, size - i)
+            same += step
+            i += step
+        else:
+            same += new[new_pos + i] == old[old_pos + i]
+            i += 1
+        if same * 2 - i > best * 2 - length:
+            best = same
+            length = i
+    return length
+
+def delta_create(old, new):
+    index = {}
+    for i in range(0, len(old) - DELTA_BLOCK_SIZE + 1, 4):
+        index.setdefault(old[i:i + DELTA_BLOCK_SIZE], i)
+
+    data = bytearray(struct.pack('<I', len(new)))
+    add_new = add_old = add_len = 0
+    pos = 0
+
+    def control(extra_end, old_pos):
+        seek = old_pos - (add_old + add_len)
+        data.extend(leb128(add_len) + leb128(extra_end - add_new - add_len) + leb128(seek * 2 if seek >= 0 else -seek * 2 - 1))
+        data.extend((new[add_new + i] - old[add_old + i]) & 0xff for i in range(add_len))
+        data.extend(new[add_new + add_len:extra_end])
+
+    while pos + DELTA_BLOCK_SIZE <= len(new):
+        old_pos = index.get(new[pos:pos + DELTA_BLOCK_SIZE])
+        if old_pos is None:
+            pos += 1
+            continue
+        new_pos = pos
+        while new_pos > add_new + add_len and old_pos > 0 and new[new_pos - 1] == old[old_pos - 1]:
+            new_pos -= 1
+            old_pos -= 1
+        control(new_pos, old_pos)
+        add_new, add_old, add_len = new_pos, old_pos, delta_extend(old, new, new_pos, old_pos)
+        pos = add_new + add_len
+
+    control(len(new), add_old + add_len)
+    return data
+
+def delta_generate(store_directory, in_file, base_file):
+    delta_file = os.path.join(store_directory, ''.join([os.path.split(in_file)[1], '.delta']))
+    with open(in_file, 'rb') as new_f, open(base_file, 'rb') as old_f:
+        new = new_f.read()
+        old = old_f.read()
+    data = delta_create(old, new)
+    with open(delta_file, 'wb') as f:
+        f.write(data)
+    print('delta file is: {}, {} bytes for a {} bytes app'.format(delta_file, len(data), len(new)))
+    return delta_file
+
+def xz_compress(store_directory, in_file, dict_size=64*1024):
     compressed_file = ''.join([in_file,'.xz'])
     if(os.path.exists(compressed_file)):
         os.remove(compressed_file)
 
     xz_compressor_filter = [
-        {"id": lzma.FILTER_LZMA2, "preset": 6, "dict_size": 64*1024},
+        {"id": lzma.FILTER_LZMA2, "preset": 6, "dict_size": dict_size},
     ]
     with open(in_file, 'rb') as src_f:
         data = src_f.read()
@@ -121,6 +205,8 @@ def main():
     parser.add_argument('-fv', '--fw_ver', nargs='?', 
             default='', help='the version of the compressed data(this field is deprecated in v3)')
     parser.add_argument('--add_app_header', action="store_true", help='add app header to use native esp_ota_* & esp_https_ota_* APIs')
+    parser.add_argument('-b', '--base_file', nargs = '?',
+            default='', help='the app running on the device, pack a delta against it (header v2 only)')
     parser.add_argument('-v', '--version', action='version', version=get_script_version(), help='the version of the script')
     
     args = parser.parse_args()
@@ -131,6 +217,13 @@ def main():
     sign_key = args.sign_key
     header_ver = args.header_ver
     add_app_header = args.add_app_header
+    base_file = args.base_file
+    delta_type = 'add_extra' if base_file != '' else 'none'
+
+    if base_file != '' and header_ver != 'v2':
+        # only the v2 header tells which app the delta applies to
+        print('delta is packed with header v2')
+        header_ver = 'v2'
 
     if src_file == '':
         origin_app_name = get_app_name()
@@ -154,16 +247,24 @@ def main():
     os.mkdir(cpmoressed_app_directory)
     print('The compressed file will store in {}'.format(cpmoressed_app_directory))
 
+    #step0: diff against the base app
+    if base_file != '':
+        payload_file = delta_generate(cpmoressed_app_directory, src_file, base_file)
+        dict_size = DELTA_DICT_SIZE
+    else:
+        payload_file = src_file
+        dict_size = 64*1024
+
     #step1: compress
     if compress_type == 'xz':
-        xz_compress(cpmoressed_app_directory, os.path.abspath(src_file))
+        xz_compress(cpmoressed_app_directory, os.path.abspath(payload_file), dict_size)
 
-        origin_app_name = os.path.split(src_file)[1]
+        origin_app_name = os.path.split(payload_file)[1]
 
         compressed_file_name = ''.join([origin_app_name, '.xz'])
         compressed_file = os.path.join(cpmoressed_app_directory, compressed_file_name)
     else:
-        compressed_file = ''.join(src_file)
+        compressed_file = ''.join(payload_file)
     
     print('compressed file is: {}'.format(compressed_file))
 
@@ -181,8 +282,8 @@ def main():
         # header version
         bin_data += struct.pack('B', header_version[header_ver])
         # Compress type
-        bin_data += struct.pack('B', binary_compress_type[compress_type])
-        print('compressed type: {}'.format(binary_compress_type[compress_type]))
+        bin_data += struct.pack('B', binary_compress_type[compress_type] | binary_delta_type[delta_type] << 4)
+        print('compressed type: {}, delta type: {}'.format(binary_compress_type[compress_type], binary_delta_type[delta_type]))
         # in header v1/v2, there is a field "Encryption type", this field has been deprecated in v3
         if (header_version[header_ver] < 3):
             bin_data += struct.pack('B', 0)
@@ -200,10 +301,14 @@ def main():
         if (header_version[header_ver] < 3):
             bin_data += struct.pack('32s', hashlib.md5(data).digest())
             if (header_version[header_ver] == 2):
-                # Todo, if it's diff OTA, write base app check data len
-                bin_data += struct.pack('<I', 0)
-                # Todo, if it's diff OTA, write base app crc32 checksum
-                bin_data += struct.pack('<I', 0)
+                base_data = b''
+                if base_file != '':
+                    with open(base_file, 'rb') as b_f:
+                        base_data = b_f.read(OLD_APP_CHECK_DATA_SIZE)
+                # base app check data len
+                bin_data += struct.pack('<I', len(base_data))
+                # base app crc32 checksum
+                bin_data += struct.pack('<I', binascii.crc32(base_data, 0x0) if base_data else 0)
         else:
             bin_data += struct.pack('16s', hashlib.md5(data).digest())
         # The CRC32 for the header
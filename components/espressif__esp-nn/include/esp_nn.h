@@ -46,6 +46,9 @@ extern "C" {
 #include "esp_nn_ansi_c.h"
 #endif
 
+/* explicit variant selection, for autotuning */
+#include "esp_nn_variants.h"
+
 #ifdef __cplusplus
 }
 #endif
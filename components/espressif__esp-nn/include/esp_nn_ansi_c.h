@@ -24,10 +24,15 @@
 
 #define esp_nn_add_elementwise_s8 esp_nn_add_elementwise_s8_ansi
 #define esp_nn_mul_elementwise_s8 esp_nn_mul_elementwise_s8_ansi
+#define esp_nn_add_elementwise_s16 esp_nn_add_elementwise_s16_ansi
+#define esp_nn_mul_elementwise_s16 esp_nn_mul_elementwise_s16_ansi
 
 #define esp_nn_depthwise_conv_s8 esp_nn_depthwise_conv_s8_ansi
+#define esp_nn_depthwise_conv_s16 esp_nn_depthwise_conv_s16_ansi
 
 #define esp_nn_conv_s8 esp_nn_conv_s8_ansi
+#define esp_nn_conv_sparse_s8 esp_nn_conv_sparse_s8_ansi
+#define esp_nn_conv_s16 esp_nn_conv_s16_ansi
 
 #define esp_nn_get_conv_scratch_size esp_nn_get_conv_scratch_size_ansi
 #define esp_nn_set_conv_scratch_buf esp_nn_set_conv_scratch_buf_ansi
@@ -37,11 +42,19 @@
 
 #define esp_nn_relu6_s8 esp_nn_relu6_s8_ansi
 
+#define esp_nn_lut_s8 esp_nn_lut_s8_ansi
+
 #define esp_nn_avg_pool_s8 esp_nn_avg_pool_s8_ansi
 #define esp_nn_max_pool_s8 esp_nn_max_pool_s8_ansi
 
 #define esp_nn_fully_connected_s8 esp_nn_fully_connected_s8_ansi
+#define esp_nn_fully_connected_sparse_s8 esp_nn_fully_connected_sparse_s8_ansi
+#define esp_nn_fully_connected_s16 esp_nn_fully_connected_s16_ansi
 
 #define esp_nn_get_softmax_scratch_size esp_nn_get_softmax_scratch_size_ansi
 #define esp_nn_set_softmax_scratch_buf esp_nn_set_softmax_scratch_buf_ansi
 #define esp_nn_softmax_s8 esp_nn_softmax_s8_ansi
+
+#define esp_nn_get_preprocess_image_scratch_size esp_nn_get_preprocess_image_scratch_size_ansi
+#define esp_nn_set_preprocess_image_scratch_buf esp_nn_set_preprocess_image_scratch_buf_ansi
+#define esp_nn_preprocess_image_s8 esp_nn_preprocess_image_s8_ansi
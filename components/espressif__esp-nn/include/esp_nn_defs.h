@@ -0,0 +1,176 @@
+// Copyright 2022 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+
+/**
+ * @brief structure to club data dims
+ * this structure can be used for input, output and filter
+ */
+typedef struct data_dims {
+    int32_t width;
+    int32_t height;
+    int32_t channels;
+
+    int32_t extra; // can be used as batch or any other param
+} data_dims_t;
+
+/**
+ * @brief 2d data structure (width, height)
+ *
+ */
+typedef struct data_2d {
+    int32_t width;
+    int32_t height;
+} data_2d_t;
+
+/**
+ * @brief min/max activation
+ */
+typedef struct act_params {
+    int32_t min;
+    int32_t max;
+} act_params_t;
+
+/**
+ * @brief per channel quant data
+ *
+ * @note number of shift and mult elements are equal to output channels
+ */
+typedef struct quant_data {
+    int32_t *shift;
+    int32_t *mult;
+} quant_data_t;
+
+/**
+ * @brief params specific to convolution 2d
+ *
+ */
+typedef struct conv_params {
+    int32_t in_offset;
+    int32_t out_offset;
+    data_2d_t stride;
+    data_2d_t padding;
+    data_2d_t dilation;
+    act_params_t activation;
+} conv_params_t;
+
+/**
+ * @brief params specific to depthwise convolution 2d
+ *
+ */
+typedef struct dw_conv_params {
+    int32_t in_offset;
+    int32_t out_offset;
+    int32_t ch_mult; // channel multiplier. (in_ch * ch_mult = out_ch)
+    data_2d_t stride;
+    data_2d_t padding;
+    data_2d_t dilation;
+    act_params_t activation;
+} dw_conv_params_t;
+
+/**
+ * @brief block sparse (block-CSR) filter data
+ *
+ * @note  Each output channel owns a dense row of `row_len` weights (OHWI
+ *        flattened for convolution). The row is split into blocks of
+ *        `block_len` weights and only blocks holding a non-zero weight are
+ *        stored. Blocks of output channel `c` are [row_ptr[c], row_ptr[c + 1]).
+ *
+ *        col_idx[b] is the position of block `b` in its dense row, in units of
+ *        block_len. For convolution, block_len must divide input channels so a
+ *        block never straddles two filter taps.
+ *
+ *        filter offset is expected to be 0 (symmetric weights), otherwise the
+ *        skipped zero weights would contribute to the result.
+ */
+typedef struct sparse_data {
+    const int8_t *values;       // num_blocks * block_len weights
+    const int32_t *row_ptr;     // out_channels + 1 entries
+    const uint16_t *col_idx;    // num_blocks entries
+    int32_t block_len;
+} sparse_data_t;
+
+/**
+ * @brief kernel variants selectable through the `_variant` entry points
+ *
+ * @note  Values are persisted by autotuners (NVS blobs, generated tables), so
+ *        existing entries must never be renumbered. Target specific variants
+ *        are only valid on that target; DEFAULT is the built-in heuristic.
+ */
+typedef enum {
+    ESP_NN_VARIANT_DEFAULT = 0,
+    ESP_NN_VARIANT_ANSI = 1,
+    ESP_NN_VARIANT_OPT = 2,
+
+    /* esp32s3 convolution */
+    ESP_NN_VARIANT_S3_CONV_1X1 = 16,
+    ESP_NN_VARIANT_S3_CONV_PADDED = 17,
+
+    /* esp32s3 depthwise convolution */
+    ESP_NN_VARIANT_S3_DW_MULT1_3X3_PADDED = 32,
+    ESP_NN_VARIANT_S3_DW_MULT1_3X3 = 33,
+    ESP_NN_VARIANT_S3_DW_MULT1 = 34,
+    ESP_NN_VARIANT_S3_DW_MULT8_3X3 = 35,
+    ESP_NN_VARIANT_S3_DW_MULT8 = 36,
+    ESP_NN_VARIANT_S3_DW_MULT4 = 37,
+    ESP_NN_VARIANT_S3_DW_GENERIC = 38,
+} esp_nn_variant_t;
+
+/* upper bound on the number of variants eligible for a single layer */
+#define ESP_NN_MAX_VARIANTS     10
+
+/**
+ * @brief camera pixel layouts accepted by the image preprocessing kernels
+ *
+ * @note  RGB565 is big endian as delivered by the camera (RRRRRGGG GGGBBBBB),
+ *        BGR565 the same with red and blue swapped (BBBBBGGG GGGRRRRR).
+ *        YUV422 is YUYV ordered (Y0 U Y1 V). GRAY is one byte per pixel.
+ */
+typedef enum {
+    ESP_NN_PIXEL_RGB565 = 0,
+    ESP_NN_PIXEL_YUV422 = 1,
+    ESP_NN_PIXEL_GRAY = 2,
+    ESP_NN_PIXEL_BGR565 = 3,
+} esp_nn_pixel_format_t;
+
+/**
+ * @brief resampling used when the crop and output sizes differ
+ */
+typedef enum {
+    ESP_NN_RESIZE_NEAREST = 0,
+    ESP_NN_RESIZE_BILINEAR = 1,
+    ESP_NN_RESIZE_AREA = 2,     // box average, meant for downscaling
+} esp_nn_resize_t;
+
+/**
+ * @brief params specific to image preprocessing
+ *
+ * @note  crop is relative to the input image, a zero sized crop selects the
+ *        whole image. Luma `y` (0..255) is quantized as
+ *        out = clamp(((y * norm_mult + (1 << 15)) >> 16) + out_offset)
+ *        so norm_mult 65536 with out_offset -128 gives the usual y - 128.
+ */
+typedef struct image_preprocess_params {
+    esp_nn_pixel_format_t format;
+    esp_nn_resize_t resize;
+    int32_t crop_x;
+    int32_t crop_y;
+    data_2d_t crop;
+    int32_t norm_mult;  // Q16
+    int32_t out_offset;
+    act_params_t activation;
+} image_preprocess_params_t;
@@ -125,6 +125,136 @@ int esp_nn_get_depthwise_conv_scratch_size_esp32s3(const data_dims_t *input_dims
                                                    const dw_conv_params_t *conv_params);
 void esp_nn_set_depthwise_conv_scratch_buf_esp32s3(const void *buf);
 
+/**
+ * @brief       variant level entry points used by autotuning
+ *
+ * @note        `_variants_` fills `variants` with the kernels eligible for the
+ *              layer (default choice first) and returns their count.
+ *              `_variant_` runs the given one; ESP_NN_VARIANT_DEFAULT picks the
+ *              same kernel as the plain entry point. All variants produce
+ *              bit-exact results, they only differ in speed and scratch need.
+ */
+int esp_nn_conv_s8_variants_esp32s3(const data_dims_t *input_dims,
+                                    const data_dims_t *filter_dims,
+                                    const data_dims_t *output_dims,
+                                    const conv_params_t *conv_params,
+                                    esp_nn_variant_t *variants,
+                                    const int max_variants);
+
+int esp_nn_get_conv_scratch_size_variant_esp32s3(esp_nn_variant_t variant,
+                                                 const data_dims_t *input_dims,
+                                                 const data_dims_t *filter_dims,
+                                                 const data_dims_t *output_dims,
+                                                 const conv_params_t *conv_params);
+
+void esp_nn_conv_s8_variant_esp32s3(esp_nn_variant_t variant,
+                                    const data_dims_t *input_dims,
+                                    const int8_t *input_data,
+                                    const data_dims_t *filter_dims,
+                                    const int8_t *filter_data,
+                                    const int32_t *bias,
+                                    const data_dims_t *output_dims,
+                                    int8_t *output_data,
+                                    const conv_params_t *conv_params,
+                                    const quant_data_t *quant_data);
+
+int esp_nn_depthwise_conv_s8_variants_esp32s3(const data_dims_t *input_dims,
+                                              const data_dims_t *filter_dims,
+                                              const data_dims_t *output_dims,
+                                              const dw_conv_params_t *conv_params,
+                                              esp_nn_variant_t *variants,
+                                              const int max_variants);
+
+int esp_nn_get_depthwise_conv_scratch_size_variant_esp32s3(esp_nn_variant_t variant,
+                                                           const data_dims_t *input_dims,
+                                                           const data_dims_t *filter_dims,
+                                                           const data_dims_t *output_dims,
+                                                           const dw_conv_params_t *conv_params);
+
+void esp_nn_depthwise_conv_s8_variant_esp32s3(esp_nn_variant_t variant,
+                                              const data_dims_t *input_dims,
+                                              const int8_t *input_data,
+                                              const data_dims_t *filter_dims,
+                                              const int8_t *filter_data,
+                                              const int32_t *bias,
+                                              const data_dims_t *output_dims,
+                                              int8_t *output_data,
+                                              const dw_conv_params_t *conv_params,
+                                              const quant_data_t *quant_data);
+
+/**
+ * @brief       prepare-time filter packing
+ *
+ * @note        `_pack_filter_` copies the filter once into the layout the
+ *              variant works on: rows zero padded for the conv kernels, an
+ *              aligned or s16 widened copy for depthwise. `packed_filter` must
+ *              be 16 byte aligned and `_packed_filter_size_` bytes long; size 0
+ *              means the variant gains nothing from packing.
+ *              `_packed_` kernels take the packed filter and need only
+ *              `_packed_scratch_size_` bytes of scratch.
+ */
+int esp_nn_get_conv_packed_filter_size_esp32s3(esp_nn_variant_t variant,
+                                               const data_dims_t *input_dims,
+                                               const data_dims_t *filter_dims,
+                                               const data_dims_t *output_dims,
+                                               const conv_params_t *conv_params);
+
+void esp_nn_conv_pack_filter_esp32s3(esp_nn_variant_t variant,
+                                     const data_dims_t *input_dims,
+                                     const data_dims_t *filter_dims,
+                                     const data_dims_t *output_dims,
+                                     const conv_params_t *conv_params,
+                                     const int8_t *filter_data,
+                                     int8_t *packed_filter);
+
+int esp_nn_get_conv_packed_scratch_size_esp32s3(esp_nn_variant_t variant,
+                                                const data_dims_t *input_dims,
+                                                const data_dims_t *filter_dims,
+                                                const data_dims_t *output_dims,
+                                                const conv_params_t *conv_params);
+
+void esp_nn_conv_s8_packed_esp32s3(esp_nn_variant_t variant,
+                                   const data_dims_t *input_dims,
+                                   const int8_t *input_data,
+                                   const data_dims_t *filter_dims,
+                                   const int8_t *packed_filter,
+                                   const int32_t *bias,
+                                   const data_dims_t *output_dims,
+                                   int8_t *output_data,
+                                   const conv_params_t *conv_params,
+                                   const quant_data_t *quant_data);
+
+int esp_nn_get_depthwise_conv_packed_filter_size_esp32s3(esp_nn_variant_t variant,
+                                                         const data_dims_t *input_dims,
+                                                         const data_dims_t *filter_dims,
+                                                         const data_dims_t *output_dims,
+                                                         const dw_conv_params_t *conv_params);
+
+void esp_nn_depthwise_conv_pack_filter_esp32s3(esp_nn_variant_t variant,
+                                               const data_dims_t *input_dims,
+                                               const data_dims_t *filter_dims,
+                                               const data_dims_t *output_dims,
+                                               const dw_conv_params_t *conv_params,
+                                               const int8_t *filter_data,
+                                               void *packed_filter);
+
+int esp_nn_get_depthwise_conv_packed_scratch_size_esp32s3(esp_nn_variant_t variant,
+                                                          const data_dims_t *input_dims,
+                                                          const data_dims_t *filter_dims,
+                                                          const data_dims_t *output_dims,
+                                                          const dw_conv_params_t *conv_params);
+
+void esp_nn_depthwise_conv_s8_packed_esp32s3(esp_nn_variant_t variant,
+                                             const data_dims_t *input_dims,
+                                             const int8_t *input_data,
+                                             const data_dims_t *filter_dims,
+                                             const void *packed_filter,
+                                             const int32_t *bias,
+                                             const data_dims_t *output_dims,
+                                             int8_t *output_data,
+                                             const dw_conv_params_t *conv_params,
+                                             const quant_data_t *quant_data);
+
 /************************** Pooling functions *****************************/
 
 /**
@@ -208,8 +338,11 @@ void esp_nn_relu6_s8_esp32s3(int8_t *data, uint16_t size);
 
 #define esp_nn_add_elementwise_s8 esp_nn_add_elementwise_s8_esp32s3
 #define esp_nn_mul_elementwise_s8 esp_nn_mul_elementwise_s8_esp32s3
+#define esp_nn_add_elementwise_s16 esp_nn_add_elementwise_s16_ansi
+#define esp_nn_mul_elementwise_s16 esp_nn_mul_elementwise_s16_ansi
 
 #define esp_nn_depthwise_conv_s8 esp_nn_depthwise_conv_s8_esp32s3
+#define esp_nn_depthwise_conv_s16 esp_nn_depthwise_conv_s16_opt
 
 #define esp_nn_get_conv_scratch_size esp_nn_get_conv_scratch_size_esp32s3
 #define esp_nn_set_conv_scratch_buf esp_nn_set_conv_scratch_buf_esp32s3
@@ -218,14 +351,24 @@ void esp_nn_relu6_s8_esp32s3(int8_t *data, uint16_t size);
 #define esp_nn_set_depthwise_conv_scratch_buf esp_nn_set_depthwise_conv_scratch_buf_esp32s3
 
 #define esp_nn_conv_s8 esp_nn_conv_s8_esp32s3
+#define esp_nn_conv_sparse_s8 esp_nn_conv_sparse_s8_opt
+#define esp_nn_conv_s16 esp_nn_conv_s16_opt
 
 #define esp_nn_relu6_s8 esp_nn_relu6_s8_esp32s3
 
+#define esp_nn_lut_s8 esp_nn_lut_s8_opt
+
 #define esp_nn_avg_pool_s8 esp_nn_avg_pool_s8_esp32s3
 #define esp_nn_max_pool_s8 esp_nn_max_pool_s8_esp32s3
 
 #define esp_nn_fully_connected_s8 esp_nn_fully_connected_s8_esp32s3
+#define esp_nn_fully_connected_sparse_s8 esp_nn_fully_connected_sparse_s8_opt
+#define esp_nn_fully_connected_s16 esp_nn_fully_connected_s16_opt
 
 #define esp_nn_get_softmax_scratch_size esp_nn_get_softmax_scratch_size_opt
 #define esp_nn_set_softmax_scratch_buf esp_nn_set_softmax_scratch_buf_opt
 #define esp_nn_softmax_s8 esp_nn_softmax_s8_opt
+
+#define esp_nn_get_preprocess_image_scratch_size esp_nn_get_preprocess_image_scratch_size_opt
+#define esp_nn_set_preprocess_image_scratch_buf esp_nn_set_preprocess_image_scratch_buf_opt
+#define esp_nn_preprocess_image_s8 esp_nn_preprocess_image_s8_opt
@@ -0,0 +1,416 @@
+// Copyright 2024 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+/**
+ * @file        Explicit kernel variant selection, used by autotuners.
+ *
+ * @note        The plain `esp_nn_conv_s8` style entry points pick a kernel
+ *              with a fixed shape heuristic. The functions below expose the
+ *              kernels eligible for a layer so that a caller can time them
+ *              and dispatch to the fastest one directly afterwards.
+ *
+ *              Prepare-time packing lets a caller copy a constant filter,
+ *              once, into the layout the chosen variant works on, instead of
+ *              the kernel realigning it on every call.
+ *
+ *              This header is included from esp_nn.h after the target
+ *              mapping header and must not be included on its own.
+ */
+
+/**
+ * @brief       list conv kernels eligible for the layer
+ *
+ * @return      number of entries written to `variants`, default choice first
+ */
+static inline int esp_nn_conv_s8_variants(const data_dims_t *input_dims,
+                                          const data_dims_t *filter_dims,
+                                          const data_dims_t *output_dims,
+                                          const conv_params_t *conv_params,
+                                          esp_nn_variant_t *variants,
+                                          const int max_variants)
+{
+    int count = 0;
+#if defined(CONFIG_NN_OPTIMIZED)
+#if defined(ARCH_ESP32_S3)
+    count = esp_nn_conv_s8_variants_esp32s3(input_dims, filter_dims, output_dims,
+                                            conv_params, variants, max_variants);
+#elif defined(ARCH_ESP32_P4)
+    if (count < max_variants) {
+        variants[count++] = ESP_NN_VARIANT_DEFAULT;
+    }
+#endif
+    if (count < max_variants) {
+        variants[count++] = ESP_NN_VARIANT_OPT;
+    }
+#endif
+    if (count < max_variants) {
+        variants[count++] = ESP_NN_VARIANT_ANSI;
+    }
+    return count;
+}
+
+static inline int esp_nn_get_conv_scratch_size_variant(const esp_nn_variant_t variant,
+                                                       const data_dims_t *input_dims,
+                                                       const data_dims_t *filter_dims,
+                                                       const data_dims_t *output_dims,
+                                                       const conv_params_t *conv_params)
+{
+    switch (variant) {
+    case ESP_NN_VARIANT_ANSI:
+        return esp_nn_get_conv_scratch_size_ansi(input_dims, filter_dims, output_dims, conv_params);
+    case ESP_NN_VARIANT_OPT:
+        return esp_nn_get_conv_scratch_size_opt(input_dims, filter_dims, output_dims, conv_params);
+    default:
+#if defined(CONFIG_NN_OPTIMIZED) && defined(ARCH_ESP32_S3)
+        return esp_nn_get_conv_scratch_size_variant_esp32s3(variant, input_dims, filter_dims,
+                                                            output_dims, conv_params);
+#else
+        return esp_nn_get_conv_scratch_size(input_dims, filter_dims, output_dims, conv_params);
+#endif
+    }
+}
+
+/**
+ * @brief       run a specific conv kernel
+ *
+ * @note        scratch buffer is still set with `esp_nn_set_conv_scratch_buf`
+ *              and must be at least `esp_nn_get_conv_scratch_size_variant` bytes
+ */
+static inline void esp_nn_conv_s8_variant(const esp_nn_variant_t variant,
+                                          const data_dims_t *input_dims,
+                                          const int8_t *input_data,
+                                          const data_dims_t *filter_dims,
+                                          const int8_t *filter_data,
+                                          const int32_t *bias,
+                                          const data_dims_t *output_dims,
+                                          int8_t *output_data,
+                                          const conv_params_t *conv_params,
+                                          const quant_data_t *quant_data)
+{
+    switch (variant) {
+    case ESP_NN_VARIANT_ANSI:
+        esp_nn_conv_s8_ansi(input_dims, input_data, filter_dims, filter_data, bias,
+                            output_dims, output_data, conv_params, quant_data);
+        break;
+    case ESP_NN_VARIANT_OPT:
+        esp_nn_conv_s8_opt(input_dims, input_data, filter_dims, filter_data, bias,
+                           output_dims, output_data, conv_params, quant_data);
+        break;
+    default:
+#if defined(CONFIG_NN_OPTIMIZED) && defined(ARCH_ESP32_S3)
+        esp_nn_conv_s8_variant_esp32s3(variant, input_dims, input_data, filter_dims, filter_data,
+                                       bias, output_dims, output_data, conv_params, quant_data);
+#else
+        esp_nn_conv_s8(input_dims, input_data, filter_dims, filter_data, bias,
+                       output_dims, output_data, conv_params, quant_data);
+#endif
+        break;
+    }
+}
+
+/**
+ * @brief       list depthwise conv kernels eligible for the layer
+ *
+ * @return      number of entries written to `variants`, default choice first
+ */
+static inline int esp_nn_depthwise_conv_s8_variants(const data_dims_t *input_dims,
+                                                    const data_dims_t *filter_dims,
+                                                    const data_dims_t *output_dims,
+                                                    const dw_conv_params_t *conv_params,
+                                                    esp_nn_variant_t *variants,
+                                                    const int max_variants)
+{
+    int count = 0;
+#if defined(CONFIG_NN_OPTIMIZED)
+#if defined(ARCH_ESP32_S3)
+    count = esp_nn_depthwise_conv_s8_variants_esp32s3(input_dims, filter_dims, output_dims,
+                                                      conv_params, variants, max_variants);
+#endif
+    if (count < max_variants) {
+        variants[count++] = ESP_NN_VARIANT_OPT;
+    }
+#endif
+    if (count < max_variants) {
+        variants[count++] = ESP_NN_VARIANT_ANSI;
+    }
+    return count;
+}
+
+static inline int esp_nn_get_depthwise_conv_scratch_size_variant(const esp_nn_variant_t variant,
+                                                                 const data_dims_t *input_dims,
+                                                                 const data_dims_t *filter_dims,
+                                                                 const data_dims_t *output_dims,
+                                                                 const dw_conv_params_t *conv_params)
+{
+    switch (variant) {
+    case ESP_NN_VARIANT_ANSI:
+        return esp_nn_get_depthwise_conv_scratch_size_ansi(input_dims, filter_dims,
+                                                           output_dims, conv_params);
+    case ESP_NN_VARIANT_OPT:
+        return esp_nn_get_depthwise_conv_scratch_size_opt(input_dims, filter_dims,
+                                                          output_dims, conv_params);
+    default:
+#if defined(CONFIG_NN_OPTIMIZED) && defined(ARCH_ESP32_S3)
+        return esp_nn_get_depthwise_conv_scratch_size_variant_esp32s3(variant, input_dims, filter_dims,
+                                                                      output_dims, conv_params);
+#else
+        return esp_nn_get_depthwise_conv_scratch_size(input_dims, filter_dims,
+                                                      output_dims, conv_params);
+#endif
+    }
+}
+
+/**
+ * @brief       run a specific depthwise conv kernel
+ *
+ * @note        scratch buffer is still set with `esp_nn_set_depthwise_conv_scratch_buf`
+ */
+static inline void esp_nn_depthwise_conv_s8_variant(const esp_nn_variant_t variant,
+                                                    const data_dims_t *input_dims,
+                                                    const int8_t *input_data,
+                                                    const data_dims_t *filter_dims,
+                                                    const int8_t *filter_data,
+                                                    const int32_t *bias,
+                                                    const data_dims_t *output_dims,
+                                                    int8_t *output_data,
+                                                    const dw_conv_params_t *conv_params,
+                                                    const quant_data_t *quant_data)
+{
+    switch (variant) {
+    case ESP_NN_VARIANT_ANSI:
+        esp_nn_depthwise_conv_s8_ansi(input_dims, input_data, filter_dims, filter_data, bias,
+                                      output_dims, output_data, conv_params, quant_data);
+        break;
+    case ESP_NN_VARIANT_OPT:
+        esp_nn_depthwise_conv_s8_opt(input_dims, input_data, filter_dims, filter_data, bias,
+                                     output_dims, output_data, conv_params, quant_data);
+        break;
+    default:
+#if defined(CONFIG_NN_OPTIMIZED) && defined(ARCH_ESP32_S3)
+        esp_nn_depthwise_conv_s8_variant_esp32s3(variant, input_dims, input_data, filter_dims,
+                                                 filter_data, bias, output_dims, output_data,
+                                                 conv_params, quant_data);
+#else
+        esp_nn_depthwise_conv_s8(input_dims, input_data, filter_dims, filter_data, bias,
+                                 output_dims, output_data, conv_params, quant_data);
+#endif
+        break;
+    }
+}
+
+/**
+ * @brief       bytes needed for the packed conv filter of `variant`
+ *
+ * @return      0 if the variant runs on the original filter as is
+ */
+static inline int esp_nn_get_conv_packed_filter_size(const esp_nn_variant_t variant,
+                                                     const data_dims_t *input_dims,
+                                                     const data_dims_t *filter_dims,
+                                                     const data_dims_t *output_dims,
+                                                     const conv_params_t *conv_params)
+{
+#if defined(CONFIG_NN_OPTIMIZED) && defined(ARCH_ESP32_S3)
+    if (variant != ESP_NN_VARIANT_ANSI && variant != ESP_NN_VARIANT_OPT) {
+        return esp_nn_get_conv_packed_filter_size_esp32s3(variant, input_dims, filter_dims,
+                                                          output_dims, conv_params);
+    }
+#endif
+    return 0;
+}
+
+/**
+ * @brief       pack the conv filter for `variant`
+ *
+ * @note        `packed_filter` must be 16 byte aligned
+ */
+static inline void esp_nn_conv_pack_filter(const esp_nn_variant_t variant,
+                                           const data_dims_t *input_dims,
+                                           const data_dims_t *filter_dims,
+                                           const data_dims_t *output_dims,
+                                           const conv_params_t *conv_params,
+                                           const int8_t *filter_data,
+                                           void *packed_filter)
+{
+#if defined(CONFIG_NN_OPTIMIZED) && defined(ARCH_ESP32_S3)
+    if (variant != ESP_NN_VARIANT_ANSI && variant != ESP_NN_VARIANT_OPT) {
+        esp_nn_conv_pack_filter_esp32s3(variant, input_dims, filter_dims, output_dims,
+                                        conv_params, filter_data, (int8_t *) packed_filter);
+    }
+#endif
+}
+
+static inline int esp_nn_get_conv_packed_scratch_size(const esp_nn_variant_t variant,
+                                                      const data_dims_t *input_dims,
+                                                      const data_dims_t *filter_dims,
+                                                      const data_dims_t *output_dims,
+                                                      const conv_params_t *conv_params)
+{
+    if (esp_nn_get_conv_packed_filter_size(variant, input_dims, filter_dims,
+                                           output_dims, conv_params) == 0) {
+        return esp_nn_get_conv_scratch_size_variant(variant, input_dims, filter_dims,
+                                                    output_dims, conv_params);
+    }
+#if defined(CONFIG_NN_OPTIMIZED) && defined(ARCH_ESP32_S3)
+    return esp_nn_get_conv_packed_scratch_size_esp32s3(variant, input_dims, filter_dims,
+                                                       output_dims, conv_params);
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief       run `variant` on a filter prepared with `esp_nn_conv_pack_filter`
+ *
+ * @note        `packed_filter` is the original filter when the packed size is 0
+ */
+static inline void esp_nn_conv_s8_packed(const esp_nn_variant_t variant,
+                                         const data_dims_t *input_dims,
+                                         const int8_t *input_data,
+                                         const data_dims_t *filter_dims,
+                                         const void *packed_filter,
+                                         const int32_t *bias,
+                                         const data_dims_t *output_dims,
+                                         int8_t *output_data,
+                                         const conv_params_t *conv_params,
+                                         const quant_data_t *quant_data)
+{
+    if (esp_nn_get_conv_packed_filter_size(variant, input_dims, filter_dims,
+                                           output_dims, conv_params) == 0) {
+        esp_nn_conv_s8_variant(variant, input_dims, input_data, filter_dims,
+                               (const int8_t *) packed_filter, bias, output_dims,
+                               output_data, conv_params, quant_data);
+        return;
+    }
+#if defined(CONFIG_NN_OPTIMIZED) && defined(ARCH_ESP32_S3)
+    esp_nn_conv_s8_packed_esp32s3(variant, input_dims, input_data, filter_dims,
+                                  (const int8_t *) packed_filter, bias, output_dims,
+                                  output_data, conv_params, quant_data);
+#endif
+}
+
+/**
+ * @brief       bytes needed for the packed depthwise filter of `variant`
+ *
+ * @return      0 if the variant runs on the original filter as is
+ */
+static inline int esp_nn_get_depthwise_conv_packed_filter_size(const esp_nn_variant_t variant,
+                                                               const data_dims_t *input_dims,
+                                                               const data_dims_t *filter_dims,
+                                                               const data_dims_t *output_dims,
+                                                               const dw_conv_params_t *conv_params)
+{
+#if defined(CONFIG_NN_OPTIMIZED) && defined(ARCH_ESP32_S3)
+    if (variant != ESP_NN_VARIANT_ANSI && variant != ESP_NN_VARIANT_OPT) {
+        return esp_nn_get_depthwise_conv_packed_filter_size_esp32s3(variant, input_dims, filter_dims,
+                                                                    output_dims, conv_params);
+    }
+#endif
+    return 0;
+}
+
+/**
+ * @brief       pack the depthwise conv filter for `variant`
+ *
+ * @note        `packed_filter` must be 16 byte aligned
+ */
+static inline void esp_nn_depthwise_conv_pack_filter(const esp_nn_variant_t variant,
+                                                     const data_dims_t *input_dims,
+                                                     const data_dims_t *filter_dims,
+                                                     const data_dims_t *output_dims,
+                                                     const dw_conv_params_t *conv_params,
+                                                     const int8_t *filter_data,
+                                                     void *packed_filter)
+{
+#if defined(CONFIG_NN_OPTIMIZED) && defined(ARCH_ESP32_S3)
+    if (variant != ESP_NN_VARIANT_ANSI && variant != ESP_NN_VARIANT_OPT) {
+        esp_nn_depthwise_conv_pack_filter_esp32s3(variant, input_dims, filter_dims, output_dims,
+                                                  conv_params, filter_data, packed_filter);
+    }
+#endif
+}
+
+static inline int esp_nn_get_depthwise_conv_packed_scratch_size(const esp_nn_variant_t variant,
+                                                                const data_dims_t *input_dims,
+                                                                const data_dims_t *filter_dims,
+                                                                const data_dims_t *output_dims,
+                                                                const dw_conv_params_t *conv_params)
+{
+    if (esp_nn_get_depthwise_conv_packed_filter_size(variant, input_dims, filter_dims,
+                                                     output_dims, conv_params) == 0) {
+        return esp_nn_get_depthwise_conv_scratch_size_variant(variant, input_dims, filter_dims,
+                                                              output_dims, conv_params);
+    }
+#if defined(CONFIG_NN_OPTIMIZED) && defined(ARCH_ESP32_S3)
+    return esp_nn_get_depthwise_conv_packed_scratch_size_esp32s3(variant, input_dims, filter_dims,
+                                                                 output_dims, conv_params);
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief       run `variant` on a filter prepared with `esp_nn_depthwise_conv_pack_filter`
+ *
+ * @note        `packed_filter` is the original filter when the packed size is 0
+ */
+static inline void esp_nn_depthwise_conv_s8_packed(const esp_nn_variant_t variant,
+                                                   const data_dims_t *input_dims,
+                                                   const int8_t *input_data,
+                                                   const data_dims_t *filter_dims,
+                                                   const void *packed_filter,
+                                                   const int32_t *bias,
+                                                   const data_dims_t *output_dims,
+                                                   int8_t *output_data,
+                                                   const dw_conv_params_t *conv_params,
+                                                   const quant_data_t *quant_data)
+{
+    if (esp_nn_get_depthwise_conv_packed_filter_size(variant, input_dims, filter_dims,
+                                                     output_dims, conv_params) == 0) {
+        esp_nn_depthwise_conv_s8_variant(variant, input_dims, input_data, filter_dims,
+                                         (const int8_t *) packed_filter, bias, output_dims,
+                                         output_data, conv_params, quant_data);
+        return;
+    }
+#if defined(CONFIG_NN_OPTIMIZED) && defined(ARCH_ESP32_S3)
+    esp_nn_depthwise_conv_s8_packed_esp32s3(variant, input_dims, input_data, filter_dims,
+                                            packed_filter, bias, output_dims,
+                                            output_data, conv_params, quant_data);
+#endif
+}
+
+/**
+ * @brief       fold the input offset into bias
+ *
+ * @note        folded_bias[c] = bias[c] + in_offset * sum(filter row c), so the
+ *              kernel can then run with in_offset = 0. Only valid when every
+ *              filter tap reads real input (no padding) and filter offset is 0.
+ *              `bias` may be NULL.
+ */
+static inline void esp_nn_fold_input_offset_s8(const int8_t *filter_data,
+                                               const int32_t *bias,
+                                               const int32_t in_offset,
+                                               const int32_t row_len,
+                                               const int32_t out_channels,
+                                               int32_t *folded_bias)
+{
+    for (int32_t out_c = 0; out_c < out_channels; out_c++) {
+        int32_t filter_sum = 0;
+        for (int32_t i = 0; i < row_len; i++) {
+            filter_sum += *filter_data++;
+        }
+        folded_bias[out_c] = (bias ? bias[out_c] : 0) + in_offset * filter_sum;
+    }
+}
@@ -1,4 +1,4 @@
-// Copyright 2015-2016 Espressif Systems (Shanghai) PTE LTD
+// Copyright 2024 Espressif Systems (Shanghai) PTE LTD
 //
 // Licensed under the Apache License, Version 2.0 (the "License");
 // you may not use this file except in compliance with the License.
@@ -11,19 +11,17 @@
 // WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 // See the License for the specific language governing permissions and
 // limitations under the License.
-#ifndef _CONVERSIONS_YUV_H_
-#define _CONVERSIONS_YUV_H_
-
-#ifdef __cplusplus
-extern "C" {
-#endif
 
 #include <stdint.h>
 
-void yuv2rgb(uint8_t y, uint8_t u, uint8_t v, uint8_t *r, uint8_t *g, uint8_t *b);
+#include <common_functions.h>
 
-#ifdef __cplusplus
+void esp_nn_lut_s8_ansi(const int8_t *input,
+                        int8_t *output,
+                        const int8_t *lut,
+                        const int32_t size)
+{
+    for (int32_t i = 0; i < size; i++) {
+        output[i] = lut[(uint8_t) input[i]];
+    }
 }
-#endif
-
-#endif /* _CONVERSIONS_YUV_H_ */
@@ -0,0 +1,53 @@
+// Copyright 2024 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdint.h>
+
+#include <common_functions.h>
+
+/**
+ * There is no gather instruction on any of the supported cores, so the win
+ * here comes from breaking the load -> lookup -> store dependency chain:
+ * four independent lookups are issued back to back and written with a single
+ * 32 bit store when output is word aligned.
+ */
+void esp_nn_lut_s8_opt(const int8_t *input,
+                       int8_t *output,
+                       const int8_t *lut,
+                       const int32_t size)
+{
+    const uint8_t *in = (const uint8_t *) input;
+    const uint8_t *table = (const uint8_t *) lut;
+    int32_t i = 0;
+
+    /* align output to 4 bytes */
+    while (i < size && ((uintptr_t) (output + i) & 3)) {
+        output[i] = lut[in[i]];
+        i++;
+    }
+
+    uint32_t *out32 = (uint32_t *) (output + i);
+    for (; i < size - 3; i += 4) {
+        uint32_t b0 = table[in[i + 0]];
+        uint32_t b1 = table[in[i + 1]];
+        uint32_t b2 = table[in[i + 2]];
+        uint32_t b3 = table[in[i + 3]];
+        /* little endian: lowest address goes to lowest byte */
+        *out32++ = b0 | (b1 << 8) | (b2 << 16) | (b3 << 24);
+    }
+
+    for (; i < size; i++) {
+        output[i] = lut[in[i]];
+    }
+}
@@ -170,6 +170,75 @@ __NN_FORCE_INLINE__ int32_t esp_nn_multiply_by_quantized_mult_fast(int32_t x, in
     return result;
 }
 
+/**
+ * @brief       requantize 64 bit accumulator of the 16x8 (s16 input, s8 filter) kernels
+ *
+ * @note        mult is reduced to 16 bits and applied with a single rounding
+ *              shift, same as TFLite's int64 MultiplyByQuantizedMultiplier.
+ */
+__NN_FORCE_INLINE__ int32_t esp_nn_multiply_by_quantized_mult_s64(int64_t x, int32_t mult, int32_t shift)
+{
+    const int32_t reduced_mult = mult < 0x7FFF0000 ? (mult + (1 << 15)) >> 16 : 0x7FFF;
+    const int32_t total_shift = 15 - shift;
+    x = x * reduced_mult + ((int64_t) 1 << (total_shift - 1));
+    return (int32_t) (x >> total_shift);
+}
+
+/**
+ * @brief       dot product of s16 input with s8 filter
+ *
+ * @note        |x * w| < 2^22, so runs of 256 products are summed in 32 bit
+ *              and only then widened. Keeps 64 bit adds out of the inner loop.
+ */
+__NN_FORCE_INLINE__ int64_t esp_nn_dot_s16_s8(const int16_t *x, const int8_t *w, const int32_t len)
+{
+    int64_t acc = 0;
+    int32_t idx = 0;
+    while (idx < len) {
+        const int32_t run_end = min(idx + 256, len);
+        int32_t part = 0;
+        for (; idx < run_end - 3; idx += 4) {
+            part += x[idx + 0] * w[idx + 0];
+            part += x[idx + 1] * w[idx + 1];
+            part += x[idx + 2] * w[idx + 2];
+            part += x[idx + 3] * w[idx + 3];
+        }
+        for (; idx < run_end; idx++) {
+            part += x[idx] * w[idx];
+        }
+        acc += part;
+    }
+    return acc;
+}
+
+/**
+ * @brief       dot product of one sparse filter block with input
+ *
+ * @note        input offset is folded out of the inner loop:
+ *                  sum(w * (x + off)) = sum(w * x) + off * sum(w)
+ *              so sum(w) is accumulated into `w_sum` alongside.
+ */
+__NN_FORCE_INLINE__ int32_t esp_nn_sparse_block_dot(const int8_t *w, const int8_t *x,
+                                                    const int32_t block_len, int32_t *w_sum)
+{
+    int32_t acc = 0, sum = 0;
+    if (block_len == 8) {
+        acc += w[0] * x[0] + w[1] * x[1] + w[2] * x[2] + w[3] * x[3];
+        acc += w[4] * x[4] + w[5] * x[5] + w[6] * x[6] + w[7] * x[7];
+        sum += w[0] + w[1] + w[2] + w[3] + w[4] + w[5] + w[6] + w[7];
+    } else if (block_len == 4) {
+        acc += w[0] * x[0] + w[1] * x[1] + w[2] * x[2] + w[3] * x[3];
+        sum += w[0] + w[1] + w[2] + w[3];
+    } else {
+        for (int32_t k = 0; k < block_len; k++) {
+            acc += w[k] * x[k];
+            sum += w[k];
+        }
+    }
+    *w_sum += sum;
+    return acc;
+}
+
 static void esp_nn_aligned_s8_pad_with_value(const int8_t *src, int8_t *dst,
                                              const uint16_t input_wd,
                                              const uint16_t input_ht,
@@ -95,10 +95,46 @@ extern void esp_nn_conv_s8_filter_aligned_input_padded_esp32s3(
                 const int32_t activation_max,
                 void *scratch_buffer);
 
-int esp_nn_get_conv_scratch_size_esp32s3(const data_dims_t *input_dims,
-                                         const data_dims_t *filter_dims,
-                                         const data_dims_t *output_dims,
-                                         const conv_params_t *conv_params)
+/* the 1x1 kernel only handles unpadded, unit stride 1x1 filters */
+static bool esp_nn_conv_s8_1x1_eligible(const data_dims_t *filter_dims,
+                                        const conv_params_t *conv_params)
+{
+    return filter_dims->width == 1 && filter_dims->height == 1 &&
+           conv_params->padding.width == 0 && conv_params->padding.height == 0 &&
+           conv_params->stride.width == 1 && conv_params->stride.height == 1;
+}
+
+static esp_nn_variant_t esp_nn_conv_s8_default_variant(const data_dims_t *filter_dims,
+                                                       const conv_params_t *conv_params)
+{
+    if (esp_nn_conv_s8_1x1_eligible(filter_dims, conv_params)) {
+        return ESP_NN_VARIANT_S3_CONV_1X1;
+    }
+    return ESP_NN_VARIANT_S3_CONV_PADDED;
+}
+
+int esp_nn_conv_s8_variants_esp32s3(const data_dims_t *input_dims,
+                                    const data_dims_t *filter_dims,
+                                    const data_dims_t *output_dims,
+                                    const conv_params_t *conv_params,
+                                    esp_nn_variant_t *variants,
+                                    const int max_variants)
+{
+    int count = 0;
+    if (count < max_variants && esp_nn_conv_s8_1x1_eligible(filter_dims, conv_params)) {
+        variants[count++] = ESP_NN_VARIANT_S3_CONV_1X1;
+    }
+    if (count < max_variants) {
+        variants[count++] = ESP_NN_VARIANT_S3_CONV_PADDED;
+    }
+    return count;
+}
+
+int esp_nn_get_conv_scratch_size_variant_esp32s3(esp_nn_variant_t variant,
+                                                 const data_dims_t *input_dims,
+                                                 const data_dims_t *filter_dims,
+                                                 const data_dims_t *output_dims,
+                                                 const conv_params_t *conv_params)
 {
     const uint16_t input_wd = input_dims->width;
     const uint16_t input_ht = input_dims->height;
@@ -108,8 +144,6 @@ int esp_nn_get_conv_scratch_size_esp32s3(const data_dims_t *input_dims,
     const uint16_t out_ch = output_dims->channels;
     const uint16_t pad_wd = conv_params->padding.width;
     const uint16_t pad_ht = conv_params->padding.height;
-    const uint16_t stride_wd = conv_params->stride.width;
-    const uint16_t stride_ht = conv_params->stride.height;
 
     int new_channels = (in_ch + 7) & ~7;
 
@@ -117,8 +151,10 @@ int esp_nn_get_conv_scratch_size_esp32s3(const data_dims_t *input_dims,
     int filter_scratch = filter_wd * filter_ht * in_ch * out_ch;
 
     int align_buf_size = 32; /* extra buffer for alignment */
-    if ((filter_wd == 1 && filter_ht == 1 && pad_wd == 0 && pad_ht == 0) &&
-            (stride_wd == 1 && stride_ht == 1)) {
+    if (variant == ESP_NN_VARIANT_DEFAULT) {
+        variant = esp_nn_conv_s8_default_variant(filter_dims, conv_params);
+    }
+    if (variant == ESP_NN_VARIANT_S3_CONV_1X1) {
         int transpose_buf_size = 2 * (8 * new_channels); /* to store intermediate data */
         if (input_wd * input_ht < 8) {
             transpose_buf_size = 0; // not using this for leftover
@@ -130,7 +166,7 @@ int esp_nn_get_conv_scratch_size_esp32s3(const data_dims_t *input_dims,
         }
         filter_scratch = new_channels * out_ch;
         return input_scratch + filter_scratch + transpose_buf_size + align_buf_size;
-    } else {
+    } else if (variant == ESP_NN_VARIANT_S3_CONV_PADDED) {
         new_channels = (in_ch + 15) & ~15;
         if (pad_wd == 0 && pad_ht == 0) {
             input_scratch = 0;
@@ -144,20 +180,125 @@ int esp_nn_get_conv_scratch_size_esp32s3(const data_dims_t *input_dims,
     return align_buf_size;
 }
 
+int esp_nn_get_conv_scratch_size_esp32s3(const data_dims_t *input_dims,
+                                         const data_dims_t *filter_dims,
+                                         const data_dims_t *output_dims,
+                                         const conv_params_t *conv_params)
+{
+    return esp_nn_get_conv_scratch_size_variant_esp32s3(ESP_NN_VARIANT_DEFAULT, input_dims,
+                                                        filter_dims, output_dims, conv_params);
+}
+
 void esp_nn_set_conv_scratch_buf_esp32s3(void *buf)
 {
     scratch_buffer = (int16_t *) buf;
 }
 
-void esp_nn_conv_s8_esp32s3(const data_dims_t *input_dims,
-                            const int8_t *input,
-                            const data_dims_t *filter_dims,
-                            const int8_t *filter_data,
-                            const int32_t *bias,
-                            const data_dims_t *output_dims,
-                            int8_t *out_data,
-                            const conv_params_t *conv_params,
-                            const quant_data_t *quant_data)
+int esp_nn_get_conv_packed_filter_size_esp32s3(esp_nn_variant_t variant,
+                                               const data_dims_t *input_dims,
+                                               const data_dims_t *filter_dims,
+                                               const data_dims_t *output_dims,
+                                               const conv_params_t *conv_params)
+{
+    const uint16_t in_ch = input_dims->channels;
+    const uint16_t out_ch = output_dims->channels;
+
+    if (variant == ESP_NN_VARIANT_DEFAULT) {
+        variant = esp_nn_conv_s8_default_variant(filter_dims, conv_params);
+    }
+    if (variant == ESP_NN_VARIANT_S3_CONV_1X1) {
+        return ((in_ch + 7) & ~7) * out_ch;
+    } else if (variant == ESP_NN_VARIANT_S3_CONV_PADDED) {
+        int32_t row_size = (filter_dims->width * in_ch + 15) & ~15;
+        return row_size * filter_dims->height * out_ch;
+    }
+    return 0;
+}
+
+void esp_nn_conv_pack_filter_esp32s3(esp_nn_variant_t variant,
+                                     const data_dims_t *input_dims,
+                                     const data_dims_t *filter_dims,
+                                     const data_dims_t *output_dims,
+                                     const conv_params_t *conv_params,
+                                     const int8_t *filter_data,
+                                     int8_t *packed_filter)
+{
+    const uint16_t in_ch = input_dims->channels;
+    const uint16_t out_ch = output_dims->channels;
+    int32_t row_size, new_row_size, num_rows;
+
+    if (variant == ESP_NN_VARIANT_DEFAULT) {
+        variant = esp_nn_conv_s8_default_variant(filter_dims, conv_params);
+    }
+    if (variant == ESP_NN_VARIANT_S3_CONV_1X1) {
+        /* one row per out channel, channels zero padded to multiple of 8 */
+        row_size = in_ch;
+        new_row_size = (in_ch + 7) & ~7;
+        num_rows = out_ch;
+    } else if (variant == ESP_NN_VARIANT_S3_CONV_PADDED) {
+        /* one row per (out channel, filter row), zero padded to 16 bytes */
+        row_size = filter_dims->width * in_ch;
+        new_row_size = (row_size + 15) & ~15;
+        num_rows = out_ch * filter_dims->height;
+    } else {
+        return;
+    }
+    for (int32_t row_idx = 0; row_idx < num_rows; row_idx++) {
+        memcpy(packed_filter, filter_data, row_size);
+        memset(packed_filter + row_size, 0, new_row_size - row_size);
+        filter_data += row_size;
+        packed_filter += new_row_size;
+    }
+}
+
+int esp_nn_get_conv_packed_scratch_size_esp32s3(esp_nn_variant_t variant,
+                                                const data_dims_t *input_dims,
+                                                const data_dims_t *filter_dims,
+                                                const data_dims_t *output_dims,
+                                                const conv_params_t *conv_params)
+{
+    const uint16_t input_wd = input_dims->width;
+    const uint16_t input_ht = input_dims->height;
+    const uint16_t in_ch = input_dims->channels;
+    const uint16_t out_ch = output_dims->channels;
+    const uint16_t pad_wd = conv_params->padding.width;
+    const uint16_t pad_ht = conv_params->padding.height;
+    int align_buf_size = 32; /* extra buffer for alignment */
+
+    if (variant == ESP_NN_VARIANT_DEFAULT) {
+        variant = esp_nn_conv_s8_default_variant(filter_dims, conv_params);
+    }
+    if (variant == ESP_NN_VARIANT_S3_CONV_1X1) {
+        int new_channels = (in_ch + 7) & ~7;
+        int transpose_buf_size = 2 * (8 * new_channels);
+        if (input_wd * input_ht < 8) {
+            transpose_buf_size = 0;
+        }
+        int input_scratch = (in_ch % 8) ? input_wd * input_ht * new_channels : 0;
+        return input_scratch + transpose_buf_size + align_buf_size;
+    } else if (variant == ESP_NN_VARIANT_S3_CONV_PADDED) {
+        int input_scratch = 0;
+        if (pad_wd || pad_ht) {
+            input_scratch = (input_wd + 2 * pad_wd) * (input_ht + 2 * pad_ht) * in_ch;
+        }
+        return input_scratch + out_ch * 4 + align_buf_size;
+    }
+    return esp_nn_get_conv_scratch_size_variant_esp32s3(variant, input_dims, filter_dims,
+                                                        output_dims, conv_params);
+}
+
+/* `filter_packed`: filter_data is the output of esp_nn_conv_pack_filter_esp32s3 */
+static void esp_nn_conv_s8_run_esp32s3(esp_nn_variant_t variant,
+                                       const data_dims_t *input_dims,
+                                       const int8_t *input,
+                                       const data_dims_t *filter_dims,
+                                       const int8_t *filter_data,
+                                       const bool filter_packed,
+                                       const int32_t *bias,
+                                       const data_dims_t *output_dims,
+                                       int8_t *out_data,
+                                       const conv_params_t *conv_params,
+                                       const quant_data_t *quant_data)
 {
     if (scratch_buffer == NULL) {
         printf("esp_nn_conv error! scratch_buffer not set!\n");
@@ -184,14 +325,31 @@ void esp_nn_conv_s8_esp32s3(const data_dims_t *input_dims,
 
     int filter_size = filter_wd * filter_ht * channels * out_channels;
 
-    if (filter_wd == 1 && filter_ht == 1 && pad_wd == 0 && pad_ht == 0 &&
-            stride_wd == 1 && stride_ht == 1) {
+    if (variant == ESP_NN_VARIANT_DEFAULT) {
+        variant = esp_nn_conv_s8_default_variant(filter_dims, conv_params);
+    }
+
+    if (variant == ESP_NN_VARIANT_S3_CONV_1X1) {
 
         int8_t *input_aligned = (int8_t *) input;
         int8_t *scratch_buf = (int8_t *) scratch_buffer;
         int8_t *filter_aligned = (int8_t *) scratch_buffer;
         int new_channels = channels;
-        if (channels % 8 == 0) {
+        if (filter_packed) {
+            new_channels = (channels + 7) & ~7;
+            filter_aligned = (int8_t *) filter_data;
+            if (new_channels != channels) {
+                input_aligned = (int8_t *) scratch_buffer;
+                for (int input_idx = 0; input_idx < input_ht * input_wd; input_idx++) {
+                    memcpy(input_aligned, input, channels);
+                    memset(input_aligned + channels, 0, new_channels - channels);
+                    input_aligned += new_channels;
+                    input += channels;
+                }
+                input_aligned = (int8_t *) scratch_buffer;
+                scratch_buf = input_aligned + input_ht * input_wd * new_channels;
+            }
+        } else if (channels % 8 == 0) {
             if ((int) filter_data & 7) { // if the filter_data is not aligned to 8 bytes
                 int scratch_offset = (int) (filter_aligned + filter_size);
                 scratch_buf = (int8_t *) (scratch_offset + 16 - (scratch_offset & 15));
@@ -232,7 +390,9 @@ void esp_nn_conv_s8_esp32s3(const data_dims_t *input_dims,
         int8_t *input_padded = (int8_t *) input;
         int8_t *scratch_data = (int8_t *) scratch_buffer;
         int new_input_wd = input_wd, new_input_ht = input_ht;
-        if (filter_alignment_padding != 16) {
+        if (filter_packed) {
+            // rows are already zero padded to 16 bytes
+        } else if (filter_alignment_padding != 16) {
             // pad filter_data
             int32_t new_row_size = filter_wd * channels + filter_alignment_padding;
             filter_data_aligned = scratch_data;
@@ -267,3 +427,48 @@ void esp_nn_conv_s8_esp32s3(const data_dims_t *input_dims,
             out_shift, out_mult, activation_min, activation_max, scratch_data);
     }
 }
+
+void esp_nn_conv_s8_variant_esp32s3(esp_nn_variant_t variant,
+                                    const data_dims_t *input_dims,
+                                    const int8_t *input,
+                                    const data_dims_t *filter_dims,
+                                    const int8_t *filter_data,
+                                    const int32_t *bias,
+                                    const data_dims_t *output_dims,
+                                    int8_t *out_data,
+                                    const conv_params_t *conv_params,
+                                    const quant_data_t *quant_data)
+{
+    esp_nn_conv_s8_run_esp32s3(variant, input_dims, input, filter_dims, filter_data, false,
+                               bias, output_dims, out_data, conv_params, quant_data);
+}
+
+void esp_nn_conv_s8_packed_esp32s3(esp_nn_variant_t variant,
+                                   const data_dims_t *input_dims,
+                                   const int8_t *input,
+                                   const data_dims_t *filter_dims,
+                                   const int8_t *packed_filter,
+                                   const int32_t *bias,
+                                   const data_dims_t *output_dims,
+                                   int8_t *out_data,
+                                   const conv_params_t *conv_params,
+                                   const quant_data_t *quant_data)
+{
+    esp_nn_conv_s8_run_esp32s3(variant, input_dims, input, filter_dims, packed_filter, true,
+                               bias, output_dims, out_data, conv_params, quant_data);
+}
+
+void esp_nn_conv_s8_esp32s3(const data_dims_t *input_dims,
+                            const int8_t *input,
+                            const data_dims_t *filter_dims,
+                            const int8_t *filter_data,
+                            const int32_t *bias,
+                            const data_dims_t *output_dims,
+                            int8_t *out_data,
+                            const conv_params_t *conv_params,
+                            const quant_data_t *quant_data)
+{
+    esp_nn_conv_s8_variant_esp32s3(ESP_NN_VARIANT_DEFAULT, input_dims, input, filter_dims,
+                                   filter_data, bias, output_dims, out_data,
+                                   conv_params, quant_data);
+}
@@ -0,0 +1,141 @@
+// Copyright 2024 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <esp_nn_defs.h>
+
+#include <common_functions.h>
+
+__NN_FORCE_INLINE__ int32_t esp_nn_sparse_requantize(int32_t acc, const int32_t *bias,
+                                                     const int32_t ch,
+                                                     const int32_t mult, const int32_t shift,
+                                                     const int32_t out_offset,
+                                                     const int32_t activation_min,
+                                                     const int32_t activation_max)
+{
+    if (bias) {
+        acc += bias[ch];
+    }
+    acc = esp_nn_multiply_by_quantized_mult_fast(acc, mult, shift);
+    acc += out_offset;
+    acc = max(acc, activation_min);
+    return min(acc, activation_max);
+}
+
+/* 1x1, no padding: each output pixel is a sparse fully connected over channels */
+static void esp_nn_conv_sparse_1x1_s8(const data_dims_t *input_dims,
+                                      const int8_t *input_data,
+                                      const sparse_data_t *filter,
+                                      const int32_t *bias,
+                                      const data_dims_t *output_dims,
+                                      int8_t *out_data,
+                                      const conv_params_t *conv_params,
+                                      const quant_data_t *quant_data)
+{
+    const uint16_t input_wd = input_dims->width;
+    const uint16_t in_channels = input_dims->channels;
+    const uint16_t stride_wd = conv_params->stride.width;
+    const uint16_t stride_ht = conv_params->stride.height;
+    const uint16_t out_channels = output_dims->channels;
+    const int32_t block_len = filter->block_len;
+
+    for (int32_t out_y = 0; out_y < output_dims->height; out_y++) {
+        for (int32_t out_x = 0; out_x < output_dims->width; out_x++) {
+            const int8_t *in_pix = input_data +
+                    (out_y * stride_ht * input_wd + out_x * stride_wd) * in_channels;
+            const int8_t *filter_val = filter->values;
+            for (int32_t ch = 0; ch < out_channels; ch++) {
+                int32_t acc = 0, w_sum = 0;
+                const int32_t blk_end = filter->row_ptr[ch + 1];
+                for (int32_t blk = filter->row_ptr[ch]; blk < blk_end; blk++) {
+                    acc += esp_nn_sparse_block_dot(filter_val, in_pix + filter->col_idx[blk] * block_len,
+                                                   block_len, &w_sum);
+                    filter_val += block_len;
+                }
+                acc += w_sum * conv_params->in_offset;
+                *out_data++ = (int8_t) esp_nn_sparse_requantize(acc, bias, ch,
+                                                                quant_data->mult[ch],
+                                                                quant_data->shift[ch],
+                                                                conv_params->out_offset,
+                                                                conv_params->activation.min,
+                                                                conv_params->activation.max);
+            }
+        }
+    }
+}
+
+void esp_nn_conv_sparse_s8_opt(const data_dims_t *input_dims,
+                               const int8_t *input_data,
+                               const data_dims_t *filter_dims,
+                               const sparse_data_t *filter,
+                               const int32_t *bias,
+                               const data_dims_t *output_dims,
+                               int8_t *out_data,
+                               const conv_params_t *conv_params,
+                               const quant_data_t *quant_data)
+{
+    if (filter_dims->width == 1 && filter_dims->height == 1 &&
+            conv_params->padding.width == 0 && conv_params->padding.height == 0) {
+        esp_nn_conv_sparse_1x1_s8(input_dims, input_data, filter, bias,
+                                  output_dims, out_data, conv_params, quant_data);
+        return;
+    }
+
+    const uint16_t input_wd = input_dims->width;
+    const uint16_t input_ht = input_dims->height;
+    const uint16_t in_channels = input_dims->channels;
+    const uint16_t filter_wd = filter_dims->width;
+    const uint16_t filter_ht = filter_dims->height;
+    const uint16_t out_channels = output_dims->channels;
+    const int32_t block_len = filter->block_len;
+
+    for (int32_t out_y = 0; out_y < output_dims->height; out_y++) {
+        const int32_t base_y = conv_params->stride.height * out_y - conv_params->padding.height;
+        for (int32_t out_x = 0; out_x < output_dims->width; out_x++) {
+            const int32_t base_x = conv_params->stride.width * out_x - conv_params->padding.width;
+            /* interior pixels need no per block bounds check */
+            const bool inside = base_y >= 0 && base_x >= 0 &&
+                                base_y + filter_ht <= input_ht && base_x + filter_wd <= input_wd;
+            const int32_t in_base = (base_y * input_wd + base_x) * in_channels;
+            const int8_t *filter_val = filter->values;
+
+            for (int32_t ch = 0; ch < out_channels; ch++) {
+                int32_t acc = 0, w_sum = 0;
+                const int32_t blk_end = filter->row_ptr[ch + 1];
+                for (int32_t blk = filter->row_ptr[ch]; blk < blk_end; blk++, filter_val += block_len) {
+                    const int32_t pos = filter->col_idx[blk] * block_len;
+                    const int32_t tap = pos / in_channels;
+                    const int32_t in_ch_idx = pos - tap * in_channels;
+                    const int32_t filter_y = tap / filter_wd;
+                    const int32_t filter_x = tap - filter_y * filter_wd;
+                    if (!inside) {
+                        const int32_t in_row = base_y + filter_y;
+                        const int32_t in_col = base_x + filter_x;
+                        if (in_row < 0 || in_row >= input_ht || in_col < 0 || in_col >= input_wd) {
+                            continue;
+                        }
+                    }
+                    const int8_t *in_val = input_data + in_base + (filter_y * input_wd + filter_x) * in_channels + in_ch_idx;
+                    acc += esp_nn_sparse_block_dot(filter_val, in_val, block_len, &w_sum);
+                }
+                acc += w_sum * conv_params->in_offset;
+                *out_data++ = (int8_t) esp_nn_sparse_requantize(acc, bias, ch,
+                                                                quant_data->mult[ch],
+                                                                quant_data->shift[ch],
+                                                                conv_params->out_offset,
+                                                                conv_params->activation.min,
+                                                                conv_params->activation.max);
+            }
+        }
+    }
+}
@@ -14,6 +14,7 @@
 
 #include <esp_nn_defs.h>
 #include <common_functions.h>
+#include <esp_nn_ansi_headers.h>
 
 int esp_nn_get_depthwise_conv_scratch_size_opt(const data_dims_t *input_dims,
                                                const data_dims_t *filter_dims,
@@ -289,3 +290,79 @@ void esp_nn_depthwise_conv_s8_opt(const data_dims_t *input_dims,
         }
     }
 }
+
+/**
+ * Each output is a sum of at most filter_ht * filter_wd products below 2^22,
+ * so for filters up to 256 taps the taps accumulate in 32 bit and only the
+ * bias add and requantization go through 64 bit.
+ */
+void esp_nn_depthwise_conv_s16_opt(const data_dims_t *input_dims,
+                                   const int16_t *input_data,
+                                   const data_dims_t *filter_dims,
+                                   const int8_t *filter_data,
+                                   const int64_t *bias,
+                                   const data_dims_t *output_dims,
+                                   int16_t *out_data,
+                                   const dw_conv_params_t *conv_params,
+                                   const quant_data_t *quant_data)
+{
+    const uint16_t filter_wd = filter_dims->width;
+    const uint16_t filter_ht = filter_dims->height;
+
+    if (filter_wd * filter_ht > 256) {
+        esp_nn_depthwise_conv_s16_ansi(input_dims, input_data, filter_dims, filter_data, bias,
+                                       output_dims, out_data, conv_params, quant_data);
+        return;
+    }
+
+    const uint16_t input_wd = input_dims->width;
+    const uint16_t input_ht = input_dims->height;
+    const uint16_t channels = input_dims->channels;
+    const uint16_t pad_wd = conv_params->padding.width;
+    const uint16_t pad_ht = conv_params->padding.height;
+    const uint16_t stride_wd = conv_params->stride.width;
+    const uint16_t stride_ht = conv_params->stride.height;
+    const uint16_t out_wd = output_dims->width;
+    const uint16_t out_ht = output_dims->height;
+    const int32_t activation_min = conv_params->activation.min;
+    const int32_t activation_max = conv_params->activation.max;
+    const uint16_t ch_mult = conv_params->ch_mult;
+    const int32_t out_channels = channels * ch_mult;
+
+    for (int32_t out_y = 0; out_y < out_ht; out_y++) {
+        const int32_t base_y = (out_y * stride_ht) - pad_ht;
+        const int32_t filter_y_start = max(0, -base_y);
+        const int32_t filter_y_end = min(filter_ht, input_ht - base_y);
+        for (int32_t out_x = 0; out_x < out_wd; out_x++) {
+            const int32_t base_x = (out_x * stride_wd) - pad_wd;
+            const int32_t filter_x_start = max(0, -base_x);
+            const int32_t filter_x_end = min(filter_wd, input_wd - base_x);
+            const int32_t *out_shift = quant_data->shift;
+            const int32_t *out_mult = quant_data->mult;
+
+            for (int32_t ch_idx = 0; ch_idx < channels; ch_idx++) {
+                for (int32_t ch_mult_idx = 0; ch_mult_idx < ch_mult; ch_mult_idx++) {
+                    const int32_t out_ch_idx = ch_idx * ch_mult + ch_mult_idx;
+                    int32_t acc = 0;
+                    for (int32_t filter_y_idx = filter_y_start; filter_y_idx < filter_y_end; filter_y_idx++) {
+                        const int16_t *input_ptr = input_data +
+                                        ((base_y + filter_y_idx) * input_wd + base_x) * channels + ch_idx;
+                        const int8_t *filter_ptr = filter_data +
+                                        filter_y_idx * filter_wd * out_channels + out_ch_idx;
+                        for (int32_t filter_x_idx = filter_x_start; filter_x_idx < filter_x_end; filter_x_idx++) {
+                            acc += input_ptr[filter_x_idx * channels] * filter_ptr[filter_x_idx * out_channels];
+                        }
+                    }
+                    int64_t acc_64 = acc;
+                    if (bias) {
+                        acc_64 += bias[out_ch_idx];
+                    }
+                    int32_t result = esp_nn_multiply_by_quantized_mult_s64(acc_64, *out_mult++, *out_shift++);
+                    result = max(result, activation_min);
+                    result = min(result, activation_max);
+                    *out_data++ = (int16_t) result;
+                }
+            }
+        }
+    }
+}
@@ -353,10 +353,81 @@ void esp_nn_depthwise_conv_s8_ch_mult1(const int8_t *input_data,
     }
 }
 
-int esp_nn_get_depthwise_conv_scratch_size_esp32s3(const data_dims_t *input_dims,
-                                                   const data_dims_t *filter_dims,
-                                                   const data_dims_t *output_dims,
-                                                   const dw_conv_params_t *conv_params)
+static esp_nn_variant_t esp_nn_depthwise_conv_s8_default_variant(const data_dims_t *input_dims,
+                                                                 const data_dims_t *filter_dims,
+                                                                 const dw_conv_params_t *conv_params)
+{
+    const uint16_t channels = input_dims->channels;
+    const uint16_t filter_wd = filter_dims->width;
+    const uint16_t filter_ht = filter_dims->height;
+    const uint16_t ch_mult = conv_params->ch_mult;
+    const uint16_t pad_wd = conv_params->padding.width;
+    const uint16_t pad_ht = conv_params->padding.height;
+
+    if ((ch_mult == 1) && (channels % 8 == 0)) {
+        if ((filter_wd == 3) && (filter_ht == 3)) {
+            if ((channels % 16 == 0) && (pad_wd == pad_ht) && (pad_wd <= 1)) {
+                return ESP_NN_VARIANT_S3_DW_MULT1_3X3_PADDED;
+            }
+            return ESP_NN_VARIANT_S3_DW_MULT1_3X3;
+        }
+        return ESP_NN_VARIANT_S3_DW_MULT1;
+    } else if (ch_mult % 8 == 0) {
+        if (filter_wd == 3 && filter_ht == 3) {
+            return ESP_NN_VARIANT_S3_DW_MULT8_3X3;
+        }
+        return ESP_NN_VARIANT_S3_DW_MULT8;
+    } else if (ch_mult % 4 == 0) {
+        return ESP_NN_VARIANT_S3_DW_MULT4;
+    }
+    return ESP_NN_VARIANT_S3_DW_GENERIC;
+}
+
+int esp_nn_depthwise_conv_s8_variants_esp32s3(const data_dims_t *input_dims,
+                                              const data_dims_t *filter_dims,
+                                              const data_dims_t *output_dims,
+                                              const dw_conv_params_t *conv_params,
+                                              esp_nn_variant_t *variants,
+                                              const int max_variants)
+{
+    const uint16_t channels = input_dims->channels;
+    const uint16_t ch_mult = conv_params->ch_mult;
+    const uint16_t pad_wd = conv_params->padding.width;
+    const uint16_t pad_ht = conv_params->padding.height;
+    const bool is_3x3 = filter_dims->width == 3 && filter_dims->height == 3;
+
+    esp_nn_variant_t eligible[7];
+    int count = 0;
+    if (ch_mult == 1) {
+        if (is_3x3 && (channels % 16 == 0) && (pad_wd == pad_ht) && (pad_wd <= 1)) {
+            eligible[count++] = ESP_NN_VARIANT_S3_DW_MULT1_3X3_PADDED;
+        }
+        if (is_3x3 && (channels % 8 == 0)) {
+            eligible[count++] = ESP_NN_VARIANT_S3_DW_MULT1_3X3;
+        }
+        eligible[count++] = ESP_NN_VARIANT_S3_DW_MULT1;
+    }
+    if (ch_mult % 8 == 0) {
+        if (is_3x3) {
+            eligible[count++] = ESP_NN_VARIANT_S3_DW_MULT8_3X3;
+        }
+        eligible[count++] = ESP_NN_VARIANT_S3_DW_MULT8;
+    }
+    if (ch_mult % 4 == 0) {
+        eligible[count++] = ESP_NN_VARIANT_S3_DW_MULT4;
+    }
+    eligible[count++] = ESP_NN_VARIANT_S3_DW_GENERIC;
+
+    count = min(count, max_variants);
+    memcpy(variants, eligible, count * sizeof(esp_nn_variant_t));
+    return count;
+}
+
+int esp_nn_get_depthwise_conv_scratch_size_variant_esp32s3(esp_nn_variant_t variant,
+                                                           const data_dims_t *input_dims,
+                                                           const data_dims_t *filter_dims,
+                                                           const data_dims_t *output_dims,
+                                                           const dw_conv_params_t *conv_params)
 {
     const uint16_t input_wd = input_dims->width;
     const uint16_t input_ht = input_dims->height;
@@ -372,40 +443,116 @@ int esp_nn_get_depthwise_conv_scratch_size_esp32s3(const data_dims_t *input_dims
     const uint16_t stride_ht = conv_params->stride.height;
 
     int filter_size = filter_wd * filter_ht * channels * ch_mult;
+    int input_size = input_wd * input_ht * channels;
     int pad_width = 0, pad_height = 0;
 
-    if ((ch_mult == 1) && (channels % 8 == 0) && (filter_wd == 3) && (filter_ht == 3)) {
-        if (channels % 16 == 0) {
-            if (pad_wd || pad_ht) {
-                pad_width = pad_wd * 2;
-                pad_height = pad_ht * 2;
-            } else {
-                // check if we need to pad additionally
-                pad_width = (out_wd * stride_wd + filter_wd - 1) - input_wd;
-                pad_height = (out_ht * stride_ht + filter_ht - 1) - input_ht;
-                // printf("in(%d %d %d), out(%d %d), filter (%d %d) stride (%d %d), pad (%d %d)",
-                //         input_wd, input_ht, channels, out_wd, out_ht, filter_wd, filter_ht,
-                //         stride_wd, stride_ht, pad_wd, pad_ht);
-            }
-            if (pad_width || pad_height) {
-                int input_size = (input_wd + pad_width) * (input_ht + pad_height) * channels;
-                // printf("ask1 %d\n", filter_size + input_size + 16);
-                return filter_size + input_size + 16;  // 16 for alignment
-            } else {
-                // printf("ask2 %d\n", filter_size + 16);
-                return filter_size + 16;  // 16 for alignment
-            }
+    if (variant == ESP_NN_VARIANT_DEFAULT) {
+        variant = esp_nn_depthwise_conv_s8_default_variant(input_dims, filter_dims, conv_params);
+    }
+
+    switch (variant) {
+    case ESP_NN_VARIANT_S3_DW_MULT1_3X3_PADDED:
+        if (pad_wd || pad_ht) {
+            pad_width = pad_wd * 2;
+            pad_height = pad_ht * 2;
         } else {
-            int input_size = input_wd * input_ht * channels;
-            // printf("ask3 %d\n", 2 * (filter_size + input_size) + 16);
-            return  2 * (filter_size + input_size) + 16; // 16 for alignment
+            // check if we need to pad additionally
+            pad_width = (out_wd * stride_wd + filter_wd - 1) - input_wd;
+            pad_height = (out_ht * stride_ht + filter_ht - 1) - input_ht;
         }
-    } else if (ch_mult % 4 == 0) {
-        int input_size = input_wd * input_ht * channels;
-        // printf("ask4 %d\n", 2 * (filter_size + input_size) + 16);
-        return  2 * (filter_size + input_size) + 16; // 16 for alignment
+        if (pad_width || pad_height) {
+            input_size = (input_wd + pad_width) * (input_ht + pad_height) * channels;
+            return filter_size + input_size + 16;  // 16 for alignment
+        }
+        return filter_size + 16;  // 16 for alignment
+    case ESP_NN_VARIANT_S3_DW_MULT1_3X3:
+    case ESP_NN_VARIANT_S3_DW_MULT8_3X3:
+    case ESP_NN_VARIANT_S3_DW_MULT8:
+    case ESP_NN_VARIANT_S3_DW_MULT4:
+        /* filter and input widened to s16 */
+        return 2 * (filter_size + input_size) + 16; // 16 for alignment
+    default:
+        return 32; // just few bytes
+    }
+}
+
+/* s16 kernels take the filter widened to int16, the padded s8 one an aligned copy */
+static bool esp_nn_depthwise_conv_s8_variant_is_s16(esp_nn_variant_t variant)
+{
+    return variant == ESP_NN_VARIANT_S3_DW_MULT1_3X3 || variant == ESP_NN_VARIANT_S3_DW_MULT8_3X3 ||
+           variant == ESP_NN_VARIANT_S3_DW_MULT8 || variant == ESP_NN_VARIANT_S3_DW_MULT4;
+}
+
+int esp_nn_get_depthwise_conv_packed_filter_size_esp32s3(esp_nn_variant_t variant,
+                                                         const data_dims_t *input_dims,
+                                                         const data_dims_t *filter_dims,
+                                                         const data_dims_t *output_dims,
+                                                         const dw_conv_params_t *conv_params)
+{
+    const int filter_size = filter_dims->width * filter_dims->height *
+                            input_dims->channels * conv_params->ch_mult;
+
+    if (variant == ESP_NN_VARIANT_DEFAULT) {
+        variant = esp_nn_depthwise_conv_s8_default_variant(input_dims, filter_dims, conv_params);
+    }
+    if (variant == ESP_NN_VARIANT_S3_DW_MULT1_3X3_PADDED) {
+        return filter_size;
+    } else if (esp_nn_depthwise_conv_s8_variant_is_s16(variant)) {
+        return filter_size * sizeof(int16_t);
+    }
+    return 0;
+}
+
+void esp_nn_depthwise_conv_pack_filter_esp32s3(esp_nn_variant_t variant,
+                                               const data_dims_t *input_dims,
+                                               const data_dims_t *filter_dims,
+                                               const data_dims_t *output_dims,
+                                               const dw_conv_params_t *conv_params,
+                                               const int8_t *filter_data,
+                                               void *packed_filter)
+{
+    const int filter_size = filter_dims->width * filter_dims->height *
+                            input_dims->channels * conv_params->ch_mult;
+
+    if (variant == ESP_NN_VARIANT_DEFAULT) {
+        variant = esp_nn_depthwise_conv_s8_default_variant(input_dims, filter_dims, conv_params);
+    }
+    if (variant == ESP_NN_VARIANT_S3_DW_MULT1_3X3_PADDED) {
+        memcpy(packed_filter, filter_data, filter_size);
+    } else if (esp_nn_depthwise_conv_s8_variant_is_s16(variant)) {
+        esp_nn_s8_to_s16_esp32s3(filter_data, (int16_t *) packed_filter, filter_size);
+    }
+}
+
+int esp_nn_get_depthwise_conv_packed_scratch_size_esp32s3(esp_nn_variant_t variant,
+                                                          const data_dims_t *input_dims,
+                                                          const data_dims_t *filter_dims,
+                                                          const data_dims_t *output_dims,
+                                                          const dw_conv_params_t *conv_params)
+{
+    const int filter_size = filter_dims->width * filter_dims->height *
+                            input_dims->channels * conv_params->ch_mult;
+    const int scratch_size = esp_nn_get_depthwise_conv_scratch_size_variant_esp32s3(
+                                variant, input_dims, filter_dims, output_dims, conv_params);
+
+    if (variant == ESP_NN_VARIANT_DEFAULT) {
+        variant = esp_nn_depthwise_conv_s8_default_variant(input_dims, filter_dims, conv_params);
+    }
+    if (variant == ESP_NN_VARIANT_S3_DW_MULT1_3X3_PADDED) {
+        return scratch_size - filter_size;
+    } else if (esp_nn_depthwise_conv_s8_variant_is_s16(variant)) {
+        return scratch_size - 2 * filter_size;
     }
-    return 32; // just few bytes
+    return scratch_size;
+}
+
+int esp_nn_get_depthwise_conv_scratch_size_esp32s3(const data_dims_t *input_dims,
+                                                   const data_dims_t *filter_dims,
+                                                   const data_dims_t *output_dims,
+                                                   const dw_conv_params_t *conv_params)
+{
+    return esp_nn_get_depthwise_conv_scratch_size_variant_esp32s3(ESP_NN_VARIANT_DEFAULT, input_dims,
+                                                                  filter_dims, output_dims, conv_params);
 }
 
 void esp_nn_set_depthwise_conv_scratch_buf_esp32s3(void *buf)
@@ -421,15 +568,18 @@ void esp_nn_set_depthwise_conv_scratch_buf_esp32s3(void *buf)
 
 
 
-void esp_nn_depthwise_conv_s8_esp32s3(const data_dims_t *input_dims,
-                                      const int8_t *input_data,
-                                      const data_dims_t *filter_dims,
-                                      const int8_t *filter_data,
-                                      const int32_t *bias,
-                                      const data_dims_t *output_dims,
-                                      int8_t *out_data,
-                                      const dw_conv_params_t *conv_params,
-                                      const quant_data_t *quant_data)
+/* `filter_packed`: filter_data is the output of esp_nn_depthwise_conv_pack_filter_esp32s3 */
+static void esp_nn_depthwise_conv_s8_run_esp32s3(esp_nn_variant_t variant,
+                                                 const data_dims_t *input_dims,
+                                                 const int8_t *input_data,
+                                                 const data_dims_t *filter_dims,
+                                                 const int8_t *filter_data,
+                                                 const bool filter_packed,
+                                                 const int32_t *bias,
+                                                 const data_dims_t *output_dims,
+                                                 int8_t *out_data,
+                                                 const dw_conv_params_t *conv_params,
+                                                 const quant_data_t *quant_data)
 {
     const uint16_t input_wd = input_dims->width;
     const uint16_t input_ht = input_dims->height;
@@ -453,91 +603,161 @@ void esp_nn_depthwise_conv_s8_esp32s3(const data_dims_t *input_dims,
     int filter_size = filter_wd * filter_ht * channels * ch_mult;
     int align_len = 16 - (filter_size & 15);
     int input_size = input_wd * input_ht * channels;
-    int16_t *filter_data16 = scratch_buffer;
-    int16_t *input_data16 = scratch_buffer + filter_size + align_len;
+    /* packed filter is already aligned, and widened to s16 for the s16 kernels */
+    int filter_scratch = filter_packed ? 0 : filter_size + align_len;
+    int16_t *filter_data16 = filter_packed ? (int16_t *) filter_data : scratch_buffer;
+    int16_t *input_data16 = scratch_buffer + filter_scratch;
     if (scratch_buffer == NULL) {
         printf("esp_nn_depthwise_conv error! scratch_buffer not set!\n");
         return;
     }
 
-    if ((ch_mult == 1) && (channels % 8 == 0)) {
-        if ((filter_wd == 3) && (filter_ht == 3)) {
-            if ((channels % 16 == 0) && (pad_wd == 1) && (pad_ht == 1)) {
-                /* process in 8 bits */
-                int8_t *filter_aligned = (int8_t *) scratch_buffer;
-                int8_t *input_padded = (int8_t *) scratch_buffer + filter_size + align_len;
+    if (variant == ESP_NN_VARIANT_DEFAULT) {
+        variant = esp_nn_depthwise_conv_s8_default_variant(input_dims, filter_dims, conv_params);
+    }
+
+    switch (variant) {
+    case ESP_NN_VARIANT_S3_DW_MULT1_3X3_PADDED:
+        if ((pad_wd == 1) && (pad_ht == 1)) {
+            /* process in 8 bits */
+            int8_t *filter_aligned = filter_packed ? (int8_t *) filter_data : (int8_t *) scratch_buffer;
+            int8_t *input_padded = (int8_t *) scratch_buffer + filter_scratch;
+            if (!filter_packed) {
                 memcpy(filter_aligned, filter_data, filter_size);
-                esp_nn_aligned_s8_pad_with_value(input_data, input_padded, input_wd, input_ht, channels,
-                                                 -input_offset, pad_wd, pad_ht);
-                esp_nn_depthwise_conv_s8_mult1_3x3_padded_esp32s3(input_padded, input_wd + 2 * pad_wd,
-                                                                  input_ht + 2 * pad_ht, channels, input_offset,
-                                                                  stride_wd, stride_ht, filter_aligned, bias,
-                                                                  out_data, out_wd, out_ht, out_offset, out_shift,
-                                                                  out_mult, activation_min, activation_max);
-            } else if ((channels % 16 == 0) && (pad_wd == 0) && (pad_ht == 0)) {
-                /* process in 8 bits */
-                int8_t *filter_aligned = (int8_t *) scratch_buffer;
-                int8_t *input_padded = (int8_t *) scratch_buffer + filter_size + align_len;
-
-                // check if we need to pad additionally
-                int pad_right = (out_wd * stride_wd + filter_wd - 1) - input_wd;
-                int pad_bottom = (out_ht * stride_ht + filter_ht - 1) - input_ht;
-                if (pad_right || pad_bottom) { // pad right and bottom
-                    esp_nn_aligned_s8_pad_end_with_value(input_data, input_padded, input_wd, input_ht,
-                                                         channels, -input_offset, pad_right, pad_bottom);
-                } else {
-                    input_padded = (int8_t *) input_data;
-                }
+            }
+            esp_nn_aligned_s8_pad_with_value(input_data, input_padded, input_wd, input_ht, channels,
+                                             -input_offset, pad_wd, pad_ht);
+            esp_nn_depthwise_conv_s8_mult1_3x3_padded_esp32s3(input_padded, input_wd + 2 * pad_wd,
+                                                              input_ht + 2 * pad_ht, channels, input_offset,
+                                                              stride_wd, stride_ht, filter_aligned, bias,
+                                                              out_data, out_wd, out_ht, out_offset, out_shift,
+                                                              out_mult, activation_min, activation_max);
+        } else { /* pad_wd == 0 && pad_ht == 0 */
+            /* process in 8 bits */
+            int8_t *filter_aligned = filter_packed ? (int8_t *) filter_data : (int8_t *) scratch_buffer;
+            int8_t *input_padded = (int8_t *) scratch_buffer + filter_scratch;
+
+            // check if we need to pad additionally
+            int pad_right = (out_wd * stride_wd + filter_wd - 1) - input_wd;
+            int pad_bottom = (out_ht * stride_ht + filter_ht - 1) - input_ht;
+            if (pad_right || pad_bottom) { // pad right and bottom
+                esp_nn_aligned_s8_pad_end_with_value(input_data, input_padded, input_wd, input_ht,
+                                                     channels, -input_offset, pad_right, pad_bottom);
+            } else {
+                input_padded = (int8_t *) input_data;
+            }
+            if (!filter_packed) {
                 memcpy(filter_aligned, filter_data, filter_size);
-                esp_nn_depthwise_conv_s8_mult1_3x3_padded_esp32s3(input_padded, input_wd + pad_right,
-                                                                  input_ht + pad_bottom, channels, input_offset,
-                                                                  stride_wd, stride_ht, filter_aligned, bias,
-                                                                  out_data, out_wd, out_ht, out_offset, out_shift,
-                                                                  out_mult, activation_min, activation_max);
-            } else { /* (channels % 8) == 0 */
-                esp_nn_s8_to_s16_esp32s3(filter_data, filter_data16, filter_size);
-                esp_nn_aligned_s8_to_s16_with_offset_esp32s3(input_data, input_data16, input_size, input_offset);
-                esp_nn_depthwise_conv_s16_mult1_3x3_esp32s3(input_data16, input_wd, input_ht, channels,
-                                                            pad_wd, pad_ht, stride_wd, stride_ht, filter_data16,
-                                                            bias, out_data, out_wd, out_ht, out_offset, out_shift,
-                                                            out_mult, activation_min, activation_max);
             }
-        } else { // all other ch_mult == 1, `channels % 8 == 0`
-            esp_nn_depthwise_conv_s8_ch_mult1(input_data, input_wd, input_ht, channels, input_offset,
-                                              pad_wd, pad_ht, stride_wd, stride_ht,
-                                              filter_data, filter_wd, filter_ht,
-                                              bias, out_data, out_wd, out_ht, out_offset, out_shift,
-                                              out_mult, activation_min, activation_max);
+            esp_nn_depthwise_conv_s8_mult1_3x3_padded_esp32s3(input_padded, input_wd + pad_right,
+                                                              input_ht + pad_bottom, channels, input_offset,
+                                                              stride_wd, stride_ht, filter_aligned, bias,
+                                                              out_data, out_wd, out_ht, out_offset, out_shift,
+                                                              out_mult, activation_min, activation_max);
+        }
+        break;
+    case ESP_NN_VARIANT_S3_DW_MULT1_3X3: /* (channels % 8) == 0 */
+        if (!filter_packed) {
+            esp_nn_s8_to_s16_esp32s3(filter_data, filter_data16, filter_size);
         }
-    } else if (ch_mult % 8 == 0) {
-        esp_nn_s8_to_s16_esp32s3(filter_data, filter_data16, filter_size);
         esp_nn_aligned_s8_to_s16_with_offset_esp32s3(input_data, input_data16, input_size, input_offset);
-        if (filter_wd == 3 && filter_ht == 3) {
-            esp_nn_depthwise_conv_s16_mult8_3x3_esp32s3(input_data16, input_wd, input_ht, channels,
-                                                        pad_wd, pad_ht, stride_wd, stride_ht, ch_mult,
-                                                        filter_data16, bias,
-                                                        out_data, out_wd, out_ht, out_offset, out_shift,
-                                                        out_mult, activation_min, activation_max);
-        } else {
-            esp_nn_depthwise_conv_s16_mult8_esp32s3(input_data16, input_wd, input_ht, channels,
+        esp_nn_depthwise_conv_s16_mult1_3x3_esp32s3(input_data16, input_wd, input_ht, channels,
+                                                    pad_wd, pad_ht, stride_wd, stride_ht, filter_data16,
+                                                    bias, out_data, out_wd, out_ht, out_offset, out_shift,
+                                                    out_mult, activation_min, activation_max);
+        break;
+    case ESP_NN_VARIANT_S3_DW_MULT1:
+        esp_nn_depthwise_conv_s8_ch_mult1(input_data, input_wd, input_ht, channels, input_offset,
+                                          pad_wd, pad_ht, stride_wd, stride_ht,
+                                          filter_data, filter_wd, filter_ht,
+                                          bias, out_data, out_wd, out_ht, out_offset, out_shift,
+                                          out_mult, activation_min, activation_max);
+        break;
+    case ESP_NN_VARIANT_S3_DW_MULT8_3X3:
+        if (!filter_packed) {
+            esp_nn_s8_to_s16_esp32s3(filter_data, filter_data16, filter_size);
+        }
+        esp_nn_aligned_s8_to_s16_with_offset_esp32s3(input_data, input_data16, input_size, input_offset);
+        esp_nn_depthwise_conv_s16_mult8_3x3_esp32s3(input_data16, input_wd, input_ht, channels,
                                                     pad_wd, pad_ht, stride_wd, stride_ht, ch_mult,
-                                                    filter_data16, filter_wd, filter_ht, bias,
+                                                    filter_data16, bias,
                                                     out_data, out_wd, out_ht, out_offset, out_shift,
                                                     out_mult, activation_min, activation_max);
+        break;
+    case ESP_NN_VARIANT_S3_DW_MULT8:
+        if (!filter_packed) {
+            esp_nn_s8_to_s16_esp32s3(filter_data, filter_data16, filter_size);
+        }
+        esp_nn_aligned_s8_to_s16_with_offset_esp32s3(input_data, input_data16, input_size, input_offset);
+        esp_nn_depthwise_conv_s16_mult8_esp32s3(input_data16, input_wd, input_ht, channels,
+                                                pad_wd, pad_ht, stride_wd, stride_ht, ch_mult,
+                                                filter_data16, filter_wd, filter_ht, bias,
+                                                out_data, out_wd, out_ht, out_offset, out_shift,
+                                                out_mult, activation_min, activation_max);
+        break;
+    case ESP_NN_VARIANT_S3_DW_MULT4:
+        if (!filter_packed) {
+            esp_nn_s8_to_s16_esp32s3(filter_data, filter_data16, filter_size);
         }
-    } else if (ch_mult % 4 == 0) {
-        esp_nn_s8_to_s16_esp32s3(filter_data, filter_data16, filter_size);
         esp_nn_aligned_s8_to_s16_with_offset_esp32s3(input_data, input_data16, input_size, input_offset);
         esp_nn_depthwise_conv_s16_mult4_esp32s3(input_data16, input_wd, input_ht, channels,
                                                 pad_wd, pad_ht, stride_wd, stride_ht, ch_mult,
                                                 filter_data16, filter_wd, filter_ht, bias,
                                                 out_data, out_wd, out_ht, out_offset, out_shift,
                                                 out_mult, activation_min, activation_max);
-    } else {
+        break;
+    default:
         esp_nn_depthwise_conv_s8_unrolled(input_data, input_wd, input_ht, channels, input_offset,
                                           pad_wd, pad_ht, stride_wd, stride_ht, ch_mult,
                                           filter_data, filter_wd, filter_ht,
                                           bias, out_data, out_wd, out_ht, out_offset, out_shift,
                                           out_mult, activation_min, activation_max);
+        break;
     }
 }
+
+void esp_nn_depthwise_conv_s8_variant_esp32s3(esp_nn_variant_t variant,
+                                              const data_dims_t *input_dims,
+                                              const int8_t *input_data,
+                                              const data_dims_t *filter_dims,
+                                              const int8_t *filter_data,
+                                              const int32_t *bias,
+                                              const data_dims_t *output_dims,
+                                              int8_t *out_data,
+                                              const dw_conv_params_t *conv_params,
+                                              const quant_data_t *quant_data)
+{
+    esp_nn_depthwise_conv_s8_run_esp32s3(variant, input_dims, input_data, filter_dims, filter_data,
+                                         false, bias, output_dims, out_data, conv_params, quant_data);
+}
+
+void esp_nn_depthwise_conv_s8_packed_esp32s3(esp_nn_variant_t variant,
+                                             const data_dims_t *input_dims,
+                                             const int8_t *input_data,
+                                             const data_dims_t *filter_dims,
+                                             const void *packed_filter,
+                                             const int32_t *bias,
+                                             const data_dims_t *output_dims,
+                                             int8_t *out_data,
+                                             const dw_conv_params_t *conv_params,
+                                             const quant_data_t *quant_data)
+{
+    esp_nn_depthwise_conv_s8_run_esp32s3(variant, input_dims, input_data, filter_dims,
+                                         (const int8_t *) packed_filter, true, bias,
+                                         output_dims, out_data, conv_params, quant_data);
+}
+
+void esp_nn_depthwise_conv_s8_esp32s3(const data_dims_t *input_dims,
+                                      const int8_t *input_data,
+                                      const data_dims_t *filter_dims,
+                                      const int8_t *filter_data,
+                                      const int32_t *bias,
+                                      const data_dims_t *output_dims,
+                                      int8_t *out_data,
+                                      const dw_conv_params_t *conv_params,
+                                      const quant_data_t *quant_data)
+{
+    esp_nn_depthwise_conv_s8_variant_esp32s3(ESP_NN_VARIANT_DEFAULT, input_dims, input_data,
+                                             filter_dims, filter_data, bias, output_dims,
+                                             out_data, conv_params, quant_data);
+}
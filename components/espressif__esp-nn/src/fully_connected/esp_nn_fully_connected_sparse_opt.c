@@ -0,0 +1,56 @@
+// Copyright 2024 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdint.h>
+
+#include <esp_nn_defs.h>
+#include <common_functions.h>
+
+void esp_nn_fully_connected_sparse_s8_opt(const int8_t *input_data,
+                                          const int32_t input_offset,
+                                          const uint16_t row_len,
+                                          const sparse_data_t *filter,
+                                          const int32_t *bias,
+                                          int8_t *out_data,
+                                          const uint16_t out_channels,
+                                          const int32_t out_offset,
+                                          const int32_t out_shift,
+                                          const int32_t out_mult,
+                                          const int32_t activation_min,
+                                          const int32_t activation_max)
+{
+    const int32_t block_len = filter->block_len;
+    const int8_t *filter_val = filter->values;
+    const uint16_t *col_idx = filter->col_idx;
+    (void) row_len;
+
+    for (int32_t out_c = 0; out_c < out_channels; ++out_c) {
+        int32_t result = 0, w_sum = 0;
+        const int32_t blk_end = filter->row_ptr[out_c + 1];
+        for (int32_t blk = filter->row_ptr[out_c]; blk < blk_end; blk++) {
+            const int8_t *input_val = input_data + col_idx[blk] * block_len;
+            result += esp_nn_sparse_block_dot(filter_val, input_val, block_len, &w_sum);
+            filter_val += block_len;
+        }
+        result += w_sum * input_offset;
+        if (bias) {
+            result += bias[out_c];
+        }
+        result = esp_nn_multiply_by_quantized_mult(result, out_mult, out_shift);
+        result += out_offset;
+        result = max(result, activation_min);
+        result = min(result, activation_max);
+        out_data[out_c] = (int8_t) result;
+    }
+}
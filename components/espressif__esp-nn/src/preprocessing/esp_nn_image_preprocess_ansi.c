@@ -0,0 +1,103 @@
+// Copyright 2024 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdint.h>
+
+#include "image_preprocess_common.h"
+
+static inline int32_t pixel_luma(const uint8_t *input,
+                                 const int32_t stride,
+                                 const esp_nn_pixel_format_t format,
+                                 const int32_t x,
+                                 const int32_t y)
+{
+    const uint8_t *row = input + y * stride;
+    switch (format) {
+    case ESP_NN_PIXEL_RGB565:
+        return esp_nn_565_luma(row[2 * x], row[2 * x + 1], LUMA_R, LUMA_B);
+    case ESP_NN_PIXEL_BGR565:
+        return esp_nn_565_luma(row[2 * x], row[2 * x + 1], LUMA_B, LUMA_R);
+    case ESP_NN_PIXEL_YUV422:
+        return row[2 * x];
+    default:
+        return row[x];
+    }
+}
+
+int32_t esp_nn_get_preprocess_image_scratch_size_ansi(const data_dims_t *input_dims,
+                                                      const data_dims_t *output_dims,
+                                                      const image_preprocess_params_t *params)
+{
+    (void) input_dims;
+    (void) output_dims;
+    (void) params;
+    return 0;
+}
+
+void esp_nn_set_preprocess_image_scratch_buf_ansi(void *buffer)
+{
+    (void) buffer;
+}
+
+void esp_nn_preprocess_image_s8_ansi(const uint8_t *input,
+                                     const data_dims_t *input_dims,
+                                     const image_preprocess_params_t *params,
+                                     int8_t *output,
+                                     const data_dims_t *output_dims)
+{
+    const crop_rect_t crop = esp_nn_preprocess_crop(input_dims, params);
+    const esp_nn_pixel_format_t format = params->format;
+    const int32_t stride = input_dims->width * esp_nn_preprocess_bpp(format);
+    const uint8_t *base = input + crop.y * stride + crop.x * esp_nn_preprocess_bpp(format);
+    const int32_t out_wd = output_dims->width;
+    const int32_t out_ht = output_dims->height;
+    const int32_t step_x = esp_nn_preprocess_step(crop.width, out_wd);
+    const int32_t step_y = esp_nn_preprocess_step(crop.height, out_ht);
+
+    for (int32_t out_y = 0; out_y < out_ht; out_y++) {
+        for (int32_t out_x = 0; out_x < out_wd; out_x++) {
+            int32_t luma;
+            if (params->resize == ESP_NN_RESIZE_BILINEAR) {
+                int32_t pos_x = esp_nn_preprocess_bilinear(out_x, step_x, crop.width);
+                int32_t pos_y = esp_nn_preprocess_bilinear(out_y, step_y, crop.height);
+                int32_t x0 = pos_x >> 16, fx = (pos_x >> 8) & 0xff;
+                int32_t y0 = pos_y >> 16, fy = (pos_y >> 8) & 0xff;
+                int32_t x1 = min(x0 + 1, crop.width - 1);
+                int32_t y1 = min(y0 + 1, crop.height - 1);
+                int32_t top = pixel_luma(base, stride, format, x0, y0) * (BILINEAR_ONE - fx) +
+                              pixel_luma(base, stride, format, x1, y0) * fx;
+                int32_t bottom = pixel_luma(base, stride, format, x0, y1) * (BILINEAR_ONE - fx) +
+                                 pixel_luma(base, stride, format, x1, y1) * fx;
+                luma = (top * (BILINEAR_ONE - fy) + bottom * fy + (1 << 15)) >> 16;
+            } else if (params->resize == ESP_NN_RESIZE_AREA) {
+                int32_t x_start, x_end, y_start, y_end;
+                esp_nn_preprocess_area(out_x, crop.width, out_wd, &x_start, &x_end);
+                esp_nn_preprocess_area(out_y, crop.height, out_ht, &y_start, &y_end);
+                int32_t count = (x_end - x_start) * (y_end - y_start);
+                int32_t sum = 0;
+                for (int32_t y = y_start; y < y_end; y++) {
+                    for (int32_t x = x_start; x < x_end; x++) {
+                        sum += pixel_luma(base, stride, format, x, y);
+                    }
+                }
+                luma = (sum + (count >> 1)) / count;
+            } else {
+                int32_t x = esp_nn_preprocess_nearest(out_x, step_x, crop.width);
+                int32_t y = esp_nn_preprocess_nearest(out_y, step_y, crop.height);
+                luma = pixel_luma(base, stride, format, x, y);
+            }
+            output[out_y * out_wd + out_x] = esp_nn_preprocess_quantize(luma, params);
+        }
+    }
+}
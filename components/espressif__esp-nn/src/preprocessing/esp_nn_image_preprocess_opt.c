@@ -0,0 +1,242 @@
+// Copyright 2024 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "image_preprocess_common.h"
+
+/**
+ * Same arithmetic as the reference kernel, restructured so that nothing is
+ * computed per output pixel that can be computed once:
+ *  - the luma -> int8 quantization (multiply, round, clamp) is a 256 entry
+ *    table built per call,
+ *  - horizontal taps and weights are tabulated per column as byte offsets,
+ *  - bilinear is done separably, each horizontally filtered source row is
+ *    cached and reused by consecutive output rows,
+ *  - area sums each source pixel exactly once into per column accumulators.
+ *
+ * Scratch layout: [lut 256][tab0 wd * 4][tab1 wd * 4][rows/acc wd * 8]
+ */
+
+static uint8_t *scratch_buf = NULL;
+
+int32_t esp_nn_get_preprocess_image_scratch_size_opt(const data_dims_t *input_dims,
+                                                     const data_dims_t *output_dims,
+                                                     const image_preprocess_params_t *params)
+{
+    (void) input_dims;
+    (void) params;
+    return 256 + output_dims->width * 16;
+}
+
+void esp_nn_set_preprocess_image_scratch_buf_opt(void *buffer)
+{
+    scratch_buf = (uint8_t *) buffer;
+}
+
+/* 565 formats carry the luma weights of their high and low fields, see esp_nn_565_luma */
+typedef struct {
+    int32_t is_565;
+    int32_t w_hi;
+    int32_t w_lo;
+} pixel_565_t;
+
+static void filter_row_bilinear(const uint8_t *row,
+                                const int32_t *tab0,
+                                const int32_t *tab1,
+                                int32_t *dst,
+                                const int32_t wd,
+                                const pixel_565_t *px)
+{
+    if (px->is_565) {
+        for (int32_t x = 0; x < wd; x++) {
+            int32_t fx = tab1[x] & 0xff;
+            const uint8_t *p0 = row + tab0[x];
+            const uint8_t *p1 = row + (tab1[x] >> 8);
+            dst[x] = esp_nn_565_luma(p0[0], p0[1], px->w_hi, px->w_lo) * (BILINEAR_ONE - fx) +
+                     esp_nn_565_luma(p1[0], p1[1], px->w_hi, px->w_lo) * fx;
+        }
+    } else {
+        for (int32_t x = 0; x < wd; x++) {
+            int32_t fx = tab1[x] & 0xff;
+            int32_t p0 = row[tab0[x]];
+            int32_t p1 = row[tab1[x] >> 8];
+            /* p0 * (256 - fx) + p1 * fx */
+            dst[x] = (p0 << 8) + (p1 - p0) * fx;
+        }
+    }
+}
+
+static void preprocess_nearest(const uint8_t *base,
+                               const int32_t stride,
+                               const pixel_565_t *px,
+                               const int32_t *tab0,
+                               const int8_t *lut,
+                               const crop_rect_t *crop,
+                               int8_t *output,
+                               const int32_t out_wd,
+                               const int32_t out_ht)
+{
+    const int32_t step_y = esp_nn_preprocess_step(crop->height, out_ht);
+    for (int32_t out_y = 0; out_y < out_ht; out_y++) {
+        const uint8_t *row = base + esp_nn_preprocess_nearest(out_y, step_y, crop->height) * stride;
+        int8_t *out = output + out_y * out_wd;
+        int32_t x = 0;
+        if (px->is_565) {
+            for (; x < out_wd; x++) {
+                const uint8_t *p = row + tab0[x];
+                out[x] = lut[esp_nn_565_luma(p[0], p[1], px->w_hi, px->w_lo)];
+            }
+        } else {
+            for (; x < out_wd - 3; x += 4) {
+                int8_t o0 = lut[row[tab0[x + 0]]];
+                int8_t o1 = lut[row[tab0[x + 1]]];
+                int8_t o2 = lut[row[tab0[x + 2]]];
+                int8_t o3 = lut[row[tab0[x + 3]]];
+                out[x + 0] = o0;
+                out[x + 1] = o1;
+                out[x + 2] = o2;
+                out[x + 3] = o3;
+            }
+            for (; x < out_wd; x++) {
+                out[x] = lut[row[tab0[x]]];
+            }
+        }
+    }
+}
+
+void esp_nn_preprocess_image_s8_opt(const uint8_t *input,
+                                    const data_dims_t *input_dims,
+                                    const image_preprocess_params_t *params,
+                                    int8_t *output,
+                                    const data_dims_t *output_dims)
+{
+    if (scratch_buf == NULL) {
+        printf("%s error! scratch buffer not set\n", __FUNCTION__);
+        return;
+    }
+
+    const crop_rect_t crop = esp_nn_preprocess_crop(input_dims, params);
+    const int32_t bpp = esp_nn_preprocess_bpp(params->format);
+    const int32_t bgr = params->format == ESP_NN_PIXEL_BGR565;
+    const pixel_565_t px = {esp_nn_preprocess_is_565(params->format),
+                            bgr ? LUMA_B : LUMA_R, bgr ? LUMA_R : LUMA_B};
+    const int32_t stride = input_dims->width * bpp;
+    const uint8_t *base = input + crop.y * stride + crop.x * bpp;
+    const int32_t out_wd = output_dims->width;
+    const int32_t out_ht = output_dims->height;
+    const int32_t step_x = esp_nn_preprocess_step(crop.width, out_wd);
+    const int32_t step_y = esp_nn_preprocess_step(crop.height, out_ht);
+
+    int8_t *lut = (int8_t *) scratch_buf;
+    int32_t *tab0 = (int32_t *) (scratch_buf + 256);
+    int32_t *tab1 = tab0 + out_wd;
+    int32_t *work = tab1 + out_wd;
+
+    for (int32_t i = 0; i < 256; i++) {
+        lut[i] = esp_nn_preprocess_quantize(i, params);
+    }
+
+    /* every resize mode reduces to a plain copy when sizes match */
+    esp_nn_resize_t resize = params->resize;
+    if (crop.width == out_wd && crop.height == out_ht) {
+        resize = ESP_NN_RESIZE_NEAREST;
+    }
+
+    if (resize == ESP_NN_RESIZE_BILINEAR) {
+        for (int32_t x = 0; x < out_wd; x++) {
+            int32_t pos = esp_nn_preprocess_bilinear(x, step_x, crop.width);
+            int32_t x0 = pos >> 16;
+            int32_t x1 = min(x0 + 1, crop.width - 1);
+            tab0[x] = x0 * bpp;
+            tab1[x] = ((x1 * bpp) << 8) | ((pos >> 8) & 0xff);
+        }
+
+        int32_t *rows[2] = {work, work + out_wd};
+        int32_t row_y[2] = {-1, -1};
+        for (int32_t out_y = 0; out_y < out_ht; out_y++) {
+            int32_t pos = esp_nn_preprocess_bilinear(out_y, step_y, crop.height);
+            int32_t y0 = pos >> 16, fy = (pos >> 8) & 0xff;
+            int32_t y1 = min(y0 + 1, crop.height - 1);
+
+            if (row_y[0] != y0) {
+                if (row_y[1] == y0) {
+                    int32_t *tmp = rows[0];
+                    rows[0] = rows[1];
+                    rows[1] = tmp;
+                    row_y[1] = row_y[0];
+                } else {
+                    filter_row_bilinear(base + y0 * stride, tab0, tab1, rows[0], out_wd, &px);
+                }
+                row_y[0] = y0;
+            }
+            if (row_y[1] != y1) {
+                filter_row_bilinear(base + y1 * stride, tab0, tab1, rows[1], out_wd, &px);
+                row_y[1] = y1;
+            }
+
+            const int32_t *top = rows[0];
+            const int32_t *bottom = rows[1];
+            int8_t *out = output + out_y * out_wd;
+            for (int32_t x = 0; x < out_wd; x++) {
+                /* top * (256 - fy) + bottom * fy */
+                int32_t val = (top[x] << 8) + (bottom[x] - top[x]) * fy;
+                out[x] = lut[(val + (1 << 15)) >> 16];
+            }
+        }
+    } else if (resize == ESP_NN_RESIZE_AREA) {
+        for (int32_t x = 0; x < out_wd; x++) {
+            esp_nn_preprocess_area(x, crop.width, out_wd, &tab0[x], &tab1[x]);
+        }
+
+        for (int32_t out_y = 0; out_y < out_ht; out_y++) {
+            int32_t y_start, y_end;
+            esp_nn_preprocess_area(out_y, crop.height, out_ht, &y_start, &y_end);
+            memset(work, 0, out_wd * sizeof(int32_t));
+
+            for (int32_t y = y_start; y < y_end; y++) {
+                const uint8_t *row = base + y * stride;
+                for (int32_t x = 0; x < out_wd; x++) {
+                    const uint8_t *p = row + tab0[x] * bpp;
+                    const uint8_t *p_end = row + tab1[x] * bpp;
+                    int32_t sum = 0;
+                    if (px.is_565) {
+                        for (; p < p_end; p += 2) {
+                            sum += esp_nn_565_luma(p[0], p[1], px.w_hi, px.w_lo);
+                        }
+                    } else {
+                        for (; p < p_end; p += bpp) {
+                            sum += p[0];
+                        }
+                    }
+                    work[x] += sum;
+                }
+            }
+
+            const int32_t span_y = y_end - y_start;
+            int8_t *out = output + out_y * out_wd;
+            for (int32_t x = 0; x < out_wd; x++) {
+                int32_t count = (tab1[x] - tab0[x]) * span_y;
+                out[x] = lut[(work[x] + (count >> 1)) / count];
+            }
+        }
+    } else {
+        for (int32_t x = 0; x < out_wd; x++) {
+            tab0[x] = esp_nn_preprocess_nearest(x, step_x, crop.width) * bpp;
+        }
+        preprocess_nearest(base, stride, &px, tab0, lut, &crop, output, out_wd, out_ht);
+    }
+}
@@ -0,0 +1,122 @@
+// Copyright 2024 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include <stdint.h>
+#include <esp_nn_defs.h>
+#include <common_functions.h>
+
+/**
+ * Coordinate mapping and pixel math shared by the reference and optimized
+ * preprocessing kernels. Everything here is integer only so that every
+ * variant produces bit-exact results.
+ */
+
+/* 8 bit luma weights, 0.299 0.587 0.114 scaled to 1024 */
+#define LUMA_R  305
+#define LUMA_G  600
+#define LUMA_B  119
+
+/* bilinear weights are 8 bit, interpolated values are Q16 before rounding */
+#define BILINEAR_ONE    256
+
+typedef struct {
+    int32_t x;
+    int32_t y;
+    int32_t width;
+    int32_t height;
+} crop_rect_t;
+
+__NN_FORCE_INLINE__ crop_rect_t esp_nn_preprocess_crop(const data_dims_t *input_dims,
+                                                       const image_preprocess_params_t *params)
+{
+    crop_rect_t rect = {params->crop_x, params->crop_y, params->crop.width, params->crop.height};
+    if (rect.width <= 0 || rect.height <= 0) {
+        rect.x = 0;
+        rect.y = 0;
+        rect.width = input_dims->width;
+        rect.height = input_dims->height;
+    }
+    return rect;
+}
+
+__NN_FORCE_INLINE__ int32_t esp_nn_preprocess_bpp(esp_nn_pixel_format_t format)
+{
+    return format == ESP_NN_PIXEL_GRAY ? 1 : 2;
+}
+
+/**
+ * big endian 565 pixel to 8 bit luma, `w_hi` and `w_lo` weigh the 5 bit
+ * fields in the high and low bits: LUMA_R, LUMA_B for RGB565 and the other
+ * way round for BGR565
+ */
+__NN_FORCE_INLINE__ int32_t esp_nn_565_luma(uint32_t b0, uint32_t b1,
+                                            const int32_t w_hi, const int32_t w_lo)
+{
+    int32_t hi = b0 & 0xf8;
+    int32_t g = ((b0 & 0x07) << 5) | ((b1 & 0xe0) >> 3);
+    int32_t lo = (b1 & 0x1f) << 3;
+    return (w_hi * hi + LUMA_G * g + w_lo * lo) >> 10;
+}
+
+__NN_FORCE_INLINE__ int32_t esp_nn_preprocess_is_565(esp_nn_pixel_format_t format)
+{
+    return format == ESP_NN_PIXEL_RGB565 || format == ESP_NN_PIXEL_BGR565;
+}
+
+__NN_FORCE_INLINE__ int8_t esp_nn_preprocess_quantize(int32_t luma,
+                                                      const image_preprocess_params_t *params)
+{
+    int32_t out = ((luma * params->norm_mult + (1 << 15)) >> 16) + params->out_offset;
+    out = max(out, params->activation.min);
+    out = min(out, params->activation.max);
+    return (int8_t) out;
+}
+
+/* Q16 step between output samples, in source pixels */
+__NN_FORCE_INLINE__ int32_t esp_nn_preprocess_step(int32_t src_len, int32_t dst_len)
+{
+    return (int32_t) (((uint32_t) src_len << 16) / (uint32_t) dst_len);
+}
+
+/* pixel centre sampling */
+__NN_FORCE_INLINE__ int32_t esp_nn_preprocess_nearest(int32_t i, int32_t step, int32_t src_len)
+{
+    int32_t pos = (i * step + (step >> 1)) >> 16;
+    return min(pos, src_len - 1);
+}
+
+/**
+ * half pixel centres, returns the Q16 source position clamped to the valid
+ * range: `pos >> 16` is the first tap, `(pos >> 8) & 0xff` the weight of the
+ * second one.
+ */
+__NN_FORCE_INLINE__ int32_t esp_nn_preprocess_bilinear(int32_t i, int32_t step, int32_t src_len)
+{
+    int32_t pos = i * step + (step >> 1) - (1 << 15);
+    pos = max(pos, 0);
+    pos = min(pos, (src_len - 1) << 16);
+    return pos;
+}
+
+/* [start, end) of the source span covered by output sample `i` */
+__NN_FORCE_INLINE__ void esp_nn_preprocess_area(int32_t i, int32_t src_len, int32_t dst_len,
+                                                int32_t *start, int32_t *end)
+{
+    int32_t s = i * src_len / dst_len;
+    int32_t e = (i + 1) * src_len / dst_len;
+    *start = s;
+    *end = max(e, s + 1);
+}
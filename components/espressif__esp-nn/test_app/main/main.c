@@ -63,18 +63,33 @@ void app_main()
     printf("mul, c %"PRIu32" opt %"PRIu32"\n", total_c, total_opt);
     esp_nn_depthwise_conv_s8_test();
     esp_nn_conv_s8_test();
+    esp_nn_conv_sparse_s8_test();
+    esp_nn_conv_variants_test();
 
     esp_nn_relu6_s8_test();
     printf("relu, c %"PRIu32" opt %"PRIu32"\n", total_c, total_opt);
+    esp_nn_lut_s8_test();
+    printf("lut, c %"PRIu32" opt %"PRIu32"\n", total_c, total_opt);
     esp_nn_avg_pool_s8_test();
     printf("avg_pool, c %"PRIu32" opt %"PRIu32"\n", total_c, total_opt);
     esp_nn_max_pool_s8_test();
     printf("max_pool, c %"PRIu32" opt %"PRIu32"\n", total_c, total_opt);
     esp_nn_fully_connected_s8_test();
+    esp_nn_fully_connected_sparse_s8_test();
     esp_nn_softmax_s8_test();
     printf("softmax, c %"PRIu32" opt %"PRIu32"\n", total_c, total_opt);
+    esp_nn_preprocess_image_s8_test();
     ESP_LOGI(TAG, "s8 tests done!\n");
 
+    /* 16x8 tests */
+    ESP_LOGI(TAG, "Running 16x8 tests...");
+    esp_nn_depthwise_conv_s16_test();
+    esp_nn_conv_s16_test();
+    esp_nn_fully_connected_s16_test();
+    esp_nn_add_elementwise_s16_test();
+    esp_nn_mul_elementwise_s16_test();
+    ESP_LOGI(TAG, "16x8 tests done!\n");
+
     /* u8 tests */
     //ESP_LOGI(TAG, "Running u8 tests...");
     //esp_nn_add_elementwise_u8_test();
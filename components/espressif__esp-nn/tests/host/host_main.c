@@ -0,0 +1,51 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Host runner for the portable (ansi/opt) kernels, see tests/README.md.
+ * "cycles" printed by the tests are nanoseconds here.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <test_functions.h>
+
+static uint32_t start_c, start_opt;
+
+static uint32_t now_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t) (ts.tv_sec * 1000000000ull + ts.tv_nsec);
+}
+
+void profile_c_start()
+{
+    start_c = now_ns();
+}
+
+uint32_t profile_c_end()
+{
+    return now_ns() - start_c;
+}
+
+void profile_opt_start()
+{
+    start_opt = now_ns();
+}
+
+uint32_t profile_opt_end()
+{
+    return now_ns() - start_opt;
+}
+
+int main()
+{
+    esp_nn_preprocess_image_s8_test();
+    return 0;
+}
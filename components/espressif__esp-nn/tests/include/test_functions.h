@@ -19,16 +19,31 @@ void esp_nn_mul_elementwise_s8_test();
 
 void esp_nn_depthwise_conv_s8_test();
 void esp_nn_conv_s8_test();
+void esp_nn_conv_sparse_s8_test();
+void esp_nn_conv_variants_test();
 
 void esp_nn_avg_pool_s8_test();
 void esp_nn_max_pool_s8_test();
 
 void esp_nn_fully_connected_s8_test();
+void esp_nn_fully_connected_sparse_s8_test();
 
 void esp_nn_relu6_s8_test();
+void esp_nn_lut_s8_test();
 
 void esp_nn_softmax_s8_test();
 
+void esp_nn_preprocess_image_s8_test();
+
+/* int16_t activation, int8_t weight ops tests */
+void esp_nn_depthwise_conv_s16_test();
+void esp_nn_conv_s16_test();
+
+void esp_nn_fully_connected_s16_test();
+
+void esp_nn_add_elementwise_s16_test();
+void esp_nn_mul_elementwise_s16_test();
+
 /* uint8_t ops tests */
 void esp_nn_add_elementwise_u8_test();
 
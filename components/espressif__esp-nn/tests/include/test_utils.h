@@ -8,6 +8,7 @@
 #include <stdbool.h>
 #include <common_functions.h>
 #include <stdio.h>
+#include <stdlib.h>
 
 /* mult value range */
 #define MULT_MAX    INT32_MAX
@@ -92,3 +93,31 @@ uint32_t profile_opt_end();
     }                                                   \
     printf("\n");                                       \
 })
+
+/**
+ * Zero out roughly `sparsity`% of the blocks of a dense [rows x row_len]
+ * filter and pack the remaining ones into block-CSR form.
+ */
+static int pack_sparse_blocks(int8_t *dense, int rows, int row_len, int block_len, int sparsity,
+                              int8_t *values, int32_t *row_ptr, uint16_t *col_idx)
+{
+    int num_blocks = 0;
+    for (int r = 0; r < rows; r++) {
+        row_ptr[r] = num_blocks;
+        for (int b = 0; b < row_len / block_len; b++) {
+            int8_t *blk = dense + r * row_len + b * block_len;
+            if (rand() % 100 < sparsity) {
+                for (int k = 0; k < block_len; k++) {
+                    blk[k] = 0;
+                }
+                continue;
+            }
+            for (int k = 0; k < block_len; k++) {
+                values[num_blocks * block_len + k] = blk[k];
+            }
+            col_idx[num_blocks++] = b;
+        }
+    }
+    row_ptr[rows] = num_blocks;
+    return num_blocks;
+}
@@ -398,3 +398,309 @@ elementwise_mult_test_cleanup:
         }
     }
 }
+
+void esp_nn_add_elementwise_s16_test()
+{
+    /* prepare data */
+    int size = 1600 + 8 + 7; /* odd len to test leftover */
+    int16_t *input1;
+    int16_t *input2;
+    int16_t *out_data_c;
+    int16_t *out_data_opt;
+    int16_t *input1_orig = NULL;
+    int16_t *input2_orig = NULL;
+    int16_t *out_c_orig = NULL;
+    int16_t *out_opt_orig = NULL;
+    /* int16 quantization is symmetric, tflite passes zero offsets and left_shift 15 */
+    int32_t input1_offset = 0;
+    int32_t input2_offset = 0;
+    int32_t output_offset = 0;
+    int32_t left_shift = 15;
+    int32_t input1_shift;
+    int32_t input2_shift;
+    int32_t output_shift;
+    int32_t input1_mult;
+    int32_t input2_mult;
+    int32_t output_mult;
+    int32_t activation_min = INT16_MIN;
+    int32_t activation_max = INT16_MAX;
+
+    for (int itr = 0; itr < 10; itr++) {
+        switch (itr) {
+        case 0: // all zeros
+            input1_mult = 0;
+            input2_mult = 0;
+            output_mult = 0;
+            input1_shift = 0;
+            input2_shift = 0;
+            output_shift = 0;
+        break;
+        case 1: // unit scales: 0.5 * 2^15 for the inputs, 0.5 * 2^-13 out, output is in1 + in2
+            input1_mult = 1 << 30;
+            input2_mult = 1 << 30;
+            output_mult = 1 << 30;
+            input1_shift = 0;
+            input2_shift = 0;
+            output_shift = -13;
+        break;
+        case 2: // hit max, inputs halved so that their sum fits in 32 bits
+            input1_mult = MULT_MAX;
+            input2_mult = MULT_MAX;
+            output_mult = MULT_MAX;
+            input1_shift = -1;
+            input2_shift = -1;
+            output_shift = 0;
+        break;
+        case 3: // clamp
+            input1_mult = MULT_MAX / 2 + rand() % INT16_MAX;
+            input2_mult = MULT_MAX / 2 + rand() % INT16_MAX;
+            output_mult = MULT_MAX / 2 + rand() % INT16_MAX;
+            input1_shift = -1;
+            input2_shift = -1;
+            output_shift = -13;
+            activation_min = -1000;
+            activation_max = 1000;
+        break;
+        default:  // practical random input
+            input1_mult = MULT_MAX / 2 + rand() % INT16_MAX;
+            input2_mult = MULT_MAX / 2 + rand() % INT16_MAX;
+            output_mult = MULT_MAX / 2 + rand() % INT16_MAX;
+            input1_shift = -1 - rand() % 4;
+            input2_shift = -1 - rand() % 4;
+            output_shift = -14 + rand() % 4;
+            activation_min = INT16_MIN;
+            activation_max = INT16_MAX;
+            size = 4 + rand() % 64;
+        }
+#if IDF_HEAP_CAPS
+        input1_orig = (int16_t *) heap_caps_malloc(size * 2 + 16, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        input2_orig = (int16_t *) heap_caps_malloc(size * 2 + 16, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        out_c_orig = (int16_t *) heap_caps_malloc(size * 2 + 16, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        out_opt_orig = (int16_t *) heap_caps_malloc(size * 2 + 16, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+#else
+        input1_orig = malloc(size * 2 + 16);
+        input2_orig = malloc(size * 2 + 16);
+        out_c_orig = malloc(size * 2 + 16);
+        out_opt_orig = malloc(size * 2 + 16);
+#endif
+        if (input1_orig == NULL || input2_orig == NULL ||
+                out_c_orig == NULL || out_opt_orig == NULL) {
+            printf(ANSI_COLOR_RED"%s error allocating buffers\n"ANSI_COLOR_RESET, __FUNCTION__);
+            goto elementwise_add_s16_test_cleanup;
+        }
+
+        input1 = (int16_t *) (((uint32_t) input1_orig + 15) & ~15);
+        input2 = (int16_t *) (((uint32_t) input2_orig + 15) & ~15);
+        if (itr == 4) {
+            input2 = input2_orig; // unaligned input
+        }
+        out_data_c = (int16_t *) (((uint32_t) out_c_orig + 15) & ~15);
+        out_data_opt = (int16_t *) (((uint32_t) out_opt_orig + 15) & ~15);
+
+        for (int i = 0; i < size; ++i) {
+            input1[i] = rand() % 65536 - 32768;
+            input2[i] = rand() % 65536 - 32768;
+        }
+
+        if (itr == 0) {
+            /* enable profiler */
+            profile_c_start();
+        }
+        /* C function */
+        esp_nn_add_elementwise_s16_ansi(input1, input2, input1_offset, input2_offset,
+                                        input1_mult, input2_mult, input1_shift, input2_shift,
+                                        left_shift, out_data_c, output_offset, output_mult,
+                                        output_shift, activation_min, activation_max, size);
+
+        if (itr == 0) {
+            profile_c_end();
+            profile_opt_start();
+        }
+
+        /* Optimized function */
+        esp_nn_add_elementwise_s16(input1, input2, input1_offset, input2_offset,
+                                   input1_mult, input2_mult, input1_shift, input2_shift,
+                                   left_shift, out_data_opt, output_offset, output_mult,
+                                   output_shift, activation_min, activation_max, size);
+        if (itr == 0) {
+            /* disable profiler */
+            profile_opt_end();
+        }
+
+        bool ret = CHECK_EQUAL(out_data_c, out_data_opt, size);
+        if (ret && itr == 1) {
+            for (int i = 0; i < size; ++i) {
+                int32_t sum = input1[i] + input2[i];
+                if (out_data_c[i] != max(INT16_MIN, min(sum, INT16_MAX))) {
+                    ret = false;
+                    break;
+                }
+            }
+        }
+        if (ret == false) {
+            printf(ANSI_COLOR_RED"%s[%d] failed\n"ANSI_COLOR_RESET, __FUNCTION__, itr);
+            printf("Output: \n");
+            PRINT_ARRAY_HEX(out_data_opt, size * 2, 1);
+            printf("Expected: \n");
+            PRINT_ARRAY_HEX(out_data_c, size * 2, 1);
+            printf("Input1:\n");
+            PRINT_ARRAY_HEX(input1, size * 2, 1);
+            printf("Input2:\n");
+            PRINT_ARRAY_HEX(input2, size * 2, 1);
+            printf("in1_shift %"PRIi32", in2_shift %"PRIi32", out_shift %"PRIi32"\n",
+                   input1_shift, input2_shift, output_shift);
+            printf("in1_mult %"PRIi32", in2_mult %"PRIi32", out_mult %"PRIi32"\n",
+                   input1_mult, input2_mult, output_mult);
+            goto elementwise_add_s16_test_cleanup;
+        }
+        printf(ANSI_COLOR_GREEN"%s[%d] passed\n"ANSI_COLOR_RESET, __FUNCTION__, itr);
+
+elementwise_add_s16_test_cleanup:
+        if (input1_orig) {
+            free(input1_orig);
+        }
+        if (input2_orig) {
+            free(input2_orig);
+        }
+        if (out_c_orig) {
+            free(out_c_orig);
+        }
+        if (out_opt_orig) {
+            free(out_opt_orig);
+        }
+    }
+}
+
+void esp_nn_mul_elementwise_s16_test()
+{
+    /* prepare data */
+    int size = 1600 + 8 + 7; /* odd len to test leftover */
+    int16_t *input1;
+    int16_t *input2;
+    int16_t *out_data_c;
+    int16_t *out_data_opt;
+    /* int16 quantization is symmetric, tflite passes zero offsets */
+    int32_t input1_offset = 0;
+    int32_t input2_offset = 0;
+    int32_t output_offset = 0;
+    int32_t output_shift;
+    int32_t output_mult;
+    int32_t activation_min = INT16_MIN;
+    int32_t activation_max = INT16_MAX;
+    int16_t *input1_orig = NULL;
+    int16_t *input2_orig = NULL;
+    int16_t *out_c_orig = NULL;
+    int16_t *out_opt_orig = NULL;
+
+    for (int itr = 0; itr < 10; itr++) {
+        switch (itr) {
+        case 0: // all zeros
+            output_mult = 0;
+            output_shift = 0;
+        break;
+        case 1: // hit min
+            output_mult = MULT_MIN;
+            output_shift = 0;
+        break;
+        case 2: // hit max
+            output_mult = MULT_MAX;
+            output_shift = 0;
+        break;
+        case 3: // clamp
+            output_mult = MULT_MAX;
+            output_shift = -15;
+            activation_min = -1000;
+            activation_max = 1000;
+        break;
+        default:  // practical random input
+            output_mult = MULT_MAX / 2 + rand() % INT16_MAX;
+            output_shift = -16 + rand() % 4;
+            activation_min = INT16_MIN;
+            activation_max = INT16_MAX;
+            size = 4 + rand() % 64;
+        }
+
+#if IDF_HEAP_CAPS
+        input1_orig = (int16_t *) heap_caps_malloc(size * 2 + 16, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        input2_orig = (int16_t *) heap_caps_malloc(size * 2 + 16, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        out_c_orig = (int16_t *) heap_caps_malloc(size * 2 + 16, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        out_opt_orig = (int16_t *) heap_caps_malloc(size * 2 + 16, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+#else
+        input1_orig = malloc(size * 2 + 16);
+        input2_orig = malloc(size * 2 + 16);
+        out_c_orig = malloc(size * 2 + 16);
+        out_opt_orig = malloc(size * 2 + 16);
+#endif
+        if (input1_orig == NULL || input2_orig == NULL ||
+                out_c_orig == NULL || out_opt_orig == NULL) {
+            printf(ANSI_COLOR_RED"%s error allocating buffers\n"ANSI_COLOR_RESET, __FUNCTION__);
+            goto elementwise_mult_s16_test_cleanup;
+        }
+
+        input1 = (int16_t *) (((uint32_t) input1_orig + 15) & ~15);
+        input2 = (int16_t *) (((uint32_t) input2_orig + 15) & ~15);
+        if (itr == 4 || itr == 5) {
+            input2 = input2_orig; // unaligned input
+        }
+
+        out_data_c = (int16_t *) (((uint32_t) out_c_orig + 15) & ~15);
+        out_data_opt = (int16_t *) (((uint32_t) out_opt_orig + 15) & ~15);
+
+        for (int i = 0; i < size; ++i) {
+            input1[i] = rand() % 65536 - 32768;
+            input2[i] = rand() % 65536 - 32768;
+        }
+
+        if (itr == 0) {
+            /* enable profiler */
+            profile_c_start();
+        }
+        /* C function */
+        esp_nn_mul_elementwise_s16_ansi(input1, input2, input1_offset, input2_offset,
+                                        out_data_c, output_offset, output_mult, output_shift,
+                                        activation_min, activation_max, size);
+
+        if (itr == 0) {
+            profile_c_end();
+            profile_opt_start();
+        }
+        /* Optimized function */
+        esp_nn_mul_elementwise_s16(input1, input2, input1_offset, input2_offset,
+                                   out_data_opt, output_offset, output_mult, output_shift,
+                                   activation_min, activation_max, size);
+
+        if (itr == 0) {
+            /* disable profiler */
+            profile_opt_end();
+        }
+
+        bool ret = CHECK_EQUAL(out_data_c, out_data_opt, size);
+        if (ret == false) {
+            printf(ANSI_COLOR_RED"%s[%d] failed\n"ANSI_COLOR_RESET, __FUNCTION__, itr);
+            printf("Output: \n");
+            PRINT_ARRAY_HEX(out_data_opt, size * 2, 1);
+            printf("Expected: \n");
+            PRINT_ARRAY_HEX(out_data_c, size * 2, 1);
+            printf("Input1:\n");
+            PRINT_ARRAY_HEX(input1, size * 2, 1);
+            printf("Input2:\n");
+            PRINT_ARRAY_HEX(input2, size * 2, 1);
+            goto elementwise_mult_s16_test_cleanup;
+        }
+        printf(ANSI_COLOR_GREEN"%s[%d] passed\n"ANSI_COLOR_RESET, __FUNCTION__, itr);
+
+elementwise_mult_s16_test_cleanup:
+        if (input1_orig) {
+            free(input1_orig);
+        }
+        if (input2_orig) {
+            free(input2_orig);
+        }
+        if (out_c_orig) {
+            free(out_c_orig);
+        }
+        if (out_opt_orig) {
+            free(out_opt_orig);
+        }
+    }
+}
@@ -0,0 +1,81 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <malloc.h>
+
+#include <esp_nn.h>
+#include "test_utils.h"
+
+void esp_nn_lut_s8_test()
+{
+    const int size = 1600 + 8 + 7;
+    int8_t lut[256];
+    int8_t *input = NULL, *out_ansi = NULL, *out_opt = NULL;
+
+    int8_t *input_orig = malloc(size + 16);
+    int8_t *out_c_orig = malloc(size + 16);
+    int8_t *out_opt_orig = malloc(size + 16);
+
+    if (input_orig == NULL || out_c_orig == NULL || out_opt_orig == NULL) {
+        printf(ANSI_COLOR_RED"%s allocations failed\n"ANSI_COLOR_RESET, __FUNCTION__);
+        goto lut_s8_cleanup;
+    }
+    input = (int8_t *) (((uint32_t) input_orig + 15) & ~15);
+    out_ansi = (int8_t *) (((uint32_t) out_c_orig + 15) & ~15);
+    /* unaligned output to exercise the head/tail handling */
+    out_opt = (int8_t *) ((((uint32_t) out_opt_orig + 15) & ~15) + 1);
+
+    /* Generate table and input data between -128 -> +127 */
+    for (int i = 0; i < 256; ++i) {
+        lut[i] = rand() % 255 - 128;
+    }
+    for (int i = 0; i < size; ++i) {
+        input[i] = rand() % 255 - 128;
+    }
+
+    /* enable profiler */
+    profile_c_start();
+
+    /* C function */
+    esp_nn_lut_s8_ansi(input, out_ansi, lut, size);
+
+    profile_c_end();
+    profile_opt_start();
+
+    /* Optimized function */
+    esp_nn_lut_s8(input, out_opt, lut, size);
+
+    /* disable profiler */
+    profile_opt_end();
+
+    bool ret = CHECK_EQUAL(out_ansi, out_opt, size);
+    if (ret == false) {
+        printf(ANSI_COLOR_RED"%s failed\n"ANSI_COLOR_RESET, __FUNCTION__);
+        printf("Output: \n");
+        PRINT_ARRAY_HEX(out_opt, size, 1);
+        printf("Expected: \n");
+        PRINT_ARRAY_HEX(out_ansi, size, 1);
+        printf("Input:\n");
+        PRINT_ARRAY_HEX(input, size, 1);
+        goto lut_s8_cleanup;
+    }
+    printf(ANSI_COLOR_GREEN"%s passed\n"ANSI_COLOR_RESET, __FUNCTION__);
+
+lut_s8_cleanup:
+    if (input_orig) {
+        free (input_orig);
+    }
+    if (out_c_orig) {
+        free (out_c_orig);
+    }
+    if (out_opt_orig) {
+        free (out_opt_orig);
+    }
+}
@@ -0,0 +1,136 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <malloc.h>
+
+#include <esp_nn.h>
+#include "test_utils.h"
+
+typedef struct {
+    int32_t in_wd, in_ht;
+    int32_t crop_x, crop_y, crop_wd, crop_ht;
+    int32_t out_wd, out_ht;
+} preprocess_shape_t;
+
+static const preprocess_shape_t shapes[] = {
+    {96, 96, 0, 0, 0, 0, 96, 96},           // today's 96x96 capture
+    {320, 240, 40, 0, 240, 240, 96, 96},    // QVGA, centre square
+    {320, 240, 0, 0, 0, 0, 96, 96},         // QVGA, squashed
+    {160, 120, 20, 0, 120, 120, 96, 96},    // QQVGA
+    {96, 96, 0, 0, 0, 0, 192, 192},         // upscale
+    {77, 53, 3, 5, 61, 41, 17, 13},         // odd everything
+};
+
+static const char *format_names[] = {"rgb565", "yuv422", "gray", "bgr565"};
+static const char *resize_names[] = {"nearest", "bilinear", "area"};
+
+void esp_nn_preprocess_image_s8_test()
+{
+    uint32_t total_c = 0, total_opt = 0;
+    const int num_shapes = sizeof(shapes) / sizeof(shapes[0]);
+
+    printf("\n######## Running %s ##########\n", __FUNCTION__);
+    for (int itr = 0; itr < num_shapes * 12; itr++) {
+        const preprocess_shape_t *shape = &shapes[itr / 12];
+        const esp_nn_pixel_format_t format = (esp_nn_pixel_format_t) ((itr % 12) / 3);
+        const esp_nn_resize_t resize = (esp_nn_resize_t) (itr % 3);
+        const int32_t bpp = format == ESP_NN_PIXEL_GRAY ? 1 : 2;
+        const int32_t in_size = shape->in_wd * shape->in_ht * bpp;
+        const int32_t out_size = shape->out_wd * shape->out_ht;
+        void *scratch_buf = NULL;
+
+        uint8_t *input = malloc(in_size);
+        int8_t *out_c = malloc(out_size);
+        int8_t *out_opt = malloc(out_size);
+        if (input == NULL || out_c == NULL || out_opt == NULL) {
+            printf(ANSI_COLOR_RED"[%3d] allocations failed\n"ANSI_COLOR_RESET, itr);
+            goto preprocess_cleanup;
+        }
+
+        for (int i = 0; i < in_size; i++) {
+            input[i] = rand() & 0xff;
+        }
+
+        data_dims_t input_dims = {.width = shape->in_wd, .height = shape->in_ht, .channels = bpp, .extra = 1};
+        data_dims_t output_dims = {.width = shape->out_wd, .height = shape->out_ht, .channels = 1, .extra = 1};
+        image_preprocess_params_t params = {
+            .format = format,
+            .resize = resize,
+            .crop_x = shape->crop_x,
+            .crop_y = shape->crop_y,
+            .crop = {.width = shape->crop_wd, .height = shape->crop_ht},
+            /* alternate between plain `y - 128` and a scaled, clamped range */
+            .norm_mult = itr & 1 ? 65536 : 90000 + itr,
+            .out_offset = itr & 1 ? -128 : -140,
+            .activation = {.min = itr & 1 ? -128 : -120, .max = itr & 1 ? 127 : 100},
+        };
+
+        /* enable profiler */
+        profile_c_start();
+
+        /* C function */
+        esp_nn_preprocess_image_s8_ansi(input, &input_dims, &params, out_c, &output_dims);
+
+        total_c = profile_c_end();
+
+        int32_t scratch_size = esp_nn_get_preprocess_image_scratch_size(&input_dims, &output_dims, &params);
+        if (scratch_size) {
+            scratch_buf = malloc(scratch_size);
+            if (scratch_buf == NULL) {
+                printf(ANSI_COLOR_RED"[%3d] scratch_buf alloc failed size %"PRIi32"\n"ANSI_COLOR_RESET,
+                       itr, scratch_size);
+                goto preprocess_cleanup;
+            }
+        }
+        esp_nn_set_preprocess_image_scratch_buf(scratch_buf);
+
+        profile_opt_start();
+
+        /* Optimized function */
+        esp_nn_preprocess_image_s8(input, &input_dims, &params, out_opt, &output_dims);
+
+        /* disable profiler */
+        total_opt = profile_opt_end();
+
+        bool ret = CHECK_EQUAL(out_c, out_opt, out_size);
+        if (ret == false) {
+            printf(ANSI_COLOR_RED"[%3d] failed [%s %s, in: (%3"PRIi32",%3"PRIi32"), out: (%3"PRIi32",%3"PRIi32")]\n"
+                   ANSI_COLOR_RESET, itr, format_names[format], resize_names[resize],
+                   shape->in_wd, shape->in_ht, shape->out_wd, shape->out_ht);
+#if 0
+            printf("Output: \n");
+            PRINT_ARRAY_HEX(out_opt, shape->out_wd, shape->out_ht);
+            printf("Expected: \n");
+            PRINT_ARRAY_HEX(out_c, shape->out_wd, shape->out_ht);
+#endif
+            goto preprocess_cleanup;
+        }
+        printf(ANSI_COLOR_GREEN"[%3d] passed [%-6s %-8s in: (%3"PRIi32",%3"PRIi32"), out: (%3"PRIi32",%3"PRIi32")]"
+               ANSI_COLOR_RESET, itr, format_names[format], resize_names[resize],
+               shape->in_wd, shape->in_ht, shape->out_wd, shape->out_ht);
+        printf("\tcycles: c %8"PRIu32", opt %8"PRIu32"\n", total_c, total_opt);
+
+    preprocess_cleanup:
+        esp_nn_set_preprocess_image_scratch_buf(NULL);
+        if (input) {
+            free(input);
+        }
+        if (out_c) {
+            free(out_c);
+        }
+        if (out_opt) {
+            free(out_opt);
+        }
+        if (scratch_buf) {
+            free(scratch_buf);
+        }
+    }
+}
@@ -184,13 +184,14 @@ static esp_err_t espnow_ctrl_responder_forward(uint8_t type, uint8_t *src_addr,
     memcpy(espnow_data->src_addr, src_addr, 6);
     memcpy(espnow_data->payload, data, size);
 
-    esp_wifi_get_channel(&primary, &second);
+    espnow_radio_get_channel(&primary, &second);
     while (retransmit_count < g_self_country.nchan) {
-        esp_wifi_set_channel(g_self_country.schan + retransmit_count, WIFI_SECOND_CHAN_NONE);
-        esp_now_send(ESPNOW_ADDR_BROADCAST, (uint8_t *)espnow_data, espnow_data->size + sizeof(espnow_forward_data_t));
+        espnow_radio_set_channel(g_self_country.schan + retransmit_count, WIFI_SECOND_CHAN_NONE);
+        espnow_radio_send(ESPNOW_ADDR_BROADCAST, espnow_data, espnow_data->size + sizeof(espnow_forward_data_t));
         retransmit_count++;
     }
-    esp_wifi_set_channel(primary, second);
+    espnow_radio_set_channel(primary, second);
+    ESP_FREE(espnow_data);
 
     return ESP_OK;
 }
@@ -200,11 +200,11 @@ static int scan_func(int argc, char **argv)
         wifi_second_chan_t second = 0;
         static wifi_country_t country = {0};
 
-        esp_wifi_get_channel(&primary, &second);
-        esp_wifi_get_country(&country);
+        espnow_radio_get_channel(&primary, &second);
+        espnow_radio_get_country(&country);
 
         for (int i = 0; i < country.nchan; ++i) {
-            esp_wifi_set_channel(country.schan + i, WIFI_SECOND_CHAN_NONE);
+            espnow_radio_set_channel(country.schan + i, WIFI_SECOND_CHAN_NONE);
             frame_head.channel = country.schan + i;
 
             for(int count = 0; count < 3; ++count) {
@@ -217,7 +217,7 @@ static int scan_func(int argc, char **argv)
             /**< Waiting to receive the response message */
         }
 
-        esp_wifi_set_channel(primary, second);
+        espnow_radio_set_channel(primary, second);
     } else {
         esp_err_t ret = espnow_send(ESPNOW_DATA_TYPE_DEBUG_COMMAND, addr,
                                     data, strlen(data) + 1, &frame_head, portMAX_DELAY);
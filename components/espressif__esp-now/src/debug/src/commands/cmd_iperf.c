@@ -68,8 +68,8 @@ static int espnow_config_func(int argc, char **argv)
         wifi_country_t country    = {0};
         wifi_second_chan_t second = WIFI_SECOND_CHAN_NONE;
 
-        esp_wifi_get_country(&country);
-        esp_wifi_get_channel(&primary, &second);
+        espnow_radio_get_country(&country);
+        espnow_radio_get_channel(&primary, &second);
         esp_wifi_get_max_tx_power(&power);
         esp_wifi_get_protocol(ESP_IF_WIFI_STA, &protocol_bitmap);
 
@@ -105,7 +105,7 @@ static int espnow_config_func(int argc, char **argv)
     }
 
     if (espnow_config_args.channel->count) {
-        ESP_ERROR_CHECK(esp_wifi_set_channel(espnow_config_args.channel->ival[0], WIFI_SECOND_CHAN_NONE));
+        ESP_ERROR_CHECK(espnow_radio_set_channel(espnow_config_args.channel->ival[0], WIFI_SECOND_CHAN_NONE));
     }
 
     if (espnow_config_args.rate->count) {
@@ -633,7 +633,7 @@ static esp_err_t espnow_iperf_func(int argc, char **argv)
 
     uint8_t channel                = 1;
     wifi_second_chan_t second      = 0;
-    ESP_ERROR_CHECK(esp_wifi_get_channel(&channel, &second));
+    ESP_ERROR_CHECK(espnow_radio_get_channel(&channel, &second));
 
     g_iperf_cfg.finish = false;
 
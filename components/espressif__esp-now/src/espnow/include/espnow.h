@@ -32,6 +32,11 @@ extern "C" {
 #define ESPNOW_DATA_LEN                     ESPNOW_PAYLOAD_LEN
 #endif
 
+/**
+ * @brief Largest message espnow_send() and espnow_send_msg() split into frames
+ */
+#define ESPNOW_MSG_MAX_LEN                  UINT16_MAX
+
 #define ESPNOW_ADDR_LEN                     (6)
 #define ESPNOW_ADDR_IS_EMPTY(addr)          (((addr)[0] | (addr)[1] | (addr)[2] | (addr)[3] | (addr)[4] | (addr)[5]) == 0x0)
 #define ESPNOW_ADDR_IS_BROADCAST(addr)      (((addr)[0] & (addr)[1] & (addr)[2] & (addr)[3] & (addr)[4] & (addr)[5]) == 0xFF)
@@ -145,6 +150,7 @@ typedef enum {
     ESPNOW_DATA_TYPE_SECURITY,       /**< Security handshake packet */
     ESPNOW_DATA_TYPE_SECURITY_DATA,  /**< Security packet */
     ESPNOW_DATA_TYPE_RESERVED,       /**< Reserved for other function */
+    ESPNOW_DATA_TYPE_STREAM,         /**< Reliable stream data and its selective ACKs */
     ESPNOW_DATA_TYPE_MAX,
 } espnow_data_type_t;
 
@@ -203,7 +209,8 @@ esp_err_t espnow_del_peer(const espnow_addr_t addr);
  * @param[in]   type  ESP-NOW data type defined by espnow_data_type_t
  * @param[in]   dest_addr  destination mac address
  * @param[in]   data  the sending data which must not be NULL
- * @param[in]   size  the maximum length of data, must be no more than ESPNOW_DATA_LEN
+ * @param[in]   size  the maximum length of data, must be no more than ESPNOW_MSG_MAX_LEN.
+ *                    Data longer than ESPNOW_DATA_LEN is sent with espnow_send_msg()
  * @param[in]   frame_config  if frame_config is NULL, Use ESPNOW_FRAME_CONFIG_DEFAULT configuration
  * @param[in]   wait_ticks  the maximum sending time in ticks
  *
@@ -216,6 +223,74 @@ esp_err_t espnow_del_peer(const espnow_addr_t addr);
 esp_err_t espnow_send(espnow_data_type_t type, const espnow_addr_t dest_addr, const void *data,
                       size_t size, const espnow_frame_head_t *frame_config, TickType_t wait_ticks);
 
+/**
+ * @brief Counters of the cache that drops copies of frames already received
+ *
+ * A frame is known by its source address, data type, magic and payload for
+ * CONFIG_ESPNOW_MSG_CACHE_TIMEOUT. The cache holds the frames of
+ * CONFIG_ESPNOW_MSG_CACHE_RATE per second over that time. A busier node
+ * forgets the oldest early, with a warning, and a late copy of one of them
+ * is delivered and forwarded again. Raise the rate while evicted keeps
+ * growing. ACKs to this node are not cached, only those it forwards.
+ */
+typedef struct {
+    uint32_t lookup;                /**< Frames checked */
+    uint32_t hit;                   /**< Frames dropped as copies */
+    uint32_t evicted;               /**< Frames forgotten before the timeout to make room */
+    uint32_t forwarded;             /**< Frames queued to be forwarded */
+} espnow_msg_cache_stats_t;
+
+/**
+ * @brief   Get the counters of the duplicate cache since start up
+ *
+ * @param[out]  stats  counters
+ *
+ * @return
+ *    - ESP_OK
+ *    - ESP_ERR_INVALID_ARG
+ */
+esp_err_t espnow_get_msg_cache_stats(espnow_msg_cache_stats_t *stats);
+
+/**
+ * @brief A piece of a message, see espnow_send_msg()
+ */
+typedef struct {
+    const void *data;
+    size_t size;
+} espnow_iov_t;
+
+/**
+ * @brief   Send a message that may be longer than one frame
+ *
+ * The message is the concatenation of the iov buffers. It is cut into frames of a few bytes
+ * less than ESPNOW_DATA_LEN, each sent like espnow_send() with frame_config. The frames are
+ * filled straight from the buffers, the message is never copied as a whole.
+ *
+ * The receiver collects the frames and calls the handler of type once with the whole
+ * message, rx_ctrl is the one of the last frame. CONFIG_ESPNOW_MSG_REASSEMBLY_NUM messages
+ * are collected at a time, one that gets no frame for CONFIG_ESPNOW_MSG_REASSEMBLY_TIMEOUT
+ * is dropped, and one larger than CONFIG_ESPNOW_MSG_REASSEMBLY_SIZE of the receiver never
+ * arrives. A message needs every frame to arrive: set retransmit_count or ack in
+ * frame_config on a lossy link.
+ *
+ * @param[in]   type  ESP-NOW data type defined by espnow_data_type_t
+ * @param[in]   dest_addr  destination mac address
+ * @param[in]   iov  buffers making up the message, at most ESPNOW_MSG_MAX_LEN bytes together
+ * @param[in]   iov_num  number of buffers
+ * @param[in]   frame_config  if frame_config is NULL, Use ESPNOW_FRAME_CONFIG_DEFAULT configuration.
+ *                            A magic other than 0 is increased by one for each frame
+ * @param[in]   wait_ticks  the maximum time for the whole message in ticks
+ *
+ * @return
+ *    - ESP_OK
+ *    - ESP_ERR_INVALID_ARG
+ *    - ESP_ERR_NO_MEM
+ *    - ESP_ERR_TIMEOUT
+ *    - ESP_ERR_WIFI_TIMEOUT
+ */
+esp_err_t espnow_send_msg(espnow_data_type_t type, const espnow_addr_t dest_addr, const espnow_iov_t *iov,
+                          size_t iov_num, const espnow_frame_head_t *frame_config, TickType_t wait_ticks);
+
 /**
  * @brief   ESP-NOW data receive callback function for the corresponding data type
  *
@@ -224,6 +299,9 @@ esp_err_t espnow_send(espnow_data_type_t type, const espnow_addr_t dest_addr, co
  * @param[in]  size  length of received data
  * @param[in]  rx_ctrl  received packet radio metadata header
  *
+ * @note src_addr, data and rx_ctrl point into the receive buffer and are only valid until the
+ *       callback returns. Do not modify them, the same buffer may still be forwarded.
+ *
  * @return
  *    - ESP_OK
  *    - ESP_ERR_INVALID_ARG
@@ -231,6 +309,94 @@ esp_err_t espnow_send(espnow_data_type_t type, const espnow_addr_t dest_addr, co
 typedef esp_err_t (*handler_for_data_t)(uint8_t *src_addr, void *data,
                                    size_t size, wifi_pkt_rx_ctrl_t *rx_ctrl);
 
+/**
+ * @brief Radio the ESP-NOW stack sends and receives through
+ *
+ * The default backend drives esp_now and esp_wifi. Another one, such as the
+ * simulated medium in test/host, is installed with espnow_set_radio() before
+ * espnow_init(). Every operation gets the ctx given to espnow_set_radio().
+ * The callbacks passed to init() must be called the way the Wi-Fi driver
+ * calls them: send_cb once per accepted send(), recv_cb for every frame
+ * heard on the current channel.
+ */
+typedef struct {
+    esp_err_t (*init)(void *ctx, esp_now_send_cb_t send_cb, esp_now_recv_cb_t recv_cb, const uint8_t *pmk);
+    esp_err_t (*deinit)(void *ctx);
+    esp_err_t (*send)(void *ctx, const uint8_t *peer_addr, const uint8_t *data, size_t len);
+    esp_err_t (*add_peer)(void *ctx, const esp_now_peer_info_t *peer);
+    esp_err_t (*del_peer)(void *ctx, const uint8_t *peer_addr);
+    bool (*is_peer_exist)(void *ctx, const uint8_t *peer_addr);
+    esp_err_t (*get_channel)(void *ctx, uint8_t *primary, wifi_second_chan_t *second);
+    esp_err_t (*set_channel)(void *ctx, uint8_t primary, wifi_second_chan_t second);
+    esp_err_t (*get_country)(void *ctx, wifi_country_t *country);
+    esp_err_t (*get_mac)(void *ctx, uint8_t mac[ESPNOW_ADDR_LEN]);
+} espnow_radio_t;
+
+/**
+ * @brief Select the radio backend, must be called before espnow_init()
+ *
+ * @param[in]  radio  backend operations, NULL restores the Wi-Fi driver
+ * @param[in]  ctx  passed to every operation
+ *
+ * @return
+ *    - ESP_OK
+ *    - ESP_ERR_INVALID_STATE
+ */
+esp_err_t espnow_set_radio(const espnow_radio_t *radio, void *ctx);
+
+/**
+ * @brief Get the current channel of the selected radio
+ *
+ * @note Components that hop channels or send frames of their own use these
+ *       espnow_radio_* calls rather than esp_wifi and esp_now, so that they
+ *       follow the backend given to espnow_set_radio().
+ *
+ * @param[out]  primary  primary channel
+ * @param[out]  second  secondary channel
+ *
+ * @return
+ *    - ESP_OK
+ *    - ESP_ERR_INVALID_ARG
+ */
+esp_err_t espnow_radio_get_channel(uint8_t *primary, wifi_second_chan_t *second);
+
+/**
+ * @brief Switch the selected radio to another channel
+ *
+ * @param[in]  primary  primary channel
+ * @param[in]  second  secondary channel
+ *
+ * @return
+ *    - ESP_OK
+ *    - ESP_ERR_INVALID_ARG
+ */
+esp_err_t espnow_radio_set_channel(uint8_t primary, wifi_second_chan_t second);
+
+/**
+ * @brief Get the country, and so the channel range, of the selected radio
+ *
+ * @param[out]  country  country configuration
+ *
+ * @return
+ *    - ESP_OK
+ *    - ESP_ERR_INVALID_ARG
+ */
+esp_err_t espnow_radio_get_country(wifi_country_t *country);
+
+/**
+ * @brief Send an already built frame on the current channel, without
+ *        sequence numbers, retransmission or acknowledgement
+ *
+ * @param[in]  dest_addr  peer address, the peer must have been added
+ * @param[in]  data  frame
+ * @param[in]  size  frame length, at most ESP_NOW_MAX_DATA_LEN
+ *
+ * @return
+ *    - ESP_OK
+ *    - ESP_ERR_INVALID_ARG
+ */
+esp_err_t espnow_radio_send(const uint8_t *dest_addr, const void *data, size_t size);
+
 /**
  * @brief De-initialize ESP-NOW function
  *
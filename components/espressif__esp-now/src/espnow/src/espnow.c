@@ -7,6 +7,8 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <inttypes.h>
+#include <stdatomic.h>
 #include <sys/param.h>
 
 #include "freertos/FreeRTOS.h"
@@ -32,8 +34,6 @@
 #define SEND_CB_OK                      BIT0
 #define SEND_CB_FAIL                    BIT1
 
-#define ESPNOW_MSG_CACHE                32
-
 #ifndef CONFIG_ESPNOW_VERSION
 #define ESPNOW_VERSION                  2
 #else
@@ -41,6 +41,43 @@
 #endif
 
 #define SEND_DELAY_UNIT_MSECS         2
+#define ACK_QUEUE_SIZE                4
+
+#ifndef CONFIG_ESPNOW_MSG_CACHE_RATE
+#define CONFIG_ESPNOW_MSG_CACHE_RATE            500
+#endif
+
+#ifndef CONFIG_ESPNOW_MSG_CACHE_SIZE
+#define CONFIG_ESPNOW_MSG_CACHE_SIZE            0
+#endif
+
+#ifndef CONFIG_ESPNOW_MSG_CACHE_TIMEOUT
+#define CONFIG_ESPNOW_MSG_CACHE_TIMEOUT         3000
+#endif
+
+/**< Frames the duplicate cache remembers, by default as many as arrive within the timeout */
+#if CONFIG_ESPNOW_MSG_CACHE_SIZE
+#define ESPNOW_MSG_CACHE_ENTRIES                CONFIG_ESPNOW_MSG_CACHE_SIZE
+#else
+#define ESPNOW_MSG_CACHE_ENTRIES                MAX(CONFIG_ESPNOW_MSG_CACHE_RATE * CONFIG_ESPNOW_MSG_CACHE_TIMEOUT / 1000, 16)
+#endif
+
+/**< Index slots of the duplicate cache, at most half of them are used so probes stay short */
+#define ESPNOW_MSG_CACHE_SLOTS                  (ESPNOW_MSG_CACHE_ENTRIES * 2)
+
+_Static_assert(ESPNOW_MSG_CACHE_SLOTS <= UINT16_MAX, "the cache index holds 16 bit entry numbers");
+
+#ifndef CONFIG_ESPNOW_MSG_REASSEMBLY_NUM
+#define CONFIG_ESPNOW_MSG_REASSEMBLY_NUM        2
+#endif
+
+#ifndef CONFIG_ESPNOW_MSG_REASSEMBLY_TIMEOUT
+#define CONFIG_ESPNOW_MSG_REASSEMBLY_TIMEOUT    1000
+#endif
+
+#ifndef CONFIG_ESPNOW_MSG_REASSEMBLY_SIZE
+#define CONFIG_ESPNOW_MSG_REASSEMBLY_SIZE       131072
+#endif
 
 #if CONFIG_ESP32_WIFI_DYNAMIC_TX_BUFFER_NUM
 #define MAX_BUFFERED_NUM              (CONFIG_ESP32_WIFI_DYNAMIC_TX_BUFFER_NUM / 2)     /* Not more than CONFIG_ESP32_WIFI_DYNAMIC_TX_BUFFER_NUM */
@@ -79,9 +116,10 @@ typedef struct {
 } __attribute__((packed)) espnow_frame_format_t;
 
 typedef struct {
-    uint8_t type    : 4;
-    uint8_t version : 2;
-    uint8_t         : 2;
+    uint8_t type     : 4;
+    uint8_t version  : 2;
+    uint8_t fragment : 1;       /**< The payload starts with an espnow_msg_frag_t */
+    uint8_t          : 1;
     uint8_t size;
     espnow_frame_head_t frame_head;
     uint8_t dest_addr[6];
@@ -89,6 +127,34 @@ typedef struct {
     uint8_t payload[0];
 } __attribute__((packed)) espnow_data_t;
 
+/**
+ * @brief Header of each piece of a message sent with espnow_send_msg()
+ */
+typedef struct {
+    uint16_t id;                /**< Counts the messages of the sender */
+    uint16_t size;              /**< Length of the whole message */
+    uint16_t index;             /**< The piece starts at index * ESPNOW_MSG_FRAG_LEN */
+    uint8_t data[0];
+} __attribute__((packed)) espnow_msg_frag_t;
+
+#define ESPNOW_MSG_FRAG_LEN             (ESPNOW_DATA_LEN - sizeof(espnow_msg_frag_t))
+#define ESPNOW_MSG_FRAG_MAX             ((ESPNOW_MSG_MAX_LEN + ESPNOW_MSG_FRAG_LEN - 1) / ESPNOW_MSG_FRAG_LEN)
+
+/**
+ * @brief A message being put back together, data is allocated for its size
+ */
+typedef struct {
+    uint8_t src_addr[6];
+    uint8_t type;
+    uint16_t id;
+    uint16_t size;
+    uint16_t frag_num;
+    uint16_t received_num;
+    TickType_t update_ticks;
+    uint32_t received[(ESPNOW_MSG_FRAG_MAX + 31) / 32];
+    uint8_t *data;
+} espnow_msg_reassembly_t;
+
 /**
  * @brief Receive data packet temporarily store in queue
  */
@@ -97,6 +163,15 @@ typedef struct {
     espnow_data_t data;
 } espnow_pkt_t;
 
+/* A slot holds the largest frame the radio can deliver, kept word aligned */
+#define ESPNOW_PKT_SLOT_SIZE            ((sizeof(espnow_pkt_t) + ESP_NOW_MAX_DATA_LEN + 3) & ~3)
+/* The free bitmap and the reference counts cover this many slots */
+#define ESPNOW_PKT_POOL_MAX             (UINT8_MAX + 1)
+
+_Static_assert(ESPNOW_PKT_POOL_MAX % 32 == 0, "the free bitmap is made of whole words");
+_Static_assert((1ULL << (8 * sizeof(((espnow_config_t *)0)->qsize))) <= ESPNOW_PKT_POOL_MAX,
+               "every qsize must fit in the packet pool");
+
 typedef enum {
     ESPNOW_EVENT_SEND_ACK,
     ESPNOW_EVENT_RECV_ACK,
@@ -123,10 +198,33 @@ static uint32_t g_buffered_num;
 static uint8_t g_espnow_sec_key[APP_KEY_LEN] = {0}, g_espnow_dec_key[APP_KEY_LEN] = {0};
 static bool g_read_from_nvs = true, g_read_dec_from_nvs = true;
 
-static struct {
-    uint8_t type;
+/**
+ * @brief A frame received recently
+ */
+typedef struct {
+    uint8_t src_addr[6];
     uint16_t magic;
-} __attribute__((packed)) g_msg_magic_cache[ESPNOW_MSG_CACHE] = {0}, g_msg_magic_sec_cache[ESPNOW_MSG_CACHE] = {0};
+    uint8_t type;                       /**< Data type, bit 7 is set for secured frames */
+    uint16_t crc;                       /**< Of the payload, tells apart frames that drew the same magic */
+    TickType_t ticks;
+} espnow_msg_cache_entry_t;
+
+/**
+ * @brief Frames received in the last CONFIG_ESPNOW_MSG_CACHE_TIMEOUT, to drop their copies
+ *
+ * entry is a ring in the order of arrival, so expired frames are always at head.
+ * slot is a linear probing hash index into it: 0 is empty, n refers to entry[n - 1].
+ * Only the Wi-Fi task touches it.
+ */
+static struct {
+    espnow_msg_cache_entry_t entry[ESPNOW_MSG_CACHE_ENTRIES];
+    uint16_t slot[ESPNOW_MSG_CACHE_SLOTS];
+    uint16_t head;
+    uint16_t count;
+    espnow_msg_cache_stats_t stats;
+    uint32_t warned_evicted;            /**< stats.evicted when the last warning was logged */
+    TickType_t warned_ticks;
+} g_msg_cache;
 
 static espnow_addr_t ESPNOW_ADDR_SELF       = {0};
 const espnow_addr_t ESPNOW_ADDR_NONE        = {0};
@@ -134,7 +232,11 @@ const espnow_addr_t ESPNOW_ADDR_BROADCAST   = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0XF
 const espnow_group_t ESPNOW_ADDR_GROUP_OTA  =  {'O', 'T', 'A', 0x0, 0x0, 0x0};
 const espnow_group_t ESPNOW_ADDR_GROUP_PROV = {'P', 'R', 'O', 'V', 0x0, 0x0};
 const espnow_group_t ESPNOW_ADDR_GROUP_SEC = {'S', 'E', 'C', 0x0, 0x0, 0x0};
-static uint8_t g_msg_magic_cache_next = 0;
+static uint16_t g_msg_id = 0;
+static espnow_msg_reassembly_t g_msg_reassembly[CONFIG_ESPNOW_MSG_REASSEMBLY_NUM];
+static size_t g_msg_reassembly_bytes = 0;   /**< Held by the buffers of g_msg_reassembly */
+static uint16_t g_msg_oversize_id = 0;      /**< Last message refused for its size, logged once */
+static espnow_addr_t g_msg_oversize_addr = {0};
 static espnow_frame_head_t g_espnow_frame_head_default = ESPNOW_FRAME_CONFIG_DEFAULT();
 
 wifi_country_t g_self_country = {0};
@@ -149,13 +251,175 @@ typedef struct espnow_recv_handle {
 /* Keep the type order same with espnow_data_type_t */
 static espnow_recv_handle_t g_recv_handle[ESPNOW_DATA_TYPE_MAX];
 
+static esp_err_t radio_wifi_init(void *ctx, esp_now_send_cb_t send_cb, esp_now_recv_cb_t recv_cb, const uint8_t *pmk)
+{
+    esp_err_t ret = esp_now_init();
+    ESP_ERROR_RETURN(ret != ESP_OK, ret, "esp_now_init");
+    ret = esp_now_register_send_cb(send_cb);
+    ESP_ERROR_RETURN(ret != ESP_OK, ret, "esp_now_register_send_cb");
+    ret = esp_now_register_recv_cb(recv_cb);
+    ESP_ERROR_RETURN(ret != ESP_OK, ret, "esp_now_register_recv_cb");
+    return esp_now_set_pmk(pmk);
+}
+
+static esp_err_t radio_wifi_deinit(void *ctx)
+{
+    esp_err_t ret = esp_now_unregister_recv_cb();
+    ESP_ERROR_RETURN(ret != ESP_OK, ret, "esp_now_unregister_recv_cb");
+    ret = esp_now_unregister_send_cb();
+    ESP_ERROR_RETURN(ret != ESP_OK, ret, "esp_now_unregister_send_cb");
+    return esp_now_deinit();
+}
+
+static esp_err_t radio_wifi_send(void *ctx, const uint8_t *peer_addr, const uint8_t *data, size_t len)
+{
+    return esp_now_send(peer_addr, data, len);
+}
+
+static esp_err_t radio_wifi_add_peer(void *ctx, const esp_now_peer_info_t *peer)
+{
+    return esp_now_add_peer(peer);
+}
+
+static esp_err_t radio_wifi_del_peer(void *ctx, const uint8_t *peer_addr)
+{
+    return esp_now_del_peer(peer_addr);
+}
+
+static bool radio_wifi_is_peer_exist(void *ctx, const uint8_t *peer_addr)
+{
+    return esp_now_is_peer_exist(peer_addr);
+}
+
+static esp_err_t radio_wifi_get_channel(void *ctx, uint8_t *primary, wifi_second_chan_t *second)
+{
+    return esp_wifi_get_channel(primary, second);
+}
+
+static esp_err_t radio_wifi_set_channel(void *ctx, uint8_t primary, wifi_second_chan_t second)
+{
+    return esp_wifi_set_channel(primary, second);
+}
+
+static esp_err_t radio_wifi_get_country(void *ctx, wifi_country_t *country)
+{
+    return esp_wifi_get_country(country);
+}
+
+static esp_err_t radio_wifi_get_mac(void *ctx, uint8_t mac[ESPNOW_ADDR_LEN])
+{
+    return esp_wifi_get_mac(ESP_IF_WIFI_STA, mac);
+}
+
+static const espnow_radio_t g_radio_wifi = {
+    .init = radio_wifi_init,
+    .deinit = radio_wifi_deinit,
+    .send = radio_wifi_send,
+    .add_peer = radio_wifi_add_peer,
+    .del_peer = radio_wifi_del_peer,
+    .is_peer_exist = radio_wifi_is_peer_exist,
+    .get_channel = radio_wifi_get_channel,
+    .set_channel = radio_wifi_set_channel,
+    .get_country = radio_wifi_get_country,
+    .get_mac = radio_wifi_get_mac,
+};
+
+static const espnow_radio_t *g_radio = &g_radio_wifi;
+static void *g_radio_ctx = NULL;
+
+/**
+ * Received frames and the ACKs sent for them live in a fixed pool of slots
+ * taken in the receive callback, so the wifi task never touches the heap.
+ * A set bit in g_pkt_free marks a free slot. A slot is shared by every event
+ * queued for it, a frame that is both delivered and forwarded is copied
+ * once, and goes back to the pool when its last event is done with it.
+ */
+static uint8_t *g_pkt_pool = NULL;
+static size_t g_pkt_pool_num;
+static _Atomic uint32_t g_pkt_free[ESPNOW_PKT_POOL_MAX / 32];
+static _Atomic uint8_t g_pkt_refs[ESPNOW_PKT_POOL_MAX];
+static _Atomic uint32_t g_pkt_dropped;
+
+static esp_err_t espnow_pkt_pool_create(size_t num)
+{
+    ESP_PARAM_CHECK(num > 0 && num <= ESPNOW_PKT_POOL_MAX);
+
+    g_pkt_pool = ESP_MALLOC(num * ESPNOW_PKT_SLOT_SIZE);
+    ESP_ERROR_RETURN(!g_pkt_pool, ESP_ERR_NO_MEM, "Create espnow packet pool fail");
+
+    g_pkt_pool_num = num;
+    atomic_store(&g_pkt_dropped, 0);
+
+    for (size_t i = 0; i < ESPNOW_PKT_POOL_MAX / 32; ++i) {
+        size_t bits = num > i * 32 ? MIN(num - i * 32, 32) : 0;
+        atomic_store(&g_pkt_free[i], bits == 32 ? UINT32_MAX : (1UL << bits) - 1);
+    }
+
+    return ESP_OK;
+}
+
+static void espnow_pkt_pool_delete(void)
+{
+    for (size_t i = 0; i < ESPNOW_PKT_POOL_MAX / 32; ++i) {
+        atomic_store(&g_pkt_free[i], 0);
+    }
+
+    ESP_FREE(g_pkt_pool);
+    g_pkt_pool = NULL;
+    g_pkt_pool_num = 0;
+}
+
+static espnow_pkt_t *espnow_pkt_alloc(void)
+{
+    for (size_t i = 0; i < ESPNOW_PKT_POOL_MAX / 32; ++i) {
+        uint32_t mask = atomic_load(&g_pkt_free[i]);
+
+        while (mask) {
+            uint32_t bit = mask & -mask;
+
+            if (atomic_compare_exchange_weak(&g_pkt_free[i], &mask, mask & ~bit)) {
+                size_t index = i * 32 + __builtin_ctz(bit);
+                atomic_store(&g_pkt_refs[index], 1);
+                return (espnow_pkt_t *)(g_pkt_pool + index * ESPNOW_PKT_SLOT_SIZE);
+            }
+        }
+    }
+
+    atomic_fetch_add(&g_pkt_dropped, 1);
+    return NULL;
+}
+
+/* ptr may point anywhere inside the slot, e.g. at the espnow_data_t of a packet */
+static size_t espnow_pkt_index(const void *ptr)
+{
+    return ((const uint8_t *)ptr - g_pkt_pool) / ESPNOW_PKT_SLOT_SIZE;
+}
+
+static void espnow_pkt_ref(const void *ptr)
+{
+    atomic_fetch_add(&g_pkt_refs[espnow_pkt_index(ptr)], 1);
+}
+
+static void espnow_pkt_release(const void *ptr)
+{
+    if (!ptr) {
+        return;
+    }
+
+    size_t index = espnow_pkt_index(ptr);
+
+    if (atomic_fetch_sub(&g_pkt_refs[index], 1) == 1) {
+        atomic_fetch_or(&g_pkt_free[index / 32], 1UL << (index % 32));
+    }
+}
+
 static bool queue_over_write(espnow_msg_id_t msg_id, const void *const data, size_t data_len, void *arg, TickType_t xTicksToWait)
 {
     if (msg_id == ESPNOW_EVENT_RECV_ACK) {
         if (!g_ack_queue) {
             return false;
         }
-        return xQueueSend(g_ack_queue, &data, xTicksToWait);
+        return xQueueSend(g_ack_queue, data, xTicksToWait);
     } else {
         if (!g_espnow_queue) {
             return false;
@@ -172,6 +436,164 @@ static bool queue_over_write(espnow_msg_id_t msg_id, const void *const data, siz
     }
 }
 
+static bool espnow_recv_need_forward(const espnow_data_t *espnow_data, const wifi_pkt_rx_ctrl_t *rx_ctrl)
+{
+    const espnow_frame_head_t *frame_head = &espnow_data->frame_head;
+
+    return g_espnow_config->forward_enable && frame_head->forward_ttl > 0 && frame_head->broadcast
+           && frame_head->forward_rssi <= rx_ctrl->rssi && !ESPNOW_ADDR_IS_SELF(espnow_data->dest_addr)
+           && !ESPNOW_ADDR_IS_SELF(espnow_data->src_addr);
+}
+
+/**
+ * @brief Copies a received frame into a pool slot, prepared for forwarding if it will be
+ */
+static espnow_pkt_t *espnow_recv_pkt_copy(const espnow_data_t *espnow_data, size_t size, const wifi_pkt_rx_ctrl_t *rx_ctrl)
+{
+    espnow_pkt_t *q_data = espnow_pkt_alloc();
+
+    if (!q_data) {
+        ESP_LOGD(TAG, "[%s, %d] Packet pool exhausted, dropped: %" PRIu32, __func__, __LINE__, atomic_load(&g_pkt_dropped));
+        return NULL;
+    }
+
+    memcpy(&q_data->rx_ctrl, rx_ctrl, sizeof(wifi_pkt_rx_ctrl_t));
+    memcpy(&q_data->data, espnow_data, size);
+
+    if (espnow_recv_need_forward(espnow_data, rx_ctrl)
+            && espnow_data->frame_head.forward_ttl != ESPNOW_FORWARD_MAX_COUNT) {
+        q_data->data.frame_head.forward_ttl--;
+    }
+
+    return q_data;
+}
+
+static size_t espnow_msg_cache_hash(const uint8_t *src_addr, uint8_t type, uint16_t magic)
+{
+    uint32_t hash = (uint32_t)src_addr[2] << 24 | src_addr[3] << 16 | src_addr[4] << 8 | src_addr[5];
+
+    hash ^= ((uint32_t)magic << 16 | type << 8 | src_addr[1]) * 0x9E3779B1;
+    hash ^= hash >> 16;
+    hash *= 0x85EBCA6B;
+    hash ^= hash >> 13;
+
+    return hash % ESPNOW_MSG_CACHE_SLOTS;
+}
+
+/**
+ * @brief Slot referring to the frame, or the empty slot where it would go
+ */
+static size_t espnow_msg_cache_probe(const uint8_t *src_addr, uint8_t type, uint16_t magic, uint16_t crc)
+{
+    size_t slot = espnow_msg_cache_hash(src_addr, type, magic);
+
+    for (; g_msg_cache.slot[slot]; slot = (slot + 1) % ESPNOW_MSG_CACHE_SLOTS) {
+        const espnow_msg_cache_entry_t *entry = g_msg_cache.entry + g_msg_cache.slot[slot] - 1;
+
+        if (entry->magic == magic && entry->crc == crc && entry->type == type
+                && ESPNOW_ADDR_IS_EQUAL(entry->src_addr, src_addr)) {
+            break;
+        }
+    }
+
+    return slot;
+}
+
+/**
+ * @brief Forgets the oldest frame
+ */
+static void espnow_msg_cache_pop(void)
+{
+    const espnow_msg_cache_entry_t *oldest = g_msg_cache.entry + g_msg_cache.head;
+    size_t hole = espnow_msg_cache_probe(oldest->src_addr, oldest->type, oldest->magic, oldest->crc);
+
+    /**< Shift later entries of the probe sequence back into the hole instead of leaving a tombstone */
+    for (size_t next = (hole + 1) % ESPNOW_MSG_CACHE_SLOTS; g_msg_cache.slot[next];
+            next = (next + 1) % ESPNOW_MSG_CACHE_SLOTS) {
+        const espnow_msg_cache_entry_t *entry = g_msg_cache.entry + g_msg_cache.slot[next] - 1;
+        size_t home = espnow_msg_cache_hash(entry->src_addr, entry->type, entry->magic);
+
+        /**< An entry may only move if the hole is not before its home slot */
+        if (hole < next ? (home <= hole || home > next) : (home <= hole && home > next)) {
+            g_msg_cache.slot[hole] = g_msg_cache.slot[next];
+            hole = next;
+        }
+    }
+
+    g_msg_cache.slot[hole] = 0;
+    g_msg_cache.head = (g_msg_cache.head + 1) % ESPNOW_MSG_CACHE_ENTRIES;
+    g_msg_cache.count--;
+}
+
+static void espnow_msg_cache_expire(TickType_t now)
+{
+    while (g_msg_cache.count
+            && now - g_msg_cache.entry[g_msg_cache.head].ticks > pdMS_TO_TICKS(CONFIG_ESPNOW_MSG_CACHE_TIMEOUT)) {
+        espnow_msg_cache_pop();
+    }
+}
+
+static bool espnow_msg_cache_find(const uint8_t *src_addr, uint8_t type, uint16_t magic, uint16_t crc)
+{
+    espnow_msg_cache_expire(xTaskGetTickCount());
+    g_msg_cache.stats.lookup++;
+
+    if (!g_msg_cache.slot[espnow_msg_cache_probe(src_addr, type, magic, crc)]) {
+        return false;
+    }
+
+    g_msg_cache.stats.hit++;
+    return true;
+}
+
+static void espnow_msg_cache_add(const uint8_t *src_addr, uint8_t type, uint16_t magic, uint16_t crc)
+{
+    TickType_t now = xTaskGetTickCount();
+
+    espnow_msg_cache_expire(now);
+
+    if (g_msg_cache.count == ESPNOW_MSG_CACHE_ENTRIES) {
+        /**< Expired frames are gone already, the oldest is still live. Warn at most once per timeout. */
+        if (!g_msg_cache.stats.evicted
+                || now - g_msg_cache.warned_ticks > pdMS_TO_TICKS(CONFIG_ESPNOW_MSG_CACHE_TIMEOUT)) {
+            ESP_LOGW(TAG, "Duplicate cache full, forgot a frame received %d ms ago, %d since the last warning",
+                     pdTICKS_TO_MS(now - g_msg_cache.entry[g_msg_cache.head].ticks),
+                     g_msg_cache.stats.evicted - g_msg_cache.warned_evicted + 1);
+            g_msg_cache.warned_evicted = g_msg_cache.stats.evicted + 1;
+            g_msg_cache.warned_ticks = now;
+        }
+
+        g_msg_cache.stats.evicted++;
+        espnow_msg_cache_pop();
+    }
+
+    size_t slot = espnow_msg_cache_probe(src_addr, type, magic, crc);
+
+    if (g_msg_cache.slot[slot]) {
+        return;
+    }
+
+    size_t index = (g_msg_cache.head + g_msg_cache.count) % ESPNOW_MSG_CACHE_ENTRIES;
+    espnow_msg_cache_entry_t *entry = g_msg_cache.entry + index;
+
+    memcpy(entry->src_addr, src_addr, sizeof(entry->src_addr));
+    entry->type = type;
+    entry->magic = magic;
+    entry->crc = crc;
+    entry->ticks = now;
+    g_msg_cache.slot[slot] = index + 1;
+    g_msg_cache.count++;
+}
+
+esp_err_t espnow_get_msg_cache_stats(espnow_msg_cache_stats_t *stats)
+{
+    ESP_PARAM_CHECK(stats);
+
+    *stats = g_msg_cache.stats;
+
+    return ESP_OK;
+}
+
 /**< callback function of receiving ESPNOW data */
 #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 1)
 void espnow_recv_cb(const esp_now_recv_info_t *recv_info, const uint8_t *data, int size)
@@ -191,8 +613,8 @@ void espnow_recv_cb(const uint8_t *addr, const uint8_t *data, int size)
 #endif
 
     ESP_LOG_BUFFER_HEXDUMP(TAG, data, size, ESP_LOG_DEBUG);
-    ESP_LOGD(TAG, "[%s, %d], " MACSTR ", rssi: %d, size: %d, total: %d - %d, type: %d, addr: %02x, g_msg_magic_cache_next: %d",
-             __func__, __LINE__, MAC2STR(addr), rx_ctrl->rssi, size, espnow_data->size, sizeof(espnow_data_t), espnow_data->type, addr[5], g_msg_magic_cache_next);
+    ESP_LOGD(TAG, "[%s, %d], " MACSTR ", rssi: %d, size: %d, total: %d - %d, type: %d, addr: %02x, cached: %d",
+             __func__, __LINE__, MAC2STR(addr), rx_ctrl->rssi, size, espnow_data->size, sizeof(espnow_data_t), espnow_data->type, addr[5], g_msg_cache.count);
 
     /**< Filter ESP-NOW packets not generated by this project */
     if (espnow_data->version != ESPNOW_VERSION || (espnow_data->type >= ESPNOW_DATA_TYPE_MAX)
@@ -204,6 +626,8 @@ void espnow_recv_cb(const uint8_t *addr, const uint8_t *data, int size)
     }
 
     espnow_frame_head_t *frame_head = &espnow_data->frame_head;
+    espnow_pkt_t *q_data = NULL;
+    uint8_t cache_type = espnow_data->type | (frame_head->security ? BIT(7) : 0);
 
     /**< Data does not need to be forwarded */
     if (!g_recv_handle[espnow_data->type].enable
@@ -232,10 +656,14 @@ void espnow_recv_cb(const uint8_t *addr, const uint8_t *data, int size)
     if (g_recv_handle[espnow_data->type].enable
             && espnow_data->type != ESPNOW_DATA_TYPE_ACK && espnow_data->type != ESPNOW_DATA_TYPE_GROUP
             && frame_head->ack && ESPNOW_ADDR_IS_SELF(espnow_data->dest_addr)) {
-        espnow_data_t *ack_data = ESP_CALLOC(1, sizeof(espnow_data_t));
-        if (!ack_data) {
+        espnow_pkt_t *ack_pkt = espnow_pkt_alloc();
+        if (!ack_pkt) {
+            ESP_LOGD(TAG, "[%s, %d] Packet pool exhausted, dropped: %" PRIu32, __func__, __LINE__, atomic_load(&g_pkt_dropped));
             return;
         }
+
+        espnow_data_t *ack_data = &ack_pkt->data;
+        memset(ack_data, 0, sizeof(espnow_data_t));
         ack_data->version = ESPNOW_VERSION;
         ack_data->type  = ESPNOW_DATA_TYPE_ACK;
         ack_data->size  = 0;
@@ -246,28 +674,33 @@ void espnow_recv_cb(const uint8_t *addr, const uint8_t *data, int size)
         ack_data->frame_head.retransmit_count = 1;
         ack_data->frame_head.broadcast = 1;
 
-        if (!g_espnow_queue || queue_over_write(ESPNOW_EVENT_SEND_ACK, ack_data, sizeof(espnow_data_t), NULL, g_espnow_config->send_max_timeout) != pdPASS) {
+        if (!g_espnow_queue || queue_over_write(ESPNOW_EVENT_SEND_ACK, ack_data, sizeof(espnow_data_t), NULL, 0) != pdPASS) {
             ESP_LOGW(TAG, "[%s, %d] Send event queue failed", __func__, __LINE__);
-            ESP_FREE(ack_data);
+            espnow_pkt_release(ack_pkt);
         }
     }
 
-    if (!frame_head->security) {
-        for (size_t i = 0, index = g_msg_magic_cache_next; i < ESPNOW_MSG_CACHE;
-                i++, index = (g_msg_magic_cache_next + i) % ESPNOW_MSG_CACHE) {
-            if (g_msg_magic_cache[index].type == espnow_data->type
-                    && g_msg_magic_cache[index].magic == frame_head->magic) {
-                return ;
-            }
-        }
-    } else {
-        for (size_t i = 0, index = g_msg_magic_cache_next; i < ESPNOW_MSG_CACHE;
-                i++, index = (g_msg_magic_cache_next + i) % ESPNOW_MSG_CACHE) {
-            if (g_msg_magic_sec_cache[index].type == espnow_data->type
-                    && g_msg_magic_sec_cache[index].magic == frame_head->magic) {
-                return ;
-            }
+    /**< An ACK to this node only wakes its sender and is not remembered: it has the magic of the
+         frame it acknowledges and no payload, so ACKs of frames that drew the same magic look alike */
+    if (espnow_data->type == ESPNOW_DATA_TYPE_ACK && g_recv_handle[ESPNOW_DATA_TYPE_ACK].enable
+            && ESPNOW_ADDR_IS_SELF(espnow_data->dest_addr)) {
+        ESP_LOGD(TAG, ">[%s, %d]: broadcast: %d, dest_addr: " MACSTR, __func__, __LINE__, frame_head->broadcast,
+                 MAC2STR(espnow_data->dest_addr));
+
+        uint32_t magic = frame_head->magic;
+
+        if (!g_ack_queue || queue_over_write(ESPNOW_EVENT_RECV_ACK, &magic, sizeof(uint32_t), NULL, 0) != pdPASS) {
+            ESP_LOGW(TAG, "[%s, %d] Send event queue failed", __func__, __LINE__);
         }
+
+        return;
+    }
+
+    /**< Copies carry the same payload, forwarding only changes the frame head */
+    uint16_t cache_crc = esp_crc16_le(UINT16_MAX, espnow_data->payload, espnow_data->size);
+
+    if (espnow_msg_cache_find(espnow_data->src_addr, cache_type, frame_head->magic, cache_crc)) {
+        return ;
     }
 #if CONFIG_IDF_TARGET_ESP32C6
     ESP_LOGD(TAG, "[%s, %d]: " MACSTR ", rssi: %d, channel: %d/%d, size: %d, %s, magic: 0x%x, ack: %d",
@@ -286,28 +719,13 @@ void espnow_recv_cb(const uint8_t *addr, const uint8_t *data, int size)
     }
 
     if (espnow_data->type == ESPNOW_DATA_TYPE_ACK) {
-        if (!ESPNOW_ADDR_IS_SELF(espnow_data->dest_addr)) {
+        /**< ACKs to this node were taken before the duplicate check */
 #ifdef CONFIG_ESPNOW_DATA_FAST_ACK
-            if (g_recv_handle[ESPNOW_DATA_TYPE_ACK].handle) {
-                g_recv_handle[ESPNOW_DATA_TYPE_ACK].handle(espnow_data->src_addr, (void *)frame_head, sizeof(espnow_frame_head_t), NULL);
-            }
-#endif
-            goto FORWARD_DATA;
+        if (g_recv_handle[ESPNOW_DATA_TYPE_ACK].handle) {
+            g_recv_handle[ESPNOW_DATA_TYPE_ACK].handle(espnow_data->src_addr, (void *)frame_head, sizeof(espnow_frame_head_t), NULL);
         }
-
-        ESP_LOGD(TAG, ">[%s, %d]: broadcast: %d, dest_addr: " MACSTR, __func__, __LINE__, frame_head->broadcast,
-                 MAC2STR(espnow_data->dest_addr));
-
-        uint32_t *magic = ESP_MALLOC(sizeof(uint32_t));
-        *magic = frame_head->magic;
-
-        if (!g_ack_queue || queue_over_write(ESPNOW_EVENT_RECV_ACK, magic, sizeof(uint32_t), NULL, g_espnow_config->send_max_timeout) != pdPASS) {
-            ESP_LOGW(TAG, "[%s, %d] Send event queue failed", __func__, __LINE__);
-            ESP_FREE(magic);
-            return ;
-        };
-
-        goto EXIT;
+#endif
+        goto FORWARD_DATA;
     } else if (espnow_data->type == ESPNOW_DATA_TYPE_GROUP) {
         espnow_group_info_t *group_info = (espnow_group_info_t *) espnow_data->payload;
         bool set_group_flag = false;
@@ -350,54 +768,42 @@ void espnow_recv_cb(const uint8_t *addr, const uint8_t *data, int size)
             goto FORWARD_DATA;
         }
 
-        espnow_pkt_t *q_data = ESP_MALLOC(sizeof(espnow_pkt_t) + espnow_data->size);
-        memcpy(&q_data->rx_ctrl, rx_ctrl, sizeof(wifi_pkt_rx_ctrl_t));
-        memcpy(&q_data->data, espnow_data, size);
+        q_data = espnow_recv_pkt_copy(espnow_data, size, rx_ctrl);
+        if (!q_data) {
+            return ;
+        }
 
         if (frame_head->channel && frame_head->channel != ESPNOW_CHANNEL_ALL) {
             q_data->rx_ctrl.channel = frame_head->channel;
         }
 
-        if (queue_over_write(ESPNOW_EVENT_RECEIVE, q_data, sizeof(espnow_pkt_t) + espnow_data->size, NULL, g_espnow_config->send_max_timeout) != pdPASS) {
+        if (queue_over_write(ESPNOW_EVENT_RECEIVE, q_data, sizeof(espnow_pkt_t) + espnow_data->size, NULL, 0) != pdPASS) {
             ESP_LOGW(TAG, "[%s, %d] Send event queue failed", __func__, __LINE__);
-            ESP_FREE(q_data);
+            espnow_pkt_release(q_data);
             return ;
         }
     }
 
 FORWARD_DATA:
 
-    if (g_espnow_config->forward_enable && frame_head->forward_ttl > 0 && frame_head->broadcast
-            && frame_head->forward_rssi <= rx_ctrl->rssi && !ESPNOW_ADDR_IS_SELF(espnow_data->dest_addr)
-            && !ESPNOW_ADDR_IS_SELF(espnow_data->src_addr)) {
-        espnow_data_t *q_data = ESP_MALLOC(size);
-
-        if (!q_data) {
+    if (espnow_recv_need_forward(espnow_data, rx_ctrl)) {
+        /**< The copy queued for the receive handler already has the TTL decremented */
+        if (q_data) {
+            espnow_pkt_ref(q_data);
+        } else if (!(q_data = espnow_recv_pkt_copy(espnow_data, size, rx_ctrl))) {
             return ;
         }
 
-        memcpy(q_data, espnow_data, size);
-
-        if (frame_head->forward_ttl != ESPNOW_FORWARD_MAX_COUNT) {
-            q_data->frame_head.forward_ttl--;
-        }
-
-        if (!g_espnow_queue || queue_over_write(ESPNOW_EVENT_FORWARD, q_data, size, NULL, g_espnow_config->send_max_timeout) != pdPASS) {
+        if (!g_espnow_queue || queue_over_write(ESPNOW_EVENT_FORWARD, &q_data->data, size, NULL, 0) != pdPASS) {
             ESP_LOGW(TAG, "[%s, %d] Send event queue failed", __func__, __LINE__);
-            ESP_FREE(q_data);
+            espnow_pkt_release(q_data);
             return ;
         }
-    }
 
-EXIT:
-    g_msg_magic_cache_next = (g_msg_magic_cache_next + 1) % ESPNOW_MSG_CACHE;
-    if (!frame_head->security) {
-        g_msg_magic_cache[g_msg_magic_cache_next].type  = espnow_data->type;
-        g_msg_magic_cache[g_msg_magic_cache_next].magic = frame_head->magic;
-    } else {
-        g_msg_magic_sec_cache[g_msg_magic_cache_next].type  = espnow_data->type;
-        g_msg_magic_sec_cache[g_msg_magic_cache_next].magic = frame_head->magic;
+        g_msg_cache.stats.forwarded++;
     }
+
+    espnow_msg_cache_add(espnow_data->src_addr, cache_type, frame_head->magic, cache_crc);
 }
 
 /**< callback function of sending ESPNOW data */
@@ -424,7 +830,7 @@ esp_err_t espnow_add_peer(const espnow_addr_t addr, const uint8_t *lmk)
     ESP_PARAM_CHECK(addr);
 
     /**< If peer exists, delete a peer from peer list */
-    if (esp_now_is_peer_exist(addr)) {
+    if (g_radio->is_peer_exist(g_radio_ctx, addr)) {
         return ESP_OK;
     }
 
@@ -441,7 +847,7 @@ esp_err_t espnow_add_peer(const espnow_addr_t addr, const uint8_t *lmk)
     memcpy(peer.peer_addr, addr, 6);
 
     /**< Add a peer to peer list */
-    ret = esp_now_add_peer(&peer);
+    ret = g_radio->add_peer(g_radio_ctx, &peer);
     ESP_ERROR_RETURN(ret != ESP_OK, ret, "Add a peer to peer list fail");
 
     return ESP_OK;
@@ -454,8 +860,8 @@ esp_err_t espnow_del_peer(const espnow_addr_t addr)
     esp_err_t ret = ESP_OK;
 
     /**< If peer exists, delete a peer from peer list */
-    if (esp_now_is_peer_exist(addr) && !ESPNOW_ADDR_IS_BROADCAST(addr)) {
-        ret = esp_now_del_peer(addr);
+    if (g_radio->is_peer_exist(g_radio_ctx, addr) && !ESPNOW_ADDR_IS_BROADCAST(addr)) {
+        ret = g_radio->del_peer(g_radio_ctx, addr);
         ESP_ERROR_RETURN(ret != ESP_OK, ret, "esp_now_del_peer fail, ret: %d", ret);
     }
 
@@ -493,7 +899,7 @@ static esp_err_t espnow_send_process(int count, espnow_data_t *espnow_data, uint
     }
 
     if (frame_head->ack && !ESPNOW_ADDR_IS_BROADCAST(espnow_data->dest_addr) && ack) {
-        uint32_t *ack_magic = NULL;
+        uint32_t ack_magic = 0;
 
         /* retry backoff time (2,4,8,16,32,64,100,100,...)ms */
         uint32_t delay_ms = (count < 6 ? 1 << count : 50) * SEND_DELAY_UNIT_MSECS;
@@ -501,14 +907,11 @@ static esp_err_t espnow_send_process(int count, espnow_data_t *espnow_data, uint
         do {
             vTaskDelay(pdMS_TO_TICKS(SEND_DELAY_UNIT_MSECS));
             while (g_ack_queue && xQueueReceive(g_ack_queue, &ack_magic, 0) == pdPASS) {
-                if (*ack_magic == frame_head->magic) {
+                if (ack_magic == frame_head->magic) {
                     espnow_data->frame_head.ack = false;
-                    ESP_FREE(ack_magic);
                     *ack = true;
                     return ESP_OK;
                 }
-
-                ESP_FREE(ack_magic);
             }
 
             delay_ms -= SEND_DELAY_UNIT_MSECS;
@@ -520,67 +923,62 @@ static esp_err_t espnow_send_process(int count, espnow_data_t *espnow_data, uint
     return ESP_OK;
 }
 
-esp_err_t espnow_send(espnow_data_type_t type, const espnow_addr_t dest_addr, const void *data,
-                      size_t size, const espnow_frame_head_t *data_head, TickType_t wait_ticks)
+static void espnow_iov_gather(uint8_t *dst, const espnow_iov_t *iov, size_t iov_num, size_t size)
 {
-    ESP_PARAM_CHECK(dest_addr);
-    ESP_PARAM_CHECK(data);
-    ESP_PARAM_CHECK(type < ESPNOW_DATA_TYPE_MAX);
-    ESP_PARAM_CHECK(size <= ESPNOW_DATA_LEN);
-    ESP_ERROR_RETURN(!g_espnow_config, ESP_ERR_ESPNOW_NOT_INIT, "ESPNOW is not initialized");
+    for (size_t i = 0; i < iov_num && size > 0; ++i) {
+        size_t n = MIN(iov[i].size, size);
+        memcpy(dst, iov[i].data, n);
+        dst += n;
+        size -= n;
+    }
+}
+
+/**
+ * @brief Encrypts the payload of a frame in place, the nonce goes after the tag
+ *
+ * @attention g_espnow_sec is shared by every sending task, call with g_send_lock held
+ */
+static esp_err_t espnow_frame_encrypt(espnow_data_t *espnow_data, size_t size)
+{
+    ESP_ERROR_RETURN(!(g_espnow_sec && g_espnow_sec->state == ESPNOW_SEC_OVER), ESP_FAIL, "Security key is not set");
+    ESP_ERROR_RETURN(size + g_espnow_sec->tag_len + IV_LEN > ESPNOW_PAYLOAD_LEN, ESP_ERR_INVALID_SIZE,
+                     "Secured payload too long, size: %d", size);
+
+    /**< The key is scheduled once by espnow_set_key(), each frame only draws a nonce */
+    uint8_t *iv = espnow_data->payload + size + g_espnow_sec->tag_len;
+    esp_fill_random(iv, IV_LEN);
+
+    esp_err_t ret = espnow_sec_auth_encrypt_iv(g_espnow_sec, iv, espnow_data->payload, size, espnow_data->payload, g_espnow_sec->tag_len);
+    ESP_ERROR_RETURN(ret != ESP_OK, ret, "Security encrypt return error");
+    espnow_data->size = size + g_espnow_sec->tag_len + IV_LEN;
+
+    return ESP_OK;
+}
 
+/**
+ * @brief Sends one frame whose payload is gathered from iov, size bytes in total
+ */
+static esp_err_t espnow_send_iov(espnow_data_type_t type, const espnow_addr_t dest_addr, const espnow_iov_t *iov,
+                                 size_t iov_num, size_t size, bool fragment, const espnow_frame_head_t *data_head,
+                                 TickType_t wait_ticks)
+{
     esp_err_t ret             = ESP_FAIL;
     TickType_t write_ticks    = 0;
     uint32_t start_ticks      = xTaskGetTickCount();
     uint8_t primary           = 0;
     wifi_second_chan_t second = 0;
     espnow_frame_head_t *frame_head = NULL;
-    espnow_data_t *espnow_data = NULL;
-    bool enc = false;
-
-    if (g_espnow_config->sec_enable && (data_head ? data_head->security : g_espnow_frame_head_default.security)
-        && type != ESPNOW_DATA_TYPE_ACK && type != ESPNOW_DATA_TYPE_FORWARD
-        && type != ESPNOW_DATA_TYPE_SECURITY_STATUS && type != ESPNOW_DATA_TYPE_SECURITY) {
-        ESP_ERROR_RETURN(!(g_espnow_sec && g_espnow_sec->state == ESPNOW_SEC_OVER), ESP_FAIL, "Security key is not set");
-        size_t enc_len = 0;
-        espnow_data = ESP_MALLOC(sizeof(espnow_data_t) + size + g_espnow_sec->tag_len + IV_LEN);
-        if (!espnow_data) {
-            ESP_LOGE(TAG, "Not enough memory!");
-            return ret;
-        }
-        uint8_t key_info[APP_KEY_LEN];
-        uint8_t iv_info[IV_LEN];
-
-        ret = espnow_get_key(key_info);
-        if (ret) {
-            ESP_FREE(espnow_data);
-            ESP_LOGE(TAG, "Get security key fail for encrypt, err_name: %s", esp_err_to_name(ret));
-            return ret;
-        }
-
-        esp_fill_random(iv_info, IV_LEN);
-        memcpy(key_info + KEY_LEN, iv_info, IV_LEN);
-        espnow_set_key(key_info);
-
-        ret = espnow_sec_auth_encrypt(g_espnow_sec, data, size, espnow_data->payload, size + g_espnow_sec->tag_len, &enc_len, g_espnow_sec->tag_len);
-        espnow_data->size = enc_len + IV_LEN;
-        if (ret == ESP_OK) {
-            enc = 1;
-            memcpy(espnow_data->payload + enc_len, iv_info, IV_LEN);
-        } else {
-            ESP_FREE(espnow_data);
-            ESP_LOGE(TAG, "Security encrypt return error");
-            return ret;
-        }
-    } else {
-        espnow_data = ESP_MALLOC(sizeof(espnow_data_t) + size);
-        if (!espnow_data) {
-            ESP_LOGE(TAG, "Not enough memory!");
-            return ret;
-        }
-        espnow_data->size = size;
-        memcpy(espnow_data->payload, data, size);
-    }
+    /**< The radio copies the frame, so it is built on the stack */
+    uint32_t frame[(sizeof(espnow_data_t) + ESPNOW_PAYLOAD_LEN + 3) / 4];
+    espnow_data_t *espnow_data = (espnow_data_t *)frame;
+    bool enc = g_espnow_config->sec_enable && (data_head ? data_head->security : g_espnow_frame_head_default.security)
+               && type != ESPNOW_DATA_TYPE_ACK && type != ESPNOW_DATA_TYPE_FORWARD
+               && type != ESPNOW_DATA_TYPE_SECURITY_STATUS && type != ESPNOW_DATA_TYPE_SECURITY;
+
+    /**< The plaintext is gathered here and encrypted in place once the lock is held */
+    ESP_ERROR_RETURN(size > ESPNOW_PAYLOAD_LEN, ESP_ERR_INVALID_SIZE, "Payload too long, size: %d", size);
+    espnow_data->size = size;
+    espnow_iov_gather(espnow_data->payload, iov, iov_num, size);
 
     if (data_head) {
         memcpy(&espnow_data->frame_head, data_head, sizeof(espnow_frame_head_t));
@@ -607,20 +1005,28 @@ esp_err_t espnow_send(espnow_data_type_t type, const espnow_addr_t dest_addr, co
 
     espnow_data->version = ESPNOW_VERSION;
     espnow_data->type = type;
+    espnow_data->fragment = fragment;
     memcpy(espnow_data->dest_addr, dest_addr, sizeof(espnow_data->dest_addr));
     memcpy(espnow_data->src_addr, ESPNOW_ADDR_SELF, sizeof(espnow_data->src_addr));
 
-    ESP_LOGD(TAG, "[%s, %d] addr: " MACSTR", size: %d, count: %d, rssi: %d, data: %s, magic: 0x%x",
-             __func__, __LINE__, MAC2STR(dest_addr), espnow_data->size, frame_head->retransmit_count,
-             frame_head->forward_rssi, espnow_data->payload, frame_head->magic);
-
     /**< Wait for other tasks to be sent before send ESP-NOW data */
     if (xSemaphoreTake(g_send_lock, pdMS_TO_TICKS(wait_ticks)) != pdPASS) {
-        ESP_FREE(espnow_data);
         return ESP_ERR_TIMEOUT;
     }
 
-    ret = esp_wifi_get_channel(&primary, &second);
+    if (enc) {
+        ret = espnow_frame_encrypt(espnow_data, size);
+        if (ret != ESP_OK) {
+            xSemaphoreGive(g_send_lock);
+            return ret;
+        }
+    }
+
+    ESP_LOGD(TAG, "[%s, %d] addr: " MACSTR", size: %d, count: %d, rssi: %d, data: %s, magic: 0x%x",
+             __func__, __LINE__, MAC2STR(dest_addr), espnow_data->size, frame_head->retransmit_count,
+             frame_head->forward_rssi, espnow_data->payload, frame_head->magic);
+
+    ret = g_radio->get_channel(g_radio_ctx, &primary, &second);
     ESP_ERROR_GOTO(ret != ESP_OK, EXIT, "esp_wifi_get_channel, err_name: %s", esp_err_to_name(ret));
 
     if (frame_head->channel == 0) {
@@ -630,7 +1036,7 @@ esp_err_t espnow_send(espnow_data_type_t type, const espnow_addr_t dest_addr, co
             ESP_ERROR_GOTO(frame_head->channel >= g_self_country.schan + g_self_country.nchan, EXIT,
                 "Can't set channel %d, not allowed in country %c%c%c.",
                 frame_head->channel, g_self_country.cc[0], g_self_country.cc[1], g_self_country.cc[2]);
-            ret = esp_wifi_set_channel(frame_head->channel, WIFI_SECOND_CHAN_NONE);
+            ret = g_radio->set_channel(g_radio_ctx, frame_head->channel, WIFI_SECOND_CHAN_NONE);
             ESP_ERROR_GOTO(ret != ESP_OK, EXIT, "esp_wifi_set_channel, err_name: %s", esp_err_to_name(ret));
         } else {
             ESP_LOGE(TAG, "Can't set channel %d, current is %d", frame_head->channel, primary);
@@ -646,7 +1052,7 @@ esp_err_t espnow_send(espnow_data_type_t type, const espnow_addr_t dest_addr, co
                 || (g_set_channel_flag && frame_head->channel == ESPNOW_CHANNEL_ALL && i < g_self_country.nchan); ++i) {
 
             if (g_set_channel_flag && frame_head->channel == ESPNOW_CHANNEL_ALL) {
-                esp_wifi_set_channel(g_self_country.schan + i, WIFI_SECOND_CHAN_NONE);
+                g_radio->set_channel(g_radio_ctx, g_self_country.schan + i, WIFI_SECOND_CHAN_NONE);
             }
 
             xEventGroupClearBits(g_event_group, SEND_CB_OK | SEND_CB_FAIL);
@@ -656,7 +1062,7 @@ esp_err_t espnow_send(espnow_data_type_t type, const espnow_addr_t dest_addr, co
             }
 
             do {
-                ret = esp_now_send(addr, (uint8_t *)espnow_data, espnow_data->size + sizeof(espnow_data_t));
+                ret = g_radio->send(g_radio_ctx, addr, (uint8_t *)espnow_data, espnow_data->size + sizeof(espnow_data_t));
 
                 if (ret == ESP_OK) {
                     bool ack = 0;
@@ -680,33 +1086,122 @@ EXIT:
 
 #ifdef CONFIG_ESPNOW_AUTO_RESTORE_CHANNEL
     if (g_set_channel_flag && frame_head->channel != primary) {
-        esp_wifi_set_channel(primary, second);
+        g_radio->set_channel(g_radio_ctx, primary, second);
     }
 #endif
 
     xSemaphoreGive(g_send_lock);
 
     if (frame_head->ack && !ESPNOW_ADDR_IS_BROADCAST(dest_addr)) {
-        uint32_t *ack_magic = NULL;
+        uint32_t ack_magic = 0;
         write_ticks = (wait_ticks == portMAX_DELAY) ? portMAX_DELAY :
                       xTaskGetTickCount() - start_ticks < wait_ticks ?
                       wait_ticks - (xTaskGetTickCount() - start_ticks) : 0;
 
         while (g_ack_queue && xQueueReceive(g_ack_queue, &ack_magic, MIN(write_ticks,
                              g_espnow_config->send_max_timeout)) == pdPASS) {
-            if (*ack_magic == frame_head->magic) {
-                ESP_FREE(espnow_data);
-                ESP_FREE(ack_magic);
+            if (ack_magic == frame_head->magic) {
                 return ESP_OK;
             }
-
-            ESP_FREE(ack_magic);
         }
 
         ret = ESP_ERR_WIFI_TIMEOUT;
     }
 
-    ESP_FREE(espnow_data);
+    return ret;
+}
+
+esp_err_t espnow_send(espnow_data_type_t type, const espnow_addr_t dest_addr, const void *data,
+                      size_t size, const espnow_frame_head_t *data_head, TickType_t wait_ticks)
+{
+    ESP_PARAM_CHECK(dest_addr);
+    ESP_PARAM_CHECK(data);
+    ESP_PARAM_CHECK(type < ESPNOW_DATA_TYPE_MAX);
+    ESP_PARAM_CHECK(size <= ESPNOW_MSG_MAX_LEN);
+    ESP_ERROR_RETURN(!g_espnow_config, ESP_ERR_ESPNOW_NOT_INIT, "ESPNOW is not initialized");
+
+    espnow_iov_t iov = {
+        .data = data,
+        .size = size,
+    };
+
+    if (size > ESPNOW_DATA_LEN) {
+        return espnow_send_msg(type, dest_addr, &iov, 1, data_head, wait_ticks);
+    }
+
+    return espnow_send_iov(type, dest_addr, &iov, 1, size, false, data_head, wait_ticks);
+}
+
+esp_err_t espnow_send_msg(espnow_data_type_t type, const espnow_addr_t dest_addr, const espnow_iov_t *iov,
+                          size_t iov_num, const espnow_frame_head_t *data_head, TickType_t wait_ticks)
+{
+    ESP_PARAM_CHECK(dest_addr);
+    ESP_PARAM_CHECK(iov && iov_num);
+    ESP_PARAM_CHECK(type < ESPNOW_DATA_TYPE_MAX && type != ESPNOW_DATA_TYPE_ACK);
+    ESP_ERROR_RETURN(!g_espnow_config, ESP_ERR_ESPNOW_NOT_INIT, "ESPNOW is not initialized");
+
+    esp_err_t ret = ESP_OK;
+    size_t size = 0;
+    uint32_t start_ticks = xTaskGetTickCount();
+    espnow_frame_head_t frame_head = data_head ? *data_head : g_espnow_frame_head_default;
+
+    for (size_t i = 0; i < iov_num; ++i) {
+        ESP_PARAM_CHECK(iov[i].data || !iov[i].size);
+        size += iov[i].size;
+    }
+
+    ESP_PARAM_CHECK(size <= ESPNOW_MSG_MAX_LEN);
+
+    /**< Each piece is the header followed by slices of the caller's buffers, nothing is copied before the frame */
+    espnow_iov_t *frag_iov = ESP_MALLOC((iov_num + 1) * sizeof(espnow_iov_t));
+    ESP_ERROR_RETURN(!frag_iov, ESP_ERR_NO_MEM, "Not enough memory!");
+
+    espnow_msg_frag_t frag = {
+        .id = g_msg_id++,
+        .size = size,
+    };
+    size_t frag_num = size ? (size + ESPNOW_MSG_FRAG_LEN - 1) / ESPNOW_MSG_FRAG_LEN : 1;
+    size_t iov_index = 0, iov_offset = 0;
+    uint16_t magic = frame_head.magic;
+
+    frag_iov[0].data = &frag;
+    frag_iov[0].size = sizeof(espnow_msg_frag_t);
+
+    for (; frag.index < frag_num; frag.index++) {
+        size_t frag_len = MIN(size - frag.index * ESPNOW_MSG_FRAG_LEN, ESPNOW_MSG_FRAG_LEN);
+        size_t frag_iov_num = 1;
+
+        for (size_t left = frag_len; left > 0; ++frag_iov_num) {
+            size_t n = MIN(left, iov[iov_index].size - iov_offset);
+
+            frag_iov[frag_iov_num].data = (const uint8_t *)iov[iov_index].data + iov_offset;
+            frag_iov[frag_iov_num].size = n;
+            left -= n;
+            iov_offset += n;
+
+            if (iov_offset == iov[iov_index].size) {
+                iov_index++;
+                iov_offset = 0;
+            }
+        }
+
+        while (iov_index < iov_num && iov_offset == iov[iov_index].size) {
+            iov_index++;
+            iov_offset = 0;
+        }
+
+        /**< A given magic is kept apart per piece, 0 draws a random one for each */
+        frame_head.magic = magic ? magic + frag.index : 0;
+
+        TickType_t write_ticks = (wait_ticks == portMAX_DELAY) ? portMAX_DELAY :
+                                 xTaskGetTickCount() - start_ticks < wait_ticks ?
+                                 wait_ticks - (xTaskGetTickCount() - start_ticks) : 0;
+        ret = espnow_send_iov(type, dest_addr, frag_iov, frag_iov_num, sizeof(espnow_msg_frag_t) + frag_len,
+                              true, &frame_head, write_ticks);
+        ESP_ERROR_BREAK(ret != ESP_OK, "<%s> Send piece %d of message %d", esp_err_to_name(ret), frag.index, frag.id);
+    }
+
+    ESP_FREE(frag_iov);
 
     return ret;
 }
@@ -740,14 +1235,14 @@ esp_err_t espnow_set_group(const uint8_t addrs_list[][ESPNOW_ADDR_LEN], size_t a
         frame_head->magic = esp_random();
     }
 
-    ret = esp_wifi_get_channel(&primary, &second);
+    ret = g_radio->get_channel(g_radio_ctx, &primary, &second);
     ESP_ERROR_GOTO(ret != ESP_OK, EXIT, "esp_wifi_get_channel, err_name: %s", esp_err_to_name(ret));
 
     if (frame_head->channel == 0) {
         frame_head->channel = primary;
     } else if (frame_head->channel > 0 && frame_head->channel < ESPNOW_CHANNEL_ALL && frame_head->channel != primary) {
         if (g_set_channel_flag) {
-            ret = esp_wifi_set_channel(frame_head->channel, WIFI_SECOND_CHAN_NONE);
+            ret = g_radio->set_channel(g_radio_ctx, frame_head->channel, WIFI_SECOND_CHAN_NONE);
             ESP_ERROR_GOTO(ret != ESP_OK, EXIT, "esp_wifi_set_channel, err_name: %s", esp_err_to_name(ret));
         } else {
             ESP_LOGE(TAG, "Can't set channel %d, current is %d", frame_head->channel, primary);
@@ -772,10 +1267,10 @@ esp_err_t espnow_set_group(const uint8_t addrs_list[][ESPNOW_ADDR_LEN], size_t a
                     || (frame_head->channel == ESPNOW_CHANNEL_ALL && i < g_self_country.nchan && g_set_channel_flag); ++i) {
 
                 if (frame_head->channel == ESPNOW_CHANNEL_ALL && g_set_channel_flag) {
-                    esp_wifi_set_channel(g_self_country.schan + i, WIFI_SECOND_CHAN_NONE);
+                    g_radio->set_channel(g_radio_ctx, g_self_country.schan + i, WIFI_SECOND_CHAN_NONE);
                 }
 
-                ret = esp_now_send(ESPNOW_ADDR_BROADCAST, (uint8_t *)espnow_data, espnow_data->size + sizeof(espnow_data_t));
+                ret = g_radio->send(g_radio_ctx, ESPNOW_ADDR_BROADCAST, (uint8_t *)espnow_data, espnow_data->size + sizeof(espnow_data_t));
 
                 if (ret == ESP_OK) {
                     TickType_t write_ticks = (wait_ticks == portMAX_DELAY) ? portMAX_DELAY :
@@ -793,13 +1288,114 @@ esp_err_t espnow_set_group(const uint8_t addrs_list[][ESPNOW_ADDR_LEN], size_t a
 EXIT:
 
     if (frame_head->channel != primary && g_set_channel_flag) {
-        esp_wifi_set_channel(primary, second);
+        g_radio->set_channel(g_radio_ctx, primary, second);
     }
 
     ESP_FREE(espnow_data);
     return ESP_OK;
 }
 
+static void espnow_msg_reassembly_free(espnow_msg_reassembly_t *msg)
+{
+    if (msg->data) {
+        g_msg_reassembly_bytes -= msg->size;
+        ESP_FREE(msg->data);
+    }
+}
+
+/**
+ * @brief Puts a piece of a message in place, the handler gets the whole message once every piece is in
+ */
+static esp_err_t espnow_msg_reassemble(const espnow_data_t *espnow_data, const uint8_t *data, size_t size,
+                                       wifi_pkt_rx_ctrl_t *rx_ctrl)
+{
+    const espnow_msg_frag_t *frag = (const espnow_msg_frag_t *)data;
+    espnow_msg_reassembly_t *msg = NULL;
+    espnow_msg_reassembly_t *free_msg = NULL;
+    TickType_t now = xTaskGetTickCount();
+
+    ESP_ERROR_RETURN(size < sizeof(espnow_msg_frag_t), ESP_ERR_INVALID_SIZE, "Message piece too short");
+    size -= sizeof(espnow_msg_frag_t);
+
+    size_t frag_num = frag->size ? (frag->size + ESPNOW_MSG_FRAG_LEN - 1) / ESPNOW_MSG_FRAG_LEN : 1;
+    size_t offset = frag->index * ESPNOW_MSG_FRAG_LEN;
+    ESP_ERROR_RETURN(frag->index >= frag_num || size != MIN(frag->size - offset, ESPNOW_MSG_FRAG_LEN),
+                     ESP_ERR_INVALID_SIZE, "Message piece %d does not fit a message of %d bytes", frag->index, frag->size);
+
+    for (int i = 0; i < CONFIG_ESPNOW_MSG_REASSEMBLY_NUM; ++i) {
+        espnow_msg_reassembly_t *it = g_msg_reassembly + i;
+
+        /**< A message that stopped coming in gives its slot back */
+        if (it->data && now - it->update_ticks > pdMS_TO_TICKS(CONFIG_ESPNOW_MSG_REASSEMBLY_TIMEOUT)) {
+            ESP_LOGD(TAG, "Drop message %d from " MACSTR ", %d of %d pieces", it->id, MAC2STR(it->src_addr),
+                     it->received_num, it->frag_num);
+            espnow_msg_reassembly_free(it);
+        }
+
+        if (!it->data) {
+            free_msg = free_msg ? free_msg : it;
+        } else if (it->id == frag->id && it->type == espnow_data->type && it->size == frag->size
+                   && ESPNOW_ADDR_IS_EQUAL(it->src_addr, espnow_data->src_addr)) {
+            msg = it;
+        }
+    }
+
+    if (!msg) {
+        /**< Not even an empty reassembly would hold it, the sender retries in vain */
+        if (frag->size > CONFIG_ESPNOW_MSG_REASSEMBLY_SIZE) {
+            if (frag->id != g_msg_oversize_id || !ESPNOW_ADDR_IS_EQUAL(g_msg_oversize_addr, espnow_data->src_addr)) {
+                ESP_LOGE(TAG, "Message %d of %d bytes from " MACSTR " is larger than CONFIG_ESPNOW_MSG_REASSEMBLY_SIZE %d, dropped",
+                         frag->id, frag->size, MAC2STR(espnow_data->src_addr), CONFIG_ESPNOW_MSG_REASSEMBLY_SIZE);
+                g_msg_oversize_id = frag->id;
+                memcpy(g_msg_oversize_addr, espnow_data->src_addr, sizeof(g_msg_oversize_addr));
+            }
+
+            return ESP_ERR_INVALID_SIZE;
+        }
+
+        ESP_ERROR_RETURN(!free_msg, ESP_ERR_ESPNOW_FULL, "No room for message %d from " MACSTR,
+                         frag->id, MAC2STR(espnow_data->src_addr));
+
+        /**< Incomplete messages hold at most CONFIG_ESPNOW_MSG_REASSEMBLY_SIZE, a new one beyond that is dropped */
+        ESP_ERROR_RETURN(g_msg_reassembly_bytes + frag->size > CONFIG_ESPNOW_MSG_REASSEMBLY_SIZE, ESP_ERR_ESPNOW_FULL,
+                         "No room for message %d of %d bytes from " MACSTR ", %d bytes in use",
+                         frag->id, frag->size, MAC2STR(espnow_data->src_addr), g_msg_reassembly_bytes);
+
+        msg = free_msg;
+        msg->data = ESP_MALLOC(frag->size ? frag->size : 1);
+        ESP_ERROR_RETURN(!msg->data, ESP_ERR_NO_MEM, "Not enough memory!");
+        g_msg_reassembly_bytes += frag->size;
+
+        memcpy(msg->src_addr, espnow_data->src_addr, sizeof(msg->src_addr));
+        msg->type = espnow_data->type;
+        msg->id = frag->id;
+        msg->size = frag->size;
+        msg->frag_num = frag_num;
+        msg->received_num = 0;
+        memset(msg->received, 0, sizeof(msg->received));
+    }
+
+    msg->update_ticks = now;
+
+    if (msg->received[frag->index / 32] & BIT(frag->index % 32)) {
+        return ESP_OK;
+    }
+
+    msg->received[frag->index / 32] |= BIT(frag->index % 32);
+    msg->received_num++;
+    memcpy(msg->data + offset, frag->data, size);
+
+    if (msg->received_num == msg->frag_num) {
+        if (g_recv_handle[msg->type].handle) {
+            g_recv_handle[msg->type].handle(msg->src_addr, msg->data, msg->size, rx_ctrl);
+        }
+
+        espnow_msg_reassembly_free(msg);
+    }
+
+    return ESP_OK;
+}
+
 static esp_err_t espnow_recv_process(espnow_pkt_t *q_data)
 {
     ESP_PARAM_CHECK(q_data);
@@ -808,10 +1404,9 @@ static esp_err_t espnow_recv_process(espnow_pkt_t *q_data)
     esp_err_t ret        = 0;
     espnow_data_t *espnow_data = &q_data->data;
     espnow_frame_head_t *frame_head = &espnow_data->frame_head;
-    uint8_t src_addr[6]     = {0};
     size_t size            = 0;
-    uint8_t *data   = ESP_MALLOC(ESPNOW_PAYLOAD_LEN);
-    wifi_pkt_rx_ctrl_t rx_ctrl = {0};
+    uint8_t *data          = espnow_data->payload;
+    uint8_t plaintext[ESPNOW_PAYLOAD_LEN];
 
     ESP_LOGD(TAG, "[%s, %d], " MACSTR ", magic: 0x%04x, type: %d, size: %d, %s", __func__, __LINE__, MAC2STR(espnow_data->src_addr),
              frame_head->magic, espnow_data->type, espnow_data->size, espnow_data->payload);
@@ -821,17 +1416,13 @@ static esp_err_t espnow_recv_process(espnow_pkt_t *q_data)
         if (frame_head->security) {
             if (g_espnow_config->sec_enable) {
                 if (g_espnow_dec && g_espnow_dec->state == ESPNOW_SEC_OVER) {
-                    uint8_t key_info[APP_KEY_LEN];
-
-                    ret = espnow_get_dec_key(key_info);
-                    if (ret) {
-                        ESP_LOGE(TAG, "Get security key fail for decrypt, err_name: %s", esp_err_to_name(ret));
-                        goto EXIT;
-                    }
-                    memcpy(key_info + KEY_LEN, espnow_data->payload + (espnow_data->size - IV_LEN), IV_LEN);
-                    espnow_set_dec_key(key_info);
+                    ESP_ERROR_GOTO(espnow_data->size <= IV_LEN + g_espnow_dec->tag_len, EXIT,
+                                   "Secured payload too short, size: %d", espnow_data->size);
 
-                    ret = espnow_sec_auth_decrypt(g_espnow_dec, espnow_data->payload, (espnow_data->size - IV_LEN), data, ESPNOW_PAYLOAD_LEN, &size, g_espnow_dec->tag_len);
+                    /**< Not in place, a forwarded copy of the frame may share its buffer */
+                    const uint8_t *iv = espnow_data->payload + (espnow_data->size - IV_LEN);
+                    data = plaintext;
+                    ret = espnow_sec_auth_decrypt_iv(g_espnow_dec, iv, espnow_data->payload, (espnow_data->size - IV_LEN), data, &size, g_espnow_dec->tag_len);
                     ESP_ERROR_GOTO(ret != ESP_OK, EXIT, "espnow_sec_auth_decrypt, err_name: %s", esp_err_to_name(ret));
                 } else {
                     ESP_LOGE(TAG, "Security key is not set");
@@ -842,21 +1433,21 @@ static esp_err_t espnow_recv_process(espnow_pkt_t *q_data)
             }
         } else {
             size = espnow_data->size;
-            memcpy(data, espnow_data->payload, espnow_data->size);
         }
 
-        memcpy(src_addr, espnow_data->src_addr, 6);
-
-        rx_ctrl = q_data->rx_ctrl;
+        if (espnow_data->fragment) {
+            ret = espnow_msg_reassemble(espnow_data, data, size, &q_data->rx_ctrl);
+            goto EXIT;
+        }
 
+        /**< The handler borrows the packet until it returns */
         if (g_recv_handle[espnow_data->type].handle) {
-            g_recv_handle[espnow_data->type].handle(src_addr, (void *)data, size, &rx_ctrl);
+            g_recv_handle[espnow_data->type].handle(espnow_data->src_addr, (void *)data, size, &q_data->rx_ctrl);
         }
     }
 
 EXIT:
-    ESP_FREE(q_data);
-    ESP_FREE(data);
+    espnow_pkt_release(q_data);
     return ret;
 }
 
@@ -884,12 +1475,12 @@ static esp_err_t espnow_send_forward(espnow_data_t *espnow_data)
     /**< Wait for other tasks to be sent before send ESP-NOW data */
     if (xSemaphoreTake(g_send_lock, g_espnow_config->send_max_timeout) != pdPASS) {
         ESP_LOGW(TAG, "Wait Sem fail");
-        ESP_FREE(espnow_data);
+        espnow_pkt_release(espnow_data);
         return ESP_ERR_TIMEOUT;
     }
 
     if (frame_head->channel == ESPNOW_CHANNEL_ALL && g_set_channel_flag && g_espnow_config->forward_switch_channel) {
-        ESP_ERROR_CHECK(esp_wifi_get_channel(&primary, &second));
+        ESP_ERROR_CHECK(g_radio->get_channel(g_radio_ctx, &primary, &second));
     }
 
     ESP_LOGD(TAG, "[%s, %d], " MACSTR ", total: %d, type: %d, magic: 0x%x", __func__, __LINE__,
@@ -901,10 +1492,10 @@ static esp_err_t espnow_send_forward(espnow_data_t *espnow_data)
         for (int i = 0;  i == 0 || (frame_head->channel == ESPNOW_CHANNEL_ALL && i < g_self_country.nchan && g_set_channel_flag && g_espnow_config->forward_switch_channel); ++i) {
 
             if (frame_head->channel == ESPNOW_CHANNEL_ALL && g_set_channel_flag && g_espnow_config->forward_switch_channel) {
-                esp_wifi_set_channel(g_self_country.schan + i, WIFI_SECOND_CHAN_NONE);
+                g_radio->set_channel(g_radio_ctx, g_self_country.schan + i, WIFI_SECOND_CHAN_NONE);
             }
 
-            ret = esp_now_send(dest_addr, (uint8_t *)espnow_data, sizeof(espnow_data_t) + espnow_data->size);
+            ret = g_radio->send(g_radio_ctx, dest_addr, (uint8_t *)espnow_data, sizeof(espnow_data_t) + espnow_data->size);
 
             if (ret == ESP_OK) {
                 ret = espnow_send_process(count, espnow_data, portMAX_DELAY, NULL);
@@ -919,11 +1510,11 @@ static esp_err_t espnow_send_forward(espnow_data_t *espnow_data)
     ESP_LOGD(TAG, "[%s, %d], " MACSTR ", size: %d, %s", __func__, __LINE__, MAC2STR(espnow_data->src_addr), espnow_data->size, espnow_data->payload);
 
     if (frame_head->channel == ESPNOW_CHANNEL_ALL && g_set_channel_flag && g_espnow_config->forward_switch_channel) {
-        esp_wifi_set_channel(primary, second);
+        g_radio->set_channel(g_radio_ctx, primary, second);
     }
 
     xSemaphoreGive(g_send_lock);
-    ESP_FREE(espnow_data);
+    espnow_pkt_release(espnow_data);
 
     return ret;
 }
@@ -936,11 +1527,13 @@ static void espnow_main_task(void *arg)
     ESP_LOGI(TAG, "main task entry");
 
     if (g_espnow_config && g_espnow_config->qsize) {
+        ESP_ERROR_GOTO(espnow_pkt_pool_create(g_espnow_config->qsize) != ESP_OK, EXIT, "Create espnow packet pool fail");
+
         g_espnow_queue = xQueueCreate(g_espnow_config->qsize, sizeof(espnow_event_ctx_t));
         ESP_ERROR_GOTO(!g_espnow_queue, EXIT, "Create espnow event queue fail");
 
         if (g_recv_handle[ESPNOW_DATA_TYPE_ACK].enable) {
-            g_ack_queue = xQueueCreate(4, sizeof(uint32_t *));
+            g_ack_queue = xQueueCreate(ACK_QUEUE_SIZE, sizeof(uint32_t));
             ESP_ERROR_GOTO(!g_ack_queue, EXIT, "Create espnow ack queue fail");
         }
     }
@@ -973,7 +1566,7 @@ static void espnow_main_task(void *arg)
 EXIT:
     if (g_espnow_queue) {
         while (xQueueReceive(g_espnow_queue, &evt_data, 0)) {
-            ESP_FREE(evt_data.data);
+            espnow_pkt_release(evt_data.data);
         }
 
         vQueueDelete(g_espnow_queue);
@@ -985,6 +1578,12 @@ EXIT:
         g_ack_queue = NULL;
     }
 
+    espnow_pkt_pool_delete();
+
+    for (int i = 0; i < CONFIG_ESPNOW_MSG_REASSEMBLY_NUM; ++i) {
+        espnow_msg_reassembly_free(g_msg_reassembly + i);
+    }
+
     ESP_LOGI(TAG, "main task exit");
     vTaskDelete(NULL);
 }
@@ -1082,15 +1681,12 @@ esp_err_t espnow_init(const espnow_config_t *config)
     }
 
     /**< Initialize ESPNOW function */
-    ESP_ERROR_CHECK(esp_now_init());
-    ESP_ERROR_CHECK(esp_now_register_send_cb(espnow_send_cb));
-    ESP_ERROR_CHECK(esp_now_register_recv_cb(espnow_recv_cb));
-    ESP_ERROR_CHECK(esp_now_set_pmk(config->pmk));
+    ESP_ERROR_CHECK(g_radio->init(g_radio_ctx, espnow_send_cb, espnow_recv_cb, config->pmk));
 
     espnow_add_peer(ESPNOW_ADDR_BROADCAST, NULL);
 
-    esp_wifi_get_country(&g_self_country);
-    esp_wifi_get_mac(ESP_IF_WIFI_STA, ESPNOW_ADDR_SELF);
+    g_radio->get_country(g_radio_ctx, &g_self_country);
+    g_radio->get_mac(g_radio_ctx, ESPNOW_ADDR_SELF);
     ESP_LOGI(TAG, "mac: " MACSTR ", version: %d", MAC2STR(ESPNOW_ADDR_SELF), ESPNOW_VERSION);
 
     ESP_LOGI(TAG, "Enable main task");
@@ -1099,14 +1695,51 @@ esp_err_t espnow_init(const espnow_config_t *config)
     return ESP_OK;
 }
 
+esp_err_t espnow_set_radio(const espnow_radio_t *radio, void *ctx)
+{
+    ESP_ERROR_RETURN(g_espnow_config, ESP_ERR_INVALID_STATE, "ESPNOW is already initialized");
+
+    g_radio = radio ? radio : &g_radio_wifi;
+    g_radio_ctx = radio ? ctx : NULL;
+
+    return ESP_OK;
+}
+
+esp_err_t espnow_radio_get_channel(uint8_t *primary, wifi_second_chan_t *second)
+{
+    ESP_PARAM_CHECK(primary);
+    ESP_PARAM_CHECK(second);
+
+    return g_radio->get_channel(g_radio_ctx, primary, second);
+}
+
+esp_err_t espnow_radio_set_channel(uint8_t primary, wifi_second_chan_t second)
+{
+    return g_radio->set_channel(g_radio_ctx, primary, second);
+}
+
+esp_err_t espnow_radio_get_country(wifi_country_t *country)
+{
+    ESP_PARAM_CHECK(country);
+
+    return g_radio->get_country(g_radio_ctx, country);
+}
+
+esp_err_t espnow_radio_send(const uint8_t *dest_addr, const void *data, size_t size)
+{
+    ESP_PARAM_CHECK(dest_addr);
+    ESP_PARAM_CHECK(data);
+    ESP_PARAM_CHECK(size > 0 && size <= ESP_NOW_MAX_DATA_LEN);
+
+    return g_radio->send(g_radio_ctx, dest_addr, data, size);
+}
+
 esp_err_t espnow_deinit(void)
 {
     ESP_ERROR_RETURN(!g_espnow_config, ESP_ERR_ESPNOW_NOT_INIT, "ESPNOW is not initialized");
 
     /**< De-initialize ESPNOW function */
-    ESP_ERROR_CHECK(esp_now_unregister_recv_cb());
-    ESP_ERROR_CHECK(esp_now_unregister_send_cb());
-    ESP_ERROR_CHECK(esp_now_deinit());
+    ESP_ERROR_CHECK(g_radio->deinit(g_radio_ctx));
 
     if (queue_over_write(ESPNOW_EVENT_STOP, NULL, 0, NULL, 0) != pdPASS) {
         ESP_LOGW(TAG, "[%s, %d] Send queue failed", __func__, __LINE__);
@@ -1209,6 +1842,12 @@ esp_err_t espnow_erase_key(void)
 {
     g_read_from_nvs = true;
     memset(g_espnow_sec_key, 0, APP_KEY_LEN);
+
+    /**< Frames are no longer encrypted with the key scheduled before */
+    if (g_espnow_sec) {
+        g_espnow_sec->state = ESPNOW_SEC_UNFINISHED;
+    }
+
     return espnow_storage_erase("key_info");
 }
 
@@ -1251,5 +1890,10 @@ esp_err_t espnow_erase_dec_key(void)
 {
     g_read_dec_from_nvs = true;
     memset(g_espnow_dec_key, 0, APP_KEY_LEN);
+
+    if (g_espnow_dec) {
+        g_espnow_dec->state = ESPNOW_SEC_UNFINISHED;
+    }
+
     return espnow_storage_erase("dec_key_info");
 }
@@ -0,0 +1,764 @@
+// Copyright 2021 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <stdio.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+#include "freertos/timers.h"
+#include "freertos/event_groups.h"
+#include "freertos/semphr.h"
+
+#include "esp_wifi.h"
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 4, 0)
+#include "esp_mac.h"
+#include "esp_random.h"
+#else
+#include "esp_system.h"
+#endif
+
+#include "espnow.h"
+#include "espnow_ota.h"
+#include "espnow_utils.h"
+#include "espnow_ota_unpack.h"
+
+static const char *TAG = "espnow_ota_initatior";
+static bool g_ota_send_running_flag   = false;
+static SemaphoreHandle_t g_ota_send_exit_sem = NULL;
+
+static size_t g_scan_num = 0;
+static espnow_ota_responder_t *g_info_list = NULL;
+static bool g_info_en = false;
+
+#ifndef CONFIG_ESPNOW_OTA_RETRY_COUNT
+#define CONFIG_ESPNOW_OTA_RETRY_COUNT           50
+#endif
+
+#ifndef CONFIG_ESPNOW_OTA_SEND_FORWARD_TTL
+#define CONFIG_ESPNOW_OTA_SEND_FORWARD_TTL      0
+#endif
+
+#ifndef CONFIG_ESPNOW_OTA_SEND_FORWARD_RSSI
+#define CONFIG_ESPNOW_OTA_SEND_FORWARD_RSSI     -65
+#endif
+
+#ifndef CONFIG_ESPNOW_OTA_WAIT_RESPONSE_TIMEOUT
+#define CONFIG_ESPNOW_OTA_WAIT_RESPONSE_TIMEOUT (10 * 1000)
+#endif
+
+
+static bool addrs_remove(uint8_t addrs_list[][ESPNOW_ADDR_LEN],
+                         size_t *addrs_num, const uint8_t addr[6])
+{
+    if (!addrs_list || !addrs_num || !addr) {
+        ESP_LOGE(TAG, "!addrs_list: %p !addrs_num: %p !addr: %p", addrs_list, addrs_num, addr);
+        return false;
+    }
+
+    for (int i = 0; i < *addrs_num; i++) {
+        if (ESPNOW_ADDR_IS_EQUAL(addrs_list[i], addr)) {
+            if (--(*addrs_num)) {
+                memcpy(addrs_list[i], addrs_list[*addrs_num], ESPNOW_ADDR_LEN);
+            }
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static esp_err_t espnow_ota_info(uint8_t *src_addr, void *data,
+                      size_t size, wifi_pkt_rx_ctrl_t *rx_ctrl)
+{
+    espnow_ota_info_t *recv_data = (espnow_ota_info_t *)data;
+
+    for (int i = 0; i < g_scan_num; ++i) {
+        if (ESPNOW_ADDR_IS_EQUAL((g_info_list)[i].mac, src_addr)) {
+            return ESP_OK;
+        }
+    }
+
+    g_info_list = ESP_REALLOC(g_info_list, (g_scan_num + 1) * sizeof(espnow_ota_responder_t));
+    (g_info_list)[g_scan_num].channel = rx_ctrl->channel;
+    (g_info_list)[g_scan_num].rssi    = rx_ctrl->rssi;
+    memcpy((g_info_list)[g_scan_num].mac, src_addr, 6);
+    memcpy(&((g_info_list)[g_scan_num].app_desc), &recv_data->app_desc, sizeof(esp_app_desc_t));
+    g_scan_num++;
+
+    ESP_LOGV(TAG, "Application information:");
+    ESP_LOGV(TAG, "Project name:     %s", recv_data->app_desc.project_name);
+    ESP_LOGV(TAG, "App version:      %s", recv_data->app_desc.version);
+    ESP_LOGV(TAG, "Secure version:   %d", recv_data->app_desc.secure_version);
+    ESP_LOGV(TAG, "Compile time:     %s %s", recv_data->app_desc.date, recv_data->app_desc.time);
+    ESP_LOGV(TAG, "ESP-IDF:          %s", recv_data->app_desc.idf_ver);
+
+    return ESP_OK;
+}
+
+static QueueHandle_t g_ota_queue = NULL;
+typedef struct {
+    uint8_t src_addr[6];
+    void *data;
+    size_t size;
+} espnow_ota_data_t;
+
+static esp_err_t espnow_ota_status_handle(uint8_t *src_addr, void *data, size_t size)
+{
+    ESP_PARAM_CHECK(src_addr);
+    ESP_PARAM_CHECK(data);
+    ESP_PARAM_CHECK(size);
+
+    if (g_ota_queue) {
+        espnow_ota_data_t ota_data = { 0 };
+        ota_data.data = ESP_MALLOC(size);
+        if (!ota_data.data) {
+            return ESP_FAIL;
+        }
+        memcpy(ota_data.data, data, size);
+        ota_data.size = size;
+        memcpy(ota_data.src_addr, src_addr, 6);
+        if (xQueueSend(g_ota_queue, &ota_data, 0) != pdPASS) {
+            ESP_LOGW(TAG, "[%s, %d] Send ota queue failed", __func__, __LINE__);
+            ESP_FREE(ota_data.data);
+            return ESP_FAIL;
+        }
+    }
+
+    return ESP_OK;
+}
+
+static esp_err_t espnow_ota_initiator_status_process(uint8_t *src_addr, void *data,
+                      size_t size, wifi_pkt_rx_ctrl_t *rx_ctrl)
+{
+    ESP_PARAM_CHECK(src_addr);
+    ESP_PARAM_CHECK(data);
+    ESP_PARAM_CHECK(size);
+    ESP_PARAM_CHECK(rx_ctrl);
+
+    esp_err_t ret = ESP_OK;
+    uint8_t data_type = ((uint8_t *)data)[0];
+
+    switch (data_type) {
+        case ESPNOW_OTA_TYPE_INFO:
+            ESP_LOGD(TAG, "ESPNOW_OTA_TYPE_INFO");
+            if (g_info_en){
+                ret = espnow_ota_info(src_addr, data, size, rx_ctrl);
+            }
+            break;
+
+        case ESPNOW_OTA_TYPE_STATUS:
+            ESP_LOGD(TAG, "ESPNOW_OTA_TYPE_STATUS");
+            ret = espnow_ota_status_handle(src_addr, data, size);
+            break;
+
+        default:
+            break;
+    }
+
+    ESP_ERROR_RETURN(ret != ESP_OK, ret, "espnow_ota_handle");
+    return ret;
+}
+
+esp_err_t espnow_ota_initiator_scan(espnow_ota_responder_t **info_list, size_t *num, TickType_t wait_ticks)
+{
+    esp_err_t ret = ESP_OK;
+    espnow_ota_info_t request_ota_info = {.type = ESPNOW_OTA_TYPE_REQUEST};
+
+    espnow_frame_head_t frame_head = {
+        .retransmit_count = CONFIG_ESPNOW_OTA_RETRANSMISSION_TIMES,
+        .broadcast        = true,
+        .magic            = esp_random(),
+        .filter_adjacent_channel = true,
+        .forward_ttl      = CONFIG_ESPNOW_OTA_SEND_FORWARD_TTL,
+        .forward_rssi     = CONFIG_ESPNOW_OTA_SEND_FORWARD_RSSI,
+        .security         = CONFIG_ESPNOW_OTA_SECURITY,
+    };
+
+    espnow_ota_initiator_scan_result_free();
+
+    g_info_en = true;
+    espnow_set_config_for_data_type(ESPNOW_DATA_TYPE_OTA_STATUS, 1, espnow_ota_initiator_status_process);
+
+    for (int i = 0, start_ticks = xTaskGetTickCount(), recv_ticks = 500; i < 5 && wait_ticks - (xTaskGetTickCount() - start_ticks) > 0;
+            ++i, recv_ticks = 500) {
+        ret = espnow_send(ESPNOW_DATA_TYPE_OTA_DATA, ESPNOW_ADDR_BROADCAST, &request_ota_info, 1, &frame_head, portMAX_DELAY);
+        ESP_ERROR_GOTO(ret != ESP_OK, EXIT, "espnow_send");
+
+        vTaskDelay(recv_ticks);
+    }
+
+    *info_list = g_info_list;
+    *num = g_scan_num;
+
+EXIT:
+    espnow_set_config_for_data_type(ESPNOW_DATA_TYPE_OTA_STATUS, 0, NULL);
+    g_info_en = false;
+
+    return ret;
+}
+
+esp_err_t espnow_ota_initiator_scan_result_free(void)
+{
+    ESP_FREE(g_info_list);
+    g_scan_num = 0;
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Who is missing a packet in the current round: the indexes of the
+ *        responders that reported it missing, ESPNOW_OTA_OWNER_NONE in the free
+ *        slots, or ESPNOW_OTA_OWNER_MULTI in the first slot once they do not fit
+ */
+#define ESPNOW_OTA_OWNER_SLOTS 2
+#define ESPNOW_OTA_OWNER_NONE  0xff
+#define ESPNOW_OTA_OWNER_MULTI 0xfe
+
+typedef uint8_t espnow_ota_owner_t[ESPNOW_OTA_OWNER_SLOTS];
+
+typedef enum {
+    ESPNOW_OTA_TARGET_WAIT,     /**< Status not received in this round */
+    ESPNOW_OTA_TARGET_ERASING,  /**< Erasing its update partition before it answers */
+    ESPNOW_OTA_TARGET_ANSWERED, /**< Status received, the missing packets are merged */
+    ESPNOW_OTA_TARGET_DONE,     /**< Upgraded or stopped, left the group */
+} espnow_ota_target_state_t;
+
+typedef struct {
+    espnow_addr_t addr;
+    uint8_t state;
+    uint16_t missing_num;   /**< Missing packets merged from its status in this round */
+    uint32_t progress_mask; /**< Slices of its bitmap merged in this round */
+} espnow_ota_target_t;
+
+static void espnow_ota_owner_mark(espnow_ota_owner_t owner, size_t index)
+{
+    if (index >= ESPNOW_OTA_OWNER_MULTI) {
+        owner[0] = ESPNOW_OTA_OWNER_MULTI;
+        return;
+    }
+
+    for (size_t i = 0; i < ESPNOW_OTA_OWNER_SLOTS && owner[0] != ESPNOW_OTA_OWNER_MULTI; ++i) {
+        if (owner[i] == index) {
+            return;
+        }
+
+        if (owner[i] == ESPNOW_OTA_OWNER_NONE) {
+            owner[i] = index;
+            return;
+        }
+    }
+
+    owner[0] = ESPNOW_OTA_OWNER_MULTI;
+}
+
+static void espnow_ota_target_leave(espnow_ota_target_t *target, espnow_ota_result_t *result, bool successed)
+{
+    target->state = ESPNOW_OTA_TARGET_DONE;
+    addrs_remove(result->unfinished_addr, &result->unfinished_num, target->addr);
+    espnow_set_group(&target->addr, 1, ESPNOW_ADDR_GROUP_OTA, NULL, false, portMAX_DELAY);
+
+    if (successed) {
+        memcpy(result->successed_addr[result->successed_num++], target->addr, ESPNOW_ADDR_LEN);
+    }
+}
+
+/**
+ * @brief Count the devices that have not answered in this round
+ */
+static size_t espnow_ota_target_count(const espnow_ota_target_t *targets, size_t targets_num, bool *erasing)
+{
+    size_t count = 0;
+    *erasing = false;
+
+    for (size_t i = 0; i < targets_num; ++i) {
+        count    += targets[i].state == ESPNOW_OTA_TARGET_WAIT || targets[i].state == ESPNOW_OTA_TARGET_ERASING;
+        *erasing |= targets[i].state == ESPNOW_OTA_TARGET_ERASING;
+    }
+
+    return count;
+}
+
+/**
+ * @brief Merge the status from one responder, the packets it misses are marked in owner
+ */
+static esp_err_t espnow_ota_status_merge(espnow_ota_target_t *targets, size_t targets_num,
+        const espnow_ota_data_t *ota_data, const espnow_ota_status_t *status,
+        espnow_ota_owner_t *owner, espnow_ota_result_t *result)
+{
+    const espnow_ota_status_t *response = ota_data->data;
+    size_t index = 0;
+
+    ESP_ERROR_RETURN(ota_data->size < sizeof(espnow_ota_status_t), ESP_ERR_INVALID_SIZE,
+                     "status size: %d", ota_data->size);
+
+    for (index = 0; index < targets_num && !ESPNOW_ADDR_IS_EQUAL(targets[index].addr, ota_data->src_addr); ++index) {
+    }
+
+    if (index == targets_num || targets[index].state == ESPNOW_OTA_TARGET_DONE) {
+        return ESP_OK;
+    }
+
+    espnow_ota_target_t *target = targets + index;
+
+    if (response->error_code == ESP_ERR_ESPNOW_OTA_FIRMWARE_NOT_INIT) {
+        target->state = ESPNOW_OTA_TARGET_ERASING;
+        return ESP_OK;
+    }
+
+    if (response->error_code == ESP_ERR_ESPNOW_OTA_STOP) {
+        ESP_LOGW(TAG, "The device stopped upgrading, addr: " MACSTR, MAC2STR(target->addr));
+        espnow_ota_target_leave(target, result, false);
+        return ESP_OK;
+    }
+
+    if (response->error_code == ESP_ERR_ESPNOW_OTA_FINISH
+            || (response->total_size && response->written_size == response->total_size)) {
+        espnow_ota_target_leave(target, result, true);
+        return ESP_OK;
+    }
+
+    ESP_LOGD(TAG, "Response, src_addr: " MACSTR ", total_size: %d, written_size: %d, progress_index: %d, error_code: %s",
+             MAC2STR(target->addr), response->total_size, response->written_size,
+             response->progress_index, esp_err_to_name(response->error_code));
+
+    if (target->state == ESPNOW_OTA_TARGET_ANSWERED) {
+        return ESP_OK;
+    }
+
+    /**< The packets received are all full except the last one */
+    size_t missing_num = status->packet_num - (response->written_size + ESPNOW_OTA_PACKET_MAX_SIZE - 1) / ESPNOW_OTA_PACKET_MAX_SIZE;
+
+    if (response->written_size == 0) {
+        for (size_t seq = 0; seq < status->packet_num; ++seq) {
+            espnow_ota_owner_mark(owner[seq], index);
+        }
+
+        target->missing_num = missing_num;
+    } else if (response->progress_index < 32 && !(target->progress_mask & BIT(response->progress_index))) {
+        /**< Each slice of the bitmap with a missing packet comes in its own frame */
+        size_t seq_start = response->progress_index * ESPNOW_OTA_PROGRESS_MAX_SIZE * 8;
+        size_t seq_end   = seq_start + (ota_data->size - sizeof(espnow_ota_status_t)) * 8;
+
+        target->progress_mask |= BIT(response->progress_index);
+
+        for (size_t seq = seq_start; seq < seq_end && seq < status->packet_num; ++seq) {
+            if (!ESPNOW_OTA_GET_BITS(response->progress_array[0], seq - seq_start)) {
+                espnow_ota_owner_mark(owner[seq], index);
+                target->missing_num++;
+            }
+        }
+    }
+
+    if (target->missing_num >= missing_num) {
+        target->state = ESPNOW_OTA_TARGET_ANSWERED;
+        memcpy(result->requested_addr[result->requested_num++], target->addr, ESPNOW_ADDR_LEN);
+    }
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Request the status of every unfinished device and merge the packets they miss
+ */
+static esp_err_t espnow_ota_request_status(espnow_ota_target_t *targets, size_t targets_num,
+        const espnow_ota_status_t *status, espnow_ota_owner_t *owner, espnow_ota_result_t *result)
+{
+    esp_err_t ret = ESP_OK;
+    size_t wait_num = 0;
+    bool erasing = false;
+    espnow_ota_data_t ota_data = { 0 };
+
+    result->requested_num = 0;
+    memset(owner, ESPNOW_OTA_OWNER_NONE, status->packet_num * sizeof(espnow_ota_owner_t));
+
+    for (size_t i = 0; i < targets_num; ++i) {
+        if (targets[i].state != ESPNOW_OTA_TARGET_DONE) {
+            targets[i].state         = ESPNOW_OTA_TARGET_WAIT;
+            targets[i].missing_num   = 0;
+            targets[i].progress_mask = 0;
+        }
+    }
+
+    /**
+     * @brief Remove the device that the firmware upgrade has completed.
+     */
+    while (g_ota_queue && (xQueueReceive(g_ota_queue, &ota_data, 0) == pdPASS)) {
+        const espnow_ota_status_t *response = ota_data.data;
+
+        if (ota_data.size >= sizeof(espnow_ota_status_t)
+                && (response->error_code == ESP_ERR_ESPNOW_OTA_STOP || response->error_code == ESP_ERR_ESPNOW_OTA_FINISH
+                    || (response->total_size && response->written_size == response->total_size))) {
+            espnow_ota_status_merge(targets, targets_num, &ota_data, status, owner, result);
+        }
+
+        ESP_FREE(ota_data.data);
+    }
+
+    if (result->unfinished_num == 0) {
+        return ESP_OK;
+    }
+
+    /**
+     * @brief Request all devices upgrade status from unfinished device.
+     */
+    espnow_frame_head_t status_frame = {
+        .group = true,
+        .broadcast = true,
+        .retransmit_count = CONFIG_ESPNOW_OTA_RETRANSMISSION_TIMES,
+        .filter_adjacent_channel = true,
+        .forward_ttl      = CONFIG_ESPNOW_OTA_SEND_FORWARD_TTL,
+        .forward_rssi     = CONFIG_ESPNOW_OTA_SEND_FORWARD_RSSI,
+        .security         = CONFIG_ESPNOW_OTA_SECURITY,
+    };
+
+    /**< The answers are unicast and come back to back, a gap this long means the rest were lost */
+    for (int i = 0; i < 3; ++i) {
+        for (size_t j = 0; j < targets_num; ++j) {
+            if (targets[j].state == ESPNOW_OTA_TARGET_ERASING) {
+                targets[j].state = ESPNOW_OTA_TARGET_WAIT;
+            }
+        }
+
+        wait_num = espnow_ota_target_count(targets, targets_num, &erasing);
+
+        if (!wait_num) {
+            break;
+        }
+
+        status_frame.magic = esp_random();
+
+        if (espnow_send(ESPNOW_DATA_TYPE_OTA_DATA, ESPNOW_ADDR_GROUP_OTA, status,
+                        sizeof(espnow_ota_status_t), &status_frame, portMAX_DELAY) != ESP_OK) {
+            ESP_LOGW(TAG, "Request devices upgrade status");
+        }
+
+        while (wait_num > 0 && g_ota_queue) {
+            /**< Wait longer while a device is erasing its update partition */
+            TickType_t wait_ticks = pdMS_TO_TICKS(erasing ? CONFIG_ESPNOW_OTA_WAIT_RESPONSE_TIMEOUT : 300);
+
+            ret = xQueueReceive(g_ota_queue, &ota_data, wait_ticks);
+            ESP_ERROR_BREAK(ret != pdPASS, "<%s> wait_ticks: %d", esp_err_to_name(ret), wait_ticks);
+
+            espnow_ota_status_merge(targets, targets_num, &ota_data, status, owner, result);
+            ESP_FREE(ota_data.data);
+
+            wait_num = espnow_ota_target_count(targets, targets_num, &erasing);
+        }
+    }
+
+    ret = ESP_OK;
+
+    if (wait_num && wait_num == result->unfinished_num && !erasing) {
+        ESP_LOGW(TAG, "ESP_ERR_ESPNOW_OTA_DEVICE_NO_EXIST");
+        ret = ESP_ERR_ESPNOW_OTA_DEVICE_NO_EXIST;
+    } else if (wait_num > 0) {
+        ESP_LOGW(TAG, "ESP_ERR_ESPNOW_OTA_SEND_PACKET_LOSS");
+        ret = ESP_ERR_ESPNOW_OTA_SEND_PACKET_LOSS;
+    } else if (result->requested_num > 0) {
+        ret = ESP_ERR_ESPNOW_OTA_FIRMWARE_INCOMPLETE;
+        ESP_LOGD(TAG, "ESP_ERR_ESPNOW_OTA_FIRMWARE_INCOMPLETE");
+    }
+
+    return ret;
+}
+
+/**
+ * @brief Add a packet to a parity packet if none of the devices missing it misses another one in there
+ */
+static bool espnow_ota_owner_take(const espnow_ota_owner_t owner, uint8_t owner_used[256 / 8])
+{
+    if (owner[0] == ESPNOW_OTA_OWNER_NONE || owner[0] == ESPNOW_OTA_OWNER_MULTI) {
+        return false;
+    }
+
+    for (size_t i = 0; i < ESPNOW_OTA_OWNER_SLOTS && owner[i] != ESPNOW_OTA_OWNER_NONE; ++i) {
+        if (ESPNOW_OTA_GET_BITS(owner_used, owner[i])) {
+            return false;
+        }
+    }
+
+    for (size_t i = 0; i < ESPNOW_OTA_OWNER_SLOTS && owner[i] != ESPNOW_OTA_OWNER_NONE; ++i) {
+        ESPNOW_OTA_SET_BITS(owner_used, owner[i]);
+    }
+
+    return true;
+}
+
+/**
+ * @brief Send every packet marked in owner once
+ *
+ * A packet missed by many devices is sent as is. Others are XORed together as long
+ * as every device misses only one of them, so one parity packet repairs a packet
+ * for each of up to ESPNOW_OTA_PARITY_SPAN devices at once.
+ */
+static esp_err_t espnow_ota_send_missing(const espnow_ota_status_t *status, espnow_ota_owner_t *owner,
+        espnow_ota_initiator_data_cb_t ota_data_cb, espnow_ota_packet_t *packet, espnow_ota_parity_t *parity,
+        const espnow_frame_head_t *frame_head, size_t *packet_count, size_t *parity_count)
+{
+    esp_err_t ret = ESP_OK;
+    uint8_t owner_used[256 / 8] = {0};
+
+    for (size_t seq = 0; seq < status->packet_num && g_ota_send_running_flag; ++seq) {
+        if (owner[seq][0] == ESPNOW_OTA_OWNER_NONE) {
+            continue;
+        }
+
+        size_t covered = 1;
+        memset(parity->mask, 0, sizeof(parity->mask));
+        memset(owner_used, 0, sizeof(owner_used));
+
+        if (espnow_ota_owner_take(owner[seq], owner_used)) {
+            for (size_t i = 1; i < ESPNOW_OTA_PARITY_SPAN && seq + i < status->packet_num; ++i) {
+                if (espnow_ota_owner_take(owner[seq + i], owner_used)) {
+                    ESPNOW_OTA_SET_BITS(parity->mask, i - 1);
+                    covered++;
+                }
+            }
+        }
+
+        if (covered == 1) {
+            packet->seq  = seq;
+            packet->size = (seq == status->packet_num - 1) ? status->total_size - ESPNOW_OTA_PACKET_MAX_SIZE * seq : ESPNOW_OTA_PACKET_MAX_SIZE;
+            owner[seq][0] = ESPNOW_OTA_OWNER_NONE;
+
+            /**
+             * @brief Read firmware data from Flash to send to unfinished device.
+             */
+            ret = ota_data_cb(seq * ESPNOW_OTA_PACKET_MAX_SIZE, packet->data, packet->size);
+            ESP_ERROR_RETURN(ret != ESP_OK, ret, "<%s> Read data from Flash", esp_err_to_name(ret));
+
+            ESP_LOGD(TAG, "seq: %d, size: %d", packet->seq, packet->size);
+            ret = espnow_send(ESPNOW_DATA_TYPE_OTA_DATA, ESPNOW_ADDR_GROUP_OTA, packet, sizeof(espnow_ota_packet_t), frame_head, portMAX_DELAY);
+            ESP_ERROR_CONTINUE(ret != ESP_OK, "<%s> espnow write", esp_err_to_name(ret));
+            (*packet_count)++;
+            continue;
+        }
+
+        uint8_t data[ESPNOW_OTA_PACKET_MAX_SIZE];
+        memset(parity->data, 0, sizeof(parity->data));
+
+        for (size_t i = 0; i < ESPNOW_OTA_PARITY_SPAN; ++i) {
+            if (i && !ESPNOW_OTA_GET_BITS(parity->mask, i - 1)) {
+                continue;
+            }
+
+            size_t size = (seq + i == status->packet_num - 1) ? status->total_size - ESPNOW_OTA_PACKET_MAX_SIZE * (seq + i) : ESPNOW_OTA_PACKET_MAX_SIZE;
+            owner[seq + i][0] = ESPNOW_OTA_OWNER_NONE;
+
+            ret = ota_data_cb((seq + i) * ESPNOW_OTA_PACKET_MAX_SIZE, data, size);
+            ESP_ERROR_RETURN(ret != ESP_OK, ret, "<%s> Read data from Flash", esp_err_to_name(ret));
+
+            for (size_t j = 0; j < size; ++j) {
+                parity->data[j] ^= data[j];
+            }
+        }
+
+        parity->seq = seq;
+
+        ESP_LOGD(TAG, "parity seq: %d, covered: %d", parity->seq, covered);
+        ret = espnow_send(ESPNOW_DATA_TYPE_OTA_DATA, ESPNOW_ADDR_GROUP_OTA, parity, sizeof(espnow_ota_parity_t), frame_head, portMAX_DELAY);
+        ESP_ERROR_CONTINUE(ret != ESP_OK, "<%s> espnow write", esp_err_to_name(ret));
+        (*parity_count)++;
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t espnow_ota_initiator_send(const uint8_t addrs_list[][6], size_t addrs_num,
+                                   const uint8_t sha_256[ESPNOW_OTA_HASH_LEN], size_t size,
+                                   espnow_ota_initiator_data_cb_t ota_data_cb, espnow_ota_result_t *res)
+{
+    ESP_PARAM_CHECK(addrs_list);
+    ESP_PARAM_CHECK(addrs_num);
+
+    esp_err_t ret = ESP_OK;
+    espnow_ota_status_t status = {
+        .type = ESPNOW_OTA_TYPE_STATUS,
+        .total_size = size,
+        .packet_num = (size + ESPNOW_OTA_PACKET_MAX_SIZE - 1) / ESPNOW_OTA_PACKET_MAX_SIZE,
+    };
+    memcpy(status.sha_256, sha_256, ESPNOW_OTA_HASH_LEN);
+
+    ESP_LOGI(TAG, "[%s, %d]: total_size: %d, packet_num: %d", __func__, __LINE__, size, status.packet_num);
+
+    espnow_ota_packet_t *packet = ESP_MALLOC(sizeof(espnow_ota_packet_t));
+    espnow_ota_parity_t *parity = ESP_MALLOC(sizeof(espnow_ota_parity_t));
+    espnow_ota_owner_t *owner = ESP_MALLOC(status.packet_num * sizeof(espnow_ota_owner_t));
+    espnow_ota_target_t *targets = NULL;
+    size_t targets_num = 0;
+    espnow_ota_result_t *result = ESP_CALLOC(1, sizeof(espnow_ota_result_t));
+    g_ota_send_running_flag = true;
+
+    espnow_frame_head_t frame_head = {
+        .broadcast        = true,
+        .retransmit_count = CONFIG_ESPNOW_OTA_RETRANSMISSION_TIMES,
+        .group            = true,
+        .forward_ttl      = CONFIG_ESPNOW_OTA_SEND_FORWARD_TTL,
+        .forward_rssi     = CONFIG_ESPNOW_OTA_SEND_FORWARD_RSSI,
+        .security         = CONFIG_ESPNOW_OTA_SECURITY,
+    };
+
+    if (addrs_num == 1 && ESPNOW_ADDR_IS_BROADCAST(addrs_list[0])) {
+        espnow_ota_responder_t *info_list = NULL;
+        size_t info_num = 0;
+        ret = espnow_ota_initiator_scan(&info_list, &info_num, 3000);
+        ESP_ERROR_GOTO(ret != ESP_OK, EXIT, "<%s> espnow_ota_initiator_scan", esp_err_to_name(ret));
+
+        ESP_LOGI(TAG, "Scan OTA list, num: %d", info_num);
+
+        targets_num = info_num;
+        targets = ESP_CALLOC(targets_num + 1, sizeof(espnow_ota_target_t));
+
+        for (size_t i = 0; targets && i < info_num; i++) {
+            memcpy(targets[i].addr, info_list[i].mac, ESPNOW_ADDR_LEN);
+        }
+
+        espnow_ota_initiator_scan_result_free();
+    } else {
+        targets_num = addrs_num;
+        targets = ESP_CALLOC(targets_num + 1, sizeof(espnow_ota_target_t));
+
+        for (size_t i = 0; targets && i < addrs_num; i++) {
+            memcpy(targets[i].addr, addrs_list[i], ESPNOW_ADDR_LEN);
+        }
+    }
+
+    /**< Every list can hold all the devices, so nothing is reallocated while sending */
+    result->unfinished_num  = targets_num;
+    result->unfinished_addr = ESP_CALLOC(targets_num + 1, ESPNOW_ADDR_LEN);
+    result->successed_addr  = ESP_CALLOC(targets_num + 1, ESPNOW_ADDR_LEN);
+    result->requested_addr  = ESP_CALLOC(targets_num + 1, ESPNOW_ADDR_LEN);
+    ESP_ERROR_GOTO(!packet || !parity || !owner || !targets || !result->unfinished_addr || !result->successed_addr || !result->requested_addr,
+                   EXIT, "<ESP_ERR_NO_MEM> targets_num: %d, packet_num: %d", targets_num, status.packet_num);
+
+    for (size_t i = 0; i < targets_num; i++) {
+        memcpy(result->unfinished_addr[i], targets[i].addr, ESPNOW_ADDR_LEN);
+    }
+
+    espnow_set_group(addrs_list, addrs_num, ESPNOW_ADDR_GROUP_OTA, NULL, true, portMAX_DELAY);
+    /* A device answers twice when it starts, before and after erasing, size the queue for that */
+    g_ota_queue = xQueueCreate(result->unfinished_num * 2, sizeof(espnow_ota_data_t));
+    ESP_ERROR_GOTO(!g_ota_queue, EXIT, "Create espnow ota queue fail");
+    espnow_set_config_for_data_type(ESPNOW_DATA_TYPE_OTA_STATUS, 1, espnow_ota_initiator_status_process);
+
+    /**< Tell the devices to unpack the image once received */
+    size_t probe_size = size < ESPNOW_OTA_UNPACK_PROBE_SIZE ? size : ESPNOW_OTA_UNPACK_PROBE_SIZE;
+    uint8_t *probe = ESP_MALLOC(probe_size);
+
+    if (probe && ota_data_cb(0, probe, probe_size) == ESP_OK && espnow_ota_unpack_check(probe, probe_size)) {
+        ESP_LOGI(TAG, "The firmware is packed, the devices unpack it after receiving");
+        status.type = ESPNOW_OTA_TYPE_STATUS_PACKED;
+    }
+
+    ESP_FREE(probe);
+
+    packet->type = ESPNOW_OTA_TYPE_DATA;
+    parity->type = ESPNOW_OTA_TYPE_PARITY;
+
+    ESP_LOGD(TAG, "packet_num: %d, total_size: %d", status.packet_num, status.total_size);
+
+    /**
+     * @brief Each round collects the status of all devices first, then sends
+     *        what any of them misses once. The first round sends the whole firmware.
+     */
+    for (int i = 0; i < CONFIG_ESPNOW_OTA_RETRY_COUNT && result->unfinished_num > 0 && g_ota_send_running_flag; ++i) {
+        size_t packet_count = 0;
+        size_t parity_count = 0;
+
+        ret = espnow_ota_request_status(targets, targets_num, &status, owner, result);
+        ESP_ERROR_BREAK(ret == ESP_OK || ret == ESP_ERR_ESPNOW_OTA_DEVICE_NO_EXIST, "");
+
+        ret = espnow_ota_send_missing(&status, owner, ota_data_cb, packet, parity, &frame_head, &packet_count, &parity_count);
+        ESP_ERROR_GOTO(ret != ESP_OK, EXIT, "<%s> espnow_ota_send_missing", esp_err_to_name(ret));
+
+        ESP_LOGI(TAG, "count: %d, Upgrade_initiator_send, requested_num: %d, unfinished_num: %d, successed_num: %d, packets: %d, parity: %d",
+                 i, result->requested_num, result->unfinished_num, result->successed_num, packet_count, parity_count);
+    }
+
+EXIT:
+
+    espnow_set_config_for_data_type(ESPNOW_DATA_TYPE_OTA_STATUS, 0, NULL);
+    if (g_ota_queue) {
+        espnow_ota_data_t tmp_data = { 0 };
+
+        while (xQueueReceive(g_ota_queue, &tmp_data, 0)) {
+            ESP_FREE(tmp_data.data);
+        }
+
+        vQueueDelete(g_ota_queue);
+        g_ota_queue = NULL;
+    }
+
+    if (result->unfinished_num > 0) {
+        espnow_set_group(result->unfinished_addr, result->unfinished_num, ESPNOW_ADDR_GROUP_OTA, NULL, false, portMAX_DELAY);
+        ret = ESP_ERR_ESPNOW_OTA_FIRMWARE_INCOMPLETE;
+    }
+
+    g_ota_send_running_flag = false;
+
+    if (res) {
+        memcpy(res, result, sizeof(espnow_ota_result_t));
+    } else {
+        espnow_ota_initiator_result_free(result);
+    }
+
+    ESP_FREE(packet);
+    ESP_FREE(parity);
+    ESP_FREE(owner);
+    ESP_FREE(targets);
+    ESP_FREE(result);
+
+    if (g_ota_send_exit_sem) {
+        xSemaphoreGive(g_ota_send_exit_sem);
+    }
+
+    return ret;
+}
+
+esp_err_t espnow_ota_initiator_result_free(espnow_ota_result_t *result)
+{
+    ESP_PARAM_CHECK(result);
+
+    result->unfinished_num = 0;
+    result->requested_num  = 0;
+    result->successed_num  = 0;
+    ESP_FREE(result->unfinished_addr);
+    ESP_FREE(result->requested_addr);
+    ESP_FREE(result->successed_addr);
+
+    return ESP_OK;
+}
+
+esp_err_t espnow_ota_initiator_stop()
+{
+    if (!g_ota_send_running_flag) {
+        return ESP_OK;
+    }
+
+    if (!g_ota_send_exit_sem) {
+        g_ota_send_exit_sem = xSemaphoreCreateBinary();
+    }
+
+    g_ota_send_running_flag = false;
+
+    xSemaphoreTake(g_ota_send_exit_sem, portMAX_DELAY);
+    vSemaphoreDelete(g_ota_send_exit_sem);
+    g_ota_send_exit_sem = NULL;
+
+    return ESP_OK;
+}
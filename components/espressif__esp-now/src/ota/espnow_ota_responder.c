@@ -28,20 +28,26 @@
 #include "espnow.h"
 #include "espnow_ota.h"
 #include "espnow_utils.h"
+#include "espnow_ota_unpack.h"
 
 #define ESPNOW_OTA_STORE_CONFIG_KEY "upugrad_config"
+#define ESPNOW_OTA_SECTOR_SIZE      4096
 #define CONFIG_ESPNOW_OTA_SKIP_VERSION_CHECK
 typedef struct {
     esp_ota_handle_t handle;      /**< OTA handle */
     const esp_partition_t *partition; /**< Pointer to partition structure obtained using
                                            esp_partition_find_first or esp_partition_get */
     uint32_t start_time;         /**< Start time of the upgrade */
+    bool packed;                 /**< The image is unpacked into the partition once received */
+    uint32_t packed_offset;      /**< Where the image is written, a packed one at the end of the partition */
+    uint32_t unpacked_size;      /**< Size of a packed image once unpacked into a data partition */
     espnow_ota_status_t status;  /**< Upgrade status */
 } ota_config_t;
 
 static const char *TAG = "espnow_ota_responder";
 static ota_config_t *g_ota_config = NULL;
 static bool g_ota_finished_flag        = false;
+static bool g_ota_unpacking_flag       = false;
 static espnow_frame_head_t g_frame_config = { .security = CONFIG_ESPNOW_OTA_SECURITY,
                                               .retransmit_count = CONFIG_ESPNOW_OTA_RETRANSMISSION_TIMES};
 static espnow_ota_config_t *g_espnow_ota_config = NULL;
@@ -124,6 +130,7 @@ static esp_err_t espnow_ota_status_handle(const espnow_addr_t src_addr, const es
     esp_err_t ret        = ESP_ERR_NO_MEM;
     size_t response_size = sizeof(espnow_ota_status_t);
     uint8_t running_sha_256[32] = {0};
+    bool packed = status->type == ESPNOW_OTA_TYPE_STATUS_PACKED;
 
     if (!g_ota_config) {
         size_t config_size = sizeof(ota_config_t) + ESPNOW_OTA_PROGRESS_MAX_SIZE * 10;
@@ -133,7 +140,8 @@ static esp_err_t espnow_ota_status_handle(const espnow_addr_t src_addr, const es
         espnow_storage_get(ESPNOW_OTA_STORE_CONFIG_KEY, g_ota_config, 0);
 
         g_ota_config->start_time = xTaskGetTickCount();
-        g_ota_config->partition = esp_ota_get_next_update_partition(NULL);
+        g_ota_config->partition = g_espnow_ota_config->data_partition ? g_espnow_ota_config->data_partition
+                                  : esp_ota_get_next_update_partition(NULL);
     }
 
     g_ota_config->status.type = ESPNOW_OTA_TYPE_STATUS;
@@ -142,7 +150,7 @@ static esp_err_t espnow_ota_status_handle(const espnow_addr_t src_addr, const es
     ret = esp_partition_get_sha256(esp_ota_get_running_partition(), running_sha_256);
     ESP_ERROR_RETURN(ret != ESP_OK, ret, "esp_partition_get_sha256");
 
-    if (!memcmp(running_sha_256, status->sha_256, ESPNOW_OTA_HASH_LEN)) {
+    if (!g_espnow_ota_config->data_partition && !memcmp(running_sha_256, status->sha_256, ESPNOW_OTA_HASH_LEN)) {
         ESP_LOGW(TAG, "The firmware to be upgraded is the same as the currently running firmware, so no upgrade");
         g_ota_config->status.error_code   = ESP_ERR_ESPNOW_OTA_FINISH;
         g_ota_config->status.written_size = 0;
@@ -152,13 +160,19 @@ static esp_err_t espnow_ota_status_handle(const espnow_addr_t src_addr, const es
     /**< If g_ota_config->status has been created and
          once again upgrade the same name bin, just return ESP_OK */
     if (!memcmp(g_ota_config->status.sha_256, status->sha_256, ESPNOW_OTA_HASH_LEN)
-            && g_ota_config->status.total_size == status->total_size) {
-        ret = ESP_OK;
+            && g_ota_config->status.total_size == status->total_size && g_ota_config->packed == packed
+            && (!g_espnow_ota_config->data_partition || g_ota_config->partition == g_espnow_ota_config->data_partition)) {
+        /**< Keep the initiator waiting until the image is unpacked */
+        ret = g_ota_unpacking_flag ? ESP_ERR_ESPNOW_OTA_FIRMWARE_NOT_INIT : ESP_OK;
         goto EXIT;
     }
 
+    ESP_ERROR_RETURN(g_ota_unpacking_flag, ESP_ERR_INVALID_STATE, "Unpacking the previous firmware");
+
     memset(g_ota_config, 0, sizeof(ota_config_t));
     memcpy(&g_ota_config->status, status, sizeof(espnow_ota_status_t));
+    g_ota_config->status.type = ESPNOW_OTA_TYPE_STATUS;
+    g_ota_config->packed = packed;
     memset(g_ota_config->status.progress_array, 0, status->packet_num / 8 + 1);
     g_ota_config->status.written_size = 0;
     g_ota_config->status.error_code = ESP_ERR_ESPNOW_OTA_FIRMWARE_NOT_INIT;
@@ -173,7 +187,8 @@ static esp_err_t espnow_ota_status_handle(const espnow_addr_t src_addr, const es
     /**< Get partition info of currently running app
     Return the next OTA app partition which should be written with a new firmware.*/
     const esp_partition_t *running = esp_ota_get_running_partition();
-    const esp_partition_t *update  = esp_ota_get_next_update_partition(NULL);
+    const esp_partition_t *update  = g_espnow_ota_config->data_partition ? g_espnow_ota_config->data_partition
+                                     : esp_ota_get_next_update_partition(NULL);
 
     ret = ESP_ERR_ESPNOW_OTA_FIRMWARE_PARTITION;
     ESP_ERROR_GOTO(!running || !update, EXIT,
@@ -186,9 +201,28 @@ static esp_err_t espnow_ota_status_handle(const espnow_addr_t src_addr, const es
     g_ota_config->partition  = update;
     g_ota_config->start_time = xTaskGetTickCount();
 
-    /**< Commence an OTA update writing to the specified partition. */
-    ret = esp_ota_begin(update, g_ota_config->status.total_size, &g_ota_config->handle);
-    ESP_ERROR_GOTO(ret != ESP_OK, EXIT, "esp_ota_begin failed");
+    if (packed) {
+        /**< Only erase where the packed image goes, the firmware is written in front of it when unpacked */
+        ret = ESP_ERR_INVALID_SIZE;
+        ESP_ERROR_GOTO(g_ota_config->status.total_size >= update->size, EXIT,
+                       "The packed firmware does not fit, total_size: %d", g_ota_config->status.total_size);
+
+        g_ota_config->packed_offset = (update->size - g_ota_config->status.total_size) & ~(ESPNOW_OTA_SECTOR_SIZE - 1);
+        ret = esp_partition_erase_range(update, g_ota_config->packed_offset, update->size - g_ota_config->packed_offset);
+        ESP_ERROR_GOTO(ret != ESP_OK, EXIT, "esp_partition_erase_range failed");
+    } else if (g_espnow_ota_config->data_partition) {
+        ret = ESP_ERR_INVALID_SIZE;
+        ESP_ERROR_GOTO(g_ota_config->status.total_size > update->size, EXIT,
+                       "The data does not fit, total_size: %d", g_ota_config->status.total_size);
+
+        ret = esp_partition_erase_range(update, 0, (g_ota_config->status.total_size + ESPNOW_OTA_SECTOR_SIZE - 1)
+                                        & ~(ESPNOW_OTA_SECTOR_SIZE - 1));
+        ESP_ERROR_GOTO(ret != ESP_OK, EXIT, "esp_partition_erase_range failed");
+    } else {
+        /**< Commence an OTA update writing to the specified partition. */
+        ret = esp_ota_begin(update, g_ota_config->status.total_size, &g_ota_config->handle);
+        ESP_ERROR_GOTO(ret != ESP_OK, EXIT, "esp_ota_begin failed");
+    }
 
     /**< Save upgrade infomation to flash. */
     ret = espnow_storage_set(ESPNOW_OTA_STORE_CONFIG_KEY, g_ota_config,
@@ -205,24 +239,37 @@ EXIT:
     /**< Update g_ota_config->status */
     if (g_ota_config->status.written_size
             && g_ota_config->status.written_size != g_ota_config->status.total_size) {
+        /**< Report every slice of the bitmap that has a missing packet in it, one frame each,
+             so the initiator learns all of them in one round */
+        const uint8_t *progress_array = g_ota_config->status.progress_array[0];
+        size_t progress_size = g_ota_config->status.packet_num / 8 + 1;
         espnow_ota_status_t *tmp_status = ESP_MALLOC(sizeof(espnow_ota_status_t) + ESPNOW_OTA_PROGRESS_MAX_SIZE);
+        ESP_ERROR_RETURN(!tmp_status, ESP_ERR_NO_MEM, "<ESP_ERR_NO_MEM> tmp_status");
         memcpy(tmp_status, &g_ota_config->status, sizeof(espnow_ota_status_t));
-        espnow_frame_head_t frame_head = ESPNOW_FRAME_CONFIG_DEFAULT();
-        frame_head.security = CONFIG_ESPNOW_OTA_SECURITY;
-
-        for (int seq = 0; seq < tmp_status->packet_num; ++seq) {
-            if (!ESPNOW_OTA_GET_BITS(g_ota_config->status.progress_array, seq)) {
-                tmp_status->progress_index = seq / (ESPNOW_OTA_PROGRESS_MAX_SIZE * 8);
-                memcpy(tmp_status->progress_array[0], g_ota_config->status.progress_array[tmp_status->progress_index], ESPNOW_OTA_PROGRESS_MAX_SIZE);
-                ret = espnow_send(ESPNOW_DATA_TYPE_OTA_STATUS, src_addr, tmp_status,
-                                  sizeof(espnow_ota_status_t) + ESPNOW_OTA_PROGRESS_MAX_SIZE, &frame_head, portMAX_DELAY);
-                ESP_LOG_BUFFER_HEXDUMP(TAG, tmp_status->progress_array, ESPNOW_OTA_PROGRESS_MAX_SIZE, ESP_LOG_DEBUG);
-                ESP_ERROR_BREAK(ret != ESP_OK, "espnow_send");
-
-                ESP_LOGD(TAG, "status, total_size: %d, written_size: %d, progress_index: %d",
-                         tmp_status->total_size, tmp_status->written_size, tmp_status->progress_index);
-                break;
+
+        for (size_t index = 0; index * ESPNOW_OTA_PROGRESS_MAX_SIZE < progress_size; ++index) {
+            size_t seq     = index * ESPNOW_OTA_PROGRESS_MAX_SIZE * 8;
+            size_t seq_end = seq + ESPNOW_OTA_PROGRESS_MAX_SIZE * 8;
+            size_t size    = progress_size - index * ESPNOW_OTA_PROGRESS_MAX_SIZE;
+
+            for (; seq < seq_end && seq < g_ota_config->status.packet_num && ESPNOW_OTA_GET_BITS(progress_array, seq); ++seq) {
+            }
+
+            if (seq == seq_end || seq == g_ota_config->status.packet_num) {
+                continue;
             }
+
+            size = size < ESPNOW_OTA_PROGRESS_MAX_SIZE ? size : ESPNOW_OTA_PROGRESS_MAX_SIZE;
+            tmp_status->progress_index = index;
+            memcpy(tmp_status->progress_array[0], g_ota_config->status.progress_array[index], size);
+
+            ret = espnow_send(ESPNOW_DATA_TYPE_OTA_STATUS, src_addr, tmp_status,
+                              sizeof(espnow_ota_status_t) + size, &g_frame_config, portMAX_DELAY);
+            ESP_LOG_BUFFER_HEXDUMP(TAG, tmp_status->progress_array, size, ESP_LOG_DEBUG);
+            ESP_ERROR_BREAK(ret != ESP_OK, "espnow_send");
+
+            ESP_LOGD(TAG, "status, total_size: %d, written_size: %d, progress_index: %d",
+                     tmp_status->total_size, tmp_status->written_size, tmp_status->progress_index);
         }
 
         ESP_FREE(tmp_status);
@@ -242,6 +289,118 @@ EXIT:
     return ESP_OK;
 }
 
+static esp_err_t espnow_ota_finish(const espnow_addr_t src_addr, const espnow_frame_head_t *frame_head)
+{
+    esp_err_t ret = ESP_OK;
+    const esp_partition_t *update_partition = esp_ota_get_next_update_partition(NULL);
+
+    if (g_espnow_ota_config->data_partition) {
+        /**< Nothing to boot, the application takes the data from here */
+        goto FINISH;
+    }
+
+    ret = validate_image_header(update_partition);
+    ESP_ERROR_RETURN(ret != ESP_OK, ret, "validate_image_header");
+
+    ret = esp_ota_set_boot_partition(update_partition);
+
+    if (ret != ESP_OK) {
+        g_ota_config->status.written_size = 0;
+        g_ota_config->status.error_code   = ESP_ERR_ESPNOW_OTA_STOP;
+        ESP_LOGW(TAG, "<%s> esp_ota_set_boot_partition", esp_err_to_name(ret));
+        return ret;
+    }
+
+    g_ota_finished_flag = true;
+
+FINISH:
+    /**< Send ESP_EVENT_ESPNOW_OTA_FINISH event to the event handler */
+    g_ota_config->status.type = ESPNOW_OTA_TYPE_STATUS;
+    g_ota_config->status.error_code = ESP_OK;
+
+    /**< Response firmware upgrade status to root node. */
+    ret = espnow_send(ESPNOW_DATA_TYPE_OTA_STATUS, src_addr, &g_ota_config->status,
+                      sizeof(espnow_ota_status_t), frame_head, portMAX_DELAY);
+    ESP_ERROR_RETURN(ret != ESP_OK, ret, "espnow_send");
+
+    esp_event_post(ESP_EVENT_ESPNOW, ESP_EVENT_ESPNOW_OTA_FINISH, NULL, 0, 0);
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Unpack the received image away from the receive task, which keeps answering
+ *        status requests with ESP_ERR_ESPNOW_OTA_FIRMWARE_NOT_INIT meanwhile
+ */
+static void espnow_ota_unpack_task(void *arg)
+{
+    espnow_addr_t src_addr = {0};
+    memcpy(src_addr, arg, ESPNOW_ADDR_LEN);
+    ESP_FREE(arg);
+
+    /**< The receive task adds and deletes the peer of the initiator around each frame,
+         reach it through the broadcast peer instead */
+    espnow_frame_head_t frame_head = g_frame_config;
+    frame_head.broadcast = true;
+
+    size_t unpacked_size = 0;
+    const esp_partition_t *base = g_espnow_ota_config->data_partition ? g_espnow_ota_config->data_base_partition : NULL;
+    esp_err_t ret = espnow_ota_unpack(g_ota_config->partition, g_ota_config->packed_offset,
+                                      g_ota_config->status.total_size, base, &unpacked_size);
+
+    if (ret == ESP_OK) {
+        g_ota_config->unpacked_size = unpacked_size;
+        ret = espnow_ota_finish(src_addr, &frame_head);
+    }
+
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "<%s> Unpack the firmware", esp_err_to_name(ret));
+        g_ota_config->status.type         = ESPNOW_OTA_TYPE_STATUS;
+        g_ota_config->status.written_size = 0;
+        g_ota_config->status.error_code   = ESP_ERR_ESPNOW_OTA_STOP;
+        memset(g_ota_config->status.progress_array, 0, g_ota_config->status.packet_num / 8 + 1);
+
+        espnow_send(ESPNOW_DATA_TYPE_OTA_STATUS, src_addr, &g_ota_config->status,
+                    sizeof(espnow_ota_status_t), &frame_head, portMAX_DELAY);
+
+        /**< Forget the image, so sending it again erases the partition first */
+        memset(g_ota_config->status.sha_256, 0, ESPNOW_OTA_HASH_LEN);
+    }
+
+    g_ota_unpacking_flag = false;
+    vTaskDelete(NULL);
+}
+
+static esp_err_t espnow_ota_unpack_start(const espnow_addr_t src_addr)
+{
+    esp_err_t ret = ESP_OK;
+    uint8_t *addr = NULL;
+
+    /**< Send ESP_EVENT_ESPNOW_OTA_FIRMWARE_DOWNLOAD event to the event handler */
+    esp_event_post(ESP_EVENT_ESPNOW, ESP_EVENT_ESPNOW_OTA_FIRMWARE_DOWNLOAD, NULL, 0, 0);
+
+    /**< The initiator waits for the device while it is unpacking */
+    g_ota_config->status.error_code = ESP_ERR_ESPNOW_OTA_FIRMWARE_NOT_INIT;
+    ret = espnow_send(ESPNOW_DATA_TYPE_OTA_STATUS, src_addr, &g_ota_config->status,
+                      sizeof(espnow_ota_status_t), &g_frame_config, portMAX_DELAY);
+    g_ota_config->status.error_code = ESP_OK;
+    ESP_ERROR_RETURN(ret != ESP_OK, ret, "espnow_send");
+
+    addr = ESP_MALLOC(ESPNOW_ADDR_LEN);
+    ESP_ERROR_RETURN(!addr, ESP_ERR_NO_MEM, "<ESP_ERR_NO_MEM> addr");
+    memcpy(addr, src_addr, ESPNOW_ADDR_LEN);
+    g_ota_unpacking_flag = true;
+
+    if (xTaskCreate(espnow_ota_unpack_task, "espnow_ota_unpack", 4 * 1024, addr, tskIDLE_PRIORITY + 1, NULL) != pdPASS) {
+        g_ota_unpacking_flag = false;
+        ESP_FREE(addr);
+        ESP_LOGW(TAG, "Create the unpack task");
+        return ESP_FAIL;
+    }
+
+    return ESP_OK;
+}
+
 static esp_err_t espnow_ota_write(const espnow_addr_t src_addr, const espnow_ota_packet_t *packet, size_t size)
 {
     ESP_PARAM_CHECK(src_addr);
@@ -278,7 +437,7 @@ static esp_err_t espnow_ota_write(const espnow_addr_t src_addr, const espnow_ota
     }
 
     /**< Write firmware data to the update partition */
-    ret = esp_partition_write(g_ota_config->partition, packet->seq * ESPNOW_OTA_PACKET_MAX_SIZE,
+    ret = esp_partition_write(g_ota_config->partition, g_ota_config->packed_offset + packet->seq * ESPNOW_OTA_PACKET_MAX_SIZE,
                               packet->data, packet->size);
     ESP_ERROR_RETURN(ret != ESP_OK, ESP_ERR_ESPNOW_OTA_FIRMWARE_DOWNLOAD,
                      "esp_partition_write %s", esp_err_to_name(ret));
@@ -324,38 +483,93 @@ static esp_err_t espnow_ota_write(const espnow_addr_t src_addr, const espnow_ota
                  g_ota_config->status.total_size, g_ota_config->status.written_size,
                  (xTaskGetTickCount() - g_ota_config->start_time) * portTICK_PERIOD_MS / 1000);
 
+        espnow_storage_erase(ESPNOW_OTA_STORE_CONFIG_KEY);
+
+        if (g_ota_config->packed) {
+            return espnow_ota_unpack_start(src_addr);
+        }
+
         /**< If ESP32 was reset duration OTA, and after restart, the update_handle will be invalid,
              but it still can switch boot partition and reboot successful */
-        esp_ota_end(g_ota_config->handle);
-        espnow_storage_erase(ESPNOW_OTA_STORE_CONFIG_KEY);
+        if (!g_espnow_ota_config->data_partition) {
+            esp_ota_end(g_ota_config->handle);
+        }
 
-        const esp_partition_t *update_partition = esp_ota_get_next_update_partition(NULL);
+        return espnow_ota_finish(src_addr, &g_frame_config);
+    }
 
-        ret = validate_image_header(update_partition);
-        ESP_ERROR_RETURN(ret != ESP_OK, ret, "validate_image_header");
+    return ESP_OK;
+}
 
-        ret = esp_ota_set_boot_partition(update_partition);
+static esp_err_t espnow_ota_parity_write(const espnow_addr_t src_addr, const espnow_ota_parity_t *parity, size_t size)
+{
+    ESP_PARAM_CHECK(src_addr);
+    ESP_PARAM_CHECK(parity);
+    ESP_PARAM_CHECK(size >= sizeof(espnow_ota_parity_t));
 
-        if (ret != ESP_OK) {
-            g_ota_config->status.written_size = 0;
-            g_ota_config->status.error_code   = ESP_ERR_ESPNOW_OTA_STOP;
-            ESP_LOGW(TAG, "<%s> esp_ota_set_boot_partition", esp_err_to_name(ret));
-            return ret;
+    esp_err_t ret = ESP_OK;
+    size_t missing_seq = 0;
+    size_t missing_num = 0;
+
+    if (!g_ota_config || g_ota_config->status.error_code != ESP_OK
+            || g_ota_config->status.written_size == g_ota_config->status.total_size) {
+        return ESP_OK;
+    }
+
+    for (size_t i = 0; i < ESPNOW_OTA_PARITY_SPAN; ++i) {
+        if (i && !ESPNOW_OTA_GET_BITS(parity->mask, i - 1)) {
+            continue;
         }
 
-        /**< Send ESP_EVENT_ESPNOW_OTA_FINISH event to the event handler */
-        g_ota_finished_flag = true;
-        g_ota_config->status.type = ESPNOW_OTA_TYPE_STATUS;
+        ESP_ERROR_RETURN(parity->seq + i >= g_ota_config->status.packet_num,
+                         ESP_ERR_INVALID_ARG, "parity->seq: %d", parity->seq);
 
-        /**< Response firmware upgrade status to root node. */
-        ret = espnow_send(ESPNOW_DATA_TYPE_OTA_STATUS, src_addr, &g_ota_config->status,
-                          sizeof(espnow_ota_status_t), &g_frame_config, portMAX_DELAY);
-        ESP_ERROR_RETURN(ret != ESP_OK, ret, "espnow_send");
-    
-        esp_event_post(ESP_EVENT_ESPNOW, ESP_EVENT_ESPNOW_OTA_FINISH, NULL, 0, 0);
+        if (!ESPNOW_OTA_GET_BITS(g_ota_config->status.progress_array, parity->seq + i)) {
+            missing_seq = parity->seq + i;
+            missing_num++;
+        }
     }
 
-    return ESP_OK;
+    /**< Nothing to recover, or more than one unknown in the XOR */
+    if (missing_num != 1) {
+        return ESP_OK;
+    }
+
+    espnow_ota_packet_t *packet = ESP_MALLOC(sizeof(espnow_ota_packet_t) + ESPNOW_OTA_PACKET_MAX_SIZE);
+    ESP_ERROR_RETURN(!packet, ESP_ERR_NO_MEM, "<ESP_ERR_NO_MEM> packet");
+    uint8_t *data = (uint8_t *)(packet + 1);
+
+    memcpy(packet->data, parity->data, ESPNOW_OTA_PACKET_MAX_SIZE);
+
+    for (size_t i = 0; i < ESPNOW_OTA_PARITY_SPAN; ++i) {
+        size_t seq = parity->seq + i;
+
+        if ((i && !ESPNOW_OTA_GET_BITS(parity->mask, i - 1)) || seq == missing_seq) {
+            continue;
+        }
+
+        size_t data_size = (seq == g_ota_config->status.packet_num - 1) ?
+                           g_ota_config->status.total_size - seq * ESPNOW_OTA_PACKET_MAX_SIZE : ESPNOW_OTA_PACKET_MAX_SIZE;
+        ret = esp_partition_read(g_ota_config->partition, g_ota_config->packed_offset + seq * ESPNOW_OTA_PACKET_MAX_SIZE,
+                                 data, data_size);
+        ESP_ERROR_GOTO(ret != ESP_OK, EXIT, "<%s> esp_partition_read", esp_err_to_name(ret));
+
+        for (size_t j = 0; j < data_size; ++j) {
+            packet->data[j] ^= data[j];
+        }
+    }
+
+    packet->type = ESPNOW_OTA_TYPE_DATA;
+    packet->seq  = missing_seq;
+    packet->size = (missing_seq == g_ota_config->status.packet_num - 1) ?
+                   g_ota_config->status.total_size - missing_seq * ESPNOW_OTA_PACKET_MAX_SIZE : ESPNOW_OTA_PACKET_MAX_SIZE;
+
+    ESP_LOGD(TAG, "Recovered packet_seq: %d from parity_seq: %d", packet->seq, parity->seq);
+    ret = espnow_ota_write(src_addr, packet, sizeof(espnow_ota_packet_t));
+
+EXIT:
+    ESP_FREE(packet);
+    return ret;
 }
 
 esp_err_t espnow_ota_responder_get_status(espnow_ota_status_t *status)
@@ -368,6 +582,16 @@ esp_err_t espnow_ota_responder_get_status(espnow_ota_status_t *status)
     return ESP_OK;
 }
 
+esp_err_t espnow_ota_responder_get_unpacked_size(size_t *size)
+{
+    ESP_PARAM_CHECK(size);
+    ESP_ERROR_RETURN(!g_ota_config, ESP_ERR_NOT_SUPPORTED, "Mupgrade firmware is not initialized");
+
+    *size = g_ota_config->unpacked_size;
+
+    return ESP_OK;
+}
+
 esp_err_t espnow_ota_responder_stop()
 {
     esp_err_t ret = ESP_OK;
@@ -416,6 +640,7 @@ static esp_err_t espnow_ota_responder_data_process(uint8_t *src_addr, void *data
             break;
 
         case ESPNOW_OTA_TYPE_STATUS:
+        case ESPNOW_OTA_TYPE_STATUS_PACKED:
             ESP_LOGD(TAG, "ESPNOW_OTA_TYPE_STATUS");
             ret = espnow_ota_status_handle(src_addr, (espnow_ota_status_t *)data, size);
             break;
@@ -425,6 +650,11 @@ static esp_err_t espnow_ota_responder_data_process(uint8_t *src_addr, void *data
             ret = espnow_ota_write(src_addr, (espnow_ota_packet_t *)data, size);
             break;
 
+        case ESPNOW_OTA_TYPE_PARITY:
+            ESP_LOGD(TAG, "ESPNOW_OTA_TYPE_PARITY");
+            ret = espnow_ota_parity_write(src_addr, (espnow_ota_parity_t *)data, size);
+            break;
+
         default:
             break;
     }
@@ -438,7 +668,11 @@ esp_err_t espnow_ota_responder_start(const espnow_ota_config_t *config)
 {
     ESP_PARAM_CHECK(config);
 
-    g_espnow_ota_config = ESP_MALLOC(sizeof(espnow_ota_config_t));
+    if (!g_espnow_ota_config) {
+        g_espnow_ota_config = ESP_MALLOC(sizeof(espnow_ota_config_t));
+        ESP_ERROR_RETURN(!g_espnow_ota_config, ESP_ERR_NO_MEM, "<ESP_ERR_NO_MEM> g_espnow_ota_config");
+    }
+
     memcpy(g_espnow_ota_config, config, sizeof(espnow_ota_config_t));
     espnow_set_config_for_data_type(ESPNOW_DATA_TYPE_OTA_DATA, 1, espnow_ota_responder_data_process);
 
@@ -0,0 +1,1010 @@
+// Copyright 2024 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Unpacks the images made by gen_custom_ota.py of cmake_utilities:
+ *
+ *   [app image header] packed header | payload
+ *
+ * The payload is the firmware, or a delta against the running firmware, either
+ * stored as is or xz compressed. Data, e.g. a model, is unpacked the same way
+ * into a data partition, a delta is then made against the data in use. The xz
+ * decoder keeps a window of the LZMA2 dictionary in RAM, matches further back
+ * are read from the firmware already written, which only works when the payload
+ * is not a delta.
+ *
+ * A delta is a list of controls, each followed by its bytes:
+ *
+ *   new size (uint32_t) | add len, extra len, seek | diff bytes | extra bytes | ...
+ *
+ * The lengths are LEB128, seek is a zigzag LEB128. add len bytes of the running
+ * firmware from the current position are added to the diff bytes, the extra bytes
+ * are copied, then the position in the running firmware moves by seek.
+ */
+
+#include <string.h>
+
+#include "esp_system.h"
+#include "esp_crc.h"
+#include "esp_ota_ops.h"
+
+#include "espnow_utils.h"
+#include "espnow_ota_unpack.h"
+
+#ifndef CONFIG_ESPNOW_OTA_UNPACK_WINDOW_SIZE
+#define CONFIG_ESPNOW_OTA_UNPACK_WINDOW_SIZE    (16 * 1024)
+#endif
+
+#define UNPACK_HEADER_V1_LEN        80
+#define UNPACK_HEADER_V2_LEN        88
+#define UNPACK_HEADER_V3_LEN        40
+#define UNPACK_APP_HEADER_LEN       288
+#define UNPACK_COMPRESS_NONE        0
+#define UNPACK_COMPRESS_XZ          1
+#define UNPACK_DELTA_NONE           0
+#define UNPACK_DELTA_ADD_EXTRA      1
+#define UNPACK_INPUT_SIZE           256
+#define UNPACK_CACHE_SIZE           128
+#define UNPACK_OUTPUT_SIZE          256
+#define UNPACK_SECTOR_SIZE          4096
+
+#define LZMA_STATES                 12
+#define LZMA_LIT_STATES             7
+#define LZMA_POS_STATES_MAX         16
+#define LZMA_MATCH_LEN_MIN          2
+#define LZMA_MATCH_LEN_MAX          273
+#define LZMA_DIST_STATES            4
+#define LZMA_DIST_SLOTS             64
+#define LZMA_DIST_MODEL_END         14
+#define LZMA_FULL_DISTANCES         128
+#define LZMA_ALIGN_BITS             4
+#define LZMA_PROB_INIT              1024
+
+/**< Offsets of the length decoders */
+#define LZMA_LEN_CHOICE             0
+#define LZMA_LEN_CHOICE2            1
+#define LZMA_LEN_LOW                2
+#define LZMA_LEN_MID                (LZMA_LEN_LOW + LZMA_POS_STATES_MAX * 8)
+#define LZMA_LEN_HIGH               (LZMA_LEN_MID + LZMA_POS_STATES_MAX * 8)
+#define LZMA_LEN_SIZE               (LZMA_LEN_HIGH + 256)
+
+/**< Offsets of the probabilities, the literal coders come last and depend on lc + lp */
+#define LZMA_IS_MATCH               0
+#define LZMA_IS_REP                 (LZMA_IS_MATCH + LZMA_STATES * LZMA_POS_STATES_MAX)
+#define LZMA_IS_REP_G0              (LZMA_IS_REP + LZMA_STATES)
+#define LZMA_IS_REP_G1              (LZMA_IS_REP_G0 + LZMA_STATES)
+#define LZMA_IS_REP_G2              (LZMA_IS_REP_G1 + LZMA_STATES)
+#define LZMA_IS_REP0_LONG           (LZMA_IS_REP_G2 + LZMA_STATES)
+#define LZMA_DIST_SLOT              (LZMA_IS_REP0_LONG + LZMA_STATES * LZMA_POS_STATES_MAX)
+#define LZMA_DIST_SPECIAL           (LZMA_DIST_SLOT + LZMA_DIST_STATES * LZMA_DIST_SLOTS)
+#define LZMA_DIST_ALIGN             (LZMA_DIST_SPECIAL + 1 + LZMA_FULL_DISTANCES - LZMA_DIST_MODEL_END)
+#define LZMA_LEN                    (LZMA_DIST_ALIGN + (1 << LZMA_ALIGN_BITS))
+#define LZMA_REP_LEN                (LZMA_LEN + LZMA_LEN_SIZE)
+#define LZMA_LITERAL                (LZMA_REP_LEN + LZMA_LEN_SIZE)
+#define LZMA_PROBS_NUM(lc_lp)       (LZMA_LITERAL + (0x300 << (lc_lp)))
+
+typedef enum {
+    DELTA_SIZE,
+    DELTA_CONTROL,
+    DELTA_ADD,
+    DELTA_EXTRA,
+} delta_step_t;
+
+typedef struct espnow_ota_unpack_s espnow_ota_unpack_t;
+typedef esp_err_t (*unpack_sink_t)(espnow_ota_unpack_t *u, const uint8_t *data, size_t size);
+
+struct espnow_ota_unpack_s {
+    esp_err_t error;                    /**< First error, stops the decoding */
+    const esp_partition_t *partition;   /**< Update partition, holds both the packed and the unpacked image */
+    esp_ota_handle_t handle;            /**< Only for an app partition, a data partition is written as it is */
+    size_t limit;                       /**< The packed image starts here */
+    size_t written;                     /**< Bytes of firmware written */
+    size_t erased;                      /**< A data partition is erased up to here as it is written */
+    unpack_sink_t sink;                 /**< Takes the payload once uncompressed */
+
+    struct {
+        size_t offset;                  /**< Partition offset of the byte after in_buf */
+        size_t end;
+        size_t pos;
+        size_t len;
+        uint8_t buf[UNPACK_INPUT_SIZE];
+    } in;
+
+    struct {
+        uint8_t *buf;                   /**< Ring with the end of the dictionary */
+        size_t size;
+        size_t pos;
+        size_t flushed;                 /**< Bytes from here to pos are not handed to the sink yet */
+        uint32_t total;                 /**< Bytes since the last dictionary reset */
+        uint32_t limit;                 /**< Dictionary size of the block */
+        size_t base;                    /**< Output offset of the last dictionary reset */
+        size_t out;                     /**< Bytes handed to the sink */
+        bool from_flash;                /**< Older bytes than the ring may be read back from the output */
+        size_t cache_offset;
+        uint8_t cache[UNPACK_CACHE_SIZE];
+        uint32_t crc;
+    } dict;
+
+    struct {
+        uint32_t range;
+        uint32_t code;
+        uint32_t state;
+        uint32_t rep[4];
+        uint8_t lc;
+        uint8_t lp;
+        uint8_t pb;
+        uint16_t *probs;
+        size_t probs_num;
+    } lzma;
+
+    struct {
+        uint8_t step;
+        uint8_t field;
+        uint8_t shift;
+        uint32_t value;
+        uint32_t new_size;
+        uint32_t add;
+        uint32_t extra;
+        int32_t seek;
+        size_t base_pos;                /**< Position in the base */
+        const esp_partition_t *base;    /**< What the delta was made against */
+        size_t cache_offset;
+        size_t cache_len;
+        uint8_t cache[UNPACK_CACHE_SIZE];
+        size_t out_len;
+        uint8_t out[UNPACK_OUTPUT_SIZE];
+    } delta;
+};
+
+static const char *TAG = "espnow_ota_unpack";
+
+static inline uint32_t unpack_le32(const uint8_t *data)
+{
+    return data[0] | data[1] << 8 | data[2] << 16 | (uint32_t)data[3] << 24;
+}
+
+static void unpack_fail(espnow_ota_unpack_t *u, esp_err_t err)
+{
+    if (u->error == ESP_OK) {
+        u->error = err;
+    }
+}
+
+static bool unpack_in_fill(espnow_ota_unpack_t *u)
+{
+    size_t size = u->in.end - u->in.offset;
+    size = size < UNPACK_INPUT_SIZE ? size : UNPACK_INPUT_SIZE;
+
+    if (!size) {
+        ESP_LOGW(TAG, "The packed image ends early");
+        unpack_fail(u, ESP_ERR_INVALID_CRC);
+        return false;
+    }
+
+    esp_err_t ret = esp_partition_read(u->partition, u->in.offset, u->in.buf, size);
+
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "<%s> esp_partition_read", esp_err_to_name(ret));
+        unpack_fail(u, ret);
+        return false;
+    }
+
+    u->in.offset += size;
+    u->in.pos = 0;
+    u->in.len = size;
+    return true;
+}
+
+static inline uint8_t unpack_in_byte(espnow_ota_unpack_t *u)
+{
+    if (u->in.pos == u->in.len && !unpack_in_fill(u)) {
+        return 0;
+    }
+
+    return u->in.buf[u->in.pos++];
+}
+
+/**
+ * @brief Offset in the partition of the next byte of input
+ */
+static inline size_t unpack_in_offset(const espnow_ota_unpack_t *u)
+{
+    return u->in.offset - u->in.len + u->in.pos;
+}
+
+static esp_err_t unpack_image_write(espnow_ota_unpack_t *u, const uint8_t *data, size_t size)
+{
+    ESP_ERROR_RETURN(u->written + size > u->limit, ESP_ERR_INVALID_SIZE,
+                     "The firmware would overwrite the packed image, written: %d, limit: %d", u->written + size, u->limit);
+
+    esp_err_t ret = ESP_OK;
+
+    if (u->partition->type == ESP_PARTITION_TYPE_APP) {
+        ret = esp_ota_write(u->handle, data, size);
+        ESP_ERROR_RETURN(ret != ESP_OK, ret, "<%s> esp_ota_write", esp_err_to_name(ret));
+    } else {
+        if (u->written + size > u->erased) {
+            size_t end = (u->written + size + UNPACK_SECTOR_SIZE - 1) & ~(UNPACK_SECTOR_SIZE - 1);
+            ret = esp_partition_erase_range(u->partition, u->erased, end - u->erased);
+            ESP_ERROR_RETURN(ret != ESP_OK, ret, "<%s> esp_partition_erase_range", esp_err_to_name(ret));
+            u->erased = end;
+        }
+
+        ret = esp_partition_write(u->partition, u->written, data, size);
+        ESP_ERROR_RETURN(ret != ESP_OK, ret, "<%s> esp_partition_write", esp_err_to_name(ret));
+    }
+
+    u->written += size;
+    return ESP_OK;
+}
+
+static inline uint8_t delta_base_byte(espnow_ota_unpack_t *u, size_t offset)
+{
+    if (offset - u->delta.cache_offset >= u->delta.cache_len) {
+        size_t len = offset < u->delta.base->size ? u->delta.base->size - offset : 0;
+        len = len < UNPACK_CACHE_SIZE ? len : UNPACK_CACHE_SIZE;
+
+        if (!len || esp_partition_read(u->delta.base, offset, u->delta.cache, len) != ESP_OK) {
+            ESP_LOGW(TAG, "The delta reads the base at 0x%x", offset);
+            unpack_fail(u, ESP_ERR_INVALID_CRC);
+            return 0;
+        }
+
+        u->delta.cache_offset = offset;
+        u->delta.cache_len = len;
+    }
+
+    return u->delta.cache[offset - u->delta.cache_offset];
+}
+
+static inline void delta_put(espnow_ota_unpack_t *u, uint8_t data)
+{
+    u->delta.out[u->delta.out_len++] = data;
+
+    if (u->delta.out_len == UNPACK_OUTPUT_SIZE) {
+        unpack_fail(u, unpack_image_write(u, u->delta.out, u->delta.out_len));
+        u->delta.out_len = 0;
+    }
+}
+
+/**
+ * @brief Move on once the bytes of a control are done
+ */
+static void delta_next(espnow_ota_unpack_t *u)
+{
+    if (u->delta.step == DELTA_CONTROL && u->delta.add) {
+        u->delta.step = DELTA_ADD;
+    } else if (u->delta.step != DELTA_EXTRA && u->delta.extra) {
+        u->delta.step = DELTA_EXTRA;
+    } else {
+        u->delta.base_pos += u->delta.seek;
+        u->delta.step = DELTA_CONTROL;
+    }
+}
+
+static esp_err_t unpack_delta_write(espnow_ota_unpack_t *u, const uint8_t *data, size_t size)
+{
+    for (size_t i = 0; i < size && u->error == ESP_OK; ++i) {
+        switch (u->delta.step) {
+            case DELTA_SIZE:
+                u->delta.new_size |= (uint32_t)data[i] << (8 * u->delta.field);
+
+                if (++u->delta.field == 4) {
+                    u->delta.field = 0;
+                    u->delta.step = DELTA_CONTROL;
+                }
+
+                break;
+
+            case DELTA_CONTROL:
+                ESP_ERROR_RETURN(u->delta.shift > 28, ESP_ERR_INVALID_CRC, "Delta control too long");
+                u->delta.value |= (uint32_t)(data[i] & 0x7f) << u->delta.shift;
+                u->delta.shift += 7;
+
+                if (data[i] & 0x80) {
+                    break;
+                }
+
+                if (u->delta.field == 0) {
+                    u->delta.add = u->delta.value;
+                } else if (u->delta.field == 1) {
+                    u->delta.extra = u->delta.value;
+                } else {
+                    u->delta.seek = (int32_t)(u->delta.value >> 1) ^ -(int32_t)(u->delta.value & 1);
+                }
+
+                u->delta.value = 0;
+                u->delta.shift = 0;
+
+                if (++u->delta.field == 3) {
+                    u->delta.field = 0;
+                    delta_next(u);
+                }
+
+                break;
+
+            case DELTA_ADD:
+                delta_put(u, delta_base_byte(u, u->delta.base_pos++) + data[i]);
+
+                if (!--u->delta.add) {
+                    delta_next(u);
+                }
+
+                break;
+
+            case DELTA_EXTRA:
+                delta_put(u, data[i]);
+
+                if (!--u->delta.extra) {
+                    delta_next(u);
+                }
+
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    return u->error;
+}
+
+/**
+ * @brief Hand the bytes added to the dictionary since the last call to the sink
+ */
+static void dict_flush(espnow_ota_unpack_t *u)
+{
+    size_t size = u->dict.pos - u->dict.flushed;
+
+    if (!size || u->error != ESP_OK) {
+        return;
+    }
+
+    const uint8_t *data = u->dict.buf + u->dict.flushed;
+    u->dict.crc = esp_crc32_le(u->dict.crc, data, size);
+    u->dict.out += size;
+    u->dict.flushed = u->dict.pos;
+    unpack_fail(u, u->sink(u, data, size));
+}
+
+static inline void dict_put(espnow_ota_unpack_t *u, uint8_t data)
+{
+    u->dict.buf[u->dict.pos++] = data;
+    u->dict.total++;
+
+    /**< Half a ring ahead of the reads from flash, see dict_get() */
+    if (u->dict.pos == u->dict.size || u->dict.pos - u->dict.flushed >= u->dict.size / 2) {
+        dict_flush(u);
+
+        if (u->dict.pos == u->dict.size) {
+            u->dict.pos = 0;
+            u->dict.flushed = 0;
+        }
+    }
+}
+
+/**
+ * @brief Byte dist back in the dictionary, 1 is the last one
+ *
+ * Older bytes than the ring were written to flash at least half a ring ago, so
+ * neither an encrypted write still held back nor a match reaching forward can miss.
+ */
+static inline uint8_t dict_get(espnow_ota_unpack_t *u, uint32_t dist)
+{
+    if (dist <= u->dict.size) {
+        return u->dict.buf[u->dict.pos >= dist ? u->dict.pos - dist : u->dict.pos + u->dict.size - dist];
+    }
+
+    size_t offset = u->dict.base + u->dict.total - dist;
+
+    if (offset - u->dict.cache_offset >= UNPACK_CACHE_SIZE) {
+        esp_err_t ret = esp_partition_read(u->partition, offset, u->dict.cache, UNPACK_CACHE_SIZE);
+
+        if (ret != ESP_OK) {
+            ESP_LOGW(TAG, "<%s> esp_partition_read", esp_err_to_name(ret));
+            unpack_fail(u, ret);
+            return 0;
+        }
+
+        u->dict.cache_offset = offset;
+    }
+
+    return u->dict.cache[offset - u->dict.cache_offset];
+}
+
+static void dict_reset(espnow_ota_unpack_t *u)
+{
+    dict_flush(u);
+    u->dict.total = 0;
+    u->dict.base = u->dict.out;
+    u->dict.cache_offset = SIZE_MAX / 2;
+}
+
+static inline void rc_normalize(espnow_ota_unpack_t *u)
+{
+    if (u->lzma.range < (1 << 24)) {
+        u->lzma.range <<= 8;
+        u->lzma.code = (u->lzma.code << 8) | unpack_in_byte(u);
+    }
+}
+
+static inline uint32_t rc_bit(espnow_ota_unpack_t *u, uint16_t *prob)
+{
+    uint32_t bound = (u->lzma.range >> 11) * *prob;
+    uint32_t bit = 0;
+
+    if (u->lzma.code < bound) {
+        u->lzma.range = bound;
+        *prob += (2048 - *prob) >> 5;
+    } else {
+        u->lzma.range -= bound;
+        u->lzma.code -= bound;
+        *prob -= *prob >> 5;
+        bit = 1;
+    }
+
+    rc_normalize(u);
+    return bit;
+}
+
+static uint32_t rc_bittree(espnow_ota_unpack_t *u, uint16_t *probs, uint32_t bits)
+{
+    uint32_t m = 1;
+
+    for (uint32_t i = 0; i < bits; ++i) {
+        m = (m << 1) | rc_bit(u, probs + m);
+    }
+
+    return m - (1 << bits);
+}
+
+static uint32_t rc_bittree_reverse(espnow_ota_unpack_t *u, uint16_t *probs, uint32_t bits)
+{
+    uint32_t m = 1;
+    uint32_t symbol = 0;
+
+    for (uint32_t i = 0; i < bits; ++i) {
+        uint32_t bit = rc_bit(u, probs + m);
+        m = (m << 1) | bit;
+        symbol |= bit << i;
+    }
+
+    return symbol;
+}
+
+static uint32_t rc_direct(espnow_ota_unpack_t *u, uint32_t bits)
+{
+    uint32_t result = 0;
+
+    for (uint32_t i = 0; i < bits; ++i) {
+        u->lzma.range >>= 1;
+        u->lzma.code -= u->lzma.range;
+        uint32_t mask = 0 - (u->lzma.code >> 31);
+        u->lzma.code += u->lzma.range & mask;
+        result = (result << 1) + (mask + 1);
+        rc_normalize(u);
+    }
+
+    return result;
+}
+
+static void lzma_reset(espnow_ota_unpack_t *u)
+{
+    for (size_t i = 0; i < LZMA_PROBS_NUM(u->lzma.lc + u->lzma.lp); ++i) {
+        u->lzma.probs[i] = LZMA_PROB_INIT;
+    }
+
+    u->lzma.state = 0;
+    memset(u->lzma.rep, 0, sizeof(u->lzma.rep));
+}
+
+static esp_err_t lzma_props(espnow_ota_unpack_t *u, uint8_t props)
+{
+    ESP_ERROR_RETURN(props >= 9 * 5 * 5, ESP_ERR_INVALID_CRC, "LZMA properties: 0x%02x", props);
+
+    u->lzma.lc = props % 9;
+    u->lzma.lp = props / 9 % 5;
+    u->lzma.pb = props / 45;
+    ESP_ERROR_RETURN(u->lzma.lc + u->lzma.lp > 4, ESP_ERR_INVALID_CRC, "LZMA2 lc + lp: %d", u->lzma.lc + u->lzma.lp);
+
+    size_t probs_num = LZMA_PROBS_NUM(u->lzma.lc + u->lzma.lp);
+
+    if (probs_num > u->lzma.probs_num) {
+        ESP_FREE(u->lzma.probs);
+        u->lzma.probs = ESP_MALLOC(probs_num * sizeof(uint16_t));
+        u->lzma.probs_num = u->lzma.probs ? probs_num : 0;
+        ESP_ERROR_RETURN(!u->lzma.probs, ESP_ERR_NO_MEM, "<ESP_ERR_NO_MEM> LZMA probabilities: %d", probs_num);
+    }
+
+    return ESP_OK;
+}
+
+static uint32_t lzma_len(espnow_ota_unpack_t *u, uint16_t *probs, uint32_t pos_state)
+{
+    if (!rc_bit(u, probs + LZMA_LEN_CHOICE)) {
+        return rc_bittree(u, probs + LZMA_LEN_LOW + pos_state * 8, 3);
+    }
+
+    if (!rc_bit(u, probs + LZMA_LEN_CHOICE2)) {
+        return 8 + rc_bittree(u, probs + LZMA_LEN_MID + pos_state * 8, 3);
+    }
+
+    return 16 + rc_bittree(u, probs + LZMA_LEN_HIGH, 8);
+}
+
+static uint32_t lzma_dist(espnow_ota_unpack_t *u, uint32_t len)
+{
+    uint32_t dist_state = len < LZMA_DIST_STATES - 1 ? len : LZMA_DIST_STATES - 1;
+    uint32_t slot = rc_bittree(u, u->lzma.probs + LZMA_DIST_SLOT + dist_state * LZMA_DIST_SLOTS, 6);
+
+    if (slot < 4) {
+        return slot;
+    }
+
+    uint32_t bits = (slot >> 1) - 1;
+    uint32_t dist = (2 | (slot & 1)) << bits;
+
+    if (slot < LZMA_DIST_MODEL_END) {
+        return dist + rc_bittree_reverse(u, u->lzma.probs + LZMA_DIST_SPECIAL + dist - slot, bits);
+    }
+
+    dist += rc_direct(u, bits - LZMA_ALIGN_BITS) << LZMA_ALIGN_BITS;
+    return dist + rc_bittree_reverse(u, u->lzma.probs + LZMA_DIST_ALIGN, LZMA_ALIGN_BITS);
+}
+
+static void lzma_literal(espnow_ota_unpack_t *u)
+{
+    uint32_t prev = u->dict.total ? dict_get(u, 1) : 0;
+    uint32_t lit_state = ((u->dict.total & ((1 << u->lzma.lp) - 1)) << u->lzma.lc) + (prev >> (8 - u->lzma.lc));
+    uint16_t *probs = u->lzma.probs + LZMA_LITERAL + 0x300 * lit_state;
+    uint32_t symbol = 1;
+
+    if (u->lzma.state >= LZMA_LIT_STATES) {
+        uint32_t match = dict_get(u, u->lzma.rep[0] + 1);
+
+        do {
+            uint32_t match_bit = (match >> 7) & 1;
+            match <<= 1;
+            uint32_t bit = rc_bit(u, probs + ((1 + match_bit) << 8) + symbol);
+            symbol = (symbol << 1) | bit;
+
+            if (match_bit != bit) {
+                break;
+            }
+        } while (symbol < 0x100);
+    }
+
+    while (symbol < 0x100) {
+        symbol = (symbol << 1) | rc_bit(u, probs + symbol);
+    }
+
+    dict_put(u, symbol - 0x100);
+    u->lzma.state = u->lzma.state < 4 ? 0 : (u->lzma.state < 10 ? u->lzma.state - 3 : u->lzma.state - 6);
+}
+
+/**
+ * @brief Decode LZMA symbols until size bytes came out
+ */
+static esp_err_t lzma_decode(espnow_ota_unpack_t *u, uint32_t size)
+{
+    uint16_t *probs = u->lzma.probs;
+    uint32_t pos_mask = (1 << u->lzma.pb) - 1;
+    uint32_t *rep = u->lzma.rep;
+
+    while (size && u->error == ESP_OK) {
+        uint32_t pos_state = u->dict.total & pos_mask;
+        uint32_t state = u->lzma.state;
+        uint32_t len = 0;
+
+        if (!rc_bit(u, probs + LZMA_IS_MATCH + state * LZMA_POS_STATES_MAX + pos_state)) {
+            lzma_literal(u);
+            size--;
+            continue;
+        }
+
+        if (!rc_bit(u, probs + LZMA_IS_REP + state)) {
+            len = lzma_len(u, probs + LZMA_LEN, pos_state);
+            u->lzma.state = state < LZMA_LIT_STATES ? 7 : 10;
+            rep[3] = rep[2];
+            rep[2] = rep[1];
+            rep[1] = rep[0];
+            rep[0] = lzma_dist(u, len);
+        } else {
+            if (!rc_bit(u, probs + LZMA_IS_REP_G0 + state)) {
+                if (!rc_bit(u, probs + LZMA_IS_REP0_LONG + state * LZMA_POS_STATES_MAX + pos_state)) {
+                    ESP_ERROR_RETURN(rep[0] >= u->dict.total, ESP_ERR_INVALID_CRC, "LZMA distance: %u", rep[0]);
+                    u->lzma.state = state < LZMA_LIT_STATES ? 9 : 11;
+                    dict_put(u, dict_get(u, rep[0] + 1));
+                    size--;
+                    continue;
+                }
+            } else {
+                uint32_t dist = 0;
+
+                if (!rc_bit(u, probs + LZMA_IS_REP_G1 + state)) {
+                    dist = rep[1];
+                } else {
+                    if (!rc_bit(u, probs + LZMA_IS_REP_G2 + state)) {
+                        dist = rep[2];
+                    } else {
+                        dist = rep[3];
+                        rep[3] = rep[2];
+                    }
+
+                    rep[2] = rep[1];
+                }
+
+                rep[1] = rep[0];
+                rep[0] = dist;
+            }
+
+            len = lzma_len(u, probs + LZMA_REP_LEN, pos_state);
+            u->lzma.state = state < LZMA_LIT_STATES ? 8 : 11;
+        }
+
+        len += LZMA_MATCH_LEN_MIN;
+        ESP_ERROR_RETURN(rep[0] >= u->dict.total || rep[0] >= u->dict.limit || len > size,
+                         ESP_ERR_INVALID_CRC, "LZMA match, distance: %u, len: %u", rep[0], len);
+
+        for (size -= len; len > 0; --len) {
+            dict_put(u, dict_get(u, rep[0] + 1));
+        }
+    }
+
+    return u->error;
+}
+
+static esp_err_t lzma2_decode(espnow_ota_unpack_t *u)
+{
+    bool need_dict_reset = true;
+    bool need_props = true;
+
+    while (u->error == ESP_OK) {
+        uint8_t control = unpack_in_byte(u);
+
+        if (control == 0x00) {
+            return u->error;
+        }
+
+        ESP_ERROR_RETURN(control > 0x02 && control < 0x80, ESP_ERR_INVALID_CRC, "LZMA2 control: 0x%02x", control);
+
+        if (control == 0x01 || control >= 0xe0) {
+            dict_reset(u);
+            need_dict_reset = false;
+            need_props = true;
+        } else {
+            ESP_ERROR_RETURN(need_dict_reset, ESP_ERR_INVALID_CRC, "LZMA2 starts without a dictionary reset");
+        }
+
+        uint32_t size = (control >= 0x80 ? (control & 0x1f) << 16 : 0) + (unpack_in_byte(u) << 8);
+        size += unpack_in_byte(u) + 1;
+
+        /**< Stored chunk */
+        if (control < 0x80) {
+            for (; size > 0 && u->error == ESP_OK; --size) {
+                dict_put(u, unpack_in_byte(u));
+            }
+
+            continue;
+        }
+
+        uint32_t packed_size = unpack_in_byte(u) << 8;
+        packed_size += unpack_in_byte(u) + 1;
+
+        if (control >= 0xc0) {
+            unpack_fail(u, lzma_props(u, unpack_in_byte(u)));
+            ESP_ERROR_RETURN(u->error != ESP_OK, u->error, "lzma_props");
+            need_props = false;
+        }
+
+        ESP_ERROR_RETURN(need_props, ESP_ERR_INVALID_CRC, "LZMA2 chunk without properties");
+
+        if (control >= 0xa0) {
+            lzma_reset(u);
+        }
+
+        size_t start = unpack_in_offset(u);
+        u->lzma.range = 0xffffffff;
+        u->lzma.code = 0;
+
+        for (int i = 0; i < 5; ++i) {
+            u->lzma.code = (u->lzma.code << 8) | unpack_in_byte(u);
+        }
+
+        unpack_fail(u, lzma_decode(u, size));
+        ESP_ERROR_RETURN(u->error != ESP_OK, u->error, "lzma_decode");
+        ESP_ERROR_RETURN(unpack_in_offset(u) - start != packed_size, ESP_ERR_INVALID_CRC,
+                         "LZMA2 chunk size: %d, expected: %d", unpack_in_offset(u) - start, packed_size);
+    }
+
+    return u->error;
+}
+
+static bool xz_varint(const uint8_t *data, size_t size, size_t *pos, uint32_t *value)
+{
+    *value = 0;
+
+    for (int shift = 0; *pos < size && shift < 32; shift += 7) {
+        uint8_t byte = data[(*pos)++];
+        *value |= (uint32_t)(byte & 0x7f) << shift;
+
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Decode the blocks of an xz stream, the index and the footer after them are not read
+ */
+static esp_err_t xz_decode(espnow_ota_unpack_t *u)
+{
+    static const uint8_t xz_magic[6] = { 0xfd, '7', 'z', 'X', 'Z', 0x00 };
+    uint8_t header[64] = {0};
+
+    for (int i = 0; i < 12; ++i) {
+        header[i] = unpack_in_byte(u);
+    }
+
+    ESP_ERROR_RETURN(memcmp(header, xz_magic, sizeof(xz_magic)) || header[6]
+                     || esp_crc32_le(0, header + 6, 2) != unpack_le32(header + 8),
+                     ESP_ERR_INVALID_CRC, "Not an xz stream");
+
+    uint8_t check = header[7] & 0x0f;
+    size_t check_size = check ? 4 << ((check - 1) / 3) : 0;
+
+    while (u->error == ESP_OK) {
+        size_t block_start = unpack_in_offset(u);
+        size_t header_size = (unpack_in_byte(u) + 1) * 4;
+
+        /**< Index indicator, all blocks are done */
+        if (header_size == 4) {
+            break;
+        }
+
+        ESP_ERROR_RETURN(header_size > sizeof(header), ESP_ERR_NOT_SUPPORTED, "xz block header size: %d", header_size);
+
+        for (size_t i = 1; i < header_size; ++i) {
+            header[i] = unpack_in_byte(u);
+        }
+
+        header[0] = header_size / 4 - 1;
+        ESP_ERROR_RETURN(esp_crc32_le(0, header, header_size - 4) != unpack_le32(header + header_size - 4),
+                         ESP_ERR_INVALID_CRC, "xz block header CRC");
+
+        size_t pos = 2;
+        uint32_t value = 0;
+        uint32_t filter = 0;
+        uint32_t props_size = 0;
+
+        ESP_ERROR_RETURN(header[1] & 0x03, ESP_ERR_NOT_SUPPORTED, "Only LZMA2 is decoded, filters: %d", (header[1] & 0x03) + 1);
+        ESP_ERROR_RETURN((header[1] & 0x40) && !xz_varint(header, header_size, &pos, &value), ESP_ERR_INVALID_CRC, "xz compressed size");
+        ESP_ERROR_RETURN((header[1] & 0x80) && !xz_varint(header, header_size, &pos, &value), ESP_ERR_INVALID_CRC, "xz uncompressed size");
+        ESP_ERROR_RETURN(!xz_varint(header, header_size, &pos, &filter) || !xz_varint(header, header_size, &pos, &props_size)
+                         || filter != 0x21 || props_size != 1 || pos >= header_size - 4 || header[pos] > 40,
+                         ESP_ERR_NOT_SUPPORTED, "Only LZMA2 is decoded, filter: 0x%x", filter);
+
+        uint8_t dict_bits = header[pos];
+        u->dict.limit = dict_bits == 40 ? UINT32_MAX : (2 | (dict_bits & 1)) << (dict_bits / 2 + 11);
+        size_t ring_size = u->dict.limit < CONFIG_ESPNOW_OTA_UNPACK_WINDOW_SIZE ? u->dict.limit : CONFIG_ESPNOW_OTA_UNPACK_WINDOW_SIZE;
+
+        ESP_ERROR_RETURN(!u->dict.from_flash && ring_size < u->dict.limit, ESP_ERR_NOT_SUPPORTED,
+                         "A delta must be compressed with a dictionary of at most %d bytes, not %u",
+                         CONFIG_ESPNOW_OTA_UNPACK_WINDOW_SIZE, u->dict.limit);
+
+        if (ring_size != u->dict.size) {
+            dict_flush(u);
+            ESP_FREE(u->dict.buf);
+            u->dict.buf = ESP_MALLOC(ring_size);
+            ESP_ERROR_RETURN(!u->dict.buf, ESP_ERR_NO_MEM, "<ESP_ERR_NO_MEM> Dictionary: %d", ring_size);
+            u->dict.size = ring_size;
+            u->dict.pos = 0;
+            u->dict.flushed = 0;
+        }
+
+        u->dict.crc = 0;
+        unpack_fail(u, lzma2_decode(u));
+        ESP_ERROR_RETURN(u->error != ESP_OK, u->error, "lzma2_decode");
+        dict_flush(u);
+
+        for (size_t padding = (unpack_in_offset(u) - block_start) % 4; padding && padding < 4; ++padding) {
+            ESP_ERROR_RETURN(unpack_in_byte(u), ESP_ERR_INVALID_CRC, "xz block padding");
+        }
+
+        for (size_t i = 0; i < check_size; ++i) {
+            header[i] = unpack_in_byte(u);
+        }
+
+        ESP_ERROR_RETURN(check == 0x01 && unpack_le32(header) != u->dict.crc, ESP_ERR_INVALID_CRC,
+                         "xz block CRC32, read: 0x%08x, calculated: 0x%08x", unpack_le32(header), u->dict.crc);
+    }
+
+    return u->error;
+}
+
+bool espnow_ota_unpack_check(const uint8_t *data, size_t size)
+{
+    if (size >= 4 && !memcmp(data, "ESP", 4)) {
+        return true;
+    }
+
+    /**< gen_custom_ota.py --add_app_header puts a copy of the app header in front */
+    return size >= UNPACK_APP_HEADER_LEN + 4 && data[0] == ESP_IMAGE_HEADER_MAGIC
+           && !memcmp(data + UNPACK_APP_HEADER_LEN, "ESP", 4);
+}
+
+/**
+ * @brief Check the base is the one the delta was made against
+ */
+static esp_err_t unpack_base_check(espnow_ota_unpack_t *u, size_t size, uint32_t crc)
+{
+    uint32_t calc = 0;
+
+    for (size_t offset = 0; offset < size; offset += UNPACK_CACHE_SIZE) {
+        size_t len = size - offset < UNPACK_CACHE_SIZE ? size - offset : UNPACK_CACHE_SIZE;
+        esp_err_t ret = esp_partition_read(u->delta.base, offset, u->delta.cache, len);
+        ESP_ERROR_RETURN(ret != ESP_OK, ret, "<%s> esp_partition_read", esp_err_to_name(ret));
+        calc = esp_crc32_le(calc, u->delta.cache, len);
+    }
+
+    ESP_ERROR_RETURN(calc != crc, ESP_ERR_INVALID_CRC, "The delta is for another base, CRC32: 0x%08x, %s: 0x%08x",
+                     crc, u->delta.base->label, calc);
+    return ESP_OK;
+}
+
+esp_err_t espnow_ota_unpack(const esp_partition_t *partition, size_t offset, size_t size,
+                            const esp_partition_t *base, size_t *unpacked_size)
+{
+    ESP_PARAM_CHECK(partition);
+    ESP_PARAM_CHECK(offset + size <= partition->size);
+
+    esp_err_t ret = ESP_OK;
+    uint8_t header[UNPACK_HEADER_V2_LEN] = {0};
+    size_t header_offset = offset;
+    size_t header_len = 0;
+    espnow_ota_unpack_t *u = ESP_CALLOC(1, sizeof(espnow_ota_unpack_t));
+    ESP_ERROR_RETURN(!u, ESP_ERR_NO_MEM, "<ESP_ERR_NO_MEM> espnow_ota_unpack_t");
+
+    u->partition = partition;
+    u->limit = offset;
+    u->delta.base = base ? base : esp_ota_get_running_partition();
+    u->delta.cache_offset = SIZE_MAX / 2;
+    u->dict.cache_offset = SIZE_MAX / 2;
+
+    ret = esp_partition_read(partition, offset, header, 1);
+    ESP_ERROR_GOTO(ret != ESP_OK, EXIT, "<%s> esp_partition_read", esp_err_to_name(ret));
+
+    if (header[0] == ESP_IMAGE_HEADER_MAGIC) {
+        header_offset += UNPACK_APP_HEADER_LEN;
+    }
+
+    ret = esp_partition_read(partition, header_offset, header, UNPACK_HEADER_V3_LEN);
+    ESP_ERROR_GOTO(ret != ESP_OK, EXIT, "<%s> esp_partition_read", esp_err_to_name(ret));
+
+    switch (header[4]) {
+        case 1:
+            header_len = UNPACK_HEADER_V1_LEN;
+            break;
+
+        case 2:
+            header_len = UNPACK_HEADER_V2_LEN;
+            break;
+
+        case 3:
+            header_len = UNPACK_HEADER_V3_LEN;
+            break;
+
+        default:
+            break;
+    }
+
+    ret = ESP_ERR_NOT_SUPPORTED;
+    ESP_ERROR_GOTO(memcmp(header, "ESP", 4) || !header_len, EXIT, "Packed header, version: %d", header[4]);
+
+    ret = esp_partition_read(partition, header_offset, header, header_len);
+    ESP_ERROR_GOTO(ret != ESP_OK, EXIT, "<%s> esp_partition_read", esp_err_to_name(ret));
+
+    ret = ESP_ERR_INVALID_CRC;
+    ESP_ERROR_GOTO(esp_crc32_le(0, header, header_len - 4) != unpack_le32(header + header_len - 4), EXIT, "Packed header CRC32");
+
+    /**< The MD5 of the payload is not checked, the xz CRC32, the base CRC32 and the
+         validation of the firmware by esp_ota_end() cover it, or the application for data */
+    uint8_t compress   = header[5] & 0x0f;
+    uint8_t delta      = header[5] >> 4;
+    size_t data_size   = unpack_le32(header + (header[4] < 3 ? 40 : 16));
+
+    u->in.offset = header_offset + header_len;
+    u->in.end    = u->in.offset + data_size;
+
+    ret = ESP_ERR_NOT_SUPPORTED;
+    ESP_ERROR_GOTO(compress > UNPACK_COMPRESS_XZ || delta > UNPACK_DELTA_ADD_EXTRA, EXIT,
+                   "Compress type: %d, delta type: %d", compress, delta);
+    ret = ESP_ERR_INVALID_SIZE;
+    ESP_ERROR_GOTO(u->in.end > offset + size, EXIT, "Payload size: %d, packed size: %d", data_size, size);
+
+    if (delta && header[4] == 2) {
+        ret = unpack_base_check(u, unpack_le32(header + 76), unpack_le32(header + 80));
+        ESP_ERROR_GOTO(ret != ESP_OK, EXIT, "unpack_base_check");
+    }
+
+    ESP_LOGI(TAG, "Unpack, compress type: %d, delta type: %d, payload: %d", compress, delta, data_size);
+
+    /**< esp_ota_begin() only takes app partitions, data is erased as it is written instead */
+    if (partition->type == ESP_PARTITION_TYPE_APP) {
+#ifdef OTA_WITH_SEQUENTIAL_WRITES
+        /**< Erase as it writes, the packed image is behind the end of the firmware */
+        ret = esp_ota_begin(partition, OTA_WITH_SEQUENTIAL_WRITES, &u->handle);
+#else
+        ret = esp_ota_begin(partition, offset, &u->handle);
+#endif
+        ESP_ERROR_GOTO(ret != ESP_OK, EXIT, "<%s> esp_ota_begin", esp_err_to_name(ret));
+    }
+
+    u->sink = delta ? unpack_delta_write : unpack_image_write;
+    u->dict.from_flash = !delta;
+
+    if (compress == UNPACK_COMPRESS_XZ) {
+        ret = xz_decode(u);
+    } else {
+        while (u->error == ESP_OK && (u->in.offset < u->in.end || u->in.pos < u->in.len)) {
+            if (u->in.pos == u->in.len && !unpack_in_fill(u)) {
+                break;
+            }
+
+            unpack_fail(u, u->sink(u, u->in.buf + u->in.pos, u->in.len - u->in.pos));
+            u->in.pos = u->in.len;
+        }
+
+        ret = u->error;
+    }
+
+    if (ret == ESP_OK && delta) {
+        if (u->delta.out_len) {
+            ret = unpack_image_write(u, u->delta.out, u->delta.out_len);
+        }
+
+        if (ret == ESP_OK && (u->delta.step != DELTA_CONTROL || u->delta.field || u->written != u->delta.new_size)) {
+            ESP_LOGW(TAG, "The delta ends early, written: %d, size: %d", u->written, u->delta.new_size);
+            ret = ESP_ERR_INVALID_CRC;
+        }
+    }
+
+    if (ret != ESP_OK) {
+        if (partition->type == ESP_PARTITION_TYPE_APP) {
+            esp_ota_abort(u->handle);
+        }
+
+        goto EXIT;
+    }
+
+    /**< Data is not validated here, the application checks it */
+    if (partition->type == ESP_PARTITION_TYPE_APP) {
+        ret = esp_ota_end(u->handle);
+        ESP_ERROR_GOTO(ret != ESP_OK, EXIT, "<%s> esp_ota_end", esp_err_to_name(ret));
+    }
+
+    if (unpacked_size) {
+        *unpacked_size = u->written;
+    }
+
+    ESP_LOGI(TAG, "Unpacked %d bytes into %d", size, u->written);
+
+EXIT:
+    ESP_FREE(u->dict.buf);
+    ESP_FREE(u->lzma.probs);
+    ESP_FREE(u);
+    return ret;
+}
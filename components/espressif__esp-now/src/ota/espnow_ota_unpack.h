@@ -0,0 +1,67 @@
+// Copyright 2024 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#pragma once
+
+#include "esp_partition.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /**< _cplusplus */
+
+/**
+ * @brief Bytes to read from the start of an image to tell whether it is packed,
+ *        a packed header may follow a copy of the app image header
+ */
+#define ESPNOW_OTA_UNPACK_PROBE_SIZE    (288 + 4)
+
+/**
+ * @brief Check if an image is packed by gen_custom_ota.py of cmake_utilities
+ *
+ * @param[in]  data  the first bytes of the image
+ * @param[in]  size  length of data, at least ESPNOW_OTA_UNPACK_PROBE_SIZE to see past an app header
+ *
+ * @return true if the image has to be unpacked by espnow_ota_unpack()
+ */
+bool espnow_ota_unpack_check(const uint8_t *data, size_t size);
+
+/**
+ * @brief Unpack an image stored in the update partition into the same partition
+ *
+ * The image may be xz compressed, a binary delta against base, or both. It is decoded
+ * as a stream with a few tens of KB of RAM and written from the start of the partition,
+ * so it must be stored behind the end of the result. An app partition is written with
+ * esp_ota_write() and validated, a data partition with esp_partition_write() and left
+ * to the application to check.
+ *
+ * @param[in]  partition  the update partition, an app or a data partition
+ * @param[in]  offset  where the packed image is stored in the partition, 4 KB aligned
+ * @param[in]  size  length of the packed image
+ * @param[in]  base  what a delta was made against, NULL for the running firmware
+ * @param[out] unpacked_size  length of the unpacked image, may be NULL
+ *
+ * @return
+ *    - ESP_OK
+ *    - ESP_ERR_NO_MEM
+ *    - ESP_ERR_NOT_SUPPORTED  header version, filter or dictionary that cannot be decoded here
+ *    - ESP_ERR_INVALID_CRC  the packed image is corrupted or the delta is for another base
+ *    - ESP_ERR_INVALID_SIZE  the unpacked image would overwrite the packed one
+ *    - ESP_ERR_OTA_VALIDATE_FAILED
+ */
+esp_err_t espnow_ota_unpack(const esp_partition_t *partition, size_t offset, size_t size,
+                            const esp_partition_t *base, size_t *unpacked_size);
+
+#ifdef __cplusplus
+}
+#endif /**< _cplusplus */
@@ -58,6 +58,7 @@ extern "C" {
 #define ESPNOW_OTA_PROGRESS_MAX_SIZE           (ESPNOW_DATA_LEN - 30)  /**< Maximum length of the array which indicates the packet processed */
 #define ESPNOW_OTA_PACKET_MAX_SIZE             ((ESPNOW_DATA_LEN - 4) - (ESPNOW_DATA_LEN -4) % 16)  /**< Maximum length of a single packet transmitted */
 #define ESPNOW_OTA_PACKET_MAX_NUM              (4 * 1024 * 1024/ ESPNOW_OTA_PACKET_MAX_SIZE) /**< The maximum number of packets */
+#define ESPNOW_OTA_PARITY_SPAN                 25  /**< Packets a parity packet can cover, its seq and the 24 following it */
 
 /**
  * @brief Bit operations to get and modify a bit in an array
@@ -91,6 +92,8 @@ typedef enum {
     ESPNOW_OTA_TYPE_INFO,
     ESPNOW_OTA_TYPE_DATA,
     ESPNOW_OTA_TYPE_STATUS,
+    ESPNOW_OTA_TYPE_PARITY,
+    ESPNOW_OTA_TYPE_STATUS_PACKED,              /**< Status request for an image to unpack after receiving */
 } espnow_ota_type_t;
 
 /**
@@ -103,12 +106,33 @@ typedef struct espnow_ota_packet_s {
     uint8_t data[ESPNOW_OTA_PACKET_MAX_SIZE];   /**< Firmware */
 } ESPNOW_PACKED_STRUCT espnow_ota_packet_t;
 
+/**
+ * @brief XOR of several firmware packets, each missed by a different responder
+ *
+ * A responder missing exactly one of the covered packets recovers it by XORing
+ * the others, read back from its update partition, into data. The last packet
+ * of the firmware is zero padded to ESPNOW_OTA_PACKET_MAX_SIZE.
+ */
+typedef struct espnow_ota_parity_s {
+    uint8_t type;                               /**< Type of packet, ESPNOW_OTA_TYPE_PARITY */
+    uint16_t seq;                               /**< First packet covered */
+    uint8_t mask[(ESPNOW_OTA_PARITY_SPAN - 1) / 8]; /**< Bit i set if packet seq + 1 + i is covered too */
+    uint8_t data[ESPNOW_OTA_PACKET_MAX_SIZE];   /**< XOR of the covered packets */
+} ESPNOW_PACKED_STRUCT espnow_ota_parity_t;
+
 /**
  * @brief Upgrade configuration
  */
 typedef struct espnow_ota_config_s {
     bool skip_version_check;          /**< Skip checking the running version with the upgrade version */
     uint8_t progress_report_interval; /**< Percentage interval to save OTA status and report ota status event */
+    const esp_partition_t *data_partition; /**< If set, images are written to this partition instead of the next
+                                                app partition: no app validation and no boot partition change. On
+                                                ESP_EVENT_ESPNOW_OTA_FINISH the application checks the data against
+                                                sha_256 of espnow_ota_responder_get_status(), or takes the size of a
+                                                packed image from espnow_ota_responder_get_unpacked_size() */
+    const esp_partition_t *data_base_partition; /**< What a delta sent to data_partition was made against, e.g. the
+                                                     partition of the data in use. NULL for the running firmware */
 } espnow_ota_config_t;
 
 /**
@@ -121,8 +145,9 @@ typedef struct espnow_ota_status_s {
     uint16_t packet_num;                    /**< Identify if each packet of data has been written */
     uint32_t total_size;                    /**< Total length of the firmware */
     uint32_t written_size;                  /**< The length of the flash has been written */
-    uint8_t progress_index;                 /**< Identify if each packet of data has been written */
-    uint8_t progress_array[0][ESPNOW_OTA_PROGRESS_MAX_SIZE]; /**< Identify if each packet of data has been written */
+    uint8_t progress_index;                 /**< Slice of ESPNOW_OTA_PROGRESS_MAX_SIZE bytes the bitmap in a reply starts at */
+    uint8_t progress_array[0][ESPNOW_OTA_PROGRESS_MAX_SIZE]; /**< Identify if each packet of data has been written.
+                                                                  A reply carries it up to the last missing packet */
 } ESPNOW_PACKED_STRUCT espnow_ota_status_t;
 
 /**
@@ -166,6 +191,14 @@ typedef esp_err_t (* espnow_ota_initiator_data_cb_t)(size_t src_offset, void *ds
 /**
  * @brief  Root sends firmware to other nodes
  *
+ * The firmware is broadcast to the group once. Then, in rounds, the status of every
+ * unfinished node is collected and each packet missed by any of them is sent once more,
+ * packets missed by different nodes XORed together into ESPNOW_OTA_TYPE_PARITY packets.
+ *
+ * An image packed by gen_custom_ota.py of cmake_utilities, compressed or as a delta against
+ * the firmware the nodes run, is detected from its first bytes. The nodes store it at the end
+ * of the update partition and unpack it there, size is then the length of the packed image.
+ *
  * @attention Only called at the root
  *
  * @param[in]  addrs_list  destination node mac list
@@ -237,6 +270,21 @@ esp_err_t espnow_ota_initiator_scan_result_free(void);
  */
 esp_err_t espnow_ota_responder_get_status(espnow_ota_status_t *status);
 
+/**
+ * @brief Get the size of the image the last upgrade unpacked into the data partition
+ *
+ * @note A packed image is checked by its CRC32s while it is unpacked, sha_256 of the status is that
+ *       of the packed image, not of the data
+ *
+ * @param[out] size  the unpacked size, 0 if the image was written as it is
+ *
+ * @return
+ *   - ESP_OK
+ *   - ESP_ERR_INVALID_ARG
+ *   - ESP_ERR_NOT_SUPPORTED
+ */
+esp_err_t espnow_ota_responder_get_unpacked_size(size_t *size);
+
 /**
  * @brief Stop upgrading
  *
@@ -249,6 +297,8 @@ esp_err_t espnow_ota_responder_stop();
 /**
  * @brief Start upgrading
  *
+ * @note Call it again to change the configuration, e.g. the data partition to write next
+ *
  * @param[in] config upgrade configuration
  * 
  * @return
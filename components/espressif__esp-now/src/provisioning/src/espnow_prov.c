@@ -167,11 +167,11 @@ esp_err_t espnow_prov_initiator_scan(espnow_addr_t responder_addr, espnow_prov_r
     g_prov_init->scan_info.addr = responder_addr;
 
     espnow_set_config_for_data_type(ESPNOW_DATA_TYPE_PROV, 1, espnow_prov_recv);
-    esp_wifi_get_country(&country);
+    espnow_radio_get_country(&country);
 
     while (g_prov_init->fix_ch == false && (wait_ticks == portMAX_DELAY || xTaskGetTickCount() - start_ticks < wait_ticks)) {
         for (int i = 0; i < country.nchan && g_prov_init->fix_ch == false; ++i) {
-            esp_wifi_set_channel(country.schan + i, WIFI_SECOND_CHAN_NONE);
+            espnow_radio_set_channel(country.schan + i, WIFI_SECOND_CHAN_NONE);
             ESP_LOGD(TAG, "espnow_send, channel: %d", country.schan + i);
             vTaskDelay(pdMS_TO_TICKS(ESPNOW_PROV_BEACON_INTERVAL + 10));
         }
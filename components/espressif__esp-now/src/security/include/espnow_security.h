@@ -129,6 +129,50 @@ esp_err_t espnow_sec_auth_decrypt(espnow_sec_t *sec, const uint8_t *input, size_
                     uint8_t *output, size_t output_len,
                     size_t *olen, size_t tag_len);
 
+/**
+ * @brief The authenticated encryption function with a nonce given per packet.
+ *        Encryption with 128 bit AES-CCM
+ *
+ * Unlike espnow_sec_auth_encrypt(), the nonce is not part of the key, so the key
+ * schedule of espnow_sec_setkey() serves every packet and nothing is allocated.
+ *
+ * @note  the tag will be appended to the ciphertext, output may be input to encrypt in place
+ *
+ * @param[in]   sec        the security info used for encryption.
+ * @param[in]   iv         the nonce, never to be used twice with the same key
+ * @param[in]   input      the buffer for the input data
+ * @param[in]   ilen       the length of the input data
+ * @param[out]  output     the buffer for the output data, at least ilen + tag_len bytes
+ * @param[in]   tag_len    the desired length of the authentication tag
+ *
+ * @return
+ *    - ESP_OK
+ *    - ESP_FAIL
+ */
+esp_err_t espnow_sec_auth_encrypt_iv(espnow_sec_t *sec, const uint8_t iv[IV_LEN], const uint8_t *input, size_t ilen,
+                                     uint8_t *output, size_t tag_len);
+
+/**
+ * @brief The authenticated decryption function with a nonce given per packet.
+ *        Decryption with 128 bit AES-CCM
+ *
+ * @note  the tag must be appended to the ciphertext, output may be input to decrypt in place
+ *
+ * @param[in]   sec        the security info used for decryption.
+ * @param[in]   iv         the nonce the packet was encrypted with
+ * @param[in]   input      the buffer for the input data
+ * @param[in]   ilen       the length of the input data, tag included
+ * @param[out]  output     the buffer for the output data, at least ilen - tag_len bytes
+ * @param[out]  olen       the actual number of bytes written to the output buffer
+ * @param[in]   tag_len    the length of the authentication tag
+ *
+ * @return
+ *    - ESP_OK
+ *    - ESP_FAIL
+ */
+esp_err_t espnow_sec_auth_decrypt_iv(espnow_sec_t *sec, const uint8_t iv[IV_LEN], const uint8_t *input, size_t ilen,
+                                     uint8_t *output, size_t *olen, size_t tag_len);
+
 #ifdef __cplusplus
 }
 #endif /**< _cplusplus */
@@ -133,3 +133,50 @@ esp_err_t espnow_sec_auth_decrypt(espnow_sec_t *sec, const uint8_t *input, size_
 
     return ret;
 }
+
+esp_err_t espnow_sec_auth_encrypt_iv(espnow_sec_t *sec, const uint8_t iv[IV_LEN], const uint8_t *input, size_t ilen,
+                                     uint8_t *output, size_t tag_len)
+{
+    ESP_PARAM_CHECK(sec);
+    ESP_PARAM_CHECK(iv);
+    ESP_PARAM_CHECK(input);
+    ESP_PARAM_CHECK(ilen);
+    ESP_PARAM_CHECK(output);
+    ESP_PARAM_CHECK(tag_len);
+
+    if (sec->state != ESPNOW_SEC_OVER) {
+        ESP_LOGE(TAG, "Security state is not over");
+        return ESP_FAIL;
+    }
+
+    int ret = mbedtls_ccm_encrypt_and_tag((mbedtls_ccm_context *)sec->cipher_ctx, ilen, iv, IV_LEN, NULL, 0,
+                                          input, output, output + ilen, tag_len);
+    ESP_ERROR_RETURN(ret != 0, ESP_FAIL, "mbedtls_ccm_encrypt_and_tag %x", ret);
+
+    return ESP_OK;
+}
+
+esp_err_t espnow_sec_auth_decrypt_iv(espnow_sec_t *sec, const uint8_t iv[IV_LEN], const uint8_t *input, size_t ilen,
+                                     uint8_t *output, size_t *olen, size_t tag_len)
+{
+    ESP_PARAM_CHECK(sec);
+    ESP_PARAM_CHECK(iv);
+    ESP_PARAM_CHECK(input);
+    ESP_PARAM_CHECK(output);
+    ESP_PARAM_CHECK(olen);
+    ESP_PARAM_CHECK(tag_len);
+    ESP_PARAM_CHECK(ilen > tag_len);
+
+    if (sec->state != ESPNOW_SEC_OVER) {
+        ESP_LOGE(TAG, "Security state is not over");
+        return ESP_FAIL;
+    }
+
+    ilen -= tag_len;
+    int ret = mbedtls_ccm_auth_decrypt((mbedtls_ccm_context *)sec->cipher_ctx, ilen, iv, IV_LEN, NULL, 0,
+                                       input, output, input + ilen, tag_len);
+    ESP_ERROR_RETURN(ret != 0, ESP_FAIL, "mbedtls_ccm_auth_decrypt %x", ret);
+    *olen = ilen;
+
+    return ESP_OK;
+}
@@ -0,0 +1,95 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include "espnow.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /**< _cplusplus */
+
+/**
+ * @brief Largest window, the selective ACK covers this many frames
+ */
+#define ESPNOW_STREAM_WINDOW_MAX        32
+
+/**
+ * @brief Bytes of the stream carried by one frame
+ */
+#define ESPNOW_STREAM_PAYLOAD_LEN       (ESPNOW_DATA_LEN - 6)
+
+/**
+ * @brief Configuration of the reliable stream, both ends should use the same window
+ */
+typedef struct {
+    uint8_t window;                     /**< Frames in flight before an ACK is needed, 1 to ESPNOW_STREAM_WINDOW_MAX */
+    uint8_t peer_num;                   /**< Senders a receiver keeps reorder state for, the least recently used one is dropped */
+    uint8_t max_retries;                /**< Timeouts in a row before espnow_stream_write() gives up */
+    bool security;                      /**< Encrypt the frames, needs sec_enable and a key */
+    uint16_t rto_min_ms;                /**< Lower bound of the retransmission timeout */
+    uint16_t rto_max_ms;                /**< Upper bound of the retransmission timeout */
+} espnow_stream_config_t;
+
+#define ESPNOW_STREAM_CONFIG_DEFAULT() { \
+    .window = 16, \
+    .peer_num = 4, \
+    .max_retries = 10, \
+    .security = false, \
+    .rto_min_ms = 20, \
+    .rto_max_ms = 1000, \
+}
+
+/**
+ * @brief Start sending and receiving reliable streams
+ *
+ * The stream is sent as ESPNOW_DATA_TYPE_STREAM frames, up to a window of them back to
+ * back. The receiver puts them back in order and answers with cumulative and selective
+ * ACKs, the sender resends what is missing after a timeout derived from the round trip time.
+ *
+ * @param[in]  config  window, peers and timeouts
+ * @param[in]  handle  called in order with each piece of a stream received from a peer.
+ *                     A new espnow_stream_write() on the sender starts a new stream
+ *
+ * @return
+ *    - ESP_OK
+ *    - ESP_ERR_INVALID_ARG
+ *    - ESP_ERR_NO_MEM
+ */
+esp_err_t espnow_stream_init(const espnow_stream_config_t *config, handler_for_data_t handle);
+
+/**
+ * @brief Stop the reliable stream and free the reorder buffers
+ *
+ * @return
+ *    - ESP_OK
+ *    - ESP_ERR_INVALID_STATE
+ */
+esp_err_t espnow_stream_deinit(void);
+
+/**
+ * @brief Send data reliably and in order to one device
+ *
+ * Blocks until every frame has been acknowledged. data is read in place and must stay
+ * valid until then. Writes from several tasks are serialized.
+ *
+ * @param[in]  dest_addr  destination MAC address
+ * @param[in]  data  data to send
+ * @param[in]  size  length of data
+ * @param[in]  wait_ticks  the maximum time for the whole transfer
+ *
+ * @return
+ *    - ESP_OK
+ *    - ESP_ERR_INVALID_ARG
+ *    - ESP_ERR_INVALID_STATE
+ *    - ESP_ERR_TIMEOUT
+ *    - ESP_ERR_WIFI_TIMEOUT  the receiver stopped acknowledging
+ */
+esp_err_t espnow_stream_write(const espnow_addr_t dest_addr, const void *data, size_t size, TickType_t wait_ticks);
+
+#ifdef __cplusplus
+}
+#endif /**< _cplusplus */
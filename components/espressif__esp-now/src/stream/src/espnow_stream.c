@@ -0,0 +1,539 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/param.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include "esp_wifi.h"
+#include "esp_now.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(4, 4, 0)
+#include "esp_mac.h"
+#include "esp_random.h"
+#else
+#include "esp_system.h"
+#endif
+
+#include "espnow.h"
+#include "espnow_mem.h"
+#include "espnow_stream.h"
+#include "espnow_utils.h"
+
+#define STREAM_FLAG_ACK_REQ             BIT0    /**< The receiver should answer this frame right away */
+#define STREAM_SACK_QUEUE_SIZE          8
+
+typedef enum {
+    STREAM_KIND_DATA,
+    STREAM_KIND_SACK,
+} stream_kind_t;
+
+typedef struct {
+    uint8_t kind;
+    uint8_t flags;
+    uint16_t session;                   /**< Picked by the sender for each write */
+    uint16_t seq;
+    uint8_t payload[0];
+} __attribute__((packed)) stream_data_t;
+
+typedef struct {
+    uint8_t kind;
+    uint8_t flags;
+    uint16_t session;
+    uint16_t cum;                       /**< Every frame before this one has been received */
+    uint16_t echo;                      /**< The frame that caused this ACK, for the round trip time */
+    uint32_t bitmap;                    /**< Bit i set: frame cum + 1 + i has been received */
+} __attribute__((packed)) stream_sack_t;
+
+typedef struct {
+    uint8_t addr[ESPNOW_ADDR_LEN];
+    stream_sack_t sack;
+} stream_sack_evt_t;
+
+/**
+ * @brief Frame of the write in progress, the data stays in the caller's buffer
+ */
+typedef struct {
+    const uint8_t *data;
+    uint16_t len;
+    uint8_t tx_count;
+    bool acked;
+    uint32_t order;                     /**< Position of the last transmission among all of the write */
+    int64_t sent_us;
+} stream_tx_slot_t;
+
+/**
+ * @brief Reorder state for one sender, buf is a ring of window frames, expected + i is
+ *        in slot (head + i) % window. Slots do not follow seq, which wraps at 65536.
+ */
+typedef struct {
+    uint8_t addr[ESPNOW_ADDR_LEN];
+    bool valid;
+    uint16_t session;
+    uint16_t last_session;
+    uint16_t expected;
+    uint8_t head;                       /**< Slot of expected in buf */
+    uint32_t received;                  /**< Bit i set: expected + 1 + i is in buf */
+    uint8_t since_ack;
+    TickType_t used_ticks;
+    uint16_t len[ESPNOW_STREAM_WINDOW_MAX];
+    uint8_t *buf;
+} stream_peer_t;
+
+static const char *TAG = "espnow_stream";
+
+static espnow_stream_config_t *g_stream_config = NULL;
+static handler_for_data_t g_stream_handle = NULL;
+static stream_peer_t *g_stream_peers = NULL;
+static SemaphoreHandle_t g_stream_write_lock = NULL;
+static QueueHandle_t g_stream_sack_queue = NULL;
+static uint16_t g_stream_session;
+
+static esp_err_t stream_frame_send(const uint8_t *dest_addr, const void *frame, size_t size)
+{
+    espnow_frame_head_t frame_head = {
+        .broadcast = true,
+        .retransmit_count = 1,
+        .security = g_stream_config->security,
+    };
+
+    return espnow_send(ESPNOW_DATA_TYPE_STREAM, dest_addr, frame, size, &frame_head, portMAX_DELAY);
+}
+
+static stream_peer_t *stream_peer_get(const uint8_t *addr)
+{
+    stream_peer_t *oldest = &g_stream_peers[0];
+    TickType_t now = xTaskGetTickCount();
+
+    for (size_t i = 0; i < g_stream_config->peer_num; ++i) {
+        stream_peer_t *peer = &g_stream_peers[i];
+
+        if (peer->valid && ESPNOW_ADDR_IS_EQUAL(peer->addr, addr)) {
+            peer->used_ticks = now;
+            return peer;
+        }
+
+        if (!peer->valid || (oldest->valid && (int32_t)(peer->used_ticks - oldest->used_ticks) < 0)) {
+            oldest = peer;
+        }
+    }
+
+    /**
+     * Taking the state of a stream in progress would break it for good, the new
+     * sender is ignored instead and retries until a peer has been quiet for the
+     * longest retransmission timeout
+     */
+    if (oldest->valid && now - oldest->used_ticks < pdMS_TO_TICKS(g_stream_config->rto_max_ms)) {
+        ESP_LOGD(TAG, "No room for " MACSTR ", all peers are busy", MAC2STR(addr));
+        return NULL;
+    }
+
+    if (!oldest->buf) {
+        oldest->buf = ESP_MALLOC(g_stream_config->window * ESPNOW_STREAM_PAYLOAD_LEN);
+
+        if (!oldest->buf) {
+            ESP_LOGW(TAG, "Allocate stream reorder buffer fail");
+            return NULL;
+        }
+    }
+
+    ESP_LOGD(TAG, "New peer " MACSTR ", replaces " MACSTR, MAC2STR(addr), MAC2STR(oldest->addr));
+
+    memcpy(oldest->addr, addr, ESPNOW_ADDR_LEN);
+    oldest->valid = true;
+    oldest->session = 0;
+    oldest->last_session = 0;
+    oldest->expected = 0;
+    oldest->head = 0;
+    oldest->received = 0;
+    oldest->since_ack = 0;
+    oldest->used_ticks = xTaskGetTickCount();
+
+    return oldest;
+}
+
+static void stream_sack_send(stream_peer_t *peer, uint16_t echo)
+{
+    stream_sack_t sack = {
+        .kind = STREAM_KIND_SACK,
+        .session = peer->session,
+        .cum = peer->expected,
+        .echo = echo,
+        .bitmap = peer->received,
+    };
+
+    peer->since_ack = 0;
+
+    if (stream_frame_send(peer->addr, &sack, sizeof(sack)) != ESP_OK) {
+        ESP_LOGD(TAG, "Send selective ACK to " MACSTR " fail", MAC2STR(peer->addr));
+    }
+}
+
+static void stream_data_process(uint8_t *src_addr, const stream_data_t *frame, size_t size,
+                                wifi_pkt_rx_ctrl_t *rx_ctrl)
+{
+    stream_peer_t *peer = stream_peer_get(src_addr);
+    size_t len = size - sizeof(stream_data_t);
+
+    if (!peer || len > ESPNOW_STREAM_PAYLOAD_LEN) {
+        return;
+    }
+
+    if (frame->session != peer->session) {
+        /**< Late frames of the stream before are ignored, anything else starts a new one */
+        if (frame->session == peer->last_session) {
+            return;
+        }
+
+        peer->last_session = peer->session;
+        peer->session = frame->session;
+        peer->expected = 0;
+        peer->head = 0;
+        peer->received = 0;
+        peer->since_ack = 0;
+    }
+
+    int16_t offset = (int16_t)(frame->seq - peer->expected);
+    bool in_order = offset == 0;
+
+    if (offset == 0) {
+        g_stream_handle(src_addr, (void *)frame->payload, len, rx_ctrl);
+        peer->expected++;
+        peer->head = (peer->head + 1) % g_stream_config->window;
+
+        /**< Hand over what has been waiting behind this frame */
+        while (peer->received & 1) {
+            uint8_t index = peer->head;
+
+            peer->received >>= 1;
+            g_stream_handle(src_addr, peer->buf + index * ESPNOW_STREAM_PAYLOAD_LEN, peer->len[index], rx_ctrl);
+            peer->expected++;
+            peer->head = (peer->head + 1) % g_stream_config->window;
+        }
+
+        peer->received >>= 1;
+    } else if (offset > 0 && offset < g_stream_config->window) {
+        uint8_t index = (peer->head + offset) % g_stream_config->window;
+
+        if (!(peer->received & BIT(offset - 1))) {
+            memcpy(peer->buf + index * ESPNOW_STREAM_PAYLOAD_LEN, frame->payload, len);
+            peer->len[index] = len;
+            peer->received |= BIT(offset - 1);
+        }
+    } else if (offset > 0) {
+        ESP_LOGD(TAG, "Frame %d beyond the window, expected %d", frame->seq, peer->expected);
+        return;
+    }
+
+    /**< Gaps and duplicates are answered at once, in order frames every quarter window */
+    if ((frame->flags & STREAM_FLAG_ACK_REQ) || !in_order
+            || ++peer->since_ack >= MAX(g_stream_config->window / 4, 1)) {
+        stream_sack_send(peer, frame->seq);
+    }
+}
+
+static esp_err_t espnow_stream_recv(uint8_t *src_addr, void *data,
+                                    size_t size, wifi_pkt_rx_ctrl_t *rx_ctrl)
+{
+    ESP_PARAM_CHECK(src_addr);
+    ESP_PARAM_CHECK(data);
+
+    uint8_t kind = ((uint8_t *)data)[0];
+
+    if (kind == STREAM_KIND_DATA && size >= sizeof(stream_data_t)) {
+        stream_data_process(src_addr, data, size, rx_ctrl);
+    } else if (kind == STREAM_KIND_SACK && size >= sizeof(stream_sack_t) && g_stream_sack_queue) {
+        stream_sack_evt_t evt;
+
+        memcpy(evt.addr, src_addr, ESPNOW_ADDR_LEN);
+        memcpy(&evt.sack, data, sizeof(stream_sack_t));
+
+        if (xQueueSend(g_stream_sack_queue, &evt, 0) != pdPASS) {
+            ESP_LOGD(TAG, "Selective ACK queue full");
+        }
+    }
+
+    return ESP_OK;
+}
+
+esp_err_t espnow_stream_init(const espnow_stream_config_t *config, handler_for_data_t handle)
+{
+    ESP_PARAM_CHECK(config);
+    ESP_PARAM_CHECK(handle);
+    ESP_PARAM_CHECK(config->window > 0 && config->window <= ESPNOW_STREAM_WINDOW_MAX);
+    ESP_PARAM_CHECK(config->peer_num > 0);
+    ESP_PARAM_CHECK(config->rto_min_ms > 0 && config->rto_min_ms <= config->rto_max_ms);
+
+    if (g_stream_config) {
+        return ESP_OK;
+    }
+
+    g_stream_config = ESP_MALLOC(sizeof(espnow_stream_config_t));
+    g_stream_peers = ESP_CALLOC(config->peer_num, sizeof(stream_peer_t));
+    g_stream_write_lock = xSemaphoreCreateMutex();
+    g_stream_sack_queue = xQueueCreate(STREAM_SACK_QUEUE_SIZE, sizeof(stream_sack_evt_t));
+
+    if (!g_stream_config || !g_stream_peers || !g_stream_write_lock || !g_stream_sack_queue) {
+        ESP_LOGE(TAG, "Create stream resources fail");
+        espnow_stream_deinit();
+        return ESP_ERR_NO_MEM;
+    }
+
+    memcpy(g_stream_config, config, sizeof(espnow_stream_config_t));
+    g_stream_handle = handle;
+
+    return espnow_set_config_for_data_type(ESPNOW_DATA_TYPE_STREAM, true, espnow_stream_recv);
+}
+
+esp_err_t espnow_stream_deinit(void)
+{
+    ESP_ERROR_RETURN(!g_stream_config && !g_stream_peers, ESP_ERR_INVALID_STATE, "Stream is not initialized");
+
+    espnow_set_config_for_data_type(ESPNOW_DATA_TYPE_STREAM, false, NULL);
+
+    if (g_stream_peers) {
+        for (size_t i = 0; g_stream_config && i < g_stream_config->peer_num; ++i) {
+            ESP_FREE(g_stream_peers[i].buf);
+        }
+
+        ESP_FREE(g_stream_peers);
+        g_stream_peers = NULL;
+    }
+
+    if (g_stream_write_lock) {
+        vSemaphoreDelete(g_stream_write_lock);
+        g_stream_write_lock = NULL;
+    }
+
+    if (g_stream_sack_queue) {
+        vQueueDelete(g_stream_sack_queue);
+        g_stream_sack_queue = NULL;
+    }
+
+    ESP_FREE(g_stream_config);
+    g_stream_config = NULL;
+    g_stream_handle = NULL;
+
+    return ESP_OK;
+}
+
+/**
+ * @brief Sender side of one write
+ */
+typedef struct {
+    const uint8_t *dest_addr;
+    uint16_t session;
+    uint32_t base;                      /**< Oldest frame not acknowledged */
+    uint32_t next;                      /**< Next frame never sent */
+    uint32_t total;
+    uint32_t order;
+    int64_t srtt_us;
+    int64_t rttvar_us;
+    int64_t rto_us;
+    stream_tx_slot_t slots[ESPNOW_STREAM_WINDOW_MAX];
+    uint8_t frame[ESPNOW_DATA_LEN];
+} stream_tx_t;
+
+static esp_err_t stream_tx_frame(stream_tx_t *tx, uint32_t seq, bool ack_req)
+{
+    stream_tx_slot_t *slot = &tx->slots[seq % ESPNOW_STREAM_WINDOW_MAX];
+    stream_data_t *frame = (stream_data_t *)tx->frame;
+
+    frame->kind = STREAM_KIND_DATA;
+    frame->flags = ack_req ? STREAM_FLAG_ACK_REQ : 0;
+    frame->session = tx->session;
+    frame->seq = (uint16_t)seq;
+    memcpy(frame->payload, slot->data, slot->len);
+
+    slot->tx_count++;
+    slot->order = ++tx->order;
+    slot->sent_us = esp_timer_get_time();
+
+    return stream_frame_send(tx->dest_addr, frame, sizeof(stream_data_t) + slot->len);
+}
+
+static void stream_tx_rtt_sample(stream_tx_t *tx, int64_t sample_us)
+{
+    /**< Jacobson/Karels, as in RFC 6298 */
+    if (!tx->srtt_us) {
+        tx->srtt_us = sample_us;
+        tx->rttvar_us = sample_us / 2;
+    } else {
+        int64_t err = sample_us - tx->srtt_us;
+        tx->rttvar_us += ((err < 0 ? -err : err) - tx->rttvar_us) / 4;
+        tx->srtt_us += err / 8;
+    }
+
+    tx->rto_us = MIN(MAX(tx->srtt_us + 4 * tx->rttvar_us, g_stream_config->rto_min_ms * 1000LL),
+                     g_stream_config->rto_max_ms * 1000LL);
+}
+
+/**
+ * @return Transmission order of the acknowledged frame, 0 if it is outside the window
+ */
+static uint32_t stream_tx_ack(stream_tx_t *tx, uint32_t seq)
+{
+    if (seq < tx->base || seq >= tx->next) {
+        return 0;
+    }
+
+    tx->slots[seq % ESPNOW_STREAM_WINDOW_MAX].acked = true;
+    return tx->slots[seq % ESPNOW_STREAM_WINDOW_MAX].order;
+}
+
+static esp_err_t stream_tx_sack_process(stream_tx_t *tx, const stream_sack_t *sack)
+{
+    esp_err_t ret = ESP_OK;
+
+    /**< Sequence numbers are 16 bit on air, the window keeps them unambiguous */
+    uint32_t cum = tx->base + (uint16_t)(sack->cum - (uint16_t)tx->base);
+    uint32_t echo = tx->base + (int16_t)(sack->echo - (uint16_t)tx->base);
+    uint32_t acked_order = 0;
+
+    if (cum > tx->next) {
+        return ESP_OK;
+    }
+
+    if (echo >= tx->base && echo < tx->next) {
+        stream_tx_slot_t *slot = &tx->slots[echo % ESPNOW_STREAM_WINDOW_MAX];
+
+        /**< Karn: only frames sent once give a round trip time */
+        if (slot->tx_count == 1 && !slot->acked) {
+            stream_tx_rtt_sample(tx, esp_timer_get_time() - slot->sent_us);
+        }
+    }
+
+    for (uint32_t seq = tx->base; seq < cum; ++seq) {
+        acked_order = MAX(acked_order, stream_tx_ack(tx, seq));
+    }
+
+    for (int i = 0; i < 32; ++i) {
+        if (sack->bitmap & BIT(i)) {
+            acked_order = MAX(acked_order, stream_tx_ack(tx, cum + 1 + i));
+        }
+    }
+
+    while (tx->base < tx->next && tx->slots[tx->base % ESPNOW_STREAM_WINDOW_MAX].acked) {
+        tx->base++;
+    }
+
+    /**
+     * Frames go out in order, so a frame still missing while one sent after it has
+     * arrived is lost. Each resend moves it behind everything sent so far.
+     */
+    for (uint32_t seq = tx->base; seq < tx->next; ++seq) {
+        stream_tx_slot_t *slot = &tx->slots[seq % ESPNOW_STREAM_WINDOW_MAX];
+
+        if (!slot->acked && slot->order < acked_order) {
+            ret = stream_tx_frame(tx, seq, false);
+            ESP_ERROR_BREAK(ret != ESP_OK, "Resend frame %" PRIu32 " fail", seq);
+        }
+    }
+
+    return ret;
+}
+
+esp_err_t espnow_stream_write(const espnow_addr_t dest_addr, const void *data, size_t size, TickType_t wait_ticks)
+{
+    ESP_PARAM_CHECK(dest_addr);
+    ESP_PARAM_CHECK(data);
+    ESP_PARAM_CHECK(size);
+    ESP_PARAM_CHECK(!ESPNOW_ADDR_IS_BROADCAST(dest_addr));
+    ESP_ERROR_RETURN(!g_stream_config, ESP_ERR_INVALID_STATE, "Stream is not initialized");
+
+    esp_err_t ret = ESP_OK;
+    TickType_t start_ticks = xTaskGetTickCount();
+    uint8_t timeouts = 0;
+    stream_sack_evt_t evt;
+
+    if (xSemaphoreTake(g_stream_write_lock, wait_ticks) != pdPASS) {
+        return ESP_ERR_TIMEOUT;
+    }
+
+    stream_tx_t *tx = ESP_CALLOC(1, sizeof(stream_tx_t));
+
+    if (!tx) {
+        xSemaphoreGive(g_stream_write_lock);
+        return ESP_ERR_NO_MEM;
+    }
+
+    tx->dest_addr = dest_addr;
+    tx->total = (size + ESPNOW_STREAM_PAYLOAD_LEN - 1) / ESPNOW_STREAM_PAYLOAD_LEN;
+    tx->rto_us = g_stream_config->rto_min_ms * 4000LL;
+
+    /**< A fresh session tells the receiver that this is a new stream */
+    do {
+        tx->session = esp_random();
+    } while (tx->session == g_stream_session || !tx->session);
+
+    g_stream_session = tx->session;
+    xQueueReset(g_stream_sack_queue);
+
+    while (tx->base < tx->total) {
+        while (tx->next < tx->total && tx->next - tx->base < g_stream_config->window) {
+            stream_tx_slot_t *slot = &tx->slots[tx->next % ESPNOW_STREAM_WINDOW_MAX];
+            size_t offset = (size_t)tx->next * ESPNOW_STREAM_PAYLOAD_LEN;
+
+            slot->data = (const uint8_t *)data + offset;
+            slot->len = MIN(size - offset, ESPNOW_STREAM_PAYLOAD_LEN);
+            slot->tx_count = 0;
+            slot->acked = false;
+            tx->next++;
+
+            ret = stream_tx_frame(tx, tx->next - 1, tx->next - tx->base == g_stream_config->window
+                                  || tx->next == tx->total);
+            ESP_ERROR_GOTO(ret != ESP_OK, EXIT, "Send frame %" PRIu32 " fail", tx->next - 1);
+        }
+
+        TickType_t elapsed = xTaskGetTickCount() - start_ticks;
+        ret = ESP_ERR_TIMEOUT;
+        ESP_ERROR_GOTO(wait_ticks != portMAX_DELAY && elapsed >= wait_ticks, EXIT, "Stream write timeout");
+        ret = ESP_OK;
+
+        TickType_t rto_ticks = MAX(pdMS_TO_TICKS(tx->rto_us / 1000), 1);
+
+        if (wait_ticks != portMAX_DELAY) {
+            rto_ticks = MIN(rto_ticks, wait_ticks - elapsed);
+        }
+
+        if (xQueueReceive(g_stream_sack_queue, &evt, rto_ticks) == pdPASS) {
+            if (ESPNOW_ADDR_IS_EQUAL(evt.addr, dest_addr) && evt.sack.session == tx->session) {
+                timeouts = 0;
+                ret = stream_tx_sack_process(tx, &evt.sack);
+                ESP_ERROR_GOTO(ret != ESP_OK, EXIT, "Process selective ACK fail");
+            }
+
+            continue;
+        }
+
+        /**< Nothing heard for a whole timeout, back off and ask for an ACK with the oldest frame */
+        ret = ESP_ERR_WIFI_TIMEOUT;
+        ESP_ERROR_GOTO(++timeouts > g_stream_config->max_retries, EXIT,
+                       "No ACK from " MACSTR " after %d timeouts", MAC2STR(dest_addr), timeouts - 1);
+
+        tx->rto_us = MIN(tx->rto_us * 2, g_stream_config->rto_max_ms * 1000LL);
+        ret = stream_tx_frame(tx, tx->base, true);
+        ESP_ERROR_GOTO(ret != ESP_OK, EXIT, "Resend frame %" PRIu32 " fail", tx->base);
+    }
+
+    ESP_LOGD(TAG, "Wrote %d bytes in %" PRIu32 " frames to " MACSTR ", srtt: %lld us",
+             size, tx->total, MAC2STR(dest_addr), tx->srtt_us);
+
+EXIT:
+    ESP_FREE(tx);
+    xSemaphoreGive(g_stream_write_lock);
+
+    return ret;
+}
@@ -28,6 +28,7 @@
 #include "esp_mac.h"
 #endif
 
+#include "espnow.h"
 #include "espnow_utils.h"
 
 static const char *TAG = "espnow_utils";
@@ -40,7 +41,7 @@ static void show_system_info_timercb(TimerHandle_t timer)
     wifi_ap_record_t ap_info  = {0};
 
     esp_wifi_get_mac(ESP_IF_WIFI_STA, sta_mac);
-    esp_wifi_get_channel(&primary, &second);
+    espnow_radio_get_channel(&primary, &second);
     esp_wifi_sta_get_ap_info(&ap_info);
 
     ESP_LOGI(TAG, "System information sta_mac: " MACSTR ", channel: [%d/%d], rssi: %d, free_heap: %u, minimum_heap: %u",
@@ -0,0 +1,8 @@
+// Host build stand-in for the IDF header, see espnow_sim.c
+#pragma once
+
+#include <stdint.h>
+
+uint32_t esp_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len);
+uint16_t esp_crc16_le(uint16_t crc, const uint8_t *buf, uint32_t len);
+uint8_t esp_crc8_le(uint8_t crc, const uint8_t *buf, uint32_t len);
@@ -0,0 +1,552 @@
+// Copyright 2024 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * The rest of the IDF the esp-now sources link against on the host:
+ * logging, error names, CRCs, the timer clock and events, the OTA partitions
+ * and the storage of each node, plus security, which the simulated nodes do
+ * not use. See espnow_sim.c.
+ */
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_crc.h"
+#include "esp_event.h"
+#include "esp_timer.h"
+#include "esp_wifi.h"
+#include "esp_ota_ops.h"
+#include "espnow_security.h"
+#include "espnow_storage.h"
+#include "espnow_mem.h"
+#include "freertos_sim.h"
+#include "espnow_radio_sim.h"
+
+ESP_EVENT_DEFINE_BASE(WIFI_EVENT);
+
+#define SIM_OTA_PARTITION_SIZE      (4 * 1024 * 1024)
+#define SIM_FLASH_SECTOR_SIZE       4096
+#define SIM_FLASH_BLOCK_SIZE        (64 * 1024)
+#define SIM_FLASH_BLOCK_ERASE_MS    150
+#define SIM_FLASH_ALIGN(size)       (((size) + SIM_FLASH_SECTOR_SIZE - 1) / SIM_FLASH_SECTOR_SIZE * SIM_FLASH_SECTOR_SIZE)
+
+static const esp_partition_t s_running_partition = {
+    .type = ESP_PARTITION_TYPE_APP, .subtype = 0x10, .address = 0x10000, .size = SIM_OTA_PARTITION_SIZE, .label = "ota_0",
+};
+static const esp_partition_t s_update_partition = {
+    .type = ESP_PARTITION_TYPE_APP, .subtype = 0x11, .address = 0x410000, .size = SIM_OTA_PARTITION_SIZE, .label = "ota_1",
+};
+/* data_0 holds the data in use, data_1 takes the next as an app does a model, in the memory of the update partition */
+static const esp_partition_t s_data_partition[] = {
+    {.type = ESP_PARTITION_TYPE_DATA, .subtype = 0x40, .address = 0x810000, .size = SIM_OTA_PARTITION_SIZE, .label = "data_0"},
+    {.type = ESP_PARTITION_TYPE_DATA, .subtype = 0x40, .address = 0xc10000, .size = SIM_OTA_PARTITION_SIZE, .label = "data_1"},
+};
+
+/* the update partition of each node, allocated when it is first erased */
+static struct {
+    uint8_t *data;
+    size_t erased;
+    size_t written;     /* where esp_ota_write() goes on */
+    size_t programmed;  /* bytes written in all, rewrites included */
+    bool boot;
+} s_ota[SIM_OTA_NODE_MAX];
+
+/* what each node keeps in NVS, it outlives espnow_sim_restart() like the partitions */
+typedef struct sim_blob {
+    struct sim_blob *next;
+    char key[16];
+    size_t len;
+    uint8_t value[];
+} sim_blob_t;
+
+static sim_blob_t *s_storage[SIM_OTA_NODE_MAX];
+
+/* every node runs the same firmware, a delta is made against it */
+static const uint8_t *s_running_image;
+static size_t s_running_size;
+
+/* and the same data, a delta sent as data is made against it */
+static const uint8_t *s_data_image;
+static size_t s_data_size;
+
+static esp_log_level_t s_log_level = ESP_LOG_WARN;
+
+void espnow_sim_set_log_level(esp_log_level_t level)
+{
+    s_log_level = level;
+}
+
+void espnow_sim_log(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    static const char letters[] = "NEWIDV";
+    va_list args;
+
+    if (level > s_log_level) {
+        return;
+    }
+
+    uint64_t now = sim_time_us();
+    printf("%c (%llu.%03llu) [%d] %s: ", letters[level], (unsigned long long) (now / 1000),
+           (unsigned long long) (now % 1000), espnow_sim_current(), tag);
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+    putchar('\n');
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return (int64_t) sim_time_us();
+}
+
+void esp_log_level_set(const char *tag, esp_log_level_t level)
+{
+    (void) tag;
+    (void) level;
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    static const struct {
+        esp_err_t code;
+        const char *name;
+    } names[] = {
+        { ESP_OK, "ESP_OK" },
+        { ESP_FAIL, "ESP_FAIL" },
+        { ESP_ERR_NO_MEM, "ESP_ERR_NO_MEM" },
+        { ESP_ERR_INVALID_ARG, "ESP_ERR_INVALID_ARG" },
+        { ESP_ERR_INVALID_STATE, "ESP_ERR_INVALID_STATE" },
+        { ESP_ERR_INVALID_SIZE, "ESP_ERR_INVALID_SIZE" },
+        { ESP_ERR_NOT_FOUND, "ESP_ERR_NOT_FOUND" },
+        { ESP_ERR_NOT_SUPPORTED, "ESP_ERR_NOT_SUPPORTED" },
+        { ESP_ERR_TIMEOUT, "ESP_ERR_TIMEOUT" },
+        { ESP_ERR_WIFI_NOT_INIT, "ESP_ERR_WIFI_NOT_INIT" },
+        { ESP_ERR_WIFI_TIMEOUT, "ESP_ERR_WIFI_TIMEOUT" },
+        { ESP_ERR_WIFI_NOT_CONNECT, "ESP_ERR_WIFI_NOT_CONNECT" },
+        { ESP_ERR_ESPNOW_NOT_INIT, "ESP_ERR_ESPNOW_NOT_INIT" },
+        { ESP_ERR_ESPNOW_ARG, "ESP_ERR_ESPNOW_ARG" },
+        { ESP_ERR_ESPNOW_NO_MEM, "ESP_ERR_ESPNOW_NO_MEM" },
+        { ESP_ERR_ESPNOW_FULL, "ESP_ERR_ESPNOW_FULL" },
+        { ESP_ERR_ESPNOW_NOT_FOUND, "ESP_ERR_ESPNOW_NOT_FOUND" },
+        { ESP_ERR_ESPNOW_INTERNAL, "ESP_ERR_ESPNOW_INTERNAL" },
+        { ESP_ERR_ESPNOW_EXIST, "ESP_ERR_ESPNOW_EXIST" },
+        { ESP_ERR_ESPNOW_IF, "ESP_ERR_ESPNOW_IF" },
+    };
+
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (names[i].code == code) {
+            return names[i].name;
+        }
+    }
+    return "UNKNOWN ERROR";
+}
+
+/* Same conventions as the ROM functions: crc is the previous result, the
+ * initial and final inversion happen inside */
+uint32_t esp_crc32_le(uint32_t crc, const uint8_t *buf, uint32_t len)
+{
+    crc = ~crc;
+    while (len--) {
+        crc ^= *buf++;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc >> 1) ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+uint16_t esp_crc16_le(uint16_t crc, const uint8_t *buf, uint32_t len)
+{
+    crc = ~crc;
+    while (len--) {
+        crc ^= *buf++;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc >> 1) ^ (0x8408 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+uint8_t esp_crc8_le(uint8_t crc, const uint8_t *buf, uint32_t len)
+{
+    crc = ~crc;
+    while (len--) {
+        crc ^= *buf++;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc >> 1) ^ (0x8C & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+/* the partitions are shared, the node calling picks the contents */
+static uint8_t *ota_data(const esp_partition_t *partition)
+{
+    int node = espnow_sim_current();
+
+    if ((partition != &s_update_partition && partition != &s_data_partition[1]) || node < 0 || node >= SIM_OTA_NODE_MAX) {
+        return NULL;
+    }
+    return s_ota[node].data;
+}
+
+const esp_partition_t *esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype, const char *label)
+{
+    const esp_partition_t *partitions[] = {&s_running_partition, &s_update_partition, &s_data_partition[0], &s_data_partition[1]};
+
+    for (size_t i = 0; i < sizeof(partitions) / sizeof(partitions[0]); i++) {
+        if (partitions[i]->type == type && partitions[i]->subtype == subtype
+                && (!label || !strcmp(partitions[i]->label, label))) {
+            return partitions[i];
+        }
+    }
+    return NULL;
+}
+
+const esp_partition_t *esp_ota_get_running_partition(void)
+{
+    return &s_running_partition;
+}
+
+const esp_partition_t *esp_ota_get_next_update_partition(const esp_partition_t *start_from)
+{
+    return &s_update_partition;
+}
+
+esp_err_t esp_ota_get_partition_description(const esp_partition_t *partition, esp_app_desc_t *app_desc)
+{
+    memcpy(app_desc, esp_app_get_description(), sizeof(esp_app_desc_t));
+    if (partition == &s_update_partition) {
+        strcpy(app_desc->version, "update");
+    }
+    return ESP_OK;
+}
+
+const esp_app_desc_t *esp_app_get_description(void)
+{
+    static const esp_app_desc_t desc = {
+        .magic_word = 0xABCD5432, .version = "running", .project_name = "espnow_sim",
+    };
+    return &desc;
+}
+
+void espnow_sim_ota_set_running(const uint8_t *image, size_t size)
+{
+    s_running_image = image;
+    s_running_size = size;
+}
+
+void espnow_sim_ota_set_data(const uint8_t *image, size_t size)
+{
+    s_data_image = image;
+    s_data_size = size;
+}
+
+/* erases sector by sector and takes as long as the chip would */
+static esp_err_t ota_erase(int node, size_t offset, size_t size)
+{
+    size_t start = offset / SIM_FLASH_SECTOR_SIZE * SIM_FLASH_SECTOR_SIZE;
+    size_t end = SIM_FLASH_ALIGN(offset + size);
+
+    if (node < 0 || node >= SIM_OTA_NODE_MAX || end > SIM_OTA_PARTITION_SIZE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!s_ota[node].data && !(s_ota[node].data = malloc(SIM_OTA_PARTITION_SIZE))) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    memset(s_ota[node].data + start, 0xff, end - start);
+    vTaskDelay(pdMS_TO_TICKS((uint64_t)(end - start) * SIM_FLASH_BLOCK_ERASE_MS / SIM_FLASH_BLOCK_SIZE));
+    return ESP_OK;
+}
+
+/* with OTA_WITH_SEQUENTIAL_WRITES, esp_ota_write() erases ahead of itself instead */
+esp_err_t esp_ota_begin(const esp_partition_t *partition, size_t image_size, esp_ota_handle_t *out_handle)
+{
+    int node = espnow_sim_current();
+    size_t size = image_size == OTA_SIZE_UNKNOWN ? partition->size
+                  : image_size == OTA_WITH_SEQUENTIAL_WRITES ? 0 : image_size;
+
+    if (partition != &s_update_partition || node < 0 || node >= SIM_OTA_NODE_MAX || size > partition->size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    esp_err_t ret = ota_erase(node, 0, size);
+    if (ret != ESP_OK) {
+        return ret;
+    }
+
+    s_ota[node].erased = SIM_FLASH_ALIGN(size);
+    s_ota[node].written = 0;
+    s_ota[node].boot = false;
+    *out_handle = node + 1;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_write(esp_ota_handle_t handle, const void *data, size_t size)
+{
+    int node = (int) handle - 1;
+
+    if (node < 0 || node >= SIM_OTA_NODE_MAX || !s_ota[node].data
+            || s_ota[node].written + size > SIM_OTA_PARTITION_SIZE) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (s_ota[node].written + size > s_ota[node].erased) {
+        esp_err_t ret = ota_erase(node, s_ota[node].erased, s_ota[node].written + size - s_ota[node].erased);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+        s_ota[node].erased = SIM_FLASH_ALIGN(s_ota[node].written + size);
+    }
+
+    for (size_t i = 0; i < size; i++) {
+        s_ota[node].data[s_ota[node].written + i] &= ((const uint8_t *) data)[i];
+    }
+    s_ota[node].written += size;
+    s_ota[node].programmed += size;
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_end(esp_ota_handle_t handle)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_abort(esp_ota_handle_t handle)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t *partition)
+{
+    int node = espnow_sim_current();
+
+    if (node >= 0 && node < SIM_OTA_NODE_MAX) {
+        s_ota[node].boot = partition == &s_update_partition;
+    }
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t *partition, size_t src_offset, void *dst, size_t size)
+{
+    const uint8_t *data = ota_data(partition);
+
+    if (partition == &s_running_partition) {
+        if (!s_running_image || src_offset + size > s_running_size) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        data = s_running_image;
+    } else if (partition == &s_data_partition[0]) {
+        if (!s_data_image || src_offset + size > s_data_size) {
+            return ESP_ERR_INVALID_ARG;
+        }
+        data = s_data_image;
+    }
+
+    if (!data || src_offset + size > partition->size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memcpy(dst, data + src_offset, size);
+    return ESP_OK;
+}
+
+/* like NOR flash, writing only clears bits, so writing twice without an erase shows */
+esp_err_t esp_partition_write(const esp_partition_t *partition, size_t dst_offset, const void *src, size_t size)
+{
+    uint8_t *data = ota_data(partition);
+
+    if (!data || dst_offset + size > partition->size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    for (size_t i = 0; i < size; i++) {
+        data[dst_offset + i] &= ((const uint8_t *) src)[i];
+    }
+    s_ota[espnow_sim_current()].programmed += size;
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *partition, size_t offset, size_t size)
+{
+    if ((partition != &s_update_partition && partition != &s_data_partition[1]) || offset + size > partition->size) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return ota_erase(espnow_sim_current(), offset, size);
+}
+
+esp_err_t esp_partition_get_sha256(const esp_partition_t *partition, uint8_t *sha_256)
+{
+    memset(sha_256, partition == &s_update_partition, 32);
+    return ESP_OK;
+}
+
+const uint8_t *espnow_sim_ota_image(size_t node, bool *boot)
+{
+    if (node >= SIM_OTA_NODE_MAX) {
+        return NULL;
+    }
+    if (boot) {
+        *boot = s_ota[node].boot;
+    }
+    return s_ota[node].data;
+}
+
+size_t espnow_sim_ota_programmed(size_t node)
+{
+    return node < SIM_OTA_NODE_MAX ? s_ota[node].programmed : 0;
+}
+
+esp_err_t esp_event_handler_register(esp_event_base_t event_base, int32_t event_id,
+                                     esp_event_handler_t event_handler, void *event_handler_arg)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_event_handler_unregister(esp_event_base_t event_base, int32_t event_id,
+                                       esp_event_handler_t event_handler)
+{
+    return ESP_OK;
+}
+
+esp_err_t esp_event_post(esp_event_base_t event_base, int32_t event_id, const void *event_data,
+                         size_t event_data_size, uint32_t ticks_to_wait)
+{
+    return ESP_OK;
+}
+
+esp_err_t espnow_sec_init(espnow_sec_t *sec)
+{
+    memset(sec, 0, sizeof(espnow_sec_t));
+    return ESP_OK;
+}
+
+esp_err_t espnow_sec_deinit(espnow_sec_t *sec)
+{
+    return ESP_OK;
+}
+
+esp_err_t espnow_sec_setkey(espnow_sec_t *sec, uint8_t app_key[APP_KEY_LEN])
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t espnow_sec_auth_encrypt(espnow_sec_t *sec, const uint8_t *input, size_t ilen,
+                                  uint8_t *output, size_t output_len, size_t *olen, size_t tag_len)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t espnow_sec_auth_decrypt(espnow_sec_t *sec, const uint8_t *input, size_t ilen,
+                                  uint8_t *output, size_t output_len, size_t *olen, size_t tag_len)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t espnow_sec_auth_encrypt_iv(espnow_sec_t *sec, const uint8_t iv[IV_LEN], const uint8_t *input, size_t ilen,
+                                     uint8_t *output, size_t tag_len)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t espnow_sec_auth_decrypt_iv(espnow_sec_t *sec, const uint8_t iv[IV_LEN], const uint8_t *input, size_t ilen,
+                                     uint8_t *output, size_t *olen, size_t tag_len)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t espnow_storage_init(void)
+{
+    return ESP_OK;
+}
+
+static sim_blob_t **storage_find(const char *key)
+{
+    int node = espnow_sim_current();
+
+    if (node < 0 || node >= SIM_OTA_NODE_MAX) {
+        return NULL;
+    }
+
+    sim_blob_t **blob = &s_storage[node];
+    while (*blob && strcmp((*blob)->key, key)) {
+        blob = &(*blob)->next;
+    }
+    return blob;
+}
+
+esp_err_t espnow_storage_set(const char *key, const void *value, size_t length)
+{
+    sim_blob_t **blob = key ? storage_find(key) : NULL;
+
+    if (!blob || strlen(key) >= sizeof((*blob)->key) || !value || !length) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    sim_blob_t *next = *blob ? (*blob)->next : NULL;
+    sim_blob_t *entry = realloc(*blob, sizeof(sim_blob_t) + length);
+    if (!entry) {
+        return ESP_ERR_NO_MEM;
+    }
+    entry->next = next;
+    strcpy(entry->key, key);
+    entry->len = length;
+    memcpy(entry->value, value, length);
+    *blob = entry;
+    return ESP_OK;
+}
+
+/* like nvs_get_blob(), a length of 0 reads all of it and a shorter one fails */
+esp_err_t espnow_storage_get(const char *key, void *value, size_t length)
+{
+    sim_blob_t **blob = key ? storage_find(key) : NULL;
+
+    if (!blob || !value) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!*blob) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    if (length && length < (*blob)->len) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(value, (*blob)->value, (*blob)->len);
+    return ESP_OK;
+}
+
+esp_err_t espnow_storage_erase(const char *key)
+{
+    sim_blob_t **blob = key ? storage_find(key) : NULL;
+
+    if (!blob) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!*blob) {
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    sim_blob_t *entry = *blob;
+    *blob = entry->next;
+    free(entry);
+    return ESP_OK;
+}
+
+void espnow_mem_add_record(void *ptr, int size, const char *tag, int line)
+{
+}
+
+void espnow_mem_remove_record(void *ptr, const char *tag, int line)
+{
+}
@@ -0,0 +1,6 @@
+// Host build stand-in for the IDF header, see espnow_sim.c
+#pragma once
+
+#define ESP_IDF_VERSION_VAL(major, minor, patch) (((major) << 16) | ((minor) << 8) | (patch))
+// the receive callback takes esp_now_recv_info_t from 5.0.1 on
+#define ESP_IDF_VERSION         ESP_IDF_VERSION_VAL(5, 1, 0)
@@ -0,0 +1,29 @@
+// Host build stand-in for the IDF header, see espnow_sim.c
+// Lines go through espnow_sim_log(), which prefixes the virtual time and node
+#pragma once
+
+#include <stdint.h>
+
+typedef enum {
+    ESP_LOG_NONE,
+    ESP_LOG_ERROR,
+    ESP_LOG_WARN,
+    ESP_LOG_INFO,
+    ESP_LOG_DEBUG,
+    ESP_LOG_VERBOSE,
+} esp_log_level_t;
+
+void espnow_sim_log(esp_log_level_t level, const char *tag, const char *format, ...);
+
+#define ESP_LOGE(tag, format, ...) espnow_sim_log(ESP_LOG_ERROR, tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) espnow_sim_log(ESP_LOG_WARN, tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) espnow_sim_log(ESP_LOG_INFO, tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) espnow_sim_log(ESP_LOG_DEBUG, tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) espnow_sim_log(ESP_LOG_VERBOSE, tag, format, ##__VA_ARGS__)
+
+#define ESP_LOG_BUFFER_HEX_LEVEL(tag, buffer, len, level)
+#define ESP_LOG_BUFFER_HEXDUMP(tag, buffer, len, level)
+#define ESP_LOG_BUFFER_HEX(tag, buffer, len)
+#define ESP_LOG_BUFFER_CHAR_LEVEL(tag, buffer, len, level)
+
+void esp_log_level_set(const char *tag, esp_log_level_t level);
@@ -0,0 +1,7 @@
+// Host build stand-in for the IDF header, see espnow_sim.c
+#pragma once
+
+#include "esp_err.h"
+
+#define MAC2STR(a) (a)[0], (a)[1], (a)[2], (a)[3], (a)[4], (a)[5]
+#define MACSTR "%02x:%02x:%02x:%02x:%02x:%02x"
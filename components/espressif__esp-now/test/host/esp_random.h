@@ -0,0 +1,9 @@
+// Host build stand-in for the IDF header, see espnow_sim.c
+// Seeded from the scenario, so that runs are repeatable
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+uint32_t esp_random(void);
+void esp_fill_random(void *buf, size_t len);
@@ -0,0 +1,4 @@
+// Host build stand-in for the IDF header, see espnow_sim.c
+#pragma once
+
+#include "esp_err.h"
@@ -0,0 +1,8 @@
+// Host build stand-in for the IDF header, see espnow_sim.c
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#define esp_get_free_heap_size() ((uint32_t) 0)
+#define esp_get_minimum_free_heap_size() ((uint32_t) 0)
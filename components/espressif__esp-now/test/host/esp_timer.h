@@ -0,0 +1,7 @@
+// Host build stand-in for the IDF header, see espnow_sim.c
+// Counts virtual time
+#pragma once
+
+#include <stdint.h>
+
+int64_t esp_timer_get_time(void);
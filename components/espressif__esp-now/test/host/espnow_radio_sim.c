@@ -0,0 +1,911 @@
+// Copyright 2024 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * The medium behind espnow_sim_radio, see espnow_radio_sim.h.
+ *
+ * A node sends one frame at a time from its queue. When a frame goes on the
+ * air every node with a link from the sender on the same channel hears it:
+ * it defers its own frames until the end, and a reception already running
+ * there is corrupted together with the new one. At the end of the airtime
+ * each addressed receiver gets the frame unless it was lost, corrupted or the
+ * receiver changed channel, and the sender learns whether a unicast frame
+ * was acknowledged. Receptions and send results reach espnow.c through a
+ * per node "wifi" task, so the callbacks run in task context as on the chip.
+ *
+ * Channel timing is 802.11b long preamble: 192 us preamble, DIFS 50 us,
+ * 20 us slots, a contention window of 15 slots doubling per retry up to 1023
+ * and a 14 byte ACK after SIFS.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/param.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_now.h"
+#include "esp_wifi.h"
+#include "esp_random.h"
+#include "espnow.h"
+#include "freertos_sim.h"
+#include "espnow_radio_sim.h"
+
+#define SIM_PREAMBLE_US         192
+#define SIM_DIFS_US             50
+#define SIM_SIFS_US             10
+#define SIM_SLOT_US             20
+#define SIM_CW_MIN              15
+#define SIM_CW_MAX              1023
+#define SIM_FRAME_OVERHEAD      43      /* MAC header, action frame and vendor element, FCS */
+#define SIM_ACK_LEN             14
+
+/* .data and .bss of espnow.c and espnow_group.c, renamed by the build, see espnow_sim.c */
+extern char __start_espnow_node_data[] __attribute__((weak));
+extern char __stop_espnow_node_data[] __attribute__((weak));
+extern char __start_espnow_node_bss[] __attribute__((weak));
+extern char __stop_espnow_node_bss[] __attribute__((weak));
+
+typedef struct sim_node sim_node_t;
+
+typedef struct sim_tx {
+    sim_node_t *node;
+    uint32_t boot;                      /* send_cb of a node restarted since is not called */
+    struct sim_tx *next;
+    uint8_t dest[ESP_NOW_ETH_ALEN];
+    bool broadcast;
+    uint8_t channel;
+    uint8_t attempt;
+    bool data_ok;                       /* the current attempt reached dest */
+    bool delivered;                     /* later attempts are MAC duplicates */
+    esp_now_send_status_t status;
+    uint64_t end;
+    size_t len;
+    uint8_t data[ESP_NOW_MAX_DATA_LEN];
+} sim_tx_t;
+
+typedef struct sim_rx {
+    sim_node_t *to;
+    sim_tx_t *tx;
+    uint64_t end;
+    uint32_t latency_us;
+    int8_t rssi;
+    uint8_t channel;
+    bool deliver;                       /* addressed to this node, otherwise it only occupies the receiver */
+    bool lost;
+    bool collided;
+} sim_rx_t;
+
+typedef enum {
+    SIM_MSG_RECV,
+    SIM_MSG_SEND_DONE,
+    SIM_MSG_STOP,
+} sim_msg_type_t;
+
+typedef struct {
+    sim_msg_type_t type;
+    sim_node_t *node;
+    esp_now_send_status_t status;
+    uint8_t src[ESP_NOW_ETH_ALEN];
+    uint8_t dest[ESP_NOW_ETH_ALEN];
+    wifi_pkt_rx_ctrl_t rx_ctrl;
+    int len;
+    uint8_t data[ESP_NOW_MAX_DATA_LEN];
+} sim_msg_t;
+
+struct sim_node {
+    size_t index;
+    uint8_t mac[ESP_NOW_ETH_ALEN];
+    uint8_t channel;
+    uint8_t start_channel;              /* from espnow_sim_set_channel(), again after a restart */
+    uint32_t boot;
+    uint8_t *state;                     /* this node's esp-now globals while another node runs */
+
+    bool up;
+    esp_now_send_cb_t send_cb;
+    esp_now_recv_cb_t recv_cb;
+    uint8_t peers[ESP_NOW_MAX_TOTAL_PEER_NUM][ESP_NOW_ETH_ALEN];
+    size_t peer_num;
+    QueueHandle_t wifi_queue;
+    size_t rx_pending;
+
+    sim_tx_t *tx_head;
+    sim_tx_t *tx_tail;
+    size_t tx_queued;
+    uint64_t tx_start;                  /* last frame this node put on the air */
+    uint64_t tx_end;
+    uint64_t cca_busy_until;            /* end of the last frame it heard */
+    uint64_t rx_busy_until;
+    sim_rx_t *rx_last;                  /* reception ending at rx_busy_until */
+
+    espnow_sim_counters_t counters;
+};
+
+typedef struct {
+    bool present;
+    espnow_sim_link_t link;
+} sim_link_t;
+
+static espnow_sim_config_t s_config;
+static sim_node_t *s_nodes;
+static size_t s_node_num;
+static sim_link_t *s_links;
+static espnow_sim_tx_hook_t s_tx_hook;
+static uint8_t *s_initial_state;        /* the esp-now globals as linked */
+static uint64_t s_rng;
+
+static uint64_t sim_random(void)
+{
+    /* xorshift64* */
+    s_rng ^= s_rng >> 12;
+    s_rng ^= s_rng << 25;
+    s_rng ^= s_rng >> 27;
+    return s_rng * 0x2545F4914F6CDD1DULL;
+}
+
+static float sim_random_float(void)
+{
+    return (float) (sim_random() >> 40) / (float) (1 << 24);
+}
+
+uint32_t esp_random(void)
+{
+    return (uint32_t) (sim_random() >> 32);
+}
+
+void esp_fill_random(void *buf, size_t len)
+{
+    uint8_t *p = buf;
+    for (size_t i = 0; i < len; i++) {
+        p[i] = (uint8_t) (sim_random() >> 56);
+    }
+}
+
+static const sim_link_t *link_get(const sim_node_t *from, const sim_node_t *to)
+{
+    return &s_links[from->index * s_node_num + to->index];
+}
+
+static bool link_on_channel(const sim_link_t *link, uint8_t channel)
+{
+    return link->present && (!link->link.channels || (link->link.channels & BIT(channel)));
+}
+
+static uint32_t airtime_us(size_t len)
+{
+    return SIM_PREAMBLE_US + (uint32_t) ((SIM_FRAME_OVERHEAD + len) * 8 * 1000 / s_config.phy_rate_kbps);
+}
+
+static uint32_t ack_time_us(void)
+{
+    return SIM_SIFS_US + SIM_PREAMBLE_US + SIM_ACK_LEN * 8 * 1000 / s_config.phy_rate_kbps;
+}
+
+static sim_node_t *node_of(void *ctx)
+{
+    sim_node_t *node = ctx;
+    if (node != sim_current_owner()) {
+        fprintf(stderr, "espnow_sim_radio used with the context of node %zu from another node\n", node->index);
+        abort();
+    }
+    return node;
+}
+
+static size_t state_data_size(void)
+{
+    return __stop_espnow_node_data - __start_espnow_node_data;
+}
+
+static size_t state_bss_size(void)
+{
+    return __stop_espnow_node_bss - __start_espnow_node_bss;
+}
+
+static void state_save(uint8_t *state)
+{
+    memcpy(state, __start_espnow_node_data, state_data_size());
+    memcpy(state + state_data_size(), __start_espnow_node_bss, state_bss_size());
+}
+
+static void node_switch(void *from, void *to)
+{
+    if (from) {
+        state_save(((sim_node_t *) from)->state);
+    }
+    if (to) {
+        const uint8_t *state = ((sim_node_t *) to)->state;
+        memcpy(__start_espnow_node_data, state, state_data_size());
+        memcpy(__start_espnow_node_bss, state + state_data_size(), state_bss_size());
+    }
+}
+
+static void wifi_post(sim_node_t *node, sim_msg_t *msg)
+{
+    if (!node->up || xQueueSend(node->wifi_queue, &msg, 0) != pdPASS) {
+        free(msg);
+    }
+}
+
+static void wifi_task(void *arg)
+{
+    sim_node_t *node = arg;
+    sim_msg_t *msg = NULL;
+
+    while (xQueueReceive(node->wifi_queue, &msg, portMAX_DELAY) == pdPASS) {
+        if (msg->type == SIM_MSG_STOP) {
+            free(msg);
+            break;
+        }
+
+        if (msg->type == SIM_MSG_RECV) {
+            node->rx_pending--;
+            if (node->recv_cb) {
+                esp_now_recv_info_t info = {
+                    .src_addr = msg->src,
+                    .des_addr = msg->dest,
+                    .rx_ctrl = &msg->rx_ctrl,
+                };
+                node->counters.rx_frames++;
+                node->recv_cb(&info, msg->data, msg->len);
+            }
+        } else if (node->send_cb) {
+            node->send_cb(msg->dest, msg->status);
+        }
+        free(msg);
+    }
+
+    while (xQueueReceive(node->wifi_queue, &msg, 0) == pdPASS) {
+        free(msg);
+    }
+    vQueueDelete(node->wifi_queue);
+    node->wifi_queue = NULL;
+}
+
+static void tx_attempt(sim_tx_t *tx);
+
+static void tx_done(void *arg)
+{
+    sim_tx_t *tx = arg;
+    sim_node_t *node = tx->node;
+
+    node->tx_head = tx->next;
+    if (!node->tx_head) {
+        node->tx_tail = NULL;
+    }
+    node->tx_queued--;
+
+    sim_msg_t *msg = tx->boot == node->boot ? calloc(1, sizeof(sim_msg_t)) : NULL;
+    if (msg) {
+        msg->type = SIM_MSG_SEND_DONE;
+        msg->status = tx->status;
+        memcpy(msg->dest, tx->dest, ESP_NOW_ETH_ALEN);
+        wifi_post(node, msg);
+    }
+    free(tx);
+
+    if (node->tx_head) {
+        tx_attempt(node->tx_head);
+    }
+}
+
+static void tx_complete(sim_tx_t *tx, esp_now_send_status_t status, uint64_t time)
+{
+    tx->status = status;
+    sim_schedule(time, tx_done, tx);
+}
+
+/* Runs after the rx_end() of the attempt, which were scheduled first */
+static void tx_end(void *arg)
+{
+    sim_tx_t *tx = arg;
+    sim_node_t *node = tx->node;
+
+    if (tx->broadcast) {
+        tx_complete(tx, ESP_NOW_SEND_SUCCESS, tx->end);
+        return;
+    }
+
+    /* the sender waits for the ACK whether it comes or not */
+    node->tx_end = tx->end + ack_time_us();
+
+    bool acked = false;
+    if (tx->data_ok) {
+        for (size_t i = 0; i < s_node_num; i++) {
+            if (!memcmp(s_nodes[i].mac, tx->dest, ESP_NOW_ETH_ALEN)) {
+                const sim_link_t *back = link_get(&s_nodes[i], node);
+                acked = link_on_channel(back, tx->channel) && sim_random_float() >= back->link.loss;
+                break;
+            }
+        }
+    }
+
+    if (acked) {
+        tx_complete(tx, ESP_NOW_SEND_SUCCESS, node->tx_end);
+    } else if (tx->attempt < s_config.mac_retries) {
+        tx->attempt++;
+        node->counters.tx_retries++;
+        tx_attempt(tx);
+    } else {
+        node->counters.tx_retries++;
+        node->counters.tx_failed++;
+        tx_complete(tx, ESP_NOW_SEND_FAIL, node->tx_end);
+    }
+}
+
+static void rx_arrive(void *arg)
+{
+    sim_msg_t *msg = arg;
+    sim_node_t *node = msg->node;
+
+    if (!node->up || node->rx_pending >= s_config.rx_queue_len) {
+        node->counters.rx_overflow++;
+        free(msg);
+        return;
+    }
+    node->rx_pending++;
+    wifi_post(node, msg);
+}
+
+static void rx_end(void *arg)
+{
+    sim_rx_t *rx = arg;
+    sim_node_t *node = rx->to;
+    sim_tx_t *tx = rx->tx;
+
+    if (node->rx_last == rx) {
+        node->rx_last = NULL;
+    }
+
+    if (!rx->deliver) {
+        free(rx);
+        return;
+    }
+
+    if (node->channel != rx->channel) {
+        node->counters.rx_off_channel++;
+    } else if (rx->collided) {
+        node->counters.rx_collided++;
+    } else if (rx->lost) {
+        node->counters.rx_lost++;
+    } else {
+        bool duplicate = false;
+        if (!tx->broadcast) {
+            tx->data_ok = true;
+            duplicate = tx->delivered;
+            tx->delivered = true;
+        }
+
+        sim_msg_t *msg = duplicate ? NULL : calloc(1, sizeof(sim_msg_t));
+        if (msg) {
+            msg->type = SIM_MSG_RECV;
+            msg->node = node;
+            memcpy(msg->src, tx->node->mac, ESP_NOW_ETH_ALEN);
+            memcpy(msg->dest, tx->dest, ESP_NOW_ETH_ALEN);
+            msg->rx_ctrl.rssi = rx->rssi;
+            msg->rx_ctrl.channel = rx->channel;
+            msg->rx_ctrl.rate = 0;
+            msg->rx_ctrl.sig_len = tx->len + SIM_FRAME_OVERHEAD;
+            msg->rx_ctrl.timestamp = (uint32_t) rx->end;
+            msg->len = tx->len;
+            memcpy(msg->data, tx->data, tx->len);
+            if (rx->latency_us) {
+                sim_schedule(rx->end + rx->latency_us, rx_arrive, msg);
+            } else {
+                rx_arrive(msg);
+            }
+        }
+    }
+    free(rx);
+}
+
+static void tx_attempt(sim_tx_t *tx)
+{
+    sim_node_t *node = tx->node;
+    uint32_t cw = MIN(((SIM_CW_MIN + 1) << tx->attempt) - 1, SIM_CW_MAX);
+    uint64_t start = MAX(MAX(sim_time_us(), node->tx_end), node->cca_busy_until)
+                     + SIM_DIFS_US + (sim_random() % (cw + 1)) * SIM_SLOT_US;
+    uint32_t airtime = airtime_us(tx->len);
+    uint64_t end = start + airtime;
+
+    tx->channel = node->channel;
+    tx->data_ok = false;
+    tx->end = end;
+
+    /* a node cannot receive while it sends */
+    if (s_config.collisions && node->rx_busy_until > start && node->rx_last) {
+        node->rx_last->collided = true;
+    }
+    node->tx_start = start;
+    node->tx_end = end;
+    node->counters.tx_frames++;
+    node->counters.tx_airtime_us += airtime;
+
+    for (size_t i = 0; i < s_node_num; i++) {
+        sim_node_t *to = &s_nodes[i];
+        const sim_link_t *link = link_get(node, to);
+        if (to == node || !link_on_channel(link, tx->channel)) {
+            continue;
+        }
+
+        bool deliver = tx->broadcast || !memcmp(to->mac, tx->dest, ESP_NOW_ETH_ALEN);
+        if (to->channel != tx->channel) {
+            if (deliver) {
+                to->counters.rx_off_channel++;
+            }
+            continue;
+        }
+
+        sim_rx_t *rx = calloc(1, sizeof(sim_rx_t));
+        if (!rx) {
+            continue;
+        }
+        rx->to = to;
+        rx->tx = tx;
+        rx->end = end;
+        rx->latency_us = link->link.latency_us;
+        rx->rssi = link->link.rssi;
+        rx->channel = tx->channel;
+        rx->deliver = deliver;
+        rx->lost = deliver && sim_random_float() < link->link.loss;
+
+        to->cca_busy_until = MAX(to->cca_busy_until, end);
+        if (s_config.collisions) {
+            if (to->rx_busy_until > start) {
+                rx->collided = true;
+                if (to->rx_last) {
+                    to->rx_last->collided = true;
+                }
+            }
+            if (to->tx_end > start && to->tx_start < end) {
+                rx->collided = true;
+            }
+        }
+        if (end > to->rx_busy_until) {
+            to->rx_busy_until = end;
+            to->rx_last = rx;
+        }
+        sim_schedule(end, rx_end, rx);
+    }
+
+    sim_schedule(end, tx_end, tx);
+}
+
+static int peer_find(const sim_node_t *node, const uint8_t *addr)
+{
+    for (size_t i = 0; i < node->peer_num; i++) {
+        if (!memcmp(node->peers[i], addr, ESP_NOW_ETH_ALEN)) {
+            return (int) i;
+        }
+    }
+    return -1;
+}
+
+static esp_err_t radio_sim_init(void *ctx, esp_now_send_cb_t send_cb, esp_now_recv_cb_t recv_cb, const uint8_t *pmk)
+{
+    sim_node_t *node = node_of(ctx);
+    (void) pmk;
+
+    if (node->up) {
+        return ESP_OK;
+    }
+
+    node->wifi_queue = xQueueCreate(s_config.rx_queue_len + s_config.tx_queue_len + 1, sizeof(sim_msg_t *));
+    if (!node->wifi_queue) {
+        return ESP_ERR_ESPNOW_NO_MEM;
+    }
+    if (sim_task_create(node, wifi_task, "wifi", node, NULL) != pdPASS) {
+        vQueueDelete(node->wifi_queue);
+        node->wifi_queue = NULL;
+        return ESP_ERR_ESPNOW_NO_MEM;
+    }
+    node->send_cb = send_cb;
+    node->recv_cb = recv_cb;
+    node->peer_num = 0;
+    node->rx_pending = 0;
+    node->up = true;
+    return ESP_OK;
+}
+
+static esp_err_t radio_sim_deinit(void *ctx)
+{
+    sim_node_t *node = node_of(ctx);
+
+    if (!node->up) {
+        return ESP_OK;
+    }
+
+    sim_msg_t *msg = calloc(1, sizeof(sim_msg_t));
+    if (!msg) {
+        return ESP_ERR_ESPNOW_NO_MEM;
+    }
+    msg->type = SIM_MSG_STOP;
+    wifi_post(node, msg);
+    node->up = false;
+    node->send_cb = NULL;
+    node->recv_cb = NULL;
+    return ESP_OK;
+}
+
+static esp_err_t radio_sim_send(void *ctx, const uint8_t *peer_addr, const uint8_t *data, size_t len)
+{
+    sim_node_t *node = node_of(ctx);
+
+    if (!node->up) {
+        return ESP_ERR_ESPNOW_NOT_INIT;
+    }
+    if (!peer_addr || !data || !len || len > ESP_NOW_MAX_DATA_LEN) {
+        return ESP_ERR_ESPNOW_ARG;
+    }
+    if (peer_find(node, peer_addr) < 0) {
+        return ESP_ERR_ESPNOW_NOT_FOUND;
+    }
+    if (node->tx_queued >= s_config.tx_queue_len) {
+        node->counters.tx_no_mem++;
+        return ESP_ERR_ESPNOW_NO_MEM;
+    }
+
+    sim_tx_t *tx = calloc(1, sizeof(sim_tx_t));
+    if (!tx) {
+        return ESP_ERR_ESPNOW_NO_MEM;
+    }
+    tx->node = node;
+    tx->boot = node->boot;
+    memcpy(tx->dest, peer_addr, ESP_NOW_ETH_ALEN);
+    tx->broadcast = ESPNOW_ADDR_IS_BROADCAST(peer_addr);
+    tx->len = len;
+    memcpy(tx->data, data, len);
+
+    if (s_tx_hook) {
+        s_tx_hook(node->index, data, len);
+    }
+
+    node->tx_queued++;
+    if (node->tx_tail) {
+        node->tx_tail->next = tx;
+        node->tx_tail = tx;
+    } else {
+        node->tx_head = node->tx_tail = tx;
+        tx_attempt(tx);
+    }
+    return ESP_OK;
+}
+
+static esp_err_t radio_sim_add_peer(void *ctx, const esp_now_peer_info_t *peer)
+{
+    sim_node_t *node = node_of(ctx);
+
+    if (!node->up) {
+        return ESP_ERR_ESPNOW_NOT_INIT;
+    }
+    if (peer_find(node, peer->peer_addr) >= 0) {
+        return ESP_ERR_ESPNOW_EXIST;
+    }
+    if (node->peer_num == ESP_NOW_MAX_TOTAL_PEER_NUM) {
+        return ESP_ERR_ESPNOW_FULL;
+    }
+    memcpy(node->peers[node->peer_num++], peer->peer_addr, ESP_NOW_ETH_ALEN);
+    return ESP_OK;
+}
+
+static esp_err_t radio_sim_del_peer(void *ctx, const uint8_t *peer_addr)
+{
+    sim_node_t *node = node_of(ctx);
+    int i = peer_find(node, peer_addr);
+
+    if (i < 0) {
+        return ESP_ERR_ESPNOW_NOT_FOUND;
+    }
+    memmove(node->peers[i], node->peers[i + 1], (node->peer_num - i - 1) * ESP_NOW_ETH_ALEN);
+    node->peer_num--;
+    return ESP_OK;
+}
+
+static bool radio_sim_is_peer_exist(void *ctx, const uint8_t *peer_addr)
+{
+    return peer_find(node_of(ctx), peer_addr) >= 0;
+}
+
+static esp_err_t radio_sim_get_channel(void *ctx, uint8_t *primary, wifi_second_chan_t *second)
+{
+    sim_node_t *node = node_of(ctx);
+
+    *primary = node->channel;
+    *second = WIFI_SECOND_CHAN_NONE;
+    return ESP_OK;
+}
+
+static esp_err_t radio_sim_set_channel(void *ctx, uint8_t primary, wifi_second_chan_t second)
+{
+    sim_node_t *node = node_of(ctx);
+
+    if (primary < 1 || primary > 14) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    node->channel = primary;
+    return ESP_OK;
+}
+
+static esp_err_t radio_sim_get_country(void *ctx, wifi_country_t *country)
+{
+    (void) ctx;
+    *country = (wifi_country_t) {
+        .cc = "CN", .schan = 1, .nchan = 13, .max_tx_power = 20, .policy = WIFI_COUNTRY_POLICY_AUTO
+    };
+    return ESP_OK;
+}
+
+static esp_err_t radio_sim_get_mac(void *ctx, uint8_t mac[ESPNOW_ADDR_LEN])
+{
+    memcpy(mac, node_of(ctx)->mac, ESPNOW_ADDR_LEN);
+    return ESP_OK;
+}
+
+const espnow_radio_t espnow_sim_radio = {
+    .init = radio_sim_init,
+    .deinit = radio_sim_deinit,
+    .send = radio_sim_send,
+    .add_peer = radio_sim_add_peer,
+    .del_peer = radio_sim_del_peer,
+    .is_peer_exist = radio_sim_is_peer_exist,
+    .get_channel = radio_sim_get_channel,
+    .set_channel = radio_sim_set_channel,
+    .get_country = radio_sim_get_country,
+    .get_mac = radio_sim_get_mac,
+};
+
+esp_err_t espnow_sim_init(const espnow_sim_config_t *config, size_t node_count)
+{
+    size_t state_size = state_data_size() + state_bss_size();
+
+    if (!config || !node_count || node_count > UINT16_MAX || !config->phy_rate_kbps
+            || !config->tx_queue_len || !config->rx_queue_len) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (s_nodes) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (!state_size && node_count > 1) {
+        fprintf(stderr, "No espnow_node_data section, the nodes would share one esp-now, see espnow_sim.c\n");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+
+    s_config = *config;
+    s_rng = config->seed ? config->seed : 1;
+    s_node_num = node_count;
+    s_nodes = calloc(node_count, sizeof(sim_node_t));
+    s_links = calloc(node_count * node_count, sizeof(sim_link_t));
+    if (!s_nodes || !s_links) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    for (size_t i = 0; i < node_count; i++) {
+        sim_node_t *node = &s_nodes[i];
+        node->index = i;
+        node->mac[0] = 0x02;
+        node->mac[4] = (uint8_t) (i >> 8);
+        node->mac[5] = (uint8_t) i;
+        node->channel = node->start_channel = 1;
+        if (state_size) {
+            node->state = malloc(state_size);
+            if (!node->state) {
+                return ESP_ERR_NO_MEM;
+            }
+        }
+    }
+
+    if (state_size) {
+        /* every node starts from the globals as linked */
+        s_initial_state = malloc(state_size);
+        if (!s_initial_state) {
+            return ESP_ERR_NO_MEM;
+        }
+        state_save(s_initial_state);
+        for (size_t i = 0; i < node_count; i++) {
+            memcpy(s_nodes[i].state, s_initial_state, state_size);
+        }
+        sim_set_owner_switch(node_switch);
+    }
+    return ESP_OK;
+}
+
+void espnow_sim_set_link(size_t from, size_t to, const espnow_sim_link_t *link)
+{
+    sim_link_t *entry = &s_links[from * s_node_num + to];
+
+    entry->present = link != NULL;
+    if (link) {
+        entry->link = *link;
+    }
+}
+
+void espnow_sim_set_channel(size_t node, uint8_t channel)
+{
+    s_nodes[node].channel = s_nodes[node].start_channel = channel;
+}
+
+void *espnow_sim_node(size_t node)
+{
+    return &s_nodes[node];
+}
+
+esp_err_t espnow_sim_start(size_t node, TaskFunction_t task, void *arg)
+{
+    if (node >= s_node_num) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return sim_task_create(&s_nodes[node], task, "node", arg, NULL) == pdPASS ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+esp_err_t espnow_sim_restart(size_t node, TaskFunction_t task, void *arg)
+{
+    if (node >= s_node_num || sim_current_owner()) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    sim_node_t *entry = &s_nodes[node];
+    sim_owner_stop(entry);
+
+    /* frames already handed to the air go out, but nobody is told about them */
+    entry->boot++;
+    if (entry->wifi_queue) {
+        sim_msg_t *msg = NULL;
+        while (xQueueReceive(entry->wifi_queue, &msg, 0) == pdPASS) {
+            free(msg);
+        }
+        vQueueDelete(entry->wifi_queue);
+        entry->wifi_queue = NULL;
+    }
+    entry->up = false;
+    entry->send_cb = NULL;
+    entry->recv_cb = NULL;
+    entry->peer_num = 0;
+    entry->rx_pending = 0;
+    entry->channel = entry->start_channel;
+    if (s_initial_state) {
+        memcpy(entry->state, s_initial_state, state_data_size() + state_bss_size());
+    }
+
+    return espnow_sim_start(node, task, arg);
+}
+
+int espnow_sim_current(void)
+{
+    sim_node_t *node = sim_current_owner();
+    return node ? (int) node->index : -1;
+}
+
+void espnow_sim_get_mac(size_t node, uint8_t mac[ESPNOW_ADDR_LEN])
+{
+    memcpy(mac, s_nodes[node].mac, ESPNOW_ADDR_LEN);
+}
+
+void espnow_sim_get_counters(size_t node, espnow_sim_counters_t *counters)
+{
+    *counters = s_nodes[node].counters;
+}
+
+void espnow_sim_set_tx_hook(espnow_sim_tx_hook_t hook)
+{
+    s_tx_hook = hook;
+}
+
+void espnow_sim_run(uint64_t duration_us)
+{
+    sim_run_until(sim_time_us() + duration_us);
+}
+
+uint64_t espnow_sim_time_us(void)
+{
+    return sim_time_us();
+}
+
+/* The IDF calls espnow.c still makes directly, answered for the running node */
+
+esp_err_t esp_wifi_get_mode(wifi_mode_t *mode)
+{
+    *mode = WIFI_MODE_STA;
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_sta_get_ap_info(wifi_ap_record_t *ap_info)
+{
+    (void) ap_info;
+    return ESP_ERR_WIFI_NOT_CONNECT;
+}
+
+esp_err_t esp_wifi_get_mac(wifi_interface_t ifx, uint8_t mac[6])
+{
+    sim_node_t *node = sim_current_owner();
+    (void) ifx;
+
+    if (!node) {
+        return ESP_ERR_WIFI_NOT_INIT;
+    }
+    memcpy(mac, node->mac, ESP_NOW_ETH_ALEN);
+    return ESP_OK;
+}
+
+esp_err_t esp_wifi_get_channel(uint8_t *primary, wifi_second_chan_t *second)
+{
+    sim_node_t *node = sim_current_owner();
+    return node ? radio_sim_get_channel(node, primary, second) : ESP_ERR_WIFI_NOT_INIT;
+}
+
+esp_err_t esp_wifi_set_channel(uint8_t primary, wifi_second_chan_t second)
+{
+    sim_node_t *node = sim_current_owner();
+    return node ? radio_sim_set_channel(node, primary, second) : ESP_ERR_WIFI_NOT_INIT;
+}
+
+esp_err_t esp_wifi_get_country(wifi_country_t *country)
+{
+    return radio_sim_get_country(NULL, country);
+}
+
+/* Only espnow_sim_radio drives the medium, the default backend is not simulated */
+
+esp_err_t esp_now_init(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+esp_err_t esp_now_deinit(void)
+{
+    return ESP_ERR_ESPNOW_NOT_INIT;
+}
+
+esp_err_t esp_now_register_recv_cb(esp_now_recv_cb_t cb)
+{
+    return ESP_ERR_ESPNOW_NOT_INIT;
+}
+
+esp_err_t esp_now_unregister_recv_cb(void)
+{
+    return ESP_ERR_ESPNOW_NOT_INIT;
+}
+
+esp_err_t esp_now_register_send_cb(esp_now_send_cb_t cb)
+{
+    return ESP_ERR_ESPNOW_NOT_INIT;
+}
+
+esp_err_t esp_now_unregister_send_cb(void)
+{
+    return ESP_ERR_ESPNOW_NOT_INIT;
+}
+
+esp_err_t esp_now_send(const uint8_t *peer_addr, const uint8_t *data, size_t len)
+{
+    return ESP_ERR_ESPNOW_NOT_INIT;
+}
+
+esp_err_t esp_now_add_peer(const esp_now_peer_info_t *peer)
+{
+    return ESP_ERR_ESPNOW_NOT_INIT;
+}
+
+esp_err_t esp_now_del_peer(const uint8_t *peer_addr)
+{
+    return ESP_ERR_ESPNOW_NOT_INIT;
+}
+
+bool esp_now_is_peer_exist(const uint8_t *peer_addr)
+{
+    return false;
+}
+
+esp_err_t esp_now_set_pmk(const uint8_t *pmk)
+{
+    return ESP_ERR_ESPNOW_NOT_INIT;
+}
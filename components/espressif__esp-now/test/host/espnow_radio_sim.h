@@ -0,0 +1,179 @@
+// Copyright 2024 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Simulated ESP-NOW medium for the host build. Every node runs its own copy
+ * of espnow.c in one process: the esp-now globals are linked into their own
+ * section, which is swapped for the node's copy whenever the scheduler in
+ * freertos_sim.c switches to a task of another node. A node talks to the
+ * medium through espnow_sim_radio, installed with espnow_set_radio().
+ *
+ * Links are one way and only exist where set. Frames take their airtime at
+ * the configured PHY rate, a sender defers while it hears another frame and
+ * backs off at random, and two frames overlapping at a receiver that cannot
+ * hear one of the senders (hidden nodes) are both lost. Unicast frames are
+ * acknowledged by the MAC and retried, like on the chip.
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "espnow.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    uint32_t seed;                  /*!< Seeds esp_random() and every loss and backoff draw, the same seed repeats a run */
+    uint32_t phy_rate_kbps;         /*!< Data rate of every frame, ESP-NOW defaults to 1 Mbps */
+    uint8_t mac_retries;            /*!< Unicast attempts after the first before send_cb reports ESP_NOW_SEND_FAIL */
+    uint8_t tx_queue_len;           /*!< Frames a node may have waiting for the air, esp_now_send() fails with ESP_ERR_ESPNOW_NO_MEM beyond */
+    uint8_t rx_queue_len;           /*!< Received frames waiting for the receive callback, more are dropped */
+    bool collisions;                /*!< Overlapping frames at a receiver are both lost */
+} espnow_sim_config_t;
+
+#define ESPNOW_SIM_CONFIG_DEFAULT() { \
+    .seed = 1, \
+    .phy_rate_kbps = 1000, \
+    .mac_retries = 7, \
+    .tx_queue_len = 32, \
+    .rx_queue_len = 32, \
+    .collisions = true, \
+}
+
+typedef struct {
+    float loss;                     /*!< Probability that a frame on the link is lost, 0 to 1 */
+    uint32_t latency_us;            /*!< Added to the airtime before the receiver gets the frame */
+    int8_t rssi;                    /*!< Reported in rx_ctrl */
+    uint16_t channels;              /*!< Bit n set: the link works on channel n. 0 for every channel */
+} espnow_sim_link_t;
+
+typedef struct {
+    uint32_t tx_frames;             /*!< Frames put on the air, MAC retries included */
+    uint32_t tx_retries;            /*!< Unicast attempts that were not acknowledged */
+    uint32_t tx_failed;             /*!< Unicast frames reported as failed to send_cb */
+    uint32_t tx_no_mem;             /*!< Frames refused because the node's queue was full */
+    uint64_t tx_airtime_us;         /*!< Time spent transmitting */
+    uint32_t rx_frames;             /*!< Frames handed to the receive callback */
+    uint32_t rx_lost;               /*!< Frames lost on the link */
+    uint32_t rx_collided;           /*!< Frames lost to an overlapping one */
+    uint32_t rx_off_channel;        /*!< Frames missed while listening on another channel */
+    uint32_t rx_overflow;           /*!< Frames dropped because the receive queue was full */
+} espnow_sim_counters_t;
+
+/**
+ * @brief Sees every frame a node's esp-now hands to the radio, retransmissions included
+ */
+typedef void (*espnow_sim_tx_hook_t)(size_t node, const uint8_t *data, size_t len);
+
+/**
+ * @brief The backend to pass to espnow_set_radio() together with espnow_sim_node()
+ */
+extern const espnow_radio_t espnow_sim_radio;
+
+/**
+ * @brief Creates node_count nodes on channel 1 without any link
+ *
+ * Node i has the MAC address 02:00:00:00:hi:lo of its index.
+ */
+esp_err_t espnow_sim_init(const espnow_sim_config_t *config, size_t node_count);
+
+/**
+ * @brief Sets the link from one node to another, NULL removes it
+ */
+void espnow_sim_set_link(size_t from, size_t to, const espnow_sim_link_t *link);
+
+/**
+ * @brief Sets the channel the node listens and sends on until esp-now changes it
+ */
+void espnow_sim_set_channel(size_t node, uint8_t channel);
+
+/**
+ * @brief Backend context of a node, for espnow_set_radio()
+ */
+void *espnow_sim_node(size_t node);
+
+/**
+ * @brief Runs task as the node, it and the tasks it creates see the node's esp-now
+ */
+esp_err_t espnow_sim_start(size_t node, TaskFunction_t task, void *arg);
+
+/**
+ * @brief Power cycles the node and runs task as it again, from outside of any node
+ *
+ * Its tasks end wherever they are, the radio forgets its peers and callbacks
+ * and the esp-now globals are back as linked. Storage and the update
+ * partition are kept, as NVS and flash would be.
+ */
+esp_err_t espnow_sim_restart(size_t node, TaskFunction_t task, void *arg);
+
+/**
+ * @brief Index of the node whose task is running, -1 outside of a node
+ */
+int espnow_sim_current(void);
+
+void espnow_sim_get_mac(size_t node, uint8_t mac[ESPNOW_ADDR_LEN]);
+void espnow_sim_get_counters(size_t node, espnow_sim_counters_t *counters);
+
+/**
+ * @brief Installs hook for the frames sent from now on, NULL removes it
+ */
+void espnow_sim_set_tx_hook(espnow_sim_tx_hook_t hook);
+
+/**
+ * @brief Lets every node run for duration_us of virtual time
+ */
+void espnow_sim_run(uint64_t duration_us);
+
+/**
+ * @brief Current virtual time
+ */
+uint64_t espnow_sim_time_us(void);
+
+/**
+ * @brief Prints ESP_LOGx() lines up to level, ESP_LOG_WARN by default
+ */
+void espnow_sim_set_log_level(esp_log_level_t level);
+
+#define SIM_OTA_NODE_MAX            256
+
+/**
+ * @brief Update partition, or data_1, of the node as written through esp_partition_write(), NULL before it is first erased
+ *
+ * boot tells whether the node would start it after a reset.
+ */
+const uint8_t *espnow_sim_ota_image(size_t node, bool *boot);
+
+/**
+ * @brief Bytes the node has written to its update partition so far, rewrites after a restart included
+ */
+size_t espnow_sim_ota_programmed(size_t node);
+
+/**
+ * @brief Firmware all the nodes run, read back through esp_partition_read() of the running partition
+ */
+void espnow_sim_ota_set_running(const uint8_t *image, size_t size);
+
+/**
+ * @brief Data all the nodes use, read back through esp_partition_read() of the data_0 partition
+ */
+void espnow_sim_ota_set_data(const uint8_t *image, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
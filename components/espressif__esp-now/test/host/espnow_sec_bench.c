@@ -0,0 +1,233 @@
+// Copyright 2024 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Times the unmodified espnow_security.c on secured frames the way espnow.c
+ * sends and receives them, against the mbed TLS library of the host:
+ *
+ *   rekey    the key and a fresh nonce scheduled with espnow_sec_setkey(),
+ *            then espnow_sec_auth_encrypt() into an allocated frame, as every
+ *            frame was secured before the nonce was passed per packet
+ *   iv       espnow_sec_auth_encrypt_iv() in place in a frame on the stack
+ *
+ * and the same for decryption, where iv is out of place like the receive
+ * path. Before timing, each path is checked to give the bytes of the other
+ * for the same key and nonce, to open what they sealed and to reject a frame
+ * with a flipped bit.
+ *
+ * The host has no AES instructions in mbed TLS's way and the target routes
+ * AES to its accelerator, so only the ratios between the paths carry over.
+ * Build from the component root with the shared mbed TLS 2.28 library:
+ *
+ *   gcc -O2 -g -Wall -Wno-format -Itest/host -Isrc/espnow/include \
+ *       -Isrc/utils/include -Isrc/security/include \
+ *       src/security/src/espnow_security.c test/host/espnow_sec_bench.c \
+ *       -l:libmbedcrypto.so.7 -o espnow_sec_bench
+ *   ./espnow_sec_bench [-n packets]
+ */
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "esp_log.h"
+#include "espnow.h"
+#include "espnow_security.h"
+
+static const size_t g_sizes[] = {32, 128, ESPNOW_SEC_PACKET_MAX_SIZE};
+static uint32_t g_seed = 1;
+static esp_log_level_t g_log_level = ESP_LOG_WARN;
+
+void espnow_sim_log(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    if (level > g_log_level) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "%s: ", tag);
+    vfprintf(stderr, format, args);
+    fputc('\n', stderr);
+    va_end(args);
+}
+
+const char *esp_err_to_name(esp_err_t code)
+{
+    return code == ESP_OK ? "ESP_OK" : code == ESP_FAIL ? "ESP_FAIL" : "ESP_ERR";
+}
+
+static void bench_fill(uint8_t *buf, size_t len)
+{
+    for (size_t i = 0; i < len; ++i) {
+        g_seed = g_seed * 1103515245 + 12345;
+        buf[i] = g_seed >> 16;
+    }
+}
+
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void bench_report(const char *path, size_t size, int num, double seconds, double base)
+{
+    printf("  %-8s %4zu bytes  %9.0f packets/s  %6.2f us/packet  x%.2f\n",
+           path, size, num / seconds, seconds * 1e6 / num, base / seconds);
+}
+
+/**< Seals and opens one payload on every path, returns the number of mismatches */
+static int bench_check(espnow_sec_t *sec, uint8_t app_key[APP_KEY_LEN], size_t size)
+{
+    int errors = 0;
+    uint8_t plain[ESPNOW_PAYLOAD_LEN], rekey[ESPNOW_PAYLOAD_LEN], frame[ESPNOW_PAYLOAD_LEN];
+    uint8_t out[ESPNOW_PAYLOAD_LEN];
+    uint8_t iv[IV_LEN];
+    size_t len = 0;
+
+    bench_fill(plain, size);
+    bench_fill(iv, IV_LEN);
+
+    memcpy(app_key + KEY_LEN, iv, IV_LEN);
+    espnow_sec_setkey(sec, app_key);
+    errors += espnow_sec_auth_encrypt(sec, plain, size, rekey, sizeof(rekey), &len, TAG_LEN) != ESP_OK;
+    errors += len != size + TAG_LEN;
+
+    memcpy(frame, plain, size);
+    errors += espnow_sec_auth_encrypt_iv(sec, iv, frame, size, frame, TAG_LEN) != ESP_OK;
+    errors += memcmp(frame, rekey, size + TAG_LEN) != 0;
+
+    errors += espnow_sec_auth_decrypt_iv(sec, iv, rekey, size + TAG_LEN, out, &len, TAG_LEN) != ESP_OK;
+    errors += len != size || memcmp(out, plain, size) != 0;
+
+    errors += espnow_sec_auth_decrypt_iv(sec, iv, frame, size + TAG_LEN, frame, &len, TAG_LEN) != ESP_OK;
+    errors += memcmp(frame, plain, size) != 0;
+
+    rekey[size / 2] ^= 0x10;
+    g_log_level = ESP_LOG_NONE;
+    errors += espnow_sec_auth_decrypt_iv(sec, iv, rekey, size + TAG_LEN, out, &len, TAG_LEN) == ESP_OK;
+    g_log_level = ESP_LOG_WARN;
+
+    return errors;
+}
+
+static void bench_encrypt(espnow_sec_t *sec, uint8_t app_key[APP_KEY_LEN], size_t size, int num)
+{
+    uint8_t plain[ESPNOW_PAYLOAD_LEN], frame[ESPNOW_PAYLOAD_LEN];
+    double start, rekey;
+    size_t len = 0;
+
+    bench_fill(plain, size);
+
+    start = bench_now();
+    for (int i = 0; i < num; ++i) {
+        uint8_t *frame = malloc(size + TAG_LEN + IV_LEN);
+        bench_fill(app_key + KEY_LEN, IV_LEN);
+        espnow_sec_setkey(sec, app_key);
+        espnow_sec_auth_encrypt(sec, plain, size, frame, size + TAG_LEN, &len, TAG_LEN);
+        memcpy(frame + len, app_key + KEY_LEN, IV_LEN);
+        free(frame);
+    }
+    rekey = bench_now() - start;
+    bench_report("rekey", size, num, rekey, rekey);
+
+    start = bench_now();
+    for (int i = 0; i < num; ++i) {
+        uint8_t *iv = frame + size + TAG_LEN;
+        bench_fill(iv, IV_LEN);
+        memcpy(frame, plain, size);
+        espnow_sec_auth_encrypt_iv(sec, iv, frame, size, frame, TAG_LEN);
+    }
+    bench_report("iv", size, num, bench_now() - start, rekey);
+}
+
+static void bench_decrypt(espnow_sec_t *sec, uint8_t app_key[APP_KEY_LEN], size_t size, int num)
+{
+    uint8_t sealed[ESPNOW_PAYLOAD_LEN], out[ESPNOW_PAYLOAD_LEN];
+    uint8_t iv[IV_LEN];
+    double start, rekey;
+    size_t len = 0;
+
+    bench_fill(out, size);
+    bench_fill(iv, IV_LEN);
+    espnow_sec_auth_encrypt_iv(sec, iv, out, size, sealed, TAG_LEN);
+
+    start = bench_now();
+    for (int i = 0; i < num; ++i) {
+        memcpy(app_key + KEY_LEN, iv, IV_LEN);
+        espnow_sec_setkey(sec, app_key);
+        espnow_sec_auth_decrypt(sec, sealed, size + TAG_LEN, out, sizeof(out), &len, TAG_LEN);
+    }
+    rekey = bench_now() - start;
+    bench_report("rekey", size, num, rekey, rekey);
+
+    start = bench_now();
+    for (int i = 0; i < num; ++i) {
+        espnow_sec_auth_decrypt_iv(sec, iv, sealed, size + TAG_LEN, out, &len, TAG_LEN);
+    }
+    bench_report("iv", size, num, bench_now() - start, rekey);
+}
+
+int main(int argc, char *argv[])
+{
+    int num = 200000;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:")) != -1) {
+        if (opt == 'n') {
+            num = atoi(optarg);
+        } else {
+            fprintf(stderr, "usage: %s [-n packets]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    espnow_sec_t sec;
+    uint8_t app_key[APP_KEY_LEN];
+    int errors = 0;
+
+    espnow_sec_init(&sec);
+    bench_fill(app_key, sizeof(app_key));
+
+    for (size_t i = 0; i < sizeof(g_sizes) / sizeof(g_sizes[0]); ++i) {
+        errors += bench_check(&sec, app_key, g_sizes[i]);
+    }
+
+    printf("check              %s\n", errors ? "FAILED" : "ok");
+
+    if (errors) {
+        espnow_sec_deinit(&sec);
+        return 1;
+    }
+
+    espnow_sec_setkey(&sec, app_key);
+    printf("encrypt, %d packets\n", num);
+
+    for (size_t i = 0; i < sizeof(g_sizes) / sizeof(g_sizes[0]); ++i) {
+        bench_encrypt(&sec, app_key, g_sizes[i], num);
+    }
+
+    printf("decrypt, %d packets\n", num);
+
+    for (size_t i = 0; i < sizeof(g_sizes) / sizeof(g_sizes[0]); ++i) {
+        bench_decrypt(&sec, app_key, g_sizes[i], num);
+    }
+
+    espnow_sec_deinit(&sec);
+
+    return 0;
+}
@@ -0,0 +1,913 @@
+// Copyright 2024 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Runs the unmodified espnow.c on many simulated nodes at once over the
+ * medium in espnow_radio_sim.c, so that ACK, retransmission, forwarding and
+ * the duplicate filter can be loaded far beyond a bench of boards. Each
+ * scenario sends numbered, timestamped messages through espnow_send(),
+ * espnow_send_msg() when they do not fit a frame, or espnow_stream_write(),
+ * or pushes a firmware image to every other node with espnow_ota, and
+ * reports what the receive handlers saw: unique deliveries against the
+ * expected ones, duplicates that got through the filter, latency
+ * percentiles and goodput, next to the frames the radios exchanged and the
+ * counters of the duplicate cache. Without ACKs, the frames each node
+ * forwards are also tracked, to count messages forwarded more than once.
+ *
+ * Time is virtual and every random draw comes from the seed, so a run
+ * repeats exactly and its numbers do not depend on the host.
+ *
+ * Each node needs its own copy of the esp-now globals. The esp-now sources
+ * are compiled on their own and their .data and .bss are renamed,
+ * espnow_radio_sim.c swaps those sections when the scheduler changes node.
+ * Build from the component root:
+ *
+ *   CFLAGS="-O2 -g -fno-pie -fno-common -Itest/host -Isrc/espnow/include \
+ *           -Isrc/utils/include -Isrc/security/include -Isrc/stream/include \
+ *           -Isrc/ota/include"
+ *   for f in src/espnow/src/espnow.c src/espnow/src/espnow_group.c \
+ *            src/stream/src/espnow_stream.c src/ota/espnow_ota_initiator.c \
+ *            src/ota/espnow_ota_responder.c src/ota/espnow_ota_unpack.c; do
+ *       o=$(basename $f .c).o
+ *       gcc $CFLAGS -c $f -o $o &&
+ *       objcopy --rename-section .data=espnow_node_data \
+ *               --rename-section .bss=espnow_node_bss $o || break
+ *   done
+ *   gcc $CFLAGS -no-pie espnow.o espnow_group.o espnow_stream.o \
+ *       espnow_ota_initiator.o espnow_ota_responder.o espnow_ota_unpack.o \
+ *       test/host/freertos_sim.c test/host/esp_idf_sim.c test/host/espnow_radio_sim.c \
+ *       test/host/espnow_sim.c -o espnow_sim
+ *   ./espnow_sim [-s seed] [-d dir] [-v] [scenario]
+ *
+ * Add -DCONFIG_ESPNOW_MSG_CACHE_SIZE=n or -DCONFIG_ESPNOW_MSG_CACHE_TIMEOUT=ms
+ * to CFLAGS to try another cache size or timeout.
+ *
+ * The ota_raw, ota_xz, ota_delta and ota_data_delta scenarios send images from the -d
+ * directory, which test/host/gen_ota_images.py fills. The time the nodes
+ * take to unpack is only the flash erase, decoding is not timed.
+ * ota_data sends the image as data, as an app does with a model, the nodes
+ * write it to the data_1 partition and do not set it to boot. ota_data_delta
+ * sends new_model.bin from -d that way, as a delta against the model.bin in
+ * data_0.
+ * ota_resume power cycles some nodes half way, what they stored with
+ * espnow_storage_set() survives and they only ask for what they miss.
+ *
+ * Without a scenario the list of scenarios is printed.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/param.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_random.h"
+#include "espnow.h"
+#include "espnow_stream.h"
+#include "espnow_ota.h"
+#include "espnow_radio_sim.h"
+
+#define PAYLOAD_MAGIC           0x53494d54  /* "SIMT" */
+#define START_DELAY_MS          100
+#define DRAIN_MS                5000
+#define OTA_ATTEMPTS            3
+
+typedef enum {
+    TOPOLOGY_MESH,              /* everyone hears everyone */
+    TOPOLOGY_LINE,              /* node i hears i - 1 and i + 1 */
+    TOPOLOGY_GRID,              /* square grid, neighbours and weaker diagonals */
+} topology_t;
+
+typedef struct {
+    const char *name;
+    const char *description;
+    topology_t topology;
+    size_t nodes;
+    float loss;                 /* per link, diagonals in a grid lose more */
+    uint32_t latency_us;
+    int dest;                   /* -1 for broadcast, 0 makes every other node a sender */
+    bool flood;                 /* send to dest as a forwarded broadcast */
+    bool ack;
+    bool stream;                /* every message of a sender in one espnow_stream_write() */
+    uint8_t stream_window;      /* 0 keeps the default */
+    uint32_t ota_size;          /* node 0 upgrades all others with an image of this size instead */
+    const char *ota_file;       /* or with this image from the -d directory, see gen_ota_images.py */
+    bool ota_data;              /* the nodes take the image as data, written to data_1 and not booted */
+    uint32_t restart_ms;        /* the odd nodes are power cycled at this time, 0 for never */
+    uint8_t retransmit;
+    uint8_t ttl;
+    int8_t forward_rssi;
+    uint32_t count;             /* messages per sender */
+    uint32_t size;
+    uint32_t interval_ms;
+    uint32_t limit_ms;          /* gives up after this much simulated time */
+} scenario_t;
+
+typedef struct {
+    uint32_t magic;
+    uint16_t sender;
+    uint16_t reserved;
+    uint32_t seq;
+    uint64_t sent_us;
+} __attribute__((packed)) payload_t;
+
+static const scenario_t s_scenarios[] = {
+    {
+        .name = "unicast_ack",
+        .description = "2 nodes, 20% loss, unicast with end to end ACK",
+        .topology = TOPOLOGY_MESH, .nodes = 2, .loss = 0.2f, .dest = 1, .ack = true, .retransmit = 5,
+        .count = 500, .size = 200, .interval_ms = 5, .limit_ms = 60000,
+    },
+    {
+        .name = "broadcast",
+        .description = "64 nodes in range, 5% loss, broadcast sent 10 times",
+        .topology = TOPOLOGY_MESH, .nodes = 64, .loss = 0.05f, .dest = -1, .retransmit = 10,
+        .count = 200, .size = 100, .interval_ms = 20, .limit_ms = 60000,
+    },
+    {
+        .name = "line_flood",
+        .description = "16 node chain, 10% loss, broadcast forwarded hop by hop",
+        .topology = TOPOLOGY_LINE, .nodes = 16, .loss = 0.1f, .latency_us = 100, .dest = -1,
+        .retransmit = 3, .ttl = 20, .forward_rssi = -100,
+        .count = 100, .size = 100, .interval_ms = 50, .limit_ms = 60000,
+    },
+    {
+        .name = "line_ack",
+        .description = "6 node chain, 10% loss, forwarded unicast with end to end ACK",
+        .topology = TOPOLOGY_LINE, .nodes = 6, .loss = 0.1f, .latency_us = 100, .dest = 5, .flood = true,
+        .ack = true, .retransmit = 5, .ttl = 10, .forward_rssi = -100,
+        .count = 100, .size = 100, .interval_ms = 20, .limit_ms = 120000,
+    },
+    {
+        .name = "grid_flood",
+        .description = "16x16 grid, 10% loss, hidden nodes, broadcast flooded from a corner",
+        .topology = TOPOLOGY_GRID, .nodes = 256, .loss = 0.1f, .latency_us = 100, .dest = -1,
+        .retransmit = 1, .ttl = 30, .forward_rssi = -90,
+        .count = 50, .size = 100, .interval_ms = 200, .limit_ms = 120000,
+    },
+    {
+        .name = "sink",
+        .description = "8 nodes sending to one, 5% loss, unicast with end to end ACK",
+        .topology = TOPOLOGY_MESH, .nodes = 9, .loss = 0.05f, .dest = 0, .ack = true, .retransmit = 5,
+        .count = 100, .size = 150, .interval_ms = 100, .limit_ms = 120000,
+    },
+    {
+        .name = "sink_16",
+        .description = "as sink with 16 senders, overloads the receiving node",
+        .topology = TOPOLOGY_MESH, .nodes = 17, .loss = 0.05f, .dest = 0, .ack = true, .retransmit = 5,
+        .count = 100, .size = 150, .interval_ms = 100, .limit_ms = 120000,
+    },
+    {
+        .name = "bulk_ack",
+        .description = "2 nodes, 10% loss, 1000 messages back to back with end to end ACK",
+        .topology = TOPOLOGY_MESH, .nodes = 2, .loss = 0.1f, .dest = 1, .ack = true, .retransmit = 5,
+        .count = 1000, .size = 200, .limit_ms = 120000,
+    },
+    {
+        .name = "bulk_stream",
+        .description = "as bulk_ack over the reliable stream",
+        .topology = TOPOLOGY_MESH, .nodes = 2, .loss = 0.1f, .dest = 1, .stream = true,
+        .count = 1000, .size = 200, .limit_ms = 120000,
+    },
+    {
+        .name = "sink_stream",
+        .description = "as sink over the reliable stream, all messages at once",
+        .topology = TOPOLOGY_MESH, .nodes = 9, .loss = 0.05f, .dest = 0, .stream = true,
+        .count = 100, .size = 150, .limit_ms = 120000,
+    },
+    {
+        .name = "stream_wrap",
+        .description = "2 nodes, 16% loss, stream with a window of 12 past frame 65535, where seq wraps",
+        .topology = TOPOLOGY_MESH, .nodes = 2, .loss = 0.16f, .dest = 1, .stream = true, .stream_window = 12,
+        .count = 80000, .size = 200, .limit_ms = 1200000,
+    },
+    {
+        .name = "snapshot",
+        .description = "2 nodes, 5% loss, 16 KB messages in pieces with end to end ACK",
+        .topology = TOPOLOGY_MESH, .nodes = 2, .loss = 0.05f, .dest = 1, .ack = true, .retransmit = 5,
+        .count = 20, .size = 16384, .interval_ms = 200, .limit_ms = 120000,
+    },
+    {
+        .name = "snapshot_max",
+        .description = "2 nodes, 5% loss, messages of ESPNOW_MSG_MAX_LEN in pieces with end to end ACK",
+        .topology = TOPOLOGY_MESH, .nodes = 2, .loss = 0.05f, .dest = 1, .ack = true, .retransmit = 5,
+        .count = 5, .size = ESPNOW_MSG_MAX_LEN, .interval_ms = 500, .limit_ms = 120000,
+    },
+    {
+        .name = "snapshot_bcast",
+        .description = "8 nodes in range, 5% loss, 4 KB messages in pieces broadcast 3 times",
+        .topology = TOPOLOGY_MESH, .nodes = 8, .loss = 0.05f, .dest = -1, .retransmit = 3,
+        .count = 20, .size = 4096, .interval_ms = 200, .limit_ms = 60000,
+    },
+    {
+        .name = "grid_sink",
+        .description = "6x6 grid, 10% loss, every node floods to a corner, stresses the duplicate cache",
+        .topology = TOPOLOGY_GRID, .nodes = 36, .loss = 0.1f, .latency_us = 100, .dest = 0, .flood = true,
+        .retransmit = 3, .ttl = 12, .forward_rssi = -90,
+        .count = 20, .size = 50, .interval_ms = 100, .limit_ms = 120000,
+    },
+    {
+        .name = "ota_5",
+        .description = "5 nodes in range, 10% loss, upgraded with a 256 KB image",
+        .topology = TOPOLOGY_MESH, .nodes = 6, .loss = 0.1f, .dest = -1,
+        .ota_size = 256 * 1024, .count = 1, .limit_ms = 600000,
+    },
+    {
+        .name = "ota_resume",
+        .description = "as ota_5 with nodes 1, 3 and 5 restarted half way, they resume from what they stored",
+        .topology = TOPOLOGY_MESH, .nodes = 6, .loss = 0.1f, .dest = -1,
+        .ota_size = 256 * 1024, .restart_ms = 3500, .count = 1, .limit_ms = 600000,
+    },
+    {
+        .name = "ota_10",
+        .description = "as ota_5 with 10 nodes",
+        .topology = TOPOLOGY_MESH, .nodes = 11, .loss = 0.1f, .dest = -1,
+        .ota_size = 256 * 1024, .count = 1, .limit_ms = 600000,
+    },
+    {
+        .name = "ota_25",
+        .description = "as ota_5 with 25 nodes",
+        .topology = TOPOLOGY_MESH, .nodes = 26, .loss = 0.1f, .dest = -1,
+        .ota_size = 256 * 1024, .count = 1, .limit_ms = 600000,
+    },
+    {
+        .name = "ota_50",
+        .description = "as ota_5 with 50 nodes",
+        .topology = TOPOLOGY_MESH, .nodes = 51, .loss = 0.1f, .dest = -1,
+        .ota_size = 256 * 1024, .count = 1, .limit_ms = 600000,
+    },
+    {
+        .name = "ota_100",
+        .description = "as ota_5 with 100 nodes",
+        .topology = TOPOLOGY_MESH, .nodes = 101, .loss = 0.1f, .dest = -1,
+        .ota_size = 256 * 1024, .count = 1, .limit_ms = 600000,
+    },
+    {
+        .name = "ota_raw",
+        .description = "10 nodes in range, 10% loss, upgraded with new.bin from -d as it is",
+        .topology = TOPOLOGY_MESH, .nodes = 11, .loss = 0.1f, .dest = -1,
+        .ota_file = "new.bin", .count = 1, .limit_ms = 600000,
+    },
+    {
+        .name = "ota_xz",
+        .description = "as ota_raw with new.bin xz compressed, the nodes unpack it",
+        .topology = TOPOLOGY_MESH, .nodes = 11, .loss = 0.1f, .dest = -1,
+        .ota_file = "new.bin.xz.packed", .count = 1, .limit_ms = 600000,
+    },
+    {
+        .name = "ota_delta",
+        .description = "as ota_raw with a compressed delta of new.bin against the running base.bin",
+        .topology = TOPOLOGY_MESH, .nodes = 11, .loss = 0.1f, .dest = -1,
+        .ota_file = "new.bin.delta.xz.packed", .count = 1, .limit_ms = 600000,
+    },
+    {
+        .name = "ota_data",
+        .description = "as ota_10 with the image taken as data, e.g. a model, instead of firmware",
+        .topology = TOPOLOGY_MESH, .nodes = 11, .loss = 0.1f, .dest = -1,
+        .ota_size = 256 * 1024, .ota_data = true, .count = 1, .limit_ms = 600000,
+    },
+    {
+        .name = "ota_data_delta",
+        .description = "as ota_data with a compressed delta of new_model.bin against the model.bin in use",
+        .topology = TOPOLOGY_MESH, .nodes = 11, .loss = 0.1f, .dest = -1,
+        .ota_file = "new_model.bin.delta.xz.packed", .ota_data = true, .count = 1, .limit_ms = 600000,
+    },
+};
+
+static const scenario_t *s_scenario;
+static size_t s_senders;
+static uint8_t *s_seen;
+static uint32_t *s_latency;
+static uint8_t *s_partial;      /* stream reassembly, one message per receiver and sender */
+static uint32_t *s_partial_len;
+static uint8_t *s_forwarded;    /* messages each node has forwarded */
+static uint64_t s_forwarded_unique;
+static espnow_msg_cache_stats_t s_cache;
+static const char *s_ota_dir = ".";
+static uint8_t *s_ota_image;    /* what node 0 sends */
+static size_t s_ota_size;
+static uint8_t *s_ota_target;   /* what the nodes end up with, the same unless it is packed */
+static size_t s_ota_target_size;
+static uint8_t *s_ota_base;     /* what the nodes run, or the data they use */
+static size_t s_ota_base_size;
+static struct {
+    uint32_t sent_ok;
+    uint32_t sent_fail;
+    uint32_t senders_done;
+    uint64_t first_send_us;
+    uint64_t last_delivery_us;
+    uint64_t delivered;
+    uint64_t delivered_bytes;
+    uint64_t duplicates;
+    uint64_t corrupt;
+} s_stats;
+
+static int sender_of(size_t node)
+{
+    if (s_scenario->dest == 0) {
+        return node ? (int) node - 1 : -1;
+    }
+    return node ? -1 : 0;
+}
+
+static uint64_t expected_deliveries(void)
+{
+    uint64_t messages = (uint64_t) s_senders * s_scenario->count;
+    return s_scenario->dest < 0 ? messages * (s_scenario->nodes - 1) : messages;
+}
+
+static esp_err_t data_handler(uint8_t *src_addr, void *data, size_t size, wifi_pkt_rx_ctrl_t *rx_ctrl)
+{
+    const payload_t *payload = data;
+    int node = espnow_sim_current();
+
+    if (size != s_scenario->size || payload->magic != PAYLOAD_MAGIC || payload->sender >= s_senders
+            || payload->seq >= s_scenario->count || node < 0) {
+        s_stats.corrupt++;
+        return ESP_OK;
+    }
+
+    for (size_t i = sizeof(payload_t); i < size; i++) {
+        if (((uint8_t *) data)[i] != (uint8_t) (payload->seq + i)) {
+            s_stats.corrupt++;
+            return ESP_OK;
+        }
+    }
+
+    size_t index = ((size_t) node * s_senders + payload->sender) * s_scenario->count + payload->seq;
+    if (s_seen[index]) {
+        s_stats.duplicates++;
+        return ESP_OK;
+    }
+
+    uint64_t now = espnow_sim_time_us();
+    s_seen[index] = 1;
+    s_latency[s_stats.delivered++] = (uint32_t) (now - payload->sent_us);
+    s_stats.delivered_bytes += size;
+    s_stats.last_delivery_us = now;
+    return ESP_OK;
+}
+
+static size_t node_of(const uint8_t *mac)
+{
+    return (size_t) mac[4] << 8 | mac[5];
+}
+
+static esp_err_t stream_handler(uint8_t *src_addr, void *data, size_t size, wifi_pkt_rx_ctrl_t *rx_ctrl)
+{
+    int node = espnow_sim_current();
+    int sender = sender_of(node_of(src_addr));
+    const uint8_t *bytes = data;
+
+    if (node < 0 || sender < 0) {
+        s_stats.corrupt++;
+        return ESP_OK;
+    }
+
+    /* the stream has no message boundaries, cut it back into messages */
+    size_t index = (size_t) node * s_senders + sender;
+    uint8_t *message = s_partial + index * s_scenario->size;
+    while (size) {
+        size_t n = MIN(size, s_scenario->size - s_partial_len[index]);
+        memcpy(message + s_partial_len[index], bytes, n);
+        s_partial_len[index] += n;
+        bytes += n;
+        size -= n;
+        if (s_partial_len[index] == s_scenario->size) {
+            data_handler(src_addr, message, s_scenario->size, rx_ctrl);
+            s_partial_len[index] = 0;
+        }
+    }
+    return ESP_OK;
+}
+
+/* the body after the header is a pattern of seq, so that misplaced bytes show up as corrupt */
+static void message_fill(uint8_t *data, int sender, uint32_t seq)
+{
+    payload_t *payload = (payload_t *) data;
+
+    payload->magic = PAYLOAD_MAGIC;
+    payload->sender = (uint16_t) sender;
+    payload->seq = seq;
+    payload->sent_us = espnow_sim_time_us();
+    for (size_t i = sizeof(payload_t); i < s_scenario->size; i++) {
+        data[i] = (uint8_t) (seq + i);
+    }
+}
+
+static void stream_send(const uint8_t *dest, int sender)
+{
+    size_t total = (size_t) s_scenario->count * s_scenario->size;
+    uint8_t *data = calloc(1, total);
+
+    for (uint32_t seq = 0; seq < s_scenario->count; seq++) {
+        message_fill(data + (size_t) seq * s_scenario->size, sender, seq);
+    }
+
+    if (espnow_stream_write(dest, data, total, portMAX_DELAY) == ESP_OK) {
+        s_stats.sent_ok += s_scenario->count;
+    } else {
+        s_stats.sent_fail += s_scenario->count;
+    }
+    free(data);
+}
+
+static uint8_t ota_image_byte(size_t offset)
+{
+    uint32_t x = (uint32_t) offset * 0x9E3779B1;
+    return (uint8_t) (x >> 24 ^ x >> 11);
+}
+
+static esp_err_t ota_data_cb(size_t src_offset, void *dst, size_t size)
+{
+    memcpy(dst, s_ota_image + src_offset, size);
+    return ESP_OK;
+}
+
+/* node 0 upgrades every other node at once, they are done when their image is set to boot.
+ * A node that restarted has left the OTA group, so as an application would, node 0 tries
+ * again for the ones left and they resume from the progress they stored */
+static void ota_send(void)
+{
+    size_t num = s_scenario->nodes - 1;
+    espnow_addr_t *addrs = calloc(num, sizeof(espnow_addr_t));
+    uint8_t sha_256[ESPNOW_OTA_HASH_LEN];
+    esp_err_t ret = ESP_FAIL;
+
+    for (size_t i = 0; i < num; i++) {
+        espnow_sim_get_mac(i + 1, addrs[i]);
+    }
+    memset(sha_256, 0x5a, sizeof(sha_256));
+
+    vTaskDelay(pdMS_TO_TICKS(START_DELAY_MS));
+    s_stats.first_send_us = espnow_sim_time_us();
+    for (int attempt = 0; attempt < OTA_ATTEMPTS && num && ret != ESP_OK; attempt++) {
+        espnow_ota_result_t result = { 0 };
+
+        ret = espnow_ota_initiator_send(addrs, num, sha_256, s_ota_size, ota_data_cb, &result);
+        num = result.unfinished_addr ? result.unfinished_num : 0;
+        if (num) {
+            memcpy(addrs, result.unfinished_addr, num * sizeof(espnow_addr_t));
+        }
+        espnow_ota_initiator_result_free(&result);
+    }
+
+    if (ret == ESP_OK) {
+        s_stats.sent_ok++;
+    } else {
+        s_stats.sent_fail++;
+    }
+    free(addrs);
+}
+
+/* called between slices of the run, picks up the nodes that finished since */
+static void ota_check(void)
+{
+    for (size_t i = 1; i < s_scenario->nodes; i++) {
+        bool boot = false;
+        const uint8_t *image = espnow_sim_ota_image(i, &boot);
+
+        if (s_seen[i]) {
+            continue;
+        }
+
+        /* data is never booted, it is there once all of it is */
+        if (s_scenario->ota_data) {
+            if (boot) {
+                s_seen[i] = 1;
+                s_stats.corrupt++;
+                continue;
+            }
+            if (!image || memcmp(image, s_ota_target, s_ota_target_size)) {
+                continue;
+            }
+        } else if (!boot) {
+            continue;
+        }
+
+        s_seen[i] = 1;
+        if (memcmp(image, s_ota_target, s_ota_target_size)) {
+            s_stats.corrupt++;
+            continue;
+        }
+
+        uint64_t now = espnow_sim_time_us();
+        s_latency[s_stats.delivered++] = (uint32_t) (now - s_stats.first_send_us);
+        s_stats.delivered_bytes += s_ota_target_size;
+        s_stats.last_delivery_us = now;
+    }
+}
+
+static void node_task(void *arg)
+{
+    size_t node = (size_t) (uintptr_t) arg;
+    int sender = sender_of(node);
+    espnow_config_t config = ESPNOW_INIT_CONFIG_DEFAULT();
+
+    config.forward_enable = s_scenario->ttl > 0;
+    config.receive_enable.data = true;
+    ESP_ERROR_CHECK(espnow_set_radio(&espnow_sim_radio, espnow_sim_node(node)));
+    ESP_ERROR_CHECK(espnow_init(&config));
+    ESP_ERROR_CHECK(espnow_set_config_for_data_type(ESPNOW_DATA_TYPE_DATA, true, data_handler));
+    if (s_ota_size) {
+        if (node) {
+            espnow_ota_config_t ota_config = {
+                .skip_version_check = true,
+                .progress_report_interval = 10,
+                .data_partition = s_scenario->ota_data ? esp_partition_find_first(ESP_PARTITION_TYPE_DATA, 0x40, "data_1") : NULL,
+                .data_base_partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, 0x40, "data_0"),
+            };
+            ESP_ERROR_CHECK(espnow_ota_responder_start(&ota_config));
+        } else {
+            ota_send();
+            s_stats.senders_done++;
+        }
+        return;
+    }
+    if (s_scenario->stream) {
+        espnow_stream_config_t stream_config = ESPNOW_STREAM_CONFIG_DEFAULT();
+        if (s_scenario->stream_window) {
+            stream_config.window = s_scenario->stream_window;
+        }
+        ESP_ERROR_CHECK(espnow_stream_init(&stream_config, stream_handler));
+    }
+
+    if (sender < 0) {
+        return;
+    }
+
+    uint8_t dest[ESPNOW_ADDR_LEN];
+    espnow_frame_head_t frame_head = ESPNOW_FRAME_CONFIG_DEFAULT();
+    frame_head.broadcast = s_scenario->dest < 0 || s_scenario->flood;
+    frame_head.ack = s_scenario->ack;
+    frame_head.retransmit_count = s_scenario->retransmit;
+    frame_head.forward_ttl = s_scenario->ttl;
+    frame_head.forward_rssi = s_scenario->forward_rssi;
+
+    if (s_scenario->dest < 0) {
+        memcpy(dest, ESPNOW_ADDR_BROADCAST, ESPNOW_ADDR_LEN);
+    } else {
+        espnow_sim_get_mac(s_scenario->dest, dest);
+        if (!frame_head.broadcast) {
+            ESP_ERROR_CHECK(espnow_add_peer(dest, NULL));
+        }
+    }
+
+    if (s_scenario->stream) {
+        stream_send(dest, sender);
+        s_stats.senders_done++;
+        return;
+    }
+
+    uint8_t *data = calloc(1, s_scenario->size);
+
+    /* spread the senders out, they would otherwise all start in one slot */
+    vTaskDelay(pdMS_TO_TICKS(START_DELAY_MS + esp_random() % (s_scenario->interval_ms + 1)));
+    if (!s_stats.first_send_us) {
+        s_stats.first_send_us = espnow_sim_time_us();
+    }
+
+    for (uint32_t seq = 0; seq < s_scenario->count; seq++) {
+        esp_err_t ret;
+
+        message_fill(data, sender, seq);
+        if (s_scenario->size > ESPNOW_DATA_LEN) {
+            /* the header and the body as separate buffers, as an application would have them */
+            espnow_iov_t iov[] = {
+                { data, sizeof(payload_t) },
+                { data + sizeof(payload_t), s_scenario->size - sizeof(payload_t) },
+            };
+            ret = espnow_send_msg(ESPNOW_DATA_TYPE_DATA, dest, iov, 2, &frame_head, portMAX_DELAY);
+        } else {
+            ret = espnow_send(ESPNOW_DATA_TYPE_DATA, dest, data, s_scenario->size, &frame_head, portMAX_DELAY);
+        }
+
+        if (ret == ESP_OK) {
+            s_stats.sent_ok++;
+        } else {
+            s_stats.sent_fail++;
+        }
+        vTaskDelay(pdMS_TO_TICKS(s_scenario->interval_ms));
+    }
+
+    free(data);
+    s_stats.senders_done++;
+}
+
+static void link_set(size_t from, size_t to, float loss, int8_t rssi)
+{
+    espnow_sim_link_t link = {
+        .loss = loss,
+        .latency_us = s_scenario->latency_us,
+        .rssi = rssi,
+    };
+    espnow_sim_set_link(from, to, &link);
+    espnow_sim_set_link(to, from, &link);
+}
+
+static void topology_build(void)
+{
+    const scenario_t *sc = s_scenario;
+
+    switch (sc->topology) {
+    case TOPOLOGY_MESH:
+        for (size_t i = 0; i < sc->nodes; i++) {
+            for (size_t j = i + 1; j < sc->nodes; j++) {
+                link_set(i, j, sc->loss, -50);
+            }
+        }
+        break;
+
+    case TOPOLOGY_LINE:
+        for (size_t i = 0; i + 1 < sc->nodes; i++) {
+            link_set(i, i + 1, sc->loss, -70);
+        }
+        break;
+
+    case TOPOLOGY_GRID: {
+        size_t side = 1;
+        while ((side + 1) * (side + 1) <= sc->nodes) {
+            side++;
+        }
+        for (size_t i = 0; i < sc->nodes; i++) {
+            size_t row = i / side;
+            size_t col = i % side;
+            if (col + 1 < side && i + 1 < sc->nodes) {
+                link_set(i, i + 1, sc->loss, -70);
+            }
+            if (i + side < sc->nodes) {
+                link_set(i, i + side, sc->loss, -70);
+            }
+            /* diagonals are further away, weaker and lossier */
+            if (col + 1 < side && i + side + 1 < sc->nodes) {
+                link_set(i, i + side + 1, sc->loss + (1 - sc->loss) * 0.3f, -85);
+            }
+            if (col > 0 && i + side - 1 < sc->nodes && row + 1 < side) {
+                link_set(i, i + side - 1, sc->loss + (1 - sc->loss) * 0.3f, -85);
+            }
+        }
+        break;
+    }
+    }
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *) a;
+    uint32_t y = *(const uint32_t *) b;
+    return x < y ? -1 : x > y;
+}
+
+static double percentile_ms(double p)
+{
+    if (!s_stats.delivered) {
+        return 0;
+    }
+    size_t index = (size_t) (p * (s_stats.delivered - 1) + 0.5);
+    return s_latency[index] / 1000.0;
+}
+
+/* picks the forwards of data frames out of everything the nodes send */
+static void tx_hook(size_t node, const uint8_t *data, size_t len)
+{
+    const size_t head_len = 2 + sizeof(espnow_frame_head_t) + 2 * ESPNOW_ADDR_LEN;
+    const uint8_t *src_addr = data + 2 + sizeof(espnow_frame_head_t) + ESPNOW_ADDR_LEN;
+    const payload_t *payload = (const payload_t *) (data + head_len);
+    uint8_t mac[ESPNOW_ADDR_LEN];
+
+    espnow_sim_get_mac(node, mac);
+    if (len < head_len + sizeof(payload_t) || (data[0] & 0xf) != ESPNOW_DATA_TYPE_DATA
+            || ESPNOW_ADDR_IS_EQUAL(src_addr, mac) || payload->magic != PAYLOAD_MAGIC
+            || payload->sender >= s_senders || payload->seq >= s_scenario->count) {
+        return;
+    }
+
+    size_t index = (node * s_senders + payload->sender) * s_scenario->count + payload->seq;
+    if (!s_forwarded[index]) {
+        s_forwarded[index] = 1;
+        s_forwarded_unique++;
+    }
+}
+
+static void cache_stats_task(void *arg)
+{
+    espnow_msg_cache_stats_t stats;
+
+    espnow_get_msg_cache_stats(&stats);
+    s_cache.lookup += stats.lookup;
+    s_cache.hit += stats.hit;
+    s_cache.evicted += stats.evicted;
+    s_cache.forwarded += stats.forwarded;
+}
+
+static void scenario_report(void)
+{
+    const scenario_t *sc = s_scenario;
+    espnow_sim_counters_t total = { 0 };
+    uint64_t expected = expected_deliveries();
+
+    for (size_t i = 0; i < sc->nodes; i++) {
+        espnow_sim_counters_t c;
+        espnow_sim_get_counters(i, &c);
+        total.tx_frames += c.tx_frames;
+        total.tx_retries += c.tx_retries;
+        total.tx_failed += c.tx_failed;
+        total.tx_no_mem += c.tx_no_mem;
+        total.tx_airtime_us += c.tx_airtime_us;
+        total.rx_frames += c.rx_frames;
+        total.rx_lost += c.rx_lost;
+        total.rx_collided += c.rx_collided;
+        total.rx_off_channel += c.rx_off_channel;
+        total.rx_overflow += c.rx_overflow;
+    }
+
+    qsort(s_latency, s_stats.delivered, sizeof(uint32_t), compare_u32);
+    uint64_t elapsed_us = s_stats.last_delivery_us > s_stats.first_send_us ?
+                          s_stats.last_delivery_us - s_stats.first_send_us : 1;
+
+    printf("%s: %s\n", sc->name, sc->description);
+    printf("  sent               %u ok, %u failed of %u x %u B\n", s_stats.sent_ok, s_stats.sent_fail,
+           (unsigned) (s_senders * sc->count), sc->size);
+    printf("  delivered          %llu of %llu (%.1f%%), %llu duplicates, %llu corrupt\n",
+           (unsigned long long) s_stats.delivered, (unsigned long long) expected,
+           expected ? 100.0 * s_stats.delivered / expected : 0.0,
+           (unsigned long long) s_stats.duplicates, (unsigned long long) s_stats.corrupt);
+    printf("  latency ms         p50 %.2f  p90 %.2f  p99 %.2f  max %.2f\n", percentile_ms(0.5),
+           percentile_ms(0.9), percentile_ms(0.99), percentile_ms(1.0));
+    printf("  goodput            %.1f kbit/s over %.2f s\n", s_stats.delivered_bytes * 8000.0 / elapsed_us,
+           elapsed_us / 1e6);
+    printf("  radio tx           %u frames, %u MAC retries, %u failed, %u refused, %.2f s airtime\n",
+           total.tx_frames, total.tx_retries, total.tx_failed, total.tx_no_mem, total.tx_airtime_us / 1e6);
+    printf("  radio rx           %u frames, %u lost, %u collided, %u off channel, %u overflow\n",
+           total.rx_frames, total.rx_lost, total.rx_collided, total.rx_off_channel, total.rx_overflow);
+    printf("  filtered           %.2f frames received per delivery\n",
+           s_stats.delivered ? (double) total.rx_frames / s_stats.delivered : 0.0);
+    printf("  duplicate cache    %u lookups, %.1f%% dropped, %u evicted early, %u forwarded",
+           s_cache.lookup, s_cache.lookup ? 100.0 * s_cache.hit / s_cache.lookup : 0.0,
+           s_cache.evicted, s_cache.forwarded);
+    /* ACKs are forwarded too and would be counted as repeats */
+    if (!sc->ack) {
+        printf(", %llu again", (unsigned long long) (s_cache.forwarded - MIN(s_cache.forwarded, s_forwarded_unique)));
+    }
+    printf("\n");
+}
+
+static uint8_t *file_load(const char *path, size_t *size)
+{
+    FILE *f = fopen(path, "rb");
+    uint8_t *data = NULL;
+    long len = -1;
+
+    if (f && !fseek(f, 0, SEEK_END) && (len = ftell(f)) > 0 && !fseek(f, 0, SEEK_SET)
+            && (data = malloc(len)) && fread(data, 1, len, f) != (size_t) len) {
+        free(data);
+        data = NULL;
+    }
+    if (f) {
+        fclose(f);
+    }
+    *size = data ? (size_t) len : 0;
+    return data;
+}
+
+static int scenario_run(const scenario_t *sc, uint32_t seed)
+{
+    espnow_sim_config_t config = ESPNOW_SIM_CONFIG_DEFAULT();
+    config.seed = seed;
+
+    s_scenario = sc;
+    s_senders = sc->dest == 0 ? sc->nodes - 1 : 1;
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_seen = calloc((size_t) sc->nodes * s_senders * sc->count, 1);
+    s_latency = calloc((size_t) sc->nodes * s_senders * sc->count, sizeof(uint32_t));
+    s_partial = calloc((size_t) sc->nodes * s_senders, sc->size);
+    s_partial_len = calloc((size_t) sc->nodes * s_senders, sizeof(uint32_t));
+    s_forwarded = calloc((size_t) sc->nodes * s_senders * sc->count, 1);
+    if (!s_seen || !s_latency || !s_partial || !s_partial_len || !s_forwarded
+            || espnow_sim_init(&config, sc->nodes) != ESP_OK) {
+        return -1;
+    }
+    espnow_sim_set_tx_hook(tx_hook);
+
+    if (sc->ota_file) {
+        char path[256];
+
+        snprintf(path, sizeof(path), "%s/%s", s_ota_dir, sc->ota_file);
+        s_ota_image = file_load(path, &s_ota_size);
+        snprintf(path, sizeof(path), "%s/%s", s_ota_dir, sc->ota_data ? "new_model.bin" : "new.bin");
+        s_ota_target = file_load(path, &s_ota_target_size);
+        snprintf(path, sizeof(path), "%s/%s", s_ota_dir, sc->ota_data ? "model.bin" : "base.bin");
+        s_ota_base = file_load(path, &s_ota_base_size);
+        if (!s_ota_image || !s_ota_target || !s_ota_base) {
+            fprintf(stderr, "no images in %s, make them with test/host/gen_ota_images.py\n", s_ota_dir);
+            return -1;
+        }
+        if (sc->ota_data) {
+            espnow_sim_ota_set_data(s_ota_base, s_ota_base_size);
+        } else {
+            espnow_sim_ota_set_running(s_ota_base, s_ota_base_size);
+        }
+    } else if (sc->ota_size) {
+        s_ota_image = malloc(sc->ota_size);
+        for (size_t i = 0; i < sc->ota_size; i++) {
+            s_ota_image[i] = ota_image_byte(i);
+        }
+        s_ota_size = sc->ota_size;
+        s_ota_target = s_ota_image;
+        s_ota_target_size = sc->ota_size;
+    }
+
+    topology_build();
+    for (size_t i = 0; i < sc->nodes; i++) {
+        espnow_sim_start(i, node_task, (void *) (uintptr_t) i);
+    }
+
+    uint64_t done_us = 0;
+    size_t restarted = 0;
+    while (espnow_sim_time_us() < (uint64_t) sc->limit_ms * 1000) {
+        espnow_sim_run(100 * 1000);
+        if (sc->restart_ms && !restarted && espnow_sim_time_us() >= (uint64_t) sc->restart_ms * 1000) {
+            for (size_t i = 1; i < sc->nodes; i += 2) {
+                espnow_sim_restart(i, node_task, (void *) (uintptr_t) i);
+                restarted++;
+            }
+        }
+        if (s_ota_size) {
+            ota_check();
+        }
+        if (!done_us && s_stats.senders_done == s_senders) {
+            done_us = espnow_sim_time_us();
+        }
+        if (done_us && espnow_sim_time_us() - done_us >= DRAIN_MS * 1000) {
+            break;
+        }
+    }
+
+    /* the counters live in each node's copy of espnow.c */
+    for (size_t i = 0; i < sc->nodes; i++) {
+        espnow_sim_start(i, cache_stats_task, NULL);
+    }
+    espnow_sim_run(1000);
+
+    scenario_report();
+    if (restarted) {
+        size_t programmed = 0;
+        for (size_t i = 1; i < sc->nodes; i++) {
+            programmed += espnow_sim_ota_programmed(i);
+        }
+        printf("  restarts           %zu nodes at %.1f s, %.1f%% of the image written again\n", restarted,
+               sc->restart_ms / 1000.0, 100.0 * programmed / ((sc->nodes - 1) * s_ota_size) - 100);
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t seed = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:d:v")) != -1) {
+        switch (opt) {
+        case 's':
+            seed = strtoul(optarg, NULL, 0);
+            break;
+        case 'd':
+            s_ota_dir = optarg;
+            break;
+        case 'v':
+            espnow_sim_set_log_level(ESP_LOG_INFO);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-s seed] [-d dir] [-v] [scenario]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    /* the esp-now globals are per process, one scenario per run */
+    const char *name = optind < argc ? argv[optind] : NULL;
+    if (!name) {
+        for (size_t i = 0; i < sizeof(s_scenarios) / sizeof(s_scenarios[0]); i++) {
+            printf("%-12s %s\n", s_scenarios[i].name, s_scenarios[i].description);
+        }
+        return 0;
+    }
+    for (size_t i = 0; i < sizeof(s_scenarios) / sizeof(s_scenarios[0]); i++) {
+        if (!strcmp(s_scenarios[i].name, name)) {
+            return scenario_run(&s_scenarios[i], seed) ? 1 : 0;
+        }
+    }
+    fprintf(stderr, "unknown scenario %s\n", name);
+    return 1;
+}
@@ -0,0 +1,32 @@
+// Host build stand-in for the IDF header, see espnow_sim.c
+// Tasks are coroutines on a virtual clock, see freertos_sim.c
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "sdkconfig.h"
+
+typedef int32_t BaseType_t;
+typedef uint32_t UBaseType_t;
+typedef uint32_t TickType_t;
+
+#define pdFALSE                 ((BaseType_t) 0)
+#define pdTRUE                  ((BaseType_t) 1)
+#define pdPASS                  pdTRUE
+#define pdFAIL                  pdFALSE
+
+#define configTICK_RATE_HZ      1000
+#define configMAX_PRIORITIES    25
+
+#define portMAX_DELAY           ((TickType_t) 0xffffffffUL)
+#define portTICK_PERIOD_MS      ((TickType_t) 1000 / configTICK_RATE_HZ)
+#define portTICK_RATE_MS        portTICK_PERIOD_MS
+#define pdMS_TO_TICKS(ms)       ((TickType_t) ((uint64_t) (ms) * configTICK_RATE_HZ / 1000))
+#define pdTICKS_TO_MS(ticks)    ((TickType_t) ((uint64_t) (ticks) * 1000 / configTICK_RATE_HZ))
+
+#define BIT(nr)                 (1UL << (nr))
+#define BIT0                    0x00000001
+#define BIT1                    0x00000002
+#define BIT2                    0x00000004
+#define BIT3                    0x00000008
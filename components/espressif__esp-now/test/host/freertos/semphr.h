@@ -0,0 +1,14 @@
+// Host build stand-in for the IDF header, see espnow_sim.c
+// A mutex is a queue of one empty item that starts full
+#pragma once
+
+#include "freertos/queue.h"
+
+typedef QueueHandle_t SemaphoreHandle_t;
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+
+#define xSemaphoreCreateBinary()        xQueueCreate(1, 0)
+#define xSemaphoreTake(sem, timeout)    xQueueReceive(sem, NULL, timeout)
+#define xSemaphoreGive(sem)             xQueueSend(sem, NULL, 0)
+#define vSemaphoreDelete(sem)           vQueueDelete(sem)
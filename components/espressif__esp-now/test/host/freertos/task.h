@@ -0,0 +1,27 @@
+// Host build stand-in for the IDF header, see espnow_sim.c
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct sim_task *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *arg);
+
+// priority and core are ignored, ready tasks run in the order they became ready
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char *name, uint32_t stack_depth, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core_id);
+void vTaskDelete(TaskHandle_t task);
+void vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount(void);
+
+#define xTaskCreate(task, name, stack_depth, arg, priority, handle) \
+    xTaskCreatePinnedToCore(task, name, stack_depth, arg, priority, handle, -1)
+#define taskYIELD()             vTaskDelay(0)
+#define tskIDLE_PRIORITY        ((UBaseType_t) 0)
+
+#ifdef __cplusplus
+}
+#endif
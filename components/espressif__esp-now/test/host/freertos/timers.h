@@ -0,0 +1,5 @@
+// Host build stand-in for the IDF header, see espnow_sim.c
+// Nothing built on the host uses software timers
+#pragma once
+
+#include "freertos/FreeRTOS.h"
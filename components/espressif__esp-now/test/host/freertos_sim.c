@@ -0,0 +1,514 @@
+// Copyright 2024 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * The FreeRTOS calls esp-now makes, as ucontext coroutines on one host
+ * thread. A task runs until it blocks, ready tasks run first in first out
+ * and virtual time only advances when none is left, see freertos_sim.h.
+ *
+ * A blocked task links a waiter on its own stack into the object it waits
+ * on. Waking means marking the task ready, it unlinks the waiter itself once
+ * it runs again; a timeout entry in the event heap carries the wait
+ * generation so that a stale one is ignored.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "freertos_sim.h"
+
+#define SIM_STACK_SIZE  (64 * 1024)
+
+typedef enum {
+    SIM_TASK_READY,
+    SIM_TASK_BLOCKED,
+    SIM_TASK_DEAD,
+} sim_task_state_t;
+
+struct sim_task {
+    ucontext_t ctx;
+    void *stack;
+    TaskFunction_t fn;
+    void *arg;
+    void *owner;
+    const char *name;
+    sim_task_state_t state;
+    uint32_t wait_gen;
+    bool timed_out;
+    struct sim_task *next_ready;
+    struct sim_task *next_task;     /* every task ever created, see sim_owner_stop() */
+};
+
+struct sim_waiter {
+    struct sim_task *task;
+    uint32_t gen;
+    struct sim_waiter *next;
+};
+
+struct sim_queue {
+    uint8_t *items;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t head;
+    UBaseType_t count;
+    struct sim_waiter *receivers;
+    struct sim_waiter *senders;
+};
+
+struct sim_event_group {
+    EventBits_t bits;
+    struct sim_waiter *waiters;
+};
+
+typedef struct {
+    uint64_t time;
+    uint64_t seq;
+    sim_callback_t cb;          /* NULL for a task timeout */
+    void *arg;
+    struct sim_task *task;
+    uint32_t gen;
+} sim_event_t;
+
+static uint64_t s_now;
+static uint64_t s_seq;
+static sim_event_t *s_events;
+static size_t s_event_count;
+static size_t s_event_cap;
+
+static ucontext_t s_sched_ctx;
+static struct sim_task *s_tasks;
+static struct sim_task *s_current;
+static struct sim_task *s_ready_head;
+static struct sim_task *s_ready_tail;
+static void *s_loaded_owner;
+static sim_owner_switch_t s_owner_switch;
+
+static bool event_before(const sim_event_t *a, const sim_event_t *b)
+{
+    return a->time < b->time || (a->time == b->time && a->seq < b->seq);
+}
+
+static void event_push(sim_event_t event)
+{
+    if (s_event_count == s_event_cap) {
+        s_event_cap = s_event_cap ? s_event_cap * 2 : 256;
+        s_events = realloc(s_events, s_event_cap * sizeof(sim_event_t));
+        if (!s_events) {
+            abort();
+        }
+    }
+    event.seq = s_seq++;
+    size_t i = s_event_count++;
+    while (i > 0 && event_before(&event, &s_events[(i - 1) / 2])) {
+        s_events[i] = s_events[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    s_events[i] = event;
+}
+
+static sim_event_t event_pop(void)
+{
+    sim_event_t top = s_events[0];
+    sim_event_t last = s_events[--s_event_count];
+    size_t i = 0;
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= s_event_count) {
+            break;
+        }
+        if (child + 1 < s_event_count && event_before(&s_events[child + 1], &s_events[child])) {
+            child++;
+        }
+        if (!event_before(&s_events[child], &last)) {
+            break;
+        }
+        s_events[i] = s_events[child];
+        i = child;
+    }
+    s_events[i] = last;
+    return top;
+}
+
+static void make_ready(struct sim_task *task)
+{
+    task->state = SIM_TASK_READY;
+    task->next_ready = NULL;
+    if (s_ready_tail) {
+        s_ready_tail->next_ready = task;
+    } else {
+        s_ready_head = task;
+    }
+    s_ready_tail = task;
+}
+
+static void wake_all(struct sim_waiter *list)
+{
+    for (struct sim_waiter *w = list; w; w = w->next) {
+        if (w->task->state == SIM_TASK_BLOCKED && w->task->wait_gen == w->gen) {
+            w->task->timed_out = false;
+            make_ready(w->task);
+        }
+    }
+}
+
+static void require_task(const char *what)
+{
+    if (!s_current) {
+        fprintf(stderr, "%s would block outside of a task\n", what);
+        abort();
+    }
+}
+
+static uint64_t deadline_of(TickType_t ticks)
+{
+    return ticks == portMAX_DELAY ? UINT64_MAX : s_now + (uint64_t) ticks * 1000 * portTICK_PERIOD_MS;
+}
+
+/* Blocks the running task on list until woken or the deadline, false on timeout */
+static bool block_on(struct sim_waiter **list, uint64_t deadline)
+{
+    struct sim_task *self = s_current;
+    struct sim_waiter waiter = { .task = self, .gen = ++self->wait_gen, .next = NULL };
+
+    if (list) {
+        waiter.next = *list;
+        *list = &waiter;
+    }
+    if (deadline != UINT64_MAX) {
+        event_push((sim_event_t) {
+            .time = deadline, .task = self, .gen = waiter.gen
+        });
+    }
+    self->state = SIM_TASK_BLOCKED;
+    self->timed_out = false;
+    swapcontext(&self->ctx, &s_sched_ctx);
+
+    if (list) {
+        for (struct sim_waiter **p = list; *p; p = &(*p)->next) {
+            if (*p == &waiter) {
+                *p = waiter.next;
+                break;
+            }
+        }
+    }
+    return !self->timed_out;
+}
+
+uint64_t sim_time_us(void)
+{
+    return s_now;
+}
+
+void sim_schedule(uint64_t time_us, sim_callback_t cb, void *arg)
+{
+    event_push((sim_event_t) {
+        .time = time_us < s_now ? s_now : time_us, .cb = cb, .arg = arg
+    });
+}
+
+void *sim_current_owner(void)
+{
+    return s_current ? s_current->owner : NULL;
+}
+
+void sim_set_owner_switch(sim_owner_switch_t hook)
+{
+    s_owner_switch = hook;
+}
+
+static void task_entry(void)
+{
+    s_current->fn(s_current->arg);
+    vTaskDelete(NULL);
+}
+
+BaseType_t sim_task_create(void *owner, TaskFunction_t fn, const char *name, void *arg, TaskHandle_t *handle)
+{
+    struct sim_task *task = calloc(1, sizeof(struct sim_task));
+    if (!task || !(task->stack = malloc(SIM_STACK_SIZE))) {
+        free(task);
+        return pdFAIL;
+    }
+    task->fn = fn;
+    task->arg = arg;
+    task->owner = owner;
+    task->name = name;
+    getcontext(&task->ctx);
+    task->ctx.uc_stack.ss_sp = task->stack;
+    task->ctx.uc_stack.ss_size = SIM_STACK_SIZE;
+    task->ctx.uc_link = &s_sched_ctx;
+    makecontext(&task->ctx, task_entry, 0);
+    task->next_task = s_tasks;
+    s_tasks = task;
+    make_ready(task);
+    if (handle) {
+        *handle = task;
+    }
+    return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t task, const char *name, uint32_t stack_depth, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core_id)
+{
+    (void) stack_depth;
+    (void) priority;
+    (void) core_id;
+    return sim_task_create(sim_current_owner(), task, name, arg, handle);
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if (!task) {
+        task = s_current;
+    }
+    task->state = SIM_TASK_DEAD;
+    task->wait_gen++;
+    if (task == s_current) {
+        swapcontext(&task->ctx, &s_sched_ctx);
+    }
+    /* A task deleted while blocked still has its waiter linked from its
+     * stack, so only the stack of a task ending itself is freed */
+}
+
+void sim_owner_stop(void *owner)
+{
+    if (s_current && s_current->owner == owner) {
+        fprintf(stderr, "A task cannot stop its own owner\n");
+        abort();
+    }
+
+    /* like vTaskDelete() of a blocked task, the stacks are kept for the waiters linked from them */
+    for (struct sim_task *task = s_tasks; task; task = task->next_task) {
+        if (task->owner == owner && task->state != SIM_TASK_DEAD) {
+            task->state = SIM_TASK_DEAD;
+            task->wait_gen++;
+        }
+    }
+
+    /* hand the owner's state back, so that it can be replaced before its next task runs */
+    if (owner && s_loaded_owner == owner) {
+        if (s_owner_switch) {
+            s_owner_switch(owner, NULL);
+        }
+        s_loaded_owner = NULL;
+    }
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    require_task("vTaskDelay");
+    if (ticks == 0) {
+        make_ready(s_current);
+        swapcontext(&s_current->ctx, &s_sched_ctx);
+        return;
+    }
+    block_on(NULL, deadline_of(ticks));
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t) (s_now / 1000 / portTICK_PERIOD_MS);
+}
+
+static void run_task(struct sim_task *task)
+{
+    if (task->owner != s_loaded_owner) {
+        if (s_owner_switch) {
+            s_owner_switch(s_loaded_owner, task->owner);
+        }
+        s_loaded_owner = task->owner;
+    }
+    s_current = task;
+    swapcontext(&s_sched_ctx, &task->ctx);
+    s_current = NULL;
+    if (task->state == SIM_TASK_DEAD) {
+        /* the handle stays, stale timeouts in the heap still point at it */
+        free(task->stack);
+        task->stack = NULL;
+    }
+}
+
+void sim_run_until(uint64_t time_us)
+{
+    for (;;) {
+        while (s_ready_head) {
+            struct sim_task *task = s_ready_head;
+            s_ready_head = task->next_ready;
+            if (!s_ready_head) {
+                s_ready_tail = NULL;
+            }
+            if (task->state == SIM_TASK_READY) {
+                run_task(task);
+            }
+        }
+        if (!s_event_count || s_events[0].time > time_us) {
+            break;
+        }
+        sim_event_t event = event_pop();
+        s_now = event.time;
+        if (event.cb) {
+            event.cb(event.arg);
+        } else if (event.task->state == SIM_TASK_BLOCKED && event.task->wait_gen == event.gen) {
+            event.task->timed_out = true;
+            make_ready(event.task);
+        }
+    }
+    if (s_now < time_us) {
+        s_now = time_us;
+    }
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    struct sim_queue *queue = calloc(1, sizeof(struct sim_queue));
+    if (!queue) {
+        return NULL;
+    }
+    queue->length = length;
+    queue->item_size = item_size;
+    if (item_size && !(queue->items = malloc((size_t) length * item_size))) {
+        free(queue);
+        return NULL;
+    }
+    return queue;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    QueueHandle_t queue = xQueueCreate(1, 0);
+    if (queue) {
+        queue->count = 1;
+    }
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    if (queue) {
+        free(queue->items);
+        free(queue);
+    }
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t timeout)
+{
+    uint64_t deadline = deadline_of(timeout);
+    while (queue->count == queue->length) {
+        if (timeout == 0 || s_now >= deadline) {
+            return pdFAIL;
+        }
+        require_task("xQueueSend");
+        if (!block_on(&queue->senders, deadline)) {
+            return pdFAIL;
+        }
+    }
+    if (queue->item_size) {
+        UBaseType_t tail = (queue->head + queue->count) % queue->length;
+        memcpy(queue->items + (size_t) tail * queue->item_size, item, queue->item_size);
+    }
+    queue->count++;
+    wake_all(queue->receivers);
+    return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t timeout)
+{
+    uint64_t deadline = deadline_of(timeout);
+    while (queue->count == 0) {
+        if (timeout == 0 || s_now >= deadline) {
+            return pdFAIL;
+        }
+        require_task("xQueueReceive");
+        if (!block_on(&queue->receivers, deadline)) {
+            return pdFAIL;
+        }
+    }
+    if (queue->item_size) {
+        memcpy(item, queue->items + (size_t) queue->head * queue->item_size, queue->item_size);
+    }
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    wake_all(queue->senders);
+    return pdPASS;
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue)
+{
+    queue->head = 0;
+    queue->count = 0;
+    wake_all(queue->senders);
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    return queue->count;
+}
+
+EventGroupHandle_t xEventGroupCreate(void)
+{
+    return calloc(1, sizeof(struct sim_event_group));
+}
+
+void vEventGroupDelete(EventGroupHandle_t group)
+{
+    free(group);
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits)
+{
+    group->bits |= bits;
+    wake_all(group->waiters);
+    return group->bits;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits)
+{
+    EventBits_t previous = group->bits;
+    group->bits &= ~bits;
+    return previous;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group)
+{
+    return group->bits;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clear_on_exit,
+                                BaseType_t wait_for_all, TickType_t timeout)
+{
+    uint64_t deadline = deadline_of(timeout);
+    for (;;) {
+        EventBits_t value = group->bits;
+        if (wait_for_all ? (value & bits) == bits : (value & bits) != 0) {
+            if (clear_on_exit) {
+                group->bits &= ~bits;
+            }
+            return value;
+        }
+        if (timeout == 0 || s_now >= deadline) {
+            return value;
+        }
+        require_task("xEventGroupWaitBits");
+        if (!block_on(&group->waiters, deadline)) {
+            return group->bits;
+        }
+    }
+}
@@ -0,0 +1,79 @@
+// Copyright 2024 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Host only side of freertos_sim.c. Time is virtual: it only moves when no
+ * task is ready to run, to the earliest timeout or scheduled callback, so a
+ * run does not depend on the speed or load of the host and repeats exactly.
+ *
+ * Every task belongs to an owner, inherited from the task that created it.
+ * The radio simulator makes each node an owner and uses the switch hook to
+ * swap that node's copy of the esp-now globals in.
+ */
+#pragma once
+
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void (*sim_callback_t)(void *arg);
+typedef void (*sim_owner_switch_t)(void *from, void *to);
+
+/**
+ * @brief Virtual time in microseconds, xTaskGetTickCount() is this in ms
+ */
+uint64_t sim_time_us(void);
+
+/**
+ * @brief Calls cb at time_us from the scheduler, outside of any task
+ *
+ * @attention cb must not block, FreeRTOS calls with a zero timeout are fine
+ */
+void sim_schedule(uint64_t time_us, sim_callback_t cb, void *arg);
+
+/**
+ * @brief Creates a task of the given owner, tasks it creates inherit it
+ */
+BaseType_t sim_task_create(void *owner, TaskFunction_t task, const char *name, void *arg, TaskHandle_t *handle);
+
+/**
+ * @brief Ends every task of owner wherever it is blocked, as a reset would
+ *
+ * The switch hook is called to put the owner's state away if it is loaded.
+ * Not from a task of owner itself.
+ */
+void sim_owner_stop(void *owner);
+
+/**
+ * @brief Owner of the running task, NULL from the scheduler
+ */
+void *sim_current_owner(void);
+
+/**
+ * @brief Called before a task of another owner than the last one runs
+ */
+void sim_set_owner_switch(sim_owner_switch_t hook);
+
+/**
+ * @brief Runs tasks and callbacks until virtual time would pass time_us
+ */
+void sim_run_until(uint64_t time_us);
+
+#ifdef __cplusplus
+}
+#endif
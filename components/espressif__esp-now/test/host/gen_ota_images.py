@@ -0,0 +1,102 @@
+#!/usr/bin/env python3
+#
+# Copyright 2024 Espressif Systems (Shanghai) PTE LTD
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Makes the images the ota_raw, ota_xz, ota_delta and ota_data_delta scenarios of espnow_sim send:
+#   base.bin                        the firmware the nodes run
+#   new.bin                         the next one, a few code changes and another model
+#   new.bin.xz.packed               new.bin packed by gen_custom_ota.py
+#   new.bin.delta.xz.packed         new.bin packed as a delta against base.bin
+#   model.bin                       the model of base.bin, the data the nodes use
+#   new_model.bin                   the model with its last layers retrained
+#   new_model.bin.delta.xz.packed   new_model.bin packed as a delta against model.bin
+#
+# Real builds can be used instead, copy them to base.bin and new.bin and two .tflite files
+# to model.bin and new_model.bin, then add --no_firmware.
+
+import argparse
+import os
+import random
+import shutil
+import subprocess
+import sys
+
+GEN_CUSTOM_OTA = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                              '../../../espressif__cmake_utilities/scripts/gen_custom_ota.py')
+
+def code(rng, size):
+    # some instructions are far more common than others, this compresses about as well as an app
+    vocabulary = random.Random(0)
+    words = [vocabulary.randbytes(4) for _ in range(16384)]
+    return b''.join(words[min(int(rng.expovariate(4 / len(words))), len(words) - 1)] for _ in range(size // 4))
+
+def firmware(seed, size, model_size):
+    rng = random.Random(seed)
+    image = bytearray(code(rng, size - model_size))
+    # the app image header, so that gen_custom_ota.py can copy it
+    image[0] = 0xE9
+    model = random.Random(seed + 1).randbytes(model_size)
+    return image, bytes(model)
+
+def pack(directory, args, name, in_file='new.bin'):
+    subprocess.check_call([sys.executable, GEN_CUSTOM_OTA, '-i', in_file] + args,
+                          cwd=directory, stdout=subprocess.DEVNULL)
+    shutil.move(os.path.join(directory, 'custom_ota_binaries', name), os.path.join(directory, name))
+    shutil.rmtree(os.path.join(directory, 'custom_ota_binaries'))
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('-d', '--directory', default='.', help='where the images go [default: .]')
+    parser.add_argument('-s', '--size', type=int, default=1024 * 1024, help='firmware size [default: 1 MB]')
+    parser.add_argument('-m', '--model_size', type=int, default=256 * 1024, help='model size [default: 256 KB]')
+    parser.add_argument('--no_firmware', action='store_true', help='only pack the images found in the directory')
+    args = parser.parse_args()
+
+    os.makedirs(args.directory, exist_ok=True)
+
+    if not args.no_firmware:
+        base, model = firmware(1, args.size, args.model_size)
+        new = bytearray(base)
+        rng = random.Random(2)
+
+        # a handful of functions changed, the code after them moved a little
+        for _ in range(8):
+            offset = rng.randrange(64, len(new) - 4096)
+            new[offset:offset + rng.randrange(256, 2048)] = code(rng, rng.randrange(256, 2048))
+
+        with open(os.path.join(args.directory, 'base.bin'), 'wb') as f:
+            f.write(base + model)
+        with open(os.path.join(args.directory, 'new.bin'), 'wb') as f:
+            f.write(new + random.Random(3).randbytes(args.model_size))
+
+        # the weights at the end change, the flatbuffer header and the first layers stay
+        new_model = bytearray(model)
+        retrained = len(new_model) // 8
+        new_model[-retrained:] = random.Random(4).randbytes(retrained)
+        with open(os.path.join(args.directory, 'model.bin'), 'wb') as f:
+            f.write(model)
+        with open(os.path.join(args.directory, 'new_model.bin'), 'wb') as f:
+            f.write(new_model)
+
+    pack(args.directory, ['-c', 'xz'], 'new.bin.xz.packed')
+    pack(args.directory, ['-c', 'xz', '-b', 'base.bin'], 'new.bin.delta.xz.packed')
+    pack(args.directory, ['-c', 'xz', '-b', 'model.bin'], 'new_model.bin.delta.xz.packed', 'new_model.bin')
+
+    for name in ['base.bin', 'new.bin', 'new.bin.xz.packed', 'new.bin.delta.xz.packed',
+                 'model.bin', 'new_model.bin', 'new_model.bin.delta.xz.packed']:
+        print('{:<32}{:>9} B'.format(name, os.path.getsize(os.path.join(args.directory, name))))
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,3 @@
+// Host build stand-in for the mbed TLS header, see espnow_sec_bench.c
+// espnow_security.c only uses AES through CCM
+#pragma once
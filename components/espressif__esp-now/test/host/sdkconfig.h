@@ -0,0 +1,23 @@
+// Host build stand-in for the generated header, see espnow_sim.c
+#pragma once
+
+#define CONFIG_IDF_TARGET_ESP32                     1
+#define CONFIG_ESP32_WIFI_DYNAMIC_TX_BUFFER_NUM     32
+#define CONFIG_ESPNOW_VERSION                       2
+#ifndef CONFIG_ESPNOW_MSG_CACHE_SIZE                 /* -D on the command line to compare sizes */
+#define CONFIG_ESPNOW_MSG_CACHE_SIZE                0
+#endif
+#ifndef CONFIG_ESPNOW_MSG_CACHE_RATE
+#define CONFIG_ESPNOW_MSG_CACHE_RATE                500
+#endif
+#ifndef CONFIG_ESPNOW_MSG_CACHE_TIMEOUT
+#define CONFIG_ESPNOW_MSG_CACHE_TIMEOUT             3000
+#endif
+#define CONFIG_ESPNOW_OTA_RETRANSMISSION_TIMES      2
+#define CONFIG_ESPNOW_MSG_REASSEMBLY_NUM            2
+#define CONFIG_ESPNOW_MSG_REASSEMBLY_TIMEOUT        1000
+
+// set from idf_component.yml by cu_pkg_define_version() in the IDF build
+#define ESP_NOW_VER_MAJOR                           2
+#define ESP_NOW_VER_MINOR                           5
+#define ESP_NOW_VER_PATCH                           2
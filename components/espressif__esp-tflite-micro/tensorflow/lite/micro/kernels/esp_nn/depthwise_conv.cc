@@ -15,6 +15,8 @@ limitations under the License.
 
 #include "tensorflow/lite/micro/kernels/depthwise_conv.h"
 
+#include <algorithm>
+
 #include "tensorflow/lite/c/builtin_op_data.h"
 #include "tensorflow/lite/kernels/internal/portable_tensor_utils.h"
 #include "tensorflow/lite/kernels/internal/reference/depthwiseconv_float.h"
@@ -28,6 +30,7 @@ limitations under the License.
 
 #if ESP_NN
 #include <esp_nn.h>
+#include "tensorflow/lite/micro/kernels/esp_nn_tune.h"
 #endif
 
 long long dc_total_time = 0;
@@ -39,6 +42,10 @@ struct NodeData {
   OpDataConv op_data;
 #if ESP_NN
   int buffer_idx;
+  uint32_t tune_key;
+  esp_nn_variant_t variant;
+  bool tune_pending;  // time all eligible variants on the first Eval
+  const void* packed_filter;  // filter in the variant's layout, or nullptr
 #endif
 };
 
@@ -51,7 +58,7 @@ void* Init(TfLiteContext* context, const char* buffer,
 #if ESP_NN
 inline void EvalQuantizedPerChannel(TfLiteContext* context, TfLiteNode* node,
                                     const TfLiteDepthwiseConvParams& params,
-                                    const NodeData& data,
+                                    NodeData& data,
                                     const TfLiteEvalTensor* input,
                                     const TfLiteEvalTensor* filter,
                                     const TfLiteEvalTensor* bias,
@@ -133,12 +140,42 @@ inline void EvalQuantizedPerChannel(TfLiteContext* context, TfLiteNode* node,
                                 .mult = data.op_data.per_channel_output_multiplier
                               };
 
+    const int8_t *filter_data = tflite::micro::GetTensorData<int8_t>(filter);
+    const int32_t *bias_data = tflite::micro::GetTensorData<int32_t>(bias);
+
+    if (data.packed_filter) {
+      for (int i_batch = 0; i_batch < batch_size; i_batch++) {
+        esp_nn_depthwise_conv_s8_packed(data.variant, &input_dims,
+                                        input_data + i_batch * input_size,
+                                        &filter_dims, data.packed_filter, bias_data,
+                                        &output_dims, output_data + i_batch * output_size,
+                                        &conv_params, &quant_data);
+      }
+      return;
+    }
+
+    if (data.tune_pending) {
+      esp_nn_variant_t variants[ESP_NN_MAX_VARIANTS];
+      const int num_variants = esp_nn_depthwise_conv_s8_variants(
+          &input_dims, &filter_dims, &output_dims, &conv_params, variants,
+          ESP_NN_MAX_VARIANTS);
+      data.variant = EspNnTuneSelect(
+          variants, num_variants, [&](esp_nn_variant_t variant) {
+            esp_nn_depthwise_conv_s8_variant(variant, &input_dims, input_data,
+                                             &filter_dims, filter_data, bias_data,
+                                             &output_dims, output_data,
+                                             &conv_params, &quant_data);
+          });
+      data.tune_pending = false;
+      EspNnTuneRecord(data.tune_key, data.variant);
+    }
+
     for (int i_batch = 0; i_batch < batch_size; i_batch++) {
-      esp_nn_depthwise_conv_s8(&input_dims, input_data + i_batch * input_size,
-                               &filter_dims, tflite::micro::GetTensorData<int8_t>(filter),
-                               tflite::micro::GetTensorData<int32_t>(bias),
-                               &output_dims, output_data + i_batch * output_size,
-                               &conv_params, &quant_data);
+      esp_nn_depthwise_conv_s8_variant(data.variant, &input_dims,
+                                       input_data + i_batch * input_size,
+                                       &filter_dims, filter_data, bias_data,
+                                       &output_dims, output_data + i_batch * output_size,
+                                       &conv_params, &quant_data);
     }
   } else {
     reference_integer_ops::DepthwiseConvPerChannel(
@@ -155,6 +192,81 @@ inline void EvalQuantizedPerChannel(TfLiteContext* context, TfLiteNode* node,
         tflite::micro::GetTensorData<int8_t>(output));
   }
 }
+
+// 16x8 depthwise convolution, int16 zero points are 0.
+inline void EvalQuantizedPerChannel16x8(const TfLiteDepthwiseConvParams& params,
+                                        const NodeData& data,
+                                        const TfLiteEvalTensor* input,
+                                        const TfLiteEvalTensor* filter,
+                                        const TfLiteEvalTensor* bias,
+                                        TfLiteEvalTensor* output) {
+  if (params.dilation_width_factor == 1 && params.dilation_height_factor == 1) {
+    RuntimeShape input_shape = tflite::micro::GetTensorShape(input);
+    RuntimeShape filter_shape = tflite::micro::GetTensorShape(filter);
+    RuntimeShape output_shape = tflite::micro::GetTensorShape(output);
+
+    const int16_t *input_data = tflite::micro::GetTensorData<int16_t>(input);
+    int16_t *output_data = tflite::micro::GetTensorData<int16_t>(output);
+
+    const int input_height = input_shape.Dims(1);
+    const int input_width = input_shape.Dims(2);
+    const int input_depth = input_shape.Dims(3);
+    const int filter_height = filter_shape.Dims(1);
+    const int filter_width = filter_shape.Dims(2);
+    const int output_height = output_shape.Dims(1);
+    const int output_width = output_shape.Dims(2);
+    const int batch_size = MatchingDim(input_shape, 0, output_shape, 0);
+    const int output_depth = MatchingDim(filter_shape, 3, output_shape, 3);
+
+    const int input_size = input_width * input_height * input_depth;
+    const int output_size = output_width * output_height * output_depth;
+
+    data_dims_t input_dims =  {
+                                .width = input_width, .height = input_height,
+                                .channels = input_depth, 1
+                              };
+    data_dims_t output_dims = {
+                                .width = output_width, .height = output_height,
+                                .channels = output_depth, 1
+                              };
+    data_dims_t filter_dims = {.width = filter_width, .height = filter_height, 0, 0};
+    dw_conv_params_t conv_params =  {
+                                      .in_offset = 0, .out_offset = 0,
+                                      .ch_mult = params.depth_multiplier,
+                                      .stride = {params.stride_width, params.stride_height},
+                                      .padding = {data.op_data.padding.width,
+                                                  data.op_data.padding.height},
+                                      .dilation = {0, 0},
+                                      .activation = {data.op_data.output_activation_min,
+                                                     data.op_data.output_activation_max}
+                                    };
+    quant_data_t quant_data = {
+                                .shift = data.op_data.per_channel_output_shift,
+                                .mult = data.op_data.per_channel_output_multiplier
+                              };
+
+    for (int i_batch = 0; i_batch < batch_size; i_batch++) {
+      esp_nn_depthwise_conv_s16(&input_dims, input_data + i_batch * input_size,
+                                &filter_dims, tflite::micro::GetTensorData<int8_t>(filter),
+                                tflite::micro::GetOptionalTensorData<int64_t>(bias),
+                                &output_dims, output_data + i_batch * output_size,
+                                &conv_params, &quant_data);
+    }
+  } else {
+    reference_integer_ops::DepthwiseConvPerChannel(
+        DepthwiseConvParamsQuantized(params, data.op_data),
+        data.op_data.per_channel_output_multiplier,
+        data.op_data.per_channel_output_shift,
+        tflite::micro::GetTensorShape(input),
+        tflite::micro::GetTensorData<int16_t>(input),
+        tflite::micro::GetTensorShape(filter),
+        tflite::micro::GetTensorData<int8_t>(filter),
+        tflite::micro::GetTensorShape(bias),
+        tflite::micro::GetOptionalTensorData<int64_t>(bias),
+        tflite::micro::GetTensorShape(output),
+        tflite::micro::GetTensorData<int16_t>(output));
+  }
+}
 #endif
 
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
@@ -269,8 +381,75 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
                                       .dilation = {0, 0}, .activation = {-128, 127}
                                     };
 
-    int scratch_buf_size = esp_nn_get_depthwise_conv_scratch_size(
-        &input_dims, &filter_dims, &output_dims, &conv_params);
+    data->tune_key = EspNnTuneKey(
+        kEspNnTuneDepthwiseConv, input_width, input_height, num_input_channels,
+        output_width, output_height, output_dims.channels, filter_width,
+        filter_height, params.stride_width, params.stride_height,
+        data->op_data.padding.width, data->op_data.padding.height,
+        params.depth_multiplier);
+    int tuned_variant = EspNnTuneLookup(data->tune_key);
+    if (tuned_variant >= 0) {
+      // A table stored by another build may name a variant that this esp-nn
+      // does not have or that is not eligible for the layer.
+      esp_nn_variant_t variants[ESP_NN_MAX_VARIANTS];
+      const int num_variants = esp_nn_depthwise_conv_s8_variants(
+          &input_dims, &filter_dims, &output_dims, &conv_params, variants,
+          ESP_NN_MAX_VARIANTS);
+      if (std::find(variants, variants + num_variants, tuned_variant) ==
+          variants + num_variants) {
+        MicroPrintf("esp-nn variant %d is not eligible for layer %08x, ignored",
+                    tuned_variant, static_cast<unsigned>(data->tune_key));
+        tuned_variant = -1;
+      }
+    }
+    data->variant = tuned_variant < 0 ? ESP_NN_VARIANT_DEFAULT
+                                      : static_cast<esp_nn_variant_t>(tuned_variant);
+    data->tune_pending = tuned_variant < 0 && EspNnTuneEnabled();
+
+    data->packed_filter = nullptr;
+#if CONFIG_NN_PREPACK_WEIGHTS
+    // Weights are constant: align (or widen to s16) them once for the
+    // kernel. Tuning layers don't know their variant yet.
+    if (filter->type == kTfLiteInt8 && !data->tune_pending) {
+      const int8_t* filter_data = GetTensorData<int8_t>(filter);
+      const int packed_size = esp_nn_get_depthwise_conv_packed_filter_size(
+          data->variant, &input_dims, &filter_dims, &output_dims, &conv_params);
+      if (packed_size == NumElements(filter) &&
+          (reinterpret_cast<uintptr_t>(filter_data) & 15) == 0) {
+        // Already aligned and not widened: the flatbuffer is the layout.
+        data->packed_filter = filter_data;
+      } else if (packed_size > 0) {
+        void* packed_filter =
+            context->AllocatePersistentBuffer(context, packed_size);
+        TF_LITE_ENSURE(context, packed_filter != nullptr);
+        esp_nn_depthwise_conv_pack_filter(data->variant, &input_dims, &filter_dims,
+                                          &output_dims, &conv_params, filter_data,
+                                          packed_filter);
+        data->packed_filter = packed_filter;
+      }
+    }
+#endif
+
+    int scratch_buf_size = 0;
+    if (data->tune_pending) {
+      // Room for whichever variant wins
+      esp_nn_variant_t variants[ESP_NN_MAX_VARIANTS];
+      const int num_variants = esp_nn_depthwise_conv_s8_variants(
+          &input_dims, &filter_dims, &output_dims, &conv_params, variants,
+          ESP_NN_MAX_VARIANTS);
+      for (int i = 0; i < num_variants; i++) {
+        scratch_buf_size = std::max(
+            scratch_buf_size,
+            esp_nn_get_depthwise_conv_scratch_size_variant(
+                variants[i], &input_dims, &filter_dims, &output_dims, &conv_params));
+      }
+    } else if (data->packed_filter != nullptr) {
+      scratch_buf_size = esp_nn_get_depthwise_conv_packed_scratch_size(
+          data->variant, &input_dims, &filter_dims, &output_dims, &conv_params);
+    } else {
+      scratch_buf_size = esp_nn_get_depthwise_conv_scratch_size_variant(
+          data->variant, &input_dims, &filter_dims, &output_dims, &conv_params);
+    }
     if (scratch_buf_size > 0) {
       TF_LITE_ENSURE_STATUS(context->RequestScratchBufferInArena(
         context, scratch_buf_size, &data->buffer_idx));
@@ -293,7 +472,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
 
   auto& params =
       *(reinterpret_cast<TfLiteDepthwiseConvParams*>(node->builtin_data));
-  const NodeData& data = *(static_cast<const NodeData*>(node->user_data));
+  NodeData& data = *(static_cast<NodeData*>(node->user_data));
 
   TfLiteEvalTensor* output =
       tflite::micro::GetEvalOutput(context, node, kDepthwiseConvOutputTensor);
@@ -374,6 +553,9 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
     case kTfLiteInt16: {
       switch (filter->type) {
         case kTfLiteInt8: {
+#if ESP_NN
+          EvalQuantizedPerChannel16x8(params, data, input, filter, bias, output);
+#else
           reference_integer_ops::DepthwiseConvPerChannel(
               DepthwiseConvParamsQuantized(params, data.op_data),
               data.op_data.per_channel_output_multiplier,
@@ -386,6 +568,7 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
               tflite::micro::GetOptionalTensorData<int64_t>(bias),
               tflite::micro::GetTensorShape(output),
               tflite::micro::GetTensorData<int16_t>(output));
+#endif
           break;
         }
         default:
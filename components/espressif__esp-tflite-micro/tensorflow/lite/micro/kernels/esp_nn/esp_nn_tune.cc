@@ -0,0 +1,115 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/kernels/esp_nn_tune.h"
+
+#include <cstring>
+
+#include "tensorflow/lite/micro/micro_log.h"
+
+namespace tflite {
+namespace {
+
+bool tune_enabled = false;
+EspNnTuneEntry tune_table[kEspNnTuneMaxEntries];
+int tune_table_count = 0;
+
+inline uint32_t Fnv1a(uint32_t hash, int value) {
+  const uint32_t v = static_cast<uint32_t>(value);
+  for (int i = 0; i < 4; i++) {
+    hash ^= (v >> (8 * i)) & 0xff;
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+}  // namespace
+
+uint32_t EspNnTuneKey(EspNnTuneOp op, int input_width, int input_height,
+                      int input_channels, int output_width, int output_height,
+                      int output_channels, int filter_width, int filter_height,
+                      int stride_width, int stride_height, int pad_width,
+                      int pad_height, int ch_mult) {
+  const int fields[] = {op,
+                        input_width,  input_height,  input_channels,
+                        output_width, output_height, output_channels,
+                        filter_width, filter_height,
+                        stride_width, stride_height,
+                        pad_width,    pad_height,
+                        ch_mult};
+  uint32_t hash = 2166136261u;
+  for (int field : fields) {
+    hash = Fnv1a(hash, field);
+  }
+  return hash;
+}
+
+void EspNnTuneSetEnabled(bool enabled) { tune_enabled = enabled; }
+
+bool EspNnTuneEnabled() { return tune_enabled; }
+
+int EspNnTuneLookup(uint32_t key) {
+  for (int i = 0; i < tune_table_count; i++) {
+    if (tune_table[i].key == key) {
+      return tune_table[i].variant;
+    }
+  }
+  return -1;
+}
+
+void EspNnTuneRecord(uint32_t key, int variant) {
+  for (int i = 0; i < tune_table_count; i++) {
+    if (tune_table[i].key == key) {
+      tune_table[i].variant = static_cast<uint8_t>(variant);
+      return;
+    }
+  }
+  if (tune_table_count == kEspNnTuneMaxEntries) {
+    MicroPrintf("esp-nn tune table full, layer %08x not recorded",
+                static_cast<unsigned>(key));
+    return;
+  }
+  EspNnTuneEntry& entry = tune_table[tune_table_count++];
+  memset(&entry, 0, sizeof(entry));
+  entry.key = key;
+  entry.variant = static_cast<uint8_t>(variant);
+}
+
+bool EspNnTuneLoadTable(const EspNnTuneEntry* entries, int count) {
+  if (count < 0 || count > kEspNnTuneMaxEntries) {
+    return false;
+  }
+  memcpy(tune_table, entries, count * sizeof(EspNnTuneEntry));
+  tune_table_count = count;
+  return true;
+}
+
+const EspNnTuneEntry* EspNnTuneGetTable(int* count) {
+  *count = tune_table_count;
+  return tune_table;
+}
+
+void EspNnTuneResetTable() { tune_table_count = 0; }
+
+void EspNnTunePrintTable() {
+  MicroPrintf("const tflite::EspNnTuneEntry esp_nn_tune_table[] = {");
+  for (int i = 0; i < tune_table_count; i++) {
+    MicroPrintf("    {0x%08x, %d},", static_cast<unsigned>(tune_table[i].key),
+                tune_table[i].variant);
+  }
+  MicroPrintf("};");
+}
+
+}  // namespace tflite
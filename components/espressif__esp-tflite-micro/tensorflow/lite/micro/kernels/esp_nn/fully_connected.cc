@@ -34,11 +34,17 @@ long long fc_total_time = 0;
 namespace tflite {
 namespace {
 
+struct NodeData {
+  OpDataFullyConnected op_data;
+#if ESP_NN
+  int32_t* folded_bias;  // bias with the input offset folded in, or nullptr
+#endif
+};
+
 void* FullyConnectedInit(TfLiteContext* context, const char* buffer,
                          size_t length) {
   TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
-  return context->AllocatePersistentBuffer(context,
-                                           sizeof(OpDataFullyConnected));
+  return context->AllocatePersistentBuffer(context, sizeof(NodeData));
 }
 
 TfLiteStatus FullyConnectedPrepare(TfLiteContext* context, TfLiteNode* node) {
@@ -47,7 +53,8 @@ TfLiteStatus FullyConnectedPrepare(TfLiteContext* context, TfLiteNode* node) {
   TFLITE_DCHECK(node->user_data != nullptr);
   TFLITE_DCHECK(node->builtin_data != nullptr);
 
-  auto* data = static_cast<OpDataFullyConnected*>(node->user_data);
+  auto* node_data = static_cast<NodeData*>(node->user_data);
+  auto* data = &node_data->op_data;
   const auto params =
       static_cast<const TfLiteFullyConnectedParams*>(node->builtin_data);
 
@@ -87,6 +94,28 @@ TfLiteStatus FullyConnectedPrepare(TfLiteContext* context, TfLiteNode* node) {
                                  context, params->activation, input->type,
                                  input, filter, bias, output, data));
 
+#if ESP_NN
+  node_data->folded_bias = nullptr;
+#if CONFIG_NN_PREPACK_WEIGHTS
+  // Constant weights and no padding: the input offset term is fixed per
+  // output channel and can be added to the bias once.
+  if (input->type == kTfLiteInt8 && filter->type == kTfLiteInt8 &&
+      data->filter_zero_point == 0 && data->input_zero_point != 0) {
+    const int filter_dim_count = filter->dims->size;
+    const int output_depth = filter->dims->data[filter_dim_count - 2];
+    const int accum_depth = filter->dims->data[filter_dim_count - 1];
+    node_data->folded_bias = static_cast<int32_t*>(
+        context->AllocatePersistentBuffer(context, output_depth * sizeof(int32_t)));
+    TF_LITE_ENSURE(context, node_data->folded_bias != nullptr);
+    esp_nn_fold_input_offset_s8(
+        GetTensorData<int8_t>(filter),
+        bias != nullptr ? GetTensorData<int32_t>(bias) : nullptr,
+        -data->input_zero_point, accum_depth, output_depth,
+        node_data->folded_bias);
+  }
+#endif
+#endif
+
   micro_context->DeallocateTempTfLiteTensor(input);
   micro_context->DeallocateTempTfLiteTensor(filter);
   if (bias != nullptr) {
@@ -112,8 +141,8 @@ TfLiteStatus FullyConnectedEval(TfLiteContext* context, TfLiteNode* node) {
 
   TFLITE_DCHECK(node->user_data != nullptr);
 
-  const auto& data =
-      *(static_cast<const OpDataFullyConnected*>(node->user_data));
+  const auto& node_data = *(static_cast<const NodeData*>(node->user_data));
+  const auto& data = node_data.op_data;
 
   long long start_time = esp_timer_get_time();
   // Checks in Prepare ensure input, output and filter types are all the same.
@@ -166,14 +195,18 @@ TfLiteStatus FullyConnectedEval(TfLiteContext* context, TfLiteNode* node) {
           const int accum_depth = filter_shape.Dims(filter_dim_count - 1);
 
           const int32_t* bias_data =
-              tflite::micro::GetOptionalTensorData<int32_t>(bias);
+              node_data.folded_bias
+                  ? node_data.folded_bias
+                  : tflite::micro::GetOptionalTensorData<int32_t>(bias);
+          const int32_t input_offset =
+              node_data.folded_bias ? 0 : -data.input_zero_point;
 
           const int8_t *input_data = tflite::micro::GetTensorData<int8_t>(input);
           int8_t *output_data = tflite::micro::GetTensorData<int8_t>(output);
           const int8_t *filter_data = tflite::micro::GetTensorData<int8_t>(filter);
 
           for (int b = 0; b < batches; ++b) {
-            esp_nn_fully_connected_s8(input_data, -data.input_zero_point,
+            esp_nn_fully_connected_s8(input_data, input_offset,
                                       accum_depth,
                                       filter_data, -data.filter_zero_point,
                                       bias_data, output_data, output_depth,
@@ -210,6 +243,36 @@ TfLiteStatus FullyConnectedEval(TfLiteContext* context, TfLiteNode* node) {
     case kTfLiteInt16: {
       switch (filter->type) {
         case kTfLiteInt8: {
+#if ESP_NN
+          if (data.input_zero_point == 0 && data.filter_zero_point == 0 &&
+              data.output_zero_point == 0) {
+            const RuntimeShape& filter_shape = tflite::micro::GetTensorShape(filter);
+            const RuntimeShape& output_shape = tflite::micro::GetTensorShape(output);
+
+            const int filter_dim_count = filter_shape.DimensionsCount();
+            const int batches = output_shape.Dims(0);
+            const int output_depth = output_shape.Dims(1);
+            const int accum_depth = filter_shape.Dims(filter_dim_count - 1);
+
+            const int64_t* bias_data =
+                tflite::micro::GetOptionalTensorData<int64_t>(bias);
+
+            const int16_t *input_data = tflite::micro::GetTensorData<int16_t>(input);
+            int16_t *output_data = tflite::micro::GetTensorData<int16_t>(output);
+            const int8_t *filter_data = tflite::micro::GetTensorData<int8_t>(filter);
+
+            for (int b = 0; b < batches; ++b) {
+              esp_nn_fully_connected_s16(input_data, accum_depth, filter_data,
+                                         bias_data, output_data, output_depth,
+                                         data.output_shift, data.output_multiplier,
+                                         data.output_activation_min,
+                                         data.output_activation_max);
+              input_data += accum_depth;
+              output_data += output_depth;
+            }
+            break;
+          }
+#endif
           tflite::reference_integer_ops::FullyConnected(
               FullyConnectedParamsQuantized(data),
               tflite::micro::GetTensorShape(input),
@@ -0,0 +1,124 @@
+/* Copyright 2021 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/kernels/internal/reference/hard_swish.h"
+
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/internal/quantization_util.h"
+#include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
+#include "tensorflow/lite/kernels/internal/types.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/kernels/op_macros.h"
+#include "tensorflow/lite/micro/kernels/hard_swish.h"
+#include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/micro_log.h"
+#include "tensorflow/lite/micro/micro_utils.h"
+
+#if ESP_NN
+#include <esp_nn.h>
+#endif
+
+namespace tflite {
+namespace {
+
+// HardSwishPrepare() fills `params` through node->user_data, so it has to stay
+// the first member.
+struct NodeData {
+  HardSwishParams params;
+#if ESP_NN
+  // int8 -> int8 table indexed by the uint8_t bit pattern of the input.
+  int8_t lut[256];
+#endif
+};
+
+void* HardSwishInit(TfLiteContext* context, const char* buffer, size_t length) {
+  TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
+  return context->AllocatePersistentBuffer(context, sizeof(NodeData));
+}
+
+TfLiteStatus HardSwishPrepareEsp(TfLiteContext* context, TfLiteNode* node) {
+  TF_LITE_ENSURE_OK(context, HardSwishPrepare(context, node));
+
+#if ESP_NN
+  NodeData* data = static_cast<NodeData*>(node->user_data);
+  MicroContext* micro_context = GetMicroContext(context);
+  TfLiteTensor* input =
+      micro_context->AllocateTempInputTensor(node, kHardSwishInputTensor);
+  TF_LITE_ENSURE(context, input != nullptr);
+
+  if (input->type == kTfLiteInt8) {
+    // Run the reference kernel once over every possible input value so the
+    // table is bit-exact with it by construction.
+    int8_t lut_input[256];
+    for (int i = 0; i < 256; ++i) {
+      lut_input[i] = static_cast<int8_t>(i);
+    }
+    const RuntimeShape lut_shape({256});
+    tflite::reference_ops::HardSwish<int8_t>(data->params, lut_shape,
+                                             lut_input, lut_shape, data->lut);
+  }
+  micro_context->DeallocateTempTfLiteTensor(input);
+#endif
+  return kTfLiteOk;
+}
+
+TfLiteStatus HardSwishEval(TfLiteContext* context, TfLiteNode* node) {
+  const TfLiteEvalTensor* input =
+      tflite::micro::GetEvalInput(context, node, kHardSwishInputTensor);
+  TfLiteEvalTensor* output =
+      tflite::micro::GetEvalOutput(context, node, kHardSwishOutputTensor);
+  NodeData* data = static_cast<NodeData*>(node->user_data);
+
+  switch (input->type) {
+    case kTfLiteFloat32: {
+      tflite::reference_ops::HardSwish<float>(
+          tflite::micro::GetTensorShape(input),
+          tflite::micro::GetTensorData<float>(input),
+          tflite::micro::GetTensorShape(output),
+          tflite::micro::GetTensorData<float>(output));
+    } break;
+    case kTfLiteInt8: {
+#if ESP_NN
+      const int size = MatchingFlatSize(tflite::micro::GetTensorShape(input),
+                                        tflite::micro::GetTensorShape(output));
+      esp_nn_lut_s8(tflite::micro::GetTensorData<int8_t>(input),
+                    tflite::micro::GetTensorData<int8_t>(output), data->lut,
+                    size);
+#else
+      tflite::reference_ops::HardSwish<int8_t>(
+          data->params, tflite::micro::GetTensorShape(input),
+          tflite::micro::GetTensorData<int8_t>(input),
+          tflite::micro::GetTensorShape(output),
+          tflite::micro::GetTensorData<int8_t>(output));
+#endif
+    } break;
+    default: {
+      MicroPrintf("Unsupported type %s", TfLiteTypeGetName(input->type));
+      return kTfLiteError;
+    }
+  }
+  return kTfLiteOk;
+}
+
+}  // namespace
+
+TFLMRegistration Register_HARD_SWISH() {
+  return tflite::micro::RegisterOp(HardSwishInit, HardSwishPrepareEsp,
+                                   HardSwishEval);
+}
+
+}  // namespace tflite
@@ -39,9 +39,47 @@ long long logistic_total_time = 0;
 namespace tflite {
 namespace {
 
+struct NodeData {
+  OpDataLogistic op_data;
+#if ESP_NN
+  // int8 -> int8 table indexed by the uint8_t bit pattern of the input.
+  int8_t lut[256];
+#endif
+};
+
 void* LogisticInit(TfLiteContext* context, const char* buffer, size_t length) {
   TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
-  return context->AllocatePersistentBuffer(context, sizeof(OpDataLogistic));
+  return context->AllocatePersistentBuffer(context, sizeof(NodeData));
+}
+
+TfLiteStatus LogisticPrepareEsp(TfLiteContext* context, TfLiteNode* node) {
+  TFLITE_DCHECK(node->user_data != nullptr);
+  NodeData* data = static_cast<NodeData*>(node->user_data);
+
+  TF_LITE_ENSURE_OK(context, CalculateArithmeticOpDataLogistic(
+                                 context, node, &data->op_data));
+
+#if ESP_NN
+  MicroContext* micro_context = GetMicroContext(context);
+  TfLiteTensor* input =
+      micro_context->AllocateTempInputTensor(node, kLogisticInputTensor);
+  TF_LITE_ENSURE(context, input != nullptr);
+
+  if (input->type == kTfLiteInt8) {
+    // Run the reference kernel once over every possible input value so the
+    // table is bit-exact with it by construction.
+    int8_t lut_input[256];
+    for (int i = 0; i < 256; ++i) {
+      lut_input[i] = static_cast<int8_t>(i);
+    }
+    reference_integer_ops::Logistic(
+        data->op_data.input_zero_point, data->op_data.input_range_radius,
+        data->op_data.input_multiplier, data->op_data.input_left_shift, 256,
+        lut_input, data->lut);
+  }
+  micro_context->DeallocateTempTfLiteTensor(input);
+#endif
+  return kTfLiteOk;
 }
 
 TfLiteStatus LogisticEval(TfLiteContext* context, TfLiteNode* node) {
@@ -50,9 +88,10 @@ TfLiteStatus LogisticEval(TfLiteContext* context, TfLiteNode* node) {
   TfLiteEvalTensor* output =
       tflite::micro::GetEvalOutput(context, node, kLogisticOutputTensor);
 
-    long long start_time = esp_timer_get_time();
+  long long start_time = esp_timer_get_time();
   TFLITE_DCHECK(node->user_data != nullptr);
-  OpDataLogistic* data = static_cast<OpDataLogistic*>(node->user_data);
+  NodeData* node_data = static_cast<NodeData*>(node->user_data);
+  OpDataLogistic* data = &node_data->op_data;
 
   if (input->type == kTfLiteFloat32) {
     switch (output->type) {
@@ -61,6 +100,7 @@ TfLiteStatus LogisticEval(TfLiteContext* context, TfLiteNode* node) {
                                 tflite::micro::GetTensorData<float>(input),
                                 tflite::micro::GetTensorShape(output),
                                 tflite::micro::GetTensorData<float>(output));
+        logistic_total_time += esp_timer_get_time() - start_time;
         return kTfLiteOk;
       }
       default:
@@ -77,6 +117,7 @@ TfLiteStatus LogisticEval(TfLiteContext* context, TfLiteNode* node) {
             NumElements(input->dims),
             tflite::micro::GetTensorData<int16_t>(input),
             tflite::micro::GetTensorData<int16_t>(output));
+        logistic_total_time += esp_timer_get_time() - start_time;
         return kTfLiteOk;
       }
       default:
@@ -88,12 +129,19 @@ TfLiteStatus LogisticEval(TfLiteContext* context, TfLiteNode* node) {
   } else if (input->type == kTfLiteInt8) {
     switch (output->type) {
       case kTfLiteInt8: {
+#if ESP_NN
+        esp_nn_lut_s8(tflite::micro::GetTensorData<int8_t>(input),
+                      tflite::micro::GetTensorData<int8_t>(output),
+                      node_data->lut, NumElements(input->dims));
+#else
         reference_integer_ops::Logistic(
             data->input_zero_point, data->input_range_radius,
             data->input_multiplier, data->input_left_shift,
             NumElements(input->dims),
             tflite::micro::GetTensorData<int8_t>(input),
             tflite::micro::GetTensorData<int8_t>(output));
+#endif
+        logistic_total_time += esp_timer_get_time() - start_time;
         return kTfLiteOk;
       }
       default:
@@ -110,13 +158,12 @@ TfLiteStatus LogisticEval(TfLiteContext* context, TfLiteNode* node) {
                 TfLiteTypeGetName(output->type));
     return kTfLiteError;
   }
-  logistic_total_time += esp_timer_get_time() - start_time;
   return kTfLiteOk;
 }
 
 }  // namespace
 
 TFLMRegistration Register_LOGISTIC() {
-  return tflite::micro::RegisterOp(LogisticInit, LogisticPrepare, LogisticEval);
+  return tflite::micro::RegisterOp(LogisticInit, LogisticPrepareEsp, LogisticEval);
 }
 }  // namespace tflite
@@ -76,6 +76,32 @@ void MulEvalQuantized(TfLiteContext* context, TfLiteNode* node,
                                                     tflite::micro::GetTensorShape(output)));
   }
 }
+
+// int16 zero points are 0 (checked in prepare), broadcasts stay on the
+// reference path.
+void MulEvalQuantized16(TfLiteContext* context, TfLiteNode* node,
+                        const OpDataMul* data, const TfLiteEvalTensor* input1,
+                        const TfLiteEvalTensor* input2,
+                        TfLiteEvalTensor* output) {
+  tflite::ArithmeticParams op_params = {};
+  bool need_broadcast = reference_ops::ProcessBroadcastShapes(
+      tflite::micro::GetTensorShape(input1),
+      tflite::micro::GetTensorShape(input2), &op_params);
+
+  if (need_broadcast) {
+    EvalMulQuantizedReference(context, node, data, input1, input2, output);
+    return;
+  }
+
+  esp_nn_mul_elementwise_s16(tflite::micro::GetTensorData<int16_t>(input1),
+                             tflite::micro::GetTensorData<int16_t>(input2),
+                             0, 0, tflite::micro::GetTensorData<int16_t>(output), 0,
+                             data->output_multiplier, data->output_shift,
+                             data->output_activation_min, data->output_activation_max,
+                             MatchingElementsSize(tflite::micro::GetTensorShape(input1),
+                                                  tflite::micro::GetTensorShape(input2),
+                                                  tflite::micro::GetTensorShape(output)));
+}
 #endif
 
 TfLiteStatus MulEval(TfLiteContext* context, TfLiteNode* node) {
@@ -102,6 +128,12 @@ TfLiteStatus MulEval(TfLiteContext* context, TfLiteNode* node) {
 #endif
       break;
     case kTfLiteInt16:
+#if ESP_NN
+      MulEvalQuantized16(context, node, data, input1, input2, output);
+#else
+      EvalMulQuantizedReference(context, node, data, input1, input2, output);
+#endif
+      break;
     case kTfLiteInt32:
       EvalMulQuantizedReference(context, node, data, input1, input2, output);
       break;
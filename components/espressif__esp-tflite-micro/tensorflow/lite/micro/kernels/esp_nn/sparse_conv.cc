@@ -0,0 +1,311 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "flatbuffers/flexbuffers.h"
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/internal/quantization_util.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/kernels/padding.h"
+#include "tensorflow/lite/micro/kernels/esp_sparse.h"
+#include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/micro_log.h"
+
+#if ESP_NN
+#include <esp_nn.h>
+#endif
+
+namespace tflite {
+namespace {
+
+constexpr int kInputTensor = 0;
+constexpr int kValuesTensor = 1;
+constexpr int kRowPtrTensor = 2;
+constexpr int kColIdxTensor = 3;
+constexpr int kBiasTensor = 4;
+constexpr int kOutputTensor = 0;
+
+struct OpData {
+  int block_len;
+  int filter_height;
+  int filter_width;
+  int stride_height;
+  int stride_width;
+  TfLitePadding padding_type;
+  TfLiteFusedActivation activation;
+  TfLitePaddingValues padding;
+  int32_t* per_channel_output_multiplier;
+  int32_t* per_channel_output_shift;
+  int32_t input_zero_point;
+  int32_t output_zero_point;
+  int32_t output_activation_min;
+  int32_t output_activation_max;
+};
+
+void* SparseConvInit(TfLiteContext* context, const char* buffer,
+                     size_t length) {
+  TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
+  OpData* data = static_cast<OpData*>(
+      context->AllocatePersistentBuffer(context, sizeof(OpData)));
+
+  const uint8_t* buffer_t = reinterpret_cast<const uint8_t*>(buffer);
+  const flexbuffers::Map& m = flexbuffers::GetRoot(buffer_t, length).AsMap();
+  data->block_len = m["block_len"].AsInt32();
+  data->filter_height = m["filter_height"].AsInt32();
+  data->filter_width = m["filter_width"].AsInt32();
+  data->stride_height = m["stride_height"].AsInt32();
+  data->stride_width = m["stride_width"].AsInt32();
+  // Schema enum: SAME = 0, VALID = 1.
+  data->padding_type =
+      m["padding"].AsInt32() == 0 ? kTfLitePaddingSame : kTfLitePaddingValid;
+  data->activation = static_cast<TfLiteFusedActivation>(
+      m["activation"].IsNull() ? 0 : m["activation"].AsInt32());
+  return data;
+}
+
+TfLiteStatus SparseConvPrepare(TfLiteContext* context, TfLiteNode* node) {
+  MicroContext* micro_context = GetMicroContext(context);
+
+  TFLITE_DCHECK(node->user_data != nullptr);
+  OpData* data = static_cast<OpData*>(node->user_data);
+
+  TF_LITE_ENSURE(context, node->inputs->size == 4 || node->inputs->size == 5);
+  TF_LITE_ENSURE_EQ(context, node->outputs->size, 1);
+  TF_LITE_ENSURE(context, data->block_len > 0);
+  TF_LITE_ENSURE(context, data->stride_height > 0 && data->stride_width > 0);
+  TF_LITE_ENSURE(context, data->filter_height > 0 && data->filter_width > 0);
+
+  TfLiteTensor* input =
+      micro_context->AllocateTempInputTensor(node, kInputTensor);
+  TF_LITE_ENSURE(context, input != nullptr);
+  TfLiteTensor* values =
+      micro_context->AllocateTempInputTensor(node, kValuesTensor);
+  TF_LITE_ENSURE(context, values != nullptr);
+  TfLiteTensor* row_ptr =
+      micro_context->AllocateTempInputTensor(node, kRowPtrTensor);
+  TF_LITE_ENSURE(context, row_ptr != nullptr);
+  TfLiteTensor* col_idx =
+      micro_context->AllocateTempInputTensor(node, kColIdxTensor);
+  TF_LITE_ENSURE(context, col_idx != nullptr);
+  TfLiteTensor* output =
+      micro_context->AllocateTempOutputTensor(node, kOutputTensor);
+  TF_LITE_ENSURE(context, output != nullptr);
+
+  TF_LITE_ENSURE_TYPES_EQ(context, input->type, kTfLiteInt8);
+  TF_LITE_ENSURE_TYPES_EQ(context, output->type, kTfLiteInt8);
+  TF_LITE_ENSURE_TYPES_EQ(context, values->type, kTfLiteInt8);
+  TF_LITE_ENSURE_TYPES_EQ(context, row_ptr->type, kTfLiteInt32);
+  TF_LITE_ENSURE_TYPES_EQ(context, col_idx->type, kTfLiteUInt16);
+  TF_LITE_ENSURE_EQ(context, input->dims->size, 4);
+  TF_LITE_ENSURE_EQ(context, output->dims->size, 4);
+
+  const int input_height = input->dims->data[1];
+  const int input_width = input->dims->data[2];
+  const int input_channels = input->dims->data[3];
+  int output_height = output->dims->data[1];
+  int output_width = output->dims->data[2];
+  const int output_channels = output->dims->data[3];
+  // Blocks must not straddle two filter taps.
+  TF_LITE_ENSURE_EQ(context, input_channels % data->block_len, 0);
+  TF_LITE_ENSURE_STATUS(CheckBlockCsr(
+      context, values, row_ptr, col_idx, data->block_len, output_channels,
+      data->filter_height * data->filter_width * input_channels));
+
+  data->padding = ComputePaddingHeightWidth(
+      data->stride_height, data->stride_width, 1, 1, input_height, input_width,
+      data->filter_height, data->filter_width, data->padding_type,
+      &output_height, &output_width);
+
+  // The values tensor keeps the quantization of the dense filter, which may
+  // be per-channel along the output dimension.
+  TF_LITE_ENSURE_EQ(context, values->quantization.type,
+                    kTfLiteAffineQuantization);
+  const auto* affine_quantization =
+      static_cast<TfLiteAffineQuantization*>(values->quantization.params);
+  TFLITE_DCHECK(affine_quantization != nullptr);
+  TFLITE_DCHECK(affine_quantization->scale != nullptr);
+  const int num_scales = affine_quantization->scale->size;
+  TF_LITE_ENSURE(context,
+                 num_scales == 1 || num_scales == output_channels);
+  for (int i = 0; i < affine_quantization->zero_point->size; ++i) {
+    TF_LITE_ENSURE_EQ(context, affine_quantization->zero_point->data[i], 0);
+  }
+
+  data->per_channel_output_multiplier =
+      static_cast<int32_t*>(context->AllocatePersistentBuffer(
+          context, output_channels * sizeof(int32_t)));
+  data->per_channel_output_shift =
+      static_cast<int32_t*>(context->AllocatePersistentBuffer(
+          context, output_channels * sizeof(int32_t)));
+  TF_LITE_ENSURE(context, data->per_channel_output_multiplier != nullptr &&
+                              data->per_channel_output_shift != nullptr);
+  for (int i = 0; i < output_channels; ++i) {
+    const float filter_scale =
+        affine_quantization->scale->data[num_scales > 1 ? i : 0];
+    const double real_multiplier = static_cast<double>(input->params.scale) *
+                                   static_cast<double>(filter_scale) /
+                                   static_cast<double>(output->params.scale);
+    int shift;
+    QuantizeMultiplier(real_multiplier,
+                       &data->per_channel_output_multiplier[i], &shift);
+    data->per_channel_output_shift[i] = shift;
+  }
+
+  TF_LITE_ENSURE_STATUS(CalculateActivationRangeQuantized(
+      context, data->activation, output, &data->output_activation_min,
+      &data->output_activation_max));
+  data->input_zero_point = input->params.zero_point;
+  data->output_zero_point = output->params.zero_point;
+
+  micro_context->DeallocateTempTfLiteTensor(input);
+  micro_context->DeallocateTempTfLiteTensor(values);
+  micro_context->DeallocateTempTfLiteTensor(row_ptr);
+  micro_context->DeallocateTempTfLiteTensor(col_idx);
+  micro_context->DeallocateTempTfLiteTensor(output);
+  return kTfLiteOk;
+}
+
+TfLiteStatus SparseConvEval(TfLiteContext* context, TfLiteNode* node) {
+  TFLITE_DCHECK(node->user_data != nullptr);
+  const OpData& data = *(static_cast<const OpData*>(node->user_data));
+
+  const TfLiteEvalTensor* input =
+      tflite::micro::GetEvalInput(context, node, kInputTensor);
+  const TfLiteEvalTensor* values =
+      tflite::micro::GetEvalInput(context, node, kValuesTensor);
+  const TfLiteEvalTensor* row_ptr =
+      tflite::micro::GetEvalInput(context, node, kRowPtrTensor);
+  const TfLiteEvalTensor* col_idx =
+      tflite::micro::GetEvalInput(context, node, kColIdxTensor);
+  const TfLiteEvalTensor* bias =
+      (NumInputs(node) == 5)
+          ? tflite::micro::GetEvalInput(context, node, kBiasTensor)
+          : nullptr;
+  TfLiteEvalTensor* output =
+      tflite::micro::GetEvalOutput(context, node, kOutputTensor);
+
+  const RuntimeShape input_shape = tflite::micro::GetTensorShape(input);
+  const RuntimeShape output_shape = tflite::micro::GetTensorShape(output);
+  const int batch_size = MatchingDim(input_shape, 0, output_shape, 0);
+  const int input_height = input_shape.Dims(1);
+  const int input_width = input_shape.Dims(2);
+  const int input_depth = input_shape.Dims(3);
+  const int output_height = output_shape.Dims(1);
+  const int output_width = output_shape.Dims(2);
+  const int output_depth = output_shape.Dims(3);
+  const int input_size = input_width * input_height * input_depth;
+  const int output_size = output_width * output_height * output_depth;
+
+  const int8_t* input_data = tflite::micro::GetTensorData<int8_t>(input);
+  int8_t* output_data = tflite::micro::GetTensorData<int8_t>(output);
+  const int32_t* bias_data =
+      tflite::micro::GetOptionalTensorData<int32_t>(bias);
+  const int8_t* values_data = tflite::micro::GetTensorData<int8_t>(values);
+  const int32_t* row_ptr_data = tflite::micro::GetTensorData<int32_t>(row_ptr);
+  const uint16_t* col_idx_data =
+      tflite::micro::GetTensorData<uint16_t>(col_idx);
+
+#if ESP_NN
+  const sparse_data_t filter = {values_data, row_ptr_data, col_idx_data,
+                                data.block_len};
+  data_dims_t input_dims = {
+                             .width = input_width, .height = input_height,
+                             .channels = input_depth, 1
+                           };
+  data_dims_t output_dims = {
+                              .width = output_width, .height = output_height,
+                              .channels = output_depth, 1
+                            };
+  data_dims_t filter_dims = {.width = data.filter_width,
+                             .height = data.filter_height, 0, 0};
+  conv_params_t conv_params = {
+                                .in_offset = -data.input_zero_point,
+                                .out_offset = data.output_zero_point,
+                                .stride = {data.stride_width, data.stride_height},
+                                .padding = {data.padding.width, data.padding.height},
+                                .dilation = {0, 0},
+                                .activation = {data.output_activation_min,
+                                               data.output_activation_max}
+                              };
+  quant_data_t quant_data = {
+                              .shift = data.per_channel_output_shift,
+                              .mult = data.per_channel_output_multiplier
+                            };
+
+  for (int i_batch = 0; i_batch < batch_size; i_batch++) {
+    esp_nn_conv_sparse_s8(&input_dims, input_data + i_batch * input_size,
+                          &filter_dims, &filter, bias_data, &output_dims,
+                          output_data + i_batch * output_size, &conv_params,
+                          &quant_data);
+  }
+#else
+  const int block_len = data.block_len;
+  for (int i_batch = 0; i_batch < batch_size; i_batch++) {
+    const int8_t* in = input_data + i_batch * input_size;
+    int8_t* out = output_data + i_batch * output_size;
+    for (int out_y = 0; out_y < output_height; ++out_y) {
+      const int base_y = out_y * data.stride_height - data.padding.height;
+      for (int out_x = 0; out_x < output_width; ++out_x) {
+        const int base_x = out_x * data.stride_width - data.padding.width;
+        for (int out_c = 0; out_c < output_depth; ++out_c) {
+          int32_t acc = 0;
+          for (int blk = row_ptr_data[out_c]; blk < row_ptr_data[out_c + 1];
+               ++blk) {
+            const int pos = col_idx_data[blk] * block_len;
+            const int tap = pos / input_depth;
+            const int in_c = pos - tap * input_depth;
+            const int in_y = base_y + tap / data.filter_width;
+            const int in_x = base_x + tap % data.filter_width;
+            if (in_y < 0 || in_y >= input_height || in_x < 0 ||
+                in_x >= input_width) {
+              continue;
+            }
+            const int8_t* x = in + (in_y * input_width + in_x) * input_depth +
+                              in_c;
+            const int8_t* w = values_data + blk * block_len;
+            for (int i = 0; i < block_len; ++i) {
+              acc += w[i] * (x[i] - data.input_zero_point);
+            }
+          }
+          if (bias_data) {
+            acc += bias_data[out_c];
+          }
+          acc = MultiplyByQuantizedMultiplier(
+              acc, data.per_channel_output_multiplier[out_c],
+              data.per_channel_output_shift[out_c]);
+          acc += data.output_zero_point;
+          acc = std::max(acc, data.output_activation_min);
+          acc = std::min(acc, data.output_activation_max);
+          *out++ = static_cast<int8_t>(acc);
+        }
+      }
+    }
+  }
+#endif
+  return kTfLiteOk;
+}
+
+}  // namespace
+
+TFLMRegistration* Register_ESP_SPARSE_CONV_2D() {
+  static TFLMRegistration r = tflite::micro::RegisterOp(
+      SparseConvInit, SparseConvPrepare, SparseConvEval);
+  return &r;
+}
+
+const char* GetString_ESP_SPARSE_CONV_2D() { return "ESP_SPARSE_CONV_2D"; }
+
+}  // namespace tflite
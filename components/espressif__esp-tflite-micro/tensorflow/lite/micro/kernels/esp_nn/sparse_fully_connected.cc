@@ -0,0 +1,220 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "flatbuffers/flexbuffers.h"
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/internal/quantization_util.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/esp_sparse.h"
+#include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/micro_log.h"
+
+#if ESP_NN
+#include <esp_nn.h>
+#endif
+
+namespace tflite {
+namespace {
+
+constexpr int kInputTensor = 0;
+constexpr int kValuesTensor = 1;
+constexpr int kRowPtrTensor = 2;
+constexpr int kColIdxTensor = 3;
+constexpr int kBiasTensor = 4;
+constexpr int kOutputTensor = 0;
+
+struct OpData {
+  int block_len;
+  TfLiteFusedActivation activation;
+  int32_t output_multiplier;
+  int output_shift;
+  int32_t input_zero_point;
+  int32_t output_zero_point;
+  int32_t output_activation_min;
+  int32_t output_activation_max;
+};
+
+void* SparseFullyConnectedInit(TfLiteContext* context, const char* buffer,
+                               size_t length) {
+  TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
+  OpData* data = static_cast<OpData*>(
+      context->AllocatePersistentBuffer(context, sizeof(OpData)));
+
+  const uint8_t* buffer_t = reinterpret_cast<const uint8_t*>(buffer);
+  const flexbuffers::Map& m = flexbuffers::GetRoot(buffer_t, length).AsMap();
+  data->block_len = m["block_len"].AsInt32();
+  data->activation = static_cast<TfLiteFusedActivation>(
+      m["activation"].IsNull() ? 0 : m["activation"].AsInt32());
+  return data;
+}
+
+TfLiteStatus SparseFullyConnectedPrepare(TfLiteContext* context,
+                                         TfLiteNode* node) {
+  MicroContext* micro_context = GetMicroContext(context);
+
+  TFLITE_DCHECK(node->user_data != nullptr);
+  OpData* data = static_cast<OpData*>(node->user_data);
+
+  TF_LITE_ENSURE(context, node->inputs->size == 4 || node->inputs->size == 5);
+  TF_LITE_ENSURE_EQ(context, node->outputs->size, 1);
+  TF_LITE_ENSURE(context, data->block_len > 0);
+
+  TfLiteTensor* input =
+      micro_context->AllocateTempInputTensor(node, kInputTensor);
+  TF_LITE_ENSURE(context, input != nullptr);
+  TfLiteTensor* values =
+      micro_context->AllocateTempInputTensor(node, kValuesTensor);
+  TF_LITE_ENSURE(context, values != nullptr);
+  TfLiteTensor* row_ptr =
+      micro_context->AllocateTempInputTensor(node, kRowPtrTensor);
+  TF_LITE_ENSURE(context, row_ptr != nullptr);
+  TfLiteTensor* col_idx =
+      micro_context->AllocateTempInputTensor(node, kColIdxTensor);
+  TF_LITE_ENSURE(context, col_idx != nullptr);
+  TfLiteTensor* output =
+      micro_context->AllocateTempOutputTensor(node, kOutputTensor);
+  TF_LITE_ENSURE(context, output != nullptr);
+
+  TF_LITE_ENSURE_TYPES_EQ(context, input->type, kTfLiteInt8);
+  TF_LITE_ENSURE_TYPES_EQ(context, output->type, kTfLiteInt8);
+  TF_LITE_ENSURE_TYPES_EQ(context, values->type, kTfLiteInt8);
+  TF_LITE_ENSURE_TYPES_EQ(context, row_ptr->type, kTfLiteInt32);
+  TF_LITE_ENSURE_TYPES_EQ(context, col_idx->type, kTfLiteUInt16);
+  // Zero blocks are dropped by the converter, so the filter must be symmetric.
+  TF_LITE_ENSURE_EQ(context, values->params.zero_point, 0);
+
+  const int output_depth = output->dims->data[output->dims->size - 1];
+  TF_LITE_ENSURE(context, output_depth > 0);
+  const int batches = NumElements(output) / output_depth;
+  TF_LITE_ENSURE(context, batches > 0);
+  TF_LITE_ENSURE_EQ(context, NumElements(input) % batches, 0);
+  const int accum_depth = NumElements(input) / batches;
+  TF_LITE_ENSURE_STATUS(CheckBlockCsr(context, values, row_ptr, col_idx,
+                                      data->block_len, output_depth,
+                                      accum_depth));
+
+  const double real_multiplier = static_cast<double>(input->params.scale) *
+                                 static_cast<double>(values->params.scale) /
+                                 static_cast<double>(output->params.scale);
+  QuantizeMultiplier(real_multiplier, &data->output_multiplier,
+                     &data->output_shift);
+  TF_LITE_ENSURE_STATUS(CalculateActivationRangeQuantized(
+      context, data->activation, output, &data->output_activation_min,
+      &data->output_activation_max));
+  data->input_zero_point = input->params.zero_point;
+  data->output_zero_point = output->params.zero_point;
+
+  micro_context->DeallocateTempTfLiteTensor(input);
+  micro_context->DeallocateTempTfLiteTensor(values);
+  micro_context->DeallocateTempTfLiteTensor(row_ptr);
+  micro_context->DeallocateTempTfLiteTensor(col_idx);
+  micro_context->DeallocateTempTfLiteTensor(output);
+  return kTfLiteOk;
+}
+
+TfLiteStatus SparseFullyConnectedEval(TfLiteContext* context,
+                                      TfLiteNode* node) {
+  TFLITE_DCHECK(node->user_data != nullptr);
+  const OpData& data = *(static_cast<const OpData*>(node->user_data));
+
+  const TfLiteEvalTensor* input =
+      tflite::micro::GetEvalInput(context, node, kInputTensor);
+  const TfLiteEvalTensor* values =
+      tflite::micro::GetEvalInput(context, node, kValuesTensor);
+  const TfLiteEvalTensor* row_ptr =
+      tflite::micro::GetEvalInput(context, node, kRowPtrTensor);
+  const TfLiteEvalTensor* col_idx =
+      tflite::micro::GetEvalInput(context, node, kColIdxTensor);
+  const TfLiteEvalTensor* bias =
+      (NumInputs(node) == 5)
+          ? tflite::micro::GetEvalInput(context, node, kBiasTensor)
+          : nullptr;
+  TfLiteEvalTensor* output =
+      tflite::micro::GetEvalOutput(context, node, kOutputTensor);
+
+  const RuntimeShape output_shape = tflite::micro::GetTensorShape(output);
+  const int output_dim_count = output_shape.DimensionsCount();
+  const int output_depth = output_shape.Dims(output_dim_count - 1);
+  const int batches = FlatSizeSkipDim(output_shape, output_dim_count - 1);
+  const int accum_depth =
+      tflite::micro::GetTensorShape(input).FlatSize() / batches;
+
+  const int8_t* input_data = tflite::micro::GetTensorData<int8_t>(input);
+  int8_t* output_data = tflite::micro::GetTensorData<int8_t>(output);
+  const int32_t* bias_data =
+      tflite::micro::GetOptionalTensorData<int32_t>(bias);
+  const int8_t* values_data = tflite::micro::GetTensorData<int8_t>(values);
+  const int32_t* row_ptr_data = tflite::micro::GetTensorData<int32_t>(row_ptr);
+  const uint16_t* col_idx_data =
+      tflite::micro::GetTensorData<uint16_t>(col_idx);
+
+#if ESP_NN
+  const sparse_data_t filter = {values_data, row_ptr_data, col_idx_data,
+                                data.block_len};
+  for (int b = 0; b < batches; ++b) {
+    esp_nn_fully_connected_sparse_s8(
+        input_data, -data.input_zero_point, accum_depth, &filter, bias_data,
+        output_data, output_depth, data.output_zero_point, data.output_shift,
+        data.output_multiplier, data.output_activation_min,
+        data.output_activation_max);
+    input_data += accum_depth;
+    output_data += output_depth;
+  }
+#else
+  const int block_len = data.block_len;
+  for (int b = 0; b < batches; ++b) {
+    for (int out_c = 0; out_c < output_depth; ++out_c) {
+      int32_t acc = 0;
+      for (int blk = row_ptr_data[out_c]; blk < row_ptr_data[out_c + 1];
+           ++blk) {
+        const int8_t* w = values_data + blk * block_len;
+        const int8_t* x = input_data + col_idx_data[blk] * block_len;
+        for (int i = 0; i < block_len; ++i) {
+          acc += w[i] * (x[i] - data.input_zero_point);
+        }
+      }
+      if (bias_data) {
+        acc += bias_data[out_c];
+      }
+      acc = MultiplyByQuantizedMultiplier(acc, data.output_multiplier,
+                                          data.output_shift);
+      acc += data.output_zero_point;
+      acc = std::max(acc, data.output_activation_min);
+      acc = std::min(acc, data.output_activation_max);
+      output_data[out_c] = static_cast<int8_t>(acc);
+    }
+    input_data += accum_depth;
+    output_data += output_depth;
+  }
+#endif
+  return kTfLiteOk;
+}
+
+}  // namespace
+
+TFLMRegistration* Register_ESP_SPARSE_FULLY_CONNECTED() {
+  static TFLMRegistration r = tflite::micro::RegisterOp(
+      SparseFullyConnectedInit, SparseFullyConnectedPrepare,
+      SparseFullyConnectedEval);
+  return &r;
+}
+
+const char* GetString_ESP_SPARSE_FULLY_CONNECTED() {
+  return "ESP_SPARSE_FULLY_CONNECTED";
+}
+
+}  // namespace tflite
@@ -0,0 +1,102 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_ESP_NN_TUNE_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_ESP_NN_TUNE_H_
+
+#include <esp_timer.h>
+
+#include <cstdint>
+
+namespace tflite {
+
+// Shape keyed esp-nn kernel selection for CONV_2D and DEPTHWISE_CONV_2D.
+//
+// esp-nn picks a kernel per layer with a fixed heuristic. With tuning enabled,
+// each int8 conv / depthwise conv layer not yet in the table times every
+// eligible esp-nn variant on its first Eval, keeps the fastest and records it.
+// Layers found in the table dispatch straight to the recorded variant and only
+// request the scratch that variant needs.
+//
+// The table is plain data: an application can persist EspNnTuneGetTable() in
+// NVS (keyed by a model hash) and feed it back with EspNnTuneLoadTable() on the
+// next boot, or bake the output of EspNnTunePrintTable() into the firmware.
+// Both must happen before AllocateTensors(), which runs the kernel Prepare.
+// Prepare ignores a recorded variant that the layer is not eligible for, as
+// if the layer was never tuned.
+
+enum EspNnTuneOp : uint8_t {
+  kEspNnTuneConv = 0,
+  kEspNnTuneDepthwiseConv = 1,
+};
+
+struct EspNnTuneEntry {
+  uint32_t key;     // EspNnTuneKey() of the layer
+  uint8_t variant;  // esp_nn_variant_t
+  uint8_t reserved[3];
+};
+
+constexpr int kEspNnTuneMaxEntries = 64;
+
+// Hash of everything that decides kernel eligibility and speed of a layer.
+uint32_t EspNnTuneKey(EspNnTuneOp op, int input_width, int input_height,
+                      int input_channels, int output_width, int output_height,
+                      int output_channels, int filter_width, int filter_height,
+                      int stride_width, int stride_height, int pad_width,
+                      int pad_height, int ch_mult);
+
+void EspNnTuneSetEnabled(bool enabled);
+bool EspNnTuneEnabled();
+
+// Returns the recorded variant or -1 when the layer was never tuned.
+int EspNnTuneLookup(uint32_t key);
+void EspNnTuneRecord(uint32_t key, int variant);
+
+// Replaces the table. Returns false if `count` exceeds kEspNnTuneMaxEntries.
+bool EspNnTuneLoadTable(const EspNnTuneEntry* entries, int count);
+const EspNnTuneEntry* EspNnTuneGetTable(int* count);
+void EspNnTuneResetTable();
+
+// Prints the table as a C array to paste into the application.
+void EspNnTunePrintTable();
+
+// Runs `run(variant)` for every candidate, best of kEspNnTuneRuns, and returns
+// the fastest. Variants are bit exact so the output of the last run is valid.
+constexpr int kEspNnTuneRuns = 3;
+
+template <typename Variant, typename RunFn>
+Variant EspNnTuneSelect(const Variant* variants, int count, RunFn run) {
+  Variant best = variants[0];
+  long long best_time = -1;
+  for (int i = 0; i < count; i++) {
+    long long variant_time = -1;
+    for (int r = 0; r < kEspNnTuneRuns; r++) {
+      long long start_time = esp_timer_get_time();
+      run(variants[i]);
+      long long elapsed = esp_timer_get_time() - start_time;
+      if (variant_time < 0 || elapsed < variant_time) {
+        variant_time = elapsed;
+      }
+    }
+    if (best_time < 0 || variant_time < best_time) {
+      best_time = variant_time;
+      best = variants[i];
+    }
+  }
+  return best;
+}
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_ESP_NN_TUNE_H_
@@ -0,0 +1,49 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_ESP_SPARSE_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_ESP_SPARSE_H_
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/micro/micro_common.h"
+
+namespace tflite {
+
+// Block-sparse int8 FULLY_CONNECTED / CONV_2D custom ops. The filter is stored
+// as block-CSR (see sparse_data_t in esp_nn_defs.h) and the op is produced by
+// tools/esp_sparse_converter. Tensor inputs are:
+//   0: input, 1: block values [num_blocks, block_len] carrying the original
+//   filter quantization, 2: row_ptr int32 [out_channels + 1],
+//   3: col_idx uint16 [num_blocks], 4: bias int32 (optional).
+// Custom options are a flexbuffer map with "block_len", "activation" and, for
+// conv, "filter_height", "filter_width", "stride_height", "stride_width" and
+// "padding" (schema enum: 0 SAME, 1 VALID).
+TFLMRegistration* Register_ESP_SPARSE_FULLY_CONNECTED();
+TFLMRegistration* Register_ESP_SPARSE_CONV_2D();
+
+// Checks the block-CSR metadata of `rows` dense rows of `row_length` weights:
+// block_len divides the row, row_ptr starts at 0, never decreases and ends at
+// the number of blocks, and every col_idx points inside the row. Eval indexes
+// the input with it unchecked.
+TfLiteStatus CheckBlockCsr(TfLiteContext* context, const TfLiteTensor* values,
+                           const TfLiteTensor* row_ptr,
+                           const TfLiteTensor* col_idx, int block_len,
+                           int rows, int row_length);
+
+const char* GetString_ESP_SPARSE_FULLY_CONNECTED();
+const char* GetString_ESP_SPARSE_CONV_2D();
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_ESP_SPARSE_H_
@@ -0,0 +1,52 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/esp_sparse.h"
+
+namespace tflite {
+
+TfLiteStatus CheckBlockCsr(TfLiteContext* context, const TfLiteTensor* values,
+                           const TfLiteTensor* row_ptr,
+                           const TfLiteTensor* col_idx, int block_len,
+                           int rows, int row_length) {
+  TF_LITE_ENSURE(context, block_len > 0);
+  TF_LITE_ENSURE_EQ(context, row_length % block_len, 0);
+  TF_LITE_ENSURE_EQ(context, NumElements(row_ptr), rows + 1);
+  // The metadata is only read once here, so it has to be part of the model.
+  TF_LITE_ENSURE(context, IsConstantTensor(row_ptr));
+  TF_LITE_ENSURE(context, IsConstantTensor(col_idx));
+
+  const int num_blocks = NumElements(col_idx);
+  TF_LITE_ENSURE_EQ(context, NumElements(values), num_blocks * block_len);
+
+  const int32_t* row_ptr_data = GetTensorData<int32_t>(row_ptr);
+  TF_LITE_ENSURE_EQ(context, row_ptr_data[0], 0);
+  for (int i = 0; i < rows; ++i) {
+    TF_LITE_ENSURE(context, row_ptr_data[i] <= row_ptr_data[i + 1]);
+  }
+  TF_LITE_ENSURE_EQ(context, row_ptr_data[rows], num_blocks);
+
+  const uint16_t* col_idx_data = GetTensorData<uint16_t>(col_idx);
+  const int row_blocks = row_length / block_len;
+  for (int i = 0; i < num_blocks; ++i) {
+    TF_LITE_ENSURE(context, col_idx_data[i] < row_blocks);
+  }
+  return kTfLiteOk;
+}
+
+}  // namespace tflite
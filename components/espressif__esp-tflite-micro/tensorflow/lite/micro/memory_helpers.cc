@@ -62,6 +62,9 @@ TfLiteStatus TfLiteTypeSizeOf(TfLiteType type, size_t* size) {
     case kTfLiteInt16:
       *size = sizeof(int16_t);
       break;
+    case kTfLiteUInt16:
+      *size = sizeof(uint16_t);
+      break;
     case kTfLiteInt32:
       *size = sizeof(int32_t);
       break;
@@ -32,6 +32,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/compatibility.h"
 #include "tensorflow/lite/kernels/op_macros.h"
 #include "tensorflow/lite/micro/compatibility.h"
+#include "tensorflow/lite/micro/kernels/esp_sparse.h"
 #include "tensorflow/lite/micro/kernels/ethosu.h"
 #include "tensorflow/lite/micro/kernels/micro_ops.h"
 #include "tensorflow/lite/micro/kernels/reduce.h"
@@ -251,6 +252,16 @@ class MicroMutableOpResolver : public MicroOpResolver {
     return AddBuiltin(BuiltinOperator_EQUAL, Register_EQUAL(), ParseEqual);
   }
 
+  TfLiteStatus AddEspSparseConv2D() {
+    return AddCustom(tflite::GetString_ESP_SPARSE_CONV_2D(),
+                     tflite::Register_ESP_SPARSE_CONV_2D());
+  }
+
+  TfLiteStatus AddEspSparseFullyConnected() {
+    return AddCustom(tflite::GetString_ESP_SPARSE_FULLY_CONNECTED(),
+                     tflite::Register_ESP_SPARSE_FULLY_CONNECTED());
+  }
+
   TfLiteStatus AddEthosU() {
     TFLMRegistration* registration = tflite::Register_ETHOSU();
     if (registration) {
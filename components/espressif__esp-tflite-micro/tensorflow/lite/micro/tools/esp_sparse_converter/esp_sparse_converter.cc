@@ -0,0 +1,342 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Host tool: rewrites int8 FULLY_CONNECTED and CONV_2D ops whose filters have
+// enough all-zero blocks into the ESP_SPARSE_FULLY_CONNECTED /
+// ESP_SPARSE_CONV_2D custom ops (see kernels/esp_sparse.h).
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "flatbuffers/default_allocator.h"
+#include "flatbuffers/flexbuffers.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace {
+
+struct Options {
+  int block_len = 8;
+  float min_sparsity = 0.5f;
+};
+
+struct SparseFilter {
+  std::vector<int8_t> values;
+  std::vector<int32_t> row_ptr;
+  std::vector<uint16_t> col_idx;
+};
+
+tflite::BuiltinOperator GetBuiltinCode(const tflite::OperatorCodeT& code) {
+  return std::max(code.builtin_code, static_cast<tflite::BuiltinOperator>(
+                                         code.deprecated_builtin_code));
+}
+
+// Packs a dense [rows, row_len] filter into block-CSR, dropping all-zero
+// blocks. Returns the fraction of blocks that were dropped.
+float PackBlocks(const int8_t* dense, int rows, int row_len, int block_len,
+                 SparseFilter* out) {
+  const int blocks_per_row = row_len / block_len;
+  int dropped = 0;
+  out->row_ptr.push_back(0);
+  for (int r = 0; r < rows; ++r) {
+    for (int b = 0; b < blocks_per_row; ++b) {
+      const int8_t* blk = dense + r * row_len + b * block_len;
+      bool zero = true;
+      for (int i = 0; i < block_len; ++i) {
+        zero &= blk[i] == 0;
+      }
+      if (zero) {
+        ++dropped;
+        continue;
+      }
+      out->values.insert(out->values.end(), blk, blk + block_len);
+      out->col_idx.push_back(static_cast<uint16_t>(b));
+    }
+    out->row_ptr.push_back(static_cast<int32_t>(out->col_idx.size()));
+  }
+  return static_cast<float>(dropped) / (rows * blocks_per_row);
+}
+
+int AddBuffer(tflite::ModelT* model, const void* data, size_t size) {
+  auto buffer = std::make_unique<tflite::BufferT>();
+  const uint8_t* bytes = static_cast<const uint8_t*>(data);
+  buffer->data.assign(bytes, bytes + size);
+  model->buffers.push_back(std::move(buffer));
+  return static_cast<int>(model->buffers.size() - 1);
+}
+
+int AddConstTensor(tflite::ModelT* model, tflite::SubGraphT* subgraph,
+                   const std::string& name, tflite::TensorType type,
+                   std::vector<int32_t> shape, const void* data, size_t size) {
+  auto tensor = std::make_unique<tflite::TensorT>();
+  tensor->name = name;
+  tensor->type = type;
+  tensor->shape = std::move(shape);
+  tensor->buffer = AddBuffer(model, data, size);
+  subgraph->tensors.push_back(std::move(tensor));
+  return static_cast<int>(subgraph->tensors.size() - 1);
+}
+
+uint32_t GetCustomOpcode(tflite::ModelT* model, const char* name) {
+  for (size_t i = 0; i < model->operator_codes.size(); ++i) {
+    const auto& code = *model->operator_codes[i];
+    if (GetBuiltinCode(code) == tflite::BuiltinOperator_CUSTOM &&
+        code.custom_code == name) {
+      return static_cast<uint32_t>(i);
+    }
+  }
+  auto code = std::make_unique<tflite::OperatorCodeT>();
+  code->builtin_code = tflite::BuiltinOperator_CUSTOM;
+  code->deprecated_builtin_code = tflite::BuiltinOperator_CUSTOM;
+  code->custom_code = name;
+  model->operator_codes.push_back(std::move(code));
+  return static_cast<uint32_t>(model->operator_codes.size() - 1);
+}
+
+// Tries to rewrite `op` in place. Returns true if it was converted.
+bool ConvertOp(tflite::ModelT* model, tflite::SubGraphT* subgraph,
+               tflite::OperatorT* op, const Options& options) {
+  const auto builtin =
+      GetBuiltinCode(*model->operator_codes[op->opcode_index]);
+  const bool is_fc = builtin == tflite::BuiltinOperator_FULLY_CONNECTED;
+  const bool is_conv = builtin == tflite::BuiltinOperator_CONV_2D;
+  if ((!is_fc && !is_conv) || op->inputs.size() < 2) {
+    return false;
+  }
+
+  const tflite::TensorT& input = *subgraph->tensors[op->inputs[0]];
+  const tflite::TensorT& filter = *subgraph->tensors[op->inputs[1]];
+  if (input.type != tflite::TensorType_INT8 ||
+      filter.type != tflite::TensorType_INT8 || filter.buffer == 0 ||
+      model->buffers[filter.buffer]->data.empty() || !filter.quantization) {
+    return false;
+  }
+  for (int64_t zp : filter.quantization->zero_point) {
+    if (zp != 0) return false;
+  }
+
+  const int block_len = options.block_len;
+  const int rows = filter.shape[0];
+  int row_len = 1;
+  for (size_t i = 1; i < filter.shape.size(); ++i) {
+    row_len *= filter.shape[i];
+  }
+
+  flexbuffers::Builder fbb;
+  if (is_fc) {
+    const auto* fc = op->builtin_options.AsFullyConnectedOptions();
+    if (fc == nullptr ||
+        fc->weights_format != tflite::FullyConnectedOptionsWeightsFormat_DEFAULT ||
+        row_len % block_len != 0 || filter.quantization->scale.size() != 1) {
+      return false;
+    }
+    fbb.Map([&]() {
+      fbb.Int("block_len", block_len);
+      fbb.Int("activation", fc->fused_activation_function);
+    });
+  } else {
+    const auto* conv = op->builtin_options.AsConv2DOptions();
+    // Blocks must stay inside one filter tap, see esp_nn_conv_sparse_s8.
+    if (conv == nullptr || conv->dilation_w_factor != 1 ||
+        conv->dilation_h_factor != 1 || filter.shape.size() != 4 ||
+        filter.shape[3] % block_len != 0 ||
+        input.shape.size() != 4 || input.shape[3] != filter.shape[3]) {
+      return false;
+    }
+    fbb.Map([&]() {
+      fbb.Int("block_len", block_len);
+      fbb.Int("activation", conv->fused_activation_function);
+      fbb.Int("filter_height", filter.shape[1]);
+      fbb.Int("filter_width", filter.shape[2]);
+      fbb.Int("stride_height", conv->stride_h);
+      fbb.Int("stride_width", conv->stride_w);
+      fbb.Int("padding", conv->padding);
+    });
+  }
+  fbb.Finish();
+
+  SparseFilter sparse;
+  const int8_t* dense =
+      reinterpret_cast<const int8_t*>(model->buffers[filter.buffer]->data.data());
+  const float sparsity = PackBlocks(dense, rows, row_len, block_len, &sparse);
+  if (sparsity < options.min_sparsity || sparse.col_idx.empty() ||
+      row_len / block_len > UINT16_MAX) {
+    return false;
+  }
+
+  const std::string name = filter.name;
+  const int num_blocks = static_cast<int>(sparse.col_idx.size());
+  auto quantization =
+      std::make_unique<tflite::QuantizationParametersT>(*filter.quantization);
+
+  const int values_idx = AddConstTensor(
+      model, subgraph, name + "/sparse_values", tflite::TensorType_INT8,
+      {num_blocks, block_len}, sparse.values.data(), sparse.values.size());
+  subgraph->tensors[values_idx]->quantization = std::move(quantization);
+  const int row_ptr_idx = AddConstTensor(
+      model, subgraph, name + "/sparse_row_ptr", tflite::TensorType_INT32,
+      {rows + 1}, sparse.row_ptr.data(),
+      sparse.row_ptr.size() * sizeof(int32_t));
+  const int col_idx_idx = AddConstTensor(
+      model, subgraph, name + "/sparse_col_idx", tflite::TensorType_UINT16,
+      {num_blocks}, sparse.col_idx.data(),
+      sparse.col_idx.size() * sizeof(uint16_t));
+
+  std::vector<int32_t> inputs = {op->inputs[0], values_idx, row_ptr_idx,
+                                 col_idx_idx};
+  if (op->inputs.size() > 2 && op->inputs[2] >= 0) {
+    inputs.push_back(op->inputs[2]);
+  }
+
+  printf("%s '%s': %d/%d blocks kept (%.1f%% sparse)\n",
+         is_fc ? "FULLY_CONNECTED" : "CONV_2D", name.c_str(), num_blocks,
+         rows * (row_len / block_len), sparsity * 100.0f);
+
+  op->opcode_index = GetCustomOpcode(
+      model, is_fc ? "ESP_SPARSE_FULLY_CONNECTED" : "ESP_SPARSE_CONV_2D");
+  op->inputs = inputs;
+  op->builtin_options.Reset();
+  op->custom_options = fbb.GetBuffer();
+  op->custom_options_format = tflite::CustomOptionsFormat_FLEXBUFFERS;
+  return true;
+}
+
+// Drops tensors that are no longer referenced and the data of their buffers,
+// so the dense filters do not stay in the flatbuffer.
+void RemoveUnusedTensors(tflite::ModelT* model, int subgraph_index) {
+  tflite::SubGraphT* subgraph = model->subgraphs[subgraph_index].get();
+  std::vector<bool> used(subgraph->tensors.size(), false);
+  auto mark = [&](const std::vector<int32_t>& v) {
+    for (int32_t t : v) {
+      if (t >= 0) used[t] = true;
+    }
+  };
+  mark(subgraph->inputs);
+  mark(subgraph->outputs);
+  for (const auto& op : subgraph->operators) {
+    mark(op->inputs);
+    mark(op->outputs);
+    mark(op->intermediates);
+  }
+
+  std::vector<int32_t> remap(subgraph->tensors.size(), -1);
+  std::vector<std::unique_ptr<tflite::TensorT>> kept;
+  for (size_t i = 0; i < subgraph->tensors.size(); ++i) {
+    if (used[i]) {
+      remap[i] = static_cast<int32_t>(kept.size());
+      kept.push_back(std::move(subgraph->tensors[i]));
+    } else if (subgraph->tensors[i]->buffer != 0) {
+      model->buffers[subgraph->tensors[i]->buffer]->data.clear();
+    }
+  }
+  subgraph->tensors = std::move(kept);
+
+  auto apply = [&](std::vector<int32_t>* v) {
+    for (int32_t& t : *v) {
+      if (t >= 0) t = remap[t];
+    }
+  };
+  apply(&subgraph->inputs);
+  apply(&subgraph->outputs);
+  for (auto& op : subgraph->operators) {
+    apply(&op->inputs);
+    apply(&op->outputs);
+    apply(&op->intermediates);
+  }
+  for (auto& sig : model->signature_defs) {
+    if (static_cast<int>(sig->subgraph_index) != subgraph_index) continue;
+    for (auto& m : sig->inputs) m->tensor_index = remap[m->tensor_index];
+    for (auto& m : sig->outputs) m->tensor_index = remap[m->tensor_index];
+  }
+}
+
+void Usage(const char* argv0) {
+  fprintf(stderr,
+          "usage: %s <in.tflite> <out.tflite> [--block_len=N] "
+          "[--min_sparsity=F]\n"
+          "  --block_len     elements per block, default 8\n"
+          "  --min_sparsity  fraction of zero blocks needed to convert an op, "
+          "default 0.5\n",
+          argv0);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc < 3) {
+    Usage(argv[0]);
+    return 1;
+  }
+  Options options;
+  for (int i = 3; i < argc; ++i) {
+    if (strncmp(argv[i], "--block_len=", 12) == 0) {
+      options.block_len = atoi(argv[i] + 12);
+    } else if (strncmp(argv[i], "--min_sparsity=", 15) == 0) {
+      options.min_sparsity = static_cast<float>(atof(argv[i] + 15));
+    } else {
+      Usage(argv[0]);
+      return 1;
+    }
+  }
+  if (options.block_len <= 0) {
+    Usage(argv[0]);
+    return 1;
+  }
+
+  std::ifstream in(argv[1], std::ios::binary);
+  if (!in) {
+    fprintf(stderr, "cannot open %s\n", argv[1]);
+    return 1;
+  }
+  std::vector<char> bytes((std::istreambuf_iterator<char>(in)),
+                          std::istreambuf_iterator<char>());
+  flatbuffers::Verifier verifier(reinterpret_cast<const uint8_t*>(bytes.data()),
+                                 bytes.size());
+  if (!tflite::VerifyModelBuffer(verifier)) {
+    fprintf(stderr, "%s is not a valid .tflite model\n", argv[1]);
+    return 1;
+  }
+  std::unique_ptr<tflite::ModelT> model(tflite::GetModel(bytes.data())->UnPack());
+
+  int converted = 0;
+  for (size_t s = 0; s < model->subgraphs.size(); ++s) {
+    tflite::SubGraphT* subgraph = model->subgraphs[s].get();
+    for (auto& op : subgraph->operators) {
+      converted += ConvertOp(model.get(), subgraph, op.get(), options);
+    }
+    RemoveUnusedTensors(model.get(), static_cast<int>(s));
+  }
+
+  // The vendored flatbuffers has no implicit default allocator.
+  flatbuffers::DefaultAllocator allocator;
+  flatbuffers::FlatBufferBuilder fbb(1024, &allocator);
+  tflite::FinishModelBuffer(fbb, tflite::Model::Pack(fbb, model.get()));
+  std::ofstream out(argv[2], std::ios::binary);
+  out.write(reinterpret_cast<const char*>(fbb.GetBufferPointer()),
+            fbb.GetSize());
+  if (!out) {
+    fprintf(stderr, "cannot write %s\n", argv[2]);
+    return 1;
+  }
+  printf("converted %d op(s), %zu -> %u bytes\n", converted, bytes.size(),
+         fbb.GetSize());
+  return 0;
+}
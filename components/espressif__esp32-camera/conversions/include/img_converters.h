@@ -83,6 +83,55 @@ bool fmt2jpg(uint8_t *src, size_t src_len, uint16_t width, uint16_t height, pixf
  */
 bool frame2jpg(camera_fb_t * fb, uint8_t quality, uint8_t ** out, size_t * out_len);
 
+/**
+ * @brief Size of the work buffer needed by fmt2jpg_fast
+ *
+ * @param width     Width in pixels of the source image
+ * @param format    Format of the source image
+ *
+ * @return size in bytes of the work buffer
+ */
+size_t fmt2jpg_fast_work_size(uint16_t width, pixformat_t format);
+
+/**
+ * @brief Convert image buffer to JPEG into caller provided memory
+ *
+ * Nothing is allocated per call. Uses the fixed point AAN DCT and, on dual core targets,
+ * encodes the bottom half of the image on the other core, the halves being joined at a
+ * restart marker. The first call on a dual core target creates the worker task.
+ *
+ * @param src       Source buffer in RGB565, RGB888, YUYV or GRAYSCALE format
+ * @param src_len   Length in bytes of the source buffer
+ * @param width     Width in pixels of the source image
+ * @param height    Height in pixels of the source image
+ * @param format    Format of the source image
+ * @param quality   JPEG quality of the resulting image
+ * @param work      Work buffer of at least fmt2jpg_fast_work_size() bytes
+ * @param work_len  Length in bytes of the work buffer
+ * @param out       Buffer for the resulting JPEG
+ * @param out_size  Size in bytes of the output buffer
+ * @param out_len   Pointer to be populated with the length of the resulting JPEG
+ *
+ * @return true on success, false if the work buffer is too small or the JPEG does not fit
+ */
+bool fmt2jpg_fast(uint8_t *src, size_t src_len, uint16_t width, uint16_t height, pixformat_t format, uint8_t quality,
+                  void *work, size_t work_len, uint8_t *out, size_t out_size, size_t *out_len);
+
+/**
+ * @brief Convert camera frame buffer to JPEG into caller provided memory
+ *
+ * @param fb        Source camera frame buffer
+ * @param quality   JPEG quality of the resulting image
+ * @param work      Work buffer of at least fmt2jpg_fast_work_size() bytes
+ * @param work_len  Length in bytes of the work buffer
+ * @param out       Buffer for the resulting JPEG
+ * @param out_size  Size in bytes of the output buffer
+ * @param out_len   Pointer to be populated with the length of the resulting JPEG
+ *
+ * @return true on success
+ */
+bool frame2jpg_fast(camera_fb_t * fb, uint8_t quality, void *work, size_t work_len, uint8_t *out, size_t out_size, size_t *out_len);
+
 /**
  * @brief Convert image buffer to BMP buffer
  *
@@ -123,6 +172,25 @@ bool fmt2rgb888(const uint8_t *src_buf, size_t src_len, pixformat_t format, uint
 
 bool jpg2rgb565(const uint8_t *src, size_t src_len, uint8_t * out, jpg_scale_t scale);
 
+/**
+ * @brief Decode JPEG straight into a downscaled 8 bit grayscale image (model input)
+ *
+ * MCU blocks are converted to luma and box filtered into the output as the
+ * decoder emits them, the full size image is never stored. Scratch is a few
+ * output rows of accumulators. The decoder's own 1/2..1/8 scaling is used
+ * whenever the result still covers the output size.
+ *
+ * @param src           Source JPEG buffer
+ * @param src_len       Length in bytes of the source buffer
+ * @param out           Output buffer (out_width * out_height)
+ * @param out_width     Output width, any size
+ * @param out_height    Output height, any size
+ * @param keep_aspect   Centre crop the image to the output aspect ratio instead of stretching
+ *
+ * @return true on success
+ */
+bool jpg2gray_resized(const uint8_t *src, size_t src_len, uint8_t *out, uint16_t out_width, uint16_t out_height, bool keep_aspect);
+
 #ifdef __cplusplus
 }
 #endif
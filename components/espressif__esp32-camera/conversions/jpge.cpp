@@ -39,7 +39,7 @@ namespace jpge {
     static inline void jpge_free(void *p) { free(p); }
 
     // Various JPEG enums and tables.
-    enum { M_SOF0 = 0xC0, M_DHT = 0xC4, M_SOI = 0xD8, M_EOI = 0xD9, M_SOS = 0xDA, M_DQT = 0xDB, M_APP0 = 0xE0 };
+    enum { M_SOF0 = 0xC0, M_DHT = 0xC4, M_RST0 = 0xD0, M_SOI = 0xD8, M_EOI = 0xD9, M_SOS = 0xDA, M_DQT = 0xDB, M_DRI = 0xDD, M_APP0 = 0xE0 };
     enum { DC_LUM_CODES = 12, AC_LUM_CODES = 256, DC_CHROMA_CODES = 12, AC_CHROMA_CODES = 256, MAX_HUFF_SYMBOLS = 257, MAX_HUFF_CODESIZE = 32 };
 
     static const uint8 s_zag[64] = { 0,1,8,16,9,2,3,10,17,24,32,25,18,11,4,5,12,19,26,33,40,48,41,34,27,20,13,6,7,14,21,28,35,42,49,56,57,50,43,36,29,22,15,23,30,37,44,51,58,59,52,45,38,31,39,46,53,60,61,54,47,55,62,63 };
@@ -70,8 +70,31 @@ namespace jpge {
 
     const int YR = 19595, YG = 38470, YB = 7471, CB_R = -11059, CB_G = -21709, CB_B = 32768, CR_R = 32768, CR_G = -27439, CR_B = -5329;
 
-    static int32 m_last_quality = 0;
-    static int32 m_quantization_tables[2][64];
+    // AAN DCT output scale factors: 16384 * s[u] * s[v], s[0] = 1, s[k] = cos(k * pi / 16) * sqrt(2). Natural order.
+    static const uint16 s_aan_scales[64] = {
+        16384, 22725, 21407, 19266, 16384, 12873,  8867,  4520,
+        22725, 31521, 29692, 26722, 22725, 17855, 12299,  6270,
+        21407, 29692, 27969, 25172, 21407, 16819, 11585,  5906,
+        19266, 26722, 25172, 22654, 19266, 15137, 10426,  5315,
+        16384, 22725, 21407, 19266, 16384, 12873,  8867,  4520,
+        12873, 17855, 16819, 15137, 12873, 10114,  6967,  3552,
+         8867, 12299, 11585, 10426,  8867,  6967,  4799,  2446,
+         4520,  6270,  5906,  5315,  4520,  3552,  2446,  1247
+    };
+
+    // Quantization tables are derived once per quality level and kept in a small round robin cache,
+    // so alternating between a few qualities (a stream and snapshots) does not recompute them on
+    // every init. Encoders running at the same time must not use more distinct qualities than
+    // there are entries, or one of them could have its tables replaced under it.
+    enum { JPGE_QUANT_CACHE_SIZE = 4 };
+    struct quant_tables {
+        int quality;
+        uint8 q[2][64];            // zigzag order, as written to DQT
+        uint16 fast_recip[2][64];  // (1 << fast_shift) / (q * 8 * s[u] * s[v]), zigzag order
+        uint8 fast_shift[2][64];
+    };
+    static quant_tables s_quant_cache[JPGE_QUANT_CACHE_SIZE];
+    static int s_quant_cache_next = 0;
 
     static bool m_huff_initialized = false;
     static uint m_huff_codes[4][256];
@@ -147,6 +170,82 @@ namespace jpge {
         }
     }
 
+    // Forward DCT - AAN (Arai, Agui, Nakajima), derived from jfdctfst with 14 bit constants.
+    // 5 multiplies per 1D pass instead of 12; the outputs are left scaled by 8 * s[u] * s[v],
+    // which the quantizer removes (see s_aan_scales).
+    enum { AAN_BITS = 14 };
+#define AAN_MUL(var, c) (((var) * static_cast<int32>(c) + (1 << (AAN_BITS - 1))) >> AAN_BITS)
+#define AAN1D(s0, s1, s2, s3, s4, s5, s6, s7) \
+    int32 t0 = s0 + s7, t7 = s0 - s7, t1 = s1 + s6, t6 = s1 - s6, t2 = s2 + s5, t5 = s2 - s5, t3 = s3 + s4, t4 = s3 - s4; \
+    int32 t10 = t0 + t3, t13 = t0 - t3, t11 = t1 + t2, t12 = t1 - t2; \
+    int32 z1 = AAN_MUL(t12 + t13, 11585); \
+    s0 = t10 + t11; s4 = t10 - t11; s2 = t13 + z1; s6 = t13 - z1; \
+    t10 = t4 + t5; t11 = t5 + t6; t12 = t6 + t7; \
+    int32 z5 = AAN_MUL(t10 - t12, 6270); \
+    int32 z2 = AAN_MUL(t10, 8867) + z5; \
+    int32 z4 = AAN_MUL(t12, 21407) + z5; \
+    int32 z3 = AAN_MUL(t11, 11585); \
+    int32 z11 = t7 + z3, z13 = t7 - z3; \
+    s5 = z13 + z2; s3 = z13 - z2; s1 = z11 + z4; s7 = z11 - z4;
+
+    static void DCT2D_AAN(int32 *p) {
+        int32 c, *q = p;
+        for (c = 7; c >= 0; c--, q += 8) {
+            int32 s0 = q[0], s1 = q[1], s2 = q[2], s3 = q[3], s4 = q[4], s5 = q[5], s6 = q[6], s7 = q[7];
+            AAN1D(s0, s1, s2, s3, s4, s5, s6, s7);
+            q[0] = s0; q[1] = s1; q[2] = s2; q[3] = s3; q[4] = s4; q[5] = s5; q[6] = s6; q[7] = s7;
+        }
+        for (q = p, c = 7; c >= 0; c--, q++) {
+            int32 s0 = q[0*8], s1 = q[1*8], s2 = q[2*8], s3 = q[3*8], s4 = q[4*8], s5 = q[5*8], s6 = q[6*8], s7 = q[7*8];
+            AAN1D(s0, s1, s2, s3, s4, s5, s6, s7);
+            q[0*8] = s0; q[1*8] = s1; q[2*8] = s2; q[3*8] = s3; q[4*8] = s4; q[5*8] = s5; q[6*8] = s6; q[7*8] = s7;
+        }
+    }
+
+    // Quantization table generation, for both the division and the AAN reciprocal paths.
+    static void compute_quant_table(quant_tables *t, int table, int quality, const int16 *pSrc)
+    {
+        int32 q;
+        if (quality < 50)
+            q = 5000 / quality;
+        else
+            q = 200 - quality * 2;
+        for (int i = 0; i < 64; i++)
+        {
+            int32 j = pSrc[i]; j = (j * q + 50L) / 100L;
+            j = JPGE_MIN(JPGE_MAX(j, 1), 255);
+            t->q[table][i] = static_cast<uint8>(j);
+
+            // The AAN output has to be divided by q * 8 * s[u] * s[v] = d / 2048. Pick the smallest
+            // shift that gives a 16 bit reciprocal >= 2^15: |coefficient| < 2^15 keeps the product in 32 bits.
+            uint32 d = j * s_aan_scales[s_zag[i]];
+            int shift = 15;
+            while (((uint64_t)1 << (shift + 11)) / d < 32768) {
+                shift++;
+            }
+            uint64_t r = (((uint64_t)1 << (shift + 11)) + d / 2) / d;
+            t->fast_recip[table][i] = static_cast<uint16>(JPGE_MIN(r, 0xFFFF));
+            t->fast_shift[table][i] = static_cast<uint8>(shift);
+        }
+    }
+
+    static const quant_tables *get_quant_tables(int quality)
+    {
+        for (int i = 0; i < JPGE_QUANT_CACHE_SIZE; i++) {
+            if (s_quant_cache[i].quality == quality) {
+                return &s_quant_cache[i];
+            }
+        }
+        quant_tables *t = &s_quant_cache[s_quant_cache_next];
+        s_quant_cache_next = (s_quant_cache_next + 1) % JPGE_QUANT_CACHE_SIZE;
+        // quality 0 never matches, so the entry is only found once it is complete
+        t->quality = 0;
+        compute_quant_table(t, 0, quality, s_std_lum_quant);
+        compute_quant_table(t, 1, quality, s_std_croma_quant);
+        t->quality = quality;
+        return t;
+    }
+
     // Compute the actual canonical Huffman codes/code sizes given the JPEG huff bits and val arrays.
     static void compute_huffman_table(uint *codes, uint8 *code_sizes, uint8 *bits, uint8 *val)
     {
@@ -251,7 +350,7 @@ namespace jpge {
             emit_word(64 + 1 + 2);
             emit_byte(static_cast<uint8>(i));
             for (int j = 0; j < 64; j++)
-                emit_byte(static_cast<uint8>(m_quantization_tables[i][j]));
+                emit_byte(m_quant->q[i][j]);
         }
     }
 
@@ -321,6 +420,37 @@ namespace jpge {
         emit_byte(0);
     }
 
+    // Emit restart interval
+    void jpeg_encoder::emit_dri()
+    {
+        emit_marker(M_DRI);
+        emit_word(4);
+        emit_word(m_params.m_restart_interval);
+    }
+
+    // Pad to a byte boundary with 1 bits and emit RSTn, the decoder resets its DC predictions on it.
+    void jpeg_encoder::emit_restart()
+    {
+        put_bits(0x7F, 7);
+        m_bit_buffer = 0;
+        m_bits_in = 0;
+        emit_marker(M_RST0 + m_restart_num);
+        m_restart_num = (m_restart_num + 1) & 7;
+        memset(m_last_dc_val, 0, 3 * sizeof(m_last_dc_val[0]));
+    }
+
+    // Called after each coded MCU. No marker follows the last MCU of the image, EOI does.
+    void jpeg_encoder::next_mcu()
+    {
+        m_mcu_index++;
+        if (m_restarts_left && !--m_restarts_left) {
+            m_restarts_left = m_params.m_restart_interval;
+            if (m_mcu_index < m_mcu_total) {
+                emit_restart();
+            }
+        }
+    }
+
     void jpeg_encoder::load_block_8_8_grey(int x)
     {
         uint8 *pSrc;
@@ -383,7 +513,7 @@ namespace jpge {
 
     void jpeg_encoder::load_quantized_coefficients(int component_num)
     {
-        int32 *q = m_quantization_tables[component_num > 0];
+        const uint8 *q = m_quant->q[component_num > 0];
         int16 *pDst = m_coefficient_array;
         for (int i = 0; i < 64; i++)
         {
@@ -406,6 +536,20 @@ namespace jpge {
         }
     }
 
+    void jpeg_encoder::load_quantized_coefficients_fast(int component_num)
+    {
+        const uint16 *r = m_quant->fast_recip[component_num > 0];
+        const uint8 *s = m_quant->fast_shift[component_num > 0];
+        int16 *pDst = m_coefficient_array;
+        for (int i = 0; i < 64; i++)
+        {
+            sample_array_t j = m_sample_array[s_zag[i]];
+            uint32 a = (j < 0) ? -j : j;
+            int16 v = static_cast<int16>((a * r[i] + (1U << (s[i] - 1))) >> s[i]);
+            pDst[i] = (j < 0) ? -v : v;
+        }
+    }
+
     void jpeg_encoder::code_coefficients_pass_two(int component_num)
     {
         int i, j, run_len, nbits, temp1, temp2;
@@ -432,11 +576,7 @@ namespace jpge {
             temp1 = -temp1; temp2--;
         }
 
-        nbits = 0;
-        while (temp1)
-        {
-            nbits++; temp1 >>= 1;
-        }
+        nbits = temp1 ? 32 - __builtin_clz(temp1) : 0;
 
         put_bits(codes[0][nbits], code_sizes[0][nbits]);
         if (nbits) put_bits(temp2 & ((1 << nbits) - 1), nbits);
@@ -457,9 +597,7 @@ namespace jpge {
                     temp1 = -temp1;
                     temp2--;
                 }
-                nbits = 1;
-                while (temp1 >>= 1)
-                    nbits++;
+                nbits = 32 - __builtin_clz(temp1);
                 j = (run_len << 4) + nbits;
                 put_bits(codes[1][j], code_sizes[1][j]);
                 put_bits(temp2 & ((1 << nbits) - 1), nbits);
@@ -472,8 +610,13 @@ namespace jpge {
 
     void jpeg_encoder::code_block(int component_num)
     {
-        DCT2D(m_sample_array);
-        load_quantized_coefficients(component_num);
+        if (m_params.m_fast_dct) {
+            DCT2D_AAN(m_sample_array);
+            load_quantized_coefficients_fast(component_num);
+        } else {
+            DCT2D(m_sample_array);
+            load_quantized_coefficients(component_num);
+        }
         code_coefficients_pass_two(component_num);
     }
 
@@ -484,6 +627,7 @@ namespace jpge {
             for (int i = 0; i < m_mcus_per_row; i++)
             {
                 load_block_8_8_grey(i); code_block(0);
+                next_mcu();
             }
         }
         else if ((m_comp_h_samp[0] == 1) && (m_comp_v_samp[0] == 1))
@@ -491,6 +635,7 @@ namespace jpge {
             for (int i = 0; i < m_mcus_per_row; i++)
             {
                 load_block_8_8(i, 0, 0); code_block(0); load_block_8_8(i, 0, 1); code_block(1); load_block_8_8(i, 0, 2); code_block(2);
+                next_mcu();
             }
         }
         else if ((m_comp_h_samp[0] == 2) && (m_comp_v_samp[0] == 1))
@@ -499,6 +644,7 @@ namespace jpge {
             {
                 load_block_8_8(i * 2 + 0, 0, 0); code_block(0); load_block_8_8(i * 2 + 1, 0, 0); code_block(0);
                 load_block_16_8_8(i, 1); code_block(1); load_block_16_8_8(i, 2); code_block(2);
+                next_mcu();
             }
         }
         else if ((m_comp_h_samp[0] == 2) && (m_comp_v_samp[0] == 2))
@@ -508,6 +654,7 @@ namespace jpge {
                 load_block_8_8(i * 2 + 0, 0, 0); code_block(0); load_block_8_8(i * 2 + 1, 0, 0); code_block(0);
                 load_block_8_8(i * 2 + 0, 1, 0); code_block(0); load_block_8_8(i * 2 + 1, 1, 0); code_block(0);
                 load_block_16_8(i, 1); code_block(1); load_block_16_8(i, 2); code_block(2);
+                next_mcu();
             }
         }
     }
@@ -550,23 +697,20 @@ namespace jpge {
         }
     }
 
-    // Quantization table generation.
-    void jpeg_encoder::compute_quant_table(int32 *pDst, const int16 *pSrc)
+    // Higher-level methods.
+    int jpeg_encoder::get_mcu_height(const params &comp_params)
     {
-        int32 q;
-        if (m_params.m_quality < 50)
-            q = 5000 / m_params.m_quality;
-        else
-            q = 200 - m_params.m_quality * 2;
-        for (int i = 0; i < 64; i++)
-        {
-            int32 j = *pSrc++; j = (j * q + 50L) / 100L;
-            *pDst++ = JPGE_MIN(JPGE_MAX(j, 1), 255);
-        }
+        return (comp_params.m_subsampling == H2V2) ? 16 : 8;
     }
 
-    // Higher-level methods.
-    bool jpeg_encoder::jpg_open(int p_x_res, int p_y_res, int src_channels)
+    int jpeg_encoder::get_work_size(int width, const params &comp_params)
+    {
+        int mcu_x = (comp_params.m_subsampling >= H2V1) ? 16 : 8;
+        int num_components = (comp_params.m_subsampling == Y_ONLY) ? 1 : 3;
+        return ((width + mcu_x - 1) & (~(mcu_x - 1))) * num_components * get_mcu_height(comp_params);
+    }
+
+    bool jpeg_encoder::jpg_open(int p_x_res, int p_y_res, int src_channels, int first_line, int num_lines, void *pWork)
     {
         m_num_components = 3;
         switch (m_params.m_subsampling)
@@ -612,20 +756,38 @@ namespace jpge {
         m_image_bpl_mcu  = m_image_x_mcu * m_num_components;
         m_mcus_per_row   = m_image_x_mcu / m_mcu_x;
 
-        if ((m_mcu_lines[0] = static_cast<uint8*>(jpge_malloc(m_image_bpl_mcu * m_mcu_y))) == NULL) {
+        // Stripes start on a whole MCU row at a restart boundary and, unless they reach the bottom
+        // of the image, end on one too, so that the next stripe can pick up from there.
+        const int interval = m_params.m_restart_interval;
+        const int last_line = first_line + num_lines;
+        m_mcu_total = m_mcus_per_row * (m_image_y_mcu / m_mcu_y);
+        m_mcu_index = (first_line / m_mcu_y) * m_mcus_per_row;
+        m_mcu_end   = (last_line >= m_image_y) ? m_mcu_total : (last_line / m_mcu_y) * m_mcus_per_row;
+        if ((first_line < 0) || (num_lines < 1) || (last_line > m_image_y) || (first_line % m_mcu_y)) {
+            return false;
+        }
+        if (m_mcu_index && ((!interval) || (m_mcu_index % interval))) {
+            return false;
+        }
+        if ((m_mcu_end < m_mcu_total) && ((!interval) || (m_mcu_end % interval) || (last_line % m_mcu_y))) {
             return false;
         }
+        m_restarts_left = interval;
+        m_restart_num = interval ? ((m_mcu_index / interval) & 7) : 0;
+
+        if (pWork) {
+            m_mcu_lines[0] = static_cast<uint8*>(pWork);
+        } else if ((m_mcu_lines[0] = static_cast<uint8*>(jpge_malloc(m_image_bpl_mcu * m_mcu_y))) == NULL) {
+            return false;
+        } else {
+            m_mcu_lines_owned = true;
+        }
         for (int i = 1; i < m_mcu_y; i++)
             m_mcu_lines[i] = m_mcu_lines[i-1] + m_image_bpl_mcu;
 
-        if(m_last_quality != m_params.m_quality){
-            m_last_quality = m_params.m_quality;
-            compute_quant_table(m_quantization_tables[0], s_std_lum_quant);
-            compute_quant_table(m_quantization_tables[1], s_std_croma_quant);
-        }
+        m_quant = get_quant_tables(m_params.m_quality);
 
         if(!m_huff_initialized){
-            m_huff_initialized = true;
 
             memcpy(m_huff_bits[0+0], s_dc_lum_bits, 17);    memcpy(m_huff_val[0+0], s_dc_lum_val, DC_LUM_CODES);
             memcpy(m_huff_bits[2+0], s_ac_lum_bits, 17);    memcpy(m_huff_val[2+0], s_ac_lum_val, AC_LUM_CODES);
@@ -636,6 +798,7 @@ namespace jpge {
             compute_huffman_table(&m_huff_codes[2+0][0], &m_huff_code_sizes[2+0][0], m_huff_bits[2+0], m_huff_val[2+0]);
             compute_huffman_table(&m_huff_codes[0+1][0], &m_huff_code_sizes[0+1][0], m_huff_bits[0+1], m_huff_val[0+1]);
             compute_huffman_table(&m_huff_codes[2+1][0], &m_huff_code_sizes[2+1][0], m_huff_bits[2+1], m_huff_val[2+1]);
+            m_huff_initialized = true;
         }
 
         m_out_buf_left = JPGE_OUT_BUF_SIZE;
@@ -647,12 +810,17 @@ namespace jpge {
         memset(m_last_dc_val, 0, 3 * sizeof(m_last_dc_val[0]));
 
         // Emit all markers at beginning of image file.
-        emit_marker(M_SOI);
-        emit_jfif_app0();
-        emit_dqt();
-        emit_sof();
-        emit_dhts();
-        emit_sos();
+        if (first_line == 0) {
+            emit_marker(M_SOI);
+            emit_jfif_app0();
+            emit_dqt();
+            emit_sof();
+            emit_dhts();
+            if (interval) {
+                emit_dri();
+            }
+            emit_sos();
+        }
 
         return m_all_stream_writes_succeeded;
     }
@@ -668,8 +836,11 @@ namespace jpge {
             process_mcu_row();
         }
 
-        put_bits(0x7F, 7);
-        emit_marker(M_EOI);
+        // a stripe above the bottom one already ended with its RSTn marker
+        if (m_mcu_end == m_mcu_total) {
+            put_bits(0x7F, 7);
+            emit_marker(M_EOI);
+        }
         flush_output_buffer();
         m_all_stream_writes_succeeded = m_all_stream_writes_succeeded && m_pStream->put_buf(NULL, 0);
         m_pass_num++; // purposely bump up m_pass_num, for debugging
@@ -679,6 +850,7 @@ namespace jpge {
     void jpeg_encoder::clear()
     {
         m_mcu_lines[0] = NULL;
+        m_mcu_lines_owned = false;
         m_pass_num = 0;
         m_all_stream_writes_succeeded = true;
     }
@@ -694,17 +866,25 @@ namespace jpge {
     }
 
     bool jpeg_encoder::init(output_stream *pStream, int width, int height, int src_channels, const params &comp_params)
+    {
+        return init_stripe(pStream, width, height, src_channels, comp_params, 0, height);
+    }
+
+    bool jpeg_encoder::init_stripe(output_stream *pStream, int width, int height, int src_channels, const params &comp_params,
+                                   int first_line, int num_lines, void *pWork)
     {
         deinit();
         if (((!pStream) || (width < 1) || (height < 1)) || ((src_channels != 1) && (src_channels != 3) && (src_channels != 4)) || (!comp_params.check())) return false;
         m_pStream = pStream;
         m_params = comp_params;
-        return jpg_open(width, height, src_channels);
+        return jpg_open(width, height, src_channels, first_line, num_lines, pWork);
     }
 
     void jpeg_encoder::deinit()
     {
-        jpge_free(m_mcu_lines[0]);
+        if (m_mcu_lines_owned) {
+            jpge_free(m_mcu_lines[0]);
+        }
         clear();
     }
 
@@ -4,6 +4,8 @@
 #ifndef JPEG_ENCODER_H
 #define JPEG_ENCODER_H
 
+#include <stddef.h>
+
 namespace jpge
 {
     typedef unsigned char  uint8;
@@ -18,7 +20,7 @@ namespace jpge
 
     // JPEG compression parameters structure.
     struct params {
-            inline params() : m_quality(85), m_subsampling(H2V2) { }
+            inline params() : m_quality(85), m_subsampling(H2V2), m_restart_interval(0), m_fast_dct(false) { }
 
             inline bool check() const {
                 if ((m_quality < 1) || (m_quality > 100)) {
@@ -27,6 +29,9 @@ namespace jpge
                 if ((uint)m_subsampling > (uint)H2V2) {
                     return false;
                 }
+                if ((m_restart_interval < 0) || (m_restart_interval > 0xFFFF)) {
+                    return false;
+                }
                 return true;
             }
 
@@ -39,6 +44,15 @@ namespace jpge
             // 2 = H2V1 subsampling (YCbCr 2x1x1, 4 blocks per MCU)
             // 3 = H2V2 subsampling (YCbCr 4x1x1, 6 blocks per MCU-- very common)
             subsampling_t m_subsampling;
+
+            // Number of MCUs between RSTn markers, 0 disables restart markers.
+            // Stripes encoded separately can only be concatenated on a restart boundary.
+            int m_restart_interval;
+
+            // Use the fixed point AAN forward DCT, with its output scaling folded into the
+            // quantization step (one multiply and shift per coefficient instead of a divide).
+            // Output differs from the default jfdctint path by rounding only.
+            bool m_fast_dct;
     };
     
     // Output stream abstract class - used by the jpeg_encoder class to write to the output stream.
@@ -47,9 +61,12 @@ namespace jpge
         public:
             virtual ~output_stream() { };
             virtual bool put_buf(const void* Pbuf, int len) = 0;
-            virtual uint get_size() const = 0;
+            virtual size_t get_size() const = 0;
     };
     
+    // Quantization tables for one quality level, shared between encoders (see jpge.cpp).
+    struct quant_tables;
+
     // Lower level jpeg_encoder class - useful if more control is needed than the above helper functions.
     class jpeg_encoder {
         public:
@@ -64,6 +81,23 @@ namespace jpge
             // Returns false on out of memory or if a stream write fails.
             bool init(output_stream *pStream, int width, int height, int src_channels, const params &comp_params = params());
 
+            // Initializes the compressor for a horizontal stripe of the image: source lines
+            // [first_line, first_line + num_lines) of a width x height image, fed one by one to
+            // process_scanline() followed by NULL as usual.
+            // Headers are only written by the stripe starting at line 0 and EOI only by the one
+            // reaching the bottom of the image, so the outputs of all stripes concatenated in
+            // order form a single JPEG. Every stripe boundary must fall on a restart boundary
+            // (see params::m_restart_interval).
+            // pWork: get_work_size() bytes used for the MCU lines, or NULL to allocate them.
+            bool init_stripe(output_stream *pStream, int width, int height, int src_channels, const params &comp_params,
+                             int first_line, int num_lines, void *pWork = NULL);
+
+            // Bytes of work memory init_stripe() needs for an image of the given width.
+            static int get_work_size(int width, const params &comp_params);
+
+            // Number of source lines per MCU row for the given parameters (8 or 16).
+            static int get_mcu_height(const params &comp_params);
+
             // Call this method with each source scanline.
             // width * src_channels bytes per scanline is expected (RGB or Y format).
             // You must call with NULL after all scanlines are processed to finish compression.
@@ -90,7 +124,11 @@ namespace jpge
             int m_mcus_per_row;
             int m_mcu_x, m_mcu_y;
             uint8 *m_mcu_lines[16];
+            bool m_mcu_lines_owned;
             uint8 m_mcu_y_ofs;
+            int m_mcu_index, m_mcu_end, m_mcu_total;
+            int m_restarts_left, m_restart_num;
+            const quant_tables *m_quant;
             sample_array_t m_sample_array[64];
             int16 m_coefficient_array[64];
 
@@ -103,7 +141,7 @@ namespace jpge
             uint8 m_pass_num;
             bool m_all_stream_writes_succeeded;
 
-            bool jpg_open(int p_x_res, int p_y_res, int src_channels);
+            bool jpg_open(int p_x_res, int p_y_res, int src_channels, int first_line, int num_lines, void *pWork);
 
             void flush_output_buffer();
             void put_bits(uint bits, uint len);
@@ -118,9 +156,12 @@ namespace jpge
             void emit_dht(uint8 *bits, uint8 *val, int index, bool ac_flag);
             void emit_dhts();
             void emit_sos();
+            void emit_dri();
+            void emit_restart();
+            void next_mcu();
 
-            void compute_quant_table(int32 *dst, const int16 *src);
             void load_quantized_coefficients(int component_num);
+            void load_quantized_coefficients_fast(int component_num);
 
             void load_block_8_8_grey(int x);
             void load_block_8_8(int x, int y, int c);
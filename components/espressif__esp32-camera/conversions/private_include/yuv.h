@@ -0,0 +1,48 @@
+// Copyright 2015-2016 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#ifndef _CONVERSIONS_YUV_H_
+#define _CONVERSIONS_YUV_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef enum {
+    YUV422_TO_RGB888,   // R, G, B bytes (JPEG encoder input)
+    YUV422_TO_BGR888,   // B, G, R bytes (BMP, fmt2rgb888)
+    YUV422_TO_RGB565,   // big endian, same layout as PIXFORMAT_RGB565
+    YUV422_TO_GRAY,     // Y only
+} yuv422_line_format_t;
+
+void yuv2rgb(uint8_t y, uint8_t u, uint8_t v, uint8_t *r, uint8_t *g, uint8_t *b);
+
+/**
+ * @brief Convert a run of YUYV pixels, bit-exact with yuv2rgb()
+ *
+ * @param src       YUYV source (Y0 U Y1 V), 2 bytes per pixel
+ * @param dst       Destination, 3, 2 or 1 bytes per pixel depending on format
+ * @param width     Number of pixels, must be even. Whole frames can be
+ *                  converted in one call (width * height pixels)
+ * @param format    Destination layout
+ */
+void yuv422_convert_line(const uint8_t *src, uint8_t *dst, size_t width, yuv422_line_format_t format);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _CONVERSIONS_YUV_H_ */
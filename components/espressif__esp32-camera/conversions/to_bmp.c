@@ -239,6 +239,229 @@ bool jpg2bmp(const uint8_t *src, size_t src_len, uint8_t ** out, size_t * out_le
     return true;
 }
 
+typedef struct {
+        const uint8_t *input;
+        uint8_t *output;
+        uint16_t out_width;
+        uint16_t out_height;
+        bool keep_aspect;
+        uint16_t crop_x;
+        uint16_t crop_y;
+        uint16_t next_row;      // first output row not written yet
+        uint16_t col_cursor;    // first output column right of the last block
+        uint16_t acc_rows;      // accumulator ring depth
+        uint16_t *x_start;      // source span of each output column
+        uint16_t *x_end;
+        uint16_t *y_start;      // source span of each output row
+        uint16_t *y_end;
+        uint32_t *acc;          // acc_rows * out_width running sums
+} gray_jpg_decoder;
+
+/* [start, end) of the source span covered by output sample i (box filter) */
+static void _gray_span(uint16_t i, uint16_t offset, uint16_t src_len, uint16_t dst_len, uint16_t *start, uint16_t *end)
+{
+    uint32_t s = (uint32_t)i * src_len / dst_len;
+    uint32_t e = (uint32_t)(i + 1) * src_len / dst_len;
+    if (e <= s) {
+        e = s + 1;
+    }
+    *start = offset + s;
+    *end = offset + e;
+}
+
+static bool _gray_setup(gray_jpg_decoder * jpeg, uint16_t w, uint16_t h)
+{
+    uint16_t crop_w = w, crop_h = h;
+    if (jpeg->keep_aspect) {
+        // centre crop to the output aspect ratio
+        if ((uint32_t)w * jpeg->out_height > (uint32_t)h * jpeg->out_width) {
+            crop_w = (uint32_t)h * jpeg->out_width / jpeg->out_height;
+        } else {
+            crop_h = (uint32_t)w * jpeg->out_height / jpeg->out_width;
+        }
+    }
+    jpeg->crop_x = (w - crop_w) / 2;
+    jpeg->crop_y = (h - crop_h) / 2;
+
+    // a 16 row MCU band touches at most this many output rows
+    jpeg->acc_rows = (16 * jpeg->out_height + crop_h - 1) / crop_h + 1;
+
+    size_t tables = 2 * (jpeg->out_width + jpeg->out_height) * sizeof(uint16_t);
+    size_t acc = (size_t)jpeg->acc_rows * jpeg->out_width * sizeof(uint32_t);
+    uint8_t *mem = (uint8_t *)_malloc(tables + acc);
+    if (!mem) {
+        ESP_LOGE(TAG, "_malloc failed! %u", tables + acc);
+        return false;
+    }
+    jpeg->acc = (uint32_t *)mem;
+    jpeg->x_start = (uint16_t *)(mem + acc);
+    jpeg->x_end = jpeg->x_start + jpeg->out_width;
+    jpeg->y_start = jpeg->x_end + jpeg->out_width;
+    jpeg->y_end = jpeg->y_start + jpeg->out_height;
+    memset(jpeg->acc, 0, acc);
+
+    for (uint16_t i = 0; i < jpeg->out_width; i++) {
+        _gray_span(i, jpeg->crop_x, crop_w, jpeg->out_width, &jpeg->x_start[i], &jpeg->x_end[i]);
+    }
+    for (uint16_t i = 0; i < jpeg->out_height; i++) {
+        _gray_span(i, jpeg->crop_y, crop_h, jpeg->out_height, &jpeg->y_start[i], &jpeg->y_end[i]);
+    }
+    jpeg->next_row = 0;
+    jpeg->col_cursor = 0;
+    return true;
+}
+
+// write out every output row whose source span ends above `y`
+static void _gray_flush_rows(gray_jpg_decoder * jpeg, uint16_t y)
+{
+    while (jpeg->next_row < jpeg->out_height && jpeg->y_end[jpeg->next_row] <= y) {
+        uint16_t oy = jpeg->next_row;
+        uint32_t *acc = jpeg->acc + (oy % jpeg->acc_rows) * jpeg->out_width;
+        uint8_t *out = jpeg->output + (size_t)oy * jpeg->out_width;
+        uint32_t span_y = jpeg->y_end[oy] - jpeg->y_start[oy];
+        for (uint16_t ox = 0; ox < jpeg->out_width; ox++) {
+            uint32_t count = (jpeg->x_end[ox] - jpeg->x_start[ox]) * span_y;
+            out[ox] = (acc[ox] + (count >> 1)) / count;
+            acc[ox] = 0;
+        }
+        jpeg->next_row++;
+    }
+}
+
+static bool _gray_write(void * arg, uint16_t x, uint16_t y, uint16_t w, uint16_t h, uint8_t *data)
+{
+    gray_jpg_decoder * jpeg = (gray_jpg_decoder *)arg;
+    if(!data){
+        if(x == 0 && y == 0){
+            //write start
+            return _gray_setup(jpeg, w, h);
+        }
+        //write end
+        _gray_flush_rows(jpeg, UINT16_MAX);
+        return true;
+    }
+
+    if (!jpeg->acc) {
+        return false;
+    }
+    if (x == 0) {
+        jpeg->col_cursor = 0;
+    }
+
+    // MCU to luma, at most 16x16
+    uint8_t luma[16 * 16];
+    for (size_t i = 0; i < (size_t)w * h; i++, data += 3) {
+        luma[i] = (305 * data[0] + 600 * data[1] + 119 * data[2]) >> 10;
+    }
+
+    // output columns overlapping [x, x + w)
+    uint16_t ox_first = jpeg->col_cursor;
+    while (ox_first < jpeg->out_width && jpeg->x_end[ox_first] <= x) {
+        ox_first++;
+    }
+    uint16_t ox_last = ox_first;
+    while (ox_last < jpeg->out_width && jpeg->x_start[ox_last] < x + w) {
+        ox_last++;
+    }
+    jpeg->col_cursor = ox_first;
+    while (jpeg->col_cursor < ox_last && jpeg->x_end[jpeg->col_cursor] <= x + w) {
+        jpeg->col_cursor++;
+    }
+
+    // output rows overlapping [y, y + h), spans are monotonic
+    for (uint16_t oy = jpeg->next_row; oy < jpeg->out_height && jpeg->y_start[oy] < y + h; oy++) {
+        uint16_t r0 = jpeg->y_start[oy] > y ? jpeg->y_start[oy] - y : 0;
+        uint16_t r1 = jpeg->y_end[oy] < y + h ? jpeg->y_end[oy] - y : h;
+        if (r0 >= r1) {
+            continue;
+        }
+        uint32_t *acc = jpeg->acc + (oy % jpeg->acc_rows) * jpeg->out_width;
+        for (uint16_t ox = ox_first; ox < ox_last; ox++) {
+            uint16_t c0 = jpeg->x_start[ox] > x ? jpeg->x_start[ox] - x : 0;
+            uint16_t c1 = jpeg->x_end[ox] < x + w ? jpeg->x_end[ox] - x : w;
+            uint32_t sum = 0;
+            for (uint16_t r = r0; r < r1; r++) {
+                const uint8_t *row = luma + r * w;
+                for (uint16_t c = c0; c < c1; c++) {
+                    sum += row[c];
+                }
+            }
+            acc[ox] += sum;
+        }
+    }
+
+    // rows are complete once the right-most MCU of the band is in
+    if (x + w >= jpeg->x_end[jpeg->out_width - 1]) {
+        _gray_flush_rows(jpeg, y + h);
+    }
+    return true;
+}
+
+static unsigned int _gray_jpg_read(void * arg, size_t index, uint8_t *buf, size_t len)
+{
+    gray_jpg_decoder * jpeg = (gray_jpg_decoder *)arg;
+    if(buf) {
+        memcpy(buf, jpeg->input + index, len);
+    }
+    return len;
+}
+
+// width and height from the SOFn segment
+static bool _jpg_get_size(const uint8_t *src, size_t src_len, uint16_t *width, uint16_t *height)
+{
+    size_t i = 2;
+    while (i + 9 < src_len) {
+        if (src[i] != 0xFF) {
+            return false;
+        }
+        uint8_t marker = src[i + 1];
+        uint16_t seg_len = (src[i + 2] << 8) | src[i + 3];
+        if (marker >= 0xC0 && marker <= 0xCF && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+            *height = (src[i + 5] << 8) | src[i + 6];
+            *width = (src[i + 7] << 8) | src[i + 8];
+            return true;
+        }
+        i += 2 + seg_len;
+    }
+    return false;
+}
+
+bool jpg2gray_resized(const uint8_t *src, size_t src_len, uint8_t *out, uint16_t out_width, uint16_t out_height, bool keep_aspect)
+{
+    uint16_t width, height;
+    if (!out_width || !out_height || !_jpg_get_size(src, src_len, &width, &height)) {
+        return false;
+    }
+
+    // let the decoder drop DCT coefficients while the crop still covers the output
+    jpg_scale_t scale = JPG_SCALE_MAX;
+    for (; scale > JPG_SCALE_NONE; scale--) {
+        uint32_t w = width >> scale, h = height >> scale;
+        if (keep_aspect) {
+            if (w * out_height > h * out_width) {
+                w = h * out_width / out_height;
+            } else {
+                h = w * out_height / out_width;
+            }
+        }
+        if (w >= out_width && h >= out_height) {
+            break;
+        }
+    }
+
+    gray_jpg_decoder jpeg;
+    memset(&jpeg, 0, sizeof(jpeg));
+    jpeg.input = src;
+    jpeg.output = out;
+    jpeg.out_width = out_width;
+    jpeg.out_height = out_height;
+    jpeg.keep_aspect = keep_aspect;
+
+    esp_err_t ret = esp_jpg_decode(src_len, scale, _gray_jpg_read, _gray_write, (void*)&jpeg);
+    free(jpeg.acc);
+    return ret == ESP_OK;
+}
+
 bool fmt2rgb888(const uint8_t *src_buf, size_t src_len, pixformat_t format, uint8_t * rgb_buf)
 {
     int pix_count = 0;
@@ -269,25 +492,7 @@ bool fmt2rgb888(const uint8_t *src_buf, size_t src_len, pixformat_t format, uint
         }
     } else if(format == PIXFORMAT_YUV422) {
         pix_count = src_len / 2;
-        int i, maxi = pix_count / 2;
-        uint8_t y0, y1, u, v;
-        uint8_t r, g, b;
-        for(i=0; i<maxi; i++) {
-            y0 = *src_buf++;
-            u = *src_buf++;
-            y1 = *src_buf++;
-            v = *src_buf++;
-
-            yuv2rgb(y0, u, v, &r, &g, &b);
-            *rgb_buf++ = b;
-            *rgb_buf++ = g;
-            *rgb_buf++ = r;
-
-            yuv2rgb(y1, u, v, &r, &g, &b);
-            *rgb_buf++ = b;
-            *rgb_buf++ = g;
-            *rgb_buf++ = r;
-        }
+        yuv422_convert_line(src_buf, rgb_buf, pix_count, YUV422_TO_BGR888);
     }
     return true;
 }
@@ -366,25 +571,7 @@ bool fmt2bmp(uint8_t *src, size_t src_len, uint16_t width, uint16_t height, pixf
     } else if(format == PIXFORMAT_GRAYSCALE) {
         memcpy(pix_buf, src_buf, pix_count);
     } else if(format == PIXFORMAT_YUV422) {
-        int i, maxi = pix_count / 2;
-        uint8_t y0, y1, u, v;
-        uint8_t r, g, b;
-        for(i=0; i<maxi; i++) {
-            y0 = *src_buf++;
-            u = *src_buf++;
-            y1 = *src_buf++;
-            v = *src_buf++;
-
-            yuv2rgb(y0, u, v, &r, &g, &b);
-            *pix_buf++ = b;
-            *pix_buf++ = g;
-            *pix_buf++ = r;
-
-            yuv2rgb(y1, u, v, &r, &g, &b);
-            *pix_buf++ = b;
-            *pix_buf++ = g;
-            *pix_buf++ = r;
-        }
+        yuv422_convert_line(src_buf, pix_buf, pix_count, YUV422_TO_BGR888);
     }
     *out = out_buf;
     *out_len = out_size;
@@ -0,0 +1,426 @@
+// Copyright 2015-2016 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+#include <stddef.h>
+#include <string.h>
+#include "esp_attr.h"
+#include "soc/efuse_reg.h"
+#include "esp_heap_caps.h"
+#include "esp_camera.h"
+#include "img_converters.h"
+#include "jpge.h"
+#include "yuv.h"
+
+#if !CONFIG_FREERTOS_UNICORE
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#define JPG_WORKER_STACK    4096
+#endif
+
+// fmt2jpg_fast splits the frame in this many stripes, one per core. Without a second
+// core they are encoded one after the other, which the host benchmark uses for testing.
+#ifndef JPG_FAST_STRIPES
+#if CONFIG_FREERTOS_UNICORE
+#define JPG_FAST_STRIPES    1
+#else
+#define JPG_FAST_STRIPES    2
+#endif
+#endif
+
+#if defined(ARDUINO_ARCH_ESP32) && defined(CONFIG_ARDUHAL_ESP_LOG)
+#include "esp32-hal-log.h"
+#define TAG ""
+#else
+#include "esp_log.h"
+static const char* TAG = "to_jpg";
+#endif
+
+static void *_malloc(size_t size)
+{
+    void * res = malloc(size);
+    if(res) {
+        return res;
+    }
+
+    // check if SPIRAM is enabled and is allocatable
+#if (CONFIG_SPIRAM_SUPPORT && (CONFIG_SPIRAM_USE_CAPS_ALLOC || CONFIG_SPIRAM_USE_MALLOC))
+    return heap_caps_malloc(size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+#endif
+    return NULL;
+}
+
+static IRAM_ATTR void convert_line_format(uint8_t * src, pixformat_t format, uint8_t * dst, size_t width, size_t in_channels, size_t line)
+{
+    int i=0, o=0, l=0;
+    if(format == PIXFORMAT_GRAYSCALE) {
+        memcpy(dst, src + line * width, width);
+    } else if(format == PIXFORMAT_RGB888) {
+        l = width * 3;
+        src += l * line;
+        for(i=0; i<l; i+=3) {
+            dst[o++] = src[i+2];
+            dst[o++] = src[i+1];
+            dst[o++] = src[i];
+        }
+    } else if(format == PIXFORMAT_RGB565) {
+        l = width * 2;
+        src += l * line;
+        for(i=0; i<l; i+=2) {
+            dst[o++] = src[i] & 0xF8;
+            dst[o++] = (src[i] & 0x07) << 5 | (src[i+1] & 0xE0) >> 3;
+            dst[o++] = (src[i+1] & 0x1F) << 3;
+        }
+    } else if(format == PIXFORMAT_YUV422) {
+        l = width * 2;
+        yuv422_convert_line(src + l * line, dst, width, YUV422_TO_RGB888);
+    }
+}
+
+static int jpg_params(pixformat_t format, uint8_t quality, jpge::params *comp_params)
+{
+    int num_channels = 3;
+    jpge::subsampling_t subsampling = jpge::H2V2;
+
+    if(format == PIXFORMAT_GRAYSCALE) {
+        num_channels = 1;
+        subsampling = jpge::Y_ONLY;
+    }
+
+    if(!quality) {
+        quality = 1;
+    } else if(quality > 100) {
+        quality = 100;
+    }
+
+    *comp_params = jpge::params();
+    comp_params->m_subsampling = subsampling;
+    comp_params->m_quality = quality;
+    return num_channels;
+}
+
+bool convert_image(uint8_t *src, uint16_t width, uint16_t height, pixformat_t format, uint8_t quality, jpge::output_stream *dst_stream)
+{
+    jpge::params comp_params;
+    int num_channels = jpg_params(format, quality, &comp_params);
+
+    jpge::jpeg_encoder dst_image;
+
+    if (!dst_image.init(dst_stream, width, height, num_channels, comp_params)) {
+        ESP_LOGE(TAG, "JPG encoder init failed");
+        return false;
+    }
+
+    uint8_t* line = (uint8_t*)_malloc(width * num_channels);
+    if(!line) {
+        ESP_LOGE(TAG, "Scan line malloc failed");
+        return false;
+    }
+
+    for (int i = 0; i < height; i++) {
+        convert_line_format(src, format, line, width, num_channels, i);
+        if (!dst_image.process_scanline(line)) {
+            ESP_LOGE(TAG, "JPG process line %u failed", i);
+            free(line);
+            return false;
+        }
+    }
+    free(line);
+
+    if (!dst_image.process_scanline(NULL)) {
+        ESP_LOGE(TAG, "JPG image finish failed");
+        return false;
+    }
+    dst_image.deinit();
+    return true;
+}
+
+class callback_stream : public jpge::output_stream {
+protected:
+    jpg_out_cb ocb;
+    void * oarg;
+    size_t index;
+
+public:
+    callback_stream(jpg_out_cb cb, void * arg) : ocb(cb), oarg(arg), index(0) { }
+    virtual ~callback_stream() { }
+    virtual bool put_buf(const void* data, int len)
+    {
+        index += ocb(oarg, index, data, len);
+        return true;
+    }
+    virtual size_t get_size() const
+    {
+        return index;
+    }
+};
+
+bool fmt2jpg_cb(uint8_t *src, size_t src_len, uint16_t width, uint16_t height, pixformat_t format, uint8_t quality, jpg_out_cb cb, void * arg)
+{
+    callback_stream dst_stream(cb, arg);
+    return convert_image(src, width, height, format, quality, &dst_stream);
+}
+
+bool frame2jpg_cb(camera_fb_t * fb, uint8_t quality, jpg_out_cb cb, void * arg)
+{
+    return fmt2jpg_cb(fb->buf, fb->len, fb->width, fb->height, fb->format, quality, cb, arg);
+}
+
+
+
+class memory_stream : public jpge::output_stream {
+protected:
+    uint8_t *out_buf;
+    size_t max_len, index;
+    bool overflow;
+
+public:
+    memory_stream(void *pBuf, uint buf_size) : out_buf(static_cast<uint8_t*>(pBuf)), max_len(buf_size), index(0), overflow(false) { }
+
+    virtual ~memory_stream() { }
+
+    virtual bool put_buf(const void* pBuf, int len)
+    {
+        if (!pBuf) {
+            //end of image
+            return true;
+        }
+        if ((size_t)len > (max_len - index)) {
+            //ESP_LOGW(TAG, "JPG output overflow: %d bytes (%d,%d,%d)", len - (max_len - index), len, index, max_len);
+            len = max_len - index;
+            overflow = true;
+        }
+        if (len) {
+            memcpy(out_buf + index, pBuf, len);
+            index += len;
+        }
+        return true;
+    }
+
+    virtual size_t get_size() const
+    {
+        return index;
+    }
+
+    bool overflowed() const
+    {
+        return overflow;
+    }
+};
+
+bool fmt2jpg(uint8_t *src, size_t src_len, uint16_t width, uint16_t height, pixformat_t format, uint8_t quality, uint8_t ** out, size_t * out_len)
+{
+    //todo: allocate proper buffer for holding JPEG data
+    //this should be enough for CIF frame size
+    int jpg_buf_len = 128*1024;
+
+
+    uint8_t * jpg_buf = (uint8_t *)_malloc(jpg_buf_len);
+    if(jpg_buf == NULL) {
+        ESP_LOGE(TAG, "JPG buffer malloc failed");
+        return false;
+    }
+    memory_stream dst_stream(jpg_buf, jpg_buf_len);
+
+    if(!convert_image(src, width, height, format, quality, &dst_stream)) {
+        free(jpg_buf);
+        return false;
+    }
+
+    *out = jpg_buf;
+    *out_len = dst_stream.get_size();
+    return true;
+}
+
+bool frame2jpg(camera_fb_t * fb, uint8_t quality, uint8_t ** out, size_t * out_len)
+{
+    return fmt2jpg(fb->buf, fb->len, fb->width, fb->height, fb->format, quality, out, out_len);
+}
+
+typedef struct {
+    uint8_t *src;
+    uint16_t width;
+    uint16_t height;
+    pixformat_t format;
+    int num_channels;
+    jpge::params params;
+} jpg_fast_frame_t;
+
+typedef struct {
+    const jpg_fast_frame_t *frame;
+    int first_line;
+    int num_lines;
+    uint8_t *work;      // encoder MCU lines followed by one converted scan line
+    uint8_t *out;
+    size_t out_size;
+    size_t out_len;
+    bool ok;
+} jpg_fast_stripe_t;
+
+static void jpg_encode_stripe(jpg_fast_stripe_t *stripe)
+{
+    const jpg_fast_frame_t *f = stripe->frame;
+    uint8_t *line = stripe->work + jpge::jpeg_encoder::get_work_size(f->width, f->params);
+    memory_stream dst_stream(stripe->out, stripe->out_size);
+    jpge::jpeg_encoder dst_image;
+
+    bool ok = dst_image.init_stripe(&dst_stream, f->width, f->height, f->num_channels, f->params,
+                                    stripe->first_line, stripe->num_lines, stripe->work);
+    for (int i = stripe->first_line; ok && i < stripe->first_line + stripe->num_lines; i++) {
+        convert_line_format(f->src, f->format, line, f->width, f->num_channels, i);
+        ok = dst_image.process_scanline(line);
+    }
+    stripe->ok = ok && dst_image.process_scanline(NULL) && !dst_stream.overflowed();
+    stripe->out_len = dst_stream.get_size();
+}
+
+#if !CONFIG_FREERTOS_UNICORE
+static portMUX_TYPE jpg_worker_mux = portMUX_INITIALIZER_UNLOCKED;
+static bool jpg_worker_claimed = false;
+static SemaphoreHandle_t jpg_worker_lock = NULL;
+static SemaphoreHandle_t jpg_worker_done = NULL;
+static TaskHandle_t jpg_worker = NULL;
+static jpg_fast_stripe_t *jpg_worker_job = NULL;
+
+static void jpg_worker_task(void *arg)
+{
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        jpg_encode_stripe(jpg_worker_job);
+        xSemaphoreGive(jpg_worker_done);
+    }
+}
+
+// Created once by the first caller, at its priority and without affinity,
+// so that it runs on whichever core the caller is not busy on.
+static bool jpg_worker_start(void)
+{
+    portENTER_CRITICAL(&jpg_worker_mux);
+    bool create = !jpg_worker_claimed;
+    jpg_worker_claimed = true;
+    portEXIT_CRITICAL(&jpg_worker_mux);
+
+    if (create) {
+        jpg_worker_lock = xSemaphoreCreateMutex();
+        jpg_worker_done = xSemaphoreCreateBinary();
+        if (!jpg_worker_lock || !jpg_worker_done ||
+            xTaskCreate(jpg_worker_task, "jpg_worker", JPG_WORKER_STACK, NULL, uxTaskPriorityGet(NULL), &jpg_worker) != pdPASS) {
+            ESP_LOGE(TAG, "JPG worker create failed, encoding on one core");
+        }
+    }
+    return jpg_worker != NULL;
+}
+
+// Bottom stripe on the worker, top one here. Falls back to encoding both here
+// while another task has the worker.
+static void jpg_encode_stripes(jpg_fast_stripe_t *stripes)
+{
+    if (jpg_worker_start() && xSemaphoreTake(jpg_worker_lock, 0) == pdTRUE) {
+        jpg_worker_job = &stripes[1];
+        xTaskNotifyGive(jpg_worker);
+        jpg_encode_stripe(&stripes[0]);
+        xSemaphoreTake(jpg_worker_done, portMAX_DELAY);
+        xSemaphoreGive(jpg_worker_lock);
+    } else {
+        jpg_encode_stripe(&stripes[0]);
+        jpg_encode_stripe(&stripes[1]);
+    }
+}
+#elif JPG_FAST_STRIPES > 1
+static void jpg_encode_stripes(jpg_fast_stripe_t *stripes)
+{
+    jpg_encode_stripe(&stripes[0]);
+    jpg_encode_stripe(&stripes[1]);
+}
+#endif
+
+size_t fmt2jpg_fast_work_size(uint16_t width, pixformat_t format)
+{
+    jpge::params comp_params;
+    int num_channels = jpg_params(format, 1, &comp_params);
+    return JPG_FAST_STRIPES * (jpge::jpeg_encoder::get_work_size(width, comp_params) + width * num_channels);
+}
+
+bool fmt2jpg_fast(uint8_t *src, size_t src_len, uint16_t width, uint16_t height, pixformat_t format, uint8_t quality,
+                  void *work, size_t work_len, uint8_t *out, size_t out_size, size_t *out_len)
+{
+    if (work_len < fmt2jpg_fast_work_size(width, format)) {
+        ESP_LOGE(TAG, "JPG work buffer too small");
+        return false;
+    }
+
+    jpg_fast_frame_t frame;
+    frame.src = src;
+    frame.width = width;
+    frame.height = height;
+    frame.format = format;
+    frame.num_channels = jpg_params(format, quality, &frame.params);
+    frame.params.m_fast_dct = true;
+
+    jpg_fast_stripe_t stripes[2];
+    memset(stripes, 0, sizeof(stripes));
+    stripes[0].frame = &frame;
+    stripes[0].num_lines = height;
+    stripes[0].work = (uint8_t *)work;
+    stripes[0].out = out;
+    stripes[0].out_size = out_size;
+
+#if JPG_FAST_STRIPES > 1
+    // Split at the middle MCU row, with a restart interval of exactly the top half so that the
+    // only RSTn marker sits at the split. Each stripe gets output space in proportion to its lines.
+    const int mcu_height = jpge::jpeg_encoder::get_mcu_height(frame.params);
+    const int mcu_width = (frame.params.m_subsampling == jpge::Y_ONLY) ? 8 : 16;
+    const int mcu_rows = (height + mcu_height - 1) / mcu_height;
+    const int split = ((mcu_rows + 1) / 2) * mcu_height;
+    if (mcu_rows > 1) {
+        const size_t split_out = (uint64_t)out_size * split / height;
+        frame.params.m_restart_interval = ((width + mcu_width - 1) / mcu_width) * (split / mcu_height);
+
+        stripes[0].num_lines = split;
+        stripes[0].out_size = split_out;
+        stripes[1] = stripes[0];
+        stripes[1].first_line = split;
+        stripes[1].num_lines = height - split;
+        stripes[1].work = (uint8_t *)work + work_len / 2;
+        stripes[1].out = out + split_out;
+        stripes[1].out_size = out_size - split_out;
+
+        if (frame.params.check()) {
+            jpg_encode_stripes(stripes);
+            if (stripes[0].ok && stripes[1].ok) {
+                memmove(out + stripes[0].out_len, stripes[1].out, stripes[1].out_len);
+                *out_len = stripes[0].out_len + stripes[1].out_len;
+                return true;
+            }
+        }
+
+        // One half did not fit in its share of the output, retry in one piece
+        frame.params.m_restart_interval = 0;
+        stripes[0].num_lines = height;
+        stripes[0].out_size = out_size;
+    }
+#endif
+
+    jpg_encode_stripe(&stripes[0]);
+    if (!stripes[0].ok) {
+        ESP_LOGE(TAG, "JPG encode failed or output larger than %u bytes", (unsigned)out_size);
+        return false;
+    }
+    *out_len = stripes[0].out_len;
+    return true;
+}
+
+bool frame2jpg_fast(camera_fb_t * fb, uint8_t quality, void *work, size_t work_len, uint8_t *out, size_t out_size, size_t *out_len)
+{
+    return fmt2jpg_fast(fb->buf, fb->len, fb->width, fb->height, fb->format, quality, work, work_len, out, out_size, out_len);
+}
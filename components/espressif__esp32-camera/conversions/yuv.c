@@ -296,3 +296,123 @@ void IRAM_ATTR yuv2rgb(uint8_t y, uint8_t u, uint8_t v, uint8_t *r, uint8_t *g,
     *g = YUYV_CONSTRAIN(gi);
     *b = YUYV_CONSTRAIN(bi);
 }
+
+/*
+ * Batch YUYV line conversion.
+ *
+ * Same results as yuv2rgb() above: every table column is trunc(coef * (x - offset)),
+ * which Q14 coefficients with truncation toward zero reproduce exactly for
+ * all 256 inputs. Chroma terms are computed once per pixel pair, luma once
+ * per pixel, and there are no branches or table loads in the inner loop.
+ */
+#define YUV_Q       14
+#define YUV_Y       19070   // 1.164
+#define YUV_VR      26150   // 1.596
+#define YUV_VG      -6409   // -0.391
+#define YUV_UG      -13318  // -0.813
+#define YUV_UB      33062   // 2.018
+
+static inline int32_t yuv_term(int32_t coef, int32_t x)
+{
+    int32_t p = coef * x;
+    return (p + ((p >> 31) & ((1 << YUV_Q) - 1))) >> YUV_Q;
+}
+
+static inline uint8_t yuv_sat(int32_t v)
+{
+    v &= ~(v >> 31);
+    v |= (255 - v) >> 31;
+    return v;
+}
+
+typedef struct {
+    int32_t r, g, b;    // chroma terms shared by the pair
+    int32_t y0, y1;     // luma terms
+} yuv_pair_t;
+
+static inline __attribute__((always_inline)) yuv_pair_t yuv_pair(const uint8_t *src)
+{
+    yuv_pair_t p;
+    int32_t u = src[1] - 128, v = src[3] - 128;
+    p.r = yuv_term(YUV_VR, v);
+    p.g = yuv_term(YUV_UG, u) + yuv_term(YUV_VG, v);
+    p.b = yuv_term(YUV_UB, u);
+    p.y0 = yuv_term(YUV_Y, src[0] - 16);
+    p.y1 = yuv_term(YUV_Y, src[2] - 16);
+    return p;
+}
+
+static inline __attribute__((always_inline)) void yuv_pair_888(const uint8_t *src, uint8_t *dst, int bgr)
+{
+    yuv_pair_t p = yuv_pair(src);
+    int32_t c0 = bgr ? p.b : p.r, c2 = bgr ? p.r : p.b;
+    dst[0] = yuv_sat(p.y0 + c0);
+    dst[1] = yuv_sat(p.y0 + p.g);
+    dst[2] = yuv_sat(p.y0 + c2);
+    dst[3] = yuv_sat(p.y1 + c0);
+    dst[4] = yuv_sat(p.y1 + p.g);
+    dst[5] = yuv_sat(p.y1 + c2);
+}
+
+static inline __attribute__((always_inline)) void yuv_pair_565(const uint8_t *src, uint8_t *dst)
+{
+    yuv_pair_t p = yuv_pair(src);
+    uint32_t r = yuv_sat(p.y0 + p.r), g = yuv_sat(p.y0 + p.g), b = yuv_sat(p.y0 + p.b);
+    dst[0] = (r & 0xF8) | (g >> 5);
+    dst[1] = ((g << 3) & 0xE0) | (b >> 3);
+    r = yuv_sat(p.y1 + p.r);
+    g = yuv_sat(p.y1 + p.g);
+    b = yuv_sat(p.y1 + p.b);
+    dst[2] = (r & 0xF8) | (g >> 5);
+    dst[3] = ((g << 3) & 0xE0) | (b >> 3);
+}
+
+static inline __attribute__((always_inline)) void yuv_pair_gray(const uint8_t *src, uint8_t *dst)
+{
+    dst[0] = src[0];
+    dst[1] = src[2];
+}
+
+static inline __attribute__((always_inline)) void yuv_pair_rgb888(const uint8_t *src, uint8_t *dst)
+{
+    yuv_pair_888(src, dst, 0);
+}
+
+static inline __attribute__((always_inline)) void yuv_pair_bgr888(const uint8_t *src, uint8_t *dst)
+{
+    yuv_pair_888(src, dst, 1);
+}
+
+/* 8 pixels per iteration, then the remaining pairs */
+#define YUV_LINE_LOOP(out_bpp, pair_fn) do {                                \
+        for (; i + 4 <= pairs; i += 4, src += 16, dst += 8 * (out_bpp)) {   \
+            pair_fn(src, dst);                                              \
+            pair_fn(src + 4, dst + 2 * (out_bpp));                          \
+            pair_fn(src + 8, dst + 4 * (out_bpp));                          \
+            pair_fn(src + 12, dst + 6 * (out_bpp));                         \
+        }                                                                   \
+        for (; i < pairs; i++, src += 4, dst += 2 * (out_bpp)) {            \
+            pair_fn(src, dst);                                              \
+        }                                                                   \
+    } while (0)
+
+void IRAM_ATTR yuv422_convert_line(const uint8_t *src, uint8_t *dst, size_t width, yuv422_line_format_t format)
+{
+    size_t pairs = width / 2;
+    size_t i = 0;
+
+    switch (format) {
+    case YUV422_TO_GRAY:
+        YUV_LINE_LOOP(1, yuv_pair_gray);
+        break;
+    case YUV422_TO_RGB888:
+        YUV_LINE_LOOP(3, yuv_pair_rgb888);
+        break;
+    case YUV422_TO_BGR888:
+        YUV_LINE_LOOP(3, yuv_pair_bgr888);
+        break;
+    case YUV422_TO_RGB565:
+        YUV_LINE_LOOP(2, yuv_pair_565);
+        break;
+    }
+}
@@ -42,6 +42,9 @@
 static const char *TAG = "cam_hal";
 static cam_obj_t *cam_obj = NULL;
 
+// pool counters are bumped from cam_task and from the tasks taking frames
+#define CAM_STAT_INC(name) __atomic_add_fetch(&cam_obj->stats.name, 1, __ATOMIC_RELAXED)
+
 static const uint32_t JPEG_SOI_MARKER = 0xFFD8FF;  // written in little-endian for esp32
 static const uint16_t JPEG_EOI_MARKER = 0xD9FF;  // written in little-endian for esp32
 
@@ -89,6 +92,8 @@ static bool cam_get_next_frame(int * frame_pos)
 
 static bool cam_start_frame(int * frame_pos)
 {
+    // one sequence number per VSYNC, whether or not the frame gets captured
+    uint32_t seq = cam_obj->frame_seq++;
     if (cam_get_next_frame(frame_pos)) {
         if(ll_cam_start(cam_obj, *frame_pos)){
             // Vsync the frame manually
@@ -96,8 +101,15 @@ static bool cam_start_frame(int * frame_pos)
             uint64_t us = (uint64_t)esp_timer_get_time();
             cam_obj->frames[*frame_pos].fb.timestamp.tv_sec = us / 1000000UL;
             cam_obj->frames[*frame_pos].fb.timestamp.tv_usec = us % 1000000UL;
+            cam_obj->frames[*frame_pos].fb.seq = seq;
+            // crop changes only take effect between frames
+            __atomic_load(&cam_obj->crop_req, &cam_obj->crop, __ATOMIC_RELAXED);
+            cam_obj->frames[*frame_pos].fb.width = cam_obj->crop.width;
+            cam_obj->frames[*frame_pos].fb.height = cam_obj->crop.height;
             return true;
         }
+    } else {
+        CAM_STAT_INC(missed);
     }
     return false;
 }
@@ -111,11 +123,37 @@ void IRAM_ATTR ll_cam_send_event(cam_obj_t *cam, cam_event_t cam_event, BaseType
     }
 }
 
+//Copy DMA half buffer `cnt` of the frame to out, only the crop window when one is set
+static size_t cam_copy_dma_buffer(uint8_t *out, int cnt)
+{
+    const uint8_t *in = &cam_obj->dma_buffer[(cnt % cam_obj->dma_half_buffer_cnt) * cam_obj->dma_half_buffer_size];
+    if (!cam_obj->crop.width) {
+        return ll_cam_memcpy(cam_obj, out, in, cam_obj->dma_half_buffer_size);
+    }
+    //outside JPEG mode a half buffer holds whole lines
+    size_t line_size = cam_obj->width * cam_obj->in_bytes_per_pixel * cam_obj->dma_bytes_per_item;
+    size_t lines = cam_obj->dma_half_buffer_size / line_size;
+    size_t first = cnt * lines;
+    size_t start = cam_obj->crop.y > first ? cam_obj->crop.y : first;
+    size_t end = cam_obj->crop.y + cam_obj->crop.height;
+    if (end > first + lines) {
+        end = first + lines;
+    }
+    in += cam_obj->crop.x * cam_obj->in_bytes_per_pixel * cam_obj->dma_bytes_per_item;
+    size_t crop_size = cam_obj->crop.width * cam_obj->in_bytes_per_pixel * cam_obj->dma_bytes_per_item;
+    size_t len = 0;
+    for (size_t line = start; line < end; line++) {
+        len += ll_cam_memcpy(cam_obj, out + len, in + (line - first) * line_size, crop_size);
+    }
+    return len;
+}
+
 //Copy fram from DMA dma_buffer to fram dma_buffer
 static void cam_task(void *arg)
 {
     int cnt = 0;
     int frame_pos = 0;
+    bool overrun = false;
     cam_obj->state = CAM_STATE_IDLE;
     cam_event_t cam_event = 0;
 
@@ -134,6 +172,7 @@ static void cam_task(void *arg)
                         cam_obj->state = CAM_STATE_READ_BUF;
                     }
                     cnt = 0;
+                    overrun = false;
                 }
             }
             break;
@@ -146,17 +185,20 @@ static void cam_task(void *arg)
                     if(!cam_obj->psram_mode){
                         if (cam_obj->fb_size < (frame_buffer_event->len + pixels_per_dma)) {
                             ESP_LOGW(TAG, "FB-OVF");
+                            if (!overrun) {
+                                overrun = true;
+                                CAM_STAT_INC(overrun);
+                            }
                             ll_cam_stop(cam_obj);
                             DBG_PIN_SET(0);
                             continue;
                         }
-                        frame_buffer_event->len += ll_cam_memcpy(cam_obj,
-                            &frame_buffer_event->buf[frame_buffer_event->len],
-                            &cam_obj->dma_buffer[(cnt % cam_obj->dma_half_buffer_cnt) * cam_obj->dma_half_buffer_size],
-                            cam_obj->dma_half_buffer_size);
+                        frame_buffer_event->len += cam_copy_dma_buffer(&frame_buffer_event->buf[frame_buffer_event->len], cnt);
                     }
                     //Check for JPEG SOI in the first buffer. stop if not found
-                    if (cam_obj->jpeg_mode && cnt == 0 && cam_verify_jpeg_soi(frame_buffer_event->buf, frame_buffer_event->len) != 0) {
+                    //in psram mode the DMA wrote it straight to the frame buffer and len is not updated yet
+                    if (cam_obj->jpeg_mode && cnt == 0 && cam_verify_jpeg_soi(frame_buffer_event->buf,
+                            cam_obj->psram_mode ? cam_obj->dma_half_buffer_size : frame_buffer_event->len) != 0) {
                         ll_cam_stop(cam_obj);
                         cam_obj->state = CAM_STATE_IDLE;
                     }
@@ -171,12 +213,13 @@ static void cam_task(void *arg)
                             if (!cam_obj->psram_mode) {
                                 if (cam_obj->fb_size < (frame_buffer_event->len + pixels_per_dma)) {
                                     ESP_LOGW(TAG, "FB-OVF");
+                                    if (!overrun) {
+                                        overrun = true;
+                                        CAM_STAT_INC(overrun);
+                                    }
                                     cnt--;
                                 } else {
-                                    frame_buffer_event->len += ll_cam_memcpy(cam_obj,
-                                        &frame_buffer_event->buf[frame_buffer_event->len],
-                                        &cam_obj->dma_buffer[(cnt % cam_obj->dma_half_buffer_cnt) * cam_obj->dma_half_buffer_size],
-                                        cam_obj->dma_half_buffer_size);
+                                    frame_buffer_event->len += cam_copy_dma_buffer(&frame_buffer_event->buf[frame_buffer_event->len], cnt);
                                 }
                             }
                             cnt++;
@@ -187,17 +230,34 @@ static void cam_task(void *arg)
                         if (cam_obj->psram_mode) {
                             if (cam_obj->jpeg_mode) {
                                 frame_buffer_event->len = cnt * cam_obj->dma_half_buffer_size;
+                                if (frame_buffer_event->len > cam_obj->fb_size) {
+                                    //the descriptors wrapped around and overwrote the start of the frame
+                                    ESP_LOGW(TAG, "FB-OVF");
+                                    if (!overrun) {
+                                        overrun = true;
+                                        CAM_STAT_INC(overrun);
+                                    }
+                                    cam_obj->frames[frame_pos].en = 1;
+                                }
                             } else {
                                 frame_buffer_event->len = cam_obj->recv_size;
                             }
                         } else if (!cam_obj->jpeg_mode) {
-                            if (frame_buffer_event->len != cam_obj->fb_size) {
+                            size_t fb_size = cam_obj->fb_size;
+                            if (cam_obj->crop.width) {
+                                fb_size = cam_obj->crop.width * cam_obj->crop.height * cam_obj->fb_bytes_per_pixel;
+                            }
+                            if (frame_buffer_event->len != fb_size) {
                                 cam_obj->frames[frame_pos].en = 1;
-                                ESP_LOGE(TAG, "FB-SIZE: %u != %u", frame_buffer_event->len, (unsigned) cam_obj->fb_size);
+                                ESP_LOGE(TAG, "FB-SIZE: %u != %u", frame_buffer_event->len, (unsigned) fb_size);
                             }
                         }
                         //send frame
-                        if(!cam_obj->frames[frame_pos].en && xQueueSend(cam_obj->frame_buffer_queue, (void *)&frame_buffer_event, 0) != pdTRUE) {
+                        if(cam_obj->frames[frame_pos].en) {
+                            //frame rejected above
+                        } else if(xQueueSend(cam_obj->frame_buffer_queue, (void *)&frame_buffer_event, 0) == pdTRUE) {
+                            CAM_STAT_INC(frames);
+                        } else {
                             //pop frame buffer from the queue
                             camera_fb_t * fb2 = NULL;
                             if(xQueueReceive(cam_obj->frame_buffer_queue, &fb2, 0) == pdTRUE) {
@@ -205,9 +265,12 @@ static void cam_task(void *arg)
                                 if (xQueueSend(cam_obj->frame_buffer_queue, (void *)&frame_buffer_event, 0) != pdTRUE) {
                                     cam_obj->frames[frame_pos].en = 1;
                                     ESP_LOGE(TAG, "FBQ-SND");
+                                } else {
+                                    CAM_STAT_INC(frames);
                                 }
                                 //free the popped buffer
                                 cam_give(fb2);
+                                CAM_STAT_INC(dropped);
                             } else {
                                 //queue is full and we could not pop a frame from it
                                 cam_obj->frames[frame_pos].en = 1;
@@ -222,6 +285,7 @@ static void cam_task(void *arg)
                         cam_obj->frames[frame_pos].fb.len = 0;
                     }
                     cnt = 0;
+                    overrun = false;
                 }
             }
             break;
@@ -473,7 +537,7 @@ void cam_start(void)
     ll_cam_vsync_intr_enable(cam_obj, true);
 }
 
-camera_fb_t *cam_take(TickType_t timeout)
+static camera_fb_t *cam_take_frame(TickType_t timeout, bool latest)
 {
     camera_fb_t *dma_buffer = NULL;
     TickType_t start = xTaskGetTickCount();
@@ -483,11 +547,20 @@ camera_fb_t *cam_take(TickType_t timeout)
     // GDMA to fall into a strange state if it is running while WiFi STA is connecting.
     // This code tries to reset GDMA if frame is not received, to try and help with
     // this case. It is possible to have some side effects too, though none come to mind
-    if (!dma_buffer) {
+    if (!dma_buffer && timeout) {
         ll_cam_dma_reset(cam_obj);
         xQueueReceive(cam_obj->frame_buffer_queue, (void *)&dma_buffer, timeout);
     }
 #endif
+    if (dma_buffer && latest) {
+        // keep only the newest queued frame, the others go back to the pool unread
+        camera_fb_t *newer = NULL;
+        while (xQueueReceive(cam_obj->frame_buffer_queue, (void *)&newer, 0) == pdTRUE) {
+            cam_give(dma_buffer);
+            CAM_STAT_INC(dropped);
+            dma_buffer = newer;
+        }
+    }
     if (dma_buffer) {
         if(cam_obj->jpeg_mode){
             // find the end marker for JPEG. Data after that can be discarded
@@ -503,14 +576,14 @@ camera_fb_t *cam_take(TickType_t timeout)
                 if (ticks_spent >= timeout) {
                     return NULL; /* We are out of time */
                 }
-                return cam_take(timeout - ticks_spent);//recurse!!!!
+                return cam_take_frame(timeout - ticks_spent, latest);//recurse!!!!
             }
         } else if(cam_obj->psram_mode && cam_obj->in_bytes_per_pixel != cam_obj->fb_bytes_per_pixel){
             //currently this is used only for YUV to GRAYSCALE
             dma_buffer->len = ll_cam_memcpy(cam_obj, dma_buffer->buf, dma_buffer->buf, dma_buffer->len);
         }
         return dma_buffer;
-    } else {
+    } else if (timeout) {
         ESP_LOGW(TAG, "Failed to get the frame on time!");
 // #if CONFIG_IDF_TARGET_ESP32S3
 //         ll_cam_dma_print_state(cam_obj);
@@ -519,6 +592,16 @@ camera_fb_t *cam_take(TickType_t timeout)
     return NULL;
 }
 
+camera_fb_t *cam_take(TickType_t timeout)
+{
+    return cam_take_frame(timeout, false);
+}
+
+camera_fb_t *cam_take_latest(TickType_t timeout)
+{
+    return cam_take_frame(timeout, true);
+}
+
 void cam_give(camera_fb_t *dma_buffer)
 {
     for (int x = 0; x < cam_obj->frame_cnt; x++) {
@@ -534,3 +617,28 @@ void cam_give_all(void) {
         cam_obj->frames[x].en = 1;
     }
 }
+
+esp_err_t cam_set_crop(const camera_roi_t *roi)
+{
+    camera_roi_t crop = {0};
+    if (roi && roi->width) {
+        CAM_CHECK(roi->height && roi->x + roi->width <= cam_obj->width && roi->y + roi->height <= cam_obj->height,
+                  "crop outside the frame", ESP_ERR_INVALID_ARG);
+        CAM_CHECK(!(roi->x % CAM_CROP_ALIGN) && !(roi->width % CAM_CROP_ALIGN), "crop not aligned", ESP_ERR_INVALID_ARG);
+        CAM_CHECK(!cam_obj->jpeg_mode && !cam_obj->psram_mode, "no frame copy to crop in", ESP_ERR_NOT_SUPPORTED);
+#if CONFIG_CAMERA_CONVERTER_ENABLED
+        CAM_CHECK(cam_obj->conv_mode == CONV_DISABLE, "no crop with the converter", ESP_ERR_NOT_SUPPORTED);
+#endif
+        crop = *roi;
+    }
+    __atomic_store(&cam_obj->crop_req, &crop, __ATOMIC_RELAXED);
+    return ESP_OK;
+}
+
+void cam_get_stats(camera_fb_stats_t *stats)
+{
+    stats->frames = __atomic_load_n(&cam_obj->stats.frames, __ATOMIC_RELAXED);
+    stats->dropped = __atomic_load_n(&cam_obj->stats.dropped, __ATOMIC_RELAXED);
+    stats->overrun = __atomic_load_n(&cam_obj->stats.overrun, __ATOMIC_RELAXED);
+    stats->missed = __atomic_load_n(&cam_obj->stats.missed, __ATOMIC_RELAXED);
+}
@@ -81,6 +81,7 @@ static const char *TAG = "camera";
 typedef struct {
     sensor_t sensor;
     camera_fb_t fb;
+    bool sensor_roi;    // the sensor window is zoomed on a region, see esp_camera_set_roi()
 } camera_state_t;
 
 static const char *CAMERA_SENSOR_NVS_KEY = "sensor";
@@ -358,21 +359,96 @@ esp_err_t esp_camera_deinit()
 
 #define FB_GET_TIMEOUT (4000 / portTICK_PERIOD_MS)
 
-camera_fb_t *esp_camera_fb_get()
+static camera_fb_t *esp_camera_fb_set_properties(camera_fb_t *fb)
 {
-    if (s_state == NULL) {
-        return NULL;
-    }
-    camera_fb_t *fb = cam_take(FB_GET_TIMEOUT);
     //set the frame properties
     if (fb) {
-        fb->width = resolution[s_state->sensor.status.framesize].width;
-        fb->height = resolution[s_state->sensor.status.framesize].height;
+        // cropped frames come with their size, the others have the sensor's
+        if (!fb->width) {
+            fb->width = resolution[s_state->sensor.status.framesize].width;
+            fb->height = resolution[s_state->sensor.status.framesize].height;
+        }
         fb->format = s_state->sensor.pixformat;
     }
     return fb;
 }
 
+camera_fb_t *esp_camera_fb_get()
+{
+    if (s_state == NULL) {
+        return NULL;
+    }
+    return esp_camera_fb_set_properties(cam_take(FB_GET_TIMEOUT));
+}
+
+camera_fb_t *esp_camera_fb_get_latest(void)
+{
+    if (s_state == NULL) {
+        return NULL;
+    }
+    return esp_camera_fb_set_properties(cam_take_latest(FB_GET_TIMEOUT));
+}
+
+camera_fb_t *esp_camera_fb_try_get(void)
+{
+    if (s_state == NULL) {
+        return NULL;
+    }
+    return esp_camera_fb_set_properties(cam_take(0));
+}
+
+esp_err_t esp_camera_fb_get_stats(camera_fb_stats_t *stats)
+{
+    if (s_state == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (stats == NULL) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    cam_get_stats(stats);
+    return ESP_OK;
+}
+
+esp_err_t esp_camera_set_roi(const camera_roi_t *roi)
+{
+    if (s_state == NULL) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    sensor_t *s = &s_state->sensor;
+    const uint16_t width = resolution[s->status.framesize].width;
+    const uint16_t height = resolution[s->status.framesize].height;
+    if (roi && (!roi->width || !roi->height || roi->x + roi->width > width || roi->y + roi->height > height)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (roi == NULL || (roi->width == width && roi->height == height)) {
+        if (s_state->sensor_roi) {
+            s_state->sensor_roi = false;
+            if (s->set_framesize(s, s->status.framesize) != 0) {
+                return ESP_ERR_CAMERA_FAILED_TO_SET_FRAME_SIZE;
+            }
+        }
+        return cam_set_crop(NULL);
+    }
+
+    if (s->set_roi && s->set_roi(s, roi->x, roi->y, roi->width, roi->height) == 0) {
+        s_state->sensor_roi = true;
+        return cam_set_crop(NULL);
+    }
+    if (s_state->sensor_roi) {
+        // the region is too small for the sensor, crop the whole sensor view instead
+        s_state->sensor_roi = false;
+        if (s->set_framesize(s, s->status.framesize) != 0) {
+            return ESP_ERR_CAMERA_FAILED_TO_SET_FRAME_SIZE;
+        }
+    }
+    camera_roi_t crop = *roi;
+    uint16_t right = roi->x + roi->width;
+    crop.x &= ~(CAM_CROP_ALIGN - 1);
+    right = (right + CAM_CROP_ALIGN - 1) & ~(CAM_CROP_ALIGN - 1);
+    crop.width = (right > width ? width : right) - crop.x;
+    return cam_set_crop(&crop);
+}
+
 void esp_camera_fb_return(camera_fb_t *fb)
 {
     if (s_state == NULL) {
@@ -167,8 +167,29 @@ typedef struct {
     size_t height;              /*!< Height of the buffer in pixels */
     pixformat_t format;         /*!< Format of the pixel data */
     struct timeval timestamp;   /*!< Timestamp since boot of the first DMA buffer of the frame */
+    uint32_t seq;               /*!< Sensor frame number since init, gaps are frames that were not delivered */
 } camera_fb_t;
 
+/**
+ * @brief Frame buffer pool counters, since the driver was initialized
+ */
+typedef struct {
+    uint32_t frames;            /*!< Frames handed to the frame queue */
+    uint32_t dropped;           /*!< Queued frames discarded unread for a newer one (CAMERA_GRAB_LATEST or esp_camera_fb_get_latest) */
+    uint32_t overrun;           /*!< Frames lost because they did not fit in the frame buffer (FB-OVF) */
+    uint32_t missed;            /*!< Sensor frames not captured because every frame buffer was in use */
+} camera_fb_stats_t;
+
+/**
+ * @brief Rectangle of the frame, in pixels of the configured frame size
+ */
+typedef struct {
+    uint16_t x;
+    uint16_t y;
+    uint16_t width;
+    uint16_t height;
+} camera_roi_t;
+
 #define ESP_ERR_CAMERA_BASE 0x20000
 #define ESP_ERR_CAMERA_NOT_DETECTED             (ESP_ERR_CAMERA_BASE + 1)
 #define ESP_ERR_CAMERA_FAILED_TO_SET_FRAME_SIZE (ESP_ERR_CAMERA_BASE + 2)
@@ -216,6 +237,60 @@ camera_fb_t* esp_camera_fb_get(void);
  */
 void esp_camera_fb_return(camera_fb_t * fb);
 
+/**
+ * @brief Obtain pointer to the newest frame buffer.
+ *
+ * Every older frame waiting in the queue is returned to the pool unread (and counted as dropped),
+ * so with CAMERA_GRAB_LATEST the frame is at most one frame period old. Waits for the next
+ * frame when none is queued.
+ *
+ * @return pointer to the frame buffer, NULL on timeout
+ */
+camera_fb_t* esp_camera_fb_get_latest(void);
+
+/**
+ * @brief Obtain pointer to a frame buffer without waiting.
+ *
+ * @return pointer to the oldest queued frame buffer, NULL if none is ready
+ */
+camera_fb_t* esp_camera_fb_try_get(void);
+
+/**
+ * @brief Read the frame buffer pool counters.
+ *
+ * @param stats Populated with the counters
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_STATE if the driver hasn't been initialized yet
+ *      - ESP_ERR_INVALID_ARG if stats is NULL
+ */
+esp_err_t esp_camera_fb_get_stats(camera_fb_stats_t *stats);
+
+/**
+ * @brief Restrict the captured image to a region of interest.
+ *
+ * Sensors that can window their array (OV2640) scale the region up to the
+ * configured frame size, frames keep their size and show the region at a
+ * higher resolution. Otherwise the driver copies only the region out of the
+ * DMA buffer, frames are then roi->width x roi->height, with x and width
+ * rounded to multiples of 4 pixels. Frame copy cropping is not available in
+ * JPEG mode or when the DMA writes straight to PSRAM (16 MHz XCLK on
+ * ESP32-S2/S3). Check fb->width and fb->height of the returned frames.
+ *
+ * The change applies from the next frame the sensor starts, frames already
+ * captured keep the previous region.
+ *
+ * @param roi Region in the configured frame size, NULL for the whole frame
+ *
+ * @return
+ *      - ESP_OK on success
+ *      - ESP_ERR_INVALID_STATE if the driver hasn't been initialized yet
+ *      - ESP_ERR_INVALID_ARG if the region is empty or outside the frame
+ *      - ESP_ERR_NOT_SUPPORTED if neither the sensor nor the driver can crop in this mode
+ */
+esp_err_t esp_camera_set_roi(const camera_roi_t *roi);
+
 /**
  * @brief Get a pointer to the image sensor control structure
  *
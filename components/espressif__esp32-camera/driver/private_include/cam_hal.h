@@ -21,6 +21,9 @@
 extern "C" {
 #endif
 
+// horizontal granularity of cam_set_crop(), the DMA filters convert 4 pixels at a time
+#define CAM_CROP_ALIGN 4
+
 /**
  * @brief Uninitialize the lcd_cam module
  *
@@ -53,10 +56,26 @@ void cam_start(void);
 
 camera_fb_t *cam_take(TickType_t timeout);
 
+camera_fb_t *cam_take_latest(TickType_t timeout);
+
 void cam_give(camera_fb_t *dma_buffer);
 
 void cam_give_all(void);
 
+void cam_get_stats(camera_fb_stats_t *stats);
+
+/**
+ * @brief Crop the following frames while they are copied out of the DMA buffer
+ *
+ * @param roi Region to keep, x and width multiples of CAM_CROP_ALIGN, NULL for the whole frame
+ *
+ * @return
+ *     - ESP_OK Success
+ *     - ESP_ERR_INVALID_ARG Region outside the frame or not aligned
+ *     - ESP_ERR_NOT_SUPPORTED JPEG, psram or converter mode, where frames are not copied line by line
+ */
+esp_err_t cam_set_crop(const camera_roi_t *roi);
+
 #ifdef __cplusplus
 }
 #endif
@@ -208,43 +208,69 @@ static int set_window(sensor_t *sensor, ov2640_sensor_mode_t mode, int offset_x,
     return ret;
 }
 
-static int set_framesize(sensor_t *sensor, framesize_t framesize)
+//sensor array window of a frame size, in the units of the mode that outputs it
+static ov2640_sensor_mode_t get_window(framesize_t framesize, uint16_t *offset_x, uint16_t *offset_y, uint16_t *max_x, uint16_t *max_y)
 {
-    int ret = 0;
-    uint16_t w = resolution[framesize].width;
-    uint16_t h = resolution[framesize].height;
     aspect_ratio_t ratio = resolution[framesize].aspect_ratio;
-    uint16_t max_x = ratio_table[ratio].max_x;
-    uint16_t max_y = ratio_table[ratio].max_y;
-    uint16_t offset_x = ratio_table[ratio].offset_x;
-    uint16_t offset_y = ratio_table[ratio].offset_y;
     ov2640_sensor_mode_t mode = OV2640_MODE_UXGA;
-
-    sensor->status.framesize = framesize;
-
-
+    *max_x = ratio_table[ratio].max_x;
+    *max_y = ratio_table[ratio].max_y;
+    *offset_x = ratio_table[ratio].offset_x;
+    *offset_y = ratio_table[ratio].offset_y;
 
     if (framesize <= FRAMESIZE_CIF) {
         mode = OV2640_MODE_CIF;
-        max_x /= 4;
-        max_y /= 4;
-        offset_x /= 4;
-        offset_y /= 4;
-        if(max_y > 296){
-            max_y = 296;
+        *max_x /= 4;
+        *max_y /= 4;
+        *offset_x /= 4;
+        *offset_y /= 4;
+        if(*max_y > 296){
+            *max_y = 296;
         }
     } else if (framesize <= FRAMESIZE_SVGA) {
         mode = OV2640_MODE_SVGA;
-        max_x /= 2;
-        max_y /= 2;
-        offset_x /= 2;
-        offset_y /= 2;
+        *max_x /= 2;
+        *max_y /= 2;
+        *offset_x /= 2;
+        *offset_y /= 2;
     }
+    return mode;
+}
+
+static int set_framesize(sensor_t *sensor, framesize_t framesize)
+{
+    int ret = 0;
+    uint16_t w = resolution[framesize].width;
+    uint16_t h = resolution[framesize].height;
+    uint16_t max_x, max_y, offset_x, offset_y;
+    ov2640_sensor_mode_t mode = get_window(framesize, &offset_x, &offset_y, &max_x, &max_y);
+
+    sensor->status.framesize = framesize;
 
     ret = set_window(sensor, mode, offset_x, offset_y, max_x, max_y, w, h);
     return ret;
 }
 
+//zoom the DSP on a part of the frame, the output keeps the frame size
+static int set_roi(sensor_t *sensor, int x, int y, int width, int height)
+{
+    framesize_t framesize = sensor->status.framesize;
+    uint16_t w = resolution[framesize].width;
+    uint16_t h = resolution[framesize].height;
+    uint16_t max_x, max_y, offset_x, offset_y;
+    ov2640_sensor_mode_t mode = get_window(framesize, &offset_x, &offset_y, &max_x, &max_y);
+
+    //window sizes are set in steps of 4 and the zoom only scales down
+    int win_w = (width * max_x / w) & ~3;
+    int win_h = (height * max_y / h) & ~3;
+    if (win_w < w || win_h < h) {
+        return -1;
+    }
+    offset_x += x * max_x / w;
+    offset_y += y * max_y / h;
+    return set_window(sensor, mode, offset_x, offset_y, win_w, win_h, w, h);
+}
+
 static int set_contrast(sensor_t *sensor, int level)
 {
     int ret=0;
@@ -605,6 +631,7 @@ int ov2640_init(sensor_t *sensor)
     sensor->get_reg = get_reg;
     sensor->set_reg = set_reg;
     sensor->set_res_raw = set_res_raw;
+    sensor->set_roi = set_roi;
     sensor->set_pll = _set_pll;
     sensor->set_xclk = set_xclk;
     ESP_LOGD(TAG, "OV2640 Attached");
@@ -141,6 +141,13 @@ typedef struct {
     uint32_t fb_size;
 
     cam_state_t state;
+
+    uint32_t frame_seq;
+    camera_fb_stats_t stats;
+
+    //frame copy crop, cam_set_crop() requests it and cam_task picks it up at frame start
+    camera_roi_t crop_req __attribute__((aligned(8)));
+    camera_roi_t crop;//of the frame being captured, width 0 for the whole frame
 } cam_obj_t;
 
 
@@ -0,0 +1,376 @@
+// Copyright 2015-2024 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Runs the unmodified driver/cam_hal.c on the host against the simulated
+ * ll_cam backend in ll_cam_sim.c. Each scenario captures frames through
+ * cam_take()/cam_give(), checks every delivered byte against what the
+ * "sensor" sent and compares the driver counters with what the scenario
+ * is meant to provoke (FB-OVF, JPEG truncation, dropped frames).
+ *
+ * Scenarios with pclk 0 ("max") hand cam_task the next DMA chunk as soon as
+ * it has handled the previous event, their MB/s is the frame assembly
+ * throughput of cam_task itself. Build from the component root:
+ *
+ *   gcc -O2 -g -pthread -Idriver/include -Idriver/private_include \
+ *       -Itarget/private_include -Iconversions/include -Itest/host \
+ *       driver/cam_hal.c driver/sensor.c test/host/ll_cam_sim.c \
+ *       test/host/freertos_sim.c test/host/cam_hal_sim.c -o cam_hal_sim
+ *   ./cam_hal_sim [-p pclk_hz] [-r recording.mjpeg]
+ *
+ * -p changes the pixel clock of the paced scenarios, -r replays the JPEG
+ * frames found in a file (for example the test/pictures JPEGs concatenated) instead
+ * of the synthetic ones in the JPEG scenarios.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "cam_hal.h"      // brings the real esp_camera.h, not the stand-in next to this file
+#include "ll_cam_sim.h"
+
+#define JPEG_FB_SIZE    (320 * 240 / 5)     // QVGA with CONFIG_CAMERA_JPEG_MODE_FRAME_SIZE_AUTO
+
+typedef struct {
+    const char *name;
+    pixformat_t format;
+    bool psram_mode;                // 16 MHz XCLK selects it on ESP32-S3
+    camera_grab_mode_t grab_mode;
+    uint8_t fb_count;
+    uint32_t pclk_hz;               // 0: as fast as cam_task goes
+    size_t jpeg_len;                // synthetic JPEG size, alternates with jpeg_len / 2 when jpeg_vary
+    bool jpeg_vary;
+    bool take_latest;               // cam_take_latest() instead of cam_take()
+    uint32_t consumer_ms;           // time the application keeps each frame
+    uint32_t frames;                // stop after this many good frames
+    uint32_t duration_ms;           // or after this long
+    // what the scenario is meant to show
+    bool expect_frames;
+    bool expect_overrun;
+    bool expect_dropped;
+    bool expect_missed;
+    bool report_only;               // nothing to expect from a recording
+    camera_roi_t crop;              // cam_set_crop() before starting, width 0 for none
+    bool crop_toggle;               // switch the crop on and off every few frames while capturing
+} scenario_t;
+
+static const scenario_t scenarios[] = {
+    // name                  format               psram  grab mode               fb  pclk      jpeg   vary   latest ms   frames ms    frames overrun dropped missed
+    {"rgb565 copy",          PIXFORMAT_RGB565,    false, CAMERA_GRAB_LATEST,     2, 0,        0,     false, false, 0,  200, 3000, true,  false, false, false},
+    {"yuv->gray copy",       PIXFORMAT_GRAYSCALE, false, CAMERA_GRAB_LATEST,     2, 0,        0,     false, false, 0,  200, 3000, true,  false, false, false},
+    {"rgb565 psram",         PIXFORMAT_RGB565,    true,  CAMERA_GRAB_LATEST,     2, 0,        0,     false, false, 0,  200, 3000, true,  false, false, false},
+    {"jpeg copy",            PIXFORMAT_JPEG,      false, CAMERA_GRAB_WHEN_EMPTY, 2, 20000000, 12000, false, false, 0,  100, 3000, true,  false, false, false},
+    {"jpeg copy vary",       PIXFORMAT_JPEG,      false, CAMERA_GRAB_WHEN_EMPTY, 2, 20000000, 14000, true,  false, 0,  100, 3000, true,  false, false, false},
+    {"jpeg psram",           PIXFORMAT_JPEG,      true,  CAMERA_GRAB_WHEN_EMPTY, 2, 20000000, 12000, false, false, 0,  100, 3000, true,  false, false, false},
+    {"jpeg copy oversize",   PIXFORMAT_JPEG,      false, CAMERA_GRAB_WHEN_EMPTY, 2, 20000000, 20000, false, false, 0,  1,   300,  false, true,  false, false},
+    {"jpeg psram oversize",  PIXFORMAT_JPEG,      true,  CAMERA_GRAB_WHEN_EMPTY, 2, 20000000, 20000, false, false, 0,  1,   300,  false, true,  false, false},
+    // a held frame leaves no free buffer: cam_take() returns frames captured before the previous one was returned
+    {"rgb565 slow take",     PIXFORMAT_RGB565,    false, CAMERA_GRAB_LATEST,     3, 20000000, 0,     false, false, 30, 20,  3000, true,  false, false, true},
+    {"rgb565 slow latest",   PIXFORMAT_RGB565,    false, CAMERA_GRAB_LATEST,     3, 20000000, 0,     false, true,  30, 20,  3000, true,  false, true,  true},
+    // crop while copying out of the DMA buffer, the toggling one checks that a change never tears a frame
+    {"yuv->gray crop",       PIXFORMAT_GRAYSCALE, false, CAMERA_GRAB_LATEST,     2, 0,        0,     false, false, 0,  200, 3000, true,  false, false, false, false, {100, 50, 96, 96}},
+    {"rgb565 crop toggle",   PIXFORMAT_RGB565,    false, CAMERA_GRAB_LATEST,     2, 0,        0,     false, false, 0,  200, 3000, true,  false, false, false, false, {4, 131, 312, 17}, true},
+};
+
+typedef struct {
+    const scenario_t *scenario;
+    size_t raw_len;
+    uint8_t **replay;               // recorded JPEG frames, NULL for synthetic ones
+    size_t *replay_len;
+    size_t replay_cnt;
+} source_t;
+
+static double now_ms(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/* two sensor bytes per pixel, both `pixel * 3 + index` so any tearing between frames shows */
+static size_t raw_frame(uint32_t index, uint8_t *buf, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        buf[i] = (uint8_t) ((i >> 1) * 3 + index);
+    }
+    return len;
+}
+
+static size_t jpeg_len(const scenario_t *s, uint32_t index)
+{
+    return s->jpeg_vary && (index & 1) ? s->jpeg_len / 2 : s->jpeg_len;
+}
+
+/* SOI, APP0, index, filler without 0xFF, EOI */
+static size_t jpeg_frame(const scenario_t *s, uint32_t index, uint8_t *buf)
+{
+    size_t len = jpeg_len(s, index);
+    static const uint8_t soi[] = {0xFF, 0xD8, 0xFF, 0xE0};
+    memcpy(buf, soi, sizeof(soi));
+    memcpy(buf + 4, &index, sizeof(index));
+    for (size_t i = 8; i < len - 2; i++) {
+        buf[i] = (uint8_t) ((i * 13 + index) % 251);
+    }
+    buf[len - 2] = 0xFF;
+    buf[len - 1] = 0xD9;
+    return len;
+}
+
+static size_t sensor_frame(uint32_t index, uint8_t *buf, size_t size, void *arg)
+{
+    source_t *src = (source_t *) arg;
+    if (src->scenario->format != PIXFORMAT_JPEG) {
+        return raw_frame(index, buf, src->raw_len);
+    }
+    if (src->replay) {
+        size_t i = index % src->replay_cnt;
+        memcpy(buf, src->replay[i], src->replay_len[i]);
+        return src->replay_len[i];
+    }
+    return jpeg_frame(src->scenario, index, buf);
+}
+
+/* fb->width is only set by cam_hal for cropped frames, the others are the whole QVGA frame */
+static bool check_raw(const camera_fb_t *fb, size_t bpp, const camera_roi_t *crop)
+{
+    const size_t width = resolution[FRAMESIZE_QVGA].width;
+    camera_roi_t roi = {0, 0, width, resolution[FRAMESIZE_QVGA].height};
+    if (fb->width) {
+        if (fb->width != crop->width || fb->height != crop->height) {
+            return false;
+        }
+        roi = *crop;
+    }
+    if (fb->len != (size_t) roi.width * roi.height * bpp) {
+        return false;
+    }
+    const uint8_t *p = fb->buf;
+    uint8_t index = p[0] - (roi.y * width + roi.x) * 3;
+    for (size_t y = roi.y; y < roi.y + roi.height; y++) {
+        uint8_t value = (y * width + roi.x) * 3 + index;
+        for (size_t x = 0; x < roi.width; x++, value += 3) {
+            for (size_t b = 0; b < bpp; b++) {
+                if (*p++ != value) {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+static bool check_jpeg(const camera_fb_t *fb, const source_t *src)
+{
+    if (src->replay) {
+        for (size_t i = 0; i < src->replay_cnt; i++) {
+            if (fb->len == src->replay_len[i] && !memcmp(fb->buf, src->replay[i], fb->len)) {
+                return true;
+            }
+        }
+        return false;
+    }
+    static uint8_t expected[64 * 1024];
+    uint32_t index;
+    if (fb->len < 8) {
+        return false;
+    }
+    memcpy(&index, fb->buf + 4, sizeof(index));
+    if (jpeg_len(src->scenario, index) > sizeof(expected)) {
+        return false;
+    }
+    size_t len = jpeg_frame(src->scenario, index, expected);
+    return fb->len == len && !memcmp(fb->buf, expected, len);
+}
+
+static int run_scenario(const scenario_t *s, source_t *src)
+{
+    camera_config_t config = {
+        .pin_vsync = -1,
+        .xclk_freq_hz = s->psram_mode ? 16000000 : 20000000,
+        .pixel_format = s->format,
+        .frame_size = FRAMESIZE_QVGA,
+        .fb_count = s->fb_count,
+        .fb_location = CAMERA_FB_IN_PSRAM,
+        .grab_mode = s->grab_mode,
+    };
+    const size_t pixels = resolution[FRAMESIZE_QVGA].width * resolution[FRAMESIZE_QVGA].height;
+    const size_t fb_bpp = s->format == PIXFORMAT_GRAYSCALE ? 1 : 2;
+    size_t max_frame_len = pixels * 2;
+    if (s->format == PIXFORMAT_JPEG) {
+        max_frame_len = s->jpeg_len;
+        for (size_t i = 0; src->replay && i < src->replay_cnt; i++) {
+            max_frame_len = src->replay_len[i] > max_frame_len ? src->replay_len[i] : max_frame_len;
+        }
+    }
+    src->scenario = s;
+    src->raw_len = pixels * 2;
+
+    ll_cam_sim_config_t sim = {
+        .pclk_hz = s->pclk_hz,
+        .vblank_us = 500,
+        .max_frame_len = max_frame_len,
+        .frame_cb = sensor_frame,
+        .arg = src,
+    };
+    ll_cam_sim_configure(&sim);
+    if (cam_init(&config) != ESP_OK || cam_config(&config, FRAMESIZE_QVGA, OV2640_PID) != ESP_OK) {
+        printf("%-21s init failed\n", s->name);
+        return 1;
+    }
+
+    if (s->crop.width && cam_set_crop(&s->crop) != ESP_OK) {
+        printf("%-21s crop rejected\n", s->name);
+        cam_deinit();
+        return 1;
+    }
+
+    uint32_t good = 0, bad = 0, timeouts = 0, gaps = 0, last_seq = 0, cropped = 0;
+    cam_start();
+    double t0 = now_ms();
+    while (good < s->frames && now_ms() - t0 < s->duration_ms) {
+        camera_fb_t *fb = s->take_latest ? cam_take_latest(pdMS_TO_TICKS(100)) : cam_take(pdMS_TO_TICKS(100));
+        if (fb == NULL) {
+            timeouts++;
+            continue;
+        }
+        bool ok = s->format == PIXFORMAT_JPEG ? check_jpeg(fb, src) : check_raw(fb, fb_bpp, &s->crop);
+        if (ok) {
+            good++;
+            cropped += fb->width != 0;
+        } else {
+            bad++;
+        }
+        if (s->crop_toggle && !(good % 5)) {
+            cam_set_crop((good / 5) & 1 ? NULL : &s->crop);
+        }
+        if (good + bad > 1 && fb->seq != last_seq + 1) {
+            gaps++;
+        }
+        last_seq = fb->seq;
+        if (s->consumer_ms) {
+            vTaskDelay(pdMS_TO_TICKS(s->consumer_ms));
+        }
+        cam_give(fb);
+    }
+    double elapsed = now_ms() - t0;
+    cam_stop();
+
+    camera_fb_stats_t stats;
+    ll_cam_sim_counters_t counters;
+    cam_get_stats(&stats);
+    ll_cam_sim_get_counters(&counters);
+    cam_deinit();
+
+    bool pass = bad == 0 || (s->jpeg_vary && !src->replay);
+    pass &= s->expect_frames ? good > 0 : good == 0;
+    pass &= s->expect_overrun ? stats.overrun > 0 : stats.overrun == 0;
+    pass &= !s->expect_dropped || stats.dropped > 0;
+    pass &= !s->expect_missed || stats.missed > 0;
+    pass &= s->crop.width ? cropped > 0 && (cropped < good) == s->crop_toggle : cropped == 0;
+
+    char pclk[16];
+    if (s->pclk_hz) {
+        snprintf(pclk, sizeof(pclk), "%5.1f MHz", s->pclk_hz / 1e6);
+    } else {
+        snprintf(pclk, sizeof(pclk), "%9s", "max");
+    }
+    printf("%-21s %s | %6.1f fps %7.1f MB/s | good %4u bad %3u timeout %3u gap %3u | "
+           "frames %4u dropped %3u overrun %3u missed %4u | %s\n",
+           s->name, pclk, stats.frames * 1e3 / elapsed, counters.dma_bytes / 1e3 / elapsed,
+           (unsigned) good, (unsigned) bad, (unsigned) timeouts, (unsigned) gaps,
+           (unsigned) stats.frames, (unsigned) stats.dropped, (unsigned) stats.overrun, (unsigned) stats.missed,
+           s->report_only ? "-" : pass ? "ok" : "FAIL");
+    return pass || s->report_only ? 0 : 1;
+}
+
+/* every SOI..EOI span of the file */
+static size_t load_recording(const char *path, source_t *src)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return 0;
+    }
+    fseek(f, 0, SEEK_END);
+    size_t len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *data = malloc(len);
+    if (fread(data, 1, len, f) != len) {
+        len = 0;
+    }
+    fclose(f);
+
+    size_t cnt = 0;
+    for (size_t i = 0; i + 3 < len; i++) {
+        if (data[i] != 0xFF || data[i + 1] != 0xD8 || data[i + 2] != 0xFF) {
+            continue;
+        }
+        size_t end = i + 2;
+        while (end + 1 < len && !(data[end] == 0xFF && data[end + 1] == 0xD9)) {
+            end++;
+        }
+        if (end + 1 >= len) {
+            break;
+        }
+        src->replay = realloc(src->replay, (cnt + 1) * sizeof(uint8_t *));
+        src->replay_len = realloc(src->replay_len, (cnt + 1) * sizeof(size_t));
+        src->replay[cnt] = data + i;
+        src->replay_len[cnt] = end + 2 - i;
+        cnt++;
+        i = end + 1;
+    }
+    src->replay_cnt = cnt;
+    return cnt;
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t pclk_hz = 0;
+    source_t src = {0};
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "-p")) {
+            pclk_hz = strtoul(argv[i + 1], NULL, 0);
+        } else if (!strcmp(argv[i], "-r")) {
+            if (!load_recording(argv[i + 1], &src)) {
+                printf("no JPEG frames in %s\n", argv[i + 1]);
+                return 1;
+            }
+            printf("replaying %u frames from %s\n", (unsigned) src.replay_cnt, argv[i + 1]);
+        }
+    }
+
+    int failures = 0;
+    printf("QVGA, JPEG frame buffer %d bytes\n", JPEG_FB_SIZE);
+    for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        scenario_t s = scenarios[i];
+        if (pclk_hz && s.pclk_hz) {
+            // dropped and missed frames depend on the frame rate, the defaults are tuned for 20 MHz
+            s.pclk_hz = pclk_hz;
+            s.expect_dropped = false;
+            s.expect_missed = false;
+        }
+        if (src.replay && s.format == PIXFORMAT_JPEG) {
+            // the recording decides the sizes, only report what happens to it
+            if (s.jpeg_vary || s.expect_overrun) {
+                continue;
+            }
+            s.frames = 50;
+            s.report_only = true;
+        }
+        failures += run_scenario(&s, &src);
+    }
+    return failures;
+}
@@ -0,0 +1,16 @@
+// Host build stand-in for the IDF header, see cam_hal_sim.c
+#pragma once
+
+#include <stdint.h>
+
+// same layout as the ROM descriptor, `empty` can't hold a host pointer and is never followed
+typedef struct lldesc_s {
+    volatile uint32_t size  : 12,
+                      length: 12,
+                      offset: 5,
+                      sosf  : 1,
+                      eof   : 1,
+                      owner : 1;
+    volatile uint8_t *buf;
+    volatile uint32_t empty;
+} lldesc_t;
@@ -0,0 +1,6 @@
+// Host build stand-in for the IDF header, see yuv422_bench.c
+#pragma once
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define DRAM_STR(str) (str)
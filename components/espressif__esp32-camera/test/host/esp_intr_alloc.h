@@ -0,0 +1,4 @@
+// Host build stand-in for the IDF header, see cam_hal_sim.c
+#pragma once
+
+typedef void *intr_handle_t;
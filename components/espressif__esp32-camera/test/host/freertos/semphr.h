@@ -0,0 +1,6 @@
+// Host build stand-in for the IDF header, see cam_hal_sim.c
+#pragma once
+
+#include "freertos/queue.h"
+
+typedef QueueHandle_t SemaphoreHandle_t;
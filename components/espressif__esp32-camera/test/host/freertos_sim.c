@@ -0,0 +1,244 @@
+// Copyright 2015-2024 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * The few FreeRTOS calls the camera driver makes, on top of pthreads. Tasks
+ * only honour vTaskDelete() while blocked in xQueueReceive(), which is where
+ * cam_task always sits when cam_deinit() deletes it. See cam_hal_sim.c.
+ */
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+struct sim_queue {
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    uint8_t *items;
+    UBaseType_t item_size;
+    UBaseType_t length;
+    UBaseType_t head;
+    UBaseType_t count;
+    UBaseType_t receivers;
+};
+
+struct sim_task {
+    pthread_t thread;
+    TaskFunction_t func;
+    void *arg;
+};
+
+static void deadline_after(struct timespec *ts, TickType_t ticks)
+{
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    uint64_t ns = (uint64_t) ticks * (1000000000ULL / configTICK_RATE_HZ) + ts->tv_nsec;
+    ts->tv_sec += ns / 1000000000ULL;
+    ts->tv_nsec = ns % 1000000000ULL;
+}
+
+/* false on timeout, the queue lock is held on return either way */
+static bool queue_wait(struct sim_queue *q, pthread_cond_t *cond, const struct timespec *deadline)
+{
+    if (deadline == NULL) {
+        return pthread_cond_wait(cond, &q->lock) == 0;
+    }
+    return pthread_cond_timedwait(cond, &q->lock, deadline) != ETIMEDOUT;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    struct sim_queue *q = calloc(1, sizeof(struct sim_queue));
+    if (q == NULL) {
+        return NULL;
+    }
+    q->items = malloc(length * item_size);
+    if (q->items == NULL) {
+        free(q);
+        return NULL;
+    }
+    q->length = length;
+    q->item_size = item_size;
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&q->not_empty, &attr);
+    pthread_cond_init(&q->not_full, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_mutex_init(&q->lock, NULL);
+    return q;
+}
+
+void vQueueDelete(QueueHandle_t q)
+{
+    pthread_cond_destroy(&q->not_empty);
+    pthread_cond_destroy(&q->not_full);
+    pthread_mutex_destroy(&q->lock);
+    free(q->items);
+    free(q);
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *item, TickType_t timeout)
+{
+    struct timespec deadline;
+    if (timeout != portMAX_DELAY) {
+        deadline_after(&deadline, timeout);
+    }
+    pthread_mutex_lock(&q->lock);
+    while (q->count == q->length) {
+        if (timeout == 0 || !queue_wait(q, &q->not_full, timeout == portMAX_DELAY ? NULL : &deadline)) {
+            pthread_mutex_unlock(&q->lock);
+            return pdFALSE;
+        }
+    }
+    memcpy(q->items + ((q->head + q->count) % q->length) * q->item_size, item, q->item_size);
+    q->count++;
+    pthread_cond_signal(&q->not_empty);
+    pthread_mutex_unlock(&q->lock);
+    return pdTRUE;
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t q, const void *item, BaseType_t *woken)
+{
+    if (woken) {
+        *woken = pdFALSE;
+    }
+    return xQueueSend(q, item, 0);
+}
+
+static void queue_receive_cancelled(void *arg)
+{
+    struct sim_queue *q = (struct sim_queue *) arg;
+    q->receivers--;
+    pthread_mutex_unlock(&q->lock);
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *item, TickType_t timeout)
+{
+    struct timespec deadline;
+    BaseType_t ret = pdTRUE;
+    int cancel_state;
+    if (timeout != portMAX_DELAY) {
+        deadline_after(&deadline, timeout);
+    }
+    pthread_mutex_lock(&q->lock);
+    q->receivers++;
+    pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, &cancel_state);
+    pthread_cleanup_push(queue_receive_cancelled, q);
+    while (q->count == 0) {
+        if (timeout == 0 || !queue_wait(q, &q->not_empty, timeout == portMAX_DELAY ? NULL : &deadline)) {
+            ret = pdFALSE;
+            break;
+        }
+    }
+    pthread_cleanup_pop(0);
+    pthread_setcancelstate(cancel_state, NULL);
+    q->receivers--;
+    if (ret == pdTRUE) {
+        memcpy(item, q->items + q->head * q->item_size, q->item_size);
+        q->head = (q->head + 1) % q->length;
+        q->count--;
+        pthread_cond_signal(&q->not_full);
+    }
+    pthread_mutex_unlock(&q->lock);
+    return ret;
+}
+
+BaseType_t xQueueReset(QueueHandle_t q)
+{
+    pthread_mutex_lock(&q->lock);
+    q->head = 0;
+    q->count = 0;
+    pthread_cond_broadcast(&q->not_full);
+    pthread_mutex_unlock(&q->lock);
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q)
+{
+    pthread_mutex_lock(&q->lock);
+    UBaseType_t count = q->count;
+    pthread_mutex_unlock(&q->lock);
+    return count;
+}
+
+bool sim_queue_drained(QueueHandle_t q)
+{
+    pthread_mutex_lock(&q->lock);
+    bool drained = q->count == 0 && q->receivers > 0;
+    pthread_mutex_unlock(&q->lock);
+    return drained;
+}
+
+static void *task_entry(void *arg)
+{
+    struct sim_task *task = (struct sim_task *) arg;
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+    task->func(task->arg);
+    return NULL;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t func, const char *name, uint32_t stack_depth, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *handle, BaseType_t core_id)
+{
+    (void) stack_depth;
+    (void) priority;
+    (void) core_id;
+    struct sim_task *task = calloc(1, sizeof(struct sim_task));
+    if (task == NULL) {
+        return pdFAIL;
+    }
+    task->func = func;
+    task->arg = arg;
+    if (pthread_create(&task->thread, NULL, task_entry, task) != 0) {
+        free(task);
+        return pdFAIL;
+    }
+    pthread_setname_np(task->thread, name);
+    if (handle) {
+        *handle = task;
+    }
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if (task == NULL) {
+        pthread_exit(NULL);
+    }
+    pthread_cancel(task->thread);
+    pthread_join(task->thread, NULL);
+    free(task);
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    struct timespec deadline;
+    deadline_after(&deadline, ticks);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR) {
+    }
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (TickType_t) ((uint64_t) ts.tv_sec * configTICK_RATE_HZ + ts.tv_nsec / (1000000000 / configTICK_RATE_HZ));
+}
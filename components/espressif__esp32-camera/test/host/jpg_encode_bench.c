@@ -0,0 +1,240 @@
+// Copyright 2015-2024 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Host check and benchmark of fmt2jpg_fast() against fmt2jpg(). Both outputs
+ * are decoded back with tjpgd and compared to the source. The host has no
+ * second core, JPG_FAST_STRIPES=2 still encodes two stripes (one after the
+ * other) so that the restart marker join gets decoded. Build from the
+ * component root:
+ *
+ *   gcc -O2 -c -Itest/host -Iconversions/private_include -Itarget/jpeg_include \
+ *       conversions/yuv.c target/tjpgd.c
+ *   g++ -O2 -DCONFIG_FREERTOS_UNICORE=1 -DJPG_FAST_STRIPES=2 -Itest/host \
+ *       -Iconversions/include -Iconversions/private_include -Itarget/jpeg_include \
+ *       -x c test/host/jpg_encode_bench.c -x c++ conversions/to_jpg.cpp \
+ *       conversions/jpge.cpp -x none yuv.o tjpgd.o -lm -o jpg_encode_bench
+ *   ./jpg_encode_bench [test/pictures/test_outside.jpeg]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include "img_converters.h"
+#include "tjpgd.h"
+
+#define RUNS        20
+#define QUALITY     80
+#define POOL_SIZE   8192    // tjpgd needs more than the 3100 bytes used on target with 64 bit pointers
+
+typedef struct {
+    const uint8_t *data;
+    size_t len;
+    size_t index;
+    uint8_t *rgb;
+    size_t width;
+} decode_ctx_t;
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static UINT decode_input(JDEC *jd, BYTE *buf, UINT len)
+{
+    decode_ctx_t *ctx = (decode_ctx_t *)jd->device;
+    if (len > ctx->len - ctx->index) {
+        len = ctx->len - ctx->index;
+    }
+    if (buf) {
+        memcpy(buf, ctx->data + ctx->index, len);
+    }
+    ctx->index += len;
+    return len;
+}
+
+static UINT decode_output(JDEC *jd, void *bitmap, JRECT *rect)
+{
+    decode_ctx_t *ctx = (decode_ctx_t *)jd->device;
+    const uint8_t *src = (const uint8_t *)bitmap;
+    size_t w = (rect->right - rect->left + 1) * 3;
+    for (int y = rect->top; y <= rect->bottom; y++, src += w) {
+        memcpy(ctx->rgb + (y * ctx->width + rect->left) * 3, src, w);
+    }
+    return 1;
+}
+
+/* RGB888 of the whole image, NULL if tjpgd rejects it */
+static uint8_t *decode(const uint8_t *jpg, size_t len, size_t *width, size_t *height)
+{
+    static uint8_t pool[POOL_SIZE];
+    decode_ctx_t ctx = {jpg, len, 0, NULL, 0};
+    JDEC jd;
+    if (jd_prepare(&jd, decode_input, pool, POOL_SIZE, &ctx) != JDR_OK) {
+        return NULL;
+    }
+    ctx.width = jd.width;
+    ctx.rgb = malloc(jd.width * jd.height * 3);
+    if (jd_decomp(&jd, decode_output, 0) != JDR_OK) {
+        free(ctx.rgb);
+        return NULL;
+    }
+    *width = jd.width;
+    *height = jd.height;
+    return ctx.rgb;
+}
+
+static uint8_t *load_file(const char *path, size_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    *len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *buf = malloc(*len);
+    if (fread(buf, 1, *len, f) != *len) {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(f);
+    return buf;
+}
+
+static uint8_t clamp(int v)
+{
+    return v < 0 ? 0 : (v > 255 ? 255 : v);
+}
+
+/* camera frame in `format` from RGB888, and the RGB888 the decoder should give back */
+static uint8_t *make_frame(const uint8_t *rgb, size_t pixels, pixformat_t format, uint8_t *expected)
+{
+    uint8_t *frame = malloc(pixels * 2 + 2);
+    for (size_t i = 0; i < pixels; i++) {
+        int r = rgb[3 * i], g = rgb[3 * i + 1], b = rgb[3 * i + 2];
+        int y = (77 * r + 150 * g + 29 * b + 128) >> 8;
+        if (format == PIXFORMAT_RGB565) {
+            frame[2 * i] = (r & 0xF8) | (g >> 5);
+            frame[2 * i + 1] = ((g << 3) & 0xE0) | (b >> 3);
+            r &= 0xF8; g &= 0xFC; b &= 0xF8;
+        } else if (format == PIXFORMAT_YUV422) {
+            /* chroma of the even pixel of each pair, the comparison uses the full colour source */
+            frame[2 * i] = y;
+            if (!(i & 1)) {
+                frame[2 * i + 1] = clamp(128 + ((-43 * r - 85 * g + 128 * b) >> 8));
+                frame[2 * i + 3] = clamp(128 + ((128 * r - 107 * g - 21 * b) >> 8));
+            }
+        } else {
+            frame[i] = y;
+            r = g = b = y;
+        }
+        expected[3 * i] = r;
+        expected[3 * i + 1] = g;
+        expected[3 * i + 2] = b;
+    }
+    return frame;
+}
+
+static double psnr(const uint8_t *a, const uint8_t *b, size_t n)
+{
+    double se = 0;
+    for (size_t i = 0; i < n; i++) {
+        double d = (double)a[i] - b[i];
+        se += d * d;
+    }
+    return se ? 10 * log10(255.0 * 255.0 * n / se) : 99;
+}
+
+int main(int argc, char **argv)
+{
+    const char *path = argc > 1 ? argv[1] : "test/pictures/test_outside.jpeg";
+    size_t jpg_len, width, height;
+    uint8_t *jpg = load_file(path, &jpg_len);
+    uint8_t *rgb = jpg ? decode(jpg, jpg_len, &width, &height) : NULL;
+    if (!rgb) {
+        printf("can't read %s\n", path);
+        return 1;
+    }
+
+    const size_t pixels = width * height;
+    const size_t out_size = 256 * 1024;
+    uint8_t *expected = malloc(pixels * 3);
+    uint8_t *out = malloc(out_size);
+    int failures = 0;
+
+    printf("%zu x %zu, quality %d, %d runs\n", width, height, QUALITY, RUNS);
+    const pixformat_t formats[] = {PIXFORMAT_RGB565, PIXFORMAT_YUV422, PIXFORMAT_GRAYSCALE};
+    const char *names[] = {"rgb565", "yuv422", "gray"};
+    for (int f = 0; f < 3; f++) {
+        uint8_t *frame = make_frame(rgb, pixels, formats[f], expected);
+        const size_t frame_len = pixels * (formats[f] == PIXFORMAT_GRAYSCALE ? 1 : 2);
+        size_t work_len = fmt2jpg_fast_work_size(width, formats[f]);
+        uint8_t *work = malloc(work_len);
+
+        uint8_t *ref_jpg = NULL;
+        size_t ref_len = 0, fast_len = 0;
+        double t_ref = 0, t_fast = 0;
+        for (int i = 0; i < RUNS; i++) {
+            free(ref_jpg);
+            double t0 = now_us();
+            fmt2jpg(frame, frame_len, width, height, formats[f], QUALITY, &ref_jpg, &ref_len);
+            double t1 = now_us();
+            if (!fmt2jpg_fast(frame, frame_len, width, height, formats[f], QUALITY, work, work_len, out, out_size, &fast_len)) {
+                printf("%-6s fmt2jpg_fast failed\n", names[f]);
+                failures++;
+                break;
+            }
+            t_fast += now_us() - t1;
+            t_ref += t1 - t0;
+        }
+
+        size_t w, h;
+        double mb = frame_len * RUNS / 1e6;
+        if (formats[f] == PIXFORMAT_GRAYSCALE) {
+            /* tjpgd only decodes three component images */
+            printf("%-6s jpge %7.1f MB/s %6zu bytes          | fast %7.1f MB/s %6zu bytes          | %.2fx\n",
+                   names[f], mb / (t_ref / 1e6), ref_len, mb / (t_fast / 1e6), fast_len, t_ref / t_fast);
+            free(ref_jpg);
+            free(work);
+            free(frame);
+            continue;
+        }
+        uint8_t *ref_rgb = decode(ref_jpg, ref_len, &w, &h);
+        uint8_t *fast_rgb = decode(out, fast_len, &w, &h);
+        if (!ref_rgb || !fast_rgb) {
+            printf("%-6s decode failed\n", names[f]);
+            failures++;
+        } else {
+            printf("%-6s jpge %7.1f MB/s %6zu bytes %5.2f dB | fast %7.1f MB/s %6zu bytes %5.2f dB | %.2fx\n",
+                   names[f], mb / (t_ref / 1e6), ref_len, psnr(ref_rgb, expected, pixels * 3),
+                   mb / (t_fast / 1e6), fast_len, psnr(fast_rgb, expected, pixels * 3), t_ref / t_fast);
+        }
+        free(ref_rgb);
+        free(fast_rgb);
+        free(ref_jpg);
+        free(work);
+        free(frame);
+    }
+
+    free(out);
+    free(expected);
+    free(rgb);
+    free(jpg);
+    return failures;
+}
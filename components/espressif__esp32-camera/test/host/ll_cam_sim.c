@@ -0,0 +1,444 @@
+// Copyright 2015-2024 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * ll_cam backend for the host. A "sensor" thread plays the part of the
+ * camera, the LCD_CAM peripheral and the GDMA channel of the ESP32-S3:
+ *
+ *  - every frame starts with a VSYNC interrupt in the middle of vblank_us
+ *    of silence, followed by the frame bytes at pclk_hz,
+ *  - bytes only land in memory while the DMA runs (between ll_cam_start()
+ *    and ll_cam_stop()), wherever in the frame that happens to be,
+ *  - in copy mode the DMA fills the dma_buffer ring and raises in_suc_eof
+ *    every dma_half_buffer_size bytes, in psram mode it writes the frame
+ *    buffer through its circular descriptor list, with in_suc_eof for JPEG
+ *    only, exactly like the real descriptors wrap around,
+ *  - interrupts go through ll_cam_send_event(), so event queue overflows
+ *    take the same path as on target.
+ *
+ * DMA sizes follow target/esp32s3/ll_cam.c.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sched.h>
+#include <pthread.h>
+#include <time.h>
+#include "ll_cam.h"
+#include "cam_hal.h"
+#include "ll_cam_sim.h"
+
+static const char *TAG = "sim ll_cam";
+
+static struct {
+    ll_cam_sim_config_t config;
+    ll_cam_sim_counters_t counters;
+    pthread_mutex_t lock;           // the "interrupt lock", recursive as ll_cam_send_event() may call ll_cam_stop()
+    pthread_t thread;
+    bool running;
+    volatile bool quit;
+    cam_obj_t *cam;
+    bool vsync_en;
+    bool eof_en;
+    bool dma_run;
+    int frame_pos;
+    size_t dma_pos;                 // bytes written since ll_cam_start()
+} s_sim;
+
+void ll_cam_sim_configure(const ll_cam_sim_config_t *config)
+{
+    s_sim.config = *config;
+}
+
+void ll_cam_sim_get_counters(ll_cam_sim_counters_t *counters)
+{
+    pthread_mutex_lock(&s_sim.lock);
+    *counters = s_sim.counters;
+    pthread_mutex_unlock(&s_sim.lock);
+}
+
+static void sim_deadline_add(struct timespec *t, uint64_t ns)
+{
+    ns += t->tv_nsec;
+    t->tv_sec += ns / 1000000000ULL;
+    t->tv_nsec = ns % 1000000000ULL;
+}
+
+/* sleep until the deadline, spinning for the last stretch as the host timer is too coarse for 1KB chunks */
+static void sim_wait_until(const struct timespec *deadline)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    int64_t left = (deadline->tv_sec - now.tv_sec) * 1000000000LL + (deadline->tv_nsec - now.tv_nsec);
+    if (left > 200000) {
+        struct timespec wake = *deadline;
+        wake.tv_nsec -= 100000;
+        if (wake.tv_nsec < 0) {
+            wake.tv_nsec += 1000000000L;
+            wake.tv_sec--;
+        }
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL) == EINTR) {
+        }
+    }
+    do {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+    } while (now.tv_sec < deadline->tv_sec || (now.tv_sec == deadline->tv_sec && now.tv_nsec < deadline->tv_nsec));
+}
+
+/* unthrottled mode: hold the bus until cam_task has handled every event */
+static void sim_wait_drained(void)
+{
+    while (!s_sim.quit) {
+        pthread_mutex_lock(&s_sim.lock);
+        // once cam_stop() ran the queues may be gone
+        bool drained = !s_sim.vsync_en || sim_queue_drained(s_sim.cam->event_queue);
+        pthread_mutex_unlock(&s_sim.lock);
+        if (drained) {
+            return;
+        }
+        sched_yield();
+    }
+}
+
+static void sim_send_event(cam_event_t event)
+{
+    BaseType_t woken = pdFALSE;
+    if (event == CAM_VSYNC_EVENT) {
+        s_sim.counters.vsync_events++;
+    } else {
+        s_sim.counters.eof_events++;
+    }
+    ll_cam_send_event(s_sim.cam, event, &woken);
+}
+
+/* the DMA side of one chunk of sensor data, called with the lock held */
+static void sim_dma_write(const uint8_t *data, size_t len)
+{
+    cam_obj_t *cam = s_sim.cam;
+    uint8_t *ring;
+    size_t ring_size;
+    if (cam->psram_mode) {
+        ring = cam->frames[s_sim.frame_pos].fb.buf;
+        ring_size = cam->dma_node_cnt * cam->dma_node_buffer_size;
+    } else {
+        ring = cam->dma_buffer;
+        ring_size = cam->dma_buffer_size;
+    }
+
+    while (len && s_sim.dma_run) {
+        size_t offset = s_sim.dma_pos % ring_size;
+        size_t to_eof = cam->dma_half_buffer_size - s_sim.dma_pos % cam->dma_half_buffer_size;
+        size_t n = len < to_eof ? len : to_eof;
+        if (n > ring_size - offset) {
+            n = ring_size - offset;
+        }
+        memcpy(ring + offset, data, n);
+        data += n;
+        len -= n;
+        s_sim.dma_pos += n;
+        s_sim.counters.dma_bytes += n;
+        if (s_sim.dma_pos % cam->dma_half_buffer_size == 0 && s_sim.eof_en && s_sim.vsync_en) {
+            sim_send_event(CAM_IN_SUC_EOF_EVENT);
+        }
+    }
+}
+
+static void *sim_sensor_task(void *arg)
+{
+    cam_obj_t *cam = (cam_obj_t *) arg;
+    const ll_cam_sim_config_t *config = &s_sim.config;
+    uint8_t *frame = malloc(config->max_frame_len);
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+
+    for (uint32_t index = 0; frame && !s_sim.quit; index++) {
+        size_t len = config->frame_cb(index, frame, config->max_frame_len, config->arg);
+
+        // frame start, which is also the end of the previous one for cam_task
+        if (config->pclk_hz) {
+            sim_deadline_add(&t, (uint64_t) config->vblank_us * 500);
+            sim_wait_until(&t);
+        }
+        pthread_mutex_lock(&s_sim.lock);
+        s_sim.counters.frames++;
+        if (s_sim.vsync_en) {
+            sim_send_event(CAM_VSYNC_EVENT);
+        }
+        pthread_mutex_unlock(&s_sim.lock);
+        if (config->pclk_hz) {
+            sim_deadline_add(&t, (uint64_t) config->vblank_us * 500);
+            sim_wait_until(&t);
+        } else {
+            sim_wait_drained();
+        }
+
+        for (size_t sent = 0; sent < len && !s_sim.quit;) {
+            size_t n = len - sent;
+            if (n > cam->dma_half_buffer_size) {
+                n = cam->dma_half_buffer_size;
+            }
+            if (config->pclk_hz) {
+                sim_deadline_add(&t, n * 1000000000ULL / config->pclk_hz);
+                sim_wait_until(&t);
+            }
+            pthread_mutex_lock(&s_sim.lock);
+            s_sim.counters.sensor_bytes += n;
+            sim_dma_write(frame + sent, n);
+            pthread_mutex_unlock(&s_sim.lock);
+            sent += n;
+            if (!config->pclk_hz) {
+                sim_wait_drained();
+            }
+        }
+        if (!config->pclk_hz && !s_sim.vsync_en) {
+            // nobody is listening before cam_start(), don't spin
+            struct timespec idle = {0, 1000000};
+            nanosleep(&idle, NULL);
+        }
+    }
+    free(frame);
+    return NULL;
+}
+
+bool ll_cam_stop(cam_obj_t *cam)
+{
+    pthread_mutex_lock(&s_sim.lock);
+    if (cam->jpeg_mode || !cam->psram_mode) {
+        s_sim.eof_en = false;
+    }
+    s_sim.dma_run = false;
+    pthread_mutex_unlock(&s_sim.lock);
+    return true;
+}
+
+bool ll_cam_start(cam_obj_t *cam, int frame_pos)
+{
+    pthread_mutex_lock(&s_sim.lock);
+    if (cam->jpeg_mode || !cam->psram_mode) {
+        s_sim.eof_en = true;
+    }
+    s_sim.frame_pos = frame_pos;
+    s_sim.dma_pos = 0;
+    s_sim.dma_run = true;
+    pthread_mutex_unlock(&s_sim.lock);
+    return true;
+}
+
+esp_err_t ll_cam_config(cam_obj_t *cam, const camera_config_t *config)
+{
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&s_sim.lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+    memset(&s_sim.counters, 0, sizeof(s_sim.counters));
+    s_sim.vsync_en = false;
+    s_sim.eof_en = false;
+    s_sim.dma_run = false;
+    if (s_sim.config.frame_cb == NULL || s_sim.config.max_frame_len == 0) {
+        ESP_LOGE(TAG, "ll_cam_sim_configure() first");
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+esp_err_t ll_cam_deinit(cam_obj_t *cam)
+{
+    if (s_sim.running) {
+        s_sim.quit = true;
+        pthread_join(s_sim.thread, NULL);
+        s_sim.running = false;
+    }
+    s_sim.cam = NULL;
+    return ESP_OK;
+}
+
+void ll_cam_vsync_intr_enable(cam_obj_t *cam, bool en)
+{
+    pthread_mutex_lock(&s_sim.lock);
+    s_sim.vsync_en = en;
+    pthread_mutex_unlock(&s_sim.lock);
+}
+
+esp_err_t ll_cam_set_pin(cam_obj_t *cam, const camera_config_t *config)
+{
+    return ESP_OK;
+}
+
+esp_err_t ll_cam_init_isr(cam_obj_t *cam)
+{
+    s_sim.cam = cam;
+    s_sim.quit = false;
+    if (pthread_create(&s_sim.thread, NULL, sim_sensor_task, cam) != 0) {
+        ESP_LOGE(TAG, "sensor thread create failed");
+        return ESP_FAIL;
+    }
+    s_sim.running = true;
+    return ESP_OK;
+}
+
+void ll_cam_do_vsync(cam_obj_t *cam)
+{
+}
+
+uint8_t ll_cam_get_dma_align(cam_obj_t *cam)
+{
+    return 16;
+}
+
+void ll_cam_dma_print_state(cam_obj_t *cam)
+{
+}
+
+void ll_cam_dma_reset(cam_obj_t *cam)
+{
+    pthread_mutex_lock(&s_sim.lock);
+    s_sim.counters.dma_resets++;
+    pthread_mutex_unlock(&s_sim.lock);
+}
+
+static bool ll_cam_calc_rgb_dma(cam_obj_t *cam){
+    size_t node_max = LCD_CAM_DMA_NODE_BUFFER_MAX_SIZE / cam->dma_bytes_per_item;
+    size_t line_width = cam->width * cam->in_bytes_per_pixel;
+    size_t node_size = node_max;
+    size_t nodes_per_line = 1;
+    size_t lines_per_node = 1;
+
+    // Calculate DMA Node Size so that it's divisable by or divisor of the line width
+    if(line_width >= node_max){
+        // One or more nodes will be requied for one line
+        for(size_t i = node_max; i > 0; i=i-1){
+            if ((line_width % i) == 0) {
+                node_size = i;
+                nodes_per_line = line_width / node_size;
+                break;
+            }
+        }
+    } else {
+        // One or more lines can fit into one node
+        for(size_t i = node_max; i > 0; i=i-1){
+            if ((i % line_width) == 0) {
+                node_size = i;
+                lines_per_node = node_size / line_width;
+                while((cam->height % lines_per_node) != 0){
+                    lines_per_node = lines_per_node - 1;
+                    node_size = lines_per_node * line_width;
+                }
+                break;
+            }
+        }
+    }
+
+    cam->dma_node_buffer_size = node_size * cam->dma_bytes_per_item;
+
+    size_t dma_half_buffer_max = CONFIG_CAMERA_DMA_BUFFER_SIZE_MAX / 2 / cam->dma_bytes_per_item;
+    if (line_width > dma_half_buffer_max) {
+        ESP_LOGE(TAG, "Resolution too high");
+        return 0;
+    }
+
+    // Calculate minimum EOF size = max(mode_size, line_size)
+    size_t dma_half_buffer_min = node_size * nodes_per_line;
+
+    // Calculate max EOF size divisable by node size
+    size_t dma_half_buffer = (dma_half_buffer_max / dma_half_buffer_min) * dma_half_buffer_min;
+
+    // Adjust EOF size so that height will be divisable by the number of lines in each EOF
+    size_t lines_per_half_buffer = dma_half_buffer / line_width;
+    while((cam->height % lines_per_half_buffer) != 0){
+        dma_half_buffer = dma_half_buffer - dma_half_buffer_min;
+        lines_per_half_buffer = dma_half_buffer / line_width;
+    }
+
+    // Calculate DMA size
+    size_t dma_buffer_max = 2 * dma_half_buffer_max;
+    if (cam->psram_mode) {
+        dma_buffer_max = cam->recv_size / cam->dma_bytes_per_item;
+    }
+    size_t dma_buffer_size = dma_buffer_max;
+    if (!cam->psram_mode) {
+        dma_buffer_size =(dma_buffer_max / dma_half_buffer) * dma_half_buffer;
+    }
+
+    cam->dma_buffer_size = dma_buffer_size * cam->dma_bytes_per_item;
+    cam->dma_half_buffer_size = dma_half_buffer * cam->dma_bytes_per_item;
+    cam->dma_half_buffer_cnt = cam->dma_buffer_size / cam->dma_half_buffer_size;
+    return 1;
+}
+
+bool ll_cam_dma_sizes(cam_obj_t *cam)
+{
+    cam->dma_bytes_per_item = 1;
+    if (cam->jpeg_mode) {
+        if (cam->psram_mode) {
+            cam->dma_buffer_size = cam->recv_size;
+            cam->dma_half_buffer_size = 1024;
+            cam->dma_half_buffer_cnt = cam->dma_buffer_size / cam->dma_half_buffer_size;
+            cam->dma_node_buffer_size = cam->dma_half_buffer_size;
+        } else {
+            cam->dma_half_buffer_cnt = 16;
+            cam->dma_buffer_size = cam->dma_half_buffer_cnt * 1024;
+            cam->dma_half_buffer_size = cam->dma_buffer_size / cam->dma_half_buffer_cnt;
+            cam->dma_node_buffer_size = cam->dma_half_buffer_size;
+        }
+    } else {
+        return ll_cam_calc_rgb_dma(cam);
+    }
+    return 1;
+}
+
+size_t ll_cam_memcpy(cam_obj_t *cam, uint8_t *out, const uint8_t *in, size_t len)
+{
+    // YUV to Grayscale
+    if (cam->in_bytes_per_pixel == 2 && cam->fb_bytes_per_pixel == 1) {
+        size_t end = len / 8;
+        for (size_t i = 0; i < end; ++i) {
+            out[0] = in[0];
+            out[1] = in[2];
+            out[2] = in[4];
+            out[3] = in[6];
+            out += 4;
+            in += 8;
+        }
+        return len / 2;
+    }
+
+    // just memcpy
+    memcpy(out, in, len);
+    return len;
+}
+
+esp_err_t ll_cam_set_sample_mode(cam_obj_t *cam, pixformat_t pix_format, uint32_t xclk_freq_hz, uint16_t sensor_pid)
+{
+    if (pix_format == PIXFORMAT_GRAYSCALE) {
+        if (sensor_pid == OV3660_PID || sensor_pid == OV5640_PID || sensor_pid == NT99141_PID || sensor_pid == SC031GS_PID || sensor_pid == BF20A6_PID || sensor_pid == GC0308_PID) {
+            cam->in_bytes_per_pixel = 1;       // camera sends Y8
+        } else {
+            cam->in_bytes_per_pixel = 2;       // camera sends YU/YV
+        }
+        cam->fb_bytes_per_pixel = 1;       // frame buffer stores Y8
+    } else if (pix_format == PIXFORMAT_YUV422 || pix_format == PIXFORMAT_RGB565) {
+        cam->in_bytes_per_pixel = 2;       // for DMA receive
+        cam->fb_bytes_per_pixel = 2;       // frame buffer stores YU/YV/RGB565
+    } else if (pix_format == PIXFORMAT_JPEG) {
+        cam->in_bytes_per_pixel = 1;
+        cam->fb_bytes_per_pixel = 1;
+    } else {
+        ESP_LOGE(TAG, "Requested format is not supported");
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    return ESP_OK;
+}
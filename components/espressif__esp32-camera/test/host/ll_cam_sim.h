@@ -0,0 +1,47 @@
+// Host build only, see cam_hal_sim.c
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Produces the bytes the sensor sends for frame `index`
+ *
+ * @return Number of bytes written to buf, at most size
+ */
+typedef size_t (*ll_cam_sim_frame_cb_t)(uint32_t index, uint8_t *buf, size_t size, void *arg);
+
+typedef struct {
+    uint32_t pclk_hz;               /*!< Bytes per second on the DVP bus. 0 sends the next chunk only once cam_task has handled every event, which measures frame assembly throughput */
+    uint32_t vblank_us;             /*!< Time between the last byte of a frame and the first of the next, VSYNC is in the middle */
+    size_t max_frame_len;           /*!< Largest frame the callback produces */
+    ll_cam_sim_frame_cb_t frame_cb; /*!< Sensor data source */
+    void *arg;                      /*!< Passed to frame_cb */
+} ll_cam_sim_config_t;
+
+typedef struct {
+    uint32_t frames;                /*!< Frames sent by the sensor */
+    uint32_t vsync_events;          /*!< VSYNC interrupts raised */
+    uint32_t eof_events;            /*!< DMA in_suc_eof interrupts raised */
+    uint64_t sensor_bytes;          /*!< Bytes sent by the sensor */
+    uint64_t dma_bytes;             /*!< Bytes written to memory by the DMA */
+    uint32_t dma_resets;            /*!< ll_cam_dma_reset() calls */
+} ll_cam_sim_counters_t;
+
+/**
+ * @brief Sets the sensor model used by the next cam_init()
+ */
+void ll_cam_sim_configure(const ll_cam_sim_config_t *config);
+
+/**
+ * @brief Reads the simulator counters, they are reset by cam_init()
+ */
+void ll_cam_sim_get_counters(ll_cam_sim_counters_t *counters);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,8 @@
+// Host build stand-in for the IDF header, see cam_hal_sim.c
+#pragma once
+
+// the simulated backend follows the ESP32-S3 LCD_CAM + GDMA driver paths
+#define CONFIG_IDF_TARGET_ESP32S3               1
+#define CONFIG_CAMERA_DMA_BUFFER_SIZE_MAX       32768
+#define CONFIG_CAMERA_JPEG_MODE_FRAME_SIZE_AUTO 1
+#define CONFIG_CAMERA_TASK_STACK_SIZE           2048
@@ -0,0 +1,2 @@
+// Host build stand-in for the IDF header, see jpg_encode_bench.c
+#pragma once
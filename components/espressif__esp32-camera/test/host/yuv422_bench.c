@@ -0,0 +1,129 @@
+// Copyright 2015-2024 Espressif Systems (Shanghai) PTE LTD
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+ * Host check and benchmark of yuv422_convert_line() against the per pixel
+ * yuv2rgb() path it replaces. Build from the component root:
+ *
+ *   gcc -O2 -Itest/host -Iconversions/private_include conversions/yuv.c \
+ *       test/host/yuv422_bench.c -o yuv422_bench && ./yuv422_bench
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "yuv.h"
+
+#define RUNS 10
+
+static const char *format_names[] = {"rgb888", "bgr888", "rgb565", "gray"};
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+/* the loops fmt2rgb888 / fmt2bmp / convert_line_format used to run */
+static void reference_frame(const uint8_t *src, uint8_t *dst, size_t pixels, yuv422_line_format_t format)
+{
+    for (size_t i = 0; i < pixels; i += 2, src += 4) {
+        for (int k = 0; k < 2; k++) {
+            uint8_t r, g, b;
+            if (format == YUV422_TO_GRAY) {
+                *dst++ = src[2 * k];
+                continue;
+            }
+            yuv2rgb(src[2 * k], src[1], src[3], &r, &g, &b);
+            if (format == YUV422_TO_RGB888) {
+                *dst++ = r; *dst++ = g; *dst++ = b;
+            } else if (format == YUV422_TO_BGR888) {
+                *dst++ = b; *dst++ = g; *dst++ = r;
+            } else {
+                *dst++ = (r & 0xF8) | (g >> 5);
+                *dst++ = ((g << 3) & 0xE0) | (b >> 3);
+            }
+        }
+    }
+}
+
+static int bench(int width, int height)
+{
+    const size_t pixels = (size_t) width * height;
+    uint8_t *src = malloc(pixels * 2);
+    uint8_t *ref = malloc(pixels * 3);
+    uint8_t *out = malloc(pixels * 3);
+    int failed = 0;
+
+    for (size_t i = 0; i < pixels * 2; i++) {
+        src[i] = rand() & 0xff;
+    }
+
+    for (int f = YUV422_TO_RGB888; f <= YUV422_TO_GRAY; f++) {
+        double t_ref = 1e30, t_line = 1e30;
+        for (int run = 0; run < RUNS; run++) {
+            double t0 = now_us();
+            reference_frame(src, ref, pixels, f);
+            double t1 = now_us();
+            /* line by line, like the jpeg encoder */
+            for (int y = 0; y < height; y++) {
+                const size_t bpp = f == YUV422_TO_GRAY ? 1 : f == YUV422_TO_RGB565 ? 2 : 3;
+                yuv422_convert_line(src + (size_t) y * width * 2, out + (size_t) y * width * bpp, width, f);
+            }
+            double t2 = now_us();
+            t_ref = t1 - t0 < t_ref ? t1 - t0 : t_ref;
+            t_line = t2 - t1 < t_line ? t2 - t1 : t_line;
+        }
+        const size_t size = pixels * (f == YUV422_TO_GRAY ? 1 : f == YUV422_TO_RGB565 ? 2 : 3);
+        int ok = memcmp(ref, out, size) == 0;
+        failed |= !ok;
+        printf("%4dx%-4d %-7s yuv2rgb %8.0f us, line %8.0f us, x%.2f %s\n", width, height,
+               format_names[f], t_ref, t_line, t_ref / t_line, ok ? "bit-exact" : "MISMATCH");
+    }
+    free(src);
+    free(ref);
+    free(out);
+    return failed;
+}
+
+int main(void)
+{
+    int failed = 0;
+
+    /* exhaustive over every (y, u, v) against the table */
+    uint8_t yuyv[4], rgb[6];
+    for (int y = 0; y < 256; y++) {
+        for (int u = 0; u < 256; u++) {
+            for (int v = 0; v < 256; v++) {
+                uint8_t r, g, b;
+                yuyv[0] = yuyv[2] = y;
+                yuyv[1] = u;
+                yuyv[3] = v;
+                yuv2rgb(y, u, v, &r, &g, &b);
+                yuv422_convert_line(yuyv, rgb, 2, YUV422_TO_RGB888);
+                if (rgb[0] != r || rgb[1] != g || rgb[2] != b) {
+                    printf("mismatch y %d u %d v %d\n", y, u, v);
+                    return 1;
+                }
+            }
+        }
+    }
+    printf("all 2^24 yuv triplets bit-exact\n");
+
+    failed |= bench(640, 480);
+    failed |= bench(800, 600);
+    return failed;
+}
@@ -338,6 +338,69 @@ TEST_CASE("Camera driver take JPEG picture test", "[camera]")
     TEST_ASSERT_NOT_NULL(pic);
 }
 
+TEST_CASE("Camera driver take latest picture test", "[camera]")
+{
+    TEST_ESP_OK(init_camera(20000000, PIXFORMAT_RGB565, FRAMESIZE_QVGA, 3, SIOD_GPIO_NUM, -1));
+    vTaskDelay(500 / portTICK_RATE_MS);
+    camera_fb_t *first = esp_camera_fb_get_latest();
+    TEST_ASSERT_NOT_NULL(first);
+    uint32_t seq = first->seq;
+    esp_camera_fb_return(first);
+
+    // let the spare buffers fill up, only the newest of them comes back
+    vTaskDelay(300 / portTICK_RATE_MS);
+    camera_fb_t *pic = esp_camera_fb_get_latest();
+    TEST_ASSERT_NOT_NULL(pic);
+    ESP_LOGI(TAG, "seq %u -> %u", (unsigned)seq, (unsigned)pic->seq);
+    TEST_ASSERT_GREATER_THAN_UINT32(seq + 1, pic->seq);
+    esp_camera_fb_return(pic);
+
+    camera_fb_stats_t stats;
+    TEST_ESP_OK(esp_camera_fb_get_stats(&stats));
+    ESP_LOGI(TAG, "frames %u, dropped %u, overrun %u, missed %u", (unsigned)stats.frames,
+             (unsigned)stats.dropped, (unsigned)stats.overrun, (unsigned)stats.missed);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(2, stats.frames);
+    TEST_ASSERT_GREATER_THAN_UINT32(0, stats.dropped);
+
+    // nothing is queued right after a take, try_get must not block
+    uint64_t t1 = esp_timer_get_time();
+    pic = esp_camera_fb_try_get();
+    uint64_t t2 = esp_timer_get_time();
+    if (pic) {
+        esp_camera_fb_return(pic);
+    }
+    TEST_ASSERT_LESS_THAN_UINT64(10000, t2 - t1);
+
+    TEST_ESP_OK(esp_camera_deinit());
+}
+
+TEST_CASE("Camera driver region of interest test", "[camera]")
+{
+    TEST_ESP_OK(init_camera(20000000, PIXFORMAT_RGB565, FRAMESIZE_QVGA, 2, SIOD_GPIO_NUM, -1));
+    camera_roi_t roi = {.x = 162, .y = 40, .width = 50, .height = 30};
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_ARG, esp_camera_set_roi(&(camera_roi_t){.x = 300, .y = 0, .width = 40, .height = 40}));
+    // too small for the OV2640 zoom, the frame copy crops it
+    TEST_ESP_OK(esp_camera_set_roi(&roi));
+    vTaskDelay(300 / portTICK_RATE_MS);
+    camera_fb_t *pic = esp_camera_fb_get_latest();
+    TEST_ASSERT_NOT_NULL(pic);
+    ESP_LOGI(TAG, "roi frame %ux%u, %u bytes", (unsigned)pic->width, (unsigned)pic->height, (unsigned)pic->len);
+    // x and width go out to multiples of 4: 160..212
+    TEST_ASSERT_EQUAL(52, pic->width);
+    TEST_ASSERT_EQUAL(30, pic->height);
+    TEST_ASSERT_EQUAL(52 * 30 * 2, pic->len);
+    esp_camera_fb_return(pic);
+
+    TEST_ESP_OK(esp_camera_set_roi(NULL));
+    vTaskDelay(300 / portTICK_RATE_MS);
+    pic = esp_camera_fb_get_latest();
+    TEST_ASSERT_NOT_NULL(pic);
+    TEST_ASSERT_EQUAL(320, pic->width);
+    TEST_ASSERT_EQUAL(320 * 240 * 2, pic->len);
+    esp_camera_fb_return(pic);
+    TEST_ESP_OK(esp_camera_deinit());
+}
+
 TEST_CASE("Camera driver performance test", "[camera]")
 {
     camera_performance_test(20 * 1000000, 16);
@@ -525,6 +588,77 @@ TEST_CASE("Conversions image 480x320 jpeg decode test", "[camera]")
     img_jpeg_decode_test(2, 0);
 }
 
+TEST_CASE("Conversions image 480x320 jpeg to 96x96 gray test", "[camera]")
+{
+    extern const uint8_t img3_start[] asm("_binary_test_outside_jpeg_start");
+    extern const uint8_t img3_end[]   asm("_binary_test_outside_jpeg_end");
+    const uint32_t length = img3_end - img3_start;
+    const uint32_t times = 16;
+
+    uint8_t *gray = malloc(96 * 96);
+    uint8_t *rgb_buf = heap_caps_malloc(480 * 320 * 3, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    TEST_ASSERT_NOT_NULL(gray);
+    TEST_ASSERT_NOT_NULL(rgb_buf);
+
+    TEST_ASSERT_TRUE(jpg2gray_resized(img3_start, length, gray, 96, 96, true));
+
+    uint64_t t_gray = 0, t_rgb = 0;
+    for (size_t i = 0; i < times; i++) {
+        uint64_t t1 = esp_timer_get_time();
+        jpg2gray_resized(img3_start, length, gray, 96, 96, true);
+        uint64_t t2 = esp_timer_get_time();
+        jpg2rgb565(img3_start, length, rgb_buf, JPG_SCALE_NONE);
+        t_rgb += esp_timer_get_time() - t2;
+        t_gray += t2 - t1;
+    }
+    printf("480 x 320 -> 96 x 96 gray: %5.2f ms, full rgb565 decode: %5.2f ms\n",
+           t_gray / 1000.0f / times, t_rgb / 1000.0f / times);
+
+    free(gray);
+    heap_caps_free(rgb_buf);
+}
+
+TEST_CASE("Conversions image 480x320 rgb565 jpeg encode test", "[camera]")
+{
+    extern const uint8_t img3_start[] asm("_binary_test_outside_jpeg_start");
+    extern const uint8_t img3_end[]   asm("_binary_test_outside_jpeg_end");
+    const uint32_t length = img3_end - img3_start;
+    const uint32_t times = 16;
+    const size_t out_size = 128 * 1024;
+
+    uint8_t *rgb_buf = heap_caps_malloc(480 * 320 * 2, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    uint8_t *out = heap_caps_malloc(out_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    size_t work_len = fmt2jpg_fast_work_size(480, PIXFORMAT_RGB565);
+    uint8_t *work = malloc(work_len);
+    TEST_ASSERT_NOT_NULL(rgb_buf);
+    TEST_ASSERT_NOT_NULL(out);
+    TEST_ASSERT_NOT_NULL(work);
+    TEST_ASSERT_TRUE(jpg2rgb565(img3_start, length, rgb_buf, JPG_SCALE_NONE));
+
+    uint64_t t_ref = 0, t_fast = 0;
+    size_t ref_len = 0, fast_len = 0;
+    for (size_t i = 0; i < times; i++) {
+        uint8_t *ref = NULL;
+        uint64_t t1 = esp_timer_get_time();
+        TEST_ASSERT_TRUE(fmt2jpg(rgb_buf, 480 * 320 * 2, 480, 320, PIXFORMAT_RGB565, 80, &ref, &ref_len));
+        uint64_t t2 = esp_timer_get_time();
+        TEST_ASSERT_TRUE(fmt2jpg_fast(rgb_buf, 480 * 320 * 2, 480, 320, PIXFORMAT_RGB565, 80, work, work_len, out, out_size, &fast_len));
+        t_fast += esp_timer_get_time() - t2;
+        t_ref += t2 - t1;
+        free(ref);
+    }
+    printf("480 x 320 rgb565 -> jpeg: fmt2jpg %5.2f ms %u bytes, fmt2jpg_fast %5.2f ms %u bytes\n",
+           t_ref / 1000.0f / times, ref_len, t_fast / 1000.0f / times, fast_len);
+
+    /* same quality tables, only the DCT rounding and the restart marker differ */
+    TEST_ASSERT_UINT32_WITHIN(ref_len / 10, ref_len, fast_len);
+    TEST_ASSERT_TRUE(jpg2rgb565(out, fast_len, rgb_buf, JPG_SCALE_NONE));
+
+    heap_caps_free(rgb_buf);
+    heap_caps_free(out);
+    free(work);
+}
+
 TEST_CASE("Camera driver uses an i2c port initialized by other devices test", "[camera]")
 {
     TEST_ESP_OK(i2c_master_init(I2C_MASTER_NUM));
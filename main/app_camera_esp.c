@@ -75,6 +75,15 @@ int app_camera_init() {
   // With display support enabled, the pixel format is RGB565 to match the display. The frame is converted to grayscale before it is passed to the trained model.
   config.pixel_format = CAMERA_PIXEL_FORMAT;
   config.frame_size = CAMERA_FRAME_SIZE;
+  // Keep capturing into the free buffers while inference runs, GetImage then
+  // takes the newest one instead of a frame that is seconds old.
+  config.grab_mode = CAMERA_GRAB_LATEST;
+#if DISPLAY_SUPPORT
+  // the display task holds one frame while it shows it
+  if (config.fb_count < 3) {
+    config.fb_count = 3;
+  }
+#endif
 
   // camera init
   esp_err_t err = esp_camera_init(&config);
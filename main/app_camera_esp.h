@@ -49,7 +49,12 @@ limitations under the License.
  * FRAMESIZE_SXGA,     // 1280x1024
  * FRAMESIZE_UXGA,     // 1600x1200
  */
+#if CONFIG_MULTISCALE_INFERENCE
+// room for windows at several scales, see multiscale_inference.h
+#define CAMERA_FRAME_SIZE FRAMESIZE_QVGA
+#else
 #define CAMERA_FRAME_SIZE FRAMESIZE_96X96
+#endif
 
 #if CONFIG_CAMERA_MODULE_WROVER_KIT
 #define CAMERA_MODULE_NAME "Wrover Kit"
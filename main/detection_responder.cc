@@ -57,6 +57,10 @@ void uart_receive_string(char* buffer, int max_len) {
   ESP_LOG_BUFFER_HEXDUMP("UART", buffer, rxBytes, ESP_LOG_INFO);
 }
 
+int uart_receive_bytes(uint8_t* buffer, int len, int timeout_ms) {
+  return uart_read_bytes(UART_NUM_1, buffer, len, timeout_ms / portTICK_PERIOD_MS);
+}
+
 int RespondToDetection(float* sign_score, const char* kCategoryLabels[]) {
   // Encender el flash durante un milisegundo
   gpio_set_level(FLASH_PIN, 1);
@@ -72,7 +76,7 @@ int RespondToDetection(float* sign_score, const char* kCategoryLabels[]) {
     }
   }
 
-  if (max_score > 0.5) {
+  if (max_score > kDetectionThreshold) {
     MicroPrintf("Detected sign: %s", kCategoryLabels[max_score_index]);
   } else {
     MicroPrintf("No sign detected");
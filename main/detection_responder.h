@@ -3,9 +3,14 @@
 
 #include "tensorflow/lite/c/common.h"
 
+// Score above which a category counts as detected
+constexpr float kDetectionThreshold = 0.5f;
+
 int RespondToDetection(float* sign_score, const char* kCategoryLabels[]);
 void uart_send_string(const char* str);
 void uart_receive_string(char* buffer, int max_len);
+// Raw bytes, returns the count read once `len` arrived or the timeout expired
+int uart_receive_bytes(uint8_t* buffer, int len, int timeout_ms);
 void uart_init(void);
 
 #endif  // TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_DETECTION_RESPONDER_H_
\ No newline at end of file
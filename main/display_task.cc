@@ -0,0 +1,151 @@
+#include "display_task.h"
+
+#include <cstring>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+#include "esp_main.h"
+#include "model_settings.h"
+
+#if DISPLAY_SUPPORT
+#include "bsp/esp-bsp.h"
+
+namespace {
+const char* TAG = "display";
+
+// The model input is too small for the LCD, it is shown 2x
+constexpr int kDisplayWidth = kNumCols * 2;
+constexpr int kDisplayHeight = kNumRows * 2;
+// model, display task and one spare while a frame changes hands
+constexpr int kMaxSharedFrames = 4;
+
+SharedFrame shared_frames[kMaxSharedFrames];
+
+// The canvas shows display_buf[front], the task fills the other one
+uint16_t* display_buf[2];
+int front = 0;
+lv_obj_t* camera_canvas = nullptr;
+TaskHandle_t display_task = nullptr;
+
+// Set by DisplaySubmit(), owned by the task until it clears busy
+bool busy = false;
+SharedFrame* pending = nullptr;
+int pending_x, pending_y, pending_side;
+
+// Nearest-neighbour sample of the side x side crop at kNumCols x kNumRows,
+// the same pixels GetImage() feeds the model. Each pixel is doubled in a
+// single 32-bit store and the finished line is copied to the one below it,
+// so the output is written word-wide instead of four times per pixel.
+void Upscale2x(const uint16_t* frame, int frame_width, int x, int y, int side, uint16_t* out) {
+  int cols[kNumCols];
+  for (int j = 0; j < kNumCols; j++) {
+    cols[j] = x + j * side / kNumCols;
+  }
+  for (int i = 0; i < kNumRows; i++) {
+    const uint16_t* row = frame + (y + i * side / kNumRows) * frame_width;
+    uint32_t* line = (uint32_t*) (out + 2 * i * kDisplayWidth);
+    for (int j = 0; j < kNumCols; j += 2) {
+      const uint32_t p0 = row[cols[j]];
+      const uint32_t p1 = row[cols[j + 1]];
+      line[j] = p0 | (p0 << 16);
+      line[j + 1] = p1 | (p1 << 16);
+    }
+    memcpy(line + kNumCols, line, kDisplayWidth * sizeof(uint16_t));
+  }
+}
+
+void DisplayTask(void* arg) {
+  while (true) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    const int back = front ^ 1;
+    Upscale2x((const uint16_t*) pending->fb->buf, pending->fb->width, pending_x, pending_y, pending_side,
+              display_buf[back]);
+    // the camera gets the frame back before the LCD is touched
+    SharedFrameRelease(pending);
+    pending = nullptr;
+
+    // LVGL only reads the canvas under the display lock, once the canvas
+    // points at the new buffer the old one is free to be filled
+    bsp_display_lock(0);
+    lv_canvas_set_buffer(camera_canvas, display_buf[back], kDisplayWidth, kDisplayHeight, LV_IMG_CF_TRUE_COLOR);
+    bsp_display_unlock();
+    front = back;
+    __atomic_clear(&busy, __ATOMIC_RELEASE);
+  }
+}
+}  // namespace
+
+SharedFrame* SharedFrameWrap(camera_fb_t* fb) {
+  for (int i = 0; i < kMaxSharedFrames; i++) {
+    camera_fb_t* expected = nullptr;
+    if (__atomic_compare_exchange_n(&shared_frames[i].fb, &expected, fb, false, __ATOMIC_ACQUIRE,
+                                    __ATOMIC_RELAXED)) {
+      __atomic_store_n(&shared_frames[i].refs, 1, __ATOMIC_RELAXED);
+      return &shared_frames[i];
+    }
+  }
+  return nullptr;
+}
+
+void SharedFrameRetain(SharedFrame* frame) {
+  __atomic_add_fetch(&frame->refs, 1, __ATOMIC_RELAXED);
+}
+
+void SharedFrameRelease(SharedFrame* frame) {
+  if (__atomic_sub_fetch(&frame->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+    esp_camera_fb_return(frame->fb);
+    __atomic_store_n(&frame->fb, nullptr, __ATOMIC_RELEASE);
+  }
+}
+
+TfLiteStatus DisplayInit() {
+  if (display_task != nullptr) {
+    return kTfLiteOk;
+  }
+  for (int i = 0; i < 2; i++) {
+    display_buf[i] = (uint16_t*) heap_caps_calloc(kDisplayWidth * kDisplayHeight, sizeof(uint16_t),
+                                                  MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (display_buf[i] == nullptr) {
+      ESP_LOGE(TAG, "Couldn't allocate display buffer");
+      return kTfLiteError;
+    }
+  }
+
+  bsp_display_start();
+  bsp_display_backlight_on();
+  bsp_display_lock(0);
+  camera_canvas = lv_canvas_create(lv_scr_act());
+  lv_obj_align(camera_canvas, LV_ALIGN_TOP_MID, 0, 0);
+  lv_canvas_set_buffer(camera_canvas, display_buf[front], kDisplayWidth, kDisplayHeight, LV_IMG_CF_TRUE_COLOR);
+  bsp_display_unlock();
+
+  // last core, away from the model where there is a second one
+  if (xTaskCreatePinnedToCore(DisplayTask, "display", 4 * 1024, nullptr, 1, &display_task,
+                              portNUM_PROCESSORS - 1) != pdPASS) {
+    ESP_LOGE(TAG, "Couldn't start the display task");
+    return kTfLiteError;
+  }
+  return kTfLiteOk;
+}
+
+bool DisplaySubmit(SharedFrame* frame, int x, int y, int side) {
+  if (frame->fb->format != PIXFORMAT_RGB565 || __atomic_test_and_set(&busy, __ATOMIC_ACQUIRE)) {
+    return false;
+  }
+  SharedFrameRetain(frame);
+  pending = frame;
+  pending_x = x;
+  pending_y = y;
+  pending_side = side;
+  xTaskNotifyGive(display_task);
+  return true;
+}
+
+const uint16_t* DisplayGetBuffer() {
+  return display_buf[front];
+}
+
+#endif  // DISPLAY_SUPPORT
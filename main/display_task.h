@@ -0,0 +1,36 @@
+#ifndef TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_DISPLAY_TASK_H_
+#define TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_DISPLAY_TASK_H_
+
+#include "esp_camera.h"
+#include "tensorflow/lite/c/common.h"
+
+// The LCD is fed by a task of its own so that the model never waits for it.
+// GetImage() hands the camera frame over by reference, the task upscales the
+// model's crop of it 2x to the display buffer and pushes that through the
+// BSP, then drops its reference. Frames arriving while the task is still busy
+// are skipped, the display simply runs at a lower rate than the model.
+
+// Camera frame with more than one holder, it goes back to the camera when the
+// last holder releases it
+struct SharedFrame {
+  camera_fb_t* fb;
+  int refs;
+};
+
+// Takes over fb with one reference, NULL when all slots are in use
+SharedFrame* SharedFrameWrap(camera_fb_t* fb);
+void SharedFrameRetain(SharedFrame* frame);
+void SharedFrameRelease(SharedFrame* frame);
+
+// Starts the display and the task feeding it
+TfLiteStatus DisplayInit();
+
+// Queues the side x side square at (x, y) of an RGB565 frame for display.
+// Returns false, without taking a reference, when the previous frame is
+// still being shown.
+bool DisplaySubmit(SharedFrame* frame, int x, int y, int side);
+
+// Last image pushed to the display, 192x192 RGB565
+const uint16_t* DisplayGetBuffer();
+
+#endif  // TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_DISPLAY_TASK_H_
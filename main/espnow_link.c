@@ -0,0 +1,43 @@
+#include "espnow_link.h"
+
+#include "esp_event.h"
+#include "esp_log.h"
+#include "esp_wifi.h"
+
+#include "espnow.h"
+#include "espnow_storage.h"
+
+static const char *TAG = "espnow_link";
+
+esp_err_t espnow_link_init(void)
+{
+    esp_err_t err = esp_event_loop_create_default();
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) {
+        return err;
+    }
+
+    wifi_init_config_t wifi_config = WIFI_INIT_CONFIG_DEFAULT();
+    err = esp_wifi_init(&wifi_config);
+    if (err == ESP_OK) {
+        err = esp_wifi_set_storage(WIFI_STORAGE_RAM);
+    }
+    if (err == ESP_OK) {
+        err = esp_wifi_set_mode(WIFI_MODE_STA);
+    }
+    if (err == ESP_OK) {
+        err = esp_wifi_start();
+    }
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Wi-Fi: %s", esp_err_to_name(err));
+        return err;
+    }
+
+    espnow_storage_init();
+
+    espnow_config_t espnow_config = ESPNOW_INIT_CONFIG_DEFAULT();
+    err = espnow_init(&espnow_config);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "ESP-NOW: %s", esp_err_to_name(err));
+    }
+    return err;
+}
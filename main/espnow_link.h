@@ -0,0 +1,15 @@
+#pragma once
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Starts Wi-Fi in station mode, without connecting to an access point, and
+// ESP-NOW on top of it. Needs nvs_flash_init() first.
+esp_err_t espnow_link_init(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -13,6 +13,7 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
@@ -26,13 +27,24 @@ limitations under the License.
 
 #include "app_camera_esp.h"
 #include "esp_camera.h"
+#include "esp_nn.h"
 #include "model_settings.h"
 #include "image_provider.h"
+#include "display_task.h"
 #include "esp_main.h"
 
 static const char* TAG = "app_camera";
 
-static uint16_t *display_buf; // buffer to hold data to be sent to display
+static int8_t *tensor_buf; // preprocessed frame, followed by the kernel scratch
+static float tensor_to_float[256]; // int8 tensor value (as uint8_t index) -> model input
+
+#if ESP_CAMERA_SUPPORTED
+static camera_roi_t roi; // region the frames show, width 0 for the whole frame
+static bool roi_tracking;
+// where the last image handed to the model lies in the frame, for TrackImageRoi()
+static float view_x, view_y, view_w, view_h;
+static camera_fb_t* held_fb; // between AcquireImage() and ReleaseImage()
+#endif
 
 // Get the camera module ready
 TfLiteStatus InitCamera() {
@@ -40,19 +52,23 @@ TfLiteStatus InitCamera() {
   ESP_LOGI(TAG, "CLI_ONLY_INFERENCE enabled, skipping camera init");
   return kTfLiteOk;
 #endif
-// if display support is present, initialise display buf
+// if display support is present, start the task feeding the LCD
 #if DISPLAY_SUPPORT
-  if (display_buf == NULL) {
-    // Size of display_buf:
-    // Frame 96x96 from camera is extrapolated to 192x192. RGB565 pixel format -> 2 bytes per pixel
-    display_buf = (uint16_t *) heap_caps_malloc(96 * 2 * 96 * 2 * sizeof(uint16_t), MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
-  }
-  if (display_buf == NULL) {
-    ESP_LOGE(TAG, "Couldn't allocate display buffer");
+  if (DisplayInit() != kTfLiteOk) {
     return kTfLiteError;
   }
 #endif // DISPLAY_SUPPORT
 
+  for (int i = 0; i < 256; i++) {
+    int8_t q = (int8_t) i;
+#if DISPLAY_SUPPORT
+    tensor_to_float[i] = q;
+#else
+    // Normalize the pixel data to 0-1 range
+    tensor_to_float[i] = (q + 128) / 255.0f;
+#endif
+  }
+
 #if ESP_CAMERA_SUPPORTED
   int ret = app_camera_init();
   if (ret != 0) {
@@ -66,68 +82,246 @@ TfLiteStatus InitCamera() {
   return kTfLiteOk;
 }
 
+#if ESP_CAMERA_SUPPORTED
+// esp-nn parameters for the side x side square at (x, y) of the frame,
+// resized to the model input and quantized to int8 (luma - 128)
+static void SetPreprocessParams(const camera_fb_t* fb, int x, int y, int side, int image_width,
+                                image_preprocess_params_t* params) {
+  *params = {};
+  if (fb->format == PIXFORMAT_RGB565) {
+#if CONFIG_CAMERA_RGB565_SENSOR_ORDER
+    params->format = ESP_NN_PIXEL_RGB565;
+#else
+    // the red/blue swapped luma the model was trained on
+    params->format = ESP_NN_PIXEL_BGR565;
+#endif
+  } else if (fb->format == PIXFORMAT_YUV422) {
+    params->format = ESP_NN_PIXEL_YUV422;
+  } else {
+    params->format = ESP_NN_PIXEL_GRAY;
+  }
+  // a cropped region of interest can be smaller than the model input
+  params->resize = side < image_width ? ESP_NN_RESIZE_BILINEAR : ESP_NN_RESIZE_AREA;
+  params->crop_x = x;
+  params->crop_y = y;
+  params->crop = {side, side};
+  params->norm_mult = 1 << 16;
+  params->out_offset = -128;
+  params->activation = {-128, 127};
+}
+
+// tensor_buf, with the esp-nn scratch behind it, on first use
+static bool AllocTensorBuf(const data_dims_t* input_dims, const data_dims_t* output_dims,
+                           const image_preprocess_params_t* params) {
+  if (tensor_buf == NULL) {
+    // scratch follows the tensor, keep it word aligned
+    const int32_t tensor_size = (output_dims->width * output_dims->height + 3) & ~3;
+    int32_t scratch_size = esp_nn_get_preprocess_image_scratch_size(input_dims, output_dims, params);
+    tensor_buf = (int8_t *) heap_caps_malloc(tensor_size + scratch_size, MALLOC_CAP_8BIT);
+    if (tensor_buf == NULL) {
+      ESP_LOGE(TAG, "Couldn't allocate preprocessing buffer");
+      return false;
+    }
+    esp_nn_set_preprocess_image_scratch_buf(tensor_buf + tensor_size);
+  }
+  return true;
+}
+#endif
+
+TfLiteStatus SetImageRoi(int x, int y, int width, int height) {
+#if ESP_CAMERA_SUPPORTED
+  esp_err_t err;
+  camera_roi_t r = {};
+  if (width <= 0) {
+    err = esp_camera_set_roi(NULL);
+  } else if (x < 0 || y < 0 || height <= 0) {
+    err = ESP_ERR_INVALID_ARG;
+  } else {
+    // x and width on the 4 pixel grid the frame copy crops on, so that the
+    // region is the same whether the sensor or the driver applies it
+    const int frame_width = resolution[CAMERA_FRAME_SIZE].width;
+    const int right = std::min((x + width + 3) & ~3, frame_width);
+    r.x = x & ~3;
+    r.y = y;
+    r.width = right - r.x;
+    r.height = height;
+    err = esp_camera_set_roi(&r);
+  }
+  if (err != ESP_OK) {
+    ESP_LOGE(TAG, "Region %dx%d at %d,%d rejected: %s", width, height, x, y, esp_err_to_name(err));
+    return kTfLiteError;
+  }
+  roi = r;
+  return kTfLiteOk;
+#else
+  return kTfLiteError;
+#endif
+}
+
+void SetImageRoiTracking(bool enable) {
+#if ESP_CAMERA_SUPPORTED
+  roi_tracking = enable;
+#endif
+}
+
+void TrackImageRoi(float center_x, float center_y) {
+#if ESP_CAMERA_SUPPORTED
+  if (!roi_tracking || !roi.width || view_w == 0) {
+    return;
+  }
+  const int max_x = resolution[CAMERA_FRAME_SIZE].width - roi.width;
+  const int max_y = resolution[CAMERA_FRAME_SIZE].height - roi.height;
+  const int x = std::max(0, std::min((int) (view_x + center_x * view_w) - roi.width / 2, max_x));
+  const int y = std::max(0, std::min((int) (view_y + center_y * view_h) - roi.height / 2, max_y));
+  // a sensor window change costs a few ms and a frame, skip small moves
+  if (std::abs(x - roi.x) < 4 && std::abs(y - roi.y) < 4) {
+    return;
+  }
+  SetImageRoi(x, y, roi.width, roi.height);
+#endif
+}
+
 void *image_provider_get_display_buf()
 {
-  return (void *) display_buf;
+#if DISPLAY_SUPPORT
+  return (void *) DisplayGetBuffer();
+#else
+  return NULL;
+#endif
 }
 
 // Get an image from the camera module
 TfLiteStatus GetImage(int image_width, int image_height, int channels, float* image_data) {
 #if ESP_CAMERA_SUPPORTED
-  camera_fb_t* fb = esp_camera_fb_get();
+  // Newest completed frame, anything that queued up while the previous
+  // inference ran is recycled rather than handed over stale
+  camera_fb_t* fb = esp_camera_fb_get_latest();
   if (!fb) {
     ESP_LOGE(TAG, "Camera capture failed");
     return kTfLiteError;
   }
 
-#if DISPLAY_SUPPORT
-  // In case if display support is enabled, we initialise camera in rgb mode
-  // Hence, we need to convert this data to grayscale to send it to tf model
-  // For display we extra-polate the data to 192X192
-  for (int i = 0; i < kNumRows; i++) {
-    for (int j = 0; j < kNumCols; j++) {
-      uint16_t pixel = ((uint16_t *) (fb->buf))[i * kNumCols + j];
-
-      // for inference
-      uint8_t hb = pixel & 0xFF;
-      uint8_t lb = pixel >> 8;
-      uint8_t r = (lb & 0x1F) << 3;
-      uint8_t g = ((hb & 0x07) << 5) | ((lb & 0xE0) >> 3);
-      uint8_t b = (hb & 0xF8);
-
-      /**
-       * Gamma corected rgb to greyscale formula: Y = 0.299R + 0.587G + 0.114B
-       * for effiency we use some tricks on this + quantize to [-128, 127]
-       */
-      int8_t grey_pixel = ((305 * r + 600 * g + 119 * b) >> 10) - 128;
-
-      image_data[i * kNumCols + j] = grey_pixel;
-
-      // to display
-      display_buf[2 * i * kNumCols * 2 + 2 * j] = pixel;
-      display_buf[2 * i * kNumCols * 2 + 2 * j + 1] = pixel;
-      display_buf[(2 * i + 1) * kNumCols * 2 + 2 * j] = pixel;
-      display_buf[(2 * i + 1) * kNumCols * 2 + 2 * j + 1] = pixel;
+  // Centre square of the frame, area-downscaled to the model input and
+  // quantized to int8 (luma - 128) in a single pass. Any CAMERA_FRAME_SIZE
+  // works, capturing at QVGA is cheaper than the per-pixel float loop was.
+  const int32_t side = fb->width < fb->height ? fb->width : fb->height;
+  const int32_t crop_x = (fb->width - side) / 2;
+  const int32_t crop_y = (fb->height - side) / 2;
+
+  // The frame shows the region of interest, zoomed by the sensor (frame
+  // size kept) or cropped by the driver. The first frame after a change
+  // may still show the previous region.
+  const float frame_x = roi.width ? roi.x : 0;
+  const float frame_y = roi.width ? roi.y : 0;
+  const float scale_x = (roi.width ? roi.width : resolution[CAMERA_FRAME_SIZE].width) / (float) fb->width;
+  const float scale_y = (roi.width ? roi.height : resolution[CAMERA_FRAME_SIZE].height) / (float) fb->height;
+  view_x = frame_x + crop_x * scale_x;
+  view_y = frame_y + crop_y * scale_y;
+  view_w = side * scale_x;
+  view_h = side * scale_y;
+
+  data_dims_t input_dims = {fb->width, fb->height, 1, 1};
+  data_dims_t output_dims = {image_width, image_height, 1, 1};
+  image_preprocess_params_t params;
+  SetPreprocessParams(fb, crop_x, crop_y, side, image_width, &params);
+  if (!AllocTensorBuf(&input_dims, &output_dims, &params)) {
+    esp_camera_fb_return(fb);
+    return kTfLiteError;
+  }
+  // index flip for tensor_to_float: 0 for int8 data, 0x80 for uint8 luma
+  uint8_t flip = 0;
+  if (fb->format == PIXFORMAT_JPEG) {
+    // Decoded MCU by MCU straight to the model size, lets the sensor run
+    // JPEG at high resolution without a full size RGB buffer
+    if (!jpg2gray_resized(fb->buf, fb->len, (uint8_t *) tensor_buf, image_width, image_height, true)) {
+      ESP_LOGE(TAG, "JPEG decode failed");
+      esp_camera_fb_return(fb);
+      return kTfLiteError;
     }
+    flip = 0x80;
+  } else {
+    esp_nn_preprocess_image_s8(fb->buf, &input_dims, &params, tensor_buf, &output_dims);
   }
-#else // DISPLAY_SUPPORT
-  // We have initialised camera to grayscale
-  // Just quantize to int8_t
-  printf("\n");
+
+  // The model takes float input, the int8 -> float step is a table lookup
   for (int i = 0; i < image_width * image_height; i++) {
-    // Convert the uint8_t pixel to float32
-    float pixel = static_cast<float>(((uint8_t *) fb->buf)[i]);
-    // Normalize the pixel data to 0-1 range if your model expects this range
-    image_data[i] = pixel / 255.0f;
-    // printf("%f, ", image_data[i]);
+    image_data[i] = tensor_to_float[((uint8_t) tensor_buf[i]) ^ flip];
   }
-  //printf("\n");
-#endif // DISPLAY_SUPPORT
 
-  esp_camera_return_all();
+#if DISPLAY_SUPPORT
+  // The display task shows the same crop 2x on its own time, holding a
+  // reference to the frame until then. It skips frames while busy, so the
+  // display never delays the model.
+  SharedFrame *frame = SharedFrameWrap(fb);
+  if (frame != NULL) {
+    DisplaySubmit(frame, crop_x, crop_y, side);
+    SharedFrameRelease(frame);
+  } else {
+    esp_camera_fb_return(fb);
+  }
+#else
+  esp_camera_fb_return(fb);
+#endif // DISPLAY_SUPPORT
   /* here the esp camera can give you grayscale image directly */
   return kTfLiteOk;
 #else
   return kTfLiteError;
 #endif
-}
\ No newline at end of file
+}
+
+TfLiteStatus AcquireImage(int* width, int* height) {
+#if ESP_CAMERA_SUPPORTED
+  if (held_fb == NULL) {
+    held_fb = esp_camera_fb_get_latest();
+    if (held_fb == NULL) {
+      ESP_LOGE(TAG, "Camera capture failed");
+      return kTfLiteError;
+    }
+    if (held_fb->format == PIXFORMAT_JPEG) {
+      ESP_LOGE(TAG, "Image windows need an uncompressed pixel format");
+      ReleaseImage();
+      return kTfLiteError;
+    }
+  }
+  *width = held_fb->width;
+  *height = held_fb->height;
+  return kTfLiteOk;
+#else
+  return kTfLiteError;
+#endif
+}
+
+TfLiteStatus GetImageWindow(int x, int y, int side, int image_width, int image_height, int8_t* image_data) {
+#if ESP_CAMERA_SUPPORTED
+  if (held_fb == NULL || x < 0 || y < 0 || side <= 0 ||
+      x + side > (int) held_fb->width || y + side > (int) held_fb->height) {
+    return kTfLiteError;
+  }
+  data_dims_t input_dims = {(int32_t) held_fb->width, (int32_t) held_fb->height, 1, 1};
+  data_dims_t output_dims = {image_width, image_height, 1, 1};
+  image_preprocess_params_t params;
+  SetPreprocessParams(held_fb, x, y, side, image_width, &params);
+  if (!AllocTensorBuf(&input_dims, &output_dims, &params)) {
+    return kTfLiteError;
+  }
+  esp_nn_preprocess_image_s8(held_fb->buf, &input_dims, &params, image_data, &output_dims);
+  return kTfLiteOk;
+#else
+  return kTfLiteError;
+#endif
+}
+
+void ImageWindowToInput(const int8_t* window, int count, float* image_data) {
+  for (int i = 0; i < count; i++) {
+    image_data[i] = tensor_to_float[(uint8_t) window[i]];
+  }
+}
+
+void ReleaseImage() {
+#if ESP_CAMERA_SUPPORTED
+  if (held_fb != NULL) {
+    esp_camera_fb_return(held_fb);
+    held_fb = NULL;
+  }
+#endif
+}
@@ -42,6 +42,29 @@ TfLiteStatus GetImage(int image_width, int image_height, int channels, float* im
 
 TfLiteStatus InitCamera();
 
+// Region of interest, in CAMERA_FRAME_SIZE pixels, that GetImage() hands to
+// the model at the image_width x image_height it is called with. The camera
+// zooms the sensor on it where the sensor can and crops while copying the
+// frame otherwise. A zero width goes back to the whole frame.
+TfLiteStatus SetImageRoi(int x, int y, int width, int height);
+
+// In tracking mode TrackImageRoi() moves the region, keeping its size, so that
+// it is centred on (center_x, center_y), given in 0..1 of the last image
+// GetImage() returned, e.g. where the last detection was.
+void SetImageRoiTracking(bool enable);
+void TrackImageRoi(float center_x, float center_y);
+
+// Several model inputs from one capture: AcquireImage() holds the newest
+// frame and reports its size, GetImageWindow() fills image_data with the
+// side x side square at (x, y) of it, resized to image_width x image_height
+// and quantized to int8 (luma - 128), and ReleaseImage() hands the frame back
+// to the camera. GetImageWindow() may run on another core than the model,
+// ImageWindowToInput() does the int8 -> float step of GetImage().
+TfLiteStatus AcquireImage(int* width, int* height);
+TfLiteStatus GetImageWindow(int x, int y, int side, int image_width, int image_height, int8_t* image_data);
+void ImageWindowToInput(const int8_t* window, int count, float* image_data);
+void ReleaseImage();
+
 #endif /* CONFIG_PERSON_DETECTION_STATIC */
 
 #endif  // TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_IMAGE_PROVIDER_H_
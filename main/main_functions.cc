@@ -2,19 +2,40 @@
 #include "detection_responder.h"
 #include "image_provider.h"
 #include "model_settings.h"
-#include "person_detect_model_data.h"
+#include "model_store.h"
+#include "multiscale_inference.h"
+#include "score_aggregator.h"
+#include "tensorflow/lite/micro/kernels/esp_nn_tune.h"
 #include "tensorflow/lite/micro/micro_interpreter.h"
 #include "tensorflow/lite/micro/micro_log.h"
 #include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 #include <esp_heap_caps.h>
+#include <algorithm>
+#include <inttypes.h>
+#include <new>
+#include <string.h>
 #include <esp_timer.h>
 #include <esp_log.h>
+#include "esp_app_desc.h"
 #include "esp_main.h"
 #include "esp_psram.h"
+#include "nvs.h"
+#include "nvs_flash.h"
 #include "driver/gpio.h"  // Incluir para el manejo del GPIO
+#if CONFIG_MODEL_UPDATE_ESPNOW || CONFIG_RESULT_BROADCAST_ESPNOW
+#include "espnow_link.h"
+#endif
+#if CONFIG_MODEL_UPDATE_ESPNOW
+#include "esp_event.h"
+#include "espnow_ota.h"
+#endif
+#if CONFIG_RESULT_BROADCAST_ESPNOW
+#include "result_broadcast.h"
+#endif
 
 #define FLASH_PIN GPIO_NUM_4  // Definir el pin del flash
 
@@ -35,6 +56,366 @@ constexpr int scratchBufSize = 0;
 
 static int kTensorArenaSize = 176 * 1024 + scratchBufSize;  // Reduced size for testing
 static uint8_t *tensor_arena;
+
+tflite::MicroMutableOpResolver<9> micro_op_resolver;
+
+// The interpreter is destroyed and built again here when the model changes
+alignas(tflite::MicroInterpreter) uint8_t interpreter_buffer[sizeof(tflite::MicroInterpreter)];
+ModelInfo active_model;
+// Held while the interpreter runs, a model swap waits for the inference
+SemaphoreHandle_t model_mutex = nullptr;
+bool nvs_ready = false;
+
+#ifndef CLI_ONLY_INFERENCE
+// A model sent over UART1 has to keep coming at least this often
+constexpr int kModelByteTimeoutMs = 2000;
+#endif
+
+#if CONFIG_NN_AUTOTUNE
+constexpr char kTuneNamespace[] = "nn_tune";
+
+// Identifies the model the stored kernel selection belongs to
+uint32_t ModelHash(const unsigned char* data, int len) {
+  uint32_t hash = 2166136261u;
+  for (int i = 0; i < len; i++) {
+    hash ^= data[i];
+    hash *= 16777619u;
+  }
+  return hash;
+}
+
+// Variant numbers and their eligibility are those of the esp-nn built into
+// this firmware, so the key also carries the start of the firmware's ELF hash
+void TuneKeyName(uint32_t model_hash, char* name, size_t size) {
+  const uint8_t* firmware = esp_app_get_description()->app_elf_sha256;
+  snprintf(name, size, "m%08" PRIx32 "%02x%02x%02x", model_hash, firmware[0], firmware[1], firmware[2]);
+}
+
+bool LoadTuneTable(uint32_t model_hash) {
+  nvs_handle_t handle;
+  if (nvs_open(kTuneNamespace, NVS_READONLY, &handle) != ESP_OK) {
+    return false;
+  }
+  char key[NVS_KEY_NAME_MAX_SIZE];
+  TuneKeyName(model_hash, key, sizeof(key));
+  static tflite::EspNnTuneEntry entries[tflite::kEspNnTuneMaxEntries];
+  size_t size = sizeof(entries);
+  esp_err_t err = nvs_get_blob(handle, key, entries, &size);
+  nvs_close(handle);
+  if (err != ESP_OK) {
+    return false;
+  }
+  return tflite::EspNnTuneLoadTable(entries, size / sizeof(entries[0]));
+}
+
+void SaveTuneTable(uint32_t model_hash) {
+  nvs_handle_t handle;
+  if (nvs_open(kTuneNamespace, NVS_READWRITE, &handle) != ESP_OK) {
+    return;
+  }
+  // Only keep the table of the current model
+  nvs_erase_all(handle);
+  char key[NVS_KEY_NAME_MAX_SIZE];
+  TuneKeyName(model_hash, key, sizeof(key));
+  int count = 0;
+  const tflite::EspNnTuneEntry* entries = tflite::EspNnTuneGetTable(&count);
+  esp_err_t err = nvs_set_blob(handle, key, entries, count * sizeof(entries[0]));
+  if (err == ESP_OK) {
+    err = nvs_commit(handle);
+  }
+  nvs_close(handle);
+  if (err != ESP_OK) {
+    printf("Failed to store kernel selection: %s\n", esp_err_to_name(err));
+  }
+}
+#endif  // CONFIG_NN_AUTOTUNE
+
+void DestroyInterpreter() {
+  if (interpreter != nullptr) {
+    interpreter->~MicroInterpreter();
+    interpreter = nullptr;
+    input = nullptr;
+  }
+}
+
+// Builds the interpreter for `info` in interpreter_buffer and checks that the
+// model takes a camera frame and scores the categories
+TfLiteStatus BuildInterpreter(const ModelInfo& info) {
+  model = tflite::GetModel(info.data);
+  if (model->version() != TFLITE_SCHEMA_VERSION) {
+    MicroPrintf("Model provided is schema version %d not equal to supported version %d.", model->version(), TFLITE_SCHEMA_VERSION);
+    return kTfLiteError;
+  }
+
+#if CONFIG_NN_AUTOTUNE
+  // Kernel selection has to be in place before AllocateTensors() runs Prepare
+  const uint32_t model_hash = ModelHash(info.data, info.size);
+  const bool tuned = nvs_ready && LoadTuneTable(model_hash);
+  if (!tuned) {
+    tflite::EspNnTuneResetTable();
+  }
+  tflite::EspNnTuneSetEnabled(!tuned);
+  printf("esp-nn kernel selection for model %08" PRIx32 ": %s\n", model_hash,
+         tuned ? "loaded from NVS" : "tuning on first inference");
+#endif
+
+  interpreter = new (interpreter_buffer) tflite::MicroInterpreter(model, micro_op_resolver, tensor_arena, kTensorArenaSize);
+
+  TfLiteStatus allocate_status = interpreter->AllocateTensors();
+  if (allocate_status != kTfLiteOk) {
+    MicroPrintf("AllocateTensors() failed");
+    DestroyInterpreter();
+    return kTfLiteError;
+  }
+
+  input = interpreter->input(0);
+  const TfLiteTensor* output = interpreter->output(0);
+  if (input->type != kTfLiteFloat32 || input->bytes != kNumCols * kNumRows * kNumChannels * sizeof(float) ||
+      output->type != kTfLiteFloat32 || output->bytes < kCategoryCount * sizeof(float)) {
+    MicroPrintf("Model does not map a %dx%dx%d float frame to %d float scores", kNumCols, kNumRows, kNumChannels,
+                kCategoryCount);
+    DestroyInterpreter();
+    return kTfLiteError;
+  }
+
+#if CONFIG_NN_AUTOTUNE
+  if (!tuned) {
+    // Warm-up inference times the kernel variants of every layer
+    memset(input->data.raw, 0, input->bytes);
+    if (interpreter->Invoke() == kTfLiteOk) {
+      tflite::EspNnTunePrintTable();
+      if (nvs_ready) {
+        SaveTuneTable(model_hash);
+      }
+    }
+    tflite::EspNnTuneSetEnabled(false);
+  }
+#endif
+
+#if CONFIG_MULTISCALE_INFERENCE && !defined(CLI_ONLY_INFERENCE)
+  if (MultiScaleInit(interpreter) != kTfLiteOk) {
+    MicroPrintf("MultiScaleInit failed\n");
+    DestroyInterpreter();
+    return kTfLiteError;
+  }
+#endif
+  return kTfLiteOk;
+}
+
+#if CONFIG_MODEL_UPDATE_ESPNOW
+// Points the ESP-NOW OTA responder at the slot the running model leaves free
+void StartModelResponder() {
+  espnow_ota_config_t config = {};
+  config.progress_report_interval = 10;
+  config.data_partition = ModelStoreNextPartition(active_model);
+  // A model packed as a delta by gen_custom_ota.py -b is made against the running one
+  config.data_base_partition = active_model.partition;
+  if (config.data_partition != nullptr) {
+    espnow_ota_responder_start(&config);
+  }
+}
+#endif
+
+#if !defined(CLI_ONLY_INFERENCE) || CONFIG_MODEL_UPDATE_ESPNOW
+// Makes the model written to `partition` the running one, once it matches
+// `sha_256` and the interpreter builds with it. The old model stays mapped
+// until then and is rebuilt if the new one is rejected.
+esp_err_t InstallModel(const esp_partition_t* partition, size_t size, const uint8_t sha_256[kModelHashSize]) {
+  xSemaphoreTake(model_mutex, portMAX_DELAY);
+  ModelInfo next;
+  esp_err_t err = ModelStoreCommit(partition, size, sha_256, active_model, &next);
+  if (err == ESP_OK) {
+    DestroyInterpreter();
+    if (BuildInterpreter(next) == kTfLiteOk) {
+      ModelStoreRelease(&active_model, false);
+      active_model = next;
+      MicroPrintf("Running model %d from %s", (int) active_model.sequence, active_model.partition->label);
+    } else {
+      ModelStoreRelease(&next, true);
+      err = ESP_ERR_NOT_SUPPORTED;
+      if (BuildInterpreter(active_model) != kTfLiteOk) {
+        MicroPrintf("The previous model doesn't build either");
+      }
+    }
+  }
+  xSemaphoreGive(model_mutex);
+
+#if CONFIG_MODEL_UPDATE_ESPNOW
+  StartModelResponder();
+#endif
+  return err;
+}
+#endif
+
+#ifndef CLI_ONLY_INFERENCE
+bool ParseHash(const char* hex, uint8_t hash[kModelHashSize]) {
+  if (strlen(hex) != 2 * kModelHashSize) {
+    return false;
+  }
+  for (size_t i = 0; i < kModelHashSize; i++) {
+    unsigned int byte;
+    if (sscanf(hex + 2 * i, "%2x", &byte) != 1) {
+      return false;
+    }
+    hash[i] = byte;
+  }
+  return true;
+}
+
+// "MODEL <size> <sha-256 hex>" on UART1. Answers "MODEL READY", takes <size>
+// raw bytes of a .tflite file into the free slot, then answers "MODEL OK
+// <sequence>" once it runs or "MODEL ERR <reason>".
+void ReceiveModel(const char* args) {
+  unsigned int size = 0;
+  char hex[2 * kModelHashSize + 1];
+  uint8_t sha_256[kModelHashSize];
+  if (sscanf(args, "%u %64s", &size, hex) != 2 || !ParseHash(hex, sha_256)) {
+    uart_send_string("MODEL ERR usage: MODEL <size> <sha-256 hex>\n");
+    return;
+  }
+
+  const esp_partition_t* partition = ModelStoreNextPartition(active_model);
+  esp_err_t err = partition != nullptr ? ModelStoreBegin(partition, size) : ESP_ERR_NOT_FOUND;
+  if (err == ESP_OK) {
+    uart_send_string("MODEL READY\n");
+    static uint8_t chunk[1024];
+    for (size_t offset = 0; err == ESP_OK && offset < size;) {
+      const int len = uart_receive_bytes(chunk, std::min<size_t>(sizeof(chunk), size - offset), kModelByteTimeoutMs);
+      if (len <= 0) {
+        err = ESP_ERR_TIMEOUT;
+        break;
+      }
+      err = ModelStoreWrite(partition, offset, chunk, len);
+      offset += len;
+    }
+  }
+  if (err == ESP_OK) {
+    err = InstallModel(partition, size, sha_256);
+  }
+
+  char reply[64];
+  if (err == ESP_OK) {
+    snprintf(reply, sizeof(reply), "MODEL OK %" PRIu32 "\n", active_model.sequence);
+  } else {
+    snprintf(reply, sizeof(reply), "MODEL ERR %s\n", esp_err_to_name(err));
+  }
+  MicroPrintf(reply);
+  uart_send_string(reply);
+}
+#endif
+
+#if CONFIG_MODEL_UPDATE_ESPNOW
+TaskHandle_t model_update_task = nullptr;
+
+void ModelOtaEventHandler(void* arg, esp_event_base_t base, int32_t id, void* data) {
+  xTaskNotifyGive(model_update_task);
+}
+
+// Installs what the responder received, off the event loop task. The
+// initiator only sends the first ESPNOW_OTA_HASH_LEN bytes of the SHA-256 of
+// the model, also when it sends the model packed.
+void ModelUpdateTask(void* arg) {
+  while (true) {
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    espnow_ota_status_t status;
+    size_t unpacked_size = 0;
+    if (espnow_ota_responder_get_status(&status) != ESP_OK
+        || espnow_ota_responder_get_unpacked_size(&unpacked_size) != ESP_OK) {
+      continue;
+    }
+    const esp_partition_t* partition = ModelStoreNextPartition(active_model);
+    const size_t size = unpacked_size ? unpacked_size : status.total_size;
+    uint8_t sha_256[kModelHashSize];
+    esp_err_t err = ModelStoreHash(partition, size, sha_256);
+    if (err == ESP_OK && memcmp(sha_256, status.sha_256, ESPNOW_OTA_HASH_LEN) != 0) {
+      err = ESP_ERR_INVALID_CRC;
+    }
+    if (err == ESP_OK) {
+      err = InstallModel(partition, size, sha_256);
+    }
+    if (err != ESP_OK) {
+      MicroPrintf("Model received over ESP-NOW rejected: %s", esp_err_to_name(err));
+    }
+  }
+}
+#endif
+
+#ifndef CLI_ONLY_INFERENCE
+// Captures a frame and runs the model on it
+TfLiteStatus ClassifyFrameLocked(float* sign_scores) {
+#if CONFIG_MULTISCALE_INFERENCE
+  MultiScaleResult result;
+  if (kTfLiteOk != MultiScaleDetect(&result)) {
+    MicroPrintf("Multi-scale inference failed.");
+    return kTfLiteError;
+  }
+  MicroPrintf("%d windows%s, best at %d,%d size %d", result.windows, result.early_exit ? " (early exit)" : "",
+              result.best_x, result.best_y, result.best_side);
+  for (int j = 0; j < kCategoryCount; ++j) {
+    sign_scores[j] = result.scores[j];
+  }
+#else
+  if (kTfLiteOk != GetImage(kNumCols, kNumRows, kNumChannels, input->data.f)) {
+    MicroPrintf("Image capture failed.");
+    return kTfLiteError;
+  }
+
+  if (kTfLiteOk != interpreter->Invoke()) {
+    MicroPrintf("Invoke failed.");
+    return kTfLiteError;
+  }
+
+  TfLiteTensor* output = interpreter->output(0);
+
+  for (int j = 0; j < kCategoryCount; ++j) {
+    sign_scores[j] = output->data.f[j];
+  }
+#endif
+  return kTfLiteOk;
+}
+
+TfLiteStatus ClassifyFrame(float* sign_scores) {
+  xSemaphoreTake(model_mutex, portMAX_DELAY);
+  TfLiteStatus status = interpreter != nullptr ? ClassifyFrameLocked(sign_scores) : kTfLiteError;
+#if CONFIG_RESULT_BROADCAST_ESPNOW
+  if (status == kTfLiteOk) {
+    ResultBroadcastPublish(sign_scores, active_model.sequence);
+  }
+#endif
+  xSemaphoreGive(model_mutex);
+  return status;
+}
+#endif
+
+#if CONFIG_RESULT_BROADCAST_ESPNOW && CONFIG_RESULT_BROADCAST_PERIOD_MS > 0 && !defined(CLI_ONLY_INFERENCE)
+// Keeps results coming between UART requests, ClassifyFrame() publishes them
+void ResultStreamTask(void* arg) {
+  TickType_t last_wake = xTaskGetTickCount();
+  while (true) {
+    float sign_scores[kCategoryCount];
+    ClassifyFrame(sign_scores);
+    vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(CONFIG_RESULT_BROADCAST_PERIOD_MS));
+  }
+}
+#endif
+
+#if CONFIG_TEMPORAL_SMOOTHING
+ScoreAggregatorConfig SmoothingConfig() {
+  ScoreAggregatorConfig config;
+#if CONFIG_SMOOTHING_EXPONENTIAL_DECAY
+  config.mode = SmoothingMode::kExponentialDecay;
+#endif
+  config.window_ms = CONFIG_SMOOTHING_WINDOW_MS;
+  config.detection_threshold = kDetectionThreshold;
+  config.release_threshold = CONFIG_SMOOTHING_RELEASE_PERCENT / 100.0f;
+  config.minimum_count = CONFIG_SMOOTHING_MIN_COUNT;
+  return config;
+}
+
+ScoreAggregator<kCategoryCount> aggregator(SmoothingConfig());
+constexpr int kMaxFrameFailures = 5;
+constexpr int kFrameRetryDelayMs = 100;
+#endif
 }  // namespace
 
 void setup() {
@@ -54,13 +435,6 @@ void setup() {
   esp_rom_gpio_pad_select_gpio(FLASH_PIN);
   gpio_set_direction(FLASH_PIN, GPIO_MODE_OUTPUT);
 
-  // Initialize model
-  model = tflite::GetModel(g_person_detect_model_data);
-  if (model->version() != TFLITE_SCHEMA_VERSION) {
-    MicroPrintf("Model provided is schema version %d not equal to supported version %d.", model->version(), TFLITE_SCHEMA_VERSION);
-    return;
-  }
-
   // Allocate tensor arena in PSRAM
   if (tensor_arena == NULL) {
     tensor_arena = (uint8_t *) heap_caps_malloc(kTensorArenaSize, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
@@ -73,7 +447,6 @@ void setup() {
   printf("Free PSRAM size after allocation: %d\n", heap_caps_get_free_size(MALLOC_CAP_SPIRAM));
 
   // Define MicroMutableOpResolver and add required operations
-  static tflite::MicroMutableOpResolver<7> micro_op_resolver;
   micro_op_resolver.AddQuantize(); 
   micro_op_resolver.AddConv2D();
   micro_op_resolver.AddMaxPool2D();
@@ -81,18 +454,16 @@ void setup() {
   micro_op_resolver.AddFullyConnected();
   micro_op_resolver.AddSoftmax();
   micro_op_resolver.AddDequantize();
-
-  // Build and allocate the interpreter
-  static tflite::MicroInterpreter static_interpreter(model, micro_op_resolver, tensor_arena, kTensorArenaSize);
-  interpreter = &static_interpreter;
-
-  TfLiteStatus allocate_status = interpreter->AllocateTensors();
-  if (allocate_status != kTfLiteOk) {
-    MicroPrintf("AllocateTensors() failed");
-    return;
+  // Only used by models rewritten with tools/esp_sparse_converter
+  micro_op_resolver.AddEspSparseConv2D();
+  micro_op_resolver.AddEspSparseFullyConnected();
+
+  esp_err_t nvs_err = nvs_flash_init();
+  if (nvs_err == ESP_ERR_NVS_NO_FREE_PAGES || nvs_err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+    nvs_flash_erase();
+    nvs_err = nvs_flash_init();
   }
-
-  input = interpreter->input(0);
+  nvs_ready = nvs_err == ESP_OK;
 
 #ifndef CLI_ONLY_INFERENCE
   TfLiteStatus init_status = InitCamera();
@@ -101,6 +472,39 @@ void setup() {
     return;
   }
 #endif
+
+  // Initialize model, the newest one in the model partitions that builds
+  model_mutex = xSemaphoreCreateMutex();
+  ModelStoreLoad(&active_model);
+  while (BuildInterpreter(active_model) != kTfLiteOk) {
+    if (active_model.partition == nullptr) {
+      return;
+    }
+    MicroPrintf("Dropping model %d from %s", (int) active_model.sequence, active_model.partition->label);
+    ModelStoreRelease(&active_model, true);
+    ModelStoreLoad(&active_model);
+  }
+
+#if CONFIG_MODEL_UPDATE_ESPNOW || CONFIG_RESULT_BROADCAST_ESPNOW
+  if (!nvs_ready || espnow_link_init() != ESP_OK) {
+    return;
+  }
+#endif
+
+#if CONFIG_MODEL_UPDATE_ESPNOW
+  xTaskCreate(ModelUpdateTask, "model_update", 4 * 1024, nullptr, uxTaskPriorityGet(nullptr), &model_update_task);
+  esp_event_handler_register(ESP_EVENT_ESPNOW, ESP_EVENT_ESPNOW_OTA_FINISH, ModelOtaEventHandler, nullptr);
+  StartModelResponder();
+#endif
+
+#if CONFIG_RESULT_BROADCAST_ESPNOW
+  if (ResultBroadcastInit(CONFIG_RESULT_BROADCAST_GROUP) == ESP_OK) {
+#if CONFIG_RESULT_BROADCAST_PERIOD_MS > 0 && !defined(CLI_ONLY_INFERENCE)
+    // Below the UART requests, which get the camera first
+    xTaskCreate(ResultStreamTask, "result_stream", 4 * 1024, nullptr, uxTaskPriorityGet(nullptr) - 1, nullptr);
+#endif
+  }
+#endif
 }
 
 #ifndef CLI_ONLY_INFERENCE
@@ -115,6 +519,11 @@ void loop() {
     // Esperar a recibir un mensaje UART
     uart_receive_string(rx_buffer, sizeof(rx_buffer));
 
+    if (strncmp(rx_buffer, "MODEL ", 6) == 0) {
+      ReceiveModel(rx_buffer + 6);
+      continue;
+    }
+
     // Si estamos inferenciando, no enviar mensajes
     if (is_inferencing) {
       ESP_LOGI("Main Loop", "Skipping UART send as inference is in progress.");
@@ -129,25 +538,54 @@ void loop() {
     vTaskDelay(10 / portTICK_PERIOD_MS);
     gpio_set_level(FLASH_PIN, 0);
 
-    // Realizar la inferencia de las cuatro fotos
-    int max_score_indices[4];
+#if CONFIG_TEMPORAL_SMOOTHING
+    // Clasificar fotos seguidas hasta la primera detección
     is_inferencing = true;  // Marcar como en inferencia
-    for (int i = 0; i < 4; ++i) {
-      if (kTfLiteOk != GetImage(kNumCols, kNumRows, kNumChannels, input->data.f)) {
-        MicroPrintf("Image capture failed.");
-        continue;  // Agregar manejo de errores
+    aggregator.ResetWindow();
+    const int64_t start_us = esp_timer_get_time();
+    int frames = 0;
+    int failures = 0;
+    int detected = -1;
+    float detected_score = 0;
+    while (esp_timer_get_time() - start_us < CONFIG_SMOOTHING_TIMEOUT_MS * 1000LL) {
+      float sign_scores[kCategoryCount];
+      if (kTfLiteOk != ClassifyFrame(sign_scores)) {
+        // Give the camera time to recover, and give up if it does not
+        if (++failures >= kMaxFrameFailures) {
+          MicroPrintf("Giving up after %d failed frames", failures);
+          break;
+        }
+        vTaskDelay(kFrameRetryDelayMs / portTICK_PERIOD_MS);
+        continue;
       }
-
-      if (kTfLiteOk != interpreter->Invoke()) {
-        MicroPrintf("Invoke failed.");
-        continue;  // Agregar manejo de errores
+      failures = 0;
+      frames++;
+      ScoreAggregator<kCategoryCount>::Result result;
+      // Time since boot, so that suppression carries over between requests
+      const int64_t now_ms = esp_timer_get_time() / 1000;
+      if (kTfLiteOk == aggregator.ProcessLatestResults(sign_scores, now_ms, &result) && result.is_new) {
+        detected = result.active;
+        detected_score = result.score;
+        break;
       }
+    }
+    is_inferencing = false;  // Marcar como no en inferencia
 
-      TfLiteTensor* output = interpreter->output(0);
-
+    if (detected >= 0) {
+      MicroPrintf("Detected sign: %s (%f) after %d frames", kCategoryLabels[detected], detected_score, frames);
+    } else {
+      MicroPrintf("No sign detected in %d frames", frames);
+    }
+    char message[50];
+    snprintf(message, sizeof(message), "Detected sign index: %d\n", detected);
+#else
+    // Realizar la inferencia de las cuatro fotos
+    int max_score_indices[4];
+    is_inferencing = true;  // Marcar como en inferencia
+    for (int i = 0; i < 4; ++i) {
       float sign_scores[kCategoryCount];
-      for (int j = 0; j < kCategoryCount; ++j) {
-        sign_scores[j] = output->data.f[j];
+      if (kTfLiteOk != ClassifyFrame(sign_scores)) {
+        continue;  // Agregar manejo de errores
       }
 
       max_score_indices[i] = RespondToDetection(sign_scores, kCategoryLabels);
@@ -157,6 +595,7 @@ void loop() {
 
     char message[50];
     snprintf(message, sizeof(message), "Max score indices: %d, %d, %d, %d\n", max_score_indices[0], max_score_indices[1], max_score_indices[2], max_score_indices[3]);
+#endif
     MicroPrintf(message);
     vTaskDelay(1000 / portTICK_PERIOD_MS);
     uart_send_string(message);
@@ -166,6 +605,12 @@ void loop() {
 
 #ifdef CLI_ONLY_INFERENCE
 void run_inference(void *ptr) {
+  xSemaphoreTake(model_mutex, portMAX_DELAY);
+  if (interpreter == nullptr) {
+    xSemaphoreGive(model_mutex);
+    return;
+  }
+
   /* Convert from uint8 picture data to float */
   for (int i = 0; i < kNumCols * kNumRows; i++) {
       input->data.f[i] = ((float*) ptr)[i];
@@ -190,6 +635,7 @@ void run_inference(void *ptr) {
   for (int i = 0; i < kCategoryCount; ++i) {
     sign_scores[i] = output->data.f[i];
   }
+  xSemaphoreGive(model_mutex);
   RespondToDetection(sign_scores, kCategoryLabels);
 }
 #endif
\ No newline at end of file
@@ -0,0 +1,180 @@
+#include "model_store.h"
+
+#include <inttypes.h>
+#include <string.h>
+
+#include "esp_log.h"
+#include "mbedtls/sha256.h"
+
+#include "person_detect_model_data.h"
+
+namespace {
+const char* TAG = "model_store";
+
+constexpr esp_partition_subtype_t kModelSubtype = static_cast<esp_partition_subtype_t>(0x40);
+constexpr const char* kSlotLabels[] = {"model_0", "model_1"};
+constexpr size_t kSlotCount = sizeof(kSlotLabels) / sizeof(kSlotLabels[0]);
+constexpr size_t kSectorSize = 4096;
+constexpr uint32_t kTrailerMagic = 0x4c444f4d;  // "MODL"
+
+struct ModelTrailer {
+  uint32_t magic;
+  uint32_t sequence;
+  uint32_t size;
+  uint8_t sha_256[kModelHashSize];
+};
+
+const esp_partition_t* Slot(size_t index) {
+  return esp_partition_find_first(ESP_PARTITION_TYPE_DATA, kModelSubtype, kSlotLabels[index]);
+}
+
+size_t TrailerOffset(const esp_partition_t* partition) {
+  return partition->size - kSectorSize;
+}
+
+// Maps the slot and checks the model in it against the trailer
+bool MapSlot(const esp_partition_t* partition, ModelInfo* info) {
+  ModelTrailer trailer;
+  if (esp_partition_read(partition, TrailerOffset(partition), &trailer, sizeof(trailer)) != ESP_OK
+      || trailer.magic != kTrailerMagic || trailer.size == 0 || trailer.size > ModelStoreCapacity(partition)) {
+    return false;
+  }
+
+  const void* data = nullptr;
+  esp_partition_mmap_handle_t mapping;
+  esp_err_t err = esp_partition_mmap(partition, 0, trailer.size, ESP_PARTITION_MMAP_DATA, &data, &mapping);
+  if (err != ESP_OK) {
+    ESP_LOGW(TAG, "Couldn't map %s: %s", partition->label, esp_err_to_name(err));
+    return false;
+  }
+
+  uint8_t sha_256[kModelHashSize];
+  if (mbedtls_sha256(static_cast<const unsigned char*>(data), trailer.size, sha_256, 0) != 0
+      || memcmp(sha_256, trailer.sha_256, kModelHashSize) != 0) {
+    ESP_LOGW(TAG, "%s: hash mismatch", partition->label);
+    esp_partition_munmap(mapping);
+    return false;
+  }
+
+  info->data = static_cast<const unsigned char*>(data);
+  info->size = trailer.size;
+  info->sequence = trailer.sequence;
+  info->partition = partition;
+  info->mapping = mapping;
+  return true;
+}
+}  // namespace
+
+void ModelStoreLoad(ModelInfo* info) {
+  info->data = g_person_detect_model_data;
+  info->size = g_person_detect_model_data_len;
+  info->sequence = 0;
+  info->partition = nullptr;
+  info->mapping = 0;
+
+  for (size_t i = 0; i < kSlotCount; i++) {
+    const esp_partition_t* partition = Slot(i);
+    ModelInfo slot;
+    if (partition == nullptr || !MapSlot(partition, &slot)) {
+      continue;
+    }
+    if (slot.sequence > info->sequence) {
+      ModelStoreRelease(info, false);
+      *info = slot;
+    } else {
+      ModelStoreRelease(&slot, false);
+    }
+  }
+
+  if (info->partition) {
+    ESP_LOGI(TAG, "Model %" PRIu32 " from %s, %u bytes", info->sequence, info->partition->label,
+             static_cast<unsigned>(info->size));
+  } else {
+    ESP_LOGI(TAG, "Compiled in model, %u bytes", static_cast<unsigned>(info->size));
+  }
+}
+
+const esp_partition_t* ModelStoreNextPartition(const ModelInfo& active) {
+  const esp_partition_t* first = Slot(0);
+  return active.partition == first ? Slot(1) : first;
+}
+
+size_t ModelStoreCapacity(const esp_partition_t* partition) {
+  return partition->size > kSectorSize ? TrailerOffset(partition) : 0;
+}
+
+esp_err_t ModelStoreHash(const esp_partition_t* partition, size_t size, uint8_t sha_256[kModelHashSize]) {
+  if (size == 0 || size > ModelStoreCapacity(partition)) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+
+  const void* data = nullptr;
+  esp_partition_mmap_handle_t mapping;
+  esp_err_t err = esp_partition_mmap(partition, 0, size, ESP_PARTITION_MMAP_DATA, &data, &mapping);
+  if (err != ESP_OK) {
+    return err;
+  }
+  if (mbedtls_sha256(static_cast<const unsigned char*>(data), size, sha_256, 0) != 0) {
+    err = ESP_FAIL;
+  }
+  esp_partition_munmap(mapping);
+  return err;
+}
+
+esp_err_t ModelStoreBegin(const esp_partition_t* partition, size_t size) {
+  if (size == 0 || size > ModelStoreCapacity(partition)) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  return esp_partition_erase_range(partition, 0, (size + kSectorSize - 1) & ~(kSectorSize - 1));
+}
+
+esp_err_t ModelStoreWrite(const esp_partition_t* partition, size_t offset, const void* data, size_t size) {
+  if (offset + size > ModelStoreCapacity(partition)) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+  return esp_partition_write(partition, offset, data, size);
+}
+
+esp_err_t ModelStoreCommit(const esp_partition_t* partition, size_t size, const uint8_t sha_256[kModelHashSize],
+                           const ModelInfo& active, ModelInfo* info) {
+  if (partition == active.partition) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (size == 0 || size > ModelStoreCapacity(partition)) {
+    return ESP_ERR_INVALID_SIZE;
+  }
+
+  ModelTrailer trailer = {};
+  trailer.magic = kTrailerMagic;
+  trailer.sequence = active.sequence + 1;
+  trailer.size = size;
+  memcpy(trailer.sha_256, sha_256, kModelHashSize);
+
+  esp_err_t err = esp_partition_erase_range(partition, TrailerOffset(partition), kSectorSize);
+  if (err == ESP_OK) {
+    err = esp_partition_write(partition, TrailerOffset(partition), &trailer, sizeof(trailer));
+  }
+  if (err != ESP_OK) {
+    return err;
+  }
+
+  // Hashes what the flash holds, not what was meant to be written
+  if (!MapSlot(partition, info)) {
+    esp_partition_erase_range(partition, TrailerOffset(partition), kSectorSize);
+    return ESP_ERR_INVALID_CRC;
+  }
+  return ESP_OK;
+}
+
+void ModelStoreRelease(ModelInfo* info, bool discard) {
+  if (info->partition == nullptr) {
+    return;
+  }
+  esp_partition_munmap(info->mapping);
+  if (discard) {
+    esp_partition_erase_range(info->partition, TrailerOffset(info->partition), kSectorSize);
+  }
+  info->partition = nullptr;
+  info->data = nullptr;
+  info->size = 0;
+}
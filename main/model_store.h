@@ -0,0 +1,54 @@
+#ifndef TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_MODEL_STORE_H_
+#define TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_MODEL_STORE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_partition.h"
+
+// Models stored in the model_0 and model_1 partitions, see partitions.csv.
+// A slot holds the flatbuffer from its start and a trailer in its last
+// sector with the size, SHA-256 and a sequence number of the model. The
+// trailer is written last, so a slot is only valid once the whole model is
+// there. The newest valid slot is memory-mapped and used in place, the
+// model compiled into the app is the fallback when neither is valid.
+
+constexpr size_t kModelHashSize = 32;
+
+struct ModelInfo {
+  const unsigned char* data;
+  size_t size;
+  uint32_t sequence;                   // 0 for the compiled in model
+  const esp_partition_t* partition;    // nullptr for the compiled in model
+  esp_partition_mmap_handle_t mapping;
+};
+
+// Maps the newest valid slot into *info, or points it at the compiled in model
+void ModelStoreLoad(ModelInfo* info);
+
+// The slot a new model goes to, the one `active` does not use. Whatever
+// writes it does not have to erase the trailer, a stale one fails the hash.
+const esp_partition_t* ModelStoreNextPartition(const ModelInfo& active);
+
+// Largest model that fits in a slot
+size_t ModelStoreCapacity(const esp_partition_t* partition);
+
+// SHA-256 of the first `size` bytes of `partition`, for a model that came
+// with only part of its hash, e.g. over ESP-NOW
+esp_err_t ModelStoreHash(const esp_partition_t* partition, size_t size, uint8_t sha_256[kModelHashSize]);
+
+// Erases the first `size` bytes of `partition` for ModelStoreWrite()
+esp_err_t ModelStoreBegin(const esp_partition_t* partition, size_t size);
+esp_err_t ModelStoreWrite(const esp_partition_t* partition, size_t offset, const void* data, size_t size);
+
+// Checks the first `size` bytes of `partition` against `sha_256`, then writes
+// the trailer so the slot is newer than `active` and maps it into *info
+esp_err_t ModelStoreCommit(const esp_partition_t* partition, size_t size, const uint8_t sha_256[kModelHashSize],
+                           const ModelInfo& active, ModelInfo* info);
+
+// Unmaps a model no longer in use. With `discard` its trailer is erased as
+// well, so it is not loaded again at the next boot.
+void ModelStoreRelease(ModelInfo* info, bool discard);
+
+#endif  // TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_MODEL_STORE_H_
@@ -0,0 +1,186 @@
+#include "multiscale_inference.h"
+
+#include <algorithm>
+#include <climits>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp_log.h"
+
+#include "detection_responder.h"
+#include "image_provider.h"
+#include "esp_main.h"
+
+#if CONFIG_MULTISCALE_INFERENCE
+
+namespace {
+const char* TAG = "multiscale";
+
+constexpr int kMaxWindows = 64;
+constexpr int kWindowSize = kNumCols * kNumRows * kNumChannels;
+
+struct Window {
+  int16_t x;
+  int16_t y;
+  int16_t side;
+};
+
+tflite::MicroInterpreter* interpreter = nullptr;
+Window windows[kMaxWindows];
+int window_count = 0;
+int planned_width = 0;
+int planned_height = 0;
+
+// Model input of two consecutive windows, the next one is prepared while the
+// model runs on the current one
+int8_t window_buf[2][kWindowSize];
+volatile TfLiteStatus prepare_status = kTfLiteOk;
+
+#if CONFIG_MULTISCALE_DUAL_CORE
+TaskHandle_t prepare_task = nullptr;
+SemaphoreHandle_t prepared = nullptr;
+#endif
+
+void PlanWindows(int width, int height) {
+  window_count = 0;
+  int side = std::min(width, height);
+  for (int level = 0; level < CONFIG_MULTISCALE_LEVELS && side >= kNumCols; level++) {
+    // half overlap, the spare pixels are spread evenly between the windows
+    const int stride = side / 2;
+    const int nx = (width - side + stride - 1) / stride + 1;
+    const int ny = (height - side + stride - 1) / stride + 1;
+    for (int j = 0; j < ny; j++) {
+      for (int i = 0; i < nx && window_count < kMaxWindows; i++) {
+        Window& w = windows[window_count++];
+        w.x = nx > 1 ? i * (width - side) / (nx - 1) : (width - side) / 2;
+        w.y = ny > 1 ? j * (height - side) / (ny - 1) : (height - side) / 2;
+        w.side = side;
+      }
+    }
+    side = side * 2 / 3;
+  }
+  planned_width = width;
+  planned_height = height;
+  ESP_LOGI(TAG, "%d windows over %dx%d", window_count, width, height);
+}
+
+TfLiteStatus PrepareWindow(int index) {
+  const Window& w = windows[index];
+  return GetImageWindow(w.x, w.y, w.side, kNumCols, kNumRows, window_buf[index & 1]);
+}
+
+#if CONFIG_MULTISCALE_DUAL_CORE
+void PrepareTask(void* arg) {
+  while (true) {
+    uint32_t index;
+    xTaskNotifyWait(0, ULONG_MAX, &index, portMAX_DELAY);
+    prepare_status = PrepareWindow(index);
+    xSemaphoreGive(prepared);
+  }
+}
+#endif
+
+// Window `index` into window_buf[index & 1], on core 1 when there is one
+void StartPrepare(int index) {
+#if CONFIG_MULTISCALE_DUAL_CORE
+  xTaskNotify(prepare_task, index, eSetValueWithOverwrite);
+#else
+  prepare_status = PrepareWindow(index);
+#endif
+}
+
+TfLiteStatus WaitPrepared() {
+#if CONFIG_MULTISCALE_DUAL_CORE
+  xSemaphoreTake(prepared, portMAX_DELAY);
+#endif
+  return prepare_status;
+}
+}  // namespace
+
+TfLiteStatus MultiScaleInit(tflite::MicroInterpreter* model_interpreter) {
+  const TfLiteTensor* input = model_interpreter->input(0);
+  if (input->type != kTfLiteFloat32 || input->bytes != kWindowSize * sizeof(float)) {
+    ESP_LOGE(TAG, "Model input is not %dx%dx%d float", kNumCols, kNumRows, kNumChannels);
+    return kTfLiteError;
+  }
+  interpreter = model_interpreter;
+#if CONFIG_MULTISCALE_DUAL_CORE
+  if (prepare_task == nullptr) {
+    prepared = xSemaphoreCreateBinary();
+    if (prepared == nullptr ||
+        xTaskCreatePinnedToCore(PrepareTask, "ms_prepare", 4 * 1024, nullptr, uxTaskPriorityGet(nullptr),
+                                &prepare_task, 1) != pdPASS) {
+      ESP_LOGE(TAG, "Couldn't start the window task");
+      return kTfLiteError;
+    }
+  }
+#endif
+  return kTfLiteOk;
+}
+
+TfLiteStatus MultiScaleDetect(MultiScaleResult* result) {
+  *result = {};
+  if (interpreter == nullptr) {
+    return kTfLiteError;
+  }
+  int width, height;
+  if (AcquireImage(&width, &height) != kTfLiteOk) {
+    return kTfLiteError;
+  }
+  if (width != planned_width || height != planned_height) {
+    PlanWindows(width, height);
+  }
+  if (window_count == 0) {
+    ESP_LOGE(TAG, "%dx%d frame is smaller than the model input", width, height);
+    ReleaseImage();
+    return kTfLiteError;
+  }
+
+  float* input = interpreter->input(0)->data.f;
+  float best = -1.0f;
+  TfLiteStatus status = kTfLiteOk;
+  StartPrepare(0);
+  for (int i = 0; i < window_count; i++) {
+    status = WaitPrepared();
+    if (status != kTfLiteOk) {
+      break;
+    }
+    ImageWindowToInput(window_buf[i & 1], kWindowSize, input);
+    const bool more = i + 1 < window_count;
+    if (more) {
+      StartPrepare(i + 1);
+    }
+    status = interpreter->Invoke();
+
+    float window_best = 0.0f;
+    if (status == kTfLiteOk) {
+      const float* scores = interpreter->output(0)->data.f;
+      for (int c = 0; c < kCategoryCount; c++) {
+        result->scores[c] = std::max(result->scores[c], scores[c]);
+        window_best = std::max(window_best, scores[c]);
+      }
+      result->windows++;
+      if (window_best > best) {
+        best = window_best;
+        result->best_x = windows[i].x;
+        result->best_y = windows[i].y;
+        result->best_side = windows[i].side;
+      }
+#if CONFIG_MULTISCALE_EARLY_EXIT
+      result->early_exit = window_best > kDetectionThreshold;
+#endif
+    }
+    if (status != kTfLiteOk || result->early_exit) {
+      if (more) {
+        // the frame goes back to the camera only once core 1 is done with it
+        WaitPrepared();
+      }
+      break;
+    }
+  }
+  ReleaseImage();
+  return status;
+}
+
+#endif  // CONFIG_MULTISCALE_INFERENCE
@@ -0,0 +1,33 @@
+#ifndef TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_MULTISCALE_INFERENCE_H_
+#define TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_MULTISCALE_INFERENCE_H_
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "model_settings.h"
+
+// Sliding window inference over an image pyramid of one capture. Every
+// scale is a square window size, the largest being the whole frame height,
+// and the windows of a scale overlap by half. Each window is area-resized
+// straight from the frame to the model input, which samples the pyramid
+// level without storing it. All windows go through the same interpreter,
+// in the order coarse to fine.
+
+struct MultiScaleResult {
+  float scores[kCategoryCount];  // per category, the best over all windows
+  int windows;                   // windows classified
+  bool early_exit;               // stopped on a window above kDetectionThreshold
+  // frame pixels of the window with the highest score
+  int best_x;
+  int best_y;
+  int best_side;
+};
+
+// Plans the windows and, with CONFIG_MULTISCALE_DUAL_CORE, starts the task
+// preparing them on core 1. Call after AllocateTensors(), and again whenever
+// the interpreter is built for another model.
+TfLiteStatus MultiScaleInit(tflite::MicroInterpreter* interpreter);
+
+// Captures a frame and classifies its windows
+TfLiteStatus MultiScaleDetect(MultiScaleResult* result);
+
+#endif  // TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_MULTISCALE_INFERENCE_H_
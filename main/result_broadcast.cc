@@ -0,0 +1,165 @@
+#include "result_broadcast.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "esp_log.h"
+#include "esp_mac.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+#include "freertos/task.h"
+
+#include "espnow.h"
+#include "model_settings.h"
+
+namespace {
+const char* TAG = "result_broadcast";
+
+constexpr uint8_t kGroupPrefix[] = {0x02, 'R', 'E', 'S'};
+
+#if CONFIG_RESULT_BROADCAST_ESPNOW
+constexpr size_t kRecordSize = kResultRecordHeaderSize + kCategoryCount;
+constexpr int kBatchSize =
+    std::min<int>(CONFIG_RESULT_BROADCAST_BATCH, (ESPNOW_DATA_LEN - kResultFrameHeaderSize) / kRecordSize);
+constexpr int kSendTimeoutMs = 100;
+
+struct PendingResult {
+  uint32_t sequence;
+  uint32_t time_ms;
+  uint8_t model;
+  uint8_t argmax;
+  int8_t scores[kCategoryCount];
+};
+
+QueueHandle_t result_queue = nullptr;
+uint32_t next_sequence = 0;
+
+uint8_t destination[6];
+espnow_frame_head_t frame_head = {};
+uint8_t frame[kResultFrameHeaderSize + kBatchSize * kRecordSize];
+ResultFrameWriter writer(frame, sizeof(frame), kCategoryCount);
+
+void SendFrame() {
+  esp_err_t err = espnow_send(ESPNOW_DATA_TYPE_DATA, destination, writer.data(), writer.size(), &frame_head,
+                              pdMS_TO_TICKS(kSendTimeoutMs));
+  if (err != ESP_OK) {
+    ESP_LOGW(TAG, "%d results not sent: %s", writer.record_count(), esp_err_to_name(err));
+  }
+  writer.Clear();
+}
+
+// Sends a frame once it is full, or once its first record waited
+// CONFIG_RESULT_BROADCAST_MAX_DELAY_MS
+void PublishTask(void* arg) {
+  const TickType_t max_delay = pdMS_TO_TICKS(CONFIG_RESULT_BROADCAST_MAX_DELAY_MS);
+  TickType_t frame_start = 0;
+  while (true) {
+    TickType_t wait = portMAX_DELAY;
+    if (writer.record_count() > 0) {
+      const TickType_t waited = xTaskGetTickCount() - frame_start;
+      wait = waited < max_delay ? max_delay - waited : 0;
+    }
+
+    PendingResult result;
+    if (xQueueReceive(result_queue, &result, wait) != pdTRUE) {
+      SendFrame();
+      continue;
+    }
+    const ResultRecord record = {result.sequence, result.time_ms, result.model, result.argmax, kCategoryCount, result.scores};
+    if (writer.record_count() > 0 && !writer.Fits(record)) {
+      SendFrame();
+    }
+    if (writer.record_count() == 0) {
+      frame_start = xTaskGetTickCount();
+    }
+    writer.Append(record);
+    if (writer.record_count() == kBatchSize) {
+      SendFrame();
+    }
+  }
+}
+#endif
+
+ResultHandler result_handler = nullptr;
+
+esp_err_t ReceiveResults(uint8_t* src_addr, void* data, size_t size, wifi_pkt_rx_ctrl_t* rx_ctrl) {
+  ResultFrameReader reader;
+  if (!reader.Init(static_cast<const uint8_t*>(data), size)) {
+    return ESP_ERR_NOT_SUPPORTED;
+  }
+  ResultRecord record;
+  while (reader.Next(&record)) {
+    result_handler(src_addr, record);
+  }
+  return ESP_OK;
+}
+}  // namespace
+
+void ResultGroupAddress(uint16_t group, uint8_t address[6]) {
+  if (group == 0) {
+    memcpy(address, ESPNOW_ADDR_BROADCAST, 6);
+    return;
+  }
+  memcpy(address, kGroupPrefix, sizeof(kGroupPrefix));
+  address[4] = group >> 8;
+  address[5] = group;
+}
+
+#if CONFIG_RESULT_BROADCAST_ESPNOW
+esp_err_t ResultBroadcastInit(uint16_t group) {
+  if (result_queue != nullptr) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  ResultGroupAddress(group, destination);
+  frame_head.broadcast = true;
+  frame_head.group = group != 0;
+  // A lost frame is not worth repeating, the next one has newer results
+  frame_head.retransmit_count = 1;
+
+  result_queue = xQueueCreate(2 * kBatchSize, sizeof(PendingResult));
+  if (result_queue == nullptr) {
+    return ESP_ERR_NO_MEM;
+  }
+  if (xTaskCreate(PublishTask, "result_pub", 3 * 1024, nullptr, uxTaskPriorityGet(nullptr), nullptr) != pdPASS) {
+    vQueueDelete(result_queue);
+    result_queue = nullptr;
+    return ESP_ERR_NO_MEM;
+  }
+  ESP_LOGI(TAG, "Publishing to " MACSTR ", %d results per frame", MAC2STR(destination), kBatchSize);
+  return ESP_OK;
+}
+
+void ResultBroadcastPublish(const float* scores, uint32_t model_sequence) {
+  if (result_queue == nullptr) {
+    return;
+  }
+  PendingResult result;
+  result.sequence = next_sequence++;
+  result.time_ms = esp_timer_get_time() / 1000;
+  result.model = model_sequence;
+  result.argmax = std::max_element(scores, scores + kCategoryCount) - scores;
+  for (int i = 0; i < kCategoryCount; ++i) {
+    result.scores[i] = std::clamp(lroundf(scores[i] * 256) - 128, -128L, 127L);
+  }
+  xQueueSend(result_queue, &result, 0);
+}
+#endif
+
+esp_err_t ResultBroadcastSubscribe(uint16_t group, ResultHandler handler) {
+  if (handler == nullptr) {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (group != 0) {
+    uint8_t address[6];
+    ResultGroupAddress(group, address);
+    esp_err_t err = espnow_add_group(address);
+    if (err != ESP_OK) {
+      return err;
+    }
+  }
+  result_handler = handler;
+  return espnow_set_config_for_data_type(ESPNOW_DATA_TYPE_DATA, true, ReceiveResults);
+}
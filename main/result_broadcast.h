@@ -0,0 +1,37 @@
+#ifndef TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_RESULT_BROADCAST_H_
+#define TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_RESULT_BROADCAST_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "result_frame.h"
+
+// Classification results sent over ESP-NOW as ESPNOW_DATA_TYPE_DATA
+// broadcasts, to a group when one is set, so that one gateway can follow
+// many cameras. Each frame batches consecutive results of one camera, see
+// result_frame.h for the format.
+//
+// A gap in the sequences a gateway sees is results lost on the air or
+// dropped by a busy camera.
+
+// The group of `group` is a locally administered address ending in it,
+// 0 is plain broadcast to every node in range
+void ResultGroupAddress(uint16_t group, uint8_t address[6]);
+
+// Starts the task that batches and sends what ResultBroadcastPublish()
+// gets. Needs ESP-NOW to be initialized.
+esp_err_t ResultBroadcastInit(uint16_t group);
+
+// Queues the result of a frame without waiting for the radio. Results
+// that find the queue full are dropped and leave a gap in the sequence.
+void ResultBroadcastPublish(const float* scores, uint32_t model_sequence);
+
+// Called for every record received, from the ESP-NOW receive task
+using ResultHandler = void (*)(const uint8_t* src_addr, const ResultRecord& record);
+
+// Gateway side: joins `group` and passes the records of every result
+// frame to `handler`. Takes over the ESPNOW_DATA_TYPE_DATA handler.
+esp_err_t ResultBroadcastSubscribe(uint16_t group, ResultHandler handler);
+
+#endif  // TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_RESULT_BROADCAST_H_
@@ -0,0 +1,81 @@
+#include "result_frame.h"
+
+#include <string.h>
+
+namespace {
+
+uint16_t GetU16(const uint8_t* p) { return p[0] | p[1] << 8; }
+
+uint32_t GetU32(const uint8_t* p) { return GetU16(p) | static_cast<uint32_t>(GetU16(p + 2)) << 16; }
+
+void PutU16(uint8_t* p, uint16_t value) {
+  p[0] = value;
+  p[1] = value >> 8;
+}
+
+void PutU32(uint8_t* p, uint32_t value) {
+  PutU16(p, value);
+  PutU16(p + 2, value >> 16);
+}
+
+}  // namespace
+
+size_t ResultFrameWriter::size() const {
+  return record_count_ == 0 ? 0 : kResultFrameHeaderSize + record_count_ * record_size();
+}
+
+bool ResultFrameWriter::Fits(const ResultRecord& record) const {
+  if (record.category_count != category_count_ || record_count_ == UINT8_MAX
+      || kResultFrameHeaderSize + (record_count_ + 1) * record_size() > capacity_) {
+    return false;
+  }
+  return record_count_ == 0
+      || (record.sequence == GetU32(data_ + 4) + record_count_ && record.model == data_[3]
+          && record.time_ms - GetU32(data_ + 8) <= UINT16_MAX);
+}
+
+bool ResultFrameWriter::Append(const ResultRecord& record) {
+  if (!Fits(record)) {
+    return false;
+  }
+  if (record_count_ == 0) {
+    data_[0] = kResultFrameVersion;
+    data_[1] = category_count_;
+    data_[3] = record.model;
+    PutU32(data_ + 4, record.sequence);
+    PutU32(data_ + 8, record.time_ms);
+  }
+  uint8_t* p = data_ + kResultFrameHeaderSize + record_count_ * record_size();
+  PutU16(p, record.time_ms - GetU32(data_ + 8));
+  p[2] = record.argmax;
+  memcpy(p + kResultRecordHeaderSize, record.scores, category_count_);
+  data_[2] = ++record_count_;
+  return true;
+}
+
+bool ResultFrameReader::Init(const uint8_t* data, size_t size) {
+  if (size < kResultFrameHeaderSize || data[0] != kResultFrameVersion || data[1] == 0
+      || size != kResultFrameHeaderSize + data[2] * (kResultRecordHeaderSize + data[1])) {
+    return false;
+  }
+  data_ = data;
+  category_count_ = data[1];
+  record_count_ = data[2];
+  next_ = 0;
+  return true;
+}
+
+bool ResultFrameReader::Next(ResultRecord* record) {
+  if (next_ >= record_count_) {
+    return false;
+  }
+  const uint8_t* p = data_ + kResultFrameHeaderSize + next_ * (kResultRecordHeaderSize + category_count_);
+  record->sequence = GetU32(data_ + 4) + next_;
+  record->time_ms = GetU32(data_ + 8) + GetU16(p);
+  record->model = data_[3];
+  record->argmax = p[2];
+  record->category_count = category_count_;
+  record->scores = reinterpret_cast<const int8_t*>(p + kResultRecordHeaderSize);
+  next_++;
+  return true;
+}
@@ -0,0 +1,85 @@
+#ifndef TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_RESULT_FRAME_H_
+#define TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_RESULT_FRAME_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// A frame of classification results, see result_broadcast.h for how they
+// travel. Each frame batches consecutive results of one camera, little
+// endian:
+//
+//   0  uint8   kResultFrameVersion
+//   1  uint8   categories per record
+//   2  uint8   records in the frame
+//   3  uint8   low byte of the model sequence, see ModelInfo
+//   4  uint32  sequence of the first record, the others follow it
+//   8  uint32  time of the first record, ms since boot
+//   12 records: uint16 ms after the first one, uint8 argmax and an int8
+//      score per category, quantized like an int8 softmax output:
+//      scale 1/256, zero point -128.
+//
+// Nothing here depends on the IDF, so that the format can be tested on the
+// host, see result_frame_test.cc.
+
+constexpr uint8_t kResultFrameVersion = 1;
+constexpr size_t kResultFrameHeaderSize = 12;
+constexpr size_t kResultRecordHeaderSize = 3;
+
+// A record as the subscriber reads it, `scores` points into the frame
+struct ResultRecord {
+  uint32_t sequence;
+  uint32_t time_ms;
+  uint8_t model;
+  uint8_t argmax;
+  uint8_t category_count;
+  const int8_t* scores;
+};
+
+inline float ResultScore(int8_t score) { return (score + 128) / 256.0f; }
+
+// Builds a frame in a buffer of the caller
+class ResultFrameWriter {
+ public:
+  ResultFrameWriter(uint8_t* buffer, size_t capacity, int category_count)
+      : data_(buffer), capacity_(capacity), category_count_(category_count) {}
+
+  // Whether `record` can follow the ones already in the frame: there is
+  // room, it has the next sequence, the same model and comes within
+  // UINT16_MAX ms of the first one
+  bool Fits(const ResultRecord& record) const;
+  // false and nothing written if it does not fit
+  bool Append(const ResultRecord& record);
+  // Starts the next frame
+  void Clear() { record_count_ = 0; }
+
+  const uint8_t* data() const { return data_; }
+  // Bytes of the frame, 0 without any record
+  size_t size() const;
+  int record_count() const { return record_count_; }
+
+ private:
+  size_t record_size() const { return kResultRecordHeaderSize + category_count_; }
+
+  uint8_t* data_;
+  size_t capacity_;
+  int category_count_;
+  int record_count_ = 0;
+};
+
+// Walks the records of a received frame without copying them
+class ResultFrameReader {
+ public:
+  // false if `data` is not a whole result frame of this version
+  bool Init(const uint8_t* data, size_t size);
+  int record_count() const { return record_count_; }
+  // Fills `record` with the next one, false past the last
+  bool Next(ResultRecord* record);
+
+ private:
+  const uint8_t* data_ = nullptr;
+  int record_count_ = 0;
+  int category_count_ = 0;
+  int next_ = 0;
+};
+
+#endif  // TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_RESULT_FRAME_H_
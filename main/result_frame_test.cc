@@ -0,0 +1,138 @@
+/* Host test for result_frame.h, not part of the firmware. From the
+ * repository root:
+ *
+ *   T=components/espressif__esp-tflite-micro
+ *   g++ -std=c++17 -Imain -I$T main/result_frame_test.cc main/result_frame.cc \
+ *       $T/tensorflow/lite/micro/micro_log.cc \
+ *       $T/tensorflow/lite/micro/debug_log.cc \
+ *       $T/tensorflow/lite/micro/system_setup.cc -o result_frame_test
+ *   ./result_frame_test
+ */
+
+#include "result_frame.h"
+
+#include <string.h>
+
+#include "tensorflow/lite/micro/testing/micro_test.h"
+
+namespace {
+
+constexpr int kCategories = 3;
+constexpr size_t kRecordSize = kResultRecordHeaderSize + kCategories;
+
+const int8_t kScores[][kCategories] = {{-128, 0, 127}, {5, -6, 7}, {127, -128, -1}};
+
+ResultRecord Record(uint32_t sequence, uint32_t time_ms, const int8_t* scores = kScores[0], uint8_t model = 7) {
+  return {sequence, time_ms, model, 2, kCategories, scores};
+}
+
+// A frame of three records, 100 and 65535 ms after the first one
+size_t WriteFrame(uint8_t* buffer, size_t capacity) {
+  ResultFrameWriter writer(buffer, capacity, kCategories);
+  writer.Append(Record(0xfffffffe, 0xffffff00, kScores[0]));
+  writer.Append(Record(0xffffffff, 0xffffff64, kScores[1]));
+  writer.Append(Record(0, 0xffffff00 + UINT16_MAX, kScores[2]));
+  return writer.size();
+}
+
+}  // namespace
+
+TF_LITE_MICRO_TESTS_BEGIN
+
+TF_LITE_MICRO_TEST(ReaderReturnsWhatTheWriterWrote) {
+  uint8_t frame[64];
+  const size_t size = WriteFrame(frame, sizeof(frame));
+  TF_LITE_MICRO_EXPECT_EQ(kResultFrameHeaderSize + 3 * kRecordSize, size);
+
+  ResultFrameReader reader;
+  TF_LITE_MICRO_EXPECT_TRUE(reader.Init(frame, size));
+  TF_LITE_MICRO_EXPECT_EQ(3, reader.record_count());
+
+  // Sequence and time wrap like the counters on the camera
+  const uint32_t sequences[] = {0xfffffffe, 0xffffffff, 0};
+  const uint32_t times[] = {0xffffff00, 0xffffff64, 0xffffff00 + UINT16_MAX};
+  ResultRecord record;
+  for (int i = 0; i < 3; ++i) {
+    TF_LITE_MICRO_EXPECT_TRUE(reader.Next(&record));
+    TF_LITE_MICRO_EXPECT_EQ(sequences[i], record.sequence);
+    TF_LITE_MICRO_EXPECT_EQ(times[i], record.time_ms);
+    TF_LITE_MICRO_EXPECT_EQ(7, record.model);
+    TF_LITE_MICRO_EXPECT_EQ(2, record.argmax);
+    TF_LITE_MICRO_EXPECT_EQ(kCategories, record.category_count);
+    TF_LITE_MICRO_EXPECT_EQ(0, memcmp(kScores[i], record.scores, kCategories));
+  }
+  TF_LITE_MICRO_EXPECT_FALSE(reader.Next(&record));
+}
+
+TF_LITE_MICRO_TEST(WriterStartsOverAfterClear) {
+  uint8_t frame[64];
+  ResultFrameWriter writer(frame, sizeof(frame), kCategories);
+  TF_LITE_MICRO_EXPECT_EQ(0u, writer.size());
+
+  TF_LITE_MICRO_EXPECT_TRUE(writer.Append(Record(10, 1000)));
+  writer.Clear();
+  TF_LITE_MICRO_EXPECT_EQ(0, writer.record_count());
+  // Any sequence and model can start a frame
+  TF_LITE_MICRO_EXPECT_TRUE(writer.Append(Record(50, 2000, kScores[1], 8)));
+
+  ResultFrameReader reader;
+  ResultRecord record;
+  TF_LITE_MICRO_EXPECT_TRUE(reader.Init(writer.data(), writer.size()));
+  TF_LITE_MICRO_EXPECT_EQ(1, reader.record_count());
+  TF_LITE_MICRO_EXPECT_TRUE(reader.Next(&record));
+  TF_LITE_MICRO_EXPECT_EQ(50u, record.sequence);
+  TF_LITE_MICRO_EXPECT_EQ(8, record.model);
+}
+
+TF_LITE_MICRO_TEST(WriterRefusesWhatDoesNotFollow) {
+  uint8_t frame[kResultFrameHeaderSize + 2 * kRecordSize];
+  ResultFrameWriter writer(frame, sizeof(frame), kCategories);
+  TF_LITE_MICRO_EXPECT_TRUE(writer.Append(Record(10, 1000)));
+
+  TF_LITE_MICRO_EXPECT_FALSE(writer.Fits(Record(12, 1000)));                 // a gap
+  TF_LITE_MICRO_EXPECT_FALSE(writer.Fits(Record(11, 1000, kScores[0], 8)));  // another model
+  TF_LITE_MICRO_EXPECT_FALSE(writer.Fits(Record(11, 1000 + UINT16_MAX + 1)));
+  ResultRecord other_categories = Record(11, 1000);
+  other_categories.category_count = kCategories - 1;
+  TF_LITE_MICRO_EXPECT_FALSE(writer.Fits(other_categories));
+  TF_LITE_MICRO_EXPECT_EQ(1, writer.record_count());
+
+  TF_LITE_MICRO_EXPECT_TRUE(writer.Append(Record(11, 1000 + UINT16_MAX)));
+  // Full
+  TF_LITE_MICRO_EXPECT_FALSE(writer.Append(Record(12, 1000 + UINT16_MAX)));
+  TF_LITE_MICRO_EXPECT_EQ(sizeof(frame), writer.size());
+}
+
+TF_LITE_MICRO_TEST(TruncatedFramesAreRejected) {
+  uint8_t frame[64];
+  const size_t size = WriteFrame(frame, sizeof(frame));
+
+  ResultFrameReader reader;
+  for (size_t truncated = 0; truncated < size; ++truncated) {
+    TF_LITE_MICRO_EXPECT_FALSE(reader.Init(frame, truncated));
+  }
+  // Trailing bytes are no more a frame of this version than missing ones
+  TF_LITE_MICRO_EXPECT_FALSE(reader.Init(frame, size + 1));
+  TF_LITE_MICRO_EXPECT_TRUE(reader.Init(frame, size));
+}
+
+TF_LITE_MICRO_TEST(OtherVersionsAreRejected) {
+  uint8_t frame[64];
+  const size_t size = WriteFrame(frame, sizeof(frame));
+
+  ResultFrameReader reader;
+  frame[0] = kResultFrameVersion + 1;
+  TF_LITE_MICRO_EXPECT_FALSE(reader.Init(frame, size));
+  frame[0] = 0;
+  TF_LITE_MICRO_EXPECT_FALSE(reader.Init(frame, size));
+
+  // A record count that does not match the size, or records without scores
+  frame[0] = kResultFrameVersion;
+  frame[2] = 2;
+  TF_LITE_MICRO_EXPECT_FALSE(reader.Init(frame, size));
+  frame[2] = 3;
+  frame[1] = 0;
+  TF_LITE_MICRO_EXPECT_FALSE(reader.Init(frame, size));
+}
+
+TF_LITE_MICRO_TESTS_END
@@ -0,0 +1,214 @@
+#ifndef TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_SCORE_AGGREGATOR_H_
+#define TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_SCORE_AGGREGATOR_H_
+
+#include <cmath>
+#include <cstdint>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/micro/micro_log.h"
+
+// Fixed capacity ring of timestamped score vectors, the vision counterpart of
+// PreviousResultsQueue in the micro_speech example. Pushing onto a full queue
+// drops the oldest entry, so a camera running faster than the averaging
+// window was sized for loses history instead of new results.
+template <int kCategories, int kMaxResults>
+class ScoreQueue {
+ public:
+  struct Result {
+    int64_t time;
+    float scores[kCategories];
+  };
+
+  int size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  void clear() { front_index_ = size_ = 0; }
+
+  const Result& front() const { return results_[front_index_]; }
+  const Result& from_front(int offset) const {
+    int index = front_index_ + offset;
+    if (index >= kMaxResults) {
+      index -= kMaxResults;
+    }
+    return results_[index];
+  }
+
+  void push_back(int64_t time, const float* scores) {
+    if (size_ == kMaxResults) {
+      pop_front();
+    }
+    int index = front_index_ + size_;
+    if (index >= kMaxResults) {
+      index -= kMaxResults;
+    }
+    results_[index].time = time;
+    for (int i = 0; i < kCategories; ++i) {
+      results_[index].scores[i] = scores[i];
+    }
+    size_ += 1;
+  }
+
+  void pop_front() {
+    if (size_ == 0) {
+      return;
+    }
+    front_index_ += 1;
+    if (front_index_ >= kMaxResults) {
+      front_index_ = 0;
+    }
+    size_ -= 1;
+  }
+
+ private:
+  Result results_[kMaxResults];
+  int front_index_ = 0;
+  int size_ = 0;
+};
+
+enum class SmoothingMode {
+  kMovingAverage,
+  kExponentialDecay,
+};
+
+struct ScoreAggregatorConfig {
+  SmoothingMode mode = SmoothingMode::kMovingAverage;
+  int32_t window_ms = 1000;
+  float detection_threshold = 0.5f;
+  float release_threshold = 0.35f;
+  int32_t suppression_ms = 1500;
+  // results needed since the last reset before anything is reported
+  int32_t minimum_count = 3;
+};
+
+// Turns the per-frame scores of a classifier into detection events. Scores are
+// smoothed over time, either as the mean over a sliding time window or as an
+// exponential decay with the window as time constant, and the top smoothed
+// category is latched with hysteresis: it becomes active above
+// detection_threshold and stays active until it drops below
+// release_threshold. Activating the same category again within
+// suppression_ms of its last event is not reported as new. Everything lives
+// in the object, nothing is allocated, and timestamps make the result
+// independent of the frame rate.
+template <int kCategories, int kMaxResults = 32>
+class ScoreAggregator {
+ public:
+  struct Result {
+    int top_index;   // highest smoothed category
+    float score;     // its smoothed score
+    int active;      // latched category, -1 when none
+    bool is_new;     // active became a category that is not suppressed
+  };
+
+  explicit ScoreAggregator(const ScoreAggregatorConfig& config = ScoreAggregatorConfig())
+      : config_(config) {
+    Reset();
+  }
+
+  // Forgets every result and event
+  void Reset() {
+    ResetWindow();
+    last_event_index_ = -1;
+    last_event_time_ = 0;
+  }
+
+  // Forgets the scores, e.g. when the stream is paused, but keeps the last
+  // event so that it is still suppressed when the stream resumes. Times must
+  // keep counting from the same origin.
+  void ResetWindow() {
+    queue_.clear();
+    count_ = 0;
+    last_time_ = 0;
+    active_ = -1;
+    for (int i = 0; i < kCategories; ++i) {
+      smoothed_[i] = 0.0f;
+    }
+  }
+
+  const float* smoothed_scores() const { return smoothed_; }
+
+  // Call with the scores of each frame, time_ms must not decrease. It is 64
+  // bit so that ms since boot do not wrap, 32 bit would after 24.8 days.
+  TfLiteStatus ProcessLatestResults(const float* scores, int64_t time_ms, Result* result) {
+    if (count_ > 0 && time_ms < last_time_) {
+      MicroPrintf("Results must be fed in increasing time order, got %lld after %lld",
+                  static_cast<long long>(time_ms), static_cast<long long>(last_time_));
+      return kTfLiteError;
+    }
+    if (config_.mode == SmoothingMode::kMovingAverage) {
+      Average(scores, time_ms);
+    } else {
+      Decay(scores, time_ms);
+    }
+    if (count_ < INT32_MAX) {
+      count_ += 1;
+    }
+    last_time_ = time_ms;
+
+    result->top_index = 0;
+    for (int i = 1; i < kCategories; ++i) {
+      if (smoothed_[i] > smoothed_[result->top_index]) {
+        result->top_index = i;
+      }
+    }
+    result->score = smoothed_[result->top_index];
+    result->is_new = false;
+    if (count_ < config_.minimum_count) {
+      result->active = -1;
+      return kTfLiteOk;
+    }
+
+    if (active_ >= 0 && smoothed_[active_] < config_.release_threshold) {
+      active_ = -1;
+    }
+    if (result->top_index != active_ && result->score > config_.detection_threshold) {
+      active_ = result->top_index;
+      if (active_ != last_event_index_ || time_ms - last_event_time_ > config_.suppression_ms) {
+        result->is_new = true;
+        last_event_index_ = active_;
+        last_event_time_ = time_ms;
+      }
+    }
+    result->active = active_;
+    return kTfLiteOk;
+  }
+
+ private:
+  void Average(const float* scores, int64_t time_ms) {
+    queue_.push_back(time_ms, scores);
+    while (time_ms - queue_.front().time > config_.window_ms) {
+      queue_.pop_front();
+    }
+    for (int i = 0; i < kCategories; ++i) {
+      smoothed_[i] = 0.0f;
+    }
+    for (int offset = 0; offset < queue_.size(); ++offset) {
+      const float* previous = queue_.from_front(offset).scores;
+      for (int i = 0; i < kCategories; ++i) {
+        smoothed_[i] += previous[i];
+      }
+    }
+    for (int i = 0; i < kCategories; ++i) {
+      smoothed_[i] /= queue_.size();
+    }
+  }
+
+  void Decay(const float* scores, int64_t time_ms) {
+    // weight of the new result grows with the time since the previous one
+    const float alpha = count_ == 0 || config_.window_ms <= 0
+                            ? 1.0f
+                            : 1.0f - expf(-static_cast<float>(time_ms - last_time_) / config_.window_ms);
+    for (int i = 0; i < kCategories; ++i) {
+      smoothed_[i] += alpha * (scores[i] - smoothed_[i]);
+    }
+  }
+
+  const ScoreAggregatorConfig config_;
+  ScoreQueue<kCategories, kMaxResults> queue_;
+  float smoothed_[kCategories];
+  int32_t count_;
+  int64_t last_time_;
+  int active_;
+  int last_event_index_;
+  int64_t last_event_time_;
+};
+
+#endif  // TENSORFLOW_LITE_MICRO_EXAMPLES_PERSON_DETECTION_SCORE_AGGREGATOR_H_
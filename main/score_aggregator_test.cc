@@ -0,0 +1,231 @@
+/* Host test for score_aggregator.h, not part of the firmware. From the
+ * repository root:
+ *
+ *   T=components/espressif__esp-tflite-micro
+ *   g++ -std=c++17 -Imain -I$T main/score_aggregator_test.cc \
+ *       $T/tensorflow/lite/micro/micro_log.cc \
+ *       $T/tensorflow/lite/micro/debug_log.cc \
+ *       $T/tensorflow/lite/micro/system_setup.cc -o score_aggregator_test
+ *   ./score_aggregator_test
+ */
+
+#include "score_aggregator.h"
+
+#include "tensorflow/lite/micro/testing/micro_test.h"
+
+namespace {
+
+constexpr int kCategories = 2;
+using Aggregator = ScoreAggregator<kCategories>;
+
+// Scores of one frame, they need not add up to 1
+const float* Frame(float score0, float score1 = 0.0f) {
+  static float scores[kCategories];
+  scores[0] = score0;
+  scores[1] = score1;
+  return scores;
+}
+
+// Only the latest result counts, so the hysteresis can be read directly
+ScoreAggregatorConfig Instant() {
+  ScoreAggregatorConfig config;
+  config.window_ms = 0;
+  config.minimum_count = 1;
+  return config;
+}
+
+}  // namespace
+
+TF_LITE_MICRO_TESTS_BEGIN
+
+TF_LITE_MICRO_TEST(MinimumCountHoldsBackDetections) {
+  ScoreAggregatorConfig config;
+  config.minimum_count = 3;
+  Aggregator aggregator(config);
+  Aggregator::Result result;
+
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, aggregator.ProcessLatestResults(Frame(0.9f), 0, &result));
+  TF_LITE_MICRO_EXPECT_EQ(-1, result.active);
+  TF_LITE_MICRO_EXPECT_EQ(0, result.top_index);
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, aggregator.ProcessLatestResults(Frame(0.9f), 100, &result));
+  TF_LITE_MICRO_EXPECT_EQ(-1, result.active);
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, aggregator.ProcessLatestResults(Frame(0.9f), 200, &result));
+  TF_LITE_MICRO_EXPECT_EQ(0, result.active);
+  TF_LITE_MICRO_EXPECT_TRUE(result.is_new);
+}
+
+TF_LITE_MICRO_TEST(HysteresisKeepsDetectionUntilRelease) {
+  Aggregator aggregator(Instant());
+  Aggregator::Result result;
+
+  aggregator.ProcessLatestResults(Frame(0.6f), 0, &result);
+  TF_LITE_MICRO_EXPECT_EQ(0, result.active);
+  TF_LITE_MICRO_EXPECT_TRUE(result.is_new);
+
+  // Between release (0.35) and detection (0.5): still latched
+  aggregator.ProcessLatestResults(Frame(0.4f), 100, &result);
+  TF_LITE_MICRO_EXPECT_EQ(0, result.active);
+  TF_LITE_MICRO_EXPECT_FALSE(result.is_new);
+
+  aggregator.ProcessLatestResults(Frame(0.45f), 200, &result);
+  TF_LITE_MICRO_EXPECT_EQ(0, result.active);
+
+  // Below release: let go
+  aggregator.ProcessLatestResults(Frame(0.3f), 300, &result);
+  TF_LITE_MICRO_EXPECT_EQ(0, result.top_index);
+  TF_LITE_MICRO_EXPECT_EQ(-1, result.active);
+  TF_LITE_MICRO_EXPECT_FALSE(result.is_new);
+
+  // Another category above detection takes over a latched one
+  aggregator.ProcessLatestResults(Frame(0.6f), 400, &result);
+  TF_LITE_MICRO_EXPECT_EQ(0, result.active);
+  aggregator.ProcessLatestResults(Frame(0.4f, 0.55f), 500, &result);
+  TF_LITE_MICRO_EXPECT_EQ(1, result.active);
+  TF_LITE_MICRO_EXPECT_TRUE(result.is_new);
+}
+
+TF_LITE_MICRO_TEST(BelowDetectionNeverActivates) {
+  ScoreAggregatorConfig config = Instant();
+  config.detection_threshold = 0.8f;
+  Aggregator aggregator(config);
+  Aggregator::Result result;
+
+  aggregator.ProcessLatestResults(Frame(0.7f), 0, &result);
+  TF_LITE_MICRO_EXPECT_EQ(0, result.top_index);
+  TF_LITE_MICRO_EXPECT_EQ(-1, result.active);
+  TF_LITE_MICRO_EXPECT_FALSE(result.is_new);
+}
+
+TF_LITE_MICRO_TEST(SameCategoryIsSuppressed) {
+  Aggregator aggregator(Instant());
+  Aggregator::Result result;
+
+  aggregator.ProcessLatestResults(Frame(0.9f), 0, &result);
+  TF_LITE_MICRO_EXPECT_TRUE(result.is_new);
+  aggregator.ProcessLatestResults(Frame(0.0f, 0.9f), 100, &result);
+  TF_LITE_MICRO_EXPECT_EQ(1, result.active);
+  TF_LITE_MICRO_EXPECT_TRUE(result.is_new);
+
+  // The last event was category 1, so 0 is new again
+  aggregator.ProcessLatestResults(Frame(0.9f), 1000, &result);
+  TF_LITE_MICRO_EXPECT_EQ(0, result.active);
+  TF_LITE_MICRO_EXPECT_TRUE(result.is_new);
+
+  // Released and back within suppression_ms of its event: active, not new
+  aggregator.ProcessLatestResults(Frame(0.2f), 1100, &result);
+  TF_LITE_MICRO_EXPECT_EQ(-1, result.active);
+  aggregator.ProcessLatestResults(Frame(0.9f), 1300, &result);
+  TF_LITE_MICRO_EXPECT_EQ(0, result.active);
+  TF_LITE_MICRO_EXPECT_FALSE(result.is_new);
+
+  // Released and back after suppression_ms: new
+  aggregator.ProcessLatestResults(Frame(0.2f), 2000, &result);
+  TF_LITE_MICRO_EXPECT_EQ(-1, result.active);
+  aggregator.ProcessLatestResults(Frame(0.9f), 3000, &result);
+  TF_LITE_MICRO_EXPECT_EQ(0, result.active);
+  TF_LITE_MICRO_EXPECT_TRUE(result.is_new);
+}
+
+TF_LITE_MICRO_TEST(ResetWindowKeepsSuppression) {
+  Aggregator aggregator(Instant());
+  Aggregator::Result result;
+
+  aggregator.ProcessLatestResults(Frame(0.9f), 0, &result);
+  TF_LITE_MICRO_EXPECT_TRUE(result.is_new);
+
+  aggregator.ResetWindow();
+  aggregator.ProcessLatestResults(Frame(0.9f), 500, &result);
+  TF_LITE_MICRO_EXPECT_EQ(0, result.active);
+  TF_LITE_MICRO_EXPECT_FALSE(result.is_new);
+
+  aggregator.Reset();
+  aggregator.ProcessLatestResults(Frame(0.9f), 600, &result);
+  TF_LITE_MICRO_EXPECT_EQ(0, result.active);
+  TF_LITE_MICRO_EXPECT_TRUE(result.is_new);
+}
+
+TF_LITE_MICRO_TEST(ResetWindowForgetsScores) {
+  ScoreAggregatorConfig config;
+  config.minimum_count = 2;
+  Aggregator aggregator(config);
+  Aggregator::Result result;
+
+  aggregator.ProcessLatestResults(Frame(0.9f), 0, &result);
+  aggregator.ProcessLatestResults(Frame(0.9f), 100, &result);
+  TF_LITE_MICRO_EXPECT_EQ(0, result.active);
+
+  aggregator.ResetWindow();
+  aggregator.ProcessLatestResults(Frame(0.1f), 200, &result);
+  TF_LITE_MICRO_EXPECT_EQ(-1, result.active);  // count restarted
+  TF_LITE_MICRO_EXPECT_NEAR(0.1f, aggregator.smoothed_scores()[0], 1e-6f);
+}
+
+TF_LITE_MICRO_TEST(MovingAverageDropsOldResults) {
+  Aggregator aggregator;
+  Aggregator::Result result;
+
+  aggregator.ProcessLatestResults(Frame(1.0f), 0, &result);
+  aggregator.ProcessLatestResults(Frame(0.0f), 500, &result);
+  TF_LITE_MICRO_EXPECT_NEAR(0.5f, aggregator.smoothed_scores()[0], 1e-6f);
+  aggregator.ProcessLatestResults(Frame(0.5f), 1000, &result);
+  TF_LITE_MICRO_EXPECT_NEAR(0.5f, aggregator.smoothed_scores()[0], 1e-6f);
+  // 0 and 500 are more than window_ms old
+  aggregator.ProcessLatestResults(Frame(0.2f), 1600, &result);
+  TF_LITE_MICRO_EXPECT_NEAR(0.35f, aggregator.smoothed_scores()[0], 1e-6f);
+}
+
+TF_LITE_MICRO_TEST(ExponentialDecayFollowsElapsedTime) {
+  ScoreAggregatorConfig config;
+  config.mode = SmoothingMode::kExponentialDecay;
+  config.window_ms = 1000;
+  Aggregator aggregator(config);
+  Aggregator::Result result;
+
+  aggregator.ProcessLatestResults(Frame(1.0f), 0, &result);
+  TF_LITE_MICRO_EXPECT_NEAR(1.0f, aggregator.smoothed_scores()[0], 1e-6f);
+  // One time constant later the old value weighs 1/e
+  aggregator.ProcessLatestResults(Frame(0.0f), 1000, &result);
+  TF_LITE_MICRO_EXPECT_NEAR(expf(-1.0f), aggregator.smoothed_scores()[0], 1e-6f);
+  // No time elapsed: no change
+  aggregator.ProcessLatestResults(Frame(1.0f), 1000, &result);
+  TF_LITE_MICRO_EXPECT_NEAR(expf(-1.0f), aggregator.smoothed_scores()[0], 1e-6f);
+}
+
+TF_LITE_MICRO_TEST(TimeMustNotGoBack) {
+  Aggregator aggregator;
+  Aggregator::Result result;
+
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, aggregator.ProcessLatestResults(Frame(0.5f), 100, &result));
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteError, aggregator.ProcessLatestResults(Frame(0.5f), 50, &result));
+}
+
+TF_LITE_MICRO_TEST(TimeGoesPast32Bits) {
+  // 24.8 days since boot, where ms in an int32_t would wrap
+  constexpr int64_t kStart = INT32_MAX - 100;
+  Aggregator aggregator(Instant());
+  Aggregator::Result result;
+
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, aggregator.ProcessLatestResults(Frame(0.9f), kStart, &result));
+  TF_LITE_MICRO_EXPECT_TRUE(result.is_new);
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, aggregator.ProcessLatestResults(Frame(0.2f), kStart + 200, &result));
+  TF_LITE_MICRO_EXPECT_EQ(-1, result.active);
+  // Suppressed across the boundary, new again after suppression_ms
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, aggregator.ProcessLatestResults(Frame(0.9f), kStart + 1300, &result));
+  TF_LITE_MICRO_EXPECT_EQ(0, result.active);
+  TF_LITE_MICRO_EXPECT_FALSE(result.is_new);
+  aggregator.ProcessLatestResults(Frame(0.2f), kStart + 1400, &result);
+  TF_LITE_MICRO_EXPECT_EQ(kTfLiteOk, aggregator.ProcessLatestResults(Frame(0.9f), kStart + 2000, &result));
+  TF_LITE_MICRO_EXPECT_EQ(0, result.active);
+  TF_LITE_MICRO_EXPECT_TRUE(result.is_new);
+
+  ScoreAggregatorConfig config;
+  config.window_ms = 1000;
+  Aggregator average(config);
+  average.ProcessLatestResults(Frame(1.0f), kStart, &result);
+  average.ProcessLatestResults(Frame(0.0f), kStart + 200, &result);
+  TF_LITE_MICRO_EXPECT_NEAR(0.5f, average.smoothed_scores()[0], 1e-6f);
+  average.ProcessLatestResults(Frame(0.0f), kStart + 1100, &result);
+  TF_LITE_MICRO_EXPECT_NEAR(0.0f, average.smoothed_scores()[0], 1e-6f);
+}
+
+TF_LITE_MICRO_TESTS_END